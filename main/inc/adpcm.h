@@ -0,0 +1,138 @@
+/**
+ ********************************************************************************
+ * @file    adpcm.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Integer only IMA-ADPCM voice codec. Every block starts with the coder state it was
+ *          encoded from, so each block decodes on its own after a loss, and the mode it was
+ *          encoded in, so the encoder can change mode from one block to the next and the decoder
+ *          follows. Input and output are always 16 kHz. The 8 kHz modes average each pair of
+ *          samples before coding and interpolate them back after decoding
+ ********************************************************************************
+ */
+
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* predictor (2, little endian), step index (1), mode (1) */
+#define ADPCM_HDR_BYTES (4U)
+
+/* 29 ms at 16 kHz. Header plus block is 236 bytes, so a block with the 4 byte fec header
+   (WT20_FEC_HDR_BYTES) fits the 242 byte wt20 payload (WT20_PAYLOAD_BYTES). The 2 spare
+   bytes can't hold another ms of samples, and 464 keeps the frame period a whole number of ms */
+#define ADPCM_BLOCK_SAMPLES (464U)
+
+#define ADPCM_BLOCK_BYTES (ADPCM_HDR_BYTES + (ADPCM_BLOCK_SAMPLES / 2U))
+
+/* the same block in the 8 kHz modes */
+#define ADPCM_8K_BLOCK_BYTES (ADPCM_HDR_BYTES + (ADPCM_BLOCK_SAMPLES / 4U))
+#define ADPCM_8K_2BIT_BLOCK_BYTES (ADPCM_HDR_BYTES + (ADPCM_BLOCK_SAMPLES / 8U))
+
+#define ADPCM_MAX_STEP_INDEX (88U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* best first. Values go in the block header */
+typedef enum
+{
+    ADPCM_MODE_16K,           /* 4 bits a sample at 16 kHz, 64 kbit/s */
+    ADPCM_MODE_8K,            /* 4 bits a sample at 8 kHz, 32 kbit/s */
+    ADPCM_MODE_8K_2BIT,       /* 2 bits a sample at 8 kHz, 16 kbit/s */
+    ADPCM_MODES
+} ADPCM_MODE_T;
+
+typedef struct
+{
+    int16_t predictor;    /* last reconstructed sample */
+    uint8_t step_index;
+} ADPCM_STATE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief resets coder state to silence
+ */
+void adpcm_init(ADPCM_STATE_T* state);
+
+/**
+ * \brief encodes samples into one block. state carries over to next block, so consecutive
+ *        blocks join without a step at the boundary
+ *
+ * \param state[in,out] encoder state, written into block header then advanced
+ * \param pcm[in] samples to encode
+ * \param samples number of samples, even and at most ADPCM_BLOCK_SAMPLES
+ * \param block[out] at least ADPCM_HDR_BYTES + samples / 2 bytes
+ *
+ * \return length of block, 0 if samples is odd or too many
+ */
+uint16_t adpcm_encode_block(ADPCM_STATE_T* state, const int16_t* pcm, uint16_t samples, uint8_t* block);
+
+/**
+ * \brief adpcm_encode_block() in the given mode. state carries over between modes too
+ *
+ * \param samples 16 kHz samples, at most ADPCM_BLOCK_SAMPLES. A multiple of 2 for ADPCM_MODE_16K,
+ *        4 for ADPCM_MODE_8K and 8 for ADPCM_MODE_8K_2BIT, so codes fill whole bytes
+ * \param block[out] at least adpcm_block_bytes(mode, samples) bytes
+ *
+ * \return length of block, 0 if samples doesn't suit mode or mode is unknown
+ */
+uint16_t adpcm_encode_block_mode(ADPCM_STATE_T* state, ADPCM_MODE_T mode, const int16_t* pcm, uint16_t samples, uint8_t* block);
+
+/**
+ * \return length of a block of samples 16 kHz samples in mode, ADPCM_BLOCK_BYTES for a full
+ *         block at ADPCM_MODE_16K
+ */
+uint16_t adpcm_block_bytes(ADPCM_MODE_T mode, uint16_t samples);
+
+/**
+ * \return mode a block was encoded in, ADPCM_MODES if block is too short or its mode unknown
+ */
+ADPCM_MODE_T adpcm_block_mode(const uint8_t* block, uint16_t length);
+
+/**
+ * \brief decodes one block using only the state in its header
+ *
+ * \param block[in] block from adpcm_encode_block() or adpcm_encode_block_mode(). Bytes past a
+ *        full block of its mode are taken as padding and ignored
+ * \param length length of block, at most ADPCM_BLOCK_BYTES
+ * \param pcm[out] room for ADPCM_BLOCK_SAMPLES 16 kHz samples
+ * \param end_state[out] decoder state after last sample, for concealment of a following loss.
+ *                       Pass NULL if not needed
+ *
+ * \return number of samples decoded, 0 if block is malformed
+ */
+uint16_t adpcm_decode_block(const uint8_t* block, uint16_t length, int16_t* pcm, ADPCM_STATE_T* end_state);
+
+/**
+ * \brief decodes codes of a block starting from state instead of the block's header. Used to
+ *        conceal a lost block, the waveform carries on smoothly from where the last one ended
+ *
+ * \param state[in,out] decoder state, advanced past the block
+ *
+ * \return number of samples decoded, 0 if block is malformed
+ */
+uint16_t adpcm_decode_continue(const uint8_t* block, uint16_t length, ADPCM_STATE_T* state, int16_t* pcm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
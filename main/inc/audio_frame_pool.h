@@ -0,0 +1,135 @@
+/**
+ ********************************************************************************
+ * @file    audio_frame_pool.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Static pool of fixed size PCM frames and lock-free queues that pass them between
+ *          the audio engine and its consumers by pointer, so samples are never copied on handoff
+ ********************************************************************************
+ */
+
+#ifndef AUDIO_FRAME_POOL_H
+#define AUDIO_FRAME_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "mem_pool.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#ifdef CONFIG_AUDIO_SAMPLE_RATE_HZ
+#define AUDIO_SAMPLE_RATE_HZ (CONFIG_AUDIO_SAMPLE_RATE_HZ)
+#else
+#define AUDIO_SAMPLE_RATE_HZ (16000U)
+#endif
+
+/* mono 16 bit samples per frame. Default is 29 ms at 16 kHz, one ADPCM block (ADPCM_BLOCK_SAMPLES) */
+#ifdef CONFIG_AUDIO_FRAME_SAMPLES
+#define AUDIO_FRAME_SAMPLES (CONFIG_AUDIO_FRAME_SAMPLES)
+#else
+#define AUDIO_FRAME_SAMPLES (464U)
+#endif
+
+#define AUDIO_FRAME_BYTES (AUDIO_FRAME_SAMPLES * sizeof(int16_t))
+#define AUDIO_FRAME_PERIOD_US ((uint32_t)(((uint64_t)AUDIO_FRAME_SAMPLES * 1000000U) / AUDIO_SAMPLE_RATE_HZ))
+
+/* frames shared by capture and playback. At most MEM_POOL_MAX_BLOCKS */
+#ifdef CONFIG_AUDIO_FRAME_POOL_FRAMES
+#define AUDIO_FRAME_POOL_FRAMES (CONFIG_AUDIO_FRAME_POOL_FRAMES)
+#else
+#define AUDIO_FRAME_POOL_FRAMES (8U)
+#endif
+
+/* a queue can never hold more frames than the pool has, so it never fills. Power of 2 */
+#define AUDIO_FRAME_QUEUE_DEPTH (32U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint32_t seq;            /* frame count since stream started */
+    uint32_t timestamp_us;   /* capture time of first sample */
+    int16_t pcm[AUDIO_FRAME_SAMPLES];
+} AUDIO_FRAME_T;
+
+/* alloc and free may be called from task and isr context. Usage is counted by blocks */
+typedef struct
+{
+    AUDIO_FRAME_T frames[AUDIO_FRAME_POOL_FRAMES];
+    MEM_POOL_T blocks;
+} AUDIO_FRAME_POOL_T;
+
+/* single producer / single consumer queue of frame pointers */
+typedef struct
+{
+    AUDIO_FRAME_T* slots[AUDIO_FRAME_QUEUE_DEPTH];
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+} AUDIO_FRAME_QUEUE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief marks every frame free and clears counters. Pool is reported as "audio"
+ */
+void audio_frame_pool_init(AUDIO_FRAME_POOL_T* pool);
+
+/**
+ * \brief takes a free frame. O(1), never blocks
+ *
+ * \return frame, NULL if every frame is in use (counted as an alloc failure)
+ */
+AUDIO_FRAME_T* audio_frame_pool_alloc(AUDIO_FRAME_POOL_T* pool);
+
+/**
+ * \brief returns a frame to pool. Frames not from this pool are ignored
+ */
+void audio_frame_pool_free(AUDIO_FRAME_POOL_T* pool, AUDIO_FRAME_T* frame);
+
+/**
+ * \brief returns number of free frames
+ */
+uint32_t audio_frame_pool_available(AUDIO_FRAME_POOL_T* pool);
+
+/**
+ * \brief empties queue
+ */
+void audio_frame_queue_init(AUDIO_FRAME_QUEUE_T* queue);
+
+/**
+ * \brief Producer side. Hands frame over to consumer
+ *
+ * \return false if queue is full
+ */
+bool audio_frame_queue_push(AUDIO_FRAME_QUEUE_T* queue, AUDIO_FRAME_T* frame);
+
+/**
+ * \brief Consumer side. Takes oldest frame
+ *
+ * \return frame, NULL if queue is empty
+ */
+AUDIO_FRAME_T* audio_frame_queue_pop(AUDIO_FRAME_QUEUE_T* queue);
+
+/**
+ * \brief returns number of frames in queue. Safe from either side
+ */
+uint32_t audio_frame_queue_count(AUDIO_FRAME_QUEUE_T* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
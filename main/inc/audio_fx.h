@@ -0,0 +1,136 @@
+/**
+ ********************************************************************************
+ * @file    audio_fx.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Fixed point voice effects, applied to whole frames in place. Chains of effects are
+ *          put together at compile time (see CHAINS_D in audio_fx.c) so each chain is one loop
+ *          with every effect inlined, and the chain in use is picked at run time
+ ********************************************************************************
+ */
+
+#ifndef AUDIO_FX_H
+#define AUDIO_FX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_frame_pool.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* robot, ring modulator carrier */
+#define AUDIO_FX_RING_MOD_HZ (60U)
+
+/* echo, 250 ms delay fed back at 0.4 */
+#define AUDIO_FX_ECHO_SAMPLES (AUDIO_SAMPLE_RATE_HZ / 4U)
+#define AUDIO_FX_ECHO_FEEDBACK_Q15 (13107)
+
+/* chipmunk, pitch up by 1.5 (Q16). Window is the length of the crossfaded grains */
+#define AUDIO_FX_PITCH_RATIO_Q16 (98304U)
+#define AUDIO_FX_PITCH_WINDOW_SAMPLES (512U)
+#define AUDIO_FX_PITCH_LINE_SAMPLES (1024U)
+
+/* tremolo, 6 Hz at 0.6 depth */
+#define AUDIO_FX_TREMOLO_HZ (6U)
+#define AUDIO_FX_TREMOLO_DEPTH_Q15 (19661)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* prebuilt chains, in the order effects are applied */
+typedef enum
+{
+    AUDIO_FX_NONE,
+    AUDIO_FX_ROBOT,           /* ring mod */
+    AUDIO_FX_ECHO,            /* echo */
+    AUDIO_FX_CHIPMUNK,        /* pitch shift */
+    AUDIO_FX_TREMOLO,         /* tremolo */
+    AUDIO_FX_ROBOT_ECHO,      /* ring mod, echo */
+    AUDIO_FX_CHIPMUNK_ECHO,   /* pitch shift, echo */
+    AUDIO_FX_CHIPMUNK_TREMOLO,/* pitch shift, tremolo */
+    AUDIO_FX_CHAIN_COUNT
+} AUDIO_FX_CHAIN_T;
+
+typedef struct
+{
+    uint32_t phase;
+    uint32_t increment;
+} AUDIO_FX_RING_MOD_T;
+
+typedef struct
+{
+    int16_t line[AUDIO_FX_ECHO_SAMPLES];
+    uint32_t position;
+} AUDIO_FX_ECHO_T;
+
+typedef struct
+{
+    int16_t line[AUDIO_FX_PITCH_LINE_SAMPLES];
+    uint32_t position;
+    uint32_t delay_q16;       /* delay of first grain, falls by ratio - 1 every sample */
+} AUDIO_FX_PITCH_T;
+
+typedef struct
+{
+    uint32_t phase;
+    uint32_t increment;
+} AUDIO_FX_TREMOLO_T;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t last_cycles;     /* cpu cycles spent on last frame */
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+} AUDIO_FX_STATS_T;
+
+typedef struct
+{
+    AUDIO_FX_CHAIN_T chain;
+    AUDIO_FX_RING_MOD_T ring_mod;
+    AUDIO_FX_ECHO_T echo;
+    AUDIO_FX_PITCH_T pitch;
+    AUDIO_FX_TREMOLO_T tremolo;
+    AUDIO_FX_STATS_T stats[AUDIO_FX_CHAIN_COUNT];
+} AUDIO_FX_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief clears effect state and stats and selects AUDIO_FX_NONE
+ */
+void audio_fx_init(AUDIO_FX_T* fx);
+
+/**
+ * \brief picks chain for following frames. Delay lines are cleared so nothing of the previous
+ *        chain is heard
+ *
+ * \return false if chain is out of range
+ */
+bool audio_fx_select(AUDIO_FX_T* fx, AUDIO_FX_CHAIN_T chain);
+
+/**
+ * \brief runs selected chain over a frame in place and records cycles spent in its stats
+ *
+ * \param pcm[in,out] samples
+ * \param samples number of samples
+ */
+void audio_fx_process(AUDIO_FX_T* fx, int16_t* pcm, uint16_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ ********************************************************************************
+ * @file    audio_io.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Audio capture and playback interface. Frames come from one static pool and are
+ *          handed over by pointer. On target this is I2S DMA to the WM8960 (audio_io_i2s.c),
+ *          off target it is WAV files (unit_tests/test/host/audio_io_wav.c)
+ ********************************************************************************
+ */
+
+#ifndef AUDIO_IO_H
+#define AUDIO_IO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_frame_pool.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define AUDIO_IO_WAIT_FOREVER (0xFFFFFFFFUL)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    AUDIO_IO_OK,
+    AUDIO_IO_ERR_INIT,        /* backend couldn't be set up */
+    AUDIO_IO_ERR_CODEC,       /* codec didn't respond */
+    AUDIO_IO_ERR_NOT_STARTED,
+    AUDIO_IO_ERR_FULL         /* playback queue is full */
+} AUDIO_IO_ERR_T;
+
+typedef struct
+{
+    uint32_t frames_captured;     /* frames handed to consumers */
+    uint32_t frames_played;       /* submitted frames that reached the codec */
+    uint32_t capture_overruns;    /* captured frames dropped, no free frame or consumer too slow */
+    uint32_t playback_underruns;  /* times playback ran dry while playing, the end of a stream counts once */
+    uint32_t pool_high_water;     /* most frames ever in use at once */
+    uint32_t pool_alloc_failures;
+} AUDIO_IO_STATS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief sets up frame pool, codec and audio interface. Nothing runs until audio_io_start()
+ */
+AUDIO_IO_ERR_T audio_io_init(void);
+
+/**
+ * \brief starts capture and playback
+ */
+AUDIO_IO_ERR_T audio_io_start(void);
+
+/**
+ * \brief stops capture and playback after the current frame. Queued playback is returned to
+ *        pool, frames already captured can still be read
+ */
+void audio_io_stop(void);
+
+/**
+ * \brief waits for next captured frame. Caller owns frame until it is released or played.
+ *        Call from one task only
+ *
+ * \param timeout_ms how long to wait, AUDIO_IO_WAIT_FOREVER to block
+ *
+ * \return frame, NULL on timeout
+ */
+AUDIO_FRAME_T* audio_io_capture_get(uint32_t timeout_ms);
+
+/**
+ * \brief takes a free frame to fill for playback
+ *
+ * \return frame, NULL if pool is empty
+ */
+AUDIO_FRAME_T* audio_io_frame_alloc(void);
+
+/**
+ * \brief queues frame for playback. Ownership passes to audio_io either way, so a captured
+ *        frame can be played back without copying. Call from one task only
+ *
+ * \return AUDIO_IO_ERR_FULL if frame was dropped
+ */
+AUDIO_IO_ERR_T audio_io_play(AUDIO_FRAME_T* frame);
+
+/**
+ * \brief returns a frame to pool without playing it
+ */
+void audio_io_frame_release(AUDIO_FRAME_T* frame);
+
+/**
+ * \brief returns number of frames queued for playback
+ */
+uint32_t audio_io_playback_queued(void);
+
+/**
+ * \brief copies counters into stats
+ */
+void audio_io_get_stats(AUDIO_IO_STATS_T* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ ********************************************************************************
+ * @file    audio_vad.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Voice activity detection ahead of the encoder, so silent frames stay off the air.
+ *          Each frame's level (mean absolute amplitude) is held against a tracked noise floor,
+ *          and its zero crossing count, with the floor as hysteresis, tells voiced speech from
+ *          hiss, so quiet vowels pass at a lower margin than noise does. Speech is held on for a
+ *          hangover after it stops, to keep word endings. Through silence only a small marker
+ *          carrying the noise level goes out, once as it starts and then every
+ *          AUDIO_VAD_SID_INTERVAL_FRAMES, and the receiver fills the gap with comfort noise at
+ *          that level (see jitter_buffer.h)
+ ********************************************************************************
+ */
+
+#ifndef AUDIO_VAD_H
+#define AUDIO_VAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* frames still sent as speech after level drops, about 230 ms at 464 samples a frame */
+#ifdef CONFIG_AUDIO_VAD_HANGOVER_FRAMES
+#define AUDIO_VAD_HANGOVER_FRAMES (CONFIG_AUDIO_VAD_HANGOVER_FRAMES)
+#else
+#define AUDIO_VAD_HANGOVER_FRAMES (8U)
+#endif
+
+/* frames between silence markers, about 350 ms. A longer interval saves airtime, a shorter one
+   follows changing background noise sooner and outlasts fewer lost markers */
+#ifdef CONFIG_AUDIO_VAD_SID_INTERVAL_FRAMES
+#define AUDIO_VAD_SID_INTERVAL_FRAMES (CONFIG_AUDIO_VAD_SID_INTERVAL_FRAMES)
+#else
+#define AUDIO_VAD_SID_INTERVAL_FRAMES (12U)
+#endif
+
+/* level over noise floor, x4, that counts as speech for voiced (few crossings) and other frames */
+#define AUDIO_VAD_VOICED_MARGIN_X4 (10U)
+#define AUDIO_VAD_OTHER_MARGIN_X4 (24U)
+
+/* zero crossings per 1024 samples below which a frame is taken to be voiced. Vowels cross at
+   their pitch and first formant, a few hundred Hz, hiss and fricatives at several kHz */
+#define AUDIO_VAD_VOICED_CROSSINGS_PER_1024 (160U)
+
+/* noise floor before anything is measured, and its slowest rise, 1/256 of itself a frame */
+#define AUDIO_VAD_INITIAL_FLOOR (64U)
+#define AUDIO_VAD_FLOOR_RISE_SHIFT (8U)
+
+/* silence descriptor, magic then noise level >> AUDIO_VAD_SID_LEVEL_SHIFT. Shorter than any
+   ADPCM block, so a stream can carry both */
+#define AUDIO_VAD_SID_BYTES (2U)
+#define AUDIO_VAD_SID_MAGIC (0xC5U)
+#define AUDIO_VAD_SID_LEVEL_SHIFT (2U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    AUDIO_VAD_SPEECH,         /* encode and send the frame */
+    AUDIO_VAD_SID,            /* send a silence marker from audio_vad_sid() instead */
+    AUDIO_VAD_SILENCE         /* send nothing */
+} AUDIO_VAD_RESULT_T;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t speech;          /* level over the margin */
+    uint32_t hangover;        /* sent as speech after it stopped */
+    uint32_t sids;
+    uint32_t suppressed;      /* neither the frame nor a marker went out */
+} AUDIO_VAD_STATS_T;
+
+typedef struct
+{
+    uint32_t floor;           /* mean absolute amplitude of background noise */
+    uint32_t noise_level;     /* smoothed level of silent frames, sent in markers */
+    uint8_t hangover;
+    uint8_t since_sid;
+    bool silent;
+    AUDIO_VAD_STATS_T stats;
+} AUDIO_VAD_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief starts a talk spurt. Noise floor starts low, so the first frames are sent
+ */
+void audio_vad_init(AUDIO_VAD_T* vad);
+
+/**
+ * \brief classifies a captured frame
+ *
+ * \param pcm[in] frame before encoding
+ * \param samples length of pcm
+ *
+ * \return what to send for it
+ */
+AUDIO_VAD_RESULT_T audio_vad_process(AUDIO_VAD_T* vad, const int16_t* pcm, uint16_t samples);
+
+/**
+ * \brief builds a silence marker with the current noise level
+ *
+ * \param out[out] AUDIO_VAD_SID_BYTES
+ *
+ * \return AUDIO_VAD_SID_BYTES
+ */
+uint16_t audio_vad_sid(const AUDIO_VAD_T* vad, uint8_t* out);
+
+/**
+ * \brief reads a received silence marker
+ *
+ * \param level[out] noise level it carries
+ *
+ * \return false if block isn't a marker
+ */
+bool audio_vad_parse_sid(const uint8_t* block, uint16_t length, uint16_t* level);
+
+/**
+ * \brief fills pcm with noise of the given mean absolute amplitude
+ *
+ * \param seed[in,out] noise generator state, never 0
+ */
+void audio_vad_comfort_noise(uint32_t* seed, uint16_t level, int16_t* pcm, uint16_t samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ ********************************************************************************
+ * @file    bench.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Latency histograms and machine readable results for protocol benchmarks. Used by the
+ *          host benchmark over sim_link and by the on target one (CONFIG_WT20_BENCHMARK), so
+ *          both print the same lines and runs can be diffed to catch regressions
+ ********************************************************************************
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* buckets per power of 2. Values up to this are exact, above it a bucket is 1/8 of its value wide */
+#define BENCH_HIST_SUB_BUCKETS (8U)
+
+/* covers the whole uint32_t range */
+#define BENCH_HIST_BUCKETS ((32U - 2U) * BENCH_HIST_SUB_BUCKETS)
+
+/* starts every result line, so results can be picked out of a log */
+#define BENCH_LINE_PREFIX "BENCH "
+
+/* longest line bench_format_result() writes, including terminator */
+#define BENCH_LINE_BYTES (512U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint32_t buckets[BENCH_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+} BENCH_HIST_T;
+
+/* one benchmark run. Histograms that weren't measured are NULL and left out of the line */
+typedef struct
+{
+    const char* name;               /* what was measured, e.g. "write" */
+    const char* link;               /* what it ran over, e.g. "sim_clean" or "device" */
+    uint32_t payload_bytes;
+    uint32_t sent;                  /* frames or messages handed to the stack */
+    uint32_t received;              /* of those, how many made it */
+    uint64_t bytes;                 /* payload bytes that made it */
+    uint32_t elapsed_us;
+    const BENCH_HIST_T* latency;    /* one way where clocks are shared, otherwise send to ack */
+    const BENCH_HIST_T* rtt;
+} BENCH_RESULT_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+void bench_hist_init(BENCH_HIST_T* hist);
+
+void bench_hist_add(BENCH_HIST_T* hist, uint32_t value);
+
+/**
+ * \brief value below which permille of samples fall, to bucket resolution. Reports the top of
+ *        the bucket, but never more than the largest sample
+ *
+ * \param permille 0 to 1000, e.g. 990 for p99
+ *
+ * \return 0 if hist is empty
+ */
+uint32_t bench_hist_percentile(const BENCH_HIST_T* hist, uint32_t permille);
+
+/**
+ * \brief writes result as BENCH_LINE_PREFIX and one line of JSON, integers only. Rates are per
+ *        second of elapsed_us
+ *
+ * \return length written, not counting terminator. Truncated if size is under BENCH_LINE_BYTES
+ */
+uint32_t bench_format_result(const BENCH_RESULT_T* result, char* out, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ ********************************************************************************
+ * @file    console.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Text command console. Bytes from the PC are assembled into lines, split into
+ *          words and handed to the registered command whose name matches the first word.
+ *          Stands in for buttons and screens until the UI exists. console_uart.c feeds it
+ *          from the UART on target
+ ********************************************************************************
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* longest line, not counting the end of line. Longer lines are thrown away */
+#define CONSOLE_LINE_BYTES (96U)
+
+/* words in a line, including the command name. Extra words are ignored */
+#define CONSOLE_MAX_ARGS (8U)
+
+#define CONSOLE_MAX_COMMANDS (16U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* argv[0] is the command name. Words are only valid until the handler returns */
+typedef void (*CONSOLE_HANDLER_T)(uint32_t argc, char** argv);
+
+typedef struct
+{
+    const char* name;
+    const char* help;           /* one line, printed by "help" */
+    CONSOLE_HANDLER_T handler;
+} CONSOLE_COMMAND_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets every command and any partial line. "help" is always available
+ */
+void console_init(void);
+
+/**
+ * \brief adds command. command must stay valid, it isn't copied
+ *
+ * \return false if CONSOLE_MAX_COMMANDS are already registered, or name is taken
+ */
+bool console_register(const CONSOLE_COMMAND_T* command);
+
+/**
+ * \brief feeds received bytes. Runs a command for each complete line (ended by \r or \n),
+ *        from the calling task. Backspace removes the last byte of the line
+ */
+void console_feed(const uint8_t* data, uint32_t length);
+
+/**
+ * \brief runs one line as if it had been typed
+ *
+ * \return false if line was empty or no command matched
+ */
+bool console_execute(char* line);
+
+/**
+ * \brief starts a low priority task reading the console UART into console_feed(). Target only
+ */
+bool console_uart_start(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
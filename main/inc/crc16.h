@@ -0,0 +1,46 @@
+/**
+ ********************************************************************************
+ * @file    crc16.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Table driven CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF, no reflection, no final
+ *          xor). One 256 entry lookup per byte
+ ********************************************************************************
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* starting value for a new crc */
+#define CRC16_INIT (0xFFFFU)
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief adds data to crc. Pass CRC16_INIT to start, or a previous result to continue over
+ *        data split in pieces
+ *
+ * \return crc of everything so far
+ */
+uint16_t crc16_update(uint16_t crc, const uint8_t* data, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
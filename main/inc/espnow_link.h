@@ -19,13 +19,31 @@ extern "C" {
  ************************************/
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 #include "esp_now.h"
+#include "espnow_link_ring.h"
+#include "espnow_link_tx.h"
+#include "espnow_link_ps.h"
+#include "espnow_link_chan.h"
+#include "espnow_link_rate.h"
 
 /************************************
  * MACROS AND DEFINES
  ************************************/
 #define ESPNOW_DATA_BYTES 250U
-#define ESPNOW_LINK_QUEUE_LENGTH (16U)
+
+/* timeout value for espnow_link_wait_for_messages() that never expires */
+#define ESPNOW_LINK_WAIT_FOREVER (0xFFFFFFFFU)
+
+/* size of receive ring in bytes. Must be a power of 2 */
+#ifdef CONFIG_ESPNOW_RX_RING_BYTES
+#define ESPNOW_LINK_RX_RING_BYTES (CONFIG_ESPNOW_RX_RING_BYTES)
+#else
+#define ESPNOW_LINK_RX_RING_BYTES (4096U)
+#endif
+
+/* frames written while their peer's radio is off wait here for its wake window. Must be a power of 2 */
+#define ESPNOW_LINK_TX_HOLD_BYTES (2048U)
 
 /************************************
  * TYPEDEFS
@@ -33,21 +51,48 @@ extern "C" {
 typedef enum
 {
     ESPNOW_LINK_ERR_NONE,
-    ESPNOW_LINK_ERR
+    ESPNOW_LINK_ERR,
+    ESPNOW_LINK_ERR_BUSY,   /* ESPNOW_LINK_TX_MAX_IN_FLIGHT frames already waiting on send callback */
+    ESPNOW_LINK_ERR_TIMEOUT
 } ESPNOW_LINK_ERR_T;
 
+/* received frame. Only info.data_len bytes of data are valid */
 typedef struct
 {
-    esp_now_recv_info_t recv_info;
+    ESPNOW_LINK_RX_DESC_T info;
     uint8_t data[ESPNOW_DATA_BYTES];
 } ESPNOW_LINK_MSG_T;
 
 typedef struct
 {
-    ESPNOW_LINK_MSG_T array[ESPNOW_LINK_QUEUE_LENGTH];
-    uint8_t head_index;
-    uint8_t tail_index;
-} ESPNOW_LINK_MSG_QUEUE_T;
+    uint32_t frames_received;
+    ESPNOW_LINK_RING_STATS_T ring;
+} ESPNOW_LINK_RX_STATS_T;
+
+typedef enum
+{
+    ESPNOW_LINK_POWER_ALWAYS_ON,  /* radio always on, e.g. for a push to talk session */
+    ESPNOW_LINK_POWER_SAVE,       /* radio on for ESPNOW_LINK_PS_WINDOW_MS every ESPNOW_LINK_PS_INTERVAL_MS */
+    ESPNOW_LINK_POWER_MODES
+} ESPNOW_LINK_POWER_MODE_T;
+
+/* what a power mode costs and how it treats traffic, counted while the mode is on */
+typedef struct
+{
+    uint32_t mode_ms;
+    uint32_t radio_on_ms;     /* of mode_ms. Radio current is drawn for this long */
+    uint32_t frames_sent;
+    uint32_t frames_held;     /* waited for their peer's wake window */
+    uint32_t hold_ms;         /* total time held frames waited */
+} ESPNOW_LINK_POWER_MODE_STATS_T;
+
+typedef struct
+{
+    ESPNOW_LINK_POWER_MODE_T mode;
+    ESPNOW_LINK_POWER_MODE_STATS_T modes[ESPNOW_LINK_POWER_MODES];
+    uint32_t beacons_sent;
+    uint32_t beacons_heard;
+} ESPNOW_LINK_POWER_STATS_T;
 
 /************************************
  * GLOBAL FUNCTION PROTOTYPES
@@ -69,13 +114,67 @@ ESPNOW_LINK_ERR_T espnow_link_close(void);
 ESPNOW_LINK_ERR_T espnow_link_register_peer(const uint8_t* peer_mac_address);
 
 /**
- * \brief send command
+ * \brief Removes peer from network, freeing its slot in esp now's peer list. Broadcast stays,
+ *        the link sends on it
+ */
+ESPNOW_LINK_ERR_T espnow_link_unregister_peer(const uint8_t* peer_mac_address);
+
+/**
+ * \brief send command. Blocks until the send callback for this frame arrives
  * 
  * \param peer_mac[in] 6 byte MAC address for peer
  * \param buffer[in] data to send. Length must be less than ESP_NOW_MAX_DATA_LEN
  */
 ESPNOW_LINK_ERR_T espnow_link_write(const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length);
 
+/**
+ * \brief queue frame to esp now and return without waiting for the send callback.
+ *        Up to ESPNOW_LINK_TX_MAX_IN_FLIGHT frames can be in the air at once, counting frames
+ *        held for a peer's wake window. Frames never go out of order, so a held frame also
+ *        holds every frame written after it
+ * 
+ * \param peer_mac[in] 6 byte MAC address for peer
+ * \param data[in] data to send. esp now copies it, so buffer can be reused on return
+ * \param data_length length of data. Must be less than ESP_NOW_MAX_DATA_LEN
+ * \param callback[in] optional, called from wifi task when frame completes (pass NULL if not used)
+ * \param context[in] passed to callback
+ * \param handle[out] identifies frame for espnow_link_wait_tx() (pass NULL if not used)
+ * 
+ * \return ESPNOW_LINK_ERR_BUSY if too many frames are already in flight
+ */
+ESPNOW_LINK_ERR_T espnow_link_write_async(const uint8_t* peer_mac,
+                                          const uint8_t* data,
+                                          uint16_t data_length,
+                                          ESPNOW_LINK_TX_DONE_CB_T callback,
+                                          void* context,
+                                          ESPNOW_LINK_TX_HANDLE_T* handle);
+
+/**
+ * \brief waits for send callback of a frame queued with espnow_link_write_async()
+ * 
+ * \param handle handle returned by espnow_link_write_async()
+ * \param timeout_ms max time to wait
+ * 
+ * \return ESPNOW_LINK_ERR_NONE if peer acked frame, ESPNOW_LINK_ERR_TIMEOUT if still in flight.
+ *         ESPNOW_LINK_ERR if frame failed, or if its result is no longer tracked because
+ *         ESPNOW_LINK_TX_MAX_IN_FLIGHT newer frames were sent since
+ */
+ESPNOW_LINK_ERR_T espnow_link_wait_tx(ESPNOW_LINK_TX_HANDLE_T handle, uint32_t timeout_ms);
+
+/**
+ * \brief sleeps until espnow_link_write_async() has room for another frame
+ *
+ * \param timeout_ms max time to wait, or ESPNOW_LINK_WAIT_FOREVER
+ *
+ * \return ESPNOW_LINK_ERR_TIMEOUT if ESPNOW_LINK_TX_MAX_IN_FLIGHT frames are still in flight
+ */
+ESPNOW_LINK_ERR_T espnow_link_wait_tx_slot(uint32_t timeout_ms);
+
+/**
+ * \brief returns number of frames waiting on their send callback
+ */
+uint32_t espnow_link_tx_pending(void);
+
 /**
  * \brief puts device mac address into buffer
  * 
@@ -84,10 +183,9 @@ ESPNOW_LINK_ERR_T espnow_link_write(const uint8_t* peer_mac, const uint8_t* data
 ESPNOW_LINK_ERR_T espnow_link_get_device_mac(const uint8_t* buffer);
 
 /**
- * \brief puts device mac address into buffer
+ * \brief copies oldest received message out of receive ring
  * 
- * \param esp_now_info[out] buffer to put esp_now_info into
- * \param data_buffer[out] buffer to put device mac address in
+ * \param msg_buffer[out] buffer to put message into. Only msg_buffer->info.data_len bytes of data are written
  */
 ESPNOW_LINK_ERR_T espnow_link_read(const ESPNOW_LINK_MSG_T* msg_buffer);
 
@@ -96,6 +194,81 @@ ESPNOW_LINK_ERR_T espnow_link_read(const ESPNOW_LINK_MSG_T* msg_buffer);
  */
 bool espnow_link_messages_available(void);
 
+/**
+ * \brief sleeps until a message is available to read. Woken by the receive callback through a
+ *        task notification, so the calling task doesn't need to poll. Only one task should wait.
+ *        Also returns early (with false if nothing arrived) after espnow_link_wake_reader()
+ * 
+ * \param timeout_ms max time to wait, or ESPNOW_LINK_WAIT_FOREVER. Rounded to ticks, and
+ *        anything above 0 waits at least one
+ * 
+ * \return true if a message is available
+ */
+bool espnow_link_wait_for_messages(uint32_t timeout_ms);
+
+/**
+ * \brief makes a task sleeping in espnow_link_wait_for_messages() return early, even though no
+ *        message arrived. With none sleeping, the next call returns early instead, so a wake is
+ *        never lost. Safe to call from send callbacks
+ */
+void espnow_link_wake_reader(void);
+
+/**
+ * \brief selects what happens when a frame arrives and the receive ring is full
+ */
+void espnow_link_set_rx_overflow_policy(ESPNOW_LINK_RING_POLICY_T policy);
+
+/**
+ * \brief copies receive counters (frames received, drops, ring high water mark) into stats
+ */
+void espnow_link_get_rx_stats(ESPNOW_LINK_RX_STATS_T* stats);
+
+/**
+ * \brief switches between a duty cycled and an always on radio. In power save, the radio also
+ *        stays on for ESPNOW_LINK_PS_HOLD_AWAKE_MS after each frame received. Either way,
+ *        frames for a peer that duty cycles are held until its window, in write order
+ *
+ * \return ESPNOW_LINK_ERR if CONFIG_ESPNOW_ENABLE_POWER_SAVE is off and mode is POWER_SAVE
+ */
+ESPNOW_LINK_ERR_T espnow_link_set_power_mode(ESPNOW_LINK_POWER_MODE_T mode);
+
+/**
+ * \brief copies time and traffic of each power mode into stats
+ */
+void espnow_link_get_power_stats(ESPNOW_LINK_POWER_STATS_T* stats);
+
+/**
+ * \brief moves the radio to channel. Peers are registered on the current channel, so they
+ *        move with it. Every unit has to move too, see wt20_switch_channel()
+ *
+ * \return ESPNOW_LINK_ERR if channel is outside ESPNOW_LINK_CHAN_FIRST to ESPNOW_LINK_CHAN_LAST
+ */
+ESPNOW_LINK_ERR_T espnow_link_set_wifi_channel(uint8_t channel);
+
+uint8_t espnow_link_get_wifi_channel(void);
+
+/**
+ * \brief listens on every channel in turn for dwell_ms, adding up the airtime and noise floor
+ *        of every frame heard, then goes back to the working channel. Blocks for
+ *        ESPNOW_LINK_CHAN_COUNT dwells, and meanwhile this unit misses its peers' frames and its
+ *        own frames go out on the channel being surveyed, so it is meant for pairing time
+ *
+ * \param survey[out] see espnow_link_chan_pick()
+ */
+ESPNOW_LINK_ERR_T espnow_link_scan_channels(uint32_t dwell_ms, ESPNOW_LINK_CHAN_SURVEY_T* survey);
+
+/**
+ * \brief copies rssi, noise floor and delivery on the working channel into stats
+ */
+void espnow_link_get_chan_stats(ESPNOW_LINK_CHAN_STATS_T* stats);
+
+/**
+ * \brief copies the PHY rate frames to peer_mac go at, its delivery there and its rssi into stats
+ *
+ * \return ESPNOW_LINK_ERR if nothing has been sent to or heard from peer_mac lately
+ */
+ESPNOW_LINK_ERR_T espnow_link_get_peer_rate(const uint8_t* peer_mac, ESPNOW_LINK_RATE_STATS_T* stats);
+
 #ifdef __cplusplus
 }
 #endif
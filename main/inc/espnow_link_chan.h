@@ -0,0 +1,175 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_chan.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Channel quality. On the working channel, the rssi and noise floor of received
+ *          frames and the delivery ratio of unicast sends are tracked. A survey of the other
+ *          channels adds up the airtime of every frame heard on each, and their noise floor,
+ *          and scores each by its own traffic plus the traffic spilling over from overlapping
+ *          neighbours, 2.4 GHz channels being 5 MHz apart but 20 MHz wide
+ ********************************************************************************
+ */
+
+#ifndef ESPNOW_LINK_CHAN_H
+#define ESPNOW_LINK_CHAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* channels surveyed, the ones allowed everywhere */
+#define ESPNOW_LINK_CHAN_FIRST (1U)
+#define ESPNOW_LINK_CHAN_LAST (13U)
+#define ESPNOW_LINK_CHAN_COUNT (ESPNOW_LINK_CHAN_LAST - ESPNOW_LINK_CHAN_FIRST + 1U)
+
+/* channel the link starts on */
+#if defined(CONFIG_ESPNOW_CHANNEL) && (CONFIG_ESPNOW_CHANNEL >= 1) && (CONFIG_ESPNOW_CHANNEL <= 13)
+#define ESPNOW_LINK_CHAN_DEFAULT (CONFIG_ESPNOW_CHANNEL)
+#else
+#define ESPNOW_LINK_CHAN_DEFAULT (1U)
+#endif
+
+/* time spent listening on each channel during a survey */
+#ifdef CONFIG_ESPNOW_SCAN_DWELL_MS
+#define ESPNOW_LINK_CHAN_DWELL_MS (CONFIG_ESPNOW_SCAN_DWELL_MS)
+#else
+#define ESPNOW_LINK_CHAN_DWELL_MS (100U)
+#endif
+
+/* score, in per mille of airtime, another channel has to win by before it is worth moving
+   every unit over */
+#ifdef CONFIG_ESPNOW_CHANNEL_HYSTERESIS
+#define ESPNOW_LINK_CHAN_HYSTERESIS (CONFIG_ESPNOW_CHANNEL_HYSTERESIS)
+#else
+#define ESPNOW_LINK_CHAN_HYSTERESIS (100U)
+#endif
+
+/* noise floor of a quiet channel. Each dB above costs ESPNOW_LINK_CHAN_NOISE_COST in score,
+   as it eats into the margin of every frame whether or not anyone is sending */
+#define ESPNOW_LINK_CHAN_QUIET_NOISE_DBM (-95)
+#define ESPNOW_LINK_CHAN_NOISE_COST (20U)
+
+/* frames heard in a survey are mostly other networks' at rates unknown here, so their
+   airtime is taken at a nominal legacy rate, preamble included */
+#define ESPNOW_LINK_CHAN_NOMINAL_MBPS (6U)
+#define ESPNOW_LINK_CHAN_PREAMBLE_US (20U)
+
+/* unicast sends per delivery ratio, and the ratio under which the channel counts as degraded */
+#define ESPNOW_LINK_CHAN_TX_WINDOW (32U)
+#define ESPNOW_LINK_CHAN_DEGRADED_PERMILLE (800U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* what a survey heard on one channel */
+typedef struct
+{
+    uint32_t dwell_us;        /* 0 if never surveyed */
+    uint32_t busy_us;
+    uint32_t frames;
+    int32_t noise_sum;        /* dBm, over frames */
+    int8_t rssi_max;
+} ESPNOW_LINK_CHAN_SCAN_T;
+
+typedef struct
+{
+    ESPNOW_LINK_CHAN_SCAN_T channels[ESPNOW_LINK_CHAN_COUNT];
+} ESPNOW_LINK_CHAN_SURVEY_T;
+
+/* working channel, fed from the receive and send callbacks */
+typedef struct
+{
+    int32_t rssi_x16;         /* moving averages, 16ths of a dBm */
+    int32_t noise_x16;
+    uint32_t frames_rx;
+    uint32_t tx_acked;
+    uint32_t tx_failed;
+    uint16_t window_sent;
+    uint16_t window_acked;
+    uint16_t delivery_permille;   /* over the last full window */
+} ESPNOW_LINK_CHAN_MONITOR_T;
+
+typedef struct
+{
+    uint8_t channel;
+    int8_t rssi;              /* averages of frames received on it */
+    int8_t noise_floor;
+    bool degraded;            /* delivery under ESPNOW_LINK_CHAN_DEGRADED_PERMILLE */
+    uint16_t delivery_permille;
+    uint32_t frames_rx;
+    uint32_t tx_acked;        /* unicast only, nothing acks a broadcast */
+    uint32_t tx_failed;
+    uint32_t switches;
+} ESPNOW_LINK_CHAN_STATS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief starts over, for a new channel
+ */
+void espnow_link_chan_monitor_init(ESPNOW_LINK_CHAN_MONITOR_T* monitor);
+
+void espnow_link_chan_on_rx(ESPNOW_LINK_CHAN_MONITOR_T* monitor, int8_t rssi, int8_t noise_floor);
+
+/**
+ * \brief records the result of a unicast send
+ */
+void espnow_link_chan_on_tx(ESPNOW_LINK_CHAN_MONITOR_T* monitor, bool acked);
+
+/**
+ * \brief fills everything in stats but channel and switches
+ */
+void espnow_link_chan_get_stats(const ESPNOW_LINK_CHAN_MONITOR_T* monitor, ESPNOW_LINK_CHAN_STATS_T* stats);
+
+void espnow_link_chan_survey_init(ESPNOW_LINK_CHAN_SURVEY_T* survey);
+
+/**
+ * \brief estimated airtime of a frame of length bytes, see ESPNOW_LINK_CHAN_NOMINAL_MBPS
+ */
+uint32_t espnow_link_chan_airtime_us(uint16_t length);
+
+/**
+ * \brief records a frame heard on channel during a survey
+ */
+void espnow_link_chan_scan_add(ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel, int8_t rssi, int8_t noise_floor, uint32_t airtime_us);
+
+/**
+ * \brief records time spent listening on channel
+ */
+void espnow_link_chan_scan_dwell(ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel, uint32_t dwell_us);
+
+/**
+ * \brief scores a surveyed channel, lower is better. Per mille of airtime taken on it, plus
+ *        half of that on the channels next to it and a quarter two away, plus the noise cost
+ *
+ * \return UINT32_MAX if channel wasn't surveyed
+ */
+uint32_t espnow_link_chan_score(const ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel);
+
+/**
+ * \brief best surveyed channel. current stays unless another beats it by ESPNOW_LINK_CHAN_HYSTERESIS
+ *
+ * \return current if nothing better was surveyed
+ */
+uint8_t espnow_link_chan_pick(const ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t current);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_ps.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Wake window schedule of power saving peers. A unit that duty cycles its radio
+ *          broadcasts a short beacon each time its wake window opens, so neighbours know when
+ *          it listens and hold frames for it until then
+ ********************************************************************************
+ */
+
+#ifndef ESPNOW_LINK_PS_H
+#define ESPNOW_LINK_PS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#ifdef CONFIG_ESPNOW_WAKE_WINDOW
+#define ESPNOW_LINK_PS_WINDOW_MS (CONFIG_ESPNOW_WAKE_WINDOW)
+#else
+#define ESPNOW_LINK_PS_WINDOW_MS (50U)
+#endif
+
+#ifdef CONFIG_ESPNOW_WAKE_INTERVAL
+#define ESPNOW_LINK_PS_INTERVAL_MS (CONFIG_ESPNOW_WAKE_INTERVAL)
+#else
+#define ESPNOW_LINK_PS_INTERVAL_MS (100U)
+#endif
+
+/* receiving a frame keeps the radio on this long, so a conversation isn't cut up into windows */
+#ifdef CONFIG_ESPNOW_PS_HOLD_AWAKE_MS
+#define ESPNOW_LINK_PS_HOLD_AWAKE_MS (CONFIG_ESPNOW_PS_HOLD_AWAKE_MS)
+#else
+#define ESPNOW_LINK_PS_HOLD_AWAKE_MS (500U)
+#endif
+
+/* peers whose schedule is remembered */
+#define ESPNOW_LINK_PS_PEERS (8U)
+
+/* a frame only goes into a window with at least this much of it left, for retries */
+#define ESPNOW_LINK_PS_MARGIN_US (3000U)
+
+/* magic, window ms (2), interval ms (2), awake ms (2). Shorter than any upper layer frame,
+   so the link can take beacons out of the receive path by length and magic. A window beacon is
+   sent as the sender's window opens, an awake beacon when it stays on outside its windows */
+#define ESPNOW_LINK_PS_BEACON_BYTES (7U)
+#define ESPNOW_LINK_PS_WINDOW_MAGIC (0xA5U)
+#define ESPNOW_LINK_PS_AWAKE_MAGIC (0xA6U)
+
+/* awake ms of a unit that isn't duty cycling, until its next beacon says otherwise */
+#define ESPNOW_LINK_PS_AWAKE_FOREVER (0xFFFFU)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t mac[6U];
+    bool used;
+    bool awake_forever;
+    uint32_t anchor_us;       /* a moment its window opened */
+    uint32_t window_us;
+    uint32_t interval_us;
+    uint32_t awake_until_us;  /* awake past its window, e.g. while holding for traffic */
+    uint32_t last_used;
+} ESPNOW_LINK_PS_PEER_T;
+
+typedef struct
+{
+    ESPNOW_LINK_PS_PEER_T peers[ESPNOW_LINK_PS_PEERS];
+    uint32_t clock;
+} ESPNOW_LINK_PS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets every peer's schedule
+ */
+void espnow_link_ps_init(ESPNOW_LINK_PS_T* ps);
+
+/**
+ * \brief builds a beacon
+ *
+ * \param window_open whether the sender's window opens now. Only these beacons set when the
+ *        sender's windows fall
+ * \param awake_ms how long the sender stays awake from now, ESPNOW_LINK_PS_AWAKE_FOREVER if
+ *        it stopped duty cycling
+ * \param frame[out] buffer of at least ESPNOW_LINK_PS_BEACON_BYTES
+ *
+ * \return beacon length
+ */
+uint16_t espnow_link_ps_build_beacon(bool window_open, uint16_t window_ms, uint16_t interval_ms, uint16_t awake_ms, uint8_t* frame);
+
+/**
+ * \brief records the schedule in a beacon from mac, heard at now_us
+ *
+ * \return false if frame isn't a beacon
+ */
+bool espnow_link_ps_on_beacon(ESPNOW_LINK_PS_T* ps, const uint8_t* mac, const uint8_t* frame, uint16_t length, uint32_t now_us);
+
+/**
+ * \brief how long a frame for mac should wait for mac's radio to be on. Peers never heard
+ *        from, and broadcasts, are taken to be awake
+ *
+ * \return 0 if the frame can go now, otherwise microseconds until mac's next window
+ */
+uint32_t espnow_link_ps_wait_us(const ESPNOW_LINK_PS_T* ps, const uint8_t* mac, uint32_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,174 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_rate.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   PHY rate per peer, picked the way minstrel does but with less bookkeeping. Every
+ *          unicast send's result is counted against the rate it went at, and each
+ *          ESPNOW_LINK_RATE_INTERVAL_MS the counts are folded into a moving average delivery
+ *          ratio per rate. The peer then goes at whichever rate that has been tried moves the
+ *          most frames per second, delivery times frames per second at that rate. Every
+ *          ESPNOW_LINK_RATE_PROBE_EVERY frames one goes a rate up, so a rate that got better is
+ *          found, unless the peer's rssi says it can't work. A run of failures drops a rate
+ *          straight away, without waiting for the interval. A new peer starts at the fastest
+ *          rate its rssi allows
+ ********************************************************************************
+ */
+
+#ifndef ESPNOW_LINK_RATE_H
+#define ESPNOW_LINK_RATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "espnow_link_tx.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* esp now's own limit on unicast peers */
+#define ESPNOW_LINK_RATE_MAX_PEERS (20U)
+
+#define ESPNOW_LINK_RATE_INTERVAL_MS (100U)
+#define ESPNOW_LINK_RATE_PROBE_EVERY (16U)
+
+/* results a rate other than the current one needs before it can be picked, so one lucky
+   probe doesn't move a peer to a rate that mostly fails */
+#define ESPNOW_LINK_RATE_MIN_SAMPLES (3U)
+
+/* failures in a row at the current rate that drop it a rate */
+#define ESPNOW_LINK_RATE_FALLBACK_FAILURES (3U)
+
+/* a rate is probed while the peer's rssi is at most this far under what the rate needs */
+#define ESPNOW_LINK_RATE_PROBE_MARGIN_DB (6)
+
+/* frame length rates are compared at, about a wt20 voice frame */
+#define ESPNOW_LINK_RATE_FRAME_BYTES (250U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* slowest first. The LR rates are only used with long range on */
+typedef enum
+{
+    ESPNOW_LINK_RATE_LR_250K,
+    ESPNOW_LINK_RATE_LR_500K,
+    ESPNOW_LINK_RATE_1M,
+    ESPNOW_LINK_RATE_2M,
+    ESPNOW_LINK_RATE_5M5,
+    ESPNOW_LINK_RATE_11M,
+    ESPNOW_LINK_RATE_24M,
+    ESPNOW_LINK_RATE_36M,
+    ESPNOW_LINK_RATE_54M,
+    ESPNOW_LINK_RATE_COUNT
+} ESPNOW_LINK_RATE_T;
+
+typedef struct
+{
+    uint32_t kbps;
+    uint16_t preamble_us;
+    int8_t min_rssi;          /* rssi the rate needs to deliver nearly every frame */
+} ESPNOW_LINK_RATE_INFO_T;
+
+typedef struct
+{
+    ESPNOW_LINK_RATE_T rate;
+    uint32_t kbps;
+    uint16_t delivery_permille; /* moving average at the current rate */
+    int8_t rssi;
+    uint32_t probes;
+    uint32_t rate_changes;
+    uint32_t frames_acked;
+    uint32_t frames_failed;
+} ESPNOW_LINK_RATE_STATS_T;
+
+typedef struct
+{
+    bool used;
+    uint8_t mac[6U];
+    uint8_t rate;
+    uint8_t applied;          /* rate the radio was last set to for this peer, COUNT if none */
+    uint16_t delivery[ESPNOW_LINK_RATE_COUNT];  /* per mille, 0 until tried */
+    uint16_t attempts[ESPNOW_LINK_RATE_COUNT];  /* this interval */
+    uint16_t acked[ESPNOW_LINK_RATE_COUNT];
+    uint8_t samples[ESPNOW_LINK_RATE_COUNT];    /* results since the rate last failed out, up to 255 */
+    uint8_t in_flight[ESPNOW_LINK_TX_MAX_IN_FLIGHT]; /* rate of each frame waiting on its result, oldest first */
+    uint8_t in_flight_head;
+    uint8_t in_flight_count;
+    int32_t rssi_x16;
+    bool rssi_known;
+    uint32_t last_update_ms;
+    uint32_t last_used_ms;
+    uint16_t since_probe;
+    uint8_t failures;
+    ESPNOW_LINK_RATE_STATS_T stats;
+} ESPNOW_LINK_RATE_PEER_T;
+
+/* written from the sending tasks and the wifi task, so callers serialize access */
+typedef struct
+{
+    ESPNOW_LINK_RATE_PEER_T peers[ESPNOW_LINK_RATE_MAX_PEERS];
+    ESPNOW_LINK_RATE_T lowest;
+} ESPNOW_LINK_RATE_TABLE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets every peer
+ *
+ * \param long_range whether the LR rates may be used. Every unit has to have long range on
+ *        for them to be heard
+ */
+void espnow_link_rate_init(ESPNOW_LINK_RATE_TABLE_T* table, bool long_range);
+
+const ESPNOW_LINK_RATE_INFO_T* espnow_link_rate_info(ESPNOW_LINK_RATE_T rate);
+
+/**
+ * \return time on air of a length byte frame at rate, preamble included
+ */
+uint32_t espnow_link_rate_frame_us(ESPNOW_LINK_RATE_T rate, uint16_t length);
+
+/**
+ * \brief rate to send the next frame to mac at, noted as in flight until its result comes in.
+ *        Peers are added as they are first seen. With the table full the least recently used
+ *        one with nothing in flight makes room
+ *
+ * \param reconfigure[out] true if it isn't the rate the radio was last set to for mac
+ *
+ * \return ESPNOW_LINK_RATE_1M, and reconfigure false, if there was no room for mac
+ */
+ESPNOW_LINK_RATE_T espnow_link_rate_select(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, uint32_t now_ms, bool* reconfigure);
+
+/**
+ * \brief forgets the frame to mac last selected for, when it never went out
+ */
+void espnow_link_rate_cancel(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac);
+
+/**
+ * \brief counts the result of the oldest frame to mac in flight
+ */
+void espnow_link_rate_on_tx(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, bool acked);
+
+void espnow_link_rate_on_rx(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, int8_t rssi, uint32_t now_ms);
+
+/**
+ * \return false if mac isn't in the table
+ */
+bool espnow_link_rate_get_stats(const ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, ESPNOW_LINK_RATE_STATS_T* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
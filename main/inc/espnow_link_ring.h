@@ -0,0 +1,147 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_ring.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free single producer / single consumer receive ring for espnow_link.
+ *          Frames are stored as a compact descriptor followed by only data_len bytes.
+ ********************************************************************************
+ */
+
+#ifndef ESPNOW_LINK_RING_H
+#define ESPNOW_LINK_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define ESPNOW_LINK_RING_MAC_BYTES (6U)
+
+/* every record starts on a 4 byte boundary */
+#define ESPNOW_LINK_RING_ALIGN (4U)
+
+/* bytes of ring used by a record holding data_len bytes of data */
+#define ESPNOW_LINK_RING_RECORD_BYTES(data_len) \
+    (sizeof(ESPNOW_LINK_RX_DESC_T) + \
+     (((uint32_t)(data_len) + (ESPNOW_LINK_RING_ALIGN - 1U)) & ~(ESPNOW_LINK_RING_ALIGN - 1U)))
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* what to do when a frame arrives and the ring is full */
+typedef enum
+{
+    ESPNOW_LINK_RING_DROP_NEWEST, /* discard the incoming frame */
+    ESPNOW_LINK_RING_DROP_OLDEST  /* discard unread frames until the incoming frame fits */
+} ESPNOW_LINK_RING_POLICY_T;
+
+/* compact per-frame descriptor, stored in front of the frame data */
+typedef struct
+{
+    uint8_t src_mac[ESPNOW_LINK_RING_MAC_BYTES];
+    int8_t rssi;
+    int8_t noise_floor;
+    uint32_t timestamp_us;
+    uint16_t data_len;
+    uint16_t reserved2;
+} ESPNOW_LINK_RX_DESC_T;
+
+typedef struct
+{
+    uint32_t dropped_newest;  /* frames rejected because ring was full (DROP_NEWEST) */
+    uint32_t dropped_oldest;  /* unread frames discarded to make room (DROP_OLDEST) */
+    uint32_t rejected;        /* frames that could never fit (bad length) */
+    uint32_t high_water_bytes;/* most bytes of ring ever in use */
+} ESPNOW_LINK_RING_STATS_T;
+
+/*
+ * head and tail are free running byte positions, masked on access. head is only
+ * written by the producer. tail is normally advanced by the consumer, but in
+ * DROP_OLDEST mode the producer may also advance it, so both sides use CAS on it.
+ */
+typedef struct
+{
+    uint8_t* buffer;
+    uint32_t size;
+    ESPNOW_LINK_RING_POLICY_T policy;
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+    atomic_uint_least32_t dropped_newest;
+    atomic_uint_least32_t dropped_oldest;
+    atomic_uint_least32_t rejected;
+    uint32_t high_water_bytes;
+} ESPNOW_LINK_RING_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief sets up ring on top of caller provided storage
+ *
+ * \param ring[out] ring to initialize
+ * \param buffer[in] storage for ring. Must be 4 byte aligned
+ * \param size size of buffer in bytes. Must be a power of 2
+ * \param policy what to drop when ring is full
+ *
+ * \return false if buffer or size is invalid
+ */
+bool espnow_link_ring_init(ESPNOW_LINK_RING_T* ring, uint8_t* buffer, uint32_t size, ESPNOW_LINK_RING_POLICY_T policy);
+
+/**
+ * \brief changes overflow policy. Only call while producer is not running
+ */
+void espnow_link_ring_set_policy(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RING_POLICY_T policy);
+
+/**
+ * \brief Producer side. Copies descriptor and desc->data_len bytes of data into ring
+ *
+ * \param desc[in] descriptor of frame. data_len must be set
+ * \param data[in] frame data
+ *
+ * \return true if frame was stored
+ */
+bool espnow_link_ring_push(ESPNOW_LINK_RING_T* ring, const ESPNOW_LINK_RX_DESC_T* desc, const uint8_t* data);
+
+/**
+ * \brief Consumer side. Copies oldest frame out of ring
+ *
+ * \param desc[out] descriptor of frame
+ * \param data[out] buffer for frame data
+ * \param data_capacity size of data buffer. Frames longer than this are truncated
+ *
+ * \return true if a frame was read
+ */
+bool espnow_link_ring_pop(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RX_DESC_T* desc, uint8_t* data, uint16_t data_capacity);
+
+/**
+ * \brief returns whether ring has unread frames. Safe from either side
+ */
+bool espnow_link_ring_is_empty(ESPNOW_LINK_RING_T* ring);
+
+/**
+ * \brief returns number of bytes currently in use
+ */
+uint32_t espnow_link_ring_used_bytes(ESPNOW_LINK_RING_T* ring);
+
+/**
+ * \brief copies drop counters and high water mark into stats
+ */
+void espnow_link_ring_get_stats(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RING_STATS_T* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,152 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_tx.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Tracks frames handed to esp now that are waiting on their send callback.
+ *          esp now reports send results in the order frames were sent, so completions
+ *          are matched to frames first in, first out.
+ ********************************************************************************
+ */
+
+#ifndef ESPNOW_LINK_TX_H
+#define ESPNOW_LINK_TX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* max frames handed to esp now that haven't had their send callback yet. Must be a power of 2 */
+#ifdef CONFIG_ESPNOW_TX_MAX_IN_FLIGHT
+#define ESPNOW_LINK_TX_MAX_IN_FLIGHT (CONFIG_ESPNOW_TX_MAX_IN_FLIGHT)
+#else
+#define ESPNOW_LINK_TX_MAX_IN_FLIGHT (8U)
+#endif
+
+/* handle value that never refers to a frame */
+#define ESPNOW_LINK_TX_INVALID_HANDLE (0U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef uint32_t ESPNOW_LINK_TX_HANDLE_T;
+
+/* called from wifi task context when the send callback for a frame arrives */
+typedef void (*ESPNOW_LINK_TX_DONE_CB_T)(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context);
+
+typedef enum
+{
+    ESPNOW_LINK_TX_STATE_FREE,
+    ESPNOW_LINK_TX_STATE_PENDING,
+    ESPNOW_LINK_TX_STATE_SUCCESS,
+    ESPNOW_LINK_TX_STATE_FAILED
+} ESPNOW_LINK_TX_STATE_T;
+
+typedef struct
+{
+    atomic_uint_least32_t handle;
+    atomic_int state;
+    uint8_t peer_mac[6U];
+    ESPNOW_LINK_TX_DONE_CB_T callback;
+    void* context;
+} ESPNOW_LINK_TX_SLOT_T;
+
+/*
+ * head is advanced by the send callback (completions), tail by the sending task (reservations).
+ * Slots keep their result after completion until they are reused, so a handle can be queried
+ * for a short while after its callback.
+ */
+typedef struct
+{
+    ESPNOW_LINK_TX_SLOT_T slots[ESPNOW_LINK_TX_MAX_IN_FLIGHT];
+    atomic_uint_least32_t head;
+    atomic_uint_least32_t tail;
+    uint32_t mac_mismatches;
+    uint32_t unmatched_completions;
+} ESPNOW_LINK_TX_TRACKER_T;
+
+/* what the send callback needs to finish a frame, copied out before the slot can be reused */
+typedef struct
+{
+    uint32_t slot_index;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    ESPNOW_LINK_TX_DONE_CB_T callback;
+    void* context;
+} ESPNOW_LINK_TX_COMPLETION_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief clears tracker
+ */
+void espnow_link_tx_init(ESPNOW_LINK_TX_TRACKER_T* tracker);
+
+/**
+ * \brief Sender side. Reserves slot for a frame that is about to be handed to esp now
+ *
+ * \param peer_mac[in] destination of frame
+ * \param callback optional completion callback (NULL if not used)
+ * \param context passed to callback
+ * \param handle[out] handle identifying frame
+ *
+ * \return index of reserved slot, or -1 if ESPNOW_LINK_TX_MAX_IN_FLIGHT frames are already in flight
+ */
+int32_t espnow_link_tx_reserve(ESPNOW_LINK_TX_TRACKER_T* tracker,
+                               const uint8_t* peer_mac,
+                               ESPNOW_LINK_TX_DONE_CB_T callback,
+                               void* context,
+                               ESPNOW_LINK_TX_HANDLE_T* handle);
+
+/**
+ * \brief Sender side. Releases most recent reservation when esp now refused the frame
+ */
+void espnow_link_tx_cancel_last(ESPNOW_LINK_TX_TRACKER_T* tracker);
+
+/**
+ * \brief Send callback side. Records result for oldest frame in flight
+ *
+ * \param peer_mac[in] mac reported by send callback. Mismatches are counted but the result still applies
+ * \param success result reported by send callback
+ * \param completion[out] handle, callback and context of completed frame
+ *
+ * \return false if nothing was in flight
+ */
+bool espnow_link_tx_complete(ESPNOW_LINK_TX_TRACKER_T* tracker,
+                             const uint8_t* peer_mac,
+                             bool success,
+                             ESPNOW_LINK_TX_COMPLETION_T* completion);
+
+/**
+ * \brief returns state of frame. FREE means handle is unknown or its slot was already reused
+ */
+ESPNOW_LINK_TX_STATE_T espnow_link_tx_get_state(ESPNOW_LINK_TX_TRACKER_T* tracker, ESPNOW_LINK_TX_HANDLE_T handle);
+
+/**
+ * \brief returns slot index a handle maps to
+ */
+uint32_t espnow_link_tx_slot_index(ESPNOW_LINK_TX_HANDLE_T handle);
+
+/**
+ * \brief returns number of frames waiting on their send callback
+ */
+uint32_t espnow_link_tx_in_flight(ESPNOW_LINK_TX_TRACKER_T* tracker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ ********************************************************************************
+ * @file    gf256.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Table driven GF(2^8) arithmetic for erasure coding. Bulk operations use split
+ *          nibble tables (two 16 entry lookups per byte), which needs no carry-less multiply
+ *          and keeps the working set small enough to stay in cache on the ESP32-C6
+ ********************************************************************************
+ */
+
+#ifndef GF256_H
+#define GF256_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* products of one constant with every low nibble and every high nibble */
+typedef struct
+{
+    uint8_t lo[16U];
+    uint8_t hi[16U];
+} GF256_MUL_TABLE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief builds log and exp tables. Must be called before any other gf256 function, calling again is harmless
+ */
+void gf256_init(void);
+
+/**
+ * \brief returns a * b
+ */
+uint8_t gf256_mul(uint8_t a, uint8_t b);
+
+/**
+ * \brief returns multiplicative inverse of a, 0 for 0
+ */
+uint8_t gf256_inv(uint8_t a);
+
+/**
+ * \brief fills table for multiplying by c, for gf256_mul_add_region()
+ */
+void gf256_mul_table(uint8_t c, GF256_MUL_TABLE_T* table);
+
+/**
+ * \brief dst[i] ^= c * src[i], with c given by its table
+ */
+void gf256_mul_add_region(uint8_t* dst, const uint8_t* src, const GF256_MUL_TABLE_T* table, uint32_t length);
+
+/**
+ * \brief buffer[i] = c * buffer[i], with c given by its table
+ */
+void gf256_mul_region(uint8_t* buffer, const GF256_MUL_TABLE_T* table, uint32_t length);
+
+/**
+ * \brief dst[i] ^= src[i], i.e. gf256_mul_add_region() with c = 1
+ */
+void gf256_add_region(uint8_t* dst, const uint8_t* src, uint32_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
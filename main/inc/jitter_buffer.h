@@ -0,0 +1,181 @@
+/**
+ ********************************************************************************
+ * @file    jitter_buffer.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Adaptive playout buffer for received ADPCM blocks. Blocks are put in by stream
+ *          sequence number as they arrive and taken out once a frame period by playback. Depth
+ *          follows measured arrival jitter, and missing blocks are concealed from the ADPCM state
+ *          of the last one played. A silence marker in place of a block (see audio_vad.h) plays
+ *          comfort noise until the next block, which starts a new talk spurt
+ ********************************************************************************
+ */
+
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "adpcm.h"
+#include "audio_frame_pool.h"
+#include "audio_vad.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* blocks held at once, by seq modulo slots. Power of 2 */
+#define JITTER_BUFFER_SLOTS (16U)
+
+/* least and most frames buffered ahead of playout */
+#ifdef CONFIG_JITTER_BUFFER_MIN_FRAMES
+#define JITTER_BUFFER_MIN_FRAMES (CONFIG_JITTER_BUFFER_MIN_FRAMES)
+#else
+#define JITTER_BUFFER_MIN_FRAMES (1U)
+#endif
+
+#ifdef CONFIG_JITTER_BUFFER_MAX_FRAMES
+#define JITTER_BUFFER_MAX_FRAMES (CONFIG_JITTER_BUFFER_MAX_FRAMES)
+#else
+#define JITTER_BUFFER_MAX_FRAMES (8U)
+#endif
+
+/* period of one block. Each block is one playback frame */
+#define JITTER_BUFFER_FRAME_US ((uint32_t)(((uint64_t)ADPCM_BLOCK_SAMPLES * 1000000U) / AUDIO_SAMPLE_RATE_HZ))
+
+/* target depth covers this many times the jitter estimate */
+#define JITTER_BUFFER_JITTER_MULTIPLE (3U)
+
+/* concealed frames in a row before output has faded out. The stream ends there if nothing is buffered */
+#define JITTER_BUFFER_CONCEAL_FRAMES (4U)
+
+/* frames depth must stay over target before one frame is dropped to cut latency, about 1 s */
+#define JITTER_BUFFER_SHRINK_FRAMES (33U)
+
+/* frames of comfort noise after the last silence marker before the stream ends. Outlasts a
+   couple of lost markers */
+#define JITTER_BUFFER_COMFORT_FRAMES (3U * AUDIO_VAD_SID_INTERVAL_FRAMES)
+
+/* samples crossfaded from the concealed waveform into the next real block */
+#define JITTER_BUFFER_CROSSFADE_SAMPLES (64U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    JITTER_BUFFER_IDLE,         /* no stream or still buffering, pcm is silence */
+    JITTER_BUFFER_FRAME,        /* pcm is a received block */
+    JITTER_BUFFER_CONCEALED,    /* pcm stands in for a block that is missing */
+    JITTER_BUFFER_COMFORT       /* pcm is comfort noise, the sender is silent */
+} JITTER_BUFFER_RESULT_T;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t played;
+    uint32_t late;              /* arrived after their turn to play, dropped */
+    uint32_t duplicates;
+    uint32_t lost;              /* never arrived, later blocks had */
+    uint32_t underruns;         /* buffer ran dry, playout delay grew a frame */
+    uint32_t concealed;         /* frames made up, lost plus underruns */
+    uint32_t dropped;           /* played over to cut latency */
+    uint32_t resyncs;           /* stream jumped too far ahead and buffer restarted */
+    uint32_t comfort;           /* frames of comfort noise played through silence */
+} JITTER_BUFFER_STATS_T;
+
+typedef struct
+{
+    bool used;
+    uint32_t seq;
+    uint32_t arrival_us;
+    uint16_t length;
+    uint8_t block[ADPCM_BLOCK_BYTES];
+} JITTER_BUFFER_SLOT_T;
+
+typedef struct
+{
+    JITTER_BUFFER_SLOT_T slots[JITTER_BUFFER_SLOTS];
+    bool playing;
+    uint32_t next_seq;          /* next to play, or oldest buffered before playout starts */
+    uint32_t newest_seq;
+    uint8_t buffered;
+    uint8_t target_frames;
+
+    /* jitter estimate as in RFC 3550, kept x16 */
+    bool have_transit;
+    int32_t last_transit;
+    uint32_t jitter_us_x16;
+
+    /* concealment */
+    ADPCM_STATE_T state;        /* decoder state after last frame out */
+    uint8_t last_block[ADPCM_BLOCK_BYTES];
+    uint16_t last_length;
+    int32_t gain_q15;
+    uint8_t conceal_run;
+    bool discontinuity;         /* next real block is crossfaded in */
+    uint8_t excess_run;
+    int16_t scratch[ADPCM_BLOCK_SAMPLES];
+
+    /* comfort noise */
+    bool comfort;
+    uint16_t comfort_level;
+    uint16_t comfort_run;
+    uint32_t noise_seed;
+
+    JITTER_BUFFER_STATS_T stats;
+} JITTER_BUFFER_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/*
+ * Not thread safe. Put and get are expected from one task, or the caller holds a lock around them
+ */
+
+/**
+ * \brief empties buffer and clears stats
+ */
+void jitter_buffer_init(JITTER_BUFFER_T* jb);
+
+/**
+ * \brief buffers a received block
+ *
+ * \param seq stream sequence number, one per block (see WT20_FEC_FRAME_CB_T)
+ * \param block[in] block from adpcm_encode_block() or audio_vad_sid(), copied
+ * \param length length of block
+ * \param now_us arrival time
+ *
+ * \return false if block is malformed, late or a duplicate
+ */
+bool jitter_buffer_put(JITTER_BUFFER_T* jb, uint32_t seq, const uint8_t* block, uint16_t length, uint32_t now_us);
+
+/**
+ * \brief takes next frame for playback. Called once a frame period
+ *
+ * \param now_us current time
+ * \param pcm[out] ADPCM_BLOCK_SAMPLES samples, always written
+ *
+ * \return what pcm holds
+ */
+JITTER_BUFFER_RESULT_T jitter_buffer_get(JITTER_BUFFER_T* jb, uint32_t now_us, int16_t* pcm);
+
+/**
+ * \brief current jitter estimate
+ */
+uint32_t jitter_buffer_jitter_us(const JITTER_BUFFER_T* jb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+/**
+ ********************************************************************************
+ * @file    log_ring.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free queue of unformatted log records. Producers copy the format string pointer
+ *          and raw argument bytes, the consumer formats them later. Any number of producers,
+ *          including wifi callbacks, one consumer
+ ********************************************************************************
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* records waiting to be formatted. Must be a power of 2 */
+#ifdef CONFIG_LOG_RING_RECORDS
+#define LOG_RING_RECORDS (CONFIG_LOG_RING_RECORDS)
+#else
+#define LOG_RING_RECORDS (16U)
+#endif
+
+/* raw argument bytes per record. Strings are copied in, so they count at their length + 1 */
+#define LOG_RING_ARG_BYTES (48U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t level;
+    uint8_t arg_bytes;                  /* bytes of args in use */
+    bool truncated;                     /* arguments past arg_bytes didn't fit */
+    uint32_t timestamp_ms;
+    const char* tag;                    /* must be a literal or otherwise outlive the record */
+    const char* format;                 /* same */
+    uint8_t args[LOG_RING_ARG_BYTES];
+} LOG_RECORD_T;
+
+typedef struct
+{
+    atomic_uint_least32_t sequence;     /* position this slot is ready for, see log_ring.c */
+    LOG_RECORD_T record;
+} LOG_RING_SLOT_T;
+
+typedef struct
+{
+    LOG_RING_SLOT_T slots[LOG_RING_RECORDS];
+    atomic_uint_least32_t write_pos;
+    atomic_uint_least32_t read_pos;
+    atomic_uint_least32_t dropped;      /* records that found the ring full */
+} LOG_RING_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief empties ring and clears dropped count. Call before ring is shared
+ */
+void log_ring_init(LOG_RING_T* ring);
+
+/**
+ * \brief queues a record. Arguments are copied by the types format asks for, %s by value.
+ *        Never blocks and never formats
+ *
+ * \param level[in] stored as is, for the consumer
+ * \param tag[in] stored by pointer
+ * \param format[in] printf style, stored by pointer. * width and precision aren't supported,
+ *                   the record ends at the first one
+ * \param timestamp_ms[in] stored as is
+ * \param args[in] arguments for format
+ *
+ * \return false if ring is full, record is dropped and counted
+ */
+bool log_ring_push(LOG_RING_T* ring, uint8_t level, const char* tag, const char* format, uint32_t timestamp_ms,
+                   va_list args);
+
+/**
+ * \brief takes oldest record. Only one task may pop
+ *
+ * \return false if ring is empty
+ */
+bool log_ring_pop(LOG_RING_T* ring, LOG_RECORD_T* record);
+
+/**
+ * \brief records dropped since init
+ */
+uint32_t log_ring_dropped(LOG_RING_T* ring);
+
+/**
+ * \brief formats record's message into out, always nul terminated. A record whose arguments
+ *        didn't fit ends in "..."
+ *
+ * \return length of text in out
+ */
+uint32_t log_record_format(const LOG_RECORD_T* record, char* out, uint32_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -3,7 +3,9 @@
  * @file    logging.h
  * @author  Andrew Bevelhymer
  * @date    2024/09/14
- * @brief   Wrapper for ESP logging system, so it can be more easily mocked
+ * @brief   Wrapper for ESP logging system, so it can be more easily mocked. Messages under the
+ *          tag's level cost a table lookup, accepted ones are queued unformatted and printed by a
+ *          low priority task, so logging from time critical code doesn't stall it
  ********************************************************************************
  */
 
@@ -17,12 +19,36 @@ extern "C" {
 /************************************
  * INCLUDES
  ************************************/
+#include <stdint.h>
 #include "esp_log.h"
 
 /************************************
  * MACROS AND DEFINES
  ************************************/
 
+/* less important levels are compiled out */
+#ifdef CONFIG_LOGGING_MIN_LEVEL
+#define LOGGING_MIN_LEVEL (CONFIG_LOGGING_MIN_LEVEL)
+#else
+#define LOGGING_MIN_LEVEL (3) /* LOG_LEVEL_INFO */
+#endif
+
+/* tags that can be given their own level */
+#define LOGGING_MAX_TAGS (16U)
+
+/**
+ * \brief logs through logging_write() if level is compiled in. Arguments aren't evaluated
+ *        otherwise
+ */
+#define logging_log(level, tag, ...)                      \
+    do                                                    \
+    {                                                     \
+        if ((int)(level) <= LOGGING_MIN_LEVEL)            \
+        {                                                 \
+            logging_write((level), (tag), __VA_ARGS__);   \
+        }                                                 \
+    } while (0)
+
 /************************************
  * TYPEDEFS
  ************************************/
@@ -41,13 +67,26 @@ typedef enum
  ************************************/
 
 /**
- * \brief calls ESP_LOGI, ESP_LOGD, etc. based on level
- * 
+ * \brief sets up the record queue and starts the task that prints it. Call before anything
+ *        logs, messages logged earlier are dropped
+ */
+void logging_init(void);
+
+/**
+ * \brief queues message if level passes tag's level. Formatting happens later, in the logging
+ *        task, so %s arguments are copied now but tag and format must be literals. Use
+ *        logging_log() rather than calling this directly
+ *
  * \param level[in] log level
  * \param tag[in] tag to pass to esp logging system
- * \param message[in] message to pass to esp logging system
+ * \param format[in] printf style, no * width or precision
+ */
+void logging_write(logging_level_t level, const char* tag, const char* format, ...);
+
+/**
+ * \brief messages dropped because the queue was full
  */
-void logging_log(logging_level_t level, const char* tag, const char* format, ...);
+uint32_t logging_dropped(void);
 
 /**
  * \brief sets logging level for a particular tag
@@ -55,8 +94,8 @@ void logging_log(logging_level_t level, const char* tag, const char* format, ...
  * \param level[in] log level
  * \param tag[in] tag the minimum log level should apply to
  * 
- * \warning some messages still won't go through if global level is higher than level.
- *          run idf.py menuconfig to set global level
+ * \warning messages under LOGGING_MIN_LEVEL or the esp global level still won't go through.
+ *          run idf.py menuconfig to set them. Tags past LOGGING_MAX_TAGS keep the default level
  */
 void logging_set_level_for_tag(logging_level_t level, const char* tag);
 
@@ -0,0 +1,123 @@
+/**
+ ********************************************************************************
+ * @file    mem_pool.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free pools of fixed size blocks on static storage. Alloc and free are O(1) and
+ *          safe from task, wifi callback and isr context. Every pool is registered when it is
+ *          initialized, so in use, high water and failure counts can be reported for all of them
+ ********************************************************************************
+ */
+
+#ifndef MEM_POOL_H
+#define MEM_POOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* free blocks are tracked in one word */
+#define MEM_POOL_MAX_BLOCKS (32U)
+
+/* every block starts on a 4 byte boundary */
+#define MEM_POOL_ALIGN (4U)
+
+#define MEM_POOL_BLOCK_STRIDE(block_bytes) \
+    (((uint32_t)(block_bytes) + (MEM_POOL_ALIGN - 1U)) & ~(MEM_POOL_ALIGN - 1U))
+
+/* declares storage for a pool. uint32_t keeps blocks aligned */
+#define MEM_POOL_STORAGE(name, block_bytes, blocks) \
+    static uint32_t name[(MEM_POOL_BLOCK_STRIDE(block_bytes) * (uint32_t)(blocks)) / sizeof(uint32_t)]
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct MEM_POOL_S
+{
+    const char* name;
+    uint8_t* storage;
+    uint32_t stride;                      /* block size rounded up to MEM_POOL_ALIGN */
+    uint32_t block_bytes;
+    uint32_t blocks;
+    atomic_uint_least32_t free_mask;      /* bit per block, set while block is free */
+    atomic_uint_least32_t alloc_failures;
+    atomic_uint_least32_t high_water;     /* most blocks ever in use at once */
+    struct MEM_POOL_S* next;              /* next registered pool */
+} MEM_POOL_T;
+
+typedef struct
+{
+    const char* name;
+    uint32_t block_bytes;
+    uint32_t blocks;
+    uint32_t in_use;
+    uint32_t high_water;
+    uint32_t alloc_failures;
+} MEM_POOL_STATS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief sets up pool on caller provided storage, marks every block free and registers pool for
+ *        reporting. Initializing a pool again clears it. Call before the pool is shared
+ *
+ * \param name[in] shown in reports, must outlive pool
+ * \param storage[in] at least MEM_POOL_BLOCK_STRIDE(block_bytes) * blocks bytes, 4 byte aligned.
+ *                    MEM_POOL_STORAGE() declares it
+ * \param block_bytes size of a block
+ * \param blocks number of blocks, 1 to MEM_POOL_MAX_BLOCKS
+ *
+ * \return false if storage or sizes are invalid
+ */
+bool mem_pool_init(MEM_POOL_T* pool, const char* name, void* storage, uint32_t block_bytes, uint32_t blocks);
+
+/**
+ * \brief takes a free block. O(1), never blocks
+ *
+ * \return block, NULL if every block is in use (counted as an alloc failure)
+ */
+void* mem_pool_alloc(MEM_POOL_T* pool);
+
+/**
+ * \brief returns a block to pool. NULL and blocks not from this pool are ignored
+ */
+void mem_pool_free(MEM_POOL_T* pool, void* block);
+
+/**
+ * \brief returns number of free blocks
+ */
+uint32_t mem_pool_available(MEM_POOL_T* pool);
+
+/**
+ * \brief copies usage counters into stats
+ */
+void mem_pool_get_stats(MEM_POOL_T* pool, MEM_POOL_STATS_T* stats);
+
+/**
+ * \brief first registered pool, NULL if none. Walk the rest with mem_pool_next()
+ */
+MEM_POOL_T* mem_pool_first(void);
+
+/**
+ * \brief pool registered after pool, NULL at the end
+ */
+MEM_POOL_T* mem_pool_next(const MEM_POOL_T* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
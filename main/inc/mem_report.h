@@ -0,0 +1,54 @@
+/**
+ ********************************************************************************
+ * @file    mem_report.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Logs memory use, so pool and stack sizes can be cut to what is actually needed.
+ *          Covers every mem_pool, the stack watermark of registered tasks and the heap
+ ********************************************************************************
+ */
+
+#ifndef MEM_REPORT_H
+#define MEM_REPORT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* tasks whose stacks are reported */
+#define MEM_REPORT_MAX_TASKS (8U)
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief adds task to report. Adding a task twice has no effect
+ *
+ * \return false if MEM_REPORT_MAX_TASKS tasks are already added
+ */
+bool mem_report_add_task(TaskHandle_t task);
+
+/**
+ * \brief logs every pool's use, high water mark and alloc failures, the least free stack each
+ *        added task has had, and free heap
+ */
+void mem_report_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/**
+ ********************************************************************************
+ * @file    metrics.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Runtime counters, gauges and timers for the espnow_link and wt20 layers, plus
+ *          per peer rssi. Updates are single relaxed atomics, cheap enough for the send and
+ *          receive callbacks. Read and reset from the console
+ ********************************************************************************
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* peers whose rssi is tracked. Frames from peers past this are still counted, just not per peer */
+#ifdef CONFIG_METRICS_MAX_PEERS
+#define METRICS_MAX_PEERS (CONFIG_METRICS_MAX_PEERS)
+#else
+#define METRICS_MAX_PEERS (8U)
+#endif
+
+#define METRICS_MAC_BYTES (6U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* counters only go up, gauges keep the highest value seen. Both go back to 0 on reset */
+typedef enum
+{
+    METRIC_LINK_TX_ATTEMPTS,      /* frames handed to esp_now_send() */
+    METRIC_LINK_TX_REFUSED,       /* esp_now_send() returned an error, no send callback follows */
+    METRIC_LINK_TX_BUSY,          /* write_async() found every in flight slot taken */
+    METRIC_LINK_TX_ACKED,
+    METRIC_LINK_TX_FAILED,        /* send callback reported failure */
+    METRIC_LINK_RX_FRAMES,
+    METRIC_LINK_RX_OVERFLOWS,     /* frames the receive ring had no room for */
+    METRIC_LINK_RX_QUEUE_HWM,     /* gauge, most bytes of receive ring in use */
+    METRIC_LINK_TX_QUEUE_HWM,     /* gauge, most frames waiting on their send callback */
+    METRIC_WT20_RX_FRAMES,
+    METRIC_WT20_RX_DROPPED,       /* bad crc, malformed or duplicate */
+    METRIC_WT20_NO_BUFFER,        /* frame pool empty on a send or receive */
+    METRIC_WT20_MESSAGES,         /* fragmented messages reassembled */
+    METRIC_COUNT
+} METRIC_ID_T;
+
+typedef enum
+{
+    METRIC_TIMER_LINK_SEND,       /* esp_now_send() to its send callback */
+    METRIC_TIMER_COUNT
+} METRIC_TIMER_ID_T;
+
+typedef struct
+{
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t mean_us;
+    uint32_t max_us;
+} METRICS_TIMER_T;
+
+typedef struct
+{
+    uint8_t mac[METRICS_MAC_BYTES];
+    int8_t last_rssi;
+    int8_t min_rssi;
+    int8_t max_rssi;
+    int8_t mean_rssi;
+    uint32_t frames;
+} METRICS_PEER_T;
+
+/* copy of everything, taken by metrics_snapshot() */
+typedef struct
+{
+    uint32_t values[METRIC_COUNT];
+    METRICS_TIMER_T timers[METRIC_TIMER_COUNT];
+    METRICS_PEER_T peers[METRICS_MAX_PEERS];
+    uint32_t peer_count;
+} METRICS_SNAPSHOT_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief adds 1 to a counter. Safe from any task or callback
+ */
+void metrics_inc(METRIC_ID_T id);
+
+/**
+ * \brief raises a gauge to value if value is higher. Safe from any task or callback
+ */
+void metrics_gauge_max(METRIC_ID_T id, uint32_t value);
+
+/**
+ * \brief records one sample of a timer. Each timer must only be recorded from one task, the
+ *        send callback for METRIC_TIMER_LINK_SEND
+ */
+void metrics_timer_add(METRIC_TIMER_ID_T id, uint32_t elapsed_us);
+
+/**
+ * \brief records rssi of a frame from mac. Only call from one task, the receive callback.
+ *        The first METRICS_MAX_PEERS macs seen get a slot
+ */
+void metrics_peer_rssi(const uint8_t* mac, int8_t rssi);
+
+/**
+ * \brief zeroes every counter, gauge and timer, and forgets every peer
+ */
+void metrics_reset(void);
+
+/**
+ * \brief copies everything into snapshot. Values updated during the copy may be from
+ *        either side of the update
+ */
+void metrics_snapshot(METRICS_SNAPSHOT_T* snapshot);
+
+/**
+ * \brief short snake case name of a counter or gauge, e.g. "link_tx_failed"
+ */
+const char* metrics_name(METRIC_ID_T id);
+
+/**
+ * \brief short snake case name of a timer
+ */
+const char* metrics_timer_name(METRIC_TIMER_ID_T id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
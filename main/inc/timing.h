@@ -0,0 +1,46 @@
+/**
+ ********************************************************************************
+ * @file    timing.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Wrapper for ESP timer, so time can be more easily mocked
+ ********************************************************************************
+ */
+
+#ifndef TIMING_H
+#define TIMING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief returns milliseconds since boot. Wraps after ~49 days, compare with subtraction
+ */
+uint32_t timing_get_ms(void);
+
+/**
+ * \brief returns microseconds since boot. Wraps after ~71 minutes, compare with subtraction
+ */
+uint32_t timing_get_us(void);
+
+/**
+ * \brief returns CPU cycle count. Wraps within a minute, compare with subtraction. Only for
+ *        measuring short stretches of code on one core
+ */
+uint32_t timing_get_cycles(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
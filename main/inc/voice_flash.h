@@ -0,0 +1,68 @@
+/**
+ ********************************************************************************
+ * @file    voice_flash.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Flash the voice store lives in. On target this is the "voice" data partition
+ *          (voice_flash_esp.c), off target a file (unit_tests/test/host/voice_flash_file.c).
+ *          Either way it reads like NOR flash: a write can only clear bits, an erase sets a
+ *          whole sector back to 0xFF, and reads go through a read only memory map
+ ********************************************************************************
+ */
+
+#ifndef VOICE_FLASH_H
+#define VOICE_FLASH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define VOICE_FLASH_SECTOR_BYTES (4096U)
+
+/* partition table entry on target */
+#define VOICE_FLASH_PARTITION_LABEL "voice"
+#define VOICE_FLASH_PARTITION_SUBTYPE (0x40U)
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief maps the whole area for reading. Writes and erases show through the map
+ *
+ * \param map[out] first byte of the area
+ * \param bytes[out] size of the area, a multiple of VOICE_FLASH_SECTOR_BYTES
+ *
+ * \return false if there is no area or it can't be mapped
+ */
+bool voice_flash_open(const uint8_t** map, uint32_t* bytes);
+
+/**
+ * \brief sets the sector starting at offset to 0xFF
+ */
+bool voice_flash_erase_sector(uint32_t offset);
+
+/**
+ * \brief programs length bytes at offset. Bits already cleared stay cleared
+ */
+bool voice_flash_write(uint32_t offset, const void* data, uint32_t length);
+
+/**
+ * \brief unmaps the area
+ */
+void voice_flash_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ ********************************************************************************
+ * @file    voice_store.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Voice messages kept in flash until they are played. The flash is a circular log
+ *          of sectors, so every sector is erased once per lap and the oldest messages make
+ *          room for new ones. Messages are written as they arrive, a sector sized chunk at a
+ *          time, and read back through the flash map without copying. Mounting rebuilds the
+ *          index from headers alone, and a message cut short by power loss keeps what was
+ *          written before it
+ ********************************************************************************
+ */
+
+#ifndef VOICE_STORE_H
+#define VOICE_STORE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "voice_flash.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* messages indexed at once. The oldest is forgotten, and later overwritten, past this */
+#ifdef CONFIG_VOICE_STORE_MAX_MESSAGES
+#define VOICE_STORE_MAX_MESSAGES (CONFIG_VOICE_STORE_MAX_MESSAGES)
+#else
+#define VOICE_STORE_MAX_MESSAGES (32U)
+#endif
+
+/* magic, sequence number (4), erase count (4), crc (2), unused (2) */
+#define VOICE_STORE_SECTOR_HDR_BYTES (16U)
+
+/* magic (2), message id (2), chunk index (2), length (2), flags, deleted, crc (2) */
+#define VOICE_STORE_RECORD_HDR_BYTES (12U)
+
+/* largest chunk, one that fills a sector */
+#define VOICE_STORE_CHUNK_BYTES (VOICE_FLASH_SECTOR_BYTES - VOICE_STORE_SECTOR_HDR_BYTES - VOICE_STORE_RECORD_HDR_BYTES)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    VOICE_STORE_OK,
+    VOICE_STORE_ERR_FLASH,        /* no flash, or it failed a write or erase */
+    VOICE_STORE_ERR_NOT_MOUNTED,
+    VOICE_STORE_ERR_BUSY,         /* a message is already being written */
+    VOICE_STORE_ERR_NOT_OPEN,     /* no message is being written */
+    VOICE_STORE_ERR_FULL,         /* the message being written would overwrite its own start */
+    VOICE_STORE_ERR_NOT_FOUND
+} VOICE_STORE_ERR_T;
+
+typedef struct
+{
+    uint16_t id;
+    uint32_t bytes;
+    bool complete;            /* false if writing it was cut short */
+} VOICE_STORE_MSG_T;
+
+typedef struct
+{
+    uint16_t id;
+    uint32_t sector;
+    uint32_t offset;
+    uint32_t seq;             /* of sector, to see that the next one follows it in the log */
+    uint16_t chunk;
+    bool done;
+} VOICE_STORE_READER_T;
+
+typedef struct
+{
+    uint32_t sectors;
+    uint32_t messages;
+    uint32_t bytes_written;
+    uint32_t chunks_written;
+    uint32_t sectors_erased;      /* this mount */
+    uint32_t messages_dropped;    /* overwritten, or forgotten with the index full */
+    uint32_t min_erase_count;     /* over every sector, how evenly wear is spread */
+    uint32_t max_erase_count;
+    bool recovered;               /* the last mount found a write cut short */
+} VOICE_STORE_STATS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief maps the flash and rebuilds the index. Blank or unreadable sectors are taken to be
+ *        free. A message being written is left as far as it got, as after power loss. Every
+ *        voice_store call must come from one task
+ */
+VOICE_STORE_ERR_T voice_store_mount(void);
+
+/**
+ * \brief finishes any message being written and unmaps the flash
+ */
+void voice_store_unmount(void);
+
+/**
+ * \brief starts a message. Its data goes to flash in chunks as they fill
+ *
+ * \param id[out] new message's id
+ */
+VOICE_STORE_ERR_T voice_store_begin(uint16_t* id);
+
+/**
+ * \brief adds data to the message being written
+ *
+ * \return VOICE_STORE_ERR_FULL once the message fills the flash, what fit is kept
+ */
+VOICE_STORE_ERR_T voice_store_append(const uint8_t* data, uint32_t length);
+
+/**
+ * \brief writes out the last chunk and marks the message complete
+ */
+VOICE_STORE_ERR_T voice_store_finish(void);
+
+/**
+ * \brief marks a message deleted in flash and drops it from the index. Its space is reused
+ *        when the log comes around to it
+ *
+ * \return VOICE_STORE_ERR_BUSY for the message being written
+ */
+VOICE_STORE_ERR_T voice_store_delete(uint16_t id);
+
+/**
+ * \brief returns number of messages, oldest first
+ */
+uint32_t voice_store_count(void);
+
+/**
+ * \brief copies out the index'th message, 0 is the oldest
+ */
+VOICE_STORE_ERR_T voice_store_get(uint32_t index, VOICE_STORE_MSG_T* msg);
+
+/**
+ * \brief starts reading message id from its beginning
+ */
+VOICE_STORE_ERR_T voice_store_open(uint16_t id, VOICE_STORE_READER_T* reader);
+
+/**
+ * \brief returns the next chunk of the message, in place in the flash map. It stays valid
+ *        until the log comes around to it, so play it before writing much more
+ *
+ * \param data[out] first byte of the chunk
+ *
+ * \return chunk length, 0 at the end of the message
+ */
+uint32_t voice_store_read(VOICE_STORE_READER_T* reader, const uint8_t** data);
+
+/**
+ * \brief copies counters into stats
+ */
+void voice_store_get_stats(VOICE_STORE_STATS_T* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,57 @@
+/**
+ ********************************************************************************
+ * @file    wm8960.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Minimal WM8960 codec driver. Sets codec up over I2C as an I2S slave with
+ *          mic to ADC and DAC to headphone paths
+ ********************************************************************************
+ */
+
+#ifndef WM8960_H
+#define WM8960_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define WM8960_I2C_ADDRESS (0x1AU)
+
+/* headphone volume range, 0x30 is mute and each step is 1 dB */
+#define WM8960_VOLUME_MUTE (0x30U)
+#define WM8960_VOLUME_0DB (0x79U)
+#define WM8960_VOLUME_MAX (0x7FU)
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief resets codec and configures it for 16 bit I2S, MCLK = 256 * sample rate
+ *
+ * \param sda_pin i2c data gpio
+ * \param scl_pin i2c clock gpio
+ *
+ * \return false if codec doesn't acknowledge
+ */
+bool wm8960_init(int32_t sda_pin, int32_t scl_pin);
+
+/**
+ * \brief sets headphone volume, WM8960_VOLUME_MUTE to WM8960_VOLUME_MAX
+ */
+bool wm8960_set_volume(uint8_t volume);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,168 @@
+/**
+ ********************************************************************************
+ * @file    wt20_bulk.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Selective repeat reliable transfer of fragmented messages. The receiver answers
+ *          polls with a bitmap of received fragments and the sender retransmits only the
+ *          missing ones, while keeping a window of new fragments in flight.
+ ********************************************************************************
+ */
+
+#ifndef WT20_BULK_H
+#define WT20_BULK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "wt20_frag.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* max fragments sent but not yet acked or declared lost */
+#ifdef CONFIG_WT20_BULK_WINDOW
+#define WT20_BULK_WINDOW (CONFIG_WT20_BULK_WINDOW)
+#else
+#define WT20_BULK_WINDOW (32U)
+#endif
+
+/* upper bound on how long to wait for an ack to a poll before polling again.
+   The actual wait follows the measured round trip */
+#ifdef CONFIG_WT20_BULK_ACK_TIMEOUT_MS
+#define WT20_BULK_ACK_TIMEOUT_MS (CONFIG_WT20_BULK_ACK_TIMEOUT_MS)
+#else
+#define WT20_BULK_ACK_TIMEOUT_MS (20U)
+#endif
+
+/* transfer fails if no new fragment is acked for this long */
+#ifdef CONFIG_WT20_BULK_GIVE_UP_MS
+#define WT20_BULK_GIVE_UP_MS (CONFIG_WT20_BULK_GIVE_UP_MS)
+#else
+#define WT20_BULK_GIVE_UP_MS (2000U)
+#endif
+
+/* command byte, fragment header and data */
+#define WT20_BULK_DATA_FRAME_BYTES (1U + WT20_FRAG_FRAME_BYTES)
+
+/* command, msg_id, poll index (2), fragment count (2), bitmap */
+#define WT20_BULK_ACK_HDR_BYTES (6U)
+#define WT20_BULK_ACK_MAX_BYTES (WT20_BULK_ACK_HDR_BYTES + WT20_FRAG_BITMAP_BYTES)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    WT20_BULK_IDLE,
+    WT20_BULK_IN_PROGRESS,
+    WT20_BULK_COMPLETE,
+    WT20_BULK_FAILED
+} WT20_BULK_STATE_T;
+
+typedef struct
+{
+    uint32_t frames_sent;
+    uint32_t retransmits;
+    uint32_t polls;
+    uint32_t acks;
+    uint32_t ack_timeouts;
+} WT20_BULK_STATS_T;
+
+typedef struct
+{
+    WT20_BULK_STATE_T state;
+    const uint8_t* message;
+    uint32_t length;
+    uint16_t count;
+    uint8_t msg_id;
+    uint8_t data_command; /* command byte for ordinary fragments */
+    uint8_t poll_command; /* command byte for fragments that ask for an ack */
+
+    uint8_t acked[WT20_FRAG_BITMAP_BYTES];
+    uint8_t outstanding[WT20_FRAG_BITMAP_BYTES]; /* sent, result not known yet */
+    uint8_t sent_once[WT20_FRAG_BITMAP_BYTES];
+    uint16_t last_send_seq[WT20_FRAG_MAX_FRAGMENTS];
+    uint16_t send_seq;
+    uint16_t acked_count;
+    uint16_t outstanding_count;
+    uint16_t sends_since_poll;
+    uint16_t first_unacked; /* every fragment below this index is acked */
+    bool awaiting_ack;
+    uint16_t last_poll_seq;
+    uint32_t last_poll_ms;
+    uint32_t last_progress_ms;
+    uint32_t srtt_ms; /* smoothed poll to ack round trip, 0 until measured */
+
+    WT20_BULK_STATS_T stats;
+} WT20_BULK_TX_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief starts a transfer. message must stay valid until transfer completes or fails
+ *
+ * \param data_command command byte placed in front of ordinary fragments
+ * \param poll_command command byte placed in front of fragments that ask the receiver for an ack
+ */
+void wt20_bulk_tx_start(WT20_BULK_TX_T* tx,
+                        uint8_t msg_id,
+                        const uint8_t* message,
+                        uint32_t length,
+                        uint8_t data_command,
+                        uint8_t poll_command,
+                        uint32_t now_ms);
+
+/**
+ * \brief builds next frame to send, if the window allows one
+ *
+ * \param frame[out] buffer of at least WT20_BULK_DATA_FRAME_BYTES, starting with command byte
+ * \param frame_length[out] bytes written to frame
+ *
+ * \return false if nothing should be sent right now
+ */
+bool wt20_bulk_tx_next(WT20_BULK_TX_T* tx, uint32_t now_ms, uint8_t* frame, uint16_t* frame_length);
+
+/**
+ * \brief applies an ack frame from the receiver. Acks for other messages are ignored
+ *
+ * \param ack[in] ack frame, starting with command byte
+ */
+void wt20_bulk_tx_on_ack(WT20_BULK_TX_T* tx, const uint8_t* ack, uint16_t ack_length, uint32_t now_ms);
+
+/**
+ * \brief returns state of transfer
+ */
+WT20_BULK_STATE_T wt20_bulk_tx_state(const WT20_BULK_TX_T* tx);
+
+/**
+ * \brief Receiver side. Builds an ack for a message from the reassembler's progress
+ *
+ * \param ack_command command byte placed in front of ack
+ * \param poll_index fragment index of the poll being answered
+ * \param ack[out] buffer of at least WT20_BULK_ACK_MAX_BYTES
+ *
+ * \return length of ack, 0 if message is unknown
+ */
+uint16_t wt20_bulk_build_ack(WT20_FRAG_REASSEMBLER_T* reassembler,
+                             const uint8_t* src_mac,
+                             uint8_t msg_id,
+                             uint16_t poll_index,
+                             uint8_t ack_command,
+                             uint8_t* ack);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ ********************************************************************************
+ * @file    wt20_chan.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Group wide channel switch. The unit moving the group broadcasts the new channel
+ *          and the time left until the switch every WT20_CHAN_ANNOUNCE_INTERVAL_MS, and every
+ *          unit that hears it answers with an ack and switches at the same moment. The leader
+ *          stops announcing once each added peer acked, and switches on time either way. Two
+ *          switches started at once are settled by mac, the lower one is followed
+ ********************************************************************************
+ */
+
+#ifndef WT20_CHAN_H
+#define WT20_CHAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "wt20_peer.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* from the first announcement to the switch. Long enough for several announcements, so a
+   unit that misses a few still hears one */
+#ifdef CONFIG_WT20_CHANNEL_SWITCH_DELAY_MS
+#define WT20_CHAN_SWITCH_DELAY_MS (CONFIG_WT20_CHANNEL_SWITCH_DELAY_MS)
+#else
+#define WT20_CHAN_SWITCH_DELAY_MS (250U)
+#endif
+
+#define WT20_CHAN_ANNOUNCE_INTERVAL_MS (25U)
+
+/* switch id (2), channel, ms left until the switch (2) */
+#define WT20_CHAN_SWITCH_BYTES (5U)
+
+/* switch id (2), channel */
+#define WT20_CHAN_ACK_BYTES (3U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    WT20_CHAN_IDLE,
+    WT20_CHAN_LEADING,        /* this unit started the switch */
+    WT20_CHAN_FOLLOWING
+} WT20_CHAN_STATE_T;
+
+typedef struct
+{
+    uint32_t switches;
+    uint32_t announcements_sent;
+    uint32_t acks_sent;
+    uint32_t acks_received;
+    uint32_t unacked;         /* added peers that hadn't acked when a switch this unit led went ahead */
+    uint32_t conflicts;       /* switches given up, or announcements ignored, for a lower mac's */
+} WT20_CHAN_STATS_T;
+
+/* owned by the receiving task */
+typedef struct
+{
+    WT20_CHAN_STATE_T state;
+    uint8_t own_mac[WT20_PEER_MAC_BYTES];
+    uint8_t leader[WT20_PEER_MAC_BYTES];
+    uint16_t id;
+    uint8_t channel;
+    uint32_t switch_ms;
+    uint32_t next_announce_ms;
+    uint32_t expected;        /* peer ids the leader waits on, bit id - 1 */
+    uint32_t acked;
+    WT20_CHAN_STATS_T stats;
+} WT20_CHAN_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets any switch under way
+ *
+ * \param own_mac[in] settles conflicts with other leaders
+ */
+void wt20_chan_init(WT20_CHAN_T* chan, const uint8_t* own_mac);
+
+/**
+ * \brief leads a switch to channel, WT20_CHAN_SWITCH_DELAY_MS from now
+ *
+ * \param id tells this switch's acks from an earlier one's
+ * \param expected peer ids that should ack, bit id - 1. With none, announcements run until the switch
+ *
+ * \return false if a switch led by a lower mac is under way, which this unit follows instead
+ */
+bool wt20_chan_start(WT20_CHAN_T* chan, uint8_t channel, uint16_t id, uint32_t expected, uint32_t now_ms);
+
+/**
+ * \brief builds the next announcement, if one is due
+ *
+ * \param payload[out] WT20_CHAN_SWITCH_BYTES
+ *
+ * \return payload length, 0 if none is due
+ */
+uint16_t wt20_chan_next_announce(WT20_CHAN_T* chan, uint32_t now_ms, uint8_t* payload);
+
+/**
+ * \brief takes in an announcement from src_mac
+ *
+ * \return true if this unit follows it, and should answer with wt20_chan_build_ack()
+ */
+bool wt20_chan_on_announce(WT20_CHAN_T* chan, const uint8_t* src_mac, const uint8_t* payload, uint16_t length, uint32_t now_ms);
+
+/**
+ * \param payload[out] WT20_CHAN_ACK_BYTES, acks the switch being followed
+ *
+ * \return payload length
+ */
+uint16_t wt20_chan_build_ack(WT20_CHAN_T* chan, uint8_t* payload);
+
+/**
+ * \brief takes in an ack from peer_id
+ *
+ * \return false if it isn't for the switch this unit leads
+ */
+bool wt20_chan_on_ack(WT20_CHAN_T* chan, WT20_PEER_ID_T peer_id, const uint8_t* payload, uint16_t length);
+
+/**
+ * \brief ends the switch once its time comes
+ *
+ * \param channel[out] channel to move the radio to
+ *
+ * \return true if the radio should move now
+ */
+bool wt20_chan_due(WT20_CHAN_T* chan, uint32_t now_ms, uint8_t* channel);
+
+/**
+ * \brief whether a switch is under way
+ *
+ * \param due_ms[out] when wt20_chan_next_announce() or wt20_chan_due() next has something (pass NULL if not used)
+ */
+bool wt20_chan_pending(const WT20_CHAN_T* chan, uint32_t* due_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,186 @@
+/**
+ ********************************************************************************
+ * @file    wt20_fec.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Forward error correction for live frames. Every group of k data frames is followed
+ *          by m parity frames, and any k of the k + m frames rebuild the group. m = 1 is plain
+ *          xor parity, larger m is a systematic Reed-Solomon (Cauchy) erasure code
+ ********************************************************************************
+ */
+
+#ifndef WT20_FEC_H
+#define WT20_FEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "gf256.h"
+#include "wt20_header.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* group id (1), index in group (1), data frames in group (1), parity frames in group (1) */
+#define WT20_FEC_HDR_BYTES (4U)
+
+/* largest frame that can be protected, sized so a coded frame fits the wt20 payload */
+#define WT20_FEC_MAX_FRAME_BYTES (WT20_PAYLOAD_BYTES - WT20_FEC_HDR_BYTES)
+
+/* largest k */
+#ifdef CONFIG_WT20_FEC_MAX_DATA_FRAMES
+#define WT20_FEC_MAX_DATA_FRAMES (CONFIG_WT20_FEC_MAX_DATA_FRAMES)
+#else
+#define WT20_FEC_MAX_DATA_FRAMES (8U)
+#endif
+
+/* largest m */
+#ifdef CONFIG_WT20_FEC_MAX_PARITY_FRAMES
+#define WT20_FEC_MAX_PARITY_FRAMES (CONFIG_WT20_FEC_MAX_PARITY_FRAMES)
+#else
+#define WT20_FEC_MAX_PARITY_FRAMES (4U)
+#endif
+
+/* groups the decoder keeps open at once, so frames of neighbouring groups may interleave */
+#define WT20_FEC_DECODER_GROUPS (2U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t k;              /* data frames per group */
+    uint8_t m;              /* parity frames per group */
+    uint16_t frame_bytes;   /* every frame is padded to this length */
+} WT20_FEC_CONFIG_T;
+
+/* generator rows for parity, as multiply tables so coding needs no per byte log lookups */
+typedef struct
+{
+    WT20_FEC_CONFIG_T config;
+    uint8_t coefficients[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_DATA_FRAMES];
+    GF256_MUL_TABLE_T tables[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_DATA_FRAMES];
+} WT20_FEC_CODE_T;
+
+typedef struct
+{
+    WT20_FEC_CODE_T code;
+    uint8_t group;
+    uint8_t next_index;     /* data frames added to current group */
+    uint8_t next_parity;    /* parity frames already taken from current group */
+    uint8_t parity[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_FRAME_BYTES];
+} WT20_FEC_ENCODER_T;
+
+/* called for every data frame, as it arrives or once it is rebuilt. seq counts data frames */
+typedef void (*WT20_FEC_FRAME_CB_T)(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context);
+
+typedef struct
+{
+    bool in_use;
+    uint32_t number;           /* group count since decoder started, group id is its low byte */
+    uint32_t received_data;    /* bit per data frame, received or rebuilt */
+    uint32_t received_parity;  /* bit per parity frame */
+    uint8_t data[WT20_FEC_MAX_DATA_FRAMES][WT20_FEC_MAX_FRAME_BYTES];
+    uint8_t parity[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_FRAME_BYTES];
+} WT20_FEC_GROUP_T;
+
+typedef struct
+{
+    uint32_t received;
+    uint32_t recovered;
+    uint32_t unrecoverable;    /* data frames lost for good */
+    uint32_t invalid;
+} WT20_FEC_STATS_T;
+
+typedef struct
+{
+    WT20_FEC_CODE_T code;
+    WT20_FEC_GROUP_T groups[WT20_FEC_DECODER_GROUPS];
+    uint32_t newest_group;     /* number of newest group seen */
+    bool started;
+    WT20_FEC_FRAME_CB_T callback;
+    void* context;
+    WT20_FEC_STATS_T stats;
+} WT20_FEC_DECODER_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief sets up encoder and starts first group
+ *
+ * \return false if config is out of range
+ */
+bool wt20_fec_encoder_init(WT20_FEC_ENCODER_T* encoder, const WT20_FEC_CONFIG_T* config);
+
+/**
+ * \brief changes frame_bytes from the next group on, without restarting the group count.
+ *        Only allowed between groups, so every frame of a group has the same length
+ *
+ * \return false if frame_bytes is out of range or a group is under way
+ */
+bool wt20_fec_encoder_resize(WT20_FEC_ENCODER_T* encoder, uint16_t frame_bytes);
+
+/**
+ * \brief adds a data frame to current group and writes it out as a coded frame
+ *
+ * \param frame[in] data, shorter frames are padded with zeros
+ * \param length length of frame, at most config frame_bytes
+ * \param out[out] coded frame, at least WT20_FEC_HDR_BYTES + frame_bytes
+ *
+ * \return length of out, 0 if frame is too long or parity of a full group hasn't been taken yet
+ */
+uint16_t wt20_fec_encode(WT20_FEC_ENCODER_T* encoder, const uint8_t* frame, uint16_t length, uint8_t* out);
+
+/**
+ * \brief once k data frames are in, returns the group's parity frames one at a time.
+ *        The next group starts after the last one is taken
+ *
+ * \param out[out] coded frame, at least WT20_FEC_HDR_BYTES + frame_bytes
+ *
+ * \return length of out, 0 if no parity frame is ready
+ */
+uint16_t wt20_fec_next_parity(WT20_FEC_ENCODER_T* encoder, uint8_t* out);
+
+/**
+ * \brief sets up decoder
+ *
+ * \param callback called with every data frame, in arrival order
+ *
+ * \return false if config is out of range
+ */
+bool wt20_fec_decoder_init(WT20_FEC_DECODER_T* decoder,
+                           const WT20_FEC_CONFIG_T* config,
+                           WT20_FEC_FRAME_CB_T callback,
+                           void* context);
+
+/**
+ * \brief follows a sender that changed frame_bytes between groups. Open groups are closed,
+ *        their missing frames counted as unrecoverable, but seq carries on where it was
+ *
+ * \return false if frame_bytes is out of range
+ */
+bool wt20_fec_decoder_resize(WT20_FEC_DECODER_T* decoder, uint16_t frame_bytes);
+
+/**
+ * \brief takes a coded frame. Data frames are passed on straight away, lost ones are passed on
+ *        as soon as enough frames of their group have arrived
+ *
+ * \return false if frame is malformed or doesn't match decoder config
+ */
+bool wt20_fec_decode(WT20_FEC_DECODER_T* decoder, const uint8_t* coded, uint16_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
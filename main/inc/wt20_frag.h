@@ -0,0 +1,217 @@
+/**
+ ********************************************************************************
+ * @file    wt20_frag.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Splits messages larger than one frame into numbered fragments and reassembles
+ *          them into a preallocated pool of buffers. No heap is used.
+ ********************************************************************************
+ */
+
+#ifndef WT20_FRAG_H
+#define WT20_FRAG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "wt20_header.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* bytes available to a fragment, i.e. the wt20 payload */
+#define WT20_FRAG_FRAME_BYTES (WT20_PAYLOAD_BYTES)
+
+/* msg_id (1), fragment index (2), fragment count (2) */
+#define WT20_FRAG_HDR_BYTES (5U)
+
+/* message bytes carried by every fragment except possibly the last */
+#define WT20_FRAG_DATA_BYTES (WT20_FRAG_FRAME_BYTES - WT20_FRAG_HDR_BYTES)
+
+/* largest message that can be reassembled */
+#ifdef CONFIG_WT20_MAX_MESSAGE_BYTES
+#define WT20_FRAG_MAX_MESSAGE_BYTES (CONFIG_WT20_MAX_MESSAGE_BYTES)
+#else
+#define WT20_FRAG_MAX_MESSAGE_BYTES (16384U)
+#endif
+
+#define WT20_FRAG_MAX_FRAGMENTS ((WT20_FRAG_MAX_MESSAGE_BYTES + WT20_FRAG_DATA_BYTES - 1U) / WT20_FRAG_DATA_BYTES)
+
+/* number of messages that can be reassembled at the same time */
+#ifdef CONFIG_WT20_REASSEMBLY_SLOTS
+#define WT20_FRAG_REASSEMBLY_SLOTS (CONFIG_WT20_REASSEMBLY_SLOTS)
+#else
+#define WT20_FRAG_REASSEMBLY_SLOTS (2U)
+#endif
+
+/* an incomplete message is dropped if no fragment for it arrives for this long */
+#ifdef CONFIG_WT20_REASSEMBLY_TIMEOUT_MS
+#define WT20_FRAG_TIMEOUT_MS (CONFIG_WT20_REASSEMBLY_TIMEOUT_MS)
+#else
+#define WT20_FRAG_TIMEOUT_MS (1000U)
+#endif
+
+#define WT20_FRAG_MAC_BYTES (6U)
+
+/* completed messages remembered so late duplicates are recognized and can still be acked */
+#define WT20_FRAG_RECENT_COMPLETIONS (4U)
+
+/* bytes needed for a bitmap with one bit per fragment */
+#define WT20_FRAG_BITMAP_BYTES ((WT20_FRAG_MAX_FRAGMENTS + 7U) / 8U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t msg_id;
+    uint16_t index;
+    uint16_t count;
+} WT20_FRAG_HDR_T;
+
+typedef enum
+{
+    WT20_FRAG_INCOMPLETE, /* fragment stored, message not complete yet */
+    WT20_FRAG_COMPLETE,   /* fragment completed a message */
+    WT20_FRAG_DUPLICATE,  /* fragment was already received */
+    WT20_FRAG_INVALID     /* header is malformed or message is too large */
+} WT20_FRAG_RESULT_T;
+
+typedef struct
+{
+    bool in_use;
+    bool complete;       /* waiting on wt20_frag_release() */
+    uint8_t src_mac[WT20_FRAG_MAC_BYTES];
+    uint8_t msg_id;
+    uint16_t count;
+    uint16_t received;
+    uint32_t length;
+    uint32_t last_update_ms;
+    uint32_t bitmap[(WT20_FRAG_MAX_FRAGMENTS + 31U) / 32U];
+    uint8_t buffer[WT20_FRAG_MAX_MESSAGE_BYTES];
+} WT20_FRAG_SLOT_T;
+
+typedef struct
+{
+    uint32_t completed;
+    uint32_t timed_out;
+    uint32_t evicted;    /* incomplete messages dropped because every slot was busy */
+    uint32_t duplicates;
+    uint32_t invalid;
+} WT20_FRAG_STATS_T;
+
+typedef struct
+{
+    uint8_t src_mac[WT20_FRAG_MAC_BYTES];
+    uint8_t msg_id;
+    uint16_t count; /* 0 if entry is unused */
+} WT20_FRAG_COMPLETION_T;
+
+typedef struct
+{
+    WT20_FRAG_SLOT_T slots[WT20_FRAG_REASSEMBLY_SLOTS];
+    WT20_FRAG_COMPLETION_T recent[WT20_FRAG_RECENT_COMPLETIONS];
+    uint8_t recent_next;
+    WT20_FRAG_STATS_T stats;
+} WT20_FRAG_REASSEMBLER_T;
+
+/* completed message. data points into a reassembly slot until wt20_frag_release() is called */
+typedef struct
+{
+    const uint8_t* src_mac;
+    uint8_t msg_id;
+    const uint8_t* data;
+    uint32_t length;
+    uint32_t slot;
+} WT20_FRAG_MESSAGE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief returns number of fragments needed for a message of length bytes
+ */
+uint16_t wt20_frag_count(uint32_t length);
+
+/**
+ * \brief writes fragment header plus its slice of message into out
+ *
+ * \param msg_id id shared by all fragments of a message
+ * \param message[in] whole message
+ * \param length length of message
+ * \param index fragment to build, 0 to wt20_frag_count(length) - 1
+ * \param out[out] buffer of at least WT20_FRAG_FRAME_BYTES
+ *
+ * \return number of bytes written to out, 0 if index is out of range
+ */
+uint16_t wt20_frag_build(uint8_t msg_id, const uint8_t* message, uint32_t length, uint16_t index, uint8_t* out);
+
+/**
+ * \brief decodes fragment header
+ *
+ * \return false if data is too short, header is inconsistent or the fragment would end past
+ *         WT20_FRAG_MAX_MESSAGE_BYTES
+ */
+bool wt20_frag_parse_header(const uint8_t* data, uint16_t length, WT20_FRAG_HDR_T* hdr);
+
+/**
+ * \brief clears all reassembly slots and stats
+ */
+void wt20_frag_reassembly_init(WT20_FRAG_REASSEMBLER_T* reassembler);
+
+/**
+ * \brief stores a received fragment. Fragments may arrive in any order
+ *
+ * \param src_mac[in] sender of fragment
+ * \param data[in] fragment, starting at fragment header
+ * \param length length of fragment
+ * \param now_ms current time, used for timeouts
+ * \param message[out] filled in when result is WT20_FRAG_COMPLETE
+ */
+WT20_FRAG_RESULT_T wt20_frag_accept(WT20_FRAG_REASSEMBLER_T* reassembler,
+                                    const uint8_t* src_mac,
+                                    const uint8_t* data,
+                                    uint16_t length,
+                                    uint32_t now_ms,
+                                    WT20_FRAG_MESSAGE_T* message);
+
+/**
+ * \brief returns slot of a completed message to the pool
+ */
+void wt20_frag_release(WT20_FRAG_REASSEMBLER_T* reassembler, uint32_t slot);
+
+/**
+ * \brief drops incomplete messages that haven't received a fragment in WT20_FRAG_TIMEOUT_MS
+ */
+void wt20_frag_expire(WT20_FRAG_REASSEMBLER_T* reassembler, uint32_t now_ms);
+
+/**
+ * \brief reports which fragments of a message have been received, for acknowledging them
+ *
+ * \param src_mac[in] sender of message
+ * \param msg_id id of message
+ * \param count[out] number of fragments in message
+ * \param bitmap[out] bit i (LSB first) set if fragment i was received. Must hold WT20_FRAG_BITMAP_BYTES
+ *
+ * \return false if message is neither in progress nor recently completed
+ */
+bool wt20_frag_get_progress(WT20_FRAG_REASSEMBLER_T* reassembler,
+                            const uint8_t* src_mac,
+                            uint8_t msg_id,
+                            uint16_t* count,
+                            uint8_t* bitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,216 @@
+/**
+ ********************************************************************************
+ * @file    wt20_group.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Group talk. Each frame is broadcast once with a group id and a per group sequence
+ *          number, and receivers keep only the groups they joined. Broadcasts are never acked,
+ *          so receivers that see a gap can NACK the talker, which rebroadcasts the missing
+ *          frames from a short history.
+ ********************************************************************************
+ */
+
+#ifndef WT20_GROUP_H
+#define WT20_GROUP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "sdkconfig.h"
+#include "wt20_header.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* frames the talker keeps for repair. Older frames are only useful to a jitter buffer anyway */
+#ifdef CONFIG_WT20_GROUP_HISTORY
+#define WT20_GROUP_HISTORY (CONFIG_WT20_GROUP_HISTORY)
+#else
+#define WT20_GROUP_HISTORY (8U)
+#endif
+
+/* least time between NACKs to one talker, and between repairs of one frame. Several members
+   missing the same frame then cost one rebroadcast */
+#ifdef CONFIG_WT20_GROUP_NACK_HOLDOFF_MS
+#define WT20_GROUP_NACK_HOLDOFF_MS (CONFIG_WT20_GROUP_NACK_HOLDOFF_MS)
+#else
+#define WT20_GROUP_NACK_HOLDOFF_MS (10U)
+#endif
+
+/* talkers a receiver tracks gaps for at once */
+#define WT20_GROUP_SOURCES (4U)
+
+#define WT20_GROUP_COUNT (256U)
+
+/* group id, sequence number (2) */
+#define WT20_GROUP_HDR_BYTES (3U)
+#define WT20_GROUP_MAX_FRAME_BYTES (WT20_PAYLOAD_BYTES - WT20_GROUP_HDR_BYTES)
+
+/* group id, newest sequence number (2), bitmap of missing frames behind it (4) */
+#define WT20_GROUP_NACK_BYTES (7U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef enum
+{
+    WT20_GROUP_NEW,
+    WT20_GROUP_REPAIRED,      /* arrived in a rebroadcast, after frames behind it */
+    WT20_GROUP_DUPLICATE,
+    WT20_GROUP_NOT_MEMBER,
+    WT20_GROUP_INVALID
+} WT20_GROUP_RESULT_T;
+
+typedef struct
+{
+    uint8_t group;
+    uint16_t seq;
+    const uint8_t* data;      /* points into the received payload */
+    uint16_t length;
+} WT20_GROUP_FRAME_T;
+
+typedef struct
+{
+    uint32_t frames_sent;
+    uint32_t nacks_received;
+    uint32_t repairs_sent;
+    uint32_t frames_received;
+    uint32_t repairs_received;
+    uint32_t duplicates;
+    uint32_t not_member;      /* frames for groups this device hasn't joined */
+    uint32_t nacks_sent;
+} WT20_GROUP_STATS_T;
+
+/* frame kept for repair. The talking task rewrites it while the receiving task may be copying
+   it out, so version is odd during a rewrite and a copy that saw it change is thrown away */
+typedef struct
+{
+    atomic_uint_least32_t version;
+    uint8_t group;
+    uint16_t seq;
+    uint16_t length;
+    uint8_t payload[WT20_PAYLOAD_BYTES];  /* group header and frame, as broadcast */
+} WT20_GROUP_SLOT_T;
+
+typedef struct
+{
+    /* talking task */
+    WT20_GROUP_SLOT_T history[WT20_GROUP_HISTORY];
+    uint32_t next_slot;
+    uint16_t next_seq[WT20_GROUP_COUNT];  /* per group, so members never see gaps from other groups */
+
+    /* receiving task. The NACK being served, and the last repair of each slot */
+    uint8_t nack_group;
+    uint16_t nack_newest;
+    uint32_t nack_missing;
+    uint16_t repaired_seq[WT20_GROUP_HISTORY];
+    uint8_t repaired_group[WT20_GROUP_HISTORY];
+    uint32_t repaired_ms[WT20_GROUP_HISTORY];
+    bool repaired[WT20_GROUP_HISTORY];
+} WT20_GROUP_TX_T;
+
+typedef struct
+{
+    uint8_t mac[WT20_DEDUP_MAC_BYTES];
+    uint8_t group;
+    WT20_SEQ_WINDOW_T window;
+    uint16_t first_seq;       /* oldest frame worth a NACK, nothing before it was expected */
+    bool nacked;
+    uint32_t last_nack_ms;
+    uint32_t last_used;
+} WT20_GROUP_SOURCE_T;
+
+typedef struct
+{
+    /* bit per group. Set by any task, read by the receiving task */
+    atomic_uint_least32_t members[WT20_GROUP_COUNT / 32U];
+    atomic_uint_least32_t repair[WT20_GROUP_COUNT / 32U];
+
+    /* receiving task */
+    WT20_GROUP_SOURCE_T sources[WT20_GROUP_SOURCES];
+    uint32_t clock;
+} WT20_GROUP_RX_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets history and restarts every group's count
+ */
+void wt20_group_tx_init(WT20_GROUP_TX_T* tx);
+
+/**
+ * \brief builds the payload of a group frame and keeps it for repair
+ *
+ * \param payload[out] buffer of at least WT20_PAYLOAD_BYTES
+ *
+ * \return payload length, or 0 if frame is longer than WT20_GROUP_MAX_FRAME_BYTES
+ */
+uint16_t wt20_group_tx_build(WT20_GROUP_TX_T* tx, uint8_t group, const uint8_t* frame, uint16_t length, uint8_t* payload);
+
+/**
+ * \brief takes a NACK payload. Replaces any NACK whose repairs haven't all been taken yet
+ *
+ * \return false if nack is malformed
+ */
+bool wt20_group_tx_on_nack(WT20_GROUP_TX_T* tx, const uint8_t* nack, uint16_t length);
+
+/**
+ * \brief builds the next repair the last NACK asked for. Frames no longer in the history,
+ *        or repaired less than WT20_GROUP_NACK_HOLDOFF_MS ago, are skipped
+ *
+ * \param payload[out] buffer of at least WT20_PAYLOAD_BYTES
+ *
+ * \return payload length, 0 once there is nothing left to repair
+ */
+uint16_t wt20_group_tx_next_repair(WT20_GROUP_TX_T* tx, uint32_t now_ms, uint8_t* payload);
+
+/**
+ * \brief leaves every group and forgets every talker
+ */
+void wt20_group_rx_init(WT20_GROUP_RX_T* rx);
+
+/**
+ * \brief joins or leaves group
+ *
+ * \param repair whether gaps in the group are NACKed
+ */
+void wt20_group_rx_set_member(WT20_GROUP_RX_T* rx, uint8_t group, bool member, bool repair);
+
+/**
+ * \brief checks a received group payload against membership and the talker's recent frames
+ *
+ * \param repair whether payload came in a rebroadcast
+ * \param frame[out] valid for WT20_GROUP_NEW and WT20_GROUP_REPAIRED
+ */
+WT20_GROUP_RESULT_T wt20_group_rx_accept(WT20_GROUP_RX_T* rx,
+                                         const uint8_t* src_mac,
+                                         const uint8_t* payload,
+                                         uint16_t length,
+                                         bool repair,
+                                         WT20_GROUP_FRAME_T* frame);
+
+/**
+ * \brief builds a NACK for the frames still missing from a talker in group, at most one per
+ *        WT20_GROUP_NACK_HOLDOFF_MS, if the group was joined with repair
+ *
+ * \param nack[out] buffer of at least WT20_GROUP_NACK_BYTES
+ *
+ * \return NACK length, 0 if none is due
+ */
+uint16_t wt20_group_rx_build_nack(WT20_GROUP_RX_T* rx, const uint8_t* src_mac, uint8_t group, uint32_t now_ms, uint8_t* nack);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ ********************************************************************************
+ * @file    wt20_header.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Header at the front of every wt20 frame, and duplicate suppression by sequence
+ *          number. The sender's MAC isn't in the header, esp now already reports it
+ ********************************************************************************
+ */
+
+#ifndef WT20_HEADER_H
+#define WT20_HEADER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/*
+ * wire layout, multi byte fields little endian
+ *   0     version (high nibble), flags (low nibble)
+ *   1     type, a WT20_COMMAND_T
+ *   2..3  sequence number, counts every frame the sender sends
+ *   4..5  sender's ms clock when the frame was built, low 16 bits
+ *   6..7  crc16 of bytes 0..5 and the payload
+ */
+#define WT20_HDR_BYTES (8U)
+
+#define WT20_HDR_VERSION (1U)
+
+/* largest esp now frame, and what is left of it for the payload */
+#define WT20_FRAME_BYTES (250U)
+#define WT20_PAYLOAD_BYTES (WT20_FRAME_BYTES - WT20_HDR_BYTES)
+
+/* none are defined in version 1. Sent as 0, ignored when received */
+#define WT20_HDR_FLAGS_MASK (0x0FU)
+
+/* senders whose recent sequence numbers are remembered */
+#define WT20_DEDUP_PEERS (8U)
+
+/* how far behind the newest sequence number a duplicate is still recognized */
+#define WT20_DEDUP_WINDOW (32U)
+
+#define WT20_DEDUP_MAC_BYTES (6U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t version;
+    uint8_t flags;
+    uint8_t type;
+    uint16_t seq;
+    uint16_t timestamp_ms;
+} WT20_HDR_T;
+
+typedef enum
+{
+    WT20_HDR_OK,
+    WT20_HDR_TOO_SHORT,
+    WT20_HDR_BAD_VERSION,
+    WT20_HDR_BAD_CRC
+} WT20_HDR_RESULT_T;
+
+/* recent sequence numbers from one sender */
+typedef struct
+{
+    bool used;
+    uint16_t newest_seq;
+    uint32_t seen;          /* bit n set if newest_seq - n has arrived */
+} WT20_SEQ_WINDOW_T;
+
+typedef struct
+{
+    uint8_t mac[WT20_DEDUP_MAC_BYTES];
+    WT20_SEQ_WINDOW_T window;
+    uint32_t last_used;     /* for replacing the least recently heard sender */
+} WT20_DEDUP_PEER_T;
+
+typedef struct
+{
+    WT20_DEDUP_PEER_T peers[WT20_DEDUP_PEERS];
+    uint32_t clock;
+    uint32_t duplicates;
+} WT20_DEDUP_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief writes header into the first WT20_HDR_BYTES of frame, with the crc covering the
+ *        payload that follows it. Build the payload first
+ *
+ * \param hdr[in] version is ignored, WT20_HDR_VERSION is always sent
+ * \param frame[in,out] header space followed by payload_length bytes of payload
+ *
+ * \return length of whole frame
+ */
+uint16_t wt20_header_build(const WT20_HDR_T* hdr, uint8_t* frame, uint16_t payload_length);
+
+/**
+ * \brief checks a received frame and reads its header. The payload starts at
+ *        frame + WT20_HDR_BYTES
+ *
+ * \param length length of whole frame
+ * \param hdr[out] only valid if WT20_HDR_OK is returned
+ */
+WT20_HDR_RESULT_T wt20_header_parse(const uint8_t* frame, uint16_t length, WT20_HDR_T* hdr);
+
+/**
+ * \brief records seq in one sender's window. A seq more than WT20_DEDUP_WINDOW behind the
+ *        newest one is taken as the sender having restarted, so it starts the window over.
+ *        Zero a window to forget it
+ *
+ * \return false if this seq already arrived
+ */
+bool wt20_seq_window_accept(WT20_SEQ_WINDOW_T* window, uint16_t seq);
+
+/**
+ * \brief forgets every sender
+ */
+void wt20_dedup_init(WT20_DEDUP_T* dedup);
+
+/**
+ * \brief wt20_seq_window_accept() for senders looked up by mac, for when there is nowhere
+ *        else to keep their window. The WT20_DEDUP_PEERS heard from most recently are kept
+ *
+ * \return false if this seq already arrived from this sender (counted in duplicates)
+ */
+bool wt20_dedup_accept(WT20_DEDUP_T* dedup, const uint8_t* src_mac, uint16_t seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,120 @@
+/**
+ ********************************************************************************
+ * @file    wt20_peer.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Fixed size table of known peers, hashed on MAC so a received frame finds its
+ *          sender in constant time however full the table is. Each peer gets a 1 byte id,
+ *          used by the API in place of its MAC, and keeps its own protocol state and stats
+ ********************************************************************************
+ */
+
+#ifndef WT20_PEER_H
+#define WT20_PEER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "wt20_header.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define WT20_PEER_MAC_BYTES (6U)
+
+/* esp now allows 20 peers, counting encrypted ones */
+#ifdef CONFIG_WT20_MAX_PEERS
+#define WT20_PEER_MAX (CONFIG_WT20_MAX_PEERS)
+#else
+#define WT20_PEER_MAX (20U)
+#endif
+
+/* never handed out, means no peer */
+#define WT20_PEER_ID_NONE (0U)
+
+/* hash index slots. At least twice WT20_PEER_MAX, so probe runs stay a slot or two long */
+#define WT20_PEER_HASH_BITS (6U)
+#define WT20_PEER_HASH_SLOTS (1U << WT20_PEER_HASH_BITS)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* 1 to WT20_PEER_MAX. Only means something on this device, peers number each other differently */
+typedef uint8_t WT20_PEER_ID_T;
+
+typedef struct
+{
+    uint32_t frames_rx;       /* frames that passed their crc */
+    uint32_t duplicates;
+    uint32_t frames_tx;       /* single frame writes */
+    uint32_t tx_failures;
+    uint32_t last_heard_ms;
+    int8_t last_rssi;
+} WT20_PEER_STATS_T;
+
+typedef struct
+{
+    uint8_t mac[WT20_PEER_MAC_BYTES];
+    WT20_PEER_ID_T id;        /* WT20_PEER_ID_NONE while the entry is free */
+    WT20_SEQ_WINDOW_T rx_window;
+    WT20_PEER_STATS_T stats;
+} WT20_PEER_T;
+
+/*
+ * peers[id - 1] holds a peer. index is open addressed with linear probing and holds ids,
+ * so a lookup hashes the MAC and compares against a slot or two instead of every peer
+ */
+typedef struct
+{
+    WT20_PEER_T peers[WT20_PEER_MAX];
+    WT20_PEER_ID_T index[WT20_PEER_HASH_SLOTS];
+    uint32_t count;
+} WT20_PEER_TABLE_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief empties table
+ */
+void wt20_peer_table_init(WT20_PEER_TABLE_T* table);
+
+/**
+ * \brief adds mac with fresh state, taking the lowest free id
+ *
+ * \return id of mac, its existing id if already added, or WT20_PEER_ID_NONE if the table is full
+ */
+WT20_PEER_ID_T wt20_peer_add(WT20_PEER_TABLE_T* table, const uint8_t* mac);
+
+/**
+ * \brief frees id for reuse
+ *
+ * \return false if id isn't in the table
+ */
+bool wt20_peer_remove(WT20_PEER_TABLE_T* table, WT20_PEER_ID_T id);
+
+/**
+ * \brief looks up mac
+ *
+ * \return its id, or WT20_PEER_ID_NONE if it isn't in the table
+ */
+WT20_PEER_ID_T wt20_peer_find(const WT20_PEER_TABLE_T* table, const uint8_t* mac);
+
+/**
+ * \brief returns entry of id, or NULL if id isn't in the table
+ */
+WT20_PEER_T* wt20_peer_get(WT20_PEER_TABLE_T* table, WT20_PEER_ID_T id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -18,11 +18,30 @@ extern "C" {
  * INCLUDES
  ************************************/
 #include <stdint.h>
+#include <stdbool.h>
+#include "wt20_fec.h"
+#include "wt20_vrate.h"
+#include "wt20_header.h"
+#include "wt20_peer.h"
+#include "wt20_group.h"
+#include "wt20_relay.h"
+#include "wt20_chan.h"
 
 /************************************
  * MACROS AND DEFINES
  ************************************/
 
+/* timeout for wt20_receive() and wt20_receive_all() that never expires */
+#define WT20_WAIT_FOREVER (0xFFFFFFFFU)
+
+/* buffers for frames being sent or read, shared by every task using wt20. The receiving task
+   holds up to 4 at once while it reads, answers and services a reliable transfer */
+#ifdef CONFIG_WT20_FRAME_POOL_BLOCKS
+#define WT20_FRAME_POOL_BLOCKS (CONFIG_WT20_FRAME_POOL_BLOCKS)
+#else
+#define WT20_FRAME_POOL_BLOCKS (6U)
+#endif
+
 /************************************
  * TYPEDEFS
  ************************************/
@@ -32,6 +51,20 @@ typedef enum
 {
     WT20_COMMAND_TOGGLE_LED,
     WT20_COMMAND_SEND_PAYLOAD,
+    WT20_COMMAND_FRAGMENT,    /* one piece of a message sent with wt20_send_message() */
+    WT20_COMMAND_BULK_DATA,   /* one piece of a message sent with wt20_send_message_reliable() */
+    WT20_COMMAND_BULK_POLL,   /* same as BULK_DATA, and asks receiver for a BULK_ACK */
+    WT20_COMMAND_BULK_ACK,    /* bitmap of received pieces of a reliable message */
+    WT20_COMMAND_STREAM,      /* fec coded live frame sent with wt20_write_stream() */
+    WT20_COMMAND_ECHO_REQUEST,/* answered by the receiving stack itself, with the same payload */
+    WT20_COMMAND_ECHO_REPLY,  /* answer to an ECHO_REQUEST, for measuring round trips */
+    WT20_COMMAND_GROUP_DATA,  /* live frame broadcast to a group with wt20_write_group() */
+    WT20_COMMAND_GROUP_REPAIR,/* GROUP_DATA broadcast again, because a member NACKed it */
+    WT20_COMMAND_GROUP_NACK,  /* group frames a member is missing, sent to their talker */
+    WT20_COMMAND_RELAY,       /* frame broadcast for relays to pass on, see wt20_relay.h */
+    WT20_COMMAND_CHANNEL_SWITCH, /* broadcast by the unit moving the group, see wt20_chan.h */
+    WT20_COMMAND_CHANNEL_ACK, /* broadcast answer to a CHANNEL_SWITCH */
+    WT20_COMMAND_STREAM_REPORT, /* loss a stream's listener saw, sent back to its talker, see wt20_vrate.h */
     WT20_COMMAND_NONE
 } WT20_COMMAND_T;
 
@@ -42,18 +75,64 @@ typedef enum
     WT20_INITIALIZATION_ERR,
     WT20_NOT_INITIALIZED,
     WT20_DEINIT_FAILURE,
-    WT20_NO_DATA_AVAILABLE
+    WT20_NO_DATA_AVAILABLE,
+    WT20_MESSAGE_TOO_LONG,
+    WT20_SEND_FAILURE,
+    WT20_TRANSFER_IN_PROGRESS,
+    WT20_NO_BUFFER,           /* every frame pool block in use, nothing was sent or read */
+    WT20_PEER_TABLE_FULL,     /* WT20_PEER_MAX peers already added, or esp now has no room */
+    WT20_UNKNOWN_PEER,
+    WT20_CHANNEL_ERR          /* channel outside ESPNOW_LINK_CHAN_FIRST to ESPNOW_LINK_CHAN_LAST, or no survey */
 } WT20_ERR_T;
 
-/* messages */
-/* TODO: Update to have version, CRC, etc. */
+/* received message. Header fields are described in wt20_header.h */
 typedef struct
 {
-    uint8_t src_mac[6U];
+    uint8_t src_mac[6U];      /* reported by esp now, not carried in the frame. A relayed frame's origin */
+    WT20_PEER_ID_T peer_id;   /* sender's id, WT20_PEER_ID_NONE if it was never added */
     uint8_t command;
-    uint8_t payload[249U];
+    uint16_t seq;
+    uint16_t timestamp_ms;    /* sender's clock, low 16 bits */
+    uint32_t rx_us;           /* esp now receive timestamp. Radio clock, not the one timing_get_us() reads */
+    int8_t rssi;
+    uint16_t length;          /* bytes of payload used, the rest is zeroed */
+    uint8_t payload[WT20_PAYLOAD_BYTES];
 } WT20_MSG_T;
 
+/* frames dropped by the receiver before they reach any handler */
+typedef struct
+{
+    uint32_t frames;          /* frames read from esp now */
+    uint32_t malformed;       /* too short, or an unknown header version */
+    uint32_t crc_errors;
+    uint32_t duplicates;
+} WT20_RX_STATS_T;
+
+/* called when all fragments of a message sent with wt20_send_message() have arrived.
+ * message is only valid until callback returns */
+typedef void (*WT20_MESSAGE_CB_T)(const uint8_t* src_mac, const uint8_t* message, uint32_t length, void* context);
+
+/* called when a transfer started with wt20_send_message_reliable() finishes.
+ * success is false if the peer stopped acknowledging before every fragment arrived */
+typedef void (*WT20_TRANSFER_DONE_CB_T)(bool success, void* context);
+
+/* called for every live frame received, or rebuilt from parity, in arrival order.
+ * seq counts frames, so gaps show frames that were lost for good */
+typedef WT20_FEC_FRAME_CB_T WT20_STREAM_CB_T;
+
+/* called for every group frame received, new or repaired, in arrival order. seq counts the
+ * talker's frames in that group, so repaired frames arrive after ones with higher seq */
+typedef void (*WT20_GROUP_CB_T)(uint8_t group,
+                                const uint8_t* src_mac,
+                                uint16_t seq,
+                                const uint8_t* frame,
+                                uint16_t length,
+                                bool repaired,
+                                void* context);
+
+/* called once per received message by wt20_receive_all() */
+typedef void (*WT20_MSG_HANDLER_T)(const WT20_MSG_T* msg, void* context);
+
 
 /************************************
  * EXPORTED VARIABLES
@@ -66,18 +145,214 @@ typedef struct
 /**
  * \brief Send command and optional payload to peer
  * 
- * \param peer_mac MAC address of peer to send message to (TODO: Create peer abstraction system)
+ * \param peer_mac MAC address of peer to send message to. Needn't be added, but only added
+ *        peers get per peer stats
  * \param command Command to send
  * \param payload[in] pointer to optional payload (pass NULL if not used)
- * \param payload_length length (in bytes) of payload (pass 0 if no payload)
+ * \param payload_length length (in bytes) of payload, at most WT20_PAYLOAD_BYTES (pass 0 if no payload).
+ *        Only these bytes go on air, receivers zero the rest of WT20_MSG_T.payload
+ *
+ * \return WT20_MESSAGE_TOO_LONG if payload doesn't fit one frame, WT20_SEND_FAILURE if the
+ *         peer's MAC layer didn't ack it
  */
 WT20_ERR_T wt20_write(const uint8_t* peer_mac, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length);
 
+/**
+ * \brief Sends a message of any length up to WT20_FRAG_MAX_MESSAGE_BYTES to peer, split into
+ *        fragments. Fragments are pipelined, so several are in the air at once. Blocks until
+ *        every fragment has been acked by the peer's MAC layer
+ * 
+ * \param peer_mac MAC address of peer to send message to
+ * \param message[in] message to send
+ * \param length length (in bytes) of message
+ * 
+ * \return WT20_SEND_FAILURE if any fragment was not acked, or the link's pipeline stayed full
+ *         of other writers' frames for two wake intervals
+ */
+WT20_ERR_T wt20_send_message(const uint8_t* peer_mac, const uint8_t* message, uint32_t length);
+
+/**
+ * \brief Starts a reliable transfer of a message of up to WT20_FRAG_MAX_MESSAGE_BYTES. The peer
+ *        periodically returns a bitmap of received fragments and only missing fragments are
+ *        resent, while new fragments keep flowing. Returns immediately, the transfer is driven
+ *        by the task calling wt20_receive() or wt20_receive_all(). One transfer at a time
+ * 
+ * \param peer_mac MAC address of peer to send message to
+ * \param message[in] message to send. Must stay valid until done_callback is called
+ * \param length length (in bytes) of message
+ * \param done_callback called from the receiving task when transfer finishes (pass NULL if not used)
+ * \param context passed to done_callback
+ * 
+ * \return WT20_TRANSFER_IN_PROGRESS if a previous transfer hasn't finished
+ */
+WT20_ERR_T wt20_send_message_reliable(const uint8_t* peer_mac,
+                                      const uint8_t* message,
+                                      uint32_t length,
+                                      WT20_TRANSFER_DONE_CB_T done_callback,
+                                      void* context);
+
+/**
+ * \brief Sets up forward error correction for wt20_write_stream(). Every config.k frames are
+ *        followed by config.m parity frames, and the receiver rebuilds up to m lost frames per
+ *        group without any retransmission. Receivers follow the sender's config automatically.
+ *        wt20_init() sets up the Kconfig defaults with full size frames, call this after it
+ * 
+ * \param config[in] group size, parity count and frame length (m = 0 sends frames unprotected)
+ */
+WT20_ERR_T wt20_set_stream_fec(const WT20_FEC_CONFIG_T* config);
+
+/**
+ * \brief Sends one live frame (e.g. encoded audio), plus parity frames when it completes a group
+ * 
+ * \param peer_mac MAC address of peer to send frame to
+ * \param frame[in] frame to send
+ * \param length length of frame, at most frame_bytes of the fec config
+ *
+ * \return WT20_SEND_FAILURE if the frame or its parity wasn't acked. Parity still goes out
+ *         after a failed frame, and each failure counts against wt20_next_voice_mode()
+ */
+WT20_ERR_T wt20_write_stream(const uint8_t* peer_mac, const uint8_t* frame, uint16_t length);
+
+/**
+ * \brief Picks the adpcm mode to code the next voice frame for wt20_write_stream() in, from
+ *        how the stream's sends are doing, the loss its listener reports and queued_frames.
+ *        Call it once per frame, from the task that writes the stream. Each fec group is sized
+ *        for its first frame's mode, so a mode can go down at any frame but only up at the
+ *        start of a group, and frames of a lower mode take less time on air. Listeners need
+ *        nothing set up, every block says what mode it is in
+ *
+ * \param queued_frames captured frames waiting behind this one, e.g. audio_frame_queue_count()
+ * \param mode[out] mode for adpcm_encode_block_mode()
+ */
+WT20_ERR_T wt20_next_voice_mode(uint32_t queued_frames, ADPCM_MODE_T* mode);
+
+/**
+ * \param stats[out] talker side (pass NULL if not used)
+ * \param rx_stats[out] listener side (pass NULL if not used)
+ */
+WT20_ERR_T wt20_get_voice_rate_stats(WT20_VRATE_STATS_T* stats, WT20_VRATE_RX_STATS_T* rx_stats);
+
+/**
+ * \brief Joins group. Frames for groups not joined are dropped as soon as they are read
+ *
+ * \param repair whether missing frames are NACKed. NACKs go straight to the talker, so only
+ *        talkers added with wt20_add_peer() are asked
+ */
+WT20_ERR_T wt20_join_group(uint8_t group, bool repair);
+
+WT20_ERR_T wt20_leave_group(uint8_t group);
+
+/**
+ * \brief Broadcasts one live frame to every member of group in a single send, so airtime
+ *        doesn't grow with the group. Doesn't wait for the send callback, a broadcast is never
+ *        acked. The last WT20_GROUP_HISTORY frames are kept and rebroadcast when NACKed,
+ *        from the task calling wt20_receive() or wt20_receive_all(). The talker needn't join
+ *
+ * \param length length of frame, at most WT20_GROUP_MAX_FRAME_BYTES
+ *
+ * \return WT20_SEND_FAILURE if esp now wouldn't take the frame
+ */
+WT20_ERR_T wt20_write_group(uint8_t group, const uint8_t* frame, uint16_t length);
+
+/**
+ * \brief Sets callback for frames of joined groups. Called from whichever task reads messages
+ *
+ * \param callback (pass NULL to drop frames)
+ */
+WT20_ERR_T wt20_set_group_callback(WT20_GROUP_CB_T callback, void* context);
+
+WT20_ERR_T wt20_get_group_stats(WT20_GROUP_STATS_T* stats);
+
+/**
+ * \brief Turns relay mode on or off. In relay mode this unit passes on relayed frames that
+ *        aren't addressed to it, after a random backoff of up to WT20_RELAY_JITTER_US, while
+ *        they have hops left. Relayed frames addressed to it are delivered either way
+ */
+WT20_ERR_T wt20_set_relay(bool enabled);
+
+/**
+ * \brief Sends command and optional payload to dest through any relays in range, for peers
+ *        too far away for wt20_write(). The frame is broadcast, and every unit in relay mode
+ *        that hears it passes it on, for up to WT20_RELAY_MAX_HOPS hops. It arrives as if it
+ *        came from this unit, with rssi and timestamp_ms from the last hop. Echo requests
+ *        sent this way are answered the same way. Nothing is acked, so nothing is waited for
+ *
+ * \param dest_mac[in] MAC of the unit it is for, or the broadcast MAC for every unit
+ * \param payload_length at most WT20_RELAY_MAX_PAYLOAD_BYTES
+ *
+ * \return WT20_MESSAGE_TOO_LONG if payload doesn't fit one relayed frame
+ */
+WT20_ERR_T wt20_write_relayed(const uint8_t* dest_mac, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length);
+
+WT20_ERR_T wt20_get_relay_stats(WT20_RELAY_STATS_T* stats);
+
+/**
+ * \brief Moves this unit and every unit in range to channel. The new channel is broadcast
+ *        from the task calling wt20_receive() or wt20_receive_all() until each added peer
+ *        acks, and every unit switches WT20_CHAN_SWITCH_DELAY_MS from now. A unit that hears
+ *        none of the announcements stays behind. Doesn't wait for the switch
+ *
+ * \return WT20_CHANNEL_ERR if channel is outside ESPNOW_LINK_CHAN_FIRST to ESPNOW_LINK_CHAN_LAST
+ */
+WT20_ERR_T wt20_switch_channel(uint8_t channel);
+
+/**
+ * \brief Surveys every channel for dwell_ms, see espnow_link_scan_channels(), and moves the
+ *        group with wt20_switch_channel() if one is clearly quieter than the working channel.
+ *        Blocks for the survey, so meant for pairing time, or when the link stats show the
+ *        working channel degraded
+ *
+ * \param channel[out] channel picked, the working one if it is staying
+ */
+WT20_ERR_T wt20_auto_channel(uint32_t dwell_ms, uint8_t* channel);
+
+WT20_ERR_T wt20_get_chan_stats(WT20_CHAN_STATS_T* stats);
+
+/**
+ * \brief Sets callback for received live frames. Called from whichever task reads messages
+ * 
+ * \param callback called with each frame (pass NULL to drop frames)
+ * \param context passed to callback
+ */
+WT20_ERR_T wt20_set_stream_callback(WT20_STREAM_CB_T callback, void* context);
+
+/**
+ * \brief Sets callback for reassembled messages. Fragments are consumed by wt20_protocol_function(),
+ *        wt20_receive() and wt20_receive_all(), and the callback is called from whichever task calls them
+ * 
+ * \param callback called with each complete message (pass NULL to drop messages)
+ * \param context passed to callback
+ */
+WT20_ERR_T wt20_set_message_callback(WT20_MESSAGE_CB_T callback, void* context);
+
 /**
  * \brief Should be called periodically. Checks for new messages from peers and performs actions
  */
 WT20_ERR_T wt20_protocol_function(const WT20_MSG_T* msg_buffer);
 
+/**
+ * \brief Sleeps until a message arrives (or timeout expires), then reads it
+ * 
+ * \param msg_buffer[out] buffer to put message into
+ * \param timeout_ms max time to wait, or WT20_WAIT_FOREVER
+ * 
+ * \return WT20_NO_DATA_AVAILABLE on timeout
+ */
+WT20_ERR_T wt20_receive(const WT20_MSG_T* msg_buffer, uint32_t timeout_ms);
+
+/**
+ * \brief Sleeps until at least one message arrives (or timeout expires), then passes every
+ *        pending message to handler before returning
+ * 
+ * \param handler[in] called once per message, from the calling task
+ * \param context[in] passed to handler
+ * \param timeout_ms max time to wait for the first message, or WT20_WAIT_FOREVER
+ * \param processed[out] number of messages handled (pass NULL if not used)
+ * 
+ * \return WT20_NO_DATA_AVAILABLE on timeout
+ */
+WT20_ERR_T wt20_receive_all(WT20_MSG_HANDLER_T handler, void* context, uint32_t timeout_ms, uint32_t* processed);
+
 /**
  * \brief Sets up wt20 protocol, initialized espnow
  */
@@ -88,6 +363,11 @@ WT20_ERR_T wt20_init(void);
  */
 WT20_ERR_T wt20_deinit(void);
 
+/**
+ * \brief copies counts of frames dropped on receive
+ */
+WT20_ERR_T wt20_get_rx_stats(WT20_RX_STATS_T* stats);
+
 /**
  * \brief puts device mac address into buffer
  * 
@@ -96,12 +376,45 @@ WT20_ERR_T wt20_deinit(void);
 WT20_ERR_T wt20_get_device_mac(const uint8_t* buffer);
 
 /**
- * \brief adds contact. Currently just adds peer to espnow
- * 
- * \todo Eventually expand contact system with IDs, etc.
+ * \brief adds peer, without asking for its id
  */
 WT20_ERR_T wt20_add_contact(const uint8_t* mac);
 
+/**
+ * \brief adds mac to the peer table and to esp now. Adding a peer again just returns its id.
+ *        The table is not locked, so add and remove peers before the receiving task starts,
+ *        or from it
+ *
+ * \param id[out] id for the other wt20_*_peer() calls (pass NULL if not used)
+ *
+ * \return WT20_PEER_TABLE_FULL if WT20_PEER_MAX peers are already added, or esp now won't
+ *         register another
+ */
+WT20_ERR_T wt20_add_peer(const uint8_t* mac, WT20_PEER_ID_T* id);
+
+/**
+ * \brief frees id, and the mac's slot in esp now. Frames from its mac are still received,
+ *        without per peer state
+ */
+WT20_ERR_T wt20_remove_peer(WT20_PEER_ID_T id);
+
+/**
+ * \brief returns id of mac, or WT20_PEER_ID_NONE if it was never added
+ */
+WT20_PEER_ID_T wt20_find_peer(const uint8_t* mac);
+
+/**
+ * \brief copies mac, state and stats of id into peer
+ */
+WT20_ERR_T wt20_get_peer(WT20_PEER_ID_T id, WT20_PEER_T* peer);
+
+/**
+ * \brief wt20_write() to a peer by id
+ *
+ * \return WT20_UNKNOWN_PEER if id isn't in the peer table
+ */
+WT20_ERR_T wt20_write_peer(WT20_PEER_ID_T id, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,176 @@
+/**
+ ********************************************************************************
+ * @file    wt20_relay.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Multi-hop relay. Relayed frames are broadcast with their origin, final destination,
+ *          origin sequence number and hops left, so units in relay mode can pass on frames
+ *          that aren't theirs. Every unit remembers the (origin, sequence) pairs it saw last in
+ *          a small set associative cache, so each frame is delivered and forwarded at most once
+ *          however many relays hear it, at the same cost per frame. Forwards wait a random
+ *          backoff first, so relays that heard the same frame don't send over each other
+ ********************************************************************************
+ */
+
+#ifndef WT20_RELAY_H
+#define WT20_RELAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "wt20_header.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* radio hops a relayed frame may take, the origin's send included */
+#ifdef CONFIG_WT20_RELAY_MAX_HOPS
+#define WT20_RELAY_MAX_HOPS (CONFIG_WT20_RELAY_MAX_HOPS)
+#else
+#define WT20_RELAY_MAX_HOPS (3U)
+#endif
+
+/* longest random wait before forwarding. Every relay that heard a frame forwards it, so the
+   spread keeps their sends apart, at half this in mean latency per hop */
+#ifdef CONFIG_WT20_RELAY_JITTER_US
+#define WT20_RELAY_JITTER_US (CONFIG_WT20_RELAY_JITTER_US)
+#else
+#define WT20_RELAY_JITTER_US (2000U)
+#endif
+
+/* seen cache of WT20_RELAY_CACHE_WAYS << WT20_RELAY_CACHE_BITS entries. A frame only has to
+   stay in it while copies of it are still going around, a few ms per hop */
+#define WT20_RELAY_CACHE_BITS (4U)
+#define WT20_RELAY_CACHE_SETS (1U << WT20_RELAY_CACHE_BITS)
+#define WT20_RELAY_CACHE_WAYS (4U)
+
+/* frames waiting out their backoff */
+#define WT20_RELAY_QUEUE (4U)
+
+#define WT20_RELAY_MAC_BYTES (6U)
+
+/* origin (6), destination (6), origin sequence number (2, low byte first), hops left, inner command */
+#define WT20_RELAY_HDR_BYTES (16U)
+#define WT20_RELAY_MAX_PAYLOAD_BYTES (WT20_PAYLOAD_BYTES - WT20_RELAY_HDR_BYTES)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t origin[WT20_RELAY_MAC_BYTES];
+    uint8_t dest[WT20_RELAY_MAC_BYTES];   /* broadcast mac for every unit in range */
+    uint16_t seq;             /* origin's count of relayed frames */
+    uint8_t hops;             /* sends left, this one included */
+    uint8_t command;
+    const uint8_t* data;      /* points into the received payload */
+    uint16_t length;
+} WT20_RELAY_FRAME_T;
+
+typedef struct
+{
+    uint32_t frames_sent;     /* relayed frames this unit started */
+    uint32_t frames_delivered;
+    uint32_t frames_forwarded;
+    uint32_t duplicates;      /* copies already seen, from other relays or coming back around */
+    uint32_t hop_limit;       /* frames for others that had no hops left */
+    uint32_t queue_full;
+} WT20_RELAY_STATS_T;
+
+typedef struct
+{
+    uint8_t origin[WT20_RELAY_MAC_BYTES];
+    uint16_t seq;
+    bool used;
+} WT20_RELAY_SEEN_T;
+
+typedef struct
+{
+    uint32_t due_us;
+    uint16_t length;
+    bool used;
+    uint8_t payload[WT20_PAYLOAD_BYTES];  /* relay header and data, hops already counted down */
+} WT20_RELAY_SLOT_T;
+
+/* owned by the receiving task */
+typedef struct
+{
+    WT20_RELAY_SEEN_T seen[WT20_RELAY_CACHE_SETS][WT20_RELAY_CACHE_WAYS];
+    uint8_t next_way[WT20_RELAY_CACHE_SETS];  /* replaced next, so each set forgets its oldest */
+    WT20_RELAY_SLOT_T queue[WT20_RELAY_QUEUE];
+    uint32_t random;
+} WT20_RELAY_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief forgets every frame seen and queued
+ *
+ * \param seed starts the backoff sequence, give each unit its own, its mac does
+ */
+void wt20_relay_init(WT20_RELAY_T* relay, uint32_t seed);
+
+/**
+ * \brief builds the payload of a relayed frame
+ *
+ * \param payload[out] buffer of at least WT20_PAYLOAD_BYTES
+ *
+ * \return payload length, or 0 if frame's data is longer than WT20_RELAY_MAX_PAYLOAD_BYTES
+ */
+uint16_t wt20_relay_build(const WT20_RELAY_FRAME_T* frame, uint8_t* payload);
+
+/**
+ * \brief reads a relayed frame's header
+ *
+ * \param frame[out] data points into payload
+ *
+ * \return false if payload is malformed
+ */
+bool wt20_relay_parse(const uint8_t* payload, uint16_t length, WT20_RELAY_FRAME_T* frame);
+
+/**
+ * \brief checks origin and seq against the cache, and adds them if they weren't there
+ *
+ * \return true if the frame was seen before
+ */
+bool wt20_relay_seen(WT20_RELAY_T* relay, const uint8_t* origin, uint16_t seq);
+
+/**
+ * \brief queues a received relay payload to go out again after a random backoff, one hop
+ *        fewer. Check its hops first, a frame with 1 hop left was on its last
+ *
+ * \return false if the queue is full
+ */
+bool wt20_relay_queue(WT20_RELAY_T* relay, const uint8_t* payload, uint16_t length, uint32_t now_us);
+
+/**
+ * \brief takes the next frame whose backoff is over off the queue
+ *
+ * \param payload[out] buffer of at least WT20_PAYLOAD_BYTES
+ *
+ * \return payload length, 0 if none is due
+ */
+uint16_t wt20_relay_next(WT20_RELAY_T* relay, uint32_t now_us, uint8_t* payload);
+
+/**
+ * \brief whether any frame is queued
+ *
+ * \param due_us[out] when the first one is due (pass NULL if not used)
+ */
+bool wt20_relay_pending(const WT20_RELAY_T* relay, uint32_t* due_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
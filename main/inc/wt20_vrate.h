@@ -0,0 +1,183 @@
+/**
+ ********************************************************************************
+ * @file    wt20_vrate.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Voice bitrate control. The talker picks the adpcm mode of every live frame from
+ *          how its own sends are doing, the loss its listener reports and how many captured
+ *          frames are waiting to go out, so talk stays inside the latency budget when the air
+ *          gets busy instead of queueing up and dropping. Any sign of trouble drops a mode
+ *          straight away, a backed up queue drops to the lowest. A mode up needs about a
+ *          second with no trouble, longer each time the last one up didn't last. Every block
+ *          carries its mode, so the listener just follows. The listener counts frames lost
+ *          before fec and reports the loss every WT20_VRATE_REPORT_FRAMES frames
+ ********************************************************************************
+ */
+
+#ifndef WT20_VRATE_H
+#define WT20_VRATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "adpcm.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+
+/* share of sends failing, as a moving average, that drops a mode */
+#define WT20_VRATE_DOWN_FAIL_PERMILLE (100U)
+
+/* loss before fec the listener reports that drops a mode. Parity still covers it, so this is
+   the early warning, not the last one */
+#ifdef CONFIG_WT20_VOICE_RATE_DOWN_LOSS_PERMILLE
+#define WT20_VRATE_DOWN_LOSS_PERMILLE (CONFIG_WT20_VOICE_RATE_DOWN_LOSS_PERMILLE)
+#else
+#define WT20_VRATE_DOWN_LOSS_PERMILLE (100U)
+#endif
+
+/* captured frames waiting to go out that drop a mode, and that drop straight to the lowest */
+#ifdef CONFIG_WT20_VOICE_RATE_QUEUE_FRAMES
+#define WT20_VRATE_QUEUE_FRAMES (CONFIG_WT20_VOICE_RATE_QUEUE_FRAMES)
+#else
+#define WT20_VRATE_QUEUE_FRAMES (2U)
+#endif
+
+#define WT20_VRATE_QUEUE_SEVERE_FRAMES (2U * WT20_VRATE_QUEUE_FRAMES)
+
+/* frames after a mode down before another, so a drop has time to show */
+#define WT20_VRATE_HOLD_FRAMES (4U)
+
+/* frames with no trouble before a mode up, about a second of talk */
+#define WT20_VRATE_RAISE_FRAMES (34U)
+
+/* most the wait for a mode up grows, as a multiple of WT20_VRATE_RAISE_FRAMES */
+#define WT20_VRATE_MAX_BACKOFF (8U)
+
+/* listener reports every this many frames, about a second of talk. Long enough that one lost
+   frame is well under WT20_VRATE_DOWN_LOSS_PERMILLE */
+#define WT20_VRATE_REPORT_FRAMES (32U)
+
+/* loss before fec per mille (2), frames the loss is out of (2) */
+#define WT20_VRATE_REPORT_BYTES (4U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+typedef struct
+{
+    ADPCM_MODE_T mode;
+    uint32_t frames[ADPCM_MODES];   /* frames sent in each mode */
+    uint32_t ups;
+    uint32_t downs;
+    uint32_t reports;
+    uint16_t loss_permille;         /* last one reported */
+    uint16_t fail_permille;
+} WT20_VRATE_STATS_T;
+
+/* talker side, owned by the sending task */
+typedef struct
+{
+    ADPCM_MODE_T mode;
+    uint16_t fail_permille;
+    uint16_t loss_permille;
+    bool report_pending;            /* a report came in that next() hasn't acted on */
+    uint32_t hold;                  /* frames left before another mode down */
+    uint32_t clean;                 /* frames in a row with no trouble */
+    uint32_t backoff;
+    uint32_t since_up;              /* frames since the last mode up, while it is on trial */
+    bool on_trial;
+    WT20_VRATE_STATS_T stats;
+} WT20_VRATE_T;
+
+typedef struct
+{
+    uint32_t delivered;             /* data frames passed on, rebuilt ones included */
+    uint32_t recovered;
+    uint32_t lost;                  /* data frames lost for good */
+    uint32_t reports;
+} WT20_VRATE_RX_STATS_T;
+
+/* listener side, owned by the receiving task */
+typedef struct
+{
+    uint16_t frames;                /* since the last report */
+    uint16_t missed;                /* of those, lost before fec */
+    WT20_VRATE_RX_STATS_T stats;
+} WT20_VRATE_RX_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief starts at the best mode, with nothing known about the link
+ */
+void wt20_vrate_init(WT20_VRATE_T* ctl);
+
+/**
+ * \brief counts the result of one live frame's send
+ */
+void wt20_vrate_on_send(WT20_VRATE_T* ctl, bool sent);
+
+/**
+ * \brief takes in a listener's report, acted on by the next wt20_vrate_next()
+ */
+void wt20_vrate_on_report(WT20_VRATE_T* ctl, uint16_t loss_permille);
+
+/**
+ * \brief mode to code the next live frame in
+ *
+ * \param queued_frames captured frames waiting behind this one
+ * \param may_raise whether the mode may go up. Fec pads every frame of a group to the same
+ *        length, so a mode up has to wait for the next group
+ */
+ADPCM_MODE_T wt20_vrate_next(WT20_VRATE_T* ctl, uint32_t queued_frames, bool may_raise);
+
+void wt20_vrate_get_stats(const WT20_VRATE_T* ctl, WT20_VRATE_STATS_T* stats);
+
+void wt20_vrate_rx_init(WT20_VRATE_RX_T* rx);
+
+/**
+ * \brief counts frames lost for good, from the fec decoder
+ */
+void wt20_vrate_rx_on_lost(WT20_VRATE_RX_T* rx, uint32_t count);
+
+/**
+ * \brief counts a data frame passed on by the fec decoder
+ *
+ * \param recovered whether it was rebuilt, so lost before fec
+ *
+ * \return true once a report is due
+ */
+bool wt20_vrate_rx_on_frame(WT20_VRATE_RX_T* rx, bool recovered);
+
+/**
+ * \brief builds a report of the loss since the last one, and starts counting again
+ *
+ * \param payload[out] WT20_VRATE_REPORT_BYTES
+ *
+ * \return payload length
+ */
+uint16_t wt20_vrate_rx_build_report(WT20_VRATE_RX_T* rx, uint8_t* payload);
+
+/**
+ * \param loss_permille[out] loss before fec the listener saw
+ *
+ * \return false if payload isn't a report
+ */
+bool wt20_vrate_parse_report(const uint8_t* payload, uint16_t length, uint16_t* loss_permille);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
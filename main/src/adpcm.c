@@ -0,0 +1,370 @@
+/**
+ ********************************************************************************
+ * @file    adpcm.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Integer only IMA-ADPCM voice codec
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "adpcm.h"
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SIGN_BIT_D (8U)
+#define SIGN_BIT_2BIT_D (2U)
+#define MODE_OFFSET_D (3U)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+
+/* IMA step sizes, roughly 1.1x apart */
+static const int16_t step_table[ADPCM_MAX_STEP_INDEX + 1U] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,
+    25,    28,    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,
+    88,    97,    107,   118,   130,   143,   157,   173,   190,   209,   230,   253,   279,
+    307,   337,   371,   408,   449,   494,   544,   598,   658,   724,   796,   876,   963,
+    1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,  2272,  2499,  2749,  3024,  3327,
+    3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,  9493,  10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+
+/* step index change per code, sign bit ignored */
+static const int8_t index_table[16U] = {-1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8};
+
+/* same for 2 bit codes. With one magnitude bit the step has to grow faster on a big one to keep
+   up with the waveform */
+static const int8_t index_table_2bit[4U] = {-1, 2, -1, 2};
+
+/* 16 kHz samples one byte of codes stands for */
+static const uint8_t samples_per_byte[ADPCM_MODES] = {
+    [ADPCM_MODE_16K] = 2U,
+    [ADPCM_MODE_8K] = 4U,
+    [ADPCM_MODE_8K_2BIT] = 8U
+};
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static inline int32_t clamp_sample(int32_t sample);
+static inline int32_t clamp_index(int32_t index);
+static inline uint8_t encode_sample(int32_t sample, int32_t* predictor, int32_t* index);
+static inline void decode_sample(uint8_t code, int32_t* predictor, int32_t* index);
+static inline uint8_t encode_sample_2bit(int32_t sample, int32_t* predictor, int32_t* index);
+static inline void decode_sample_2bit(uint8_t code, int32_t* predictor, int32_t* index);
+static void upsample(int16_t* pcm, uint16_t samples_8k, int32_t previous);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static inline int32_t clamp_sample(int32_t sample)
+{
+    if (sample > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    return (sample < INT16_MIN) ? INT16_MIN : sample;
+}
+
+static inline int32_t clamp_index(int32_t index)
+{
+    if (index < 0)
+    {
+        return 0;
+    }
+
+    return (index > (int32_t)ADPCM_MAX_STEP_INDEX) ? (int32_t)ADPCM_MAX_STEP_INDEX : index;
+}
+
+/* quantizes difference to predictor with the same shifts the decoder uses, so encoder and
+   decoder reconstruct bit identical samples */
+static inline uint8_t encode_sample(int32_t sample, int32_t* predictor, int32_t* index)
+{
+    int32_t step = step_table[*index];
+    int32_t diff = sample - *predictor;
+    int32_t delta = step >> 3;
+    uint8_t code = 0U;
+
+    if (diff < 0)
+    {
+        code = SIGN_BIT_D;
+        diff = -diff;
+    }
+
+    if (diff >= step)
+    {
+        code |= 4U;
+        diff -= step;
+        delta += step;
+    }
+
+    step >>= 1;
+
+    if (diff >= step)
+    {
+        code |= 2U;
+        diff -= step;
+        delta += step;
+    }
+
+    step >>= 1;
+
+    if (diff >= step)
+    {
+        code |= 1U;
+        delta += step;
+    }
+
+    *predictor = clamp_sample(((code & SIGN_BIT_D) != 0U) ? (*predictor - delta) : (*predictor + delta));
+    *index = clamp_index(*index + index_table[code]);
+
+    return code;
+}
+
+static inline void decode_sample(uint8_t code, int32_t* predictor, int32_t* index)
+{
+    int32_t step = step_table[*index];
+    int32_t delta = step >> 3;
+
+    if ((code & 4U) != 0U)
+    {
+        delta += step;
+    }
+
+    if ((code & 2U) != 0U)
+    {
+        delta += step >> 1;
+    }
+
+    if ((code & 1U) != 0U)
+    {
+        delta += step >> 2;
+    }
+
+    *predictor = clamp_sample(((code & SIGN_BIT_D) != 0U) ? (*predictor - delta) : (*predictor + delta));
+    *index = clamp_index(*index + index_table[code]);
+}
+
+/* one magnitude bit. Small differences come back as half a step, big ones as one and a half */
+static inline uint8_t encode_sample_2bit(int32_t sample, int32_t* predictor, int32_t* index)
+{
+    int32_t step = step_table[*index];
+    int32_t diff = sample - *predictor;
+    int32_t delta = step >> 1;
+    uint8_t code = 0U;
+
+    if (diff < 0)
+    {
+        code = SIGN_BIT_2BIT_D;
+        diff = -diff;
+    }
+
+    if (diff >= step)
+    {
+        code |= 1U;
+        delta += step;
+    }
+
+    *predictor = clamp_sample(((code & SIGN_BIT_2BIT_D) != 0U) ? (*predictor - delta) : (*predictor + delta));
+    *index = clamp_index(*index + index_table_2bit[code]);
+
+    return code;
+}
+
+static inline void decode_sample_2bit(uint8_t code, int32_t* predictor, int32_t* index)
+{
+    int32_t step = step_table[*index];
+    int32_t delta = ((code & 1U) != 0U) ? (step + (step >> 1)) : (step >> 1);
+
+    *predictor = clamp_sample(((code & SIGN_BIT_2BIT_D) != 0U) ? (*predictor - delta) : (*predictor + delta));
+    *index = clamp_index(*index + index_table_2bit[code]);
+}
+
+/* 8 kHz samples decoded into the back half of pcm, spread out to 16 kHz over the whole of it.
+   Each 8 kHz sample sits between the two it was averaged from, so both are a quarter of the
+   way to a neighbour. previous is the sample before the block, the last one has none after it */
+static void upsample(int16_t* pcm, uint16_t samples_8k, int32_t previous)
+{
+    const int16_t* in = &pcm[samples_8k];
+    int32_t sample;
+    int32_t next;
+    uint16_t i;
+
+    /* reads stay ahead of writes, sample i is read before pcm[2i] and pcm[2i + 1] are written */
+    for (i = 0U; i < samples_8k; i++)
+    {
+        sample = in[i];
+        next = ((i + 1U) < samples_8k) ? in[i + 1U] : sample;
+        pcm[2U * i] = (int16_t)((previous + (3 * sample)) >> 2);
+        pcm[(2U * i) + 1U] = (int16_t)(((3 * sample) + next) >> 2);
+        previous = sample;
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void adpcm_init(ADPCM_STATE_T* state)
+{
+    state->predictor = 0;
+    state->step_index = 0U;
+}
+
+uint16_t adpcm_encode_block(ADPCM_STATE_T* state, const int16_t* pcm, uint16_t samples, uint8_t* block)
+{
+    return adpcm_encode_block_mode(state, ADPCM_MODE_16K, pcm, samples, block);
+}
+
+uint16_t adpcm_encode_block_mode(ADPCM_STATE_T* state, ADPCM_MODE_T mode, const int16_t* pcm, uint16_t samples, uint8_t* block)
+{
+    /* state is kept in registers for the whole block and only written back at the end */
+    int32_t predictor = state->predictor;
+    int32_t index = state->step_index;
+    uint8_t* out = &block[ADPCM_HDR_BYTES];
+    uint16_t i;
+    uint8_t byte;
+    uint8_t code;
+
+    if ((mode >= ADPCM_MODES) || ((samples % samples_per_byte[mode]) != 0U) || (samples > ADPCM_BLOCK_SAMPLES))
+    {
+        return 0U;
+    }
+
+    block[0] = (uint8_t)((uint16_t)predictor & 0xFFU);
+    block[1] = (uint8_t)((uint16_t)predictor >> 8U);
+    block[2] = (uint8_t)index;
+    block[MODE_OFFSET_D] = (uint8_t)mode;
+
+    /* first sample in the low bits of each byte. At 8 kHz each pair is averaged, a plain low
+       pass that keeps most of what aliasing would bring down into the voice band out */
+    for (i = 0U; i < samples; i += samples_per_byte[mode])
+    {
+        switch (mode)
+        {
+        case ADPCM_MODE_16K:
+            byte = encode_sample(pcm[i], &predictor, &index);
+            byte |= (uint8_t)(encode_sample(pcm[i + 1U], &predictor, &index) << 4U);
+            break;
+        case ADPCM_MODE_8K:
+            byte = encode_sample((pcm[i] + pcm[i + 1U]) >> 1, &predictor, &index);
+            byte |= (uint8_t)(encode_sample((pcm[i + 2U] + pcm[i + 3U]) >> 1, &predictor, &index) << 4U);
+            break;
+        default:
+            byte = 0U;
+
+            for (code = 0U; code < 4U; code++)
+            {
+                byte |= (uint8_t)(encode_sample_2bit((pcm[i + (2U * code)] + pcm[i + (2U * code) + 1U]) >> 1, &predictor, &index)
+                                  << (2U * code));
+            }
+            break;
+        }
+
+        *out++ = byte;
+    }
+
+    state->predictor = (int16_t)predictor;
+    state->step_index = (uint8_t)index;
+
+    return (uint16_t)(ADPCM_HDR_BYTES + (samples / samples_per_byte[mode]));
+}
+
+uint16_t adpcm_block_bytes(ADPCM_MODE_T mode, uint16_t samples)
+{
+    return (mode < ADPCM_MODES) ? (uint16_t)(ADPCM_HDR_BYTES + (samples / samples_per_byte[mode])) : 0U;
+}
+
+ADPCM_MODE_T adpcm_block_mode(const uint8_t* block, uint16_t length)
+{
+    if ((length < ADPCM_HDR_BYTES) || (block[MODE_OFFSET_D] >= (uint8_t)ADPCM_MODES))
+    {
+        return ADPCM_MODES;
+    }
+
+    return (ADPCM_MODE_T)block[MODE_OFFSET_D];
+}
+
+uint16_t adpcm_decode_block(const uint8_t* block, uint16_t length, int16_t* pcm, ADPCM_STATE_T* end_state)
+{
+    ADPCM_STATE_T state;
+    uint16_t samples;
+
+    if ((length < ADPCM_HDR_BYTES) || (length > ADPCM_BLOCK_BYTES) || (block[2] > ADPCM_MAX_STEP_INDEX))
+    {
+        return 0U;
+    }
+
+    state.predictor = (int16_t)(uint16_t)((uint16_t)block[0] | ((uint16_t)block[1] << 8U));
+    state.step_index = block[2];
+    samples = adpcm_decode_continue(block, length, &state, pcm);
+
+    if (end_state != NULL)
+    {
+        *end_state = state;
+    }
+
+    return samples;
+}
+
+uint16_t adpcm_decode_continue(const uint8_t* block, uint16_t length, ADPCM_STATE_T* state, int16_t* pcm)
+{
+    ADPCM_MODE_T mode = adpcm_block_mode(block, length);
+    int32_t predictor = state->predictor;
+    int32_t index = clamp_index(state->step_index);
+    int16_t* out;
+    uint16_t bytes;
+    uint16_t samples;
+    uint16_t i;
+    uint8_t byte;
+    uint8_t code;
+
+    if ((mode == ADPCM_MODES) || (length > ADPCM_BLOCK_BYTES))
+    {
+        return 0U;
+    }
+
+    /* anything past a full block is padding, fec pads every frame to the same length */
+    bytes = (uint16_t)(length - ADPCM_HDR_BYTES);
+    bytes = (bytes > (ADPCM_BLOCK_SAMPLES / samples_per_byte[mode])) ? (uint16_t)(ADPCM_BLOCK_SAMPLES / samples_per_byte[mode]) : bytes;
+    samples = (uint16_t)(bytes * samples_per_byte[mode]);
+
+    /* 8 kHz samples go to the back half, for upsample() to spread out */
+    out = (mode == ADPCM_MODE_16K) ? pcm : &pcm[samples / 2U];
+
+    for (i = 0U; i < bytes; i++)
+    {
+        byte = block[ADPCM_HDR_BYTES + i];
+
+        if (mode == ADPCM_MODE_8K_2BIT)
+        {
+            for (code = 0U; code < 4U; code++)
+            {
+                decode_sample_2bit((uint8_t)(byte >> (2U * code)) & 0x03U, &predictor, &index);
+                *out++ = (int16_t)predictor;
+            }
+        }
+        else
+        {
+            decode_sample(byte & 0x0FU, &predictor, &index);
+            *out++ = (int16_t)predictor;
+            decode_sample(byte >> 4U, &predictor, &index);
+            *out++ = (int16_t)predictor;
+        }
+    }
+
+    if (mode != ADPCM_MODE_16K)
+    {
+        upsample(pcm, samples / 2U, state->predictor);
+    }
+
+    state->predictor = (int16_t)predictor;
+    state->step_index = (uint8_t)index;
+
+    return samples;
+}
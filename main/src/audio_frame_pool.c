@@ -0,0 +1,88 @@
+/**
+ ********************************************************************************
+ * @file    audio_frame_pool.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Static PCM frame pool and lock-free frame queues
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "audio_frame_pool.h"
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+_Static_assert((AUDIO_FRAME_POOL_FRAMES >= 1U) && (AUDIO_FRAME_POOL_FRAMES <= MEM_POOL_MAX_BLOCKS), "pool is tracked in one word");
+_Static_assert(AUDIO_FRAME_POOL_FRAMES <= AUDIO_FRAME_QUEUE_DEPTH, "queue must hold whole pool");
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void audio_frame_pool_init(AUDIO_FRAME_POOL_T* pool)
+{
+    (void)mem_pool_init(&pool->blocks, "audio", pool->frames, sizeof(AUDIO_FRAME_T), AUDIO_FRAME_POOL_FRAMES);
+}
+
+AUDIO_FRAME_T* audio_frame_pool_alloc(AUDIO_FRAME_POOL_T* pool)
+{
+    return (AUDIO_FRAME_T*)mem_pool_alloc(&pool->blocks);
+}
+
+void audio_frame_pool_free(AUDIO_FRAME_POOL_T* pool, AUDIO_FRAME_T* frame)
+{
+    mem_pool_free(&pool->blocks, frame);
+}
+
+uint32_t audio_frame_pool_available(AUDIO_FRAME_POOL_T* pool)
+{
+    return mem_pool_available(&pool->blocks);
+}
+
+void audio_frame_queue_init(AUDIO_FRAME_QUEUE_T* queue)
+{
+    atomic_init(&queue->head, 0U);
+    atomic_init(&queue->tail, 0U);
+}
+
+bool audio_frame_queue_push(AUDIO_FRAME_QUEUE_T* queue, AUDIO_FRAME_T* frame)
+{
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if ((head - tail) >= AUDIO_FRAME_QUEUE_DEPTH)
+    {
+        return false;
+    }
+
+    queue->slots[head & (AUDIO_FRAME_QUEUE_DEPTH - 1U)] = frame;
+    atomic_store_explicit(&queue->head, head + 1U, memory_order_release);
+
+    return true;
+}
+
+AUDIO_FRAME_T* audio_frame_queue_pop(AUDIO_FRAME_QUEUE_T* queue)
+{
+    uint32_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    AUDIO_FRAME_T* frame;
+
+    if (head == tail)
+    {
+        return NULL;
+    }
+
+    frame = queue->slots[tail & (AUDIO_FRAME_QUEUE_DEPTH - 1U)];
+    atomic_store_explicit(&queue->tail, tail + 1U, memory_order_release);
+
+    return frame;
+}
+
+uint32_t audio_frame_queue_count(AUDIO_FRAME_QUEUE_T* queue)
+{
+    return atomic_load_explicit(&queue->head, memory_order_acquire) -
+           atomic_load_explicit(&queue->tail, memory_order_acquire);
+}
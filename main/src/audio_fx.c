@@ -0,0 +1,250 @@
+/**
+ ********************************************************************************
+ * @file    audio_fx.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Fixed point voice effects
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "audio_fx.h"
+#include <string.h>
+#include <stddef.h>
+#include "timing.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define Q15_ONE_D (32768)
+
+/* phase step per sample for a frequency, phase wraps once per cycle */
+#define PHASE_INCREMENT_D(hz) ((uint32_t)(((uint64_t)(hz) << 32U) / AUDIO_SAMPLE_RATE_HZ))
+
+#define PITCH_LINE_MASK_D (AUDIO_FX_PITCH_LINE_SAMPLES - 1U)
+#define PITCH_WINDOW_Q16_D ((int32_t)(AUDIO_FX_PITCH_WINDOW_SAMPLES << 16U))
+#define PITCH_DELAY_STEP_Q16_D ((int32_t)AUDIO_FX_PITCH_RATIO_Q16 - 65536)
+
+_Static_assert((AUDIO_FX_PITCH_LINE_SAMPLES & PITCH_LINE_MASK_D) == 0U, "pitch line must be a power of 2");
+_Static_assert(AUDIO_FX_PITCH_WINDOW_SAMPLES < AUDIO_FX_PITCH_LINE_SAMPLES, "pitch line must hold a whole window");
+
+/*
+ * Chains. Each stage is an inline per sample function below, and DEFINE_CHAIN_D puts a chain's
+ * stages inside one loop over the frame, so a chain costs one call per frame and no indirect
+ * calls per sample. To add a chain, add it to AUDIO_FX_CHAIN_T and list its stages here
+ */
+#define STAGE_D(effect) sample = effect##_sample(&fx->effect, sample);
+
+#define CHAINS_D(CHAIN) \
+    CHAIN(AUDIO_FX_ROBOT, chain_robot, STAGE_D(ring_mod)) \
+    CHAIN(AUDIO_FX_ECHO, chain_echo, STAGE_D(echo)) \
+    CHAIN(AUDIO_FX_CHIPMUNK, chain_chipmunk, STAGE_D(pitch)) \
+    CHAIN(AUDIO_FX_TREMOLO, chain_tremolo, STAGE_D(tremolo)) \
+    CHAIN(AUDIO_FX_ROBOT_ECHO, chain_robot_echo, STAGE_D(ring_mod) STAGE_D(echo)) \
+    CHAIN(AUDIO_FX_CHIPMUNK_ECHO, chain_chipmunk_echo, STAGE_D(pitch) STAGE_D(echo)) \
+    CHAIN(AUDIO_FX_CHIPMUNK_TREMOLO, chain_chipmunk_tremolo, STAGE_D(pitch) STAGE_D(tremolo))
+
+#define DEFINE_CHAIN_D(id, function, stages) \
+    static void function(AUDIO_FX_T* fx, int16_t* pcm, uint16_t samples) \
+    { \
+        uint16_t i; \
+        int32_t sample; \
+        for (i = 0U; i < samples; i++) \
+        { \
+            sample = pcm[i]; \
+            stages \
+            pcm[i] = (int16_t)sample; \
+        } \
+    }
+
+#define CHAIN_ENTRY_D(id, function, stages) [id] = function,
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+typedef void (*CHAIN_FN_T)(AUDIO_FX_T* fx, int16_t* pcm, uint16_t samples);
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static inline int32_t saturate(int32_t sample);
+static inline int32_t sine_q15(uint32_t phase);
+static inline int32_t ring_mod_sample(AUDIO_FX_RING_MOD_T* ring_mod, int32_t sample);
+static inline int32_t echo_sample(AUDIO_FX_ECHO_T* echo, int32_t sample);
+static inline int32_t pitch_tap(const AUDIO_FX_PITCH_T* pitch, int32_t delay_q16);
+static inline int32_t pitch_sample(AUDIO_FX_PITCH_T* pitch, int32_t sample);
+static inline int32_t tremolo_sample(AUDIO_FX_TREMOLO_T* tremolo, int32_t sample);
+static void reset_effects(AUDIO_FX_T* fx);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static inline int32_t saturate(int32_t sample)
+{
+    if (sample > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    return (sample < INT16_MIN) ? INT16_MIN : sample;
+}
+
+/* sine of phase (a full turn is 2^32) in Q15. Parabola plus one correction step, within 0.1% */
+static inline int32_t sine_q15(uint32_t phase)
+{
+    int32_t x = (int32_t)phase >> 16;
+    int32_t y = (4 * x * (Q15_ONE_D - ((x < 0) ? -x : x))) >> 15;
+
+    y += (7373 * (((y * ((y < 0) ? -y : y)) >> 15) - y)) >> 15;
+
+    return (y > INT16_MAX) ? INT16_MAX : y;
+}
+
+static inline int32_t ring_mod_sample(AUDIO_FX_RING_MOD_T* ring_mod, int32_t sample)
+{
+    int32_t out = (sample * sine_q15(ring_mod->phase)) >> 15;
+
+    ring_mod->phase += ring_mod->increment;
+
+    return out;
+}
+
+static inline int32_t echo_sample(AUDIO_FX_ECHO_T* echo, int32_t sample)
+{
+    int32_t out = saturate(sample + ((echo->line[echo->position] * AUDIO_FX_ECHO_FEEDBACK_Q15) >> 15));
+
+    echo->line[echo->position] = (int16_t)out;
+    echo->position = ((echo->position + 1U) == AUDIO_FX_ECHO_SAMPLES) ? 0U : (echo->position + 1U);
+
+    return out;
+}
+
+/* line read delay_q16 samples back, linearly interpolated */
+static inline int32_t pitch_tap(const AUDIO_FX_PITCH_T* pitch, int32_t delay_q16)
+{
+    uint32_t newer = pitch->position - ((uint32_t)delay_q16 >> 16U);
+    int32_t a = pitch->line[newer & PITCH_LINE_MASK_D];
+    int32_t b = pitch->line[(newer - 1U) & PITCH_LINE_MASK_D];
+
+    return a + (((b - a) * ((delay_q16 & 0xFFFF) >> 1)) >> 15);
+}
+
+/* two grains read the line at a rate of ratio, half a window apart. Each fades in and out with a
+   triangle window, so the jump when a grain's delay wraps happens while it is silent */
+static inline int32_t pitch_sample(AUDIO_FX_PITCH_T* pitch, int32_t sample)
+{
+    int32_t delay1 = (int32_t)pitch->delay_q16;
+    int32_t delay2 = delay1 + (PITCH_WINDOW_Q16_D / 2);
+    int32_t distance;
+    int32_t gain1;
+    int32_t out;
+
+    if (delay2 >= PITCH_WINDOW_Q16_D)
+    {
+        delay2 -= PITCH_WINDOW_Q16_D;
+    }
+
+    pitch->line[pitch->position & PITCH_LINE_MASK_D] = (int16_t)sample;
+
+    /* 1 at half a window, 0 at either end. Gains of the two grains always add up to 1 */
+    distance = delay1 - (PITCH_WINDOW_Q16_D / 2);
+    distance = (distance < 0) ? -distance : distance;
+    gain1 = Q15_ONE_D - (distance / (int32_t)AUDIO_FX_PITCH_WINDOW_SAMPLES);
+
+    out = ((pitch_tap(pitch, delay1) * gain1) + (pitch_tap(pitch, delay2) * (Q15_ONE_D - gain1))) >> 15;
+
+    delay1 -= PITCH_DELAY_STEP_Q16_D;
+
+    if (delay1 < 0)
+    {
+        delay1 += PITCH_WINDOW_Q16_D;
+    }
+    else if (delay1 >= PITCH_WINDOW_Q16_D)
+    {
+        delay1 -= PITCH_WINDOW_Q16_D;
+    }
+
+    pitch->delay_q16 = (uint32_t)delay1;
+    pitch->position++;
+
+    return out;
+}
+
+/* gain swings between 1 and 1 - depth */
+static inline int32_t tremolo_sample(AUDIO_FX_TREMOLO_T* tremolo, int32_t sample)
+{
+    int32_t dip = (((Q15_ONE_D - sine_q15(tremolo->phase)) >> 1) * AUDIO_FX_TREMOLO_DEPTH_Q15) >> 15;
+
+    tremolo->phase += tremolo->increment;
+
+    return (sample * (Q15_ONE_D - dip)) >> 15;
+}
+
+CHAINS_D(DEFINE_CHAIN_D)
+
+static const CHAIN_FN_T chains[AUDIO_FX_CHAIN_COUNT] = {[AUDIO_FX_NONE] = NULL, CHAINS_D(CHAIN_ENTRY_D)};
+
+static void reset_effects(AUDIO_FX_T* fx)
+{
+    memset(&fx->ring_mod, 0, sizeof(fx->ring_mod));
+    memset(&fx->echo, 0, sizeof(fx->echo));
+    memset(&fx->pitch, 0, sizeof(fx->pitch));
+    memset(&fx->tremolo, 0, sizeof(fx->tremolo));
+
+    fx->ring_mod.increment = PHASE_INCREMENT_D(AUDIO_FX_RING_MOD_HZ);
+    fx->tremolo.increment = PHASE_INCREMENT_D(AUDIO_FX_TREMOLO_HZ);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void audio_fx_init(AUDIO_FX_T* fx)
+{
+    memset(fx->stats, 0, sizeof(fx->stats));
+    fx->chain = AUDIO_FX_NONE;
+    reset_effects(fx);
+}
+
+bool audio_fx_select(AUDIO_FX_T* fx, AUDIO_FX_CHAIN_T chain)
+{
+    if ((uint32_t)chain >= (uint32_t)AUDIO_FX_CHAIN_COUNT)
+    {
+        return false;
+    }
+
+    if (chain != fx->chain)
+    {
+        reset_effects(fx);
+        fx->chain = chain;
+    }
+
+    return true;
+}
+
+void audio_fx_process(AUDIO_FX_T* fx, int16_t* pcm, uint16_t samples)
+{
+    CHAIN_FN_T chain = chains[fx->chain];
+    AUDIO_FX_STATS_T* stats = &fx->stats[fx->chain];
+    uint32_t start;
+    uint32_t cycles;
+
+    if (chain == NULL)
+    {
+        return;
+    }
+
+    start = timing_get_cycles();
+    chain(fx, pcm, samples);
+    cycles = timing_get_cycles() - start;
+
+    stats->frames++;
+    stats->last_cycles = cycles;
+    stats->total_cycles += cycles;
+
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles;
+    }
+}
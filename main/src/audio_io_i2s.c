@@ -0,0 +1,327 @@
+/**
+ ********************************************************************************
+ * @file    audio_io_i2s.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   audio_io on target. Full duplex I2S to the WM8960 on DMA double buffers. The
+ *          driver moves samples between its DMA buffers and pool frames, that is the only
+ *          copy, after that frames only move by pointer
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "audio_io.h"
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/i2s_std.h"
+#include "esp_attr.h"
+#include "logging.h"
+#include "mem_report.h"
+#include "timing.h"
+#include "wm8960.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define TAG "AUDIO_IO"
+
+/* one DMA buffer is played or filled while the other is handed over */
+#define DMA_BUFFERS_D (2U)
+
+/* audio has to run ahead of the protocol task, otherwise the radio causes dropouts */
+#define AUDIO_TASK_PRIORITY_D (10U)
+#define AUDIO_TASK_STACK_BYTES_D (3072U)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static AUDIO_FRAME_POOL_T pool;
+static AUDIO_FRAME_QUEUE_T capture_queue;
+static AUDIO_FRAME_QUEUE_T playback_queue;
+
+/* captured samples are read here when no pool frame is free, so DMA keeps running */
+static int16_t discard_pcm[AUDIO_FRAME_SAMPLES];
+static const int16_t silence_pcm[AUDIO_FRAME_SAMPLES] = {0};
+
+static i2s_chan_handle_t tx_channel = NULL;
+static i2s_chan_handle_t rx_channel = NULL;
+static TaskHandle_t audio_task_handle = NULL;
+static SemaphoreHandle_t capture_ready;
+static StaticSemaphore_t capture_ready_buffer;
+
+static volatile bool running = false;
+static bool playing = false;
+static uint32_t capture_seq = 0U;
+
+static uint32_t frames_captured = 0U;
+static uint32_t frames_played = 0U;
+static atomic_uint_least32_t capture_overruns;
+static atomic_uint_least32_t playback_underruns;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static bool IRAM_ATTR on_recv_overflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* context);
+static bool IRAM_ATTR on_send_overflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* context);
+static void capture_frame(void);
+static void play_frame(void);
+static void drain_playback(void);
+static void audio_task(void* params);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* DMA filled a buffer nobody read in time */
+static bool IRAM_ATTR on_recv_overflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* context)
+{
+    atomic_fetch_add_explicit(&capture_overruns, 1U, memory_order_relaxed);
+    return false;
+}
+
+/* DMA ran out of samples to send, driver plays zeros */
+static bool IRAM_ATTR on_send_overflow(i2s_chan_handle_t handle, i2s_event_data_t* event, void* context)
+{
+    atomic_fetch_add_explicit(&playback_underruns, 1U, memory_order_relaxed);
+    return false;
+}
+
+static void capture_frame(void)
+{
+    AUDIO_FRAME_T* frame = audio_frame_pool_alloc(&pool);
+    int16_t* pcm = (frame != NULL) ? frame->pcm : discard_pcm;
+    size_t bytes_read = 0U;
+
+    /* blocks until DMA has a full buffer, this paces the task to one frame period */
+    if ((i2s_channel_read(rx_channel, pcm, AUDIO_FRAME_BYTES, &bytes_read, portMAX_DELAY) != ESP_OK) ||
+        (bytes_read != AUDIO_FRAME_BYTES) || (frame == NULL))
+    {
+        audio_frame_pool_free(&pool, frame);
+        atomic_fetch_add_explicit(&capture_overruns, 1U, memory_order_relaxed);
+        return;
+    }
+
+    frame->seq = capture_seq++;
+    frame->timestamp_us = timing_get_us() - AUDIO_FRAME_PERIOD_US;
+
+    if (!audio_frame_queue_push(&capture_queue, frame))
+    {
+        audio_frame_pool_free(&pool, frame);
+        atomic_fetch_add_explicit(&capture_overruns, 1U, memory_order_relaxed);
+        return;
+    }
+
+    frames_captured++;
+    xSemaphoreGive(capture_ready);
+}
+
+static void play_frame(void)
+{
+    AUDIO_FRAME_T* frame = audio_frame_queue_pop(&playback_queue);
+    size_t bytes_written = 0U;
+
+    /* keep DMA fed with silence so the next frame starts on time */
+    if (frame == NULL)
+    {
+        if (playing)
+        {
+            atomic_fetch_add_explicit(&playback_underruns, 1U, memory_order_relaxed);
+            playing = false;
+        }
+
+        (void)i2s_channel_write(tx_channel, silence_pcm, AUDIO_FRAME_BYTES, &bytes_written, portMAX_DELAY);
+        return;
+    }
+
+    playing = true;
+    (void)i2s_channel_write(tx_channel, frame->pcm, AUDIO_FRAME_BYTES, &bytes_written, portMAX_DELAY);
+    audio_frame_pool_free(&pool, frame);
+    frames_played++;
+}
+
+static void drain_playback(void)
+{
+    AUDIO_FRAME_T* frame;
+
+    while ((frame = audio_frame_queue_pop(&playback_queue)) != NULL)
+    {
+        audio_frame_pool_free(&pool, frame);
+    }
+}
+
+/* rx and tx share one clock, so one capture and one playback per pass keeps them in step */
+static void audio_task(void* params)
+{
+    while (true)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (running)
+        {
+            capture_frame();
+            play_frame();
+        }
+
+        i2s_channel_disable(tx_channel);
+        i2s_channel_disable(rx_channel);
+        drain_playback();
+        playing = false;
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+AUDIO_IO_ERR_T audio_io_init(void)
+{
+    i2s_chan_config_t channel_config = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM_AUTO, I2S_ROLE_MASTER);
+    i2s_std_config_t std_config = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(AUDIO_SAMPLE_RATE_HZ),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = CONFIG_AUDIO_I2S_MCLK_GPIO,
+            .bclk = CONFIG_AUDIO_I2S_BCLK_GPIO,
+            .ws = CONFIG_AUDIO_I2S_WS_GPIO,
+            .dout = CONFIG_AUDIO_I2S_DOUT_GPIO,
+            .din = CONFIG_AUDIO_I2S_DIN_GPIO,
+        },
+    };
+    i2s_event_callbacks_t rx_callbacks = {.on_recv_q_ovf = on_recv_overflow};
+    i2s_event_callbacks_t tx_callbacks = {.on_send_q_ovf = on_send_overflow};
+
+    if (audio_task_handle != NULL)
+    {
+        return AUDIO_IO_OK;
+    }
+
+    audio_frame_pool_init(&pool);
+    audio_frame_queue_init(&capture_queue);
+    audio_frame_queue_init(&playback_queue);
+    atomic_init(&capture_overruns, 0U);
+    atomic_init(&playback_underruns, 0U);
+    capture_ready = xSemaphoreCreateCountingStatic(AUDIO_FRAME_QUEUE_DEPTH, 0U, &capture_ready_buffer);
+
+    /* codec needs MCLK before it can be clocked, but takes its register writes without it */
+    if (!wm8960_init(CONFIG_AUDIO_I2C_SDA_GPIO, CONFIG_AUDIO_I2C_SCL_GPIO))
+    {
+        return AUDIO_IO_ERR_CODEC;
+    }
+
+    /* two DMA buffers of exactly one frame each, so every read and write is one whole buffer */
+    channel_config.dma_desc_num = DMA_BUFFERS_D;
+    channel_config.dma_frame_num = AUDIO_FRAME_SAMPLES;
+    channel_config.auto_clear = true;
+
+    if ((i2s_new_channel(&channel_config, &tx_channel, &rx_channel) != ESP_OK) ||
+        (i2s_channel_init_std_mode(tx_channel, &std_config) != ESP_OK) ||
+        (i2s_channel_init_std_mode(rx_channel, &std_config) != ESP_OK) ||
+        (i2s_channel_register_event_callback(rx_channel, &rx_callbacks, NULL) != ESP_OK) ||
+        (i2s_channel_register_event_callback(tx_channel, &tx_callbacks, NULL) != ESP_OK))
+    {
+        logging_log(LOG_LEVEL_ERROR, TAG, "i2s setup failed");
+        return AUDIO_IO_ERR_INIT;
+    }
+
+    if (xTaskCreate(audio_task, "audio_task", AUDIO_TASK_STACK_BYTES_D, NULL, AUDIO_TASK_PRIORITY_D, &audio_task_handle) != pdPASS)
+    {
+        return AUDIO_IO_ERR_INIT;
+    }
+
+    (void)mem_report_add_task(audio_task_handle);
+
+    return AUDIO_IO_OK;
+}
+
+AUDIO_IO_ERR_T audio_io_start(void)
+{
+    size_t bytes_loaded = 0U;
+
+    if (audio_task_handle == NULL)
+    {
+        return AUDIO_IO_ERR_NOT_STARTED;
+    }
+
+    if (running)
+    {
+        return AUDIO_IO_OK;
+    }
+
+    /* preload tx so playback starts with a full double buffer of silence */
+    (void)i2s_channel_preload_data(tx_channel, silence_pcm, AUDIO_FRAME_BYTES, &bytes_loaded);
+
+    if ((i2s_channel_enable(tx_channel) != ESP_OK) || (i2s_channel_enable(rx_channel) != ESP_OK))
+    {
+        return AUDIO_IO_ERR_INIT;
+    }
+
+    capture_seq = 0U;
+    running = true;
+    xTaskNotifyGive(audio_task_handle);
+
+    return AUDIO_IO_OK;
+}
+
+void audio_io_stop(void)
+{
+    /* audio task finishes its current frame, then disables channels and frees queued playback */
+    running = false;
+}
+
+AUDIO_FRAME_T* audio_io_capture_get(uint32_t timeout_ms)
+{
+    TickType_t ticks = (timeout_ms == AUDIO_IO_WAIT_FOREVER) ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+
+    if (xSemaphoreTake(capture_ready, ticks) != pdTRUE)
+    {
+        return NULL;
+    }
+
+    return audio_frame_queue_pop(&capture_queue);
+}
+
+AUDIO_FRAME_T* audio_io_frame_alloc(void)
+{
+    return audio_frame_pool_alloc(&pool);
+}
+
+AUDIO_IO_ERR_T audio_io_play(AUDIO_FRAME_T* frame)
+{
+    if (!running)
+    {
+        audio_frame_pool_free(&pool, frame);
+        return AUDIO_IO_ERR_NOT_STARTED;
+    }
+
+    if (!audio_frame_queue_push(&playback_queue, frame))
+    {
+        audio_frame_pool_free(&pool, frame);
+        return AUDIO_IO_ERR_FULL;
+    }
+
+    return AUDIO_IO_OK;
+}
+
+void audio_io_frame_release(AUDIO_FRAME_T* frame)
+{
+    audio_frame_pool_free(&pool, frame);
+}
+
+uint32_t audio_io_playback_queued(void)
+{
+    return audio_frame_queue_count(&playback_queue);
+}
+
+void audio_io_get_stats(AUDIO_IO_STATS_T* stats)
+{
+    stats->frames_captured = frames_captured;
+    stats->frames_played = frames_played;
+    stats->capture_overruns = atomic_load_explicit(&capture_overruns, memory_order_relaxed);
+    stats->playback_underruns = atomic_load_explicit(&playback_underruns, memory_order_relaxed);
+    stats->pool_high_water = atomic_load_explicit(&pool.blocks.high_water, memory_order_relaxed);
+    stats->pool_alloc_failures = atomic_load_explicit(&pool.blocks.alloc_failures, memory_order_relaxed);
+}
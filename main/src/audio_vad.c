@@ -0,0 +1,163 @@
+/**
+ ********************************************************************************
+ * @file    audio_vad.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Fixed point voice activity detection and comfort noise
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "audio_vad.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+
+/* floor never goes under this, so dither on a quiet input isn't taken for speech */
+#define MIN_FLOOR_D (8U)
+
+/* largest level a marker carries */
+#define MAX_SID_LEVEL_D (255U << AUDIO_VAD_SID_LEVEL_SHIFT)
+
+_Static_assert(AUDIO_VAD_HANGOVER_FRAMES < 256U, "hangover must fit in a byte");
+_Static_assert((AUDIO_VAD_SID_INTERVAL_FRAMES > 0U) && (AUDIO_VAD_SID_INTERVAL_FRAMES < 256U), "sid interval must fit in a byte");
+_Static_assert(AUDIO_VAD_VOICED_MARGIN_X4 <= AUDIO_VAD_OTHER_MARGIN_X4, "voiced frames need the lower margin");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void update_floor(AUDIO_VAD_T* vad, uint32_t level);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* drops straight to a quieter frame, as the quietest frames lately are background noise, and
+   creeps up otherwise, slow enough that a few seconds of talking barely move it */
+static void update_floor(AUDIO_VAD_T* vad, uint32_t level)
+{
+    if (level < vad->floor)
+    {
+        vad->floor = (level < MIN_FLOOR_D) ? MIN_FLOOR_D : level;
+    }
+    else
+    {
+        vad->floor += (vad->floor >> AUDIO_VAD_FLOOR_RISE_SHIFT) + 1U;
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void audio_vad_init(AUDIO_VAD_T* vad)
+{
+    memset(vad, 0, sizeof(*vad));
+    vad->floor = AUDIO_VAD_INITIAL_FLOOR;
+    vad->noise_level = AUDIO_VAD_INITIAL_FLOOR;
+}
+
+AUDIO_VAD_RESULT_T audio_vad_process(AUDIO_VAD_T* vad, const int16_t* pcm, uint16_t samples)
+{
+    int32_t threshold = (int32_t)vad->floor;
+    uint32_t sum = 0U;
+    uint32_t crossings = 0U;
+    uint32_t level;
+    uint32_t margin_x4;
+    bool negative = (samples > 0U) && (pcm[0] < 0);
+    uint16_t i;
+
+    /* a crossing counts once the signal swings past the noise floor the other way, so hiss
+       riding on a vowel doesn't add crossings of its own */
+    for (i = 0U; i < samples; i++)
+    {
+        sum += (uint32_t)((pcm[i] < 0) ? -(int32_t)pcm[i] : pcm[i]);
+
+        if (negative ? (pcm[i] > threshold) : (pcm[i] < -threshold))
+        {
+            negative = !negative;
+            crossings++;
+        }
+    }
+
+    level = (samples > 0U) ? (sum / samples) : 0U;
+    margin_x4 = (samples > 0U) && (((crossings << 10U) / samples) < AUDIO_VAD_VOICED_CROSSINGS_PER_1024) ?
+                AUDIO_VAD_VOICED_MARGIN_X4 : AUDIO_VAD_OTHER_MARGIN_X4;
+
+    vad->stats.frames++;
+
+    if ((level << 2U) > (vad->floor * margin_x4))
+    {
+        update_floor(vad, level);
+        vad->hangover = (uint8_t)AUDIO_VAD_HANGOVER_FRAMES;
+        vad->silent = false;
+        vad->stats.speech++;
+        return AUDIO_VAD_SPEECH;
+    }
+
+    update_floor(vad, level);
+    vad->noise_level = (uint32_t)((int32_t)vad->noise_level + (((int32_t)level - (int32_t)vad->noise_level) / 4));
+
+    if (vad->hangover > 0U)
+    {
+        vad->hangover--;
+        vad->stats.hangover++;
+        return AUDIO_VAD_SPEECH;
+    }
+
+    /* a marker as silence starts, then one a while to keep the far end's noise going */
+    if (!vad->silent || (++vad->since_sid >= AUDIO_VAD_SID_INTERVAL_FRAMES))
+    {
+        vad->silent = true;
+        vad->since_sid = 0U;
+        vad->stats.sids++;
+        return AUDIO_VAD_SID;
+    }
+
+    vad->stats.suppressed++;
+
+    return AUDIO_VAD_SILENCE;
+}
+
+uint16_t audio_vad_sid(const AUDIO_VAD_T* vad, uint8_t* out)
+{
+    uint32_t level = (vad->noise_level > MAX_SID_LEVEL_D) ? MAX_SID_LEVEL_D : vad->noise_level;
+
+    out[0] = AUDIO_VAD_SID_MAGIC;
+    out[1] = (uint8_t)(level >> AUDIO_VAD_SID_LEVEL_SHIFT);
+
+    return AUDIO_VAD_SID_BYTES;
+}
+
+bool audio_vad_parse_sid(const uint8_t* block, uint16_t length, uint16_t* level)
+{
+    if ((length != AUDIO_VAD_SID_BYTES) || (block[0] != AUDIO_VAD_SID_MAGIC))
+    {
+        return false;
+    }
+
+    *level = (uint16_t)((uint16_t)block[1] << AUDIO_VAD_SID_LEVEL_SHIFT);
+
+    return true;
+}
+
+/* xorshift32, its top 16 bits as a uniform sample. Uniform noise from -a to a has a mean
+   absolute amplitude of a / 2, so the sample is scaled by 2 * level / 32768 */
+void audio_vad_comfort_noise(uint32_t* seed, uint16_t level, int16_t* pcm, uint16_t samples)
+{
+    uint32_t x = *seed;
+    uint16_t i;
+
+    for (i = 0U; i < samples; i++)
+    {
+        x ^= x << 13U;
+        x ^= x >> 17U;
+        x ^= x << 5U;
+        pcm[i] = (int16_t)(((int32_t)(int16_t)(x >> 16U) * (int32_t)level) >> 14);
+    }
+
+    *seed = x;
+}
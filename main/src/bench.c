@@ -0,0 +1,181 @@
+/**
+ ********************************************************************************
+ * @file    bench.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Latency histograms and machine readable benchmark results
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "bench.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SUB_BITS_D (3U)
+#define US_PER_S_D (1000000ULL)
+
+_Static_assert(BENCH_HIST_SUB_BUCKETS == (1U << SUB_BITS_D), "sub buckets must match SUB_BITS_D");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t bucket_of(uint32_t value);
+static uint32_t bucket_top(uint32_t bucket);
+static uint32_t append(char* out, uint32_t size, uint32_t length, const char* format, ...);
+static uint32_t append_hist(char* out, uint32_t size, uint32_t length, const char* name, const BENCH_HIST_T* hist);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* exact below BENCH_HIST_SUB_BUCKETS, then BENCH_HIST_SUB_BUCKETS buckets per power of 2 */
+static uint32_t bucket_of(uint32_t value)
+{
+    uint32_t msb;
+
+    if (value < BENCH_HIST_SUB_BUCKETS)
+    {
+        return value;
+    }
+
+    msb = 31U - (uint32_t)__builtin_clz(value);
+
+    return ((msb - (SUB_BITS_D - 1U)) * BENCH_HIST_SUB_BUCKETS) +
+           ((value >> (msb - SUB_BITS_D)) & (BENCH_HIST_SUB_BUCKETS - 1U));
+}
+
+/* largest value that lands in bucket */
+static uint32_t bucket_top(uint32_t bucket)
+{
+    uint32_t shift;
+    uint32_t low;
+
+    if (bucket < BENCH_HIST_SUB_BUCKETS)
+    {
+        return bucket;
+    }
+
+    shift = (bucket / BENCH_HIST_SUB_BUCKETS) - 1U;
+    low = (BENCH_HIST_SUB_BUCKETS + (bucket % BENCH_HIST_SUB_BUCKETS)) << shift;
+
+    return low + ((1UL << shift) - 1U);
+}
+
+/* snprintf onto the end of out, never past size */
+static uint32_t append(char* out, uint32_t size, uint32_t length, const char* format, ...)
+{
+    va_list args;
+    int written;
+
+    if (length >= size)
+    {
+        return length;
+    }
+
+    va_start(args, format);
+    written = vsnprintf(&out[length], size - length, format, args);
+    va_end(args);
+
+    if (written < 0)
+    {
+        return length;
+    }
+
+    length += (uint32_t)written;
+
+    return (length >= size) ? (size - 1U) : length;
+}
+
+static uint32_t append_hist(char* out, uint32_t size, uint32_t length, const char* name, const BENCH_HIST_T* hist)
+{
+    if ((hist == NULL) || (hist->count == 0U))
+    {
+        return length;
+    }
+
+    return append(out, size, length, ",\"%s\":{\"n\":%lu,\"min\":%lu,\"mean\":%lu,\"p50\":%lu,\"p90\":%lu,\"p99\":%lu,\"max\":%lu}",
+                  name, (unsigned long)hist->count, (unsigned long)hist->min,
+                  (unsigned long)(hist->sum / hist->count), (unsigned long)bench_hist_percentile(hist, 500U),
+                  (unsigned long)bench_hist_percentile(hist, 900U), (unsigned long)bench_hist_percentile(hist, 990U),
+                  (unsigned long)hist->max);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void bench_hist_init(BENCH_HIST_T* hist)
+{
+    memset(hist, 0, sizeof(*hist));
+    hist->min = UINT32_MAX;
+}
+
+void bench_hist_add(BENCH_HIST_T* hist, uint32_t value)
+{
+    hist->buckets[bucket_of(value)]++;
+    hist->count++;
+    hist->sum += value;
+    hist->min = (value < hist->min) ? value : hist->min;
+    hist->max = (value > hist->max) ? value : hist->max;
+}
+
+uint32_t bench_hist_percentile(const BENCH_HIST_T* hist, uint32_t permille)
+{
+    uint64_t rank;
+    uint64_t seen = 0U;
+    uint32_t top;
+    uint32_t i;
+
+    if (hist->count == 0U)
+    {
+        return 0U;
+    }
+
+    /* nearest rank, so p50 of 1..10 is 5 */
+    rank = (((uint64_t)hist->count * permille) + 999U) / 1000U;
+    rank = (rank == 0U) ? 1U : rank;
+
+    for (i = 0U; i < BENCH_HIST_BUCKETS; i++)
+    {
+        seen += hist->buckets[i];
+
+        if (seen >= rank)
+        {
+            top = bucket_top(i);
+            return (top > hist->max) ? hist->max : ((top < hist->min) ? hist->min : top);
+        }
+    }
+
+    return hist->max;
+}
+
+uint32_t bench_format_result(const BENCH_RESULT_T* result, char* out, uint32_t size)
+{
+    uint64_t elapsed = (result->elapsed_us > 0U) ? result->elapsed_us : 1U;
+    uint32_t length = 0U;
+
+    if (size == 0U)
+    {
+        return 0U;
+    }
+
+    out[0] = '\0';
+
+    length = append(out, size, length,
+                    BENCH_LINE_PREFIX "{\"bench\":\"%s\",\"link\":\"%s\",\"payload\":%lu,\"sent\":%lu,\"received\":%lu,"
+                    "\"elapsed_us\":%lu,\"per_s\":%lu,\"goodput_bps\":%llu",
+                    result->name, result->link, (unsigned long)result->payload_bytes, (unsigned long)result->sent,
+                    (unsigned long)result->received, (unsigned long)result->elapsed_us,
+                    (unsigned long)(((uint64_t)result->received * US_PER_S_D) / elapsed),
+                    (unsigned long long)((result->bytes * 8U * US_PER_S_D) / elapsed));
+    length = append_hist(out, size, length, "latency_us", result->latency);
+    length = append_hist(out, size, length, "rtt_us", result->rtt);
+
+    return append(out, size, length, "}");
+}
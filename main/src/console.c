@@ -0,0 +1,186 @@
+/**
+ ********************************************************************************
+ * @file    console.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Assembles console input into lines and runs commands
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "console.h"
+#include <stdio.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define BACKSPACE_D (0x08U)
+#define DELETE_D (0x7FU)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static const CONSOLE_COMMAND_T* commands[CONSOLE_MAX_COMMANDS];
+static uint32_t command_count = 0U;
+static char line[CONSOLE_LINE_BYTES + 1U];
+static uint32_t line_length = 0U;
+static bool line_too_long = false;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void print_help(uint32_t argc, char** argv);
+static const CONSOLE_COMMAND_T* find(const char* name);
+static uint32_t split(char* text, char** argv);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void print_help(uint32_t argc, char** argv)
+{
+    uint32_t i;
+
+    for (i = 0U; i < command_count; i++)
+    {
+        printf("%-10s %s\n", commands[i]->name, commands[i]->help);
+    }
+}
+
+static const CONSOLE_COMMAND_T* find(const char* name)
+{
+    uint32_t i;
+
+    for (i = 0U; i < command_count; i++)
+    {
+        if (strcmp(commands[i]->name, name) == 0)
+        {
+            return commands[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* splits text in place on spaces and tabs */
+static uint32_t split(char* text, char** argv)
+{
+    uint32_t argc = 0U;
+
+    while (*text != '\0')
+    {
+        while ((*text == ' ') || (*text == '\t'))
+        {
+            *text++ = '\0';
+        }
+
+        if (*text == '\0')
+        {
+            break;
+        }
+
+        if (argc == CONSOLE_MAX_ARGS)
+        {
+            break;
+        }
+
+        argv[argc++] = text;
+
+        while ((*text != '\0') && (*text != ' ') && (*text != '\t'))
+        {
+            text++;
+        }
+    }
+
+    return argc;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void console_init(void)
+{
+    static const CONSOLE_COMMAND_T help_command = {"help", "lists commands", print_help};
+
+    command_count = 0U;
+    line_length = 0U;
+    line_too_long = false;
+    (void)console_register(&help_command);
+}
+
+bool console_register(const CONSOLE_COMMAND_T* command)
+{
+    if ((command_count >= CONSOLE_MAX_COMMANDS) || (find(command->name) != NULL))
+    {
+        return false;
+    }
+
+    commands[command_count++] = command;
+
+    return true;
+}
+
+void console_feed(const uint8_t* data, uint32_t length)
+{
+    uint32_t i;
+    uint8_t byte;
+
+    for (i = 0U; i < length; i++)
+    {
+        byte = data[i];
+
+        if ((byte == '\r') || (byte == '\n'))
+        {
+            if (line_too_long)
+            {
+                printf("line too long\n");
+            }
+            else if (line_length > 0U)
+            {
+                line[line_length] = '\0';
+                (void)console_execute(line);
+            }
+
+            line_length = 0U;
+            line_too_long = false;
+        }
+        else if ((byte == BACKSPACE_D) || (byte == DELETE_D))
+        {
+            line_length = (line_length > 0U) ? (line_length - 1U) : 0U;
+        }
+        else if (line_length < CONSOLE_LINE_BYTES)
+        {
+            line[line_length++] = (char)byte;
+        }
+        else
+        {
+            line_too_long = true;
+        }
+    }
+}
+
+bool console_execute(char* text)
+{
+    char* argv[CONSOLE_MAX_ARGS];
+    const CONSOLE_COMMAND_T* command;
+    uint32_t argc = split(text, argv);
+
+    if (argc == 0U)
+    {
+        return false;
+    }
+
+    command = find(argv[0]);
+
+    if (command == NULL)
+    {
+        printf("unknown command %s, try help\n", argv[0]);
+        return false;
+    }
+
+    command->handler(argc, argv);
+
+    return true;
+}
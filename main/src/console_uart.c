@@ -0,0 +1,90 @@
+/**
+ ********************************************************************************
+ * @file    console_uart.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Feeds the console from the UART the IDF console prints on
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "console.h"
+#include "sdkconfig.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "logging.h"
+#include "mem_report.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define TAG "CONSOLE"
+
+#ifdef CONFIG_ESP_CONSOLE_UART_NUM
+#define CONSOLE_UART_D (CONFIG_ESP_CONSOLE_UART_NUM)
+#else
+#define CONSOLE_UART_D (UART_NUM_0)
+#endif
+
+/* commands are typed by hand, so this only has to hold a pasted line or two */
+#define RX_BUFFER_BYTES_D (256U)
+#define READ_BYTES_D (32U)
+#define READ_TIMEOUT_MS_D (20U)
+
+/* same as the logging task. Commands run here, so anything long should hand off to its own task */
+#define CONSOLE_TASK_PRIORITY_D (tskIDLE_PRIORITY + 1U)
+#define CONSOLE_TASK_STACK_BYTES_D (3072U)
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void console_task(void* params);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void console_task(void* params)
+{
+    uint8_t buffer[READ_BYTES_D];
+    int length;
+
+    while (1U)
+    {
+        /* returns what arrived so far once the timeout passes, so a line is handled as soon as it ends */
+        length = uart_read_bytes(CONSOLE_UART_D, buffer, sizeof(buffer), pdMS_TO_TICKS(READ_TIMEOUT_MS_D));
+
+        if (length > 0)
+        {
+            console_feed(buffer, (uint32_t)length);
+        }
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool console_uart_start(void)
+{
+    TaskHandle_t task;
+
+    /* output still goes through the IDF console, the driver is only needed to read */
+    if (!uart_is_driver_installed(CONSOLE_UART_D) &&
+        (uart_driver_install(CONSOLE_UART_D, RX_BUFFER_BYTES_D, 0, 0, NULL, 0) != ESP_OK))
+    {
+        logging_log(LOG_LEVEL_ERROR, TAG, "uart driver install failed, console disabled");
+        return false;
+    }
+
+    if (xTaskCreate(console_task, "console_task", CONSOLE_TASK_STACK_BYTES_D, NULL, CONSOLE_TASK_PRIORITY_D, &task) != pdPASS)
+    {
+        logging_log(LOG_LEVEL_ERROR, TAG, "console task setup failed");
+        return false;
+    }
+
+    (void)mem_report_add_task(task);
+
+    return true;
+}
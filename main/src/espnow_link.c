@@ -17,8 +17,14 @@
 #include "esp_mac.h"
 #include <stdio.h>
 #include <string.h>
+#include <stdatomic.h>
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "logging.h"
+#include "metrics.h"
+#include "timing.h"
 
 /************************************
  * PRIVATE MACROS AND DEFINES
@@ -26,28 +32,164 @@
 #define TAG "ESPNOW_LINK"
 #define MAC_LENGTH_BYTES_D (6U)
 
+/* how often a blocking write re-checks its frame in case its semaphore give was consumed by a stale waiter */
+#define BLOCKING_WRITE_RECHECK_MS_D (10U)
+
+#ifdef CONFIG_ESPNOW_RX_DROP_OLDEST
+#define RX_OVERFLOW_POLICY_D ESPNOW_LINK_RING_DROP_OLDEST
+#else
+#define RX_OVERFLOW_POLICY_D ESPNOW_LINK_RING_DROP_NEWEST
+#endif
+
+/* wakes at window edges and when a held frame's peer wakes, so it runs above the protocol task */
+#define PS_TASK_STACK_BYTES_D (3072U)
+#define PS_TASK_PRIORITY_D (2U)
+
+/* a wake window longer than the wake interval keeps the radio on */
+#define RADIO_ALWAYS_ON_WINDOW_D (0xFFFFU)
+
+/* nothing to wake up for */
+#define PS_NO_WAIT_D (0xFFFFFFFFU)
+
+/* esp now refused a held frame, likely out of buffers for a moment */
+#define PS_RETRY_US_D (2000U)
+
+#ifdef CONFIG_ESPNOW_ENABLE_LONG_RANGE
+#define LONG_RANGE_D (true)
+#else
+#define LONG_RANGE_D (false)
+#endif
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+
+/* how the radio is told to send at a rate */
+typedef struct
+{
+    wifi_phy_mode_t phymode;
+    wifi_phy_rate_t rate;
+} PHY_RATE_T;
+
+/* result of a blocking write, filled in from send callback */
+typedef struct
+{
+    volatile bool done;
+    volatile bool success;
+} BLOCKING_WRITE_T;
+
 /************************************
  * STATIC VARIABLES
  ************************************/
 static uint8_t device_mac[MAC_LENGTH_BYTES_D];
-static bool send_callback_called = false;
-static esp_now_send_status_t send_status = ESP_NOW_SEND_SUCCESS;
-static ESPNOW_LINK_MSG_QUEUE_T message_receive_queue;
+static ESPNOW_LINK_TX_TRACKER_T tx_tracker;
+static SemaphoreHandle_t tx_mutex;
+static StaticSemaphore_t tx_mutex_buffer;
+static SemaphoreHandle_t tx_done_semaphores[ESPNOW_LINK_TX_MAX_IN_FLIGHT];
+static StaticSemaphore_t tx_done_semaphore_buffers[ESPNOW_LINK_TX_MAX_IN_FLIGHT];
+static ESPNOW_LINK_RING_T rx_ring;
+static uint32_t rx_ring_storage[ESPNOW_LINK_RX_RING_BYTES / sizeof(uint32_t)]; /* uint32_t keeps ring aligned */
+static uint32_t frames_received = 0U;
+static volatile TaskHandle_t rx_waiting_task = NULL;
+static atomic_bool rx_wake_requested = false;
+
+/* when each in flight frame was written, for the send latency metric. Includes time held */
+static uint32_t tx_sent_us[ESPNOW_LINK_TX_MAX_IN_FLIGHT];
+
+/* power save. The receive callback updates peer schedules, so ps is only touched inside ps_lock */
+static const uint8_t broadcast_mac[MAC_LENGTH_BYTES_D] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+static ESPNOW_LINK_PS_T ps;
+static portMUX_TYPE ps_lock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t ps_task_handle = NULL;
+static volatile ESPNOW_LINK_POWER_MODE_T power_mode = ESPNOW_LINK_POWER_ALWAYS_ON;
+static volatile uint32_t hold_awake_until_us = 0U;
+static volatile bool hold_awake_started = false;
+static ESPNOW_LINK_POWER_STATS_T power_stats;
+
+/* frames held for a peer's wake window, in write order. info.src_mac holds the destination.
+   Only touched with tx_mutex taken */
+static ESPNOW_LINK_RING_T tx_hold;
+static uint32_t tx_hold_storage[ESPNOW_LINK_TX_HOLD_BYTES / sizeof(uint32_t)];
+static ESPNOW_LINK_MSG_T tx_hold_head;
+static bool tx_hold_head_valid = false;
+static uint32_t tx_held = 0U;
+
+/* channel quality. The callbacks feed the monitor and any survey running, so both are only
+   touched inside chan_lock */
+static portMUX_TYPE chan_lock = portMUX_INITIALIZER_UNLOCKED;
+static ESPNOW_LINK_CHAN_MONITOR_T chan_monitor;
+static ESPNOW_LINK_CHAN_SURVEY_T* chan_survey = NULL;
+static uint8_t survey_channel = 0U;
+static uint8_t wifi_channel = ESPNOW_LINK_CHAN_DEFAULT;
+static uint32_t channel_switches = 0U;
+
+/* rate per peer. Picked by the sending tasks, fed by both callbacks, so only touched inside rate_lock */
+static portMUX_TYPE rate_lock = portMUX_INITIALIZER_UNLOCKED;
+static ESPNOW_LINK_RATE_TABLE_T rate_table;
+
+static const PHY_RATE_T phy_rates[ESPNOW_LINK_RATE_COUNT] = {
+    [ESPNOW_LINK_RATE_LR_250K] = {WIFI_PHY_MODE_LR, WIFI_PHY_RATE_LORA_250K},
+    [ESPNOW_LINK_RATE_LR_500K] = {WIFI_PHY_MODE_LR, WIFI_PHY_RATE_LORA_500K},
+    [ESPNOW_LINK_RATE_1M] = {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_1M_L},
+    [ESPNOW_LINK_RATE_2M] = {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_2M_S},
+    [ESPNOW_LINK_RATE_5M5] = {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_5M_S},
+    [ESPNOW_LINK_RATE_11M] = {WIFI_PHY_MODE_11B, WIFI_PHY_RATE_11M_S},
+    [ESPNOW_LINK_RATE_24M] = {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_24M},
+    [ESPNOW_LINK_RATE_36M] = {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_36M},
+    [ESPNOW_LINK_RATE_54M] = {WIFI_PHY_MODE_11G, WIFI_PHY_RATE_54M}
+};
 
 /************************************
  * STATIC FUNCTION PROTOTYPES
  ************************************/
 void espnow_send_callback(const uint8_t* mac_addr, esp_now_send_status_t status);
 void espnow_receive_callback(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, int data_len);
-void send_message_to_peer(const uint8_t* peer_mac, const uint8_t* message, uint16_t message_length);
+esp_err_t send_message_to_peer(const uint8_t* peer_mac, const uint8_t* message, uint16_t message_length);
+void blocking_write_done(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context);
+static uint32_t peer_wait_us(const uint8_t* peer_mac, uint32_t now_us);
+static ESPNOW_LINK_ERR_T hold_frame(const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length, uint32_t now_us);
+static uint32_t send_held(uint32_t now_us);
+static void set_radio_on(bool on);
+static void account_time(ESPNOW_LINK_POWER_MODE_T mode, bool radio_on, uint32_t elapsed_us);
+static void ps_task(void* params);
+static void promiscuous_callback(void* buf, wifi_promiscuous_pkt_type_t type);
+static TickType_t ms_to_ticks(uint32_t ms);
 
 /************************************
  * STATIC FUNCTIONS
  ************************************/
 void espnow_send_callback(const uint8_t* mac_addr, esp_now_send_status_t status)
 {
-    send_callback_called = true;
-    send_status = status;
+    ESPNOW_LINK_TX_COMPLETION_T completion;
+    bool success = (status == ESP_NOW_SEND_SUCCESS);
+
+    /* results arrive in send order, so this is the oldest frame in flight */
+    metrics_inc(success ? METRIC_LINK_TX_ACKED : METRIC_LINK_TX_FAILED);
+
+    /* nothing acks a broadcast, so only unicast results say how the channel is doing */
+    if (memcmp(mac_addr, broadcast_mac, MAC_LENGTH_BYTES_D) != 0)
+    {
+        taskENTER_CRITICAL(&chan_lock);
+        espnow_link_chan_on_tx(&chan_monitor, success);
+        taskEXIT_CRITICAL(&chan_lock);
+
+        taskENTER_CRITICAL(&rate_lock);
+        espnow_link_rate_on_tx(&rate_table, mac_addr, success);
+        taskEXIT_CRITICAL(&rate_lock);
+    }
+
+    if (espnow_link_tx_complete(&tx_tracker, mac_addr, success, &completion))
+    {
+        metrics_timer_add(METRIC_TIMER_LINK_SEND, timing_get_us() - tx_sent_us[completion.slot_index]);
+
+        if (completion.callback != NULL)
+        {
+            completion.callback(completion.handle, success, completion.context);
+        }
+
+        /* give after callback so blocking writers see their result when they wake */
+        xSemaphoreGive(tx_done_semaphores[completion.slot_index]);
+    }
 
     switch (status)
     {
@@ -63,39 +205,369 @@ void espnow_send_callback(const uint8_t* mac_addr, esp_now_send_status_t status)
     }
 }
 
-void enqueue(ESPNOW_LINK_MSG_T msg)
+void espnow_receive_callback(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, int data_len)
 {
-    message_receive_queue.array[message_receive_queue.tail_index] = msg;
+    ESPNOW_LINK_RX_DESC_T desc;
+    uint32_t dropped_oldest;
+    uint32_t now_us;
+    bool beacon;
+    bool pushed;
+
+    logging_log(LOG_LEVEL_VERBOSE, TAG, "Received message from mac " MACSTR, MAC2STR(esp_now_info->src_addr));
+
+    if ((data_len < 0) || (data_len > (int)ESPNOW_DATA_BYTES))
+    {
+        return;
+    }
 
-    message_receive_queue.tail_index = (message_receive_queue.tail_index + 1U) % ESPNOW_LINK_QUEUE_LENGTH;
+    now_us = timing_get_us();
+
+    taskENTER_CRITICAL(&chan_lock);
+    espnow_link_chan_on_rx(&chan_monitor, esp_now_info->rx_ctrl->rssi, esp_now_info->rx_ctrl->noise_floor);
+    taskEXIT_CRITICAL(&chan_lock);
+
+    taskENTER_CRITICAL(&rate_lock);
+    espnow_link_rate_on_rx(&rate_table, esp_now_info->src_addr, esp_now_info->rx_ctrl->rssi, now_us / 1000U);
+    taskEXIT_CRITICAL(&rate_lock);
+
+    /* beacons are the link's own, nothing above sees them */
+    if (data_len == (int)ESPNOW_LINK_PS_BEACON_BYTES)
+    {
+        taskENTER_CRITICAL(&ps_lock);
+        beacon = espnow_link_ps_on_beacon(&ps, esp_now_info->src_addr, data, (uint16_t)data_len, now_us);
+        taskEXIT_CRITICAL(&ps_lock);
+
+        if (beacon)
+        {
+            power_stats.beacons_heard++;
+
+            /* frames held for this peer may be able to go now */
+            if (ps_task_handle != NULL)
+            {
+                xTaskNotifyGive(ps_task_handle);
+            }
+
+            return;
+        }
+    }
+
+    /* someone is talking to us, stay on instead of only listening in windows */
+    if (power_mode == ESPNOW_LINK_POWER_SAVE)
+    {
+        if (((int32_t)(hold_awake_until_us - now_us) <= 0) && (ps_task_handle != NULL))
+        {
+            hold_awake_started = true;
+            xTaskNotifyGive(ps_task_handle);
+        }
+
+        hold_awake_until_us = now_us + (ESPNOW_LINK_PS_HOLD_AWAKE_MS * 1000U);
+    }
+
+    /* only the descriptor and data_len bytes go into the ring, no padding and no full recv_info */
+    memcpy(desc.src_mac, esp_now_info->src_addr, MAC_LENGTH_BYTES_D);
+    desc.rssi = esp_now_info->rx_ctrl->rssi;
+    desc.noise_floor = esp_now_info->rx_ctrl->noise_floor;
+    desc.timestamp_us = esp_now_info->rx_ctrl->timestamp;
+    desc.data_len = (uint16_t)data_len;
+    desc.reserved2 = 0U;
+
+    /* this callback is the only producer, so a plain increment is fine */
+    frames_received++;
+    metrics_inc(METRIC_LINK_RX_FRAMES);
+    metrics_peer_rssi(desc.src_mac, desc.rssi);
+
+    /* a full ring either refuses the frame or, with DROP_OLDEST, discards older ones to fit it */
+    dropped_oldest = atomic_load_explicit(&rx_ring.dropped_oldest, memory_order_relaxed);
+    pushed = espnow_link_ring_push(&rx_ring, &desc, data);
+
+    if (!pushed || (atomic_load_explicit(&rx_ring.dropped_oldest, memory_order_relaxed) != dropped_oldest))
+    {
+        metrics_inc(METRIC_LINK_RX_OVERFLOWS);
+    }
+
+    if (pushed)
+    {
+        metrics_gauge_max(METRIC_LINK_RX_QUEUE_HWM, espnow_link_ring_used_bytes(&rx_ring));
+
+        TaskHandle_t waiting_task = rx_waiting_task;
+
+        /* only pay for a notification when a reader is actually asleep */
+        if (waiting_task != NULL)
+        {
+            xTaskNotifyGive(waiting_task);
+        }
+    }
 }
 
-ESPNOW_LINK_MSG_T dequeue(void)
+esp_err_t send_message_to_peer(const uint8_t* peer_mac, const uint8_t* message, uint16_t message_length)
 {
-    ESPNOW_LINK_MSG_T retval;
+#ifdef CONFIG_ESPNOW_RATE_ADAPTATION
+    esp_now_rate_config_t config = {0};
+    ESPNOW_LINK_RATE_T rate;
+    bool reconfigure;
+    esp_err_t ret;
+
+    /* broadcasts go at the default rate, every unit has to hear them */
+    if (memcmp(peer_mac, broadcast_mac, MAC_LENGTH_BYTES_D) == 0)
+    {
+        return esp_now_send(peer_mac, message, message_length);
+    }
 
-    retval = message_receive_queue.array[message_receive_queue.head_index];
-    message_receive_queue.head_index = (message_receive_queue.head_index + 1U) % ESPNOW_LINK_QUEUE_LENGTH;
+    taskENTER_CRITICAL(&rate_lock);
+    rate = espnow_link_rate_select(&rate_table, peer_mac, timing_get_ms(), &reconfigure);
+    taskEXIT_CRITICAL(&rate_lock);
 
-    return retval;
+    /* the radio keeps each peer's rate, so it is only set when it changes */
+    if (reconfigure)
+    {
+        config.phymode = phy_rates[rate].phymode;
+        config.rate = phy_rates[rate].rate;
+        (void)esp_now_set_peer_rate_config(peer_mac, &config);
+    }
+
+    ret = esp_now_send(peer_mac, message, message_length);
+
+    if (ret != ESP_OK)
+    {
+        taskENTER_CRITICAL(&rate_lock);
+        espnow_link_rate_cancel(&rate_table, peer_mac);
+        taskEXIT_CRITICAL(&rate_lock);
+    }
+
+    return ret;
+#else
+    return esp_now_send(peer_mac, message, message_length);
+#endif
 }
 
-void espnow_receive_callback(const esp_now_recv_info_t* esp_now_info, const uint8_t* data, int data_len)
+void blocking_write_done(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context)
 {
-    ESPNOW_LINK_MSG_T msg;
+    BLOCKING_WRITE_T* result = (BLOCKING_WRITE_T*)context;
 
-    logging_log(LOG_LEVEL_VERBOSE, TAG, "Received message from mac " MACSTR, MAC2STR(esp_now_info->src_addr));
+    result->success = success;
+    result->done = true;
+}
+
+static uint32_t peer_wait_us(const uint8_t* peer_mac, uint32_t now_us)
+{
+    uint32_t wait_us;
+
+    taskENTER_CRITICAL(&ps_lock);
+    wait_us = espnow_link_ps_wait_us(&ps, peer_mac, now_us);
+    taskEXIT_CRITICAL(&ps_lock);
+
+    return wait_us;
+}
+
+/* tx_mutex taken. Keeps frame for ps_task to send once its peer wakes */
+static ESPNOW_LINK_ERR_T hold_frame(const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length, uint32_t now_us)
+{
+    ESPNOW_LINK_RX_DESC_T desc;
+
+    /* held frames can't be refused later without breaking send callback order, so refuse
+       what esp_now_send() would refuse now */
+    if (!esp_now_is_peer_exist(peer_mac))
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    memset(&desc, 0, sizeof(desc));
+    memcpy(desc.src_mac, peer_mac, MAC_LENGTH_BYTES_D);
+    desc.timestamp_us = now_us;
+    desc.data_len = data_length;
+
+    if (!espnow_link_ring_push(&tx_hold, &desc, data))
+    {
+        return ESPNOW_LINK_ERR_BUSY;
+    }
+
+    tx_held++;
+    power_stats.modes[power_mode].frames_held++;
+    xTaskNotifyGive(ps_task_handle);
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+/* tx_mutex taken. Sends held frames, oldest first, until one's peer is asleep. Returns how long
+   until that one can go */
+static uint32_t send_held(uint32_t now_us)
+{
+    uint32_t wait_us;
+
+    while (tx_held > 0U)
+    {
+        if (!tx_hold_head_valid)
+        {
+            tx_hold_head_valid = espnow_link_ring_pop(&tx_hold, &tx_hold_head.info, tx_hold_head.data, ESPNOW_DATA_BYTES);
+        }
+
+        wait_us = peer_wait_us(tx_hold_head.info.src_mac, now_us);
+
+        if (wait_us > 0U)
+        {
+            return wait_us;
+        }
+
+        /* its slot was reserved when it was written and can't be released out of order, so
+           a refusal is retried */
+        if (send_message_to_peer(tx_hold_head.info.src_mac, tx_hold_head.data, tx_hold_head.info.data_len) != ESP_OK)
+        {
+            metrics_inc(METRIC_LINK_TX_REFUSED);
+            return PS_RETRY_US_D;
+        }
+
+        power_stats.modes[power_mode].frames_sent++;
+        power_stats.modes[power_mode].hold_ms += (now_us - tx_hold_head.info.timestamp_us + 500U) / 1000U;
+        tx_hold_head_valid = false;
+        tx_held--;
+    }
 
-    memset(&msg, 0U, sizeof(ESPNOW_LINK_MSG_T));
-    memcpy(&(msg.data), data, data_len);
-    memcpy(&(msg.recv_info), esp_now_info, sizeof(esp_now_recv_info_t));
+    return PS_NO_WAIT_D;
+}
 
-    enqueue(msg);
+static void set_radio_on(bool on)
+{
+#ifdef CONFIG_ESPNOW_ENABLE_POWER_SAVE
+    (void)esp_now_set_wake_window(on ? RADIO_ALWAYS_ON_WINDOW_D : 0U);
+#endif
 }
 
-void send_message_to_peer(const uint8_t* peer_mac, const uint8_t* message, uint16_t message_length)
+/* ps_task only. Carries sub millisecond remainders so short passes aren't lost */
+static void account_time(ESPNOW_LINK_POWER_MODE_T mode, bool radio_on, uint32_t elapsed_us)
 {
-    esp_now_send(peer_mac, message, message_length);
+    static uint32_t mode_carry_us[ESPNOW_LINK_POWER_MODES];
+    static uint32_t radio_carry_us[ESPNOW_LINK_POWER_MODES];
+
+    mode_carry_us[mode] += elapsed_us;
+    power_stats.modes[mode].mode_ms += mode_carry_us[mode] / 1000U;
+    mode_carry_us[mode] %= 1000U;
+
+    if (radio_on)
+    {
+        radio_carry_us[mode] += elapsed_us;
+        power_stats.modes[mode].radio_on_ms += radio_carry_us[mode] / 1000U;
+        radio_carry_us[mode] %= 1000U;
+    }
+}
+
+/*
+ * Opens and closes this unit's wake windows, announcing each with a beacon, and sends held
+ * frames as their peers wake. Sleeps in between, woken early by writes and beacons
+ */
+static void ps_task(void* params)
+{
+    uint8_t beacon[ESPNOW_LINK_PS_BEACON_BYTES];
+    uint16_t beacon_length;
+    uint32_t window_start_us = timing_get_us();
+    uint32_t last_us = window_start_us;
+    ESPNOW_LINK_POWER_MODE_T last_mode = power_mode;
+    ESPNOW_LINK_POWER_MODE_T mode;
+    bool radio_on = true;
+    bool announce = (last_mode == ESPNOW_LINK_POWER_SAVE);
+    bool awake_announce = false;
+    uint32_t now_us;
+    uint32_t awake_left_us;
+    uint32_t hold_left_us;
+    uint32_t wait_us;
+    TickType_t ticks;
+
+    while (1U)
+    {
+        now_us = timing_get_us();
+        mode = power_mode;
+        account_time(last_mode, radio_on, now_us - last_us);
+        last_us = now_us;
+
+        /* a new mode starts a window right away, and tells the neighbours */
+        if (mode != last_mode)
+        {
+            last_mode = mode;
+            window_start_us = now_us;
+            announce = true;
+        }
+
+        if ((mode == ESPNOW_LINK_POWER_SAVE) && ((now_us - window_start_us) >= (ESPNOW_LINK_PS_INTERVAL_MS * 1000U)))
+        {
+            window_start_us += ((now_us - window_start_us) / (ESPNOW_LINK_PS_INTERVAL_MS * 1000U)) * (ESPNOW_LINK_PS_INTERVAL_MS * 1000U);
+            announce = true;
+        }
+
+        /* how long the radio stays on from now, for this window or a hold */
+        hold_left_us = ((int32_t)(hold_awake_until_us - now_us) > 0) ? (hold_awake_until_us - now_us) : 0U;
+        awake_left_us = ((now_us - window_start_us) < (ESPNOW_LINK_PS_WINDOW_MS * 1000U)) ?
+                         ((ESPNOW_LINK_PS_WINDOW_MS * 1000U) - (now_us - window_start_us)) : 0U;
+        awake_left_us = (awake_left_us > hold_left_us) ? awake_left_us : hold_left_us;
+
+        /* a hold doesn't open a window, the mode change or window open beacon covers it */
+        if (hold_awake_started)
+        {
+            hold_awake_started = false;
+            awake_announce = !announce && (mode == ESPNOW_LINK_POWER_SAVE);
+        }
+
+        if (radio_on != ((mode == ESPNOW_LINK_POWER_ALWAYS_ON) || (awake_left_us > 0U)))
+        {
+            radio_on = !radio_on;
+            set_radio_on(radio_on);
+        }
+
+        xSemaphoreTake(tx_mutex, portMAX_DELAY);
+        wait_us = send_held(now_us);
+        xSemaphoreGive(tx_mutex);
+
+        /* behind held frames a beacon would go out late and misplace our windows. It is skipped,
+           the next window sends another */
+        if ((announce || awake_announce) && (wait_us == PS_NO_WAIT_D))
+        {
+            beacon_length = espnow_link_ps_build_beacon(announce && (mode == ESPNOW_LINK_POWER_SAVE),
+                                                        ESPNOW_LINK_PS_WINDOW_MS, ESPNOW_LINK_PS_INTERVAL_MS,
+                                                        (mode == ESPNOW_LINK_POWER_ALWAYS_ON) ? ESPNOW_LINK_PS_AWAKE_FOREVER :
+                                                        (uint16_t)(awake_left_us / 1000U), beacon);
+            power_stats.beacons_sent += (espnow_link_write_async(broadcast_mac, beacon, beacon_length, NULL, NULL, NULL) ==
+                                         ESPNOW_LINK_ERR_NONE) ? 1U : 0U;
+        }
+
+        announce = false;
+        awake_announce = false;
+
+        if (mode == ESPNOW_LINK_POWER_SAVE)
+        {
+            /* next window edge */
+            awake_left_us = (awake_left_us > 0U) ? awake_left_us :
+                             ((ESPNOW_LINK_PS_INTERVAL_MS * 1000U) - (now_us - window_start_us));
+            wait_us = (awake_left_us < wait_us) ? awake_left_us : wait_us;
+        }
+
+        ticks = (wait_us == PS_NO_WAIT_D) ? portMAX_DELAY : pdMS_TO_TICKS((wait_us + 999U) / 1000U);
+        (void)ulTaskNotifyTake(pdTRUE, (ticks > 0U) ? ticks : 1U);
+    }
+}
+
+/* wifi task, while a survey runs. Every frame on the air counts, whoever it is for */
+static void promiscuous_callback(void* buf, wifi_promiscuous_pkt_type_t type)
+{
+    const wifi_promiscuous_pkt_t* pkt = (const wifi_promiscuous_pkt_t*)buf;
+
+    taskENTER_CRITICAL(&chan_lock);
+
+    if (chan_survey != NULL)
+    {
+        espnow_link_chan_scan_add(chan_survey, survey_channel, pkt->rx_ctrl.rssi, pkt->rx_ctrl.noise_floor,
+                                  espnow_link_chan_airtime_us((uint16_t)pkt->rx_ctrl.sig_len));
+    }
+
+    taskEXIT_CRITICAL(&chan_lock);
+}
+
+/*
+ * pdMS_TO_TICKS() rounds down, so at a 100 Hz tick any wait under 10 ms is 0 ticks and returns
+ * at once. A wait of any length sleeps at least a tick here rather than spinning
+ */
+static TickType_t ms_to_ticks(uint32_t ms)
+{
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+
+    return ((ticks == 0U) && (ms > 0U)) ? 1U : ticks;
 }
 
 /************************************
@@ -103,6 +575,25 @@ void send_message_to_peer(const uint8_t* peer_mac, const uint8_t* message, uint1
  ************************************/
 ESPNOW_LINK_ERR_T espnow_link_init(void)
 {
+    /* ring and tx tracking must be ready before the callbacks are registered */
+    espnow_link_ring_init(&rx_ring, (uint8_t*)rx_ring_storage, ESPNOW_LINK_RX_RING_BYTES, RX_OVERFLOW_POLICY_D);
+
+    espnow_link_tx_init(&tx_tracker);
+    espnow_link_ring_init(&tx_hold, (uint8_t*)tx_hold_storage, ESPNOW_LINK_TX_HOLD_BYTES, ESPNOW_LINK_RING_DROP_NEWEST);
+    tx_hold_head_valid = false;
+    tx_held = 0U;
+    espnow_link_ps_init(&ps);
+    memset(&power_stats, 0, sizeof(power_stats));
+    espnow_link_chan_monitor_init(&chan_monitor);
+    wifi_channel = ESPNOW_LINK_CHAN_DEFAULT;
+    channel_switches = 0U;
+    espnow_link_rate_init(&rate_table, LONG_RANGE_D);
+    tx_mutex = xSemaphoreCreateMutexStatic(&tx_mutex_buffer);
+    for (uint32_t i = 0U; i < ESPNOW_LINK_TX_MAX_IN_FLIGHT; i++)
+    {
+        tx_done_semaphores[i] = xSemaphoreCreateBinaryStatic(&tx_done_semaphore_buffers[i]);
+    }
+
     /* Initiailize NVS Flash for WiFi to store configuration information */
     esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -118,6 +609,10 @@ ESPNOW_LINK_ERR_T espnow_link_init(void)
     ret = esp_wifi_set_storage(WIFI_STORAGE_RAM);
     ret = esp_wifi_set_mode(WIFI_MODE_STA);
     ret = esp_wifi_start();
+#ifdef CONFIG_ESPNOW_ENABLE_LONG_RANGE
+    ret = esp_wifi_set_protocol(WIFI_IF_STA, WIFI_PROTOCOL_11B | WIFI_PROTOCOL_11G | WIFI_PROTOCOL_11N | WIFI_PROTOCOL_LR);
+#endif
+    ret = esp_wifi_set_channel(wifi_channel, WIFI_SECOND_CHAN_NONE);
 
     ret = esp_wifi_get_mac(WIFI_IF_STA, device_mac);
 
@@ -126,6 +621,23 @@ ESPNOW_LINK_ERR_T espnow_link_init(void)
     ret = esp_now_register_send_cb(espnow_send_callback);
     ret = esp_now_register_recv_cb(espnow_receive_callback);
 
+#ifdef CONFIG_ESPNOW_ENABLE_POWER_SAVE
+    /* ps_task opens and closes the windows itself, the driver only needs to check often enough */
+    (void)esp_wifi_connectionless_module_set_wake_interval(ESPNOW_LINK_PS_INTERVAL_MS);
+    power_mode = ESPNOW_LINK_POWER_SAVE;
+#else
+    power_mode = ESPNOW_LINK_POWER_ALWAYS_ON;
+#endif
+
+    /* beacons go to everyone */
+    (void)espnow_link_register_peer(broadcast_mac);
+
+    if ((ret == ESP_OK) && (ps_task_handle == NULL) &&
+        (xTaskCreate(ps_task, "espnow_ps", PS_TASK_STACK_BYTES_D, NULL, PS_TASK_PRIORITY_D, &ps_task_handle) != pdPASS))
+    {
+        ret = ESP_FAIL;
+    }
+
     if (ret == ESP_OK)
     {
         return ESPNOW_LINK_ERR_NONE;
@@ -139,6 +651,12 @@ ESPNOW_LINK_ERR_T espnow_link_register_peer(const uint8_t* peer_mac_address)
     esp_err_t ret;
     esp_now_peer_info_t peer;
 
+    /* upper layers and the link may both register broadcast */
+    if (esp_now_is_peer_exist(peer_mac_address))
+    {
+        return ESPNOW_LINK_ERR_NONE;
+    }
+
     memset(&peer, 0, sizeof(esp_now_peer_info_t));
     memcpy(peer.peer_addr, peer_mac_address, 6);
 
@@ -147,25 +665,170 @@ ESPNOW_LINK_ERR_T espnow_link_register_peer(const uint8_t* peer_mac_address)
     return (ret == ESP_OK) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
 }
 
+ESPNOW_LINK_ERR_T espnow_link_unregister_peer(const uint8_t* peer_mac_address)
+{
+    if ((memcmp(peer_mac_address, broadcast_mac, MAC_LENGTH_BYTES_D) == 0) || !esp_now_is_peer_exist(peer_mac_address))
+    {
+        return ESPNOW_LINK_ERR_NONE;
+    }
+
+    return (esp_now_del_peer(peer_mac_address) == ESP_OK) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+}
+
 ESPNOW_LINK_ERR_T espnow_link_write(const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length)
+{
+    ESPNOW_LINK_ERR_T ret;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    BLOCKING_WRITE_T result = { .done = false, .success = false };
+
+    ret = espnow_link_write_async(peer_mac, data, data_length, blocking_write_done, &result, &handle);
+
+    /* pipeline is full, sleep while the oldest frames complete. Can last a whole wake interval
+       when frames are held for a sleeping peer */
+    while (ret == ESPNOW_LINK_ERR_BUSY)
+    {
+        (void)espnow_link_wait_tx_slot(ESPNOW_LINK_WAIT_FOREVER);
+        ret = espnow_link_write_async(peer_mac, data, data_length, blocking_write_done, &result, &handle);
+    }
+
+    if (ret != ESPNOW_LINK_ERR_NONE)
+    {
+        return ret;
+    }
+
+    /* sleep on the slot's semaphore instead of spinning. result lives on our stack, so wait for it */
+    while (!result.done)
+    {
+        xSemaphoreTake(tx_done_semaphores[espnow_link_tx_slot_index(handle)], pdMS_TO_TICKS(BLOCKING_WRITE_RECHECK_MS_D));
+    }
+
+    return result.success ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+}
+
+ESPNOW_LINK_ERR_T espnow_link_write_async(const uint8_t* peer_mac,
+                                          const uint8_t* data,
+                                          uint16_t data_length,
+                                          ESPNOW_LINK_TX_DONE_CB_T callback,
+                                          void* context,
+                                          ESPNOW_LINK_TX_HANDLE_T* handle)
 {
     ESPNOW_LINK_ERR_T ret = ESPNOW_LINK_ERR_NONE;
+    ESPNOW_LINK_TX_HANDLE_T new_handle = ESPNOW_LINK_TX_INVALID_HANDLE;
+    int32_t slot;
 
     if (data_length > ESP_NOW_MAX_DATA_LEN)
     {
-        ret = ESPNOW_LINK_ERR;
+        return ESPNOW_LINK_ERR;
     }
 
-    send_message_to_peer(peer_mac, data, data_length);
+    /* reservation order has to match esp_now_send() order, since callbacks are matched first in first out */
+    xSemaphoreTake(tx_mutex, portMAX_DELAY);
+
+    slot = espnow_link_tx_reserve(&tx_tracker, peer_mac, callback, context, &new_handle);
+
+    if (slot < 0)
+    {
+        metrics_inc(METRIC_LINK_TX_BUSY);
+        ret = ESPNOW_LINK_ERR_BUSY;
+    }
+    else
+    {
+        /* clear any give left over from a previous user of this slot that timed out */
+        xSemaphoreTake(tx_done_semaphores[slot], 0U);
+
+        /* stamped before the send, its callback may run before esp_now_send() returns */
+        tx_sent_us[slot] = timing_get_us();
+        metrics_inc(METRIC_LINK_TX_ATTEMPTS);
+        metrics_gauge_max(METRIC_LINK_TX_QUEUE_HWM, espnow_link_tx_in_flight(&tx_tracker));
+
+        /* behind held frames, or for a peer whose radio is off. Either way it waits its turn */
+        if ((tx_held > 0U) || (peer_wait_us(peer_mac, tx_sent_us[slot]) > 0U))
+        {
+            ret = hold_frame(peer_mac, data, data_length, tx_sent_us[slot]);
+        }
+        else if (send_message_to_peer(peer_mac, data, data_length) != ESP_OK)
+        {
+            metrics_inc(METRIC_LINK_TX_REFUSED);
+            ret = ESPNOW_LINK_ERR;
+        }
+        else
+        {
+            power_stats.modes[power_mode].frames_sent++;
+        }
+
+        if (ret != ESPNOW_LINK_ERR_NONE)
+        {
+            /* no send callback will come for this frame */
+            espnow_link_tx_cancel_last(&tx_tracker);
+            new_handle = ESPNOW_LINK_TX_INVALID_HANDLE;
+        }
+    }
 
-    while(!send_callback_called); /* wait for send callback to finish */
-    send_callback_called = false;
+    xSemaphoreGive(tx_mutex);
 
-    ret = (send_status == ESP_NOW_SEND_SUCCESS) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+    if (handle != NULL)
+    {
+        *handle = new_handle;
+    }
 
     return ret;
 }
 
+ESPNOW_LINK_ERR_T espnow_link_wait_tx(ESPNOW_LINK_TX_HANDLE_T handle, uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = pdMS_TO_TICKS(timeout_ms);
+    TickType_t elapsed;
+
+    while (1U)
+    {
+        switch (espnow_link_tx_get_state(&tx_tracker, handle))
+        {
+        case ESPNOW_LINK_TX_STATE_SUCCESS:
+            return ESPNOW_LINK_ERR_NONE;
+        case ESPNOW_LINK_TX_STATE_PENDING:
+            break;
+        case ESPNOW_LINK_TX_STATE_FAILED:
+        case ESPNOW_LINK_TX_STATE_FREE:
+        default:
+            return ESPNOW_LINK_ERR;
+        }
+
+        elapsed = xTaskGetTickCount() - start;
+        if (elapsed >= timeout)
+        {
+            return ESPNOW_LINK_ERR_TIMEOUT;
+        }
+
+        xSemaphoreTake(tx_done_semaphores[espnow_link_tx_slot_index(handle)], timeout - elapsed);
+    }
+}
+
+ESPNOW_LINK_ERR_T espnow_link_wait_tx_slot(uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t timeout = (timeout_ms == ESPNOW_LINK_WAIT_FOREVER) ? portMAX_DELAY : ms_to_ticks(timeout_ms);
+
+    /* any slot may be the one that frees, and each belongs to its own writer, so there is no
+       single semaphore to sleep on. Checks once a tick */
+    while (espnow_link_tx_in_flight(&tx_tracker) >= ESPNOW_LINK_TX_MAX_IN_FLIGHT)
+    {
+        if ((timeout != portMAX_DELAY) && ((xTaskGetTickCount() - start) >= timeout))
+        {
+            return ESPNOW_LINK_ERR_TIMEOUT;
+        }
+
+        vTaskDelay(ms_to_ticks(1U));
+    }
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+uint32_t espnow_link_tx_pending(void)
+{
+    return espnow_link_tx_in_flight(&tx_tracker);
+}
+
 ESPNOW_LINK_ERR_T espnow_link_get_device_mac(const uint8_t* buffer)
 {
     memcpy(buffer, device_mac, MAC_LENGTH_BYTES_D);
@@ -175,27 +838,214 @@ ESPNOW_LINK_ERR_T espnow_link_get_device_mac(const uint8_t* buffer)
 
 ESPNOW_LINK_ERR_T espnow_link_read(const ESPNOW_LINK_MSG_T* msg_buffer)
 {
-    ESPNOW_LINK_ERR_T ret = ESPNOW_LINK_ERR;
-    ESPNOW_LINK_MSG_T msg;
+    ESPNOW_LINK_MSG_T* msg = (ESPNOW_LINK_MSG_T*)msg_buffer;
+
+    /* copy straight from ring into caller's buffer, no intermediate message on the stack */
+    return espnow_link_ring_pop(&rx_ring, &msg->info, msg->data, ESPNOW_DATA_BYTES) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+}
+
+bool espnow_link_messages_available(void)
+{
+    return !espnow_link_ring_is_empty(&rx_ring);
+}
+
+bool espnow_link_wait_for_messages(uint32_t timeout_ms)
+{
+    TickType_t start;
+    TickType_t timeout;
+    TickType_t elapsed;
 
     if (espnow_link_messages_available())
     {
-        msg = dequeue();    
-        memcpy(msg_buffer, &msg, sizeof(ESPNOW_LINK_MSG_T));
-        ret = ESPNOW_LINK_ERR_NONE;
+        return true;
     }
 
-    return ret;
+    start = xTaskGetTickCount();
+    /* a short timeout still sleeps, callers polling on one would otherwise spin */
+    timeout = (timeout_ms == ESPNOW_LINK_WAIT_FOREVER) ? portMAX_DELAY : ms_to_ticks(timeout_ms);
+
+    /* register before re-checking, so a frame arriving in between still notifies us */
+    rx_waiting_task = xTaskGetCurrentTaskHandle();
+
+    /* a wake is consumed as it is seen, so one that lands after the loop stays for the next wait */
+    while (!espnow_link_messages_available() && !atomic_exchange_explicit(&rx_wake_requested, false, memory_order_acq_rel))
+    {
+        if (timeout == portMAX_DELAY)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        elapsed = xTaskGetTickCount() - start;
+        if ((elapsed >= timeout) || (ulTaskNotifyTake(pdTRUE, timeout - elapsed) == 0U))
+        {
+            break;
+        }
+    }
+
+    rx_waiting_task = NULL;
+
+    return espnow_link_messages_available();
 }
 
-bool espnow_link_messages_available(void)
+void espnow_link_wake_reader(void)
+{
+    TaskHandle_t waiting_task;
+
+    /* flag first, so a reader that registers after the check below still sees it */
+    atomic_store_explicit(&rx_wake_requested, true, memory_order_release);
+    waiting_task = rx_waiting_task;
+
+    if (waiting_task != NULL)
+    {
+        xTaskNotifyGive(waiting_task);
+    }
+}
+
+void espnow_link_set_rx_overflow_policy(ESPNOW_LINK_RING_POLICY_T policy)
+{
+    espnow_link_ring_set_policy(&rx_ring, policy);
+}
+
+void espnow_link_get_rx_stats(ESPNOW_LINK_RX_STATS_T* stats)
+{
+    stats->frames_received = frames_received;
+    espnow_link_ring_get_stats(&rx_ring, &stats->ring);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_set_power_mode(ESPNOW_LINK_POWER_MODE_T mode)
+{
+#ifndef CONFIG_ESPNOW_ENABLE_POWER_SAVE
+    /* the driver can't sleep the radio without station power management */
+    if (mode == ESPNOW_LINK_POWER_SAVE)
+    {
+        return ESPNOW_LINK_ERR;
+    }
+#endif
+
+    if (mode >= ESPNOW_LINK_POWER_MODES)
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    power_mode = mode;
+
+    if (ps_task_handle != NULL)
+    {
+        xTaskNotifyGive(ps_task_handle);
+    }
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+void espnow_link_get_power_stats(ESPNOW_LINK_POWER_STATS_T* stats)
 {
-    return message_receive_queue.head_index != message_receive_queue.tail_index;
+    *stats = power_stats;
+    stats->mode = power_mode;
+}
+
+ESPNOW_LINK_ERR_T espnow_link_set_wifi_channel(uint8_t channel)
+{
+    if ((channel < ESPNOW_LINK_CHAN_FIRST) || (channel > ESPNOW_LINK_CHAN_LAST) ||
+        (esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE) != ESP_OK))
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    /* what was measured on the old channel says nothing about this one */
+    taskENTER_CRITICAL(&chan_lock);
+
+    if (channel != wifi_channel)
+    {
+        wifi_channel = channel;
+        channel_switches++;
+        espnow_link_chan_monitor_init(&chan_monitor);
+    }
+
+    taskEXIT_CRITICAL(&chan_lock);
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+uint8_t espnow_link_get_wifi_channel(void)
+{
+    return wifi_channel;
+}
+
+ESPNOW_LINK_ERR_T espnow_link_scan_channels(uint32_t dwell_ms, ESPNOW_LINK_CHAN_SURVEY_T* survey)
+{
+    const wifi_promiscuous_filter_t filter = { .filter_mask = WIFI_PROMIS_FILTER_MASK_ALL };
+    uint32_t start_us;
+    uint8_t channel;
+    esp_err_t ret;
+
+    espnow_link_chan_survey_init(survey);
+
+    taskENTER_CRITICAL(&chan_lock);
+    chan_survey = survey;
+    taskEXIT_CRITICAL(&chan_lock);
+
+    ret = esp_wifi_set_promiscuous_filter(&filter);
+    ret = (ret == ESP_OK) ? esp_wifi_set_promiscuous_rx_cb(promiscuous_callback) : ret;
+    ret = (ret == ESP_OK) ? esp_wifi_set_promiscuous(true) : ret;
+
+    for (channel = ESPNOW_LINK_CHAN_FIRST; (ret == ESP_OK) && (channel <= ESPNOW_LINK_CHAN_LAST); channel++)
+    {
+        taskENTER_CRITICAL(&chan_lock);
+        survey_channel = channel;
+        taskEXIT_CRITICAL(&chan_lock);
+
+        ret = esp_wifi_set_channel(channel, WIFI_SECOND_CHAN_NONE);
+        start_us = timing_get_us();
+        vTaskDelay(pdMS_TO_TICKS(dwell_ms));
+
+        taskENTER_CRITICAL(&chan_lock);
+        espnow_link_chan_scan_dwell(survey, channel, timing_get_us() - start_us);
+        taskEXIT_CRITICAL(&chan_lock);
+    }
+
+    (void)esp_wifi_set_promiscuous(false);
+
+    taskENTER_CRITICAL(&chan_lock);
+    chan_survey = NULL;
+    taskEXIT_CRITICAL(&chan_lock);
+
+    /* back where the peers are, whatever happened */
+    (void)esp_wifi_set_channel(wifi_channel, WIFI_SECOND_CHAN_NONE);
+
+    return (ret == ESP_OK) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+}
+
+void espnow_link_get_chan_stats(ESPNOW_LINK_CHAN_STATS_T* stats)
+{
+    taskENTER_CRITICAL(&chan_lock);
+    espnow_link_chan_get_stats(&chan_monitor, stats);
+    stats->channel = wifi_channel;
+    stats->switches = channel_switches;
+    taskEXIT_CRITICAL(&chan_lock);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_get_peer_rate(const uint8_t* peer_mac, ESPNOW_LINK_RATE_STATS_T* stats)
+{
+    bool found;
+
+    taskENTER_CRITICAL(&rate_lock);
+    found = espnow_link_rate_get_stats(&rate_table, peer_mac, stats);
+    taskEXIT_CRITICAL(&rate_lock);
+
+    return found ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
 }
 
 ESPNOW_LINK_ERR_T espnow_link_close(void)
 {
     esp_err_t ret;
+
+    if (ps_task_handle != NULL)
+    {
+        vTaskDelete(ps_task_handle);
+        ps_task_handle = NULL;
+    }
+
     ret = esp_now_deinit();
     ret = esp_wifi_stop();
 
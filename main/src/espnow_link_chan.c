@@ -0,0 +1,198 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_chan.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Channel quality monitor and survey scoring
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "espnow_link_chan.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+
+/* moving averages take 1/8 of each new sample */
+#define AVERAGE_SHIFT_D (3)
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static const ESPNOW_LINK_CHAN_SCAN_T* find_scan(const ESPNOW_LINK_CHAN_SURVEY_T* survey, int32_t channel);
+static uint32_t busy_permille(const ESPNOW_LINK_CHAN_SURVEY_T* survey, int32_t channel);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static const ESPNOW_LINK_CHAN_SCAN_T* find_scan(const ESPNOW_LINK_CHAN_SURVEY_T* survey, int32_t channel)
+{
+    if ((channel < (int32_t)ESPNOW_LINK_CHAN_FIRST) || (channel > (int32_t)ESPNOW_LINK_CHAN_LAST))
+    {
+        return NULL;
+    }
+
+    return &survey->channels[channel - (int32_t)ESPNOW_LINK_CHAN_FIRST];
+}
+
+/* 0 for channels off the band or not surveyed, so they add nothing to their neighbours */
+static uint32_t busy_permille(const ESPNOW_LINK_CHAN_SURVEY_T* survey, int32_t channel)
+{
+    const ESPNOW_LINK_CHAN_SCAN_T* scan = find_scan(survey, channel);
+    uint32_t permille;
+
+    if ((scan == NULL) || (scan->dwell_us == 0U))
+    {
+        return 0U;
+    }
+
+    permille = (uint32_t)(((uint64_t)scan->busy_us * 1000U) / scan->dwell_us);
+
+    return (permille > 1000U) ? 1000U : permille;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void espnow_link_chan_monitor_init(ESPNOW_LINK_CHAN_MONITOR_T* monitor)
+{
+    memset(monitor, 0, sizeof(*monitor));
+    monitor->delivery_permille = 1000U;
+}
+
+void espnow_link_chan_on_rx(ESPNOW_LINK_CHAN_MONITOR_T* monitor, int8_t rssi, int8_t noise_floor)
+{
+    /* first frame sets the averages, so they don't start out at 0 dBm */
+    if (monitor->frames_rx == 0U)
+    {
+        monitor->rssi_x16 = (int32_t)rssi * 16;
+        monitor->noise_x16 = (int32_t)noise_floor * 16;
+    }
+    else
+    {
+        monitor->rssi_x16 += (((int32_t)rssi * 16) - monitor->rssi_x16) / (1 << AVERAGE_SHIFT_D);
+        monitor->noise_x16 += (((int32_t)noise_floor * 16) - monitor->noise_x16) / (1 << AVERAGE_SHIFT_D);
+    }
+
+    monitor->frames_rx++;
+}
+
+void espnow_link_chan_on_tx(ESPNOW_LINK_CHAN_MONITOR_T* monitor, bool acked)
+{
+    monitor->tx_acked += acked ? 1U : 0U;
+    monitor->tx_failed += acked ? 0U : 1U;
+    monitor->window_sent++;
+    monitor->window_acked += acked ? 1U : 0U;
+
+    if (monitor->window_sent >= ESPNOW_LINK_CHAN_TX_WINDOW)
+    {
+        monitor->delivery_permille = (uint16_t)(((uint32_t)monitor->window_acked * 1000U) / monitor->window_sent);
+        monitor->window_sent = 0U;
+        monitor->window_acked = 0U;
+    }
+}
+
+void espnow_link_chan_get_stats(const ESPNOW_LINK_CHAN_MONITOR_T* monitor, ESPNOW_LINK_CHAN_STATS_T* stats)
+{
+    stats->rssi = (int8_t)(monitor->rssi_x16 / 16);
+    stats->noise_floor = (int8_t)(monitor->noise_x16 / 16);
+    stats->delivery_permille = monitor->delivery_permille;
+    stats->degraded = (monitor->delivery_permille < ESPNOW_LINK_CHAN_DEGRADED_PERMILLE);
+    stats->frames_rx = monitor->frames_rx;
+    stats->tx_acked = monitor->tx_acked;
+    stats->tx_failed = monitor->tx_failed;
+}
+
+void espnow_link_chan_survey_init(ESPNOW_LINK_CHAN_SURVEY_T* survey)
+{
+    memset(survey, 0, sizeof(*survey));
+}
+
+uint32_t espnow_link_chan_airtime_us(uint16_t length)
+{
+    return ESPNOW_LINK_CHAN_PREAMBLE_US + ((((uint32_t)length * 8U) + ESPNOW_LINK_CHAN_NOMINAL_MBPS - 1U) / ESPNOW_LINK_CHAN_NOMINAL_MBPS);
+}
+
+void espnow_link_chan_scan_add(ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel, int8_t rssi, int8_t noise_floor, uint32_t airtime_us)
+{
+    ESPNOW_LINK_CHAN_SCAN_T* scan = (ESPNOW_LINK_CHAN_SCAN_T*)find_scan(survey, channel);
+
+    if (scan == NULL)
+    {
+        return;
+    }
+
+    scan->rssi_max = ((scan->frames == 0U) || (rssi > scan->rssi_max)) ? rssi : scan->rssi_max;
+    scan->busy_us += airtime_us;
+    scan->noise_sum += noise_floor;
+    scan->frames++;
+}
+
+void espnow_link_chan_scan_dwell(ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel, uint32_t dwell_us)
+{
+    ESPNOW_LINK_CHAN_SCAN_T* scan = (ESPNOW_LINK_CHAN_SCAN_T*)find_scan(survey, channel);
+
+    if (scan != NULL)
+    {
+        scan->dwell_us += dwell_us;
+    }
+}
+
+uint32_t espnow_link_chan_score(const ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t channel)
+{
+    const ESPNOW_LINK_CHAN_SCAN_T* scan = find_scan(survey, channel);
+    int32_t noise;
+    uint32_t score;
+
+    if ((scan == NULL) || (scan->dwell_us == 0U))
+    {
+        return UINT32_MAX;
+    }
+
+    score = busy_permille(survey, channel) +
+            (busy_permille(survey, (int32_t)channel - 1) / 2U) + (busy_permille(survey, (int32_t)channel + 1) / 2U) +
+            (busy_permille(survey, (int32_t)channel - 2) / 4U) + (busy_permille(survey, (int32_t)channel + 2) / 4U);
+
+    /* noise is only reported with frames, a channel nothing was heard on is taken as quiet */
+    if (scan->frames > 0U)
+    {
+        noise = scan->noise_sum / (int32_t)scan->frames;
+        score += (noise > ESPNOW_LINK_CHAN_QUIET_NOISE_DBM) ?
+                 ((uint32_t)(noise - ESPNOW_LINK_CHAN_QUIET_NOISE_DBM) * ESPNOW_LINK_CHAN_NOISE_COST) : 0U;
+    }
+
+    return score;
+}
+
+uint8_t espnow_link_chan_pick(const ESPNOW_LINK_CHAN_SURVEY_T* survey, uint8_t current)
+{
+    uint32_t best_score = UINT32_MAX;
+    uint32_t current_score = espnow_link_chan_score(survey, current);
+    uint32_t score;
+    uint8_t best = current;
+    uint8_t channel;
+
+    for (channel = ESPNOW_LINK_CHAN_FIRST; channel <= ESPNOW_LINK_CHAN_LAST; channel++)
+    {
+        score = espnow_link_chan_score(survey, channel);
+
+        if (score < best_score)
+        {
+            best_score = score;
+            best = channel;
+        }
+    }
+
+    /* moving costs a handshake and strands any unit that misses it, so only for a clear win */
+    if ((best_score == UINT32_MAX) ||
+        ((current_score != UINT32_MAX) && (current_score <= (best_score + ESPNOW_LINK_CHAN_HYSTERESIS))))
+    {
+        return current;
+    }
+
+    return best;
+}
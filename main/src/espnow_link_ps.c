@@ -0,0 +1,133 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_ps.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Wake window schedule of power saving peers
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "espnow_link_ps.h"
+#include <string.h>
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static const ESPNOW_LINK_PS_PEER_T* find_peer(const ESPNOW_LINK_PS_T* ps, const uint8_t* mac);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static const ESPNOW_LINK_PS_PEER_T* find_peer(const ESPNOW_LINK_PS_T* ps, const uint8_t* mac)
+{
+    uint32_t i;
+
+    for (i = 0U; i < ESPNOW_LINK_PS_PEERS; i++)
+    {
+        if (ps->peers[i].used && (memcmp(ps->peers[i].mac, mac, sizeof(ps->peers[i].mac)) == 0))
+        {
+            return &ps->peers[i];
+        }
+    }
+
+    return NULL;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void espnow_link_ps_init(ESPNOW_LINK_PS_T* ps)
+{
+    memset(ps, 0, sizeof(*ps));
+}
+
+uint16_t espnow_link_ps_build_beacon(bool window_open, uint16_t window_ms, uint16_t interval_ms, uint16_t awake_ms, uint8_t* frame)
+{
+    frame[0] = window_open ? ESPNOW_LINK_PS_WINDOW_MAGIC : ESPNOW_LINK_PS_AWAKE_MAGIC;
+    frame[1] = (uint8_t)(window_ms & 0xFFU);
+    frame[2] = (uint8_t)(window_ms >> 8U);
+    frame[3] = (uint8_t)(interval_ms & 0xFFU);
+    frame[4] = (uint8_t)(interval_ms >> 8U);
+    frame[5] = (uint8_t)(awake_ms & 0xFFU);
+    frame[6] = (uint8_t)(awake_ms >> 8U);
+
+    return ESPNOW_LINK_PS_BEACON_BYTES;
+}
+
+bool espnow_link_ps_on_beacon(ESPNOW_LINK_PS_T* ps, const uint8_t* mac, const uint8_t* frame, uint16_t length, uint32_t now_us)
+{
+    ESPNOW_LINK_PS_PEER_T* peer = (ESPNOW_LINK_PS_PEER_T*)find_peer(ps, mac);
+    uint16_t awake_ms;
+    bool window_open;
+    uint32_t i;
+
+    if ((length != ESPNOW_LINK_PS_BEACON_BYTES) ||
+        ((frame[0] != ESPNOW_LINK_PS_WINDOW_MAGIC) && (frame[0] != ESPNOW_LINK_PS_AWAKE_MAGIC)))
+    {
+        return false;
+    }
+
+    /* a peer first heard between windows is placed as if its window just opened, the next
+       window beacon puts it right */
+    window_open = (frame[0] == ESPNOW_LINK_PS_WINDOW_MAGIC) || (peer == NULL);
+
+    /* replace the peer heard from least recently */
+    if (peer == NULL)
+    {
+        peer = &ps->peers[0];
+
+        for (i = 1U; (i < ESPNOW_LINK_PS_PEERS) && peer->used; i++)
+        {
+            if (!ps->peers[i].used || (ps->peers[i].last_used < peer->last_used))
+            {
+                peer = &ps->peers[i];
+            }
+        }
+
+        memcpy(peer->mac, mac, sizeof(peer->mac));
+        peer->used = true;
+    }
+
+    awake_ms = (uint16_t)frame[5] | (uint16_t)((uint16_t)frame[6] << 8U);
+
+    ps->clock++;
+    peer->last_used = ps->clock;
+
+    if (window_open)
+    {
+        peer->anchor_us = now_us;
+    }
+
+    peer->window_us = ((uint32_t)frame[1] | ((uint32_t)frame[2] << 8U)) * 1000U;
+    peer->interval_us = ((uint32_t)frame[3] | ((uint32_t)frame[4] << 8U)) * 1000U;
+    peer->awake_forever = (awake_ms == ESPNOW_LINK_PS_AWAKE_FOREVER);
+    peer->awake_until_us = now_us + ((uint32_t)awake_ms * 1000U);
+
+    return true;
+}
+
+uint32_t espnow_link_ps_wait_us(const ESPNOW_LINK_PS_T* ps, const uint8_t* mac, uint32_t now_us)
+{
+    const ESPNOW_LINK_PS_PEER_T* peer = find_peer(ps, mac);
+    uint32_t phase;
+
+    if ((peer == NULL) || peer->awake_forever || (peer->window_us >= peer->interval_us) ||
+        ((int32_t)(peer->awake_until_us - now_us) >= (int32_t)ESPNOW_LINK_PS_MARGIN_US))
+    {
+        return 0U;
+    }
+
+    /* windows repeat every interval from the last beacon. Clocks drift apart far slower than
+       beacons come in */
+    phase = (now_us - peer->anchor_us) % peer->interval_us;
+
+    if ((phase + ESPNOW_LINK_PS_MARGIN_US) <= peer->window_us)
+    {
+        return 0U;
+    }
+
+    return peer->interval_us - phase;
+}
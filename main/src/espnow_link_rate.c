@@ -0,0 +1,339 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_rate.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   PHY rate per peer, see espnow_link_rate.h
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "espnow_link_rate.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define MAC_BYTES_D (6U)
+
+/* a rate's delivery ratio takes 1/4 of each interval's, once it has one */
+#define DELIVERY_SHIFT_D (2U)
+
+/* rssi average takes 1/8 of each frame's */
+#define RSSI_SHIFT_D (3)
+
+_Static_assert(ESPNOW_LINK_TX_MAX_IN_FLIGHT <= 255U, "in flight count is kept in a byte");
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+
+/* LR and 1 Mbps go with the long preamble, the other 11b rates the short one. Needed rssi is
+   a few dB over the esp32c6's sensitivity at each rate */
+static const ESPNOW_LINK_RATE_INFO_T rates[ESPNOW_LINK_RATE_COUNT] = {
+    [ESPNOW_LINK_RATE_LR_250K] = {.kbps = 250U, .preamble_us = 192U, .min_rssi = -100},
+    [ESPNOW_LINK_RATE_LR_500K] = {.kbps = 500U, .preamble_us = 192U, .min_rssi = -97},
+    [ESPNOW_LINK_RATE_1M] = {.kbps = 1000U, .preamble_us = 192U, .min_rssi = -92},
+    [ESPNOW_LINK_RATE_2M] = {.kbps = 2000U, .preamble_us = 96U, .min_rssi = -90},
+    [ESPNOW_LINK_RATE_5M5] = {.kbps = 5500U, .preamble_us = 96U, .min_rssi = -88},
+    [ESPNOW_LINK_RATE_11M] = {.kbps = 11000U, .preamble_us = 96U, .min_rssi = -85},
+    [ESPNOW_LINK_RATE_24M] = {.kbps = 24000U, .preamble_us = 20U, .min_rssi = -79},
+    [ESPNOW_LINK_RATE_36M] = {.kbps = 36000U, .preamble_us = 20U, .min_rssi = -75},
+    [ESPNOW_LINK_RATE_54M] = {.kbps = 54000U, .preamble_us = 20U, .min_rssi = -70}
+};
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static ESPNOW_LINK_RATE_PEER_T* find_peer(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac);
+static ESPNOW_LINK_RATE_PEER_T* add_peer(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, uint32_t now_ms);
+static ESPNOW_LINK_RATE_T rssi_rate(const ESPNOW_LINK_RATE_TABLE_T* table, int8_t rssi);
+static void set_rate(ESPNOW_LINK_RATE_PEER_T* peer, ESPNOW_LINK_RATE_T rate);
+static void update(ESPNOW_LINK_RATE_TABLE_T* table, ESPNOW_LINK_RATE_PEER_T* peer, uint32_t now_ms);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static ESPNOW_LINK_RATE_PEER_T* find_peer(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac)
+{
+    uint32_t i;
+
+    for (i = 0U; i < ESPNOW_LINK_RATE_MAX_PEERS; i++)
+    {
+        if (table->peers[i].used && (memcmp(table->peers[i].mac, mac, MAC_BYTES_D) == 0))
+        {
+            return &table->peers[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* a free entry, or the least recently used one. Not one with frames in flight, their results would land on the new peer */
+static ESPNOW_LINK_RATE_PEER_T* add_peer(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, uint32_t now_ms)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = NULL;
+    ESPNOW_LINK_RATE_PEER_T* entry;
+    uint32_t i;
+
+    for (i = 0U; i < ESPNOW_LINK_RATE_MAX_PEERS; i++)
+    {
+        entry = &table->peers[i];
+
+        if (!entry->used)
+        {
+            peer = entry;
+            break;
+        }
+
+        if ((entry->in_flight_count == 0U) &&
+            ((peer == NULL) || ((int32_t)(entry->last_used_ms - peer->last_used_ms) < 0)))
+        {
+            peer = entry;
+        }
+    }
+
+    if (peer == NULL)
+    {
+        return NULL;
+    }
+
+    memset(peer, 0, sizeof(*peer));
+    peer->used = true;
+    memcpy(peer->mac, mac, MAC_BYTES_D);
+    peer->applied = ESPNOW_LINK_RATE_COUNT;
+    peer->last_update_ms = now_ms;
+    peer->last_used_ms = now_ms;
+    set_rate(peer, (table->lowest > ESPNOW_LINK_RATE_1M) ? table->lowest : ESPNOW_LINK_RATE_1M);
+    peer->stats.rate_changes = 0U;
+
+    return peer;
+}
+
+/* fastest rate rssi is enough for, the slowest allowed if none */
+static ESPNOW_LINK_RATE_T rssi_rate(const ESPNOW_LINK_RATE_TABLE_T* table, int8_t rssi)
+{
+    uint32_t rate;
+
+    for (rate = ESPNOW_LINK_RATE_COUNT - 1U; rate > (uint32_t)table->lowest; rate--)
+    {
+        if (rssi >= rates[rate].min_rssi)
+        {
+            break;
+        }
+    }
+
+    return (ESPNOW_LINK_RATE_T)rate;
+}
+
+static void set_rate(ESPNOW_LINK_RATE_PEER_T* peer, ESPNOW_LINK_RATE_T rate)
+{
+    peer->stats.rate_changes += (peer->rate != (uint8_t)rate) ? 1U : 0U;
+    peer->rate = (uint8_t)rate;
+    peer->failures = 0U;
+    peer->stats.rate = rate;
+    peer->stats.kbps = rates[rate].kbps;
+}
+
+/* folds this interval's results into each rate's delivery ratio, then moves to the best rate */
+static void update(ESPNOW_LINK_RATE_TABLE_T* table, ESPNOW_LINK_RATE_PEER_T* peer, uint32_t now_ms)
+{
+    uint32_t best_throughput = 0U;
+    uint32_t throughput;
+    uint32_t sample;
+    uint32_t best = peer->rate;
+    uint32_t rate;
+
+    for (rate = (uint32_t)table->lowest; rate < ESPNOW_LINK_RATE_COUNT; rate++)
+    {
+        if (peer->attempts[rate] > 0U)
+        {
+            sample = ((uint32_t)peer->acked[rate] * 1000U) / peer->attempts[rate];
+
+            /* the first interval at a rate stands on its own, later ones are averaged in */
+            peer->delivery[rate] = (peer->delivery[rate] == 0U) ? (uint16_t)sample :
+                                   (uint16_t)((((uint32_t)peer->delivery[rate] << DELIVERY_SHIFT_D) - peer->delivery[rate] + sample) >>
+                                              DELIVERY_SHIFT_D);
+            peer->attempts[rate] = 0U;
+            peer->acked[rate] = 0U;
+        }
+
+        if ((rate != peer->rate) && (peer->samples[rate] < ESPNOW_LINK_RATE_MIN_SAMPLES))
+        {
+            continue;
+        }
+
+        /* frames per second the rate gets through, per mille */
+        throughput = ((uint32_t)peer->delivery[rate] * 1000000U) / espnow_link_rate_frame_us((ESPNOW_LINK_RATE_T)rate, ESPNOW_LINK_RATE_FRAME_BYTES);
+
+        if (throughput > best_throughput)
+        {
+            best_throughput = throughput;
+            best = rate;
+        }
+    }
+
+    if (best != peer->rate)
+    {
+        set_rate(peer, (ESPNOW_LINK_RATE_T)best);
+    }
+
+    peer->last_update_ms = now_ms;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void espnow_link_rate_init(ESPNOW_LINK_RATE_TABLE_T* table, bool long_range)
+{
+    memset(table, 0, sizeof(*table));
+    table->lowest = long_range ? ESPNOW_LINK_RATE_LR_250K : ESPNOW_LINK_RATE_1M;
+}
+
+const ESPNOW_LINK_RATE_INFO_T* espnow_link_rate_info(ESPNOW_LINK_RATE_T rate)
+{
+    return &rates[(rate < ESPNOW_LINK_RATE_COUNT) ? rate : ESPNOW_LINK_RATE_1M];
+}
+
+uint32_t espnow_link_rate_frame_us(ESPNOW_LINK_RATE_T rate, uint16_t length)
+{
+    const ESPNOW_LINK_RATE_INFO_T* info = espnow_link_rate_info(rate);
+
+    return info->preamble_us + ((((uint32_t)length * 8000U) + info->kbps - 1U) / info->kbps);
+}
+
+ESPNOW_LINK_RATE_T espnow_link_rate_select(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, uint32_t now_ms, bool* reconfigure)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = find_peer(table, mac);
+    uint32_t rate;
+    uint32_t up;
+
+    *reconfigure = false;
+
+    if ((peer == NULL) && ((peer = add_peer(table, mac, now_ms)) == NULL))
+    {
+        return ESPNOW_LINK_RATE_1M;
+    }
+
+    if ((now_ms - peer->last_update_ms) >= ESPNOW_LINK_RATE_INTERVAL_MS)
+    {
+        update(table, peer, now_ms);
+    }
+
+    rate = peer->rate;
+    up = rate + 1U;
+
+    /* a rate up now and then, while rssi doesn't rule it out */
+    if (++peer->since_probe >= ESPNOW_LINK_RATE_PROBE_EVERY)
+    {
+        peer->since_probe = 0U;
+
+        if ((up < ESPNOW_LINK_RATE_COUNT) &&
+            (!peer->rssi_known || ((peer->rssi_x16 / 16) >= (rates[up].min_rssi - ESPNOW_LINK_RATE_PROBE_MARGIN_DB))))
+        {
+            rate = up;
+            peer->stats.probes++;
+        }
+    }
+
+    /* results come back in send order, so they are matched to their rate first in first out */
+    if (peer->in_flight_count < ESPNOW_LINK_TX_MAX_IN_FLIGHT)
+    {
+        peer->in_flight[(peer->in_flight_head + peer->in_flight_count) % ESPNOW_LINK_TX_MAX_IN_FLIGHT] = (uint8_t)rate;
+        peer->in_flight_count++;
+    }
+
+    peer->last_used_ms = now_ms;
+    *reconfigure = (peer->applied != (uint8_t)rate);
+    peer->applied = (uint8_t)rate;
+
+    return (ESPNOW_LINK_RATE_T)rate;
+}
+
+void espnow_link_rate_cancel(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = find_peer(table, mac);
+
+    if ((peer != NULL) && (peer->in_flight_count > 0U))
+    {
+        peer->in_flight_count--;
+    }
+}
+
+void espnow_link_rate_on_tx(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, bool acked)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = find_peer(table, mac);
+    uint32_t rate;
+
+    if ((peer == NULL) || (peer->in_flight_count == 0U))
+    {
+        return;
+    }
+
+    rate = peer->in_flight[peer->in_flight_head];
+    peer->in_flight_head = (uint8_t)((peer->in_flight_head + 1U) % ESPNOW_LINK_TX_MAX_IN_FLIGHT);
+    peer->in_flight_count--;
+
+    peer->attempts[rate]++;
+    peer->acked[rate] += acked ? 1U : 0U;
+    peer->samples[rate] += (peer->samples[rate] < UINT8_MAX) ? 1U : 0U;
+    peer->stats.frames_acked += acked ? 1U : 0U;
+    peer->stats.frames_failed += acked ? 0U : 1U;
+
+    if (rate != peer->rate)
+    {
+        return;
+    }
+
+    peer->failures = acked ? 0U : (uint8_t)(peer->failures + 1U);
+
+    /* the link just got worse. Drop a rate now, and make this one earn its way back with probes */
+    if ((peer->failures >= ESPNOW_LINK_RATE_FALLBACK_FAILURES) && (rate > (uint32_t)table->lowest))
+    {
+        peer->delivery[rate] = 0U;
+        peer->samples[rate] = 0U;
+        peer->attempts[rate] = 0U;
+        peer->acked[rate] = 0U;
+        set_rate(peer, (ESPNOW_LINK_RATE_T)(rate - 1U));
+    }
+}
+
+void espnow_link_rate_on_rx(ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, int8_t rssi, uint32_t now_ms)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = find_peer(table, mac);
+
+    if ((peer == NULL) && ((peer = add_peer(table, mac, now_ms)) == NULL))
+    {
+        return;
+    }
+
+    peer->rssi_x16 = peer->rssi_known ? (peer->rssi_x16 + ((((int32_t)rssi * 16) - peer->rssi_x16) / (1 << RSSI_SHIFT_D)))
+                                      : ((int32_t)rssi * 16);
+    peer->rssi_known = true;
+    peer->stats.rssi = (int8_t)(peer->rssi_x16 / 16);
+    peer->last_used_ms = now_ms;
+
+    /* nothing sent yet, so rssi is all there is to go on */
+    if ((peer->stats.frames_acked + peer->stats.frames_failed + peer->in_flight_count) == 0U)
+    {
+        set_rate(peer, rssi_rate(table, peer->stats.rssi));
+        peer->stats.rate_changes = 0U;
+    }
+}
+
+bool espnow_link_rate_get_stats(const ESPNOW_LINK_RATE_TABLE_T* table, const uint8_t* mac, ESPNOW_LINK_RATE_STATS_T* stats)
+{
+    ESPNOW_LINK_RATE_PEER_T* peer = find_peer((ESPNOW_LINK_RATE_TABLE_T*)table, mac);
+
+    if (peer == NULL)
+    {
+        return false;
+    }
+
+    *stats = peer->stats;
+    stats->delivery_permille = peer->delivery[peer->rate];
+
+    return true;
+}
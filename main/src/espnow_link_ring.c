@@ -0,0 +1,252 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_ring.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free single producer / single consumer receive ring for espnow_link
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "espnow_link_ring.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define DESC_BYTES_D ((uint32_t)sizeof(ESPNOW_LINK_RX_DESC_T))
+
+/* data_len value of a record that only pads out the end of the buffer */
+#define WRAP_MARKER_D (0xFFFFU)
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t bytes_to_end(const ESPNOW_LINK_RING_T* ring, uint32_t position);
+static uint32_t next_record(const ESPNOW_LINK_RING_T* ring, uint32_t position, bool* is_frame);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static uint32_t bytes_to_end(const ESPNOW_LINK_RING_T* ring, uint32_t position)
+{
+    return ring->size - (position & (ring->size - 1U));
+}
+
+/* position of record after the one at position. Only valid for a record the caller knows is intact */
+static uint32_t next_record(const ESPNOW_LINK_RING_T* ring, uint32_t position, bool* is_frame)
+{
+    uint32_t to_end = bytes_to_end(ring, position);
+    ESPNOW_LINK_RX_DESC_T desc;
+
+    *is_frame = false;
+
+    /* not enough room for a descriptor at the end of the buffer, both sides skip it implicitly */
+    if (to_end < DESC_BYTES_D)
+    {
+        return position + to_end;
+    }
+
+    memcpy(&desc, &ring->buffer[position & (ring->size - 1U)], DESC_BYTES_D);
+
+    if (desc.data_len == WRAP_MARKER_D)
+    {
+        return position + to_end;
+    }
+
+    *is_frame = true;
+
+    return position + ESPNOW_LINK_RING_RECORD_BYTES(desc.data_len);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool espnow_link_ring_init(ESPNOW_LINK_RING_T* ring, uint8_t* buffer, uint32_t size, ESPNOW_LINK_RING_POLICY_T policy)
+{
+    if ((ring == NULL) || (buffer == NULL) || (size < (2U * DESC_BYTES_D)) || ((size & (size - 1U)) != 0U) ||
+        (((uintptr_t)buffer % ESPNOW_LINK_RING_ALIGN) != 0U))
+    {
+        return false;
+    }
+
+    ring->buffer = buffer;
+    ring->size = size;
+    ring->policy = policy;
+    ring->high_water_bytes = 0U;
+    atomic_init(&ring->head, 0U);
+    atomic_init(&ring->tail, 0U);
+    atomic_init(&ring->dropped_newest, 0U);
+    atomic_init(&ring->dropped_oldest, 0U);
+    atomic_init(&ring->rejected, 0U);
+
+    return true;
+}
+
+void espnow_link_ring_set_policy(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RING_POLICY_T policy)
+{
+    ring->policy = policy;
+}
+
+bool espnow_link_ring_push(ESPNOW_LINK_RING_T* ring, const ESPNOW_LINK_RX_DESC_T* desc, const uint8_t* data)
+{
+    uint32_t needed = ESPNOW_LINK_RING_RECORD_BYTES(desc->data_len);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed); /* only we write head */
+    uint32_t to_end = bytes_to_end(ring, head);
+    uint32_t skip = (to_end < needed) ? to_end : 0U;
+    uint32_t used;
+
+    /* a record must always fit next to a wrap skip, otherwise the ring could never drain enough */
+    if ((desc->data_len == WRAP_MARKER_D) || (needed > (ring->size / 2U)))
+    {
+        atomic_fetch_add_explicit(&ring->rejected, 1U, memory_order_relaxed);
+        return false;
+    }
+
+    while (1U)
+    {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+        used = head - tail;
+
+        if ((ring->size - used) >= (skip + needed))
+        {
+            break;
+        }
+
+        if (ring->policy == ESPNOW_LINK_RING_DROP_NEWEST)
+        {
+            atomic_fetch_add_explicit(&ring->dropped_newest, 1U, memory_order_relaxed);
+            return false;
+        }
+
+        /*
+         * DROP_OLDEST: step tail past the oldest record. If the consumer moved tail first the
+         * CAS fails and we simply re-evaluate with the new tail. Wrap skips don't count as drops.
+         */
+        bool is_frame;
+        uint32_t new_tail = next_record(ring, tail, &is_frame);
+
+        if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, new_tail,
+                                                    memory_order_acq_rel, memory_order_acquire) && is_frame)
+        {
+            atomic_fetch_add_explicit(&ring->dropped_oldest, 1U, memory_order_relaxed);
+        }
+    }
+
+    if (skip > 0U)
+    {
+        if (skip >= DESC_BYTES_D)
+        {
+            ESPNOW_LINK_RX_DESC_T marker;
+
+            memset(&marker, 0U, DESC_BYTES_D);
+            marker.data_len = WRAP_MARKER_D;
+            memcpy(&ring->buffer[head & (ring->size - 1U)], &marker, DESC_BYTES_D);
+        }
+
+        head += skip;
+    }
+
+    memcpy(&ring->buffer[head & (ring->size - 1U)], desc, DESC_BYTES_D);
+    if (desc->data_len > 0U)
+    {
+        memcpy(&ring->buffer[(head & (ring->size - 1U)) + DESC_BYTES_D], data, desc->data_len);
+    }
+
+    /* publish record. release orders the copies above before the new head is visible */
+    atomic_store_explicit(&ring->head, head + needed, memory_order_release);
+
+    used += skip + needed;
+    if (used > ring->high_water_bytes)
+    {
+        ring->high_water_bytes = used;
+    }
+
+    return true;
+}
+
+bool espnow_link_ring_pop(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RX_DESC_T* desc, uint8_t* data, uint16_t data_capacity)
+{
+    while (1U)
+    {
+        uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint32_t to_end;
+        uint32_t index;
+        uint16_t copy_len;
+
+        if (tail == head)
+        {
+            return false;
+        }
+
+        to_end = bytes_to_end(ring, tail);
+        index = tail & (ring->size - 1U);
+
+        if (to_end < DESC_BYTES_D)
+        {
+            atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + to_end,
+                                                    memory_order_acq_rel, memory_order_acquire);
+            continue;
+        }
+
+        memcpy(desc, &ring->buffer[index], DESC_BYTES_D);
+
+        if (desc->data_len == WRAP_MARKER_D)
+        {
+            atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + to_end,
+                                                    memory_order_acq_rel, memory_order_acquire);
+            continue;
+        }
+
+        /*
+         * in DROP_OLDEST mode the producer may overwrite this record while we copy it. Bound the
+         * copy so a torn descriptor can't run off the buffer; the CAS below then fails and we retry.
+         */
+        copy_len = desc->data_len;
+        if (copy_len > (to_end - DESC_BYTES_D))
+        {
+            copy_len = (uint16_t)(to_end - DESC_BYTES_D);
+        }
+        if (copy_len > data_capacity)
+        {
+            copy_len = data_capacity;
+        }
+
+        if (copy_len > 0U)
+        {
+            memcpy(data, &ring->buffer[index + DESC_BYTES_D], copy_len);
+        }
+
+        if (atomic_compare_exchange_strong_explicit(&ring->tail, &tail, tail + ESPNOW_LINK_RING_RECORD_BYTES(desc->data_len),
+                                                    memory_order_acq_rel, memory_order_acquire))
+        {
+            desc->data_len = copy_len;
+            return true;
+        }
+    }
+}
+
+bool espnow_link_ring_is_empty(ESPNOW_LINK_RING_T* ring)
+{
+    return atomic_load_explicit(&ring->head, memory_order_acquire) ==
+           atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+uint32_t espnow_link_ring_used_bytes(ESPNOW_LINK_RING_T* ring)
+{
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    return atomic_load_explicit(&ring->head, memory_order_acquire) - tail;
+}
+
+void espnow_link_ring_get_stats(ESPNOW_LINK_RING_T* ring, ESPNOW_LINK_RING_STATS_T* stats)
+{
+    stats->dropped_newest = atomic_load_explicit(&ring->dropped_newest, memory_order_relaxed);
+    stats->dropped_oldest = atomic_load_explicit(&ring->dropped_oldest, memory_order_relaxed);
+    stats->rejected = atomic_load_explicit(&ring->rejected, memory_order_relaxed);
+    stats->high_water_bytes = ring->high_water_bytes;
+}
@@ -0,0 +1,168 @@
+/**
+ ********************************************************************************
+ * @file    espnow_link_tx.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Tracks frames handed to esp now that are waiting on their send callback
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "espnow_link_tx.h"
+#include <string.h>
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SLOT_MASK_D (ESPNOW_LINK_TX_MAX_IN_FLIGHT - 1U)
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void espnow_link_tx_init(ESPNOW_LINK_TX_TRACKER_T* tracker)
+{
+    uint32_t i;
+
+    for (i = 0U; i < ESPNOW_LINK_TX_MAX_IN_FLIGHT; i++)
+    {
+        atomic_init(&tracker->slots[i].handle, ESPNOW_LINK_TX_INVALID_HANDLE);
+        atomic_init(&tracker->slots[i].state, ESPNOW_LINK_TX_STATE_FREE);
+        memset(tracker->slots[i].peer_mac, 0U, sizeof(tracker->slots[i].peer_mac));
+        tracker->slots[i].callback = NULL;
+        tracker->slots[i].context = NULL;
+    }
+
+    atomic_init(&tracker->head, 0U);
+    atomic_init(&tracker->tail, 0U);
+    tracker->mac_mismatches = 0U;
+    tracker->unmatched_completions = 0U;
+}
+
+int32_t espnow_link_tx_reserve(ESPNOW_LINK_TX_TRACKER_T* tracker,
+                               const uint8_t* peer_mac,
+                               ESPNOW_LINK_TX_DONE_CB_T callback,
+                               void* context,
+                               ESPNOW_LINK_TX_HANDLE_T* handle)
+{
+    uint32_t tail = atomic_load_explicit(&tracker->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&tracker->head, memory_order_acquire);
+    ESPNOW_LINK_TX_SLOT_T* slot;
+
+    if ((tail - head) >= ESPNOW_LINK_TX_MAX_IN_FLIGHT)
+    {
+        return -1;
+    }
+
+    slot = &tracker->slots[tail & SLOT_MASK_D];
+
+    /* handle is position + 1 so it is never ESPNOW_LINK_TX_INVALID_HANDLE and maps straight to a slot */
+    *handle = tail + 1U;
+
+    /* invalidate handle first so a concurrent get_state on the old handle can't see the new state */
+    atomic_store_explicit(&slot->handle, ESPNOW_LINK_TX_INVALID_HANDLE, memory_order_relaxed);
+    atomic_store_explicit(&slot->state, ESPNOW_LINK_TX_STATE_PENDING, memory_order_relaxed);
+    memcpy(slot->peer_mac, peer_mac, sizeof(slot->peer_mac));
+    slot->callback = callback;
+    slot->context = context;
+    atomic_store_explicit(&slot->handle, *handle, memory_order_release);
+
+    /* publish before the frame goes to esp now, its callback may run before esp_now_send() returns */
+    atomic_store_explicit(&tracker->tail, tail + 1U, memory_order_release);
+
+    return (int32_t)(tail & SLOT_MASK_D);
+}
+
+void espnow_link_tx_cancel_last(ESPNOW_LINK_TX_TRACKER_T* tracker)
+{
+    uint32_t tail = atomic_load_explicit(&tracker->tail, memory_order_relaxed);
+    ESPNOW_LINK_TX_SLOT_T* slot;
+
+    if (tail == atomic_load_explicit(&tracker->head, memory_order_acquire))
+    {
+        return;
+    }
+
+    tail--;
+    slot = &tracker->slots[tail & SLOT_MASK_D];
+    atomic_store_explicit(&slot->handle, ESPNOW_LINK_TX_INVALID_HANDLE, memory_order_relaxed);
+    atomic_store_explicit(&slot->state, ESPNOW_LINK_TX_STATE_FREE, memory_order_relaxed);
+    atomic_store_explicit(&tracker->tail, tail, memory_order_release);
+}
+
+bool espnow_link_tx_complete(ESPNOW_LINK_TX_TRACKER_T* tracker,
+                             const uint8_t* peer_mac,
+                             bool success,
+                             ESPNOW_LINK_TX_COMPLETION_T* completion)
+{
+    uint32_t head = atomic_load_explicit(&tracker->head, memory_order_relaxed);
+    ESPNOW_LINK_TX_SLOT_T* slot;
+
+    if (head == atomic_load_explicit(&tracker->tail, memory_order_acquire))
+    {
+        tracker->unmatched_completions++;
+        return false;
+    }
+
+    slot = &tracker->slots[head & SLOT_MASK_D];
+
+    if ((peer_mac != NULL) && (memcmp(slot->peer_mac, peer_mac, sizeof(slot->peer_mac)) != 0))
+    {
+        tracker->mac_mismatches++;
+    }
+
+    /* copy out everything needed before head moves, after that the sender may reuse the slot */
+    completion->slot_index = head & SLOT_MASK_D;
+    completion->handle = atomic_load_explicit(&slot->handle, memory_order_relaxed);
+    completion->callback = slot->callback;
+    completion->context = slot->context;
+
+    atomic_store_explicit(&slot->state,
+                          success ? ESPNOW_LINK_TX_STATE_SUCCESS : ESPNOW_LINK_TX_STATE_FAILED,
+                          memory_order_release);
+    atomic_store_explicit(&tracker->head, head + 1U, memory_order_release);
+
+    return true;
+}
+
+ESPNOW_LINK_TX_STATE_T espnow_link_tx_get_state(ESPNOW_LINK_TX_TRACKER_T* tracker, ESPNOW_LINK_TX_HANDLE_T handle)
+{
+    ESPNOW_LINK_TX_SLOT_T* slot;
+    ESPNOW_LINK_TX_STATE_T state;
+
+    if (handle == ESPNOW_LINK_TX_INVALID_HANDLE)
+    {
+        return ESPNOW_LINK_TX_STATE_FREE;
+    }
+
+    slot = &tracker->slots[espnow_link_tx_slot_index(handle)];
+
+    /* read handle on both sides of state so a slot reused in between is detected */
+    if (atomic_load_explicit(&slot->handle, memory_order_acquire) != handle)
+    {
+        return ESPNOW_LINK_TX_STATE_FREE;
+    }
+
+    state = (ESPNOW_LINK_TX_STATE_T)atomic_load_explicit(&slot->state, memory_order_acquire);
+
+    if (atomic_load_explicit(&slot->handle, memory_order_acquire) != handle)
+    {
+        return ESPNOW_LINK_TX_STATE_FREE;
+    }
+
+    return state;
+}
+
+uint32_t espnow_link_tx_slot_index(ESPNOW_LINK_TX_HANDLE_T handle)
+{
+    return (handle - 1U) & SLOT_MASK_D;
+}
+
+uint32_t espnow_link_tx_in_flight(ESPNOW_LINK_TX_TRACKER_T* tracker)
+{
+    uint32_t head = atomic_load_explicit(&tracker->head, memory_order_acquire);
+
+    return atomic_load_explicit(&tracker->tail, memory_order_acquire) - head;
+}
@@ -0,0 +1,140 @@
+/**
+ ********************************************************************************
+ * @file    gf256.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Table driven GF(2^8) arithmetic, field polynomial x^8 + x^4 + x^3 + x^2 + 1
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "gf256.h"
+#include <stdbool.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define POLYNOMIAL_D (0x11DU)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+
+/* exp is doubled so log[a] + log[b] never needs reducing mod 255 */
+static uint8_t exp_table[512U];
+static uint8_t log_table[256U];
+static bool tables_ready = false;
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void gf256_init(void)
+{
+    uint32_t i;
+    uint32_t x = 1U;
+
+    if (tables_ready)
+    {
+        return;
+    }
+
+    for (i = 0U; i < 255U; i++)
+    {
+        exp_table[i] = (uint8_t)x;
+        exp_table[i + 255U] = (uint8_t)x;
+        log_table[x] = (uint8_t)i;
+
+        x <<= 1U;
+        if ((x & 0x100U) != 0U)
+        {
+            x ^= POLYNOMIAL_D;
+        }
+    }
+
+    exp_table[510U] = exp_table[0U];
+    exp_table[511U] = exp_table[1U];
+    log_table[0U] = 0U; /* unused, callers check for 0 first */
+
+    tables_ready = true;
+}
+
+uint8_t gf256_mul(uint8_t a, uint8_t b)
+{
+    if ((a == 0U) || (b == 0U))
+    {
+        return 0U;
+    }
+
+    return exp_table[(uint32_t)log_table[a] + log_table[b]];
+}
+
+uint8_t gf256_inv(uint8_t a)
+{
+    if (a == 0U)
+    {
+        return 0U;
+    }
+
+    return exp_table[255U - log_table[a]];
+}
+
+void gf256_mul_table(uint8_t c, GF256_MUL_TABLE_T* table)
+{
+    uint8_t i;
+
+    for (i = 0U; i < 16U; i++)
+    {
+        table->lo[i] = gf256_mul(c, i);
+        table->hi[i] = gf256_mul(c, (uint8_t)(i << 4U));
+    }
+}
+
+void gf256_mul_add_region(uint8_t* dst, const uint8_t* src, const GF256_MUL_TABLE_T* table, uint32_t length)
+{
+    uint32_t i;
+
+    /* multiplication distributes over xor, so c * b = c * (b & 0x0F) ^ c * (b & 0xF0) */
+    for (i = 0U; i < length; i++)
+    {
+        dst[i] ^= (uint8_t)(table->lo[src[i] & 0x0FU] ^ table->hi[src[i] >> 4U]);
+    }
+}
+
+void gf256_mul_region(uint8_t* buffer, const GF256_MUL_TABLE_T* table, uint32_t length)
+{
+    uint32_t i;
+
+    for (i = 0U; i < length; i++)
+    {
+        buffer[i] = (uint8_t)(table->lo[buffer[i] & 0x0FU] ^ table->hi[buffer[i] >> 4U]);
+    }
+}
+
+void gf256_add_region(uint8_t* dst, const uint8_t* src, uint32_t length)
+{
+    uint32_t i = 0U;
+
+    /* word at a time when both buffers allow it */
+    if ((((uintptr_t)dst | (uintptr_t)src) & 3U) == 0U)
+    {
+        for (; (i + 4U) <= length; i += 4U)
+        {
+            uint32_t a;
+            uint32_t b;
+
+            /* memcpy keeps this free of aliasing problems, it compiles to plain word loads */
+            memcpy(&a, &dst[i], 4U);
+            memcpy(&b, &src[i], 4U);
+            a ^= b;
+            memcpy(&dst[i], &a, 4U);
+        }
+    }
+
+    for (; i < length; i++)
+    {
+        dst[i] ^= src[i];
+    }
+}
@@ -0,0 +1,361 @@
+/**
+ ********************************************************************************
+ * @file    jitter_buffer.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Adaptive playout buffer with loss concealment
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "jitter_buffer.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SLOT_MASK_D (JITTER_BUFFER_SLOTS - 1U)
+#define Q15_ONE_D (32768)
+#define FADE_STEP_Q15_D (Q15_ONE_D / (int32_t)JITTER_BUFFER_CONCEAL_FRAMES)
+
+/* first comfort noise seed, any but 0 */
+#define NOISE_SEED_D (0x2545F491U)
+
+_Static_assert((JITTER_BUFFER_SLOTS & SLOT_MASK_D) == 0U, "jitter buffer slots must be a power of 2");
+_Static_assert(JITTER_BUFFER_MAX_FRAMES < JITTER_BUFFER_SLOTS, "jitter buffer needs a slot past its deepest target");
+_Static_assert(JITTER_BUFFER_MIN_FRAMES <= JITTER_BUFFER_MAX_FRAMES, "jitter buffer min frames is over max");
+_Static_assert(JITTER_BUFFER_CROSSFADE_SAMPLES <= ADPCM_BLOCK_SAMPLES, "crossfade is longer than a block");
+_Static_assert(AUDIO_VAD_SID_BYTES < ADPCM_HDR_BYTES, "silence marker must be shorter than any block");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void flush(JITTER_BUFFER_T* jb);
+static void update_jitter(JITTER_BUFFER_T* jb, uint32_t seq, uint32_t now_us);
+static void play_block(JITTER_BUFFER_T* jb, JITTER_BUFFER_SLOT_T* slot, int16_t* pcm);
+static void conceal(JITTER_BUFFER_T* jb, int16_t* pcm);
+static void trim(JITTER_BUFFER_T* jb);
+static void start_comfort(JITTER_BUFFER_T* jb, JITTER_BUFFER_SLOT_T* slot);
+static JITTER_BUFFER_RESULT_T play_comfort(JITTER_BUFFER_T* jb, int16_t* pcm);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void flush(JITTER_BUFFER_T* jb)
+{
+    uint32_t i;
+
+    for (i = 0U; i < JITTER_BUFFER_SLOTS; i++)
+    {
+        jb->slots[i].used = false;
+    }
+
+    jb->buffered = 0U;
+    jb->playing = false;
+    jb->have_transit = false;
+}
+
+/* transit is arrival less send time, with send time taken from seq. Its change between blocks is
+   arrival jitter, smoothed over 16 blocks. Target depth follows it */
+static void update_jitter(JITTER_BUFFER_T* jb, uint32_t seq, uint32_t now_us)
+{
+    int32_t transit = (int32_t)(now_us - (seq * JITTER_BUFFER_FRAME_US));
+    int32_t change;
+    uint32_t jitter_us;
+    uint32_t target;
+
+    if (jb->have_transit)
+    {
+        change = transit - jb->last_transit;
+        change = (change < 0) ? -change : change;
+        jb->jitter_us_x16 += (uint32_t)change - (jb->jitter_us_x16 >> 4U);
+    }
+
+    jb->have_transit = true;
+    jb->last_transit = transit;
+
+    jitter_us = jb->jitter_us_x16 >> 4U;
+    target = JITTER_BUFFER_MIN_FRAMES +
+             (((jitter_us * JITTER_BUFFER_JITTER_MULTIPLE) + JITTER_BUFFER_FRAME_US - 1U) / JITTER_BUFFER_FRAME_US);
+    jb->target_frames = (uint8_t)((target > JITTER_BUFFER_MAX_FRAMES) ? JITTER_BUFFER_MAX_FRAMES : target);
+}
+
+static void play_block(JITTER_BUFFER_T* jb, JITTER_BUFFER_SLOT_T* slot, int16_t* pcm)
+{
+    ADPCM_STATE_T carry_on = jb->state;
+    uint16_t samples = adpcm_decode_block(slot->block, slot->length, pcm, &jb->state);
+    int32_t weight;
+    int32_t faded;
+    uint32_t i;
+
+    memset(&pcm[samples], 0, (ADPCM_BLOCK_SAMPLES - samples) * sizeof(int16_t));
+
+    /* after a made up or skipped frame the block's own state won't match what was last heard.
+       Fade from where the concealed waveform would have gone on to the block */
+    if (jb->discontinuity && (jb->last_length != 0U))
+    {
+        (void)adpcm_decode_continue(jb->last_block, jb->last_length, &carry_on, jb->scratch);
+
+        for (i = 0U; i < JITTER_BUFFER_CROSSFADE_SAMPLES; i++)
+        {
+            weight = (int32_t)((i * (uint32_t)Q15_ONE_D) / JITTER_BUFFER_CROSSFADE_SAMPLES);
+            faded = (jb->scratch[i] * jb->gain_q15) >> 15;
+            pcm[i] = (int16_t)(((pcm[i] * weight) + (faded * (Q15_ONE_D - weight))) >> 15);
+        }
+    }
+
+    memcpy(jb->last_block, slot->block, slot->length);
+    jb->last_length = slot->length;
+    jb->gain_q15 = Q15_ONE_D;
+    jb->conceal_run = 0U;
+    jb->discontinuity = false;
+    jb->comfort = false;
+
+    slot->used = false;
+    jb->buffered--;
+    jb->next_seq++;
+    jb->stats.played++;
+}
+
+/* replays the last block's codes from the state the decoder was left in, so the waveform carries
+   on without a step, and fades it out over JITTER_BUFFER_CONCEAL_FRAMES frames */
+static void conceal(JITTER_BUFFER_T* jb, int16_t* pcm)
+{
+    int32_t end_gain = jb->gain_q15 - FADE_STEP_Q15_D;
+    int32_t gain;
+    uint32_t i;
+
+    end_gain = (end_gain < 0) ? 0 : end_gain;
+
+    memset(pcm, 0, ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+
+    if ((jb->last_length != 0U) && (jb->gain_q15 != 0))
+    {
+        (void)adpcm_decode_continue(jb->last_block, jb->last_length, &jb->state, pcm);
+
+        for (i = 0U; i < ADPCM_BLOCK_SAMPLES; i++)
+        {
+            gain = jb->gain_q15 - (((jb->gain_q15 - end_gain) * (int32_t)i) / (int32_t)ADPCM_BLOCK_SAMPLES);
+            pcm[i] = (int16_t)((pcm[i] * gain) >> 15);
+        }
+    }
+
+    jb->gain_q15 = end_gain;
+    jb->conceal_run++;
+    jb->discontinuity = true;
+    jb->stats.concealed++;
+}
+
+/* depth held over target for a while means jitter has settled, so skip a frame to cut latency */
+static void trim(JITTER_BUFFER_T* jb)
+{
+    JITTER_BUFFER_SLOT_T* slot;
+
+    if (jb->buffered <= jb->target_frames)
+    {
+        jb->excess_run = 0U;
+        return;
+    }
+
+    if (++jb->excess_run < JITTER_BUFFER_SHRINK_FRAMES)
+    {
+        return;
+    }
+
+    slot = &jb->slots[jb->next_seq & SLOT_MASK_D];
+
+    if (slot->used && (slot->seq == jb->next_seq))
+    {
+        slot->used = false;
+        jb->buffered--;
+    }
+
+    jb->next_seq++;
+    jb->excess_run = 0U;
+    jb->discontinuity = true;
+    jb->stats.dropped++;
+}
+
+/* sender went silent. Whatever it sends next starts a talk spurt of its own, buffered to target
+   depth again with no crossfade from before, and its transit starts the jitter estimate over, as
+   blocks may have been numbered straight through the silence or not */
+static void start_comfort(JITTER_BUFFER_T* jb, JITTER_BUFFER_SLOT_T* slot)
+{
+    (void)audio_vad_parse_sid(slot->block, slot->length, &jb->comfort_level);
+    jb->comfort = true;
+    jb->comfort_run = 0U;
+
+    jb->playing = false;
+    jb->have_transit = false;
+    jb->discontinuity = false;
+    jb->last_length = 0U;
+    jb->conceal_run = 0U;
+
+    slot->used = false;
+    jb->buffered--;
+    jb->next_seq++;
+}
+
+static JITTER_BUFFER_RESULT_T play_comfort(JITTER_BUFFER_T* jb, int16_t* pcm)
+{
+    if (jb->comfort_run >= JITTER_BUFFER_COMFORT_FRAMES)
+    {
+        /* markers stopped coming, stream is over */
+        jb->comfort = false;
+        memset(pcm, 0, ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+        return JITTER_BUFFER_IDLE;
+    }
+
+    audio_vad_comfort_noise(&jb->noise_seed, jb->comfort_level, pcm, ADPCM_BLOCK_SAMPLES);
+    jb->comfort_run++;
+    jb->stats.comfort++;
+
+    return JITTER_BUFFER_COMFORT;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void jitter_buffer_init(JITTER_BUFFER_T* jb)
+{
+    memset(jb, 0, sizeof(*jb));
+    jb->target_frames = JITTER_BUFFER_MIN_FRAMES;
+    jb->noise_seed = NOISE_SEED_D;
+}
+
+bool jitter_buffer_put(JITTER_BUFFER_T* jb, uint32_t seq, const uint8_t* block, uint16_t length, uint32_t now_us)
+{
+    JITTER_BUFFER_SLOT_T* slot;
+    int32_t ahead;
+    uint16_t level;
+
+    if (!audio_vad_parse_sid(block, length, &level) && ((length < ADPCM_HDR_BYTES) || (length > ADPCM_BLOCK_BYTES)))
+    {
+        return false;
+    }
+
+    if ((jb->buffered == 0U) && !jb->playing)
+    {
+        jb->next_seq = seq;
+        jb->newest_seq = seq;
+    }
+
+    update_jitter(jb, seq, now_us);
+    ahead = (int32_t)(seq - jb->next_seq);
+
+    if (ahead < 0)
+    {
+        /* before playout starts an earlier block may still come in out of order */
+        if (jb->playing || ((int32_t)(jb->newest_seq - seq) >= (int32_t)JITTER_BUFFER_SLOTS))
+        {
+            jb->stats.late++;
+            return false;
+        }
+
+        jb->next_seq = seq;
+    }
+    else if (ahead >= (int32_t)JITTER_BUFFER_SLOTS)
+    {
+        /* sender is far ahead of playout, start over from this block */
+        flush(jb);
+        jb->next_seq = seq;
+        jb->newest_seq = seq;
+        jb->stats.resyncs++;
+    }
+
+    slot = &jb->slots[seq & SLOT_MASK_D];
+
+    if (slot->used && (slot->seq == seq))
+    {
+        jb->stats.duplicates++;
+        return false;
+    }
+
+    slot->used = true;
+    slot->seq = seq;
+    slot->arrival_us = now_us;
+    slot->length = length;
+    memcpy(slot->block, block, length);
+
+    if ((int32_t)(seq - jb->newest_seq) > 0)
+    {
+        jb->newest_seq = seq;
+    }
+
+    jb->buffered++;
+    jb->stats.received++;
+
+    return true;
+}
+
+JITTER_BUFFER_RESULT_T jitter_buffer_get(JITTER_BUFFER_T* jb, uint32_t now_us, int16_t* pcm)
+{
+    JITTER_BUFFER_SLOT_T* slot = &jb->slots[jb->next_seq & SLOT_MASK_D];
+    bool present = slot->used && (slot->seq == jb->next_seq);
+
+    if (!jb->playing)
+    {
+        /* start once target depth is buffered, or the oldest block has waited as long as that takes */
+        if ((jb->buffered == 0U) ||
+            ((jb->buffered < jb->target_frames) &&
+             ((now_us - slot->arrival_us) < ((uint32_t)jb->target_frames * JITTER_BUFFER_FRAME_US))))
+        {
+            if (jb->comfort)
+            {
+                return play_comfort(jb, pcm);
+            }
+
+            memset(pcm, 0, ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+            return JITTER_BUFFER_IDLE;
+        }
+
+        jb->playing = true;
+        jb->excess_run = 0U;
+    }
+
+    if (present && (slot->length == AUDIO_VAD_SID_BYTES))
+    {
+        start_comfort(jb, slot);
+        return play_comfort(jb, pcm);
+    }
+
+    if (present)
+    {
+        play_block(jb, slot, pcm);
+        trim(jb);
+        return JITTER_BUFFER_FRAME;
+    }
+
+    if (jb->buffered == 0U)
+    {
+        if (jb->conceal_run >= JITTER_BUFFER_CONCEAL_FRAMES)
+        {
+            /* faded out with nothing left, stream is over */
+            jb->playing = false;
+            jb->have_transit = false;
+            jb->discontinuity = false;
+            jb->last_length = 0U;
+            memset(pcm, 0, ADPCM_BLOCK_SAMPLES * sizeof(int16_t));
+            return JITTER_BUFFER_IDLE;
+        }
+
+        /* block may just be late. Hold its turn, so playout delay grows by this frame */
+        conceal(jb, pcm);
+        jb->stats.underruns++;
+        return JITTER_BUFFER_CONCEALED;
+    }
+
+    /* later blocks are in, this one is lost */
+    conceal(jb, pcm);
+    jb->next_seq++;
+    jb->stats.lost++;
+
+    return JITTER_BUFFER_CONCEALED;
+}
+
+uint32_t jitter_buffer_jitter_us(const JITTER_BUFFER_T* jb)
+{
+    return jb->jitter_us_x16 >> 4U;
+}
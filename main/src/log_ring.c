@@ -0,0 +1,545 @@
+/**
+ ********************************************************************************
+ * @file    log_ring.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free queue of unformatted log records
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "log_ring.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define RING_MASK_D (LOG_RING_RECORDS - 1U)
+
+/* longest conversion spec copied out for snprintf, e.g. "%-08.3llx" */
+#define SPEC_LENGTH_D (16U)
+
+#define ELLIPSIS_D "..."
+
+_Static_assert((LOG_RING_RECORDS & RING_MASK_D) == 0U, "log ring records must be a power of 2");
+_Static_assert(LOG_RING_ARG_BYTES <= UINT8_MAX, "log record arg bytes must fit arg_bytes");
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+typedef enum
+{
+    ARG_NONE,           /* %%, takes nothing */
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_SIZE,
+    ARG_INTMAX,
+    ARG_PTRDIFF,
+    ARG_POINTER,
+    ARG_STRING,
+    ARG_DOUBLE,
+    ARG_LONG_DOUBLE,
+    ARG_UNSUPPORTED     /* * width or precision, %n, wide strings, unknown conversions */
+} ARG_TYPE_T;
+
+typedef struct
+{
+    const char* start;  /* the '%' */
+    uint32_t length;    /* through the conversion character */
+    ARG_TYPE_T type;
+} CONVERSION_T;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static const char* next_conversion(const char* format, CONVERSION_T* conversion);
+static uint32_t arg_size(ARG_TYPE_T type);
+static void encode_args(LOG_RECORD_T* record, va_list* args);
+static bool format_arg(const CONVERSION_T* conversion, const LOG_RECORD_T* record, uint32_t* offset, char* out,
+                       uint32_t size, uint32_t* length);
+static void append(char* out, uint32_t size, uint32_t* length, const char* text, uint32_t text_length);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* finds the next conversion spec at or after format. Returns NULL if there are none left */
+static const char* next_conversion(const char* format, CONVERSION_T* conversion)
+{
+    const char* c = strchr(format, '%');
+    bool is_long = false;
+    bool is_long_long = false;
+    ARG_TYPE_T integer = ARG_INT;
+
+    if (c == NULL)
+    {
+        return NULL;
+    }
+
+    conversion->start = c++;
+    conversion->type = ARG_UNSUPPORTED;
+
+    while ((*c != '\0') && (strchr("-+ #0", *c) != NULL))
+    {
+        c++;
+    }
+
+    while (((*c >= '0') && (*c <= '9')) || (*c == '.') || (*c == '*'))
+    {
+        if (*c == '*')
+        {
+            conversion->length = (uint32_t)(c + 1 - conversion->start);
+            return conversion->start;
+        }
+
+        c++;
+    }
+
+    switch (*c)
+    {
+    case 'h':
+        c += (c[1] == 'h') ? 2 : 1;
+        break;
+    case 'l':
+        is_long = true;
+        is_long_long = (c[1] == 'l');
+        integer = is_long_long ? ARG_LLONG : ARG_LONG;
+        c += is_long_long ? 2 : 1;
+        break;
+    case 'z':
+        integer = ARG_SIZE;
+        c++;
+        break;
+    case 'j':
+        integer = ARG_INTMAX;
+        c++;
+        break;
+    case 't':
+        integer = ARG_PTRDIFF;
+        c++;
+        break;
+    case 'L':
+        integer = ARG_LONG_DOUBLE;
+        c++;
+        break;
+    default:
+        break;
+    }
+
+    switch (*c)
+    {
+    case 'd':
+    case 'i':
+    case 'u':
+    case 'o':
+    case 'x':
+    case 'X':
+        conversion->type = (integer == ARG_LONG_DOUBLE) ? ARG_UNSUPPORTED : integer;
+        break;
+    case 'c':
+        conversion->type = is_long ? ARG_UNSUPPORTED : ARG_INT;
+        break;
+    case 's':
+        conversion->type = is_long ? ARG_UNSUPPORTED : ARG_STRING;
+        break;
+    case 'p':
+        conversion->type = ARG_POINTER;
+        break;
+    case 'f':
+    case 'F':
+    case 'e':
+    case 'E':
+    case 'g':
+    case 'G':
+    case 'a':
+    case 'A':
+        conversion->type = (integer == ARG_LONG_DOUBLE) ? ARG_LONG_DOUBLE : ARG_DOUBLE;
+        break;
+    case '%':
+        conversion->type = ARG_NONE;
+        break;
+    default:
+        break;
+    }
+
+    conversion->length = (uint32_t)(c + ((*c != '\0') ? 1 : 0) - conversion->start);
+
+    return conversion->start;
+}
+
+static uint32_t arg_size(ARG_TYPE_T type)
+{
+    switch (type)
+    {
+    case ARG_INT:
+        return sizeof(int);
+    case ARG_LONG:
+        return sizeof(long);
+    case ARG_LLONG:
+        return sizeof(long long);
+    case ARG_SIZE:
+        return sizeof(size_t);
+    case ARG_INTMAX:
+        return sizeof(intmax_t);
+    case ARG_PTRDIFF:
+        return sizeof(ptrdiff_t);
+    case ARG_POINTER:
+        return sizeof(void*);
+    case ARG_DOUBLE:
+        return sizeof(double);
+    case ARG_LONG_DOUBLE:
+        return sizeof(long double);
+    default:
+        return 0U;
+    }
+}
+
+/* copies each argument format asks for into record, packed in order at its own size */
+static void encode_args(LOG_RECORD_T* record, va_list* args)
+{
+    const char* format = record->format;
+    CONVERSION_T conversion;
+    uint32_t offset = 0U;
+    uint32_t size;
+    uint32_t copied;
+    const char* string;
+    union
+    {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        intmax_t j;
+        ptrdiff_t t;
+        void* p;
+        double d;
+        long double ld;
+    } value;
+
+    while ((format = next_conversion(format, &conversion)) != NULL)
+    {
+        format += conversion.length;
+
+        if (conversion.type == ARG_UNSUPPORTED)
+        {
+            record->truncated = true;
+            break;
+        }
+
+        if (conversion.type == ARG_NONE)
+        {
+            continue;
+        }
+
+        if (conversion.type == ARG_STRING)
+        {
+            string = va_arg(*args, const char*);
+            string = (string == NULL) ? "(null)" : string;
+            size = (uint32_t)strlen(string) + 1U;
+            copied = ((offset + size) > LOG_RING_ARG_BYTES) ? (LOG_RING_ARG_BYTES - offset) : size;
+
+            if (copied == 0U)
+            {
+                record->truncated = true;
+                break;
+            }
+
+            /* keep what fits of a long string, it is still worth reading */
+            memcpy(&record->args[offset], string, copied - 1U);
+            record->args[offset + copied - 1U] = '\0';
+            offset += copied;
+
+            if (copied < size)
+            {
+                record->truncated = true;
+                break;
+            }
+
+            continue;
+        }
+
+        switch (conversion.type)
+        {
+        case ARG_LONG:
+            value.l = va_arg(*args, long);
+            break;
+        case ARG_LLONG:
+            value.ll = va_arg(*args, long long);
+            break;
+        case ARG_SIZE:
+            value.z = va_arg(*args, size_t);
+            break;
+        case ARG_INTMAX:
+            value.j = va_arg(*args, intmax_t);
+            break;
+        case ARG_PTRDIFF:
+            value.t = va_arg(*args, ptrdiff_t);
+            break;
+        case ARG_POINTER:
+            value.p = va_arg(*args, void*);
+            break;
+        case ARG_DOUBLE:
+            value.d = va_arg(*args, double);
+            break;
+        case ARG_LONG_DOUBLE:
+            value.ld = va_arg(*args, long double);
+            break;
+        case ARG_INT:
+        default:
+            value.i = va_arg(*args, int);
+            break;
+        }
+
+        size = arg_size(conversion.type);
+
+        if ((offset + size) > LOG_RING_ARG_BYTES)
+        {
+            record->truncated = true;
+            break;
+        }
+
+        memcpy(&record->args[offset], &value, size);
+        offset += size;
+    }
+
+    record->arg_bytes = (uint8_t)offset;
+}
+
+/* formats one stored argument. Returns false when the record has no more arguments */
+static bool format_arg(const CONVERSION_T* conversion, const LOG_RECORD_T* record, uint32_t* offset, char* out,
+                       uint32_t size, uint32_t* length)
+{
+    char spec[SPEC_LENGTH_D];
+    uint32_t bytes = arg_size(conversion->type);
+    const uint8_t* arg = &record->args[*offset];
+    int written;
+    union
+    {
+        int i;
+        long l;
+        long long ll;
+        size_t z;
+        intmax_t j;
+        ptrdiff_t t;
+        void* p;
+        double d;
+        long double ld;
+    } value;
+
+    if (conversion->type == ARG_NONE)
+    {
+        append(out, size, length, "%", 1U);
+        return true;
+    }
+
+    if ((conversion->type == ARG_UNSUPPORTED) || (conversion->length >= SPEC_LENGTH_D))
+    {
+        return false;
+    }
+
+    if (conversion->type == ARG_STRING)
+    {
+        bytes = (*offset < record->arg_bytes) ? ((uint32_t)strlen((const char*)arg) + 1U) : 0U;
+    }
+
+    if ((bytes == 0U) || ((*offset + bytes) > record->arg_bytes))
+    {
+        return false;
+    }
+
+    memcpy(spec, conversion->start, conversion->length);
+    spec[conversion->length] = '\0';
+    memcpy(&value, arg, (conversion->type == ARG_STRING) ? 0U : bytes);
+    *offset += bytes;
+
+    switch (conversion->type)
+    {
+    case ARG_STRING:
+        written = snprintf(&out[*length], size - *length, spec, (const char*)arg);
+        break;
+    case ARG_LONG:
+        written = snprintf(&out[*length], size - *length, spec, value.l);
+        break;
+    case ARG_LLONG:
+        written = snprintf(&out[*length], size - *length, spec, value.ll);
+        break;
+    case ARG_SIZE:
+        written = snprintf(&out[*length], size - *length, spec, value.z);
+        break;
+    case ARG_INTMAX:
+        written = snprintf(&out[*length], size - *length, spec, value.j);
+        break;
+    case ARG_PTRDIFF:
+        written = snprintf(&out[*length], size - *length, spec, value.t);
+        break;
+    case ARG_POINTER:
+        written = snprintf(&out[*length], size - *length, spec, value.p);
+        break;
+    case ARG_DOUBLE:
+        written = snprintf(&out[*length], size - *length, spec, value.d);
+        break;
+    case ARG_LONG_DOUBLE:
+        written = snprintf(&out[*length], size - *length, spec, value.ld);
+        break;
+    case ARG_INT:
+    default:
+        written = snprintf(&out[*length], size - *length, spec, value.i);
+        break;
+    }
+
+    if (written > 0)
+    {
+        *length += (uint32_t)written;
+        *length = (*length >= size) ? (size - 1U) : *length;
+    }
+
+    return true;
+}
+
+static void append(char* out, uint32_t size, uint32_t* length, const char* text, uint32_t text_length)
+{
+    uint32_t room = size - 1U - *length;
+
+    text_length = (text_length > room) ? room : text_length;
+    memcpy(&out[*length], text, text_length);
+    *length += text_length;
+    out[*length] = '\0';
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void log_ring_init(LOG_RING_T* ring)
+{
+    uint32_t i;
+
+    /* a slot whose sequence equals the write position is free for that write, one equal to the
+       read position + 1 holds a finished record for that read */
+    for (i = 0U; i < LOG_RING_RECORDS; i++)
+    {
+        atomic_init(&ring->slots[i].sequence, i);
+    }
+
+    atomic_init(&ring->write_pos, 0U);
+    atomic_init(&ring->read_pos, 0U);
+    atomic_init(&ring->dropped, 0U);
+}
+
+bool log_ring_push(LOG_RING_T* ring, uint8_t level, const char* tag, const char* format, uint32_t timestamp_ms,
+                   va_list args)
+{
+    uint32_t pos = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+    LOG_RING_SLOT_T* slot;
+    int32_t ready;
+    va_list copy;
+
+    /* claim a slot by moving the write position past it. A producer preempted between claiming
+       and publishing only holds up the reader, never other producers */
+    for (;;)
+    {
+        slot = &ring->slots[pos & RING_MASK_D];
+        ready = (int32_t)(atomic_load_explicit(&slot->sequence, memory_order_acquire) - pos);
+
+        if (ready == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(
+                    &ring->write_pos, &pos, pos + 1U, memory_order_relaxed, memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (ready < 0)
+        {
+            /* slot still holds the record from a lap ago */
+            atomic_fetch_add_explicit(&ring->dropped, 1U, memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = atomic_load_explicit(&ring->write_pos, memory_order_relaxed);
+        }
+    }
+
+    slot->record.level = level;
+    slot->record.truncated = false;
+    slot->record.timestamp_ms = timestamp_ms;
+    slot->record.tag = tag;
+    slot->record.format = format;
+
+    va_copy(copy, args);
+    encode_args(&slot->record, &copy);
+    va_end(copy);
+
+    atomic_store_explicit(&slot->sequence, pos + 1U, memory_order_release);
+
+    return true;
+}
+
+bool log_ring_pop(LOG_RING_T* ring, LOG_RECORD_T* record)
+{
+    uint32_t pos = atomic_load_explicit(&ring->read_pos, memory_order_relaxed);
+    LOG_RING_SLOT_T* slot = &ring->slots[pos & RING_MASK_D];
+
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != (pos + 1U))
+    {
+        return false;
+    }
+
+    *record = slot->record;
+    atomic_store_explicit(&slot->sequence, pos + LOG_RING_RECORDS, memory_order_release);
+    atomic_store_explicit(&ring->read_pos, pos + 1U, memory_order_relaxed);
+
+    return true;
+}
+
+uint32_t log_ring_dropped(LOG_RING_T* ring)
+{
+    return atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+}
+
+uint32_t log_record_format(const LOG_RECORD_T* record, char* out, uint32_t size)
+{
+    const char* text = record->format;
+    const char* next;
+    CONVERSION_T conversion;
+    uint32_t offset = 0U;
+    uint32_t length = 0U;
+    bool complete = true;
+
+    if (size == 0U)
+    {
+        return 0U;
+    }
+
+    out[0] = '\0';
+
+    while ((next = next_conversion(text, &conversion)) != NULL)
+    {
+        append(out, size, &length, text, (uint32_t)(next - text));
+
+        if (!format_arg(&conversion, record, &offset, out, size, &length))
+        {
+            complete = false;
+            break;
+        }
+
+        text = next + conversion.length;
+    }
+
+    if (complete)
+    {
+        append(out, size, &length, text, (uint32_t)strlen(text));
+    }
+
+    if (record->truncated || !complete)
+    {
+        append(out, size, &length, ELLIPSIS_D, (uint32_t)strlen(ELLIPSIS_D));
+    }
+
+    return length;
+}
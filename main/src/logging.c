@@ -11,8 +11,13 @@
  * INCLUDES
  ************************************/
 #include "logging.h"
-#include <stdio.h>
 #include <stdarg.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "log_ring.h"
+#include "mem_report.h"
 
 /************************************
  * PRIVATE MACROS AND DEFINES
@@ -20,49 +25,215 @@
 #define TAG "LOGGING_WRAPPER"
 #define LOG_BUFFER_LENGTH_D (250U)
 
+/* below everything that does real work, it only has to keep up on average */
+#define LOGGING_TASK_PRIORITY_D (tskIDLE_PRIORITY + 1U)
+#define LOGGING_TASK_STACK_BYTES_D (3072U)
+#define LOGGING_FLUSH_MS_D (20U)
+
+/* esp levels are numbered the same way as logging_level_t */
+#ifdef CONFIG_LOG_DEFAULT_LEVEL
+#define LOGGING_DEFAULT_LEVEL_D ((logging_level_t)CONFIG_LOG_DEFAULT_LEVEL)
+#else
+#define LOGGING_DEFAULT_LEVEL_D (LOG_LEVEL_INFO)
+#endif
+
 /************************************
- * GLOBAL FUNCTIONS
+ * PRIVATE TYPEDEFS
  ************************************/
-void logging_log(logging_level_t level, const char* tag, const char* format, ...)
+typedef struct
 {
-    va_list args;
-    va_start(args, format);
+    const char* tag;
+    atomic_int level;
+} TAG_LEVEL_T;
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static LOG_RING_T ring;
+static atomic_bool ring_ready = false;
+
+/* tags given their own level. Entries are only ever added, count is bumped once one is filled in */
+static TAG_LEVEL_T tag_levels[LOGGING_MAX_TAGS];
+static atomic_uint_least32_t tag_count = 0U;
+static atomic_int default_level = LOGGING_DEFAULT_LEVEL_D;
+static portMUX_TYPE tag_levels_lock = portMUX_INITIALIZER_UNLOCKED;
 
-    char buffer[LOG_BUFFER_LENGTH_D];
+static TaskHandle_t logging_task_handle = NULL;
 
-    if (vsnprintf(buffer, LOG_BUFFER_LENGTH_D, format, args) > LOG_BUFFER_LENGTH_D)
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static TAG_LEVEL_T* find_tag(const char* tag);
+static logging_level_t effective_level(const char* tag);
+static void print_record(const LOG_RECORD_T* record, const char* text);
+static void logging_task(void* params);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static TAG_LEVEL_T* find_tag(const char* tag)
+{
+    uint32_t count = atomic_load_explicit(&tag_count, memory_order_acquire);
+    uint32_t i;
+
+    /* tags are literals, so the same pointer nearly always comes back */
+    for (i = 0U; i < count; i++)
     {
-        ESP_LOGE(
-            TAG,
-            "Message sent to logging_log() too long. Must be < %d characters\n", LOG_BUFFER_LENGTH_D
-        );
+        if (tag_levels[i].tag == tag)
+        {
+            return &tag_levels[i];
+        }
     }
 
-    switch (level)
+    for (i = 0U; i < count; i++)
+    {
+        if (strcmp(tag_levels[i].tag, tag) == 0)
+        {
+            return &tag_levels[i];
+        }
+    }
+
+    return NULL;
+}
+
+static logging_level_t effective_level(const char* tag)
+{
+    TAG_LEVEL_T* entry = find_tag(tag);
+
+    if (entry != NULL)
+    {
+        return (logging_level_t)atomic_load_explicit(&entry->level, memory_order_relaxed);
+    }
+
+    return (logging_level_t)atomic_load_explicit(&default_level, memory_order_relaxed);
+}
+
+static void print_record(const LOG_RECORD_T* record, const char* text)
+{
+    /* stamped with when the message was logged, not when it is printed */
+    switch (record->level)
     {
     case LOG_LEVEL_ERROR:
-        ESP_LOGE(tag, "%s", buffer);
+        esp_log_write(ESP_LOG_ERROR, record->tag, LOG_FORMAT(E, "%s"), record->timestamp_ms, record->tag, text);
         break;
     case LOG_LEVEL_DEBUG:
-        ESP_LOGD(tag, "%s", buffer);
+        esp_log_write(ESP_LOG_DEBUG, record->tag, LOG_FORMAT(D, "%s"), record->timestamp_ms, record->tag, text);
         break;
     case LOG_LEVEL_INFO:
-        ESP_LOGI(tag, "%s", buffer);
+        esp_log_write(ESP_LOG_INFO, record->tag, LOG_FORMAT(I, "%s"), record->timestamp_ms, record->tag, text);
         break;
     case LOG_LEVEL_WARNING:
-        ESP_LOGW(tag, "%s", buffer);
+        esp_log_write(ESP_LOG_WARN, record->tag, LOG_FORMAT(W, "%s"), record->timestamp_ms, record->tag, text);
         break;
     case LOG_LEVEL_VERBOSE:
     default:
-        ESP_LOGV(tag, "%s", buffer);
+        esp_log_write(ESP_LOG_VERBOSE, record->tag, LOG_FORMAT(V, "%s"), record->timestamp_ms, record->tag, text);
         break;
     }
+}
+
+static void logging_task(void* params)
+{
+    static char buffer[LOG_BUFFER_LENGTH_D];
+    LOG_RECORD_T record;
+    uint32_t dropped;
+    uint32_t reported = 0U;
+
+    while (1U)
+    {
+        while (log_ring_pop(&ring, &record))
+        {
+            (void)log_record_format(&record, buffer, LOG_BUFFER_LENGTH_D);
+            print_record(&record, buffer);
+        }
+
+        dropped = log_ring_dropped(&ring);
 
+        if (dropped != reported)
+        {
+            ESP_LOGW(TAG, "%lu log messages dropped, queue was full", (unsigned long)(dropped - reported));
+            reported = dropped;
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(LOGGING_FLUSH_MS_D));
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void logging_init(void)
+{
+    if (atomic_load(&ring_ready))
+    {
+        return;
+    }
+
+    log_ring_init(&ring);
+    atomic_store_explicit(&ring_ready, true, memory_order_release);
+
+    if (xTaskCreate(logging_task, "logging_task", LOGGING_TASK_STACK_BYTES_D, NULL, LOGGING_TASK_PRIORITY_D,
+                    &logging_task_handle) != pdPASS)
+    {
+        ESP_LOGE(TAG, "logging task setup failed, messages won't be printed");
+        return;
+    }
+
+    (void)mem_report_add_task(logging_task_handle);
+}
+
+void logging_write(logging_level_t level, const char* tag, const char* format, ...)
+{
+    va_list args;
+
+    /* filtered messages stop here, before anything is copied or formatted */
+    if ((level == LOG_LEVEL_NONE) || (level > effective_level(tag)) ||
+        !atomic_load_explicit(&ring_ready, memory_order_acquire))
+    {
+        return;
+    }
+
+    va_start(args, format);
+    (void)log_ring_push(&ring, (uint8_t)level, tag, format, esp_log_timestamp(), args);
     va_end(args);
 }
 
+uint32_t logging_dropped(void)
+{
+    return log_ring_dropped(&ring);
+}
+
 void logging_set_level_for_tag(logging_level_t level, const char* tag)
 {
+    TAG_LEVEL_T* entry;
+    uint32_t count;
+
+    /* "*" sets every tag, as it does for esp_log_level_set() */
+    if (strcmp(tag, "*") == 0)
+    {
+        atomic_store_explicit(&default_level, (int)level, memory_order_relaxed);
+    }
+    else
+    {
+        taskENTER_CRITICAL(&tag_levels_lock);
+
+        entry = find_tag(tag);
+        count = atomic_load_explicit(&tag_count, memory_order_relaxed);
+
+        if ((entry == NULL) && (count < LOGGING_MAX_TAGS))
+        {
+            entry = &tag_levels[count];
+            entry->tag = tag;
+            atomic_store_explicit(&entry->level, (int)level, memory_order_relaxed);
+            atomic_store_explicit(&tag_count, count + 1U, memory_order_release);
+        }
+        else if (entry != NULL)
+        {
+            atomic_store_explicit(&entry->level, (int)level, memory_order_relaxed);
+        }
+
+        taskEXIT_CRITICAL(&tag_levels_lock);
+    }
 
     /*
      * could define logging_level_t to be in same order as esp_log_level_t,
@@ -20,15 +20,46 @@
 
 #include "espnow_link.h"
 #include "logging.h"
+#include "mem_report.h"
 // #include "gpio.h"
 #include "driver/gpio.h"
 #include "wt20_protocol.h"
+#include "timing.h"
+#include "bench.h"
+#include "metrics.h"
+#include "console.h"
+#include "voice_store.h"
 
 /************************************
  * PRIVATE MACROS AND DEFINES
  ************************************/
 #define TAG "ESPNOW_LINK_EXAMPLE"
 
+/* frames are read and built in pool blocks, so this only has to cover call depth. Check the
+   watermark in the memory report before cutting it */
+#define PROTOCOL_TASK_STACK_BYTES_D (4096U)
+
+/* memory report is logged every this many sends, about every 10 s */
+#define MEM_REPORT_EVERY_D (1000)
+
+#ifdef CONFIG_WT20_BENCHMARK_FRAMES
+#define BENCH_FRAMES_D (CONFIG_WT20_BENCHMARK_FRAMES)
+#else
+#define BENCH_FRAMES_D (500U)
+#endif
+
+/* an echo not answered in this long counts as lost */
+#define BENCH_ECHO_TIMEOUT_MS_D (50U)
+
+/* load tests run in their own task, so the console stays responsive while one runs */
+#define LOAD_TASK_STACK_BYTES_D (3072U)
+#define LOAD_DEFAULT_FRAMES_D (1000U)
+
+/* ESP32-C6 datasheet typicals, radio receiving and modem sleep with the cpu running, for a
+   rough current estimate per power mode */
+#define RADIO_ON_MA_D (78U)
+#define RADIO_OFF_MA_D (27U)
+
 /************************************
  * STATIC VARIABLES
  ************************************/
@@ -38,54 +69,471 @@ static uint8_t mac2[6] = {0x40, 0x4C, 0xCA, 0x4D, 0x67, 0xEC};
 // static uint32_t gpio_level = GPIO_PIN_OFF;
 static uint32_t gpio_level = 0U;
 
+#ifdef CONFIG_WT20_CONSOLE
+static const uint8_t* console_peer_mac = NULL;
+static TaskHandle_t load_task_handle = NULL;
+static volatile bool load_running = false;
+static uint32_t load_frames;
+static uint16_t load_bytes;
+static uint32_t load_gap_ms;
+static uint8_t load_payload[WT20_PAYLOAD_BYTES];
+#endif
+
+#ifdef CONFIG_WT20_BENCHMARK
+static const uint16_t bench_payload_sizes[] = {4U, 64U, 128U, WT20_PAYLOAD_BYTES};
+static uint8_t bench_payload[WT20_PAYLOAD_BYTES];
+static WT20_MSG_T bench_msg;
+static BENCH_HIST_T bench_hist;
+static char bench_line[BENCH_LINE_BYTES];
+#endif
+
 /************************************
  * STATIC FUNCTIONS
  ************************************/
 
-void wt20_protocol_task(void* params)
+void handle_message(const WT20_MSG_T* msg, void* context)
 {
+    logging_log(
+        LOG_LEVEL_VERBOSE,
+        TAG,
+        "Message received from mac " MACSTR ". Command = %d", MAC2STR(msg->src_mac), msg->command
+    );
 
-    printf("Test\n");
-    WT20_MSG_T msg;
-    WT20_ERR_T ret;
+    /* process message */
+    switch (msg->command)
+    {
+    case WT20_COMMAND_TOGGLE_LED:
+        // gpio_set_pin_level(LED_PIN, gpio_level);
+        gpio_set_level(2U, gpio_level);
+        // gpio_level = (gpio_level == GPIO_PIN_ON) ? GPIO_PIN_OFF : GPIO_PIN_ON;
+        gpio_level = !gpio_level;
+        break;
 
-    while (1U)
+    case WT20_COMMAND_SEND_PAYLOAD:
+#ifndef CONFIG_WT20_BENCHMARK
+        printf("Message: %s\n", (char*)msg->payload);
+#endif
+
+    default:
+        break;
+    }
+}
+
+void handle_long_message(const uint8_t* src_mac, const uint8_t* message, uint32_t length, void* context)
+{
+    VOICE_STORE_ERR_T err;
+    uint16_t id;
+
+    logging_log(LOG_LEVEL_INFO, TAG, "Received %lu byte message from mac " MACSTR, (unsigned long)length, MAC2STR(src_mac));
+
+    /* kept until it is played, the protocol task is the only one using the store */
+    err = voice_store_begin(&id);
+    err = (err == VOICE_STORE_OK) ? voice_store_append(message, length) : err;
+
+    if (err == VOICE_STORE_OK)
+    {
+        err = voice_store_finish();
+    }
+    else if (err != VOICE_STORE_ERR_NOT_MOUNTED)
+    {
+        (void)voice_store_finish();
+    }
+
+    if (err == VOICE_STORE_OK)
     {
-        /* get message */
-        ret = wt20_protocol_function(&msg);
+        logging_log(LOG_LEVEL_INFO, TAG, "Stored message %u, %lu in flash", id, (unsigned long)voice_store_count());
+    }
+}
+
+#ifdef CONFIG_WT20_BENCHMARK
+static void bench_print(BENCH_RESULT_T* result)
+{
+    result->link = "device";
+    result->latency = (result->latency != NULL) && (result->latency->count > 0U) ? result->latency : NULL;
+    result->rtt = (result->rtt != NULL) && (result->rtt->count > 0U) ? result->rtt : NULL;
+
+    (void)bench_format_result(result, bench_line, sizeof(bench_line));
+    printf("%s\n", bench_line);
+}
 
-        if (ret == WT20_ERR_NONE)
+/* back to back writes. Clocks aren't shared, so latency is how long wt20_write() blocks, send to
+   ack, and a frame counts as received once the peer's MAC layer acked it. Unacked writes return
+   WT20_SEND_FAILURE, so lost frames count against delivery and goodput */
+static void bench_write(const uint8_t* peer_mac, uint16_t size)
+{
+    BENCH_RESULT_T result = {.name = "write", .payload_bytes = size, .sent = BENCH_FRAMES_D, .latency = &bench_hist};
+    uint32_t start_us = timing_get_us();
+    uint32_t sent_us;
+    uint32_t i;
+
+    bench_hist_init(&bench_hist);
+
+    for (i = 0U; i < BENCH_FRAMES_D; i++)
+    {
+        sent_us = timing_get_us();
+
+        if (wt20_write(peer_mac, WT20_COMMAND_SEND_PAYLOAD, bench_payload, size) == WT20_ERR_NONE)
         {
-            logging_log(
-                LOG_LEVEL_VERBOSE,
-                TAG,
-                "Message received from mac " MACSTR ". Command = %d", msg.command
-            );
-
-            /* process message */
-            switch (msg.command)
+            bench_hist_add(&bench_hist, timing_get_us() - sent_us);
+            result.received++;
+            result.bytes += size;
+        }
+    }
+
+    result.elapsed_us = timing_get_us() - start_us;
+    bench_print(&result);
+}
+
+/* one echo at a time, round trip on this device's clock. The peer answers from its protocol task */
+static void bench_echo(const uint8_t* peer_mac, uint16_t size)
+{
+    BENCH_RESULT_T result = {.name = "echo", .payload_bytes = size, .sent = BENCH_FRAMES_D, .rtt = &bench_hist};
+    uint32_t start_us = timing_get_us();
+    uint32_t sent_us;
+    uint32_t i;
+
+    bench_hist_init(&bench_hist);
+
+    for (i = 0U; i < BENCH_FRAMES_D; i++)
+    {
+        /* the send time tags the request, so a late reply to an earlier one isn't counted */
+        sent_us = timing_get_us();
+        memcpy(bench_payload, &sent_us, sizeof(sent_us));
+        (void)wt20_write(peer_mac, WT20_COMMAND_ECHO_REQUEST, bench_payload, size);
+
+        while ((timing_get_us() - sent_us) < (BENCH_ECHO_TIMEOUT_MS_D * 1000U))
+        {
+            if ((wt20_receive(&bench_msg, BENCH_ECHO_TIMEOUT_MS_D) == WT20_ERR_NONE) &&
+                (bench_msg.command == WT20_COMMAND_ECHO_REPLY) && (bench_msg.length == size) &&
+                (memcmp(bench_msg.payload, &sent_us, sizeof(sent_us)) == 0))
             {
-            case WT20_COMMAND_TOGGLE_LED:
-                // gpio_set_pin_level(LED_PIN, gpio_level);
-                gpio_set_level(2U, gpio_level);
-                // gpio_level = (gpio_level == GPIO_PIN_ON) ? GPIO_PIN_OFF : GPIO_PIN_ON;
-                gpio_level = !gpio_level;
+                bench_hist_add(&bench_hist, timing_get_us() - sent_us);
+                result.received++;
+                result.bytes += size;
                 break;
+            }
+        }
+    }
 
-            case WT20_COMMAND_SEND_PAYLOAD:
-                printf("Message: %s\n", (char*)msg.payload);
-            
-            default:
-                break;
+    result.elapsed_us = timing_get_us() - start_us;
+    bench_print(&result);
+}
+
+/* runs on the device with mac1, with the peer's protocol task answering. Results go to the
+   console as BENCH lines, the same format as the host benchmark */
+static void bench_run(const uint8_t* peer_mac)
+{
+    uint32_t i;
+
+    for (i = 0U; i < (sizeof(bench_payload_sizes) / sizeof(bench_payload_sizes[0])); i++)
+    {
+        bench_write(peer_mac, bench_payload_sizes[i]);
+        bench_echo(peer_mac, bench_payload_sizes[i]);
+    }
+
+    mem_report_log();
+}
+#endif
+
+#ifdef CONFIG_WT20_CONSOLE
+static void print_metrics(void)
+{
+    static METRICS_SNAPSHOT_T snapshot;
+    const METRICS_TIMER_T* timer;
+    const METRICS_PEER_T* peer;
+    uint32_t i;
+
+    metrics_snapshot(&snapshot);
+
+    for (i = 0U; i < METRIC_COUNT; i++)
+    {
+        printf("%-26s %lu\n", metrics_name((METRIC_ID_T)i), (unsigned long)snapshot.values[i]);
+    }
+
+    for (i = 0U; i < METRIC_TIMER_COUNT; i++)
+    {
+        timer = &snapshot.timers[i];
+        printf("%-26s n %lu min %lu mean %lu max %lu\n", metrics_timer_name((METRIC_TIMER_ID_T)i),
+               (unsigned long)timer->count, (unsigned long)timer->min_us, (unsigned long)timer->mean_us,
+               (unsigned long)timer->max_us);
+    }
+
+    for (i = 0U; i < snapshot.peer_count; i++)
+    {
+        peer = &snapshot.peers[i];
+        printf("peer " MACSTR " frames %lu rssi last %d min %d mean %d max %d\n", MAC2STR(peer->mac),
+               (unsigned long)peer->frames, peer->last_rssi, peer->min_rssi, peer->mean_rssi, peer->max_rssi);
+    }
+}
+
+static void metrics_command(uint32_t argc, char** argv)
+{
+    if ((argc > 1U) && (strcmp(argv[1], "reset") == 0))
+    {
+        metrics_reset();
+        printf("metrics reset\n");
+        return;
+    }
+
+    print_metrics();
+}
+
+static void peers_command(uint32_t argc, char** argv)
+{
+    ESPNOW_LINK_RATE_STATS_T rate;
+    WT20_PEER_T peer;
+    uint32_t id;
+
+    for (id = 1U; id <= WT20_PEER_MAX; id++)
+    {
+        if (wt20_get_peer((WT20_PEER_ID_T)id, &peer) == WT20_ERR_NONE)
+        {
+            printf("%2lu " MACSTR " rx %lu dup %lu tx %lu failed %lu rssi %d heard %lu ms ago\n", (unsigned long)id,
+                   MAC2STR(peer.mac), (unsigned long)peer.stats.frames_rx, (unsigned long)peer.stats.duplicates,
+                   (unsigned long)peer.stats.frames_tx, (unsigned long)peer.stats.tx_failures, peer.stats.last_rssi,
+                   (unsigned long)(timing_get_ms() - peer.stats.last_heard_ms));
+
+            if (espnow_link_get_peer_rate(peer.mac, &rate) == ESPNOW_LINK_ERR_NONE)
+            {
+                printf("   rate %lu kbps delivery %u.%u%% probes %lu changes %lu\n", (unsigned long)rate.kbps,
+                       (unsigned)(rate.delivery_permille / 10U), (unsigned)(rate.delivery_permille % 10U),
+                       (unsigned long)rate.probes, (unsigned long)rate.rate_changes);
             }
         }
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(1U));
+static void print_power_stats(void)
+{
+    static const char* const names[ESPNOW_LINK_POWER_MODES] = {"always on", "save"};
+    ESPNOW_LINK_POWER_STATS_T stats;
+    const ESPNOW_LINK_POWER_MODE_STATS_T* mode;
+    uint32_t on_permille;
+    uint32_t i;
+
+    espnow_link_get_power_stats(&stats);
+    printf("power mode %s, beacons sent %lu heard %lu\n", names[stats.mode], (unsigned long)stats.beacons_sent,
+           (unsigned long)stats.beacons_heard);
+
+    for (i = 0U; i < ESPNOW_LINK_POWER_MODES; i++)
+    {
+        mode = &stats.modes[i];
+
+        if (mode->mode_ms == 0U)
+        {
+            continue;
+        }
+
+        on_permille = (uint32_t)(((uint64_t)mode->radio_on_ms * 1000U) / mode->mode_ms);
+        printf("%-10s %lu ms, radio on %lu.%lu%%, ~%lu mA, sent %lu held %lu mean hold %lu ms\n", names[i],
+               (unsigned long)mode->mode_ms, (unsigned long)(on_permille / 10U), (unsigned long)(on_permille % 10U),
+               (unsigned long)(RADIO_OFF_MA_D + (((RADIO_ON_MA_D - RADIO_OFF_MA_D) * on_permille) / 1000U)),
+               (unsigned long)mode->frames_sent, (unsigned long)mode->frames_held,
+               (unsigned long)((mode->frames_held > 0U) ? (mode->hold_ms / mode->frames_held) : 0U));
+    }
+}
+
+/* power [on|save]. "on" is what a push to talk session uses */
+static void power_command(uint32_t argc, char** argv)
+{
+    ESPNOW_LINK_ERR_T err = ESPNOW_LINK_ERR_NONE;
+
+    if ((argc > 1U) && (strcmp(argv[1], "on") == 0))
+    {
+        err = espnow_link_set_power_mode(ESPNOW_LINK_POWER_ALWAYS_ON);
+    }
+    else if ((argc > 1U) && (strcmp(argv[1], "save") == 0))
+    {
+        err = espnow_link_set_power_mode(ESPNOW_LINK_POWER_SAVE);
+    }
+
+    if (err != ESPNOW_LINK_ERR_NONE)
+    {
+        printf("power save is not enabled in this build\n");
+    }
+
+    print_power_stats();
+}
+
+/* relay [on|off] */
+static void relay_command(uint32_t argc, char** argv)
+{
+    WT20_RELAY_STATS_T stats;
+
+    if (argc > 1U)
+    {
+        (void)wt20_set_relay(strcmp(argv[1], "on") == 0);
+    }
+
+    (void)wt20_get_relay_stats(&stats);
+    printf("relay sent %lu delivered %lu forwarded %lu duplicates %lu hop limit %lu queue full %lu\n",
+           (unsigned long)stats.frames_sent, (unsigned long)stats.frames_delivered,
+           (unsigned long)stats.frames_forwarded, (unsigned long)stats.duplicates, (unsigned long)stats.hop_limit,
+           (unsigned long)stats.queue_full);
+}
+
+/* channel [scan|auto|N]. scan only prints the survey, auto moves the group if it finds a clearly better channel */
+static void channel_command(uint32_t argc, char** argv)
+{
+    static ESPNOW_LINK_CHAN_SURVEY_T survey;
+    ESPNOW_LINK_CHAN_STATS_T link_stats;
+    WT20_CHAN_STATS_T stats;
+    uint32_t score;
+    uint8_t channel;
+
+    if ((argc > 1U) && (strcmp(argv[1], "scan") == 0))
+    {
+        if (espnow_link_scan_channels(ESPNOW_LINK_CHAN_DWELL_MS, &survey) == ESPNOW_LINK_ERR_NONE)
+        {
+            for (channel = ESPNOW_LINK_CHAN_FIRST; channel <= ESPNOW_LINK_CHAN_LAST; channel++)
+            {
+                score = espnow_link_chan_score(&survey, channel);
+                printf("channel %2u: %lu frames, busy %lu us, score %lu\n", channel,
+                       (unsigned long)survey.channels[channel - ESPNOW_LINK_CHAN_FIRST].frames,
+                       (unsigned long)survey.channels[channel - ESPNOW_LINK_CHAN_FIRST].busy_us, (unsigned long)score);
+            }
+
+            printf("pick %u\n", espnow_link_chan_pick(&survey, espnow_link_get_wifi_channel()));
+        }
+    }
+    else if ((argc > 1U) && (strcmp(argv[1], "auto") == 0))
+    {
+        if (wt20_auto_channel(ESPNOW_LINK_CHAN_DWELL_MS, &channel) == WT20_ERR_NONE)
+        {
+            printf("moving to channel %u\n", channel);
+        }
+    }
+    else if (argc > 1U)
+    {
+        if (wt20_switch_channel((uint8_t)strtoul(argv[1], NULL, 0)) != WT20_ERR_NONE)
+        {
+            printf("channels are %u to %u\n", ESPNOW_LINK_CHAN_FIRST, ESPNOW_LINK_CHAN_LAST);
+        }
+    }
+
+    espnow_link_get_chan_stats(&link_stats);
+    (void)wt20_get_chan_stats(&stats);
+    printf("channel %u, rssi %d noise %d dBm, delivery %u.%u%%%s, switches %lu\n", link_stats.channel, link_stats.rssi,
+           link_stats.noise_floor, link_stats.delivery_permille / 10U, link_stats.delivery_permille % 10U,
+           link_stats.degraded ? " (degraded)" : "", (unsigned long)link_stats.switches);
+    printf("handshake switches %lu announcements %lu acks sent %lu received %lu unacked %lu conflicts %lu\n",
+           (unsigned long)stats.switches, (unsigned long)stats.announcements_sent, (unsigned long)stats.acks_sent,
+           (unsigned long)stats.acks_received, (unsigned long)stats.unacked, (unsigned long)stats.conflicts);
+}
+
+static void mem_command(uint32_t argc, char** argv)
+{
+    mem_report_log();
+}
+
+/* load [frames] [bytes] [gap_ms] */
+static void load_command(uint32_t argc, char** argv)
+{
+    uint32_t bytes = (argc > 2U) ? strtoul(argv[2], NULL, 0) : WT20_PAYLOAD_BYTES;
+
+    if (load_task_handle == NULL)
+    {
+        printf("load test unavailable, its task wasn't created\n");
+        return;
+    }
+
+    if (load_running)
+    {
+        printf("load test already running\n");
+        return;
+    }
+
+    load_frames = (argc > 1U) ? strtoul(argv[1], NULL, 0) : LOAD_DEFAULT_FRAMES_D;
+    load_bytes = (uint16_t)((bytes > WT20_PAYLOAD_BYTES) ? WT20_PAYLOAD_BYTES : bytes);
+    load_gap_ms = (argc > 3U) ? strtoul(argv[3], NULL, 0) : 0U;
+    load_running = true;
+    xTaskNotifyGive(load_task_handle);
+}
+
+/* writes load_frames frames to the peer when the console asks, then prints how it went. A frame
+   the peer's MAC layer didn't ack counts as failed */
+static void load_task(void* params)
+{
+    uint32_t start_us;
+    uint32_t elapsed_us;
+    uint32_t failed;
+    uint32_t i;
+
+    while (1U)
+    {
+        (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        printf("load: %lu frames of %u bytes to " MACSTR "\n", (unsigned long)load_frames, load_bytes,
+               MAC2STR(console_peer_mac));
+        failed = 0U;
+        start_us = timing_get_us();
+
+        for (i = 0U; i < load_frames; i++)
+        {
+            failed += (wt20_write(console_peer_mac, WT20_COMMAND_SEND_PAYLOAD, load_payload, load_bytes) == WT20_ERR_NONE) ? 0U : 1U;
+
+            if (load_gap_ms > 0U)
+            {
+                vTaskDelay(pdMS_TO_TICKS(load_gap_ms));
+            }
+        }
+
+        elapsed_us = timing_get_us() - start_us;
+        elapsed_us = (elapsed_us > 0U) ? elapsed_us : 1U;
+        printf("load: %lu sent, %lu failed, %lu ms, %lu frames/s\n", (unsigned long)load_frames, (unsigned long)failed,
+               (unsigned long)(elapsed_us / 1000U), (unsigned long)(((uint64_t)load_frames * 1000000U) / elapsed_us));
+        load_running = false;
+    }
+}
+
+static void console_setup(const uint8_t* peer_mac)
+{
+    static const CONSOLE_COMMAND_T commands[] = {
+        {"metrics", "prints link and protocol metrics, \"metrics reset\" zeroes them", metrics_command},
+        {"peers", "lists peers with their ids, stats and PHY rate", peers_command},
+        {"power", "power [on|save], sets the radio power mode and prints time, duty and frames per mode", power_command},
+        {"relay", "relay [on|off], passes on other units' relayed frames and prints relay stats", relay_command},
+        {"channel", "channel [scan|auto|N], surveys channels or moves the group, and prints channel stats", channel_command},
+        {"mem", "logs pool, stack and heap use", mem_command},
+        {"load", "load [frames] [bytes] [gap_ms], writes frames to the peer", load_command}
+    };
+    uint32_t i;
+
+    console_peer_mac = peer_mac;
+    console_init();
+
+    for (i = 0U; i < (sizeof(commands) / sizeof(commands[0])); i++)
+    {
+        (void)console_register(&commands[i]);
+    }
+
+    if (xTaskCreate(load_task, "load_task", LOAD_TASK_STACK_BYTES_D, NULL, 1, &load_task_handle) == pdPASS)
+    {
+        (void)mem_report_add_task(load_task_handle);
+    }
+
+    (void)console_uart_start();
+}
+#endif
+
+void wt20_protocol_task(void* params)
+{
+
+    printf("Test\n");
+
+    while (1U)
+    {
+        /* sleep until the receive callback wakes us, then handle everything that arrived */
+        wt20_receive_all(handle_message, NULL, WT20_WAIT_FOREVER, NULL);
     }
 }
 
 void app_main(void)
 {
+    TaskHandle_t protocol_task;
+
+    logging_init();
+
     /* Initialize gpio */
     // gpio_setup_pin(LED_PIN, GPIO_PIN_OUTPUT);
     gpio_reset_pin(2U);
@@ -94,6 +542,11 @@ void app_main(void)
     /* Initialize WT20 */
     wt20_init();
 
+    if (voice_store_mount() != VOICE_STORE_OK)
+    {
+        logging_log(LOG_LEVEL_WARNING, TAG, "No voice partition, messages won't be kept");
+    }
+
     /* get mac and determine whether to register mac1 or mac2 as a peer */
     uint8_t device_mac[6U];
     wt20_get_device_mac(device_mac);
@@ -103,17 +556,40 @@ void app_main(void)
 
     /* add contact */
     wt20_add_contact(peer_mac);
+    wt20_set_message_callback(handle_long_message, NULL);
+
+#ifdef CONFIG_WT20_CONSOLE
+    console_setup(peer_mac);
+#endif
+
+#ifdef CONFIG_WT20_BENCHMARK
+    /* the protocol task would take the echo replies, so the measuring side doesn't start it */
+    if (is_mac1)
+    {
+        bench_run(peer_mac);
+        return;
+    }
+#endif
 
     /* start protocol */
     xTaskCreate(
         wt20_protocol_task,
         "wt20_protocol_task",
-        4096, /* 4kb stack */
+        PROTOCOL_TASK_STACK_BYTES_D,
         NULL,
         1,
-        NULL
+        &protocol_task
     );
 
+    (void)mem_report_add_task(protocol_task);
+
+#ifdef CONFIG_WT20_BENCHMARK
+    /* answering side, the protocol task replies to echoes */
+    return;
+#endif
+
+    (void)mem_report_add_task(xTaskGetCurrentTaskHandle());
+
     /* send 250 messages to peer*/
     // char send_buffer[250U];
     for(int i = 0; i < 2000; i++)
@@ -121,6 +597,11 @@ void app_main(void)
         wt20_write(peer_mac, WT20_COMMAND_TOGGLE_LED, NULL, 0U);
         vTaskDelay(pdMS_TO_TICKS(10U));
 
+        if ((i % MEM_REPORT_EVERY_D) == 0)
+        {
+            mem_report_log();
+        }
+
         // gpio_set_pin_level(LED_PIN, current_led);
         // current_led = !current_led;
         // logging_log(LOG_LEVEL_VERBOSE, TAG, "set led to status %d", current_led);
@@ -0,0 +1,151 @@
+/**
+ ********************************************************************************
+ * @file    mem_pool.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Lock-free fixed block pools
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "mem_pool.h"
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define ALL_FREE_D(blocks) (0xFFFFFFFFUL >> (MEM_POOL_MAX_BLOCKS - (blocks)))
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+
+/* only changed by mem_pool_init(), which runs before pools are shared */
+static MEM_POOL_T* registered_pools = NULL;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void register_pool(MEM_POOL_T* pool);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void register_pool(MEM_POOL_T* pool)
+{
+    MEM_POOL_T* registered;
+
+    for (registered = registered_pools; registered != NULL; registered = registered->next)
+    {
+        if (registered == pool)
+        {
+            return;
+        }
+    }
+
+    pool->next = registered_pools;
+    registered_pools = pool;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool mem_pool_init(MEM_POOL_T* pool, const char* name, void* storage, uint32_t block_bytes, uint32_t blocks)
+{
+    if ((storage == NULL) || (((uintptr_t)storage & (MEM_POOL_ALIGN - 1U)) != 0U) || (block_bytes == 0U) ||
+        (blocks == 0U) || (blocks > MEM_POOL_MAX_BLOCKS))
+    {
+        return false;
+    }
+
+    pool->name = name;
+    pool->storage = (uint8_t*)storage;
+    pool->stride = MEM_POOL_BLOCK_STRIDE(block_bytes);
+    pool->block_bytes = block_bytes;
+    pool->blocks = blocks;
+    atomic_init(&pool->free_mask, ALL_FREE_D(blocks));
+    atomic_init(&pool->alloc_failures, 0U);
+    atomic_init(&pool->high_water, 0U);
+    register_pool(pool);
+
+    return true;
+}
+
+void* mem_pool_alloc(MEM_POOL_T* pool)
+{
+    uint32_t free_mask = atomic_load_explicit(&pool->free_mask, memory_order_acquire);
+    uint32_t taken;
+    uint32_t in_use;
+    uint32_t high_water;
+
+    /* claim lowest free block. A racing alloc or free just means trying again with the new mask */
+    do
+    {
+        if (free_mask == 0U)
+        {
+            atomic_fetch_add_explicit(&pool->alloc_failures, 1U, memory_order_relaxed);
+            return NULL;
+        }
+
+        taken = free_mask & (~free_mask + 1U);
+    } while (!atomic_compare_exchange_weak_explicit(
+        &pool->free_mask, &free_mask, free_mask & ~taken, memory_order_acq_rel, memory_order_acquire));
+
+    in_use = pool->blocks - (uint32_t)__builtin_popcount(free_mask & ~taken);
+    high_water = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+
+    while ((in_use > high_water) &&
+           !atomic_compare_exchange_weak_explicit(
+               &pool->high_water, &high_water, in_use, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+
+    return &pool->storage[(uint32_t)__builtin_ctz(taken) * pool->stride];
+}
+
+void mem_pool_free(MEM_POOL_T* pool, void* block)
+{
+    uint8_t* bytes = (uint8_t*)block;
+    uint32_t offset;
+
+    if ((bytes == NULL) || (bytes < pool->storage))
+    {
+        return;
+    }
+
+    offset = (uint32_t)(bytes - pool->storage);
+
+    if (((offset % pool->stride) != 0U) || ((offset / pool->stride) >= pool->blocks))
+    {
+        return;
+    }
+
+    atomic_fetch_or_explicit(&pool->free_mask, 1UL << (offset / pool->stride), memory_order_release);
+}
+
+uint32_t mem_pool_available(MEM_POOL_T* pool)
+{
+    return (uint32_t)__builtin_popcount(atomic_load_explicit(&pool->free_mask, memory_order_relaxed));
+}
+
+void mem_pool_get_stats(MEM_POOL_T* pool, MEM_POOL_STATS_T* stats)
+{
+    stats->name = pool->name;
+    stats->block_bytes = pool->block_bytes;
+    stats->blocks = pool->blocks;
+    stats->in_use = pool->blocks - mem_pool_available(pool);
+    stats->high_water = atomic_load_explicit(&pool->high_water, memory_order_relaxed);
+    stats->alloc_failures = atomic_load_explicit(&pool->alloc_failures, memory_order_relaxed);
+}
+
+MEM_POOL_T* mem_pool_first(void)
+{
+    return registered_pools;
+}
+
+MEM_POOL_T* mem_pool_next(const MEM_POOL_T* pool)
+{
+    return pool->next;
+}
@@ -0,0 +1,96 @@
+/**
+ ********************************************************************************
+ * @file    mem_report.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Logs pool, stack and heap use
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "mem_report.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "mem_pool.h"
+#include "logging.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define TAG "MEM_REPORT"
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static TaskHandle_t tasks[MEM_REPORT_MAX_TASKS];
+static uint32_t task_count = 0U;
+static portMUX_TYPE tasks_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool mem_report_add_task(TaskHandle_t task)
+{
+    bool added = true;
+    uint32_t i;
+
+    taskENTER_CRITICAL(&tasks_lock);
+
+    for (i = 0U; i < task_count; i++)
+    {
+        if (tasks[i] == task)
+        {
+            break;
+        }
+    }
+
+    if (i == task_count)
+    {
+        if (task_count < MEM_REPORT_MAX_TASKS)
+        {
+            tasks[task_count++] = task;
+        }
+        else
+        {
+            added = false;
+        }
+    }
+
+    taskEXIT_CRITICAL(&tasks_lock);
+
+    return added;
+}
+
+void mem_report_log(void)
+{
+    MEM_POOL_STATS_T stats;
+    MEM_POOL_T* pool;
+    uint32_t count;
+    uint32_t i;
+
+    for (pool = mem_pool_first(); pool != NULL; pool = mem_pool_next(pool))
+    {
+        mem_pool_get_stats(pool, &stats);
+        logging_log(LOG_LEVEL_INFO, TAG, "pool %s: %lu of %lu x %lu bytes in use, high water %lu, %lu alloc failures",
+                    stats.name, (unsigned long)stats.in_use, (unsigned long)stats.blocks,
+                    (unsigned long)stats.block_bytes, (unsigned long)stats.high_water,
+                    (unsigned long)stats.alloc_failures);
+    }
+
+    taskENTER_CRITICAL(&tasks_lock);
+    count = task_count;
+    taskEXIT_CRITICAL(&tasks_lock);
+
+    /* on esp-idf the watermark is in bytes, the least stack that has ever been free */
+    for (i = 0U; i < count; i++)
+    {
+        logging_log(LOG_LEVEL_INFO, TAG, "task %s: %lu bytes of stack never used", pcTaskGetName(tasks[i]),
+                    (unsigned long)uxTaskGetStackHighWaterMark(tasks[i]));
+    }
+
+    logging_log(LOG_LEVEL_INFO, TAG, "heap: %lu bytes free, %lu at lowest, largest block %lu",
+                (unsigned long)esp_get_free_heap_size(), (unsigned long)esp_get_minimum_free_heap_size(),
+                (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+}
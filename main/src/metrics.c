@@ -0,0 +1,236 @@
+/**
+ ********************************************************************************
+ * @file    metrics.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Runtime counters, gauges, timers and per peer rssi
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "metrics.h"
+#include <stdatomic.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+
+/* sum is only written by the one task that records the timer, so it doesn't need to be atomic */
+typedef struct
+{
+    atomic_uint_least32_t count;
+    atomic_uint_least32_t min_us;
+    atomic_uint_least32_t max_us;
+    uint64_t sum_us;
+} TIMER_T;
+
+/* written only by the receive callback, published by peer_count */
+typedef struct
+{
+    uint8_t mac[METRICS_MAC_BYTES];
+    int8_t last_rssi;
+    int8_t min_rssi;
+    int8_t max_rssi;
+    uint32_t frames;
+    int64_t rssi_sum;
+} PEER_T;
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static atomic_uint_least32_t values[METRIC_COUNT];
+static TIMER_T timers[METRIC_TIMER_COUNT];
+static PEER_T peers[METRICS_MAX_PEERS];
+static atomic_uint_least32_t peer_count = 0U;
+
+static const char* const names[METRIC_COUNT] = {
+    [METRIC_LINK_TX_ATTEMPTS] = "link_tx_attempts",
+    [METRIC_LINK_TX_REFUSED] = "link_tx_refused",
+    [METRIC_LINK_TX_BUSY] = "link_tx_busy",
+    [METRIC_LINK_TX_ACKED] = "link_tx_acked",
+    [METRIC_LINK_TX_FAILED] = "link_tx_failed",
+    [METRIC_LINK_RX_FRAMES] = "link_rx_frames",
+    [METRIC_LINK_RX_OVERFLOWS] = "link_rx_overflows",
+    [METRIC_LINK_RX_QUEUE_HWM] = "link_rx_queue_hwm_bytes",
+    [METRIC_LINK_TX_QUEUE_HWM] = "link_tx_queue_hwm_frames",
+    [METRIC_WT20_RX_FRAMES] = "wt20_rx_frames",
+    [METRIC_WT20_RX_DROPPED] = "wt20_rx_dropped",
+    [METRIC_WT20_NO_BUFFER] = "wt20_no_buffer",
+    [METRIC_WT20_MESSAGES] = "wt20_messages"
+};
+
+static const char* const timer_names[METRIC_TIMER_COUNT] = {
+    [METRIC_TIMER_LINK_SEND] = "link_send_us"
+};
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void store_max(atomic_uint_least32_t* value, uint32_t candidate);
+static void store_min(atomic_uint_least32_t* value, uint32_t candidate);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void store_max(atomic_uint_least32_t* value, uint32_t candidate)
+{
+    uint32_t current = atomic_load_explicit(value, memory_order_relaxed);
+
+    /* a failed exchange reloads current, so this only loops while someone else raises it */
+    while ((candidate > current) &&
+           !atomic_compare_exchange_weak_explicit(value, &current, candidate, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+static void store_min(atomic_uint_least32_t* value, uint32_t candidate)
+{
+    uint32_t current = atomic_load_explicit(value, memory_order_relaxed);
+
+    while ((candidate < current) &&
+           !atomic_compare_exchange_weak_explicit(value, &current, candidate, memory_order_relaxed, memory_order_relaxed))
+    {
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void metrics_inc(METRIC_ID_T id)
+{
+    atomic_fetch_add_explicit(&values[id], 1U, memory_order_relaxed);
+}
+
+void metrics_gauge_max(METRIC_ID_T id, uint32_t value)
+{
+    store_max(&values[id], value);
+}
+
+void metrics_timer_add(METRIC_TIMER_ID_T id, uint32_t elapsed_us)
+{
+    TIMER_T* timer = &timers[id];
+
+    /* min starts at 0 before the first reset, so the first sample sets it */
+    if (atomic_load_explicit(&timer->count, memory_order_relaxed) == 0U)
+    {
+        atomic_store_explicit(&timer->min_us, elapsed_us, memory_order_relaxed);
+    }
+
+    timer->sum_us += elapsed_us;
+    store_min(&timer->min_us, elapsed_us);
+    store_max(&timer->max_us, elapsed_us);
+    atomic_fetch_add_explicit(&timer->count, 1U, memory_order_relaxed);
+}
+
+void metrics_peer_rssi(const uint8_t* mac, int8_t rssi)
+{
+    uint32_t count = atomic_load_explicit(&peer_count, memory_order_relaxed);
+    PEER_T* peer = NULL;
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        if (memcmp(peers[i].mac, mac, METRICS_MAC_BYTES) == 0)
+        {
+            peer = &peers[i];
+            break;
+        }
+    }
+
+    if (peer == NULL)
+    {
+        if (count >= METRICS_MAX_PEERS)
+        {
+            return;
+        }
+
+        peer = &peers[count];
+        memcpy(peer->mac, mac, METRICS_MAC_BYTES);
+        peer->min_rssi = rssi;
+        peer->max_rssi = rssi;
+        peer->frames = 0U;
+        peer->rssi_sum = 0;
+
+        /* publish once the mac is in place, so a snapshot never shows a half written peer */
+        atomic_store_explicit(&peer_count, count + 1U, memory_order_release);
+    }
+
+    peer->last_rssi = rssi;
+    peer->min_rssi = (rssi < peer->min_rssi) ? rssi : peer->min_rssi;
+    peer->max_rssi = (rssi > peer->max_rssi) ? rssi : peer->max_rssi;
+    peer->rssi_sum += rssi;
+    peer->frames++;
+}
+
+void metrics_reset(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < METRIC_COUNT; i++)
+    {
+        atomic_store_explicit(&values[i], 0U, memory_order_relaxed);
+    }
+
+    for (i = 0U; i < METRIC_TIMER_COUNT; i++)
+    {
+        atomic_store_explicit(&timers[i].count, 0U, memory_order_relaxed);
+        atomic_store_explicit(&timers[i].min_us, UINT32_MAX, memory_order_relaxed);
+        atomic_store_explicit(&timers[i].max_us, 0U, memory_order_relaxed);
+        timers[i].sum_us = 0U;
+    }
+
+    atomic_store_explicit(&peer_count, 0U, memory_order_release);
+}
+
+void metrics_snapshot(METRICS_SNAPSHOT_T* snapshot)
+{
+    METRICS_TIMER_T* timer;
+    METRICS_PEER_T* peer;
+    uint32_t i;
+
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    for (i = 0U; i < METRIC_COUNT; i++)
+    {
+        snapshot->values[i] = atomic_load_explicit(&values[i], memory_order_relaxed);
+    }
+
+    for (i = 0U; i < METRIC_TIMER_COUNT; i++)
+    {
+        timer = &snapshot->timers[i];
+        timer->count = atomic_load_explicit(&timers[i].count, memory_order_relaxed);
+
+        if (timer->count > 0U)
+        {
+            timer->min_us = atomic_load_explicit(&timers[i].min_us, memory_order_relaxed);
+            timer->max_us = atomic_load_explicit(&timers[i].max_us, memory_order_relaxed);
+            timer->mean_us = (uint32_t)(timers[i].sum_us / timer->count);
+        }
+    }
+
+    snapshot->peer_count = atomic_load_explicit(&peer_count, memory_order_acquire);
+
+    for (i = 0U; i < snapshot->peer_count; i++)
+    {
+        peer = &snapshot->peers[i];
+        memcpy(peer->mac, peers[i].mac, METRICS_MAC_BYTES);
+        peer->frames = peers[i].frames;
+        peer->last_rssi = peers[i].last_rssi;
+        peer->min_rssi = peers[i].min_rssi;
+        peer->max_rssi = peers[i].max_rssi;
+        peer->mean_rssi = (peer->frames > 0U) ? (int8_t)(peers[i].rssi_sum / (int64_t)peer->frames) : peer->last_rssi;
+    }
+}
+
+const char* metrics_name(METRIC_ID_T id)
+{
+    return (id < METRIC_COUNT) ? names[id] : "";
+}
+
+const char* metrics_timer_name(METRIC_TIMER_ID_T id)
+{
+    return (id < METRIC_TIMER_COUNT) ? timer_names[id] : "";
+}
@@ -0,0 +1,33 @@
+/**
+ ********************************************************************************
+ * @file    timing.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Wrapper for ESP timer, so time can be more easily mocked
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "timing.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+uint32_t timing_get_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+uint32_t timing_get_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+uint32_t timing_get_cycles(void)
+{
+    return (uint32_t)esp_cpu_get_cycle_count();
+}
@@ -0,0 +1,63 @@
+/**
+ ********************************************************************************
+ * @file    voice_flash_esp.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Voice store flash on target, the "voice" data partition
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "voice_flash.h"
+#include "esp_partition.h"
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static const esp_partition_t* partition = NULL;
+static esp_partition_mmap_handle_t map_handle;
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool voice_flash_open(const uint8_t** map, uint32_t* bytes)
+{
+    const void* mapped;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)VOICE_FLASH_PARTITION_SUBTYPE,
+                                         VOICE_FLASH_PARTITION_LABEL);
+
+    if ((partition == NULL) ||
+        (esp_partition_mmap(partition, 0U, partition->size, ESP_PARTITION_MMAP_DATA, &mapped, &map_handle) != ESP_OK))
+    {
+        partition = NULL;
+        return false;
+    }
+
+    *map = (const uint8_t*)mapped;
+    *bytes = partition->size - (partition->size % VOICE_FLASH_SECTOR_BYTES);
+
+    return true;
+}
+
+bool voice_flash_erase_sector(uint32_t offset)
+{
+    return (partition != NULL) && (esp_partition_erase_range(partition, offset, VOICE_FLASH_SECTOR_BYTES) == ESP_OK);
+}
+
+/* the flash driver invalidates the cache over what it writes, so the map sees it */
+bool voice_flash_write(uint32_t offset, const void* data, uint32_t length)
+{
+    return (partition != NULL) && (esp_partition_write(partition, offset, data, length) == ESP_OK);
+}
+
+void voice_flash_close(void)
+{
+    if (partition != NULL)
+    {
+        esp_partition_munmap(map_handle);
+        partition = NULL;
+    }
+}
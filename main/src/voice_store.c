@@ -0,0 +1,690 @@
+/**
+ ********************************************************************************
+ * @file    voice_store.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Log structured voice message store
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "voice_store.h"
+#include <string.h>
+#include "crc16.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SECTOR_MAGIC_D (0x53565457UL)     /* "WTVS" */
+#define RECORD_MAGIC_D (0x4356U)          /* "VC" */
+
+#define RECORD_LAST_D (0x01U)
+#define RECORD_LIVE_D (0xFFU)
+#define RECORD_DELETED_D (0x00U)
+
+/* offsets into a record header */
+#define RECORD_ID_D (2U)
+#define RECORD_CHUNK_D (4U)
+#define RECORD_LENGTH_D (6U)
+#define RECORD_FLAGS_D (8U)
+#define RECORD_DELETED_OFFSET_D (9U)
+#define RECORD_CRC_D (10U)
+
+/* records start 4 byte aligned */
+#define ALIGN_D(bytes) (((bytes) + 3U) & ~3UL)
+
+_Static_assert(VOICE_STORE_CHUNK_BYTES <= 0xFFFFU, "chunk length is 16 bits");
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+typedef struct
+{
+    VOICE_STORE_MSG_T msg;
+    uint32_t sector;          /* where its first chunk is */
+    uint32_t offset;
+    uint32_t seq;
+    uint16_t chunks;
+} ENTRY_T;
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static const uint8_t* flash = NULL;
+static uint32_t sector_count = 0U;
+static bool mounted = false;
+
+/* sector being written, 0 seq while the flash is blank */
+static uint32_t head_sector = 0U;
+static uint32_t head_seq = 0U;
+static uint32_t head_offset = 0U;
+
+/* oldest first */
+static ENTRY_T entries[VOICE_STORE_MAX_MESSAGES];
+static uint32_t entry_count = 0U;
+static uint16_t next_id = 0U;
+
+/* message being written. Its entry is in the index from the start, so a cut short write
+   still shows up */
+static bool writing = false;
+static uint16_t open_id = 0U;
+static uint32_t open_first_seq = 0U;
+static uint16_t chunk_index = 0U;
+static uint32_t chunk_fill = 0U;
+static uint8_t chunk_buffer[VOICE_STORE_CHUNK_BYTES];
+
+static VOICE_STORE_STATS_T stats;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint16_t read16(const uint8_t* bytes);
+static uint32_t read32(const uint8_t* bytes);
+static void write16(uint8_t* bytes, uint16_t value);
+static void write32(uint8_t* bytes, uint32_t value);
+static bool sector_header(uint32_t sector, uint32_t* seq, uint32_t* erase_count);
+static uint32_t chunk_room(void);
+static uint32_t find_entry(uint16_t id);
+static void drop_entry(uint32_t index);
+static bool next_overwrites_open(void);
+static VOICE_STORE_ERR_T open_next_sector(void);
+static VOICE_STORE_ERR_T write_chunk(bool last);
+static void index_record(const uint8_t* record, uint32_t sector, uint32_t offset, uint32_t seq);
+static void scan_sector(uint32_t sector, uint32_t seq, bool head);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static uint16_t read16(const uint8_t* bytes)
+{
+    return (uint16_t)bytes[0] | (uint16_t)((uint16_t)bytes[1] << 8U);
+}
+
+static uint32_t read32(const uint8_t* bytes)
+{
+    return (uint32_t)read16(bytes) | ((uint32_t)read16(&bytes[2]) << 16U);
+}
+
+static void write16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = (uint8_t)(value & 0xFFU);
+    bytes[1] = (uint8_t)(value >> 8U);
+}
+
+static void write32(uint8_t* bytes, uint32_t value)
+{
+    write16(bytes, (uint16_t)(value & 0xFFFFU));
+    write16(&bytes[2], (uint16_t)(value >> 16U));
+}
+
+/* false for blank sectors, and ones whose erase or header write was cut short */
+static bool sector_header(uint32_t sector, uint32_t* seq, uint32_t* erase_count)
+{
+    const uint8_t* header = &flash[sector * VOICE_FLASH_SECTOR_BYTES];
+
+    if ((read32(header) != SECTOR_MAGIC_D) || (read16(&header[12]) != crc16_update(CRC16_INIT, header, 12U)))
+    {
+        return false;
+    }
+
+    *seq = read32(&header[4]);
+    *erase_count = read32(&header[8]);
+
+    return true;
+}
+
+/* data that fits in a chunk written at the head */
+static uint32_t chunk_room(void)
+{
+    if ((head_seq == 0U) || ((head_offset + VOICE_STORE_RECORD_HDR_BYTES) >= VOICE_FLASH_SECTOR_BYTES))
+    {
+        return 0U;
+    }
+
+    return VOICE_FLASH_SECTOR_BYTES - head_offset - VOICE_STORE_RECORD_HDR_BYTES;
+}
+
+static uint32_t find_entry(uint16_t id)
+{
+    uint32_t i;
+
+    for (i = 0U; i < entry_count; i++)
+    {
+        if (entries[i].msg.id == id)
+        {
+            return i;
+        }
+    }
+
+    return entry_count;
+}
+
+static void drop_entry(uint32_t index)
+{
+    entry_count--;
+    memmove(&entries[index], &entries[index + 1U], (entry_count - index) * sizeof(entries[0]));
+}
+
+/* the next sector round is the oldest in the log */
+static bool next_overwrites_open(void)
+{
+    uint32_t seq;
+    uint32_t erase_count;
+
+    return writing && (head_seq != 0U) && sector_header((head_sector + 1U) % sector_count, &seq, &erase_count) &&
+           (seq >= open_first_seq);
+}
+
+/* reclaims the oldest sector, dropping messages that start in it */
+static VOICE_STORE_ERR_T open_next_sector(void)
+{
+    uint8_t header[VOICE_STORE_SECTOR_HDR_BYTES];
+    uint32_t sector = (head_seq == 0U) ? 0U : ((head_sector + 1U) % sector_count);
+    uint32_t old_seq;
+    uint32_t erase_count = 0U;
+
+    if (next_overwrites_open())
+    {
+        return VOICE_STORE_ERR_FULL;
+    }
+
+    if (sector_header(sector, &old_seq, &erase_count))
+    {
+        while ((entry_count > 0U) && (entries[0].seq <= old_seq))
+        {
+            drop_entry(0U);
+            stats.messages_dropped++;
+        }
+    }
+    else if ((head_seq != 0U) && sector_header(head_sector, &old_seq, &erase_count))
+    {
+        /* blank, or its count was lost with the header. Sectors in a circular log wear alike,
+           so it has likely been erased as often as the one before it */
+        erase_count--;
+    }
+
+    memset(header, 0xFF, sizeof(header));
+    write32(header, SECTOR_MAGIC_D);
+    write32(&header[4], head_seq + 1U);
+    write32(&header[8], erase_count + 1U);
+    write16(&header[12], crc16_update(CRC16_INIT, header, 12U));
+
+    if (!voice_flash_erase_sector(sector * VOICE_FLASH_SECTOR_BYTES) ||
+        !voice_flash_write(sector * VOICE_FLASH_SECTOR_BYTES, header, sizeof(header)))
+    {
+        return VOICE_STORE_ERR_FLASH;
+    }
+
+    stats.sectors_erased++;
+    head_sector = sector;
+    head_seq++;
+    head_offset = VOICE_STORE_SECTOR_HDR_BYTES;
+
+    return VOICE_STORE_OK;
+}
+
+/* data goes down before the header, so a write cut short leaves no record behind */
+static VOICE_STORE_ERR_T write_chunk(bool last)
+{
+    uint8_t header[VOICE_STORE_RECORD_HDR_BYTES];
+    uint32_t offset = (head_sector * VOICE_FLASH_SECTOR_BYTES) + head_offset;
+    ENTRY_T* entry = &entries[find_entry(open_id)];
+    uint16_t crc;
+
+    write16(header, RECORD_MAGIC_D);
+    write16(&header[RECORD_ID_D], open_id);
+    write16(&header[RECORD_CHUNK_D], chunk_index);
+    write16(&header[RECORD_LENGTH_D], (uint16_t)chunk_fill);
+    header[RECORD_FLAGS_D] = last ? RECORD_LAST_D : 0U;
+    header[RECORD_DELETED_OFFSET_D] = RECORD_LIVE_D;
+    crc = crc16_update(CRC16_INIT, header, RECORD_FLAGS_D + 1U);
+    write16(&header[RECORD_CRC_D], crc16_update(crc, chunk_buffer, chunk_fill));
+
+    if (((chunk_fill > 0U) && !voice_flash_write(offset + VOICE_STORE_RECORD_HDR_BYTES, chunk_buffer, chunk_fill)) ||
+        !voice_flash_write(offset, header, sizeof(header)))
+    {
+        return VOICE_STORE_ERR_FLASH;
+    }
+
+    head_offset = ALIGN_D(head_offset + VOICE_STORE_RECORD_HDR_BYTES + chunk_fill);
+    stats.bytes_written += VOICE_STORE_RECORD_HDR_BYTES + chunk_fill;
+    stats.chunks_written++;
+
+    entry->msg.bytes += chunk_fill;
+    entry->msg.complete = last;
+    entry->chunks++;
+
+    chunk_index++;
+    chunk_fill = 0U;
+
+    return VOICE_STORE_OK;
+}
+
+/* a message's chunks follow each other in the log, anything else belongs to a message that
+   was overwritten or deleted */
+static void index_record(const uint8_t* record, uint32_t sector, uint32_t offset, uint32_t seq)
+{
+    ENTRY_T* entry;
+    uint16_t id = read16(&record[RECORD_ID_D]);
+    uint16_t chunk = read16(&record[RECORD_CHUNK_D]);
+    uint16_t length = read16(&record[RECORD_LENGTH_D]);
+    bool last = (record[RECORD_FLAGS_D] & RECORD_LAST_D) != 0U;
+
+    if (chunk == 0U)
+    {
+        next_id = (uint16_t)(id + 1U);
+
+        if (record[RECORD_DELETED_OFFSET_D] != RECORD_LIVE_D)
+        {
+            return;
+        }
+
+        if (entry_count == VOICE_STORE_MAX_MESSAGES)
+        {
+            drop_entry(0U);
+            stats.messages_dropped++;
+        }
+
+        entry = &entries[entry_count];
+        entry_count++;
+        entry->msg.id = id;
+        entry->msg.bytes = length;
+        entry->msg.complete = last;
+        entry->sector = sector;
+        entry->offset = offset;
+        entry->seq = seq;
+        entry->chunks = 1U;
+    }
+    else if (entry_count > 0U)
+    {
+        entry = &entries[entry_count - 1U];
+
+        if ((entry->msg.id != id) || (entry->chunks != chunk) || entry->msg.complete)
+        {
+            return;
+        }
+
+        entry->msg.bytes += length;
+        entry->msg.complete = last;
+        entry->chunks++;
+    }
+}
+
+/* only the head sector can hold a write cut short, so only its data is checked */
+static void scan_sector(uint32_t sector, uint32_t seq, bool head)
+{
+    const uint8_t* base = &flash[sector * VOICE_FLASH_SECTOR_BYTES];
+    const uint8_t* record;
+    uint32_t offset = VOICE_STORE_SECTOR_HDR_BYTES;
+    uint32_t length;
+    uint16_t crc;
+
+    while ((offset + VOICE_STORE_RECORD_HDR_BYTES) <= VOICE_FLASH_SECTOR_BYTES)
+    {
+        record = &base[offset];
+        length = read16(&record[RECORD_LENGTH_D]);
+
+        if ((read16(record) != RECORD_MAGIC_D) ||
+            ((offset + VOICE_STORE_RECORD_HDR_BYTES + length) > VOICE_FLASH_SECTOR_BYTES))
+        {
+            break;
+        }
+
+        if (head)
+        {
+            crc = crc16_update(CRC16_INIT, record, RECORD_FLAGS_D + 1U);
+
+            if (read16(&record[RECORD_CRC_D]) != crc16_update(crc, &record[VOICE_STORE_RECORD_HDR_BYTES], length))
+            {
+                break;
+            }
+        }
+
+        index_record(record, sector, offset, seq);
+        offset = ALIGN_D(offset + VOICE_STORE_RECORD_HDR_BYTES + length);
+    }
+
+    if (!head)
+    {
+        return;
+    }
+
+    head_offset = offset;
+
+    /* a write was cut short past the last record. Programming over it could leave a record
+       that reads wrong, so the head moves on to the next sector */
+    for (; offset < VOICE_FLASH_SECTOR_BYTES; offset++)
+    {
+        if (base[offset] != 0xFFU)
+        {
+            head_offset = VOICE_FLASH_SECTOR_BYTES;
+            stats.recovered = true;
+            break;
+        }
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+VOICE_STORE_ERR_T voice_store_mount(void)
+{
+    uint32_t bytes;
+    uint32_t sector;
+    uint32_t seq;
+    uint32_t erase_count;
+    uint32_t i;
+
+    /* like after power loss, a message being written is left as far as it got */
+    if (mounted)
+    {
+        voice_flash_close();
+        mounted = false;
+    }
+
+    writing = false;
+    memset(&stats, 0, sizeof(stats));
+    entry_count = 0U;
+    next_id = 0U;
+    head_sector = 0U;
+    head_seq = 0U;
+    head_offset = 0U;
+
+    if (!voice_flash_open(&flash, &bytes))
+    {
+        return VOICE_STORE_ERR_FLASH;
+    }
+
+    sector_count = bytes / VOICE_FLASH_SECTOR_BYTES;
+
+    if (sector_count == 0U)
+    {
+        voice_flash_close();
+        return VOICE_STORE_ERR_FLASH;
+    }
+
+    /* the head is the newest sector */
+    for (sector = 0U; sector < sector_count; sector++)
+    {
+        if (sector_header(sector, &seq, &erase_count) && (seq > head_seq))
+        {
+            head_seq = seq;
+            head_sector = sector;
+        }
+    }
+
+    /* oldest first. Sectors of the log follow each other round the flash up to the head, so
+       any other seq is from an older lap */
+    for (i = 1U; (head_seq != 0U) && (i <= sector_count); i++)
+    {
+        sector = (head_sector + i) % sector_count;
+
+        if (sector_header(sector, &seq, &erase_count) && ((seq + (sector_count - i)) == head_seq))
+        {
+            scan_sector(sector, seq, i == sector_count);
+        }
+    }
+
+    mounted = true;
+    stats.sectors = sector_count;
+
+    return VOICE_STORE_OK;
+}
+
+void voice_store_unmount(void)
+{
+    if (!mounted)
+    {
+        return;
+    }
+
+    if (writing)
+    {
+        (void)voice_store_finish();
+    }
+
+    voice_flash_close();
+    mounted = false;
+}
+
+VOICE_STORE_ERR_T voice_store_begin(uint16_t* id)
+{
+    VOICE_STORE_ERR_T err;
+    ENTRY_T* entry;
+
+    if (!mounted)
+    {
+        return VOICE_STORE_ERR_NOT_MOUNTED;
+    }
+
+    if (writing)
+    {
+        return VOICE_STORE_ERR_BUSY;
+    }
+
+    if (chunk_room() == 0U)
+    {
+        err = open_next_sector();
+
+        if (err != VOICE_STORE_OK)
+        {
+            return err;
+        }
+    }
+
+    if (entry_count == VOICE_STORE_MAX_MESSAGES)
+    {
+        drop_entry(0U);
+        stats.messages_dropped++;
+    }
+
+    entry = &entries[entry_count];
+    entry_count++;
+    memset(entry, 0, sizeof(*entry));
+    entry->msg.id = next_id;
+    entry->sector = head_sector;
+    entry->offset = head_offset;
+    entry->seq = head_seq;
+
+    writing = true;
+    open_id = next_id;
+    open_first_seq = head_seq;
+    chunk_index = 0U;
+    chunk_fill = 0U;
+    next_id++;
+    *id = open_id;
+
+    return VOICE_STORE_OK;
+}
+
+VOICE_STORE_ERR_T voice_store_append(const uint8_t* data, uint32_t length)
+{
+    VOICE_STORE_ERR_T err;
+    uint32_t room;
+    uint32_t count;
+
+    if (!writing)
+    {
+        return VOICE_STORE_ERR_NOT_OPEN;
+    }
+
+    while (length > 0U)
+    {
+        room = chunk_room();
+
+        /* a full chunk only goes down once there is more, the last one is written by finish */
+        if (chunk_fill == room)
+        {
+            if (next_overwrites_open())
+            {
+                return VOICE_STORE_ERR_FULL;
+            }
+
+            err = write_chunk(false);
+            err = (err == VOICE_STORE_OK) ? open_next_sector() : err;
+
+            if (err != VOICE_STORE_OK)
+            {
+                return err;
+            }
+
+            continue;
+        }
+
+        count = ((room - chunk_fill) < length) ? (room - chunk_fill) : length;
+        memcpy(&chunk_buffer[chunk_fill], data, count);
+        chunk_fill += count;
+        data += count;
+        length -= count;
+    }
+
+    return VOICE_STORE_OK;
+}
+
+VOICE_STORE_ERR_T voice_store_finish(void)
+{
+    if (!writing)
+    {
+        return VOICE_STORE_ERR_NOT_OPEN;
+    }
+
+    writing = false;
+
+    return write_chunk(true);
+}
+
+VOICE_STORE_ERR_T voice_store_delete(uint16_t id)
+{
+    static const uint8_t deleted = RECORD_DELETED_D;
+    uint32_t index;
+
+    if (!mounted)
+    {
+        return VOICE_STORE_ERR_NOT_MOUNTED;
+    }
+
+    if (writing && (id == open_id))
+    {
+        return VOICE_STORE_ERR_BUSY;
+    }
+
+    index = find_entry(id);
+
+    if (index == entry_count)
+    {
+        return VOICE_STORE_ERR_NOT_FOUND;
+    }
+
+    /* the mark goes on the first chunk, the rest of the message is skipped with it */
+    if (!voice_flash_write((entries[index].sector * VOICE_FLASH_SECTOR_BYTES) + entries[index].offset + RECORD_DELETED_OFFSET_D,
+                           &deleted, sizeof(deleted)))
+    {
+        return VOICE_STORE_ERR_FLASH;
+    }
+
+    drop_entry(index);
+
+    return VOICE_STORE_OK;
+}
+
+uint32_t voice_store_count(void)
+{
+    return entry_count;
+}
+
+VOICE_STORE_ERR_T voice_store_get(uint32_t index, VOICE_STORE_MSG_T* msg)
+{
+    if (index >= entry_count)
+    {
+        return VOICE_STORE_ERR_NOT_FOUND;
+    }
+
+    *msg = entries[index].msg;
+
+    return VOICE_STORE_OK;
+}
+
+VOICE_STORE_ERR_T voice_store_open(uint16_t id, VOICE_STORE_READER_T* reader)
+{
+    uint32_t index = find_entry(id);
+
+    if (index == entry_count)
+    {
+        return VOICE_STORE_ERR_NOT_FOUND;
+    }
+
+    reader->id = id;
+    reader->sector = entries[index].sector;
+    reader->offset = entries[index].offset;
+    reader->seq = entries[index].seq;
+    reader->chunk = 0U;
+    reader->done = false;
+
+    return VOICE_STORE_OK;
+}
+
+uint32_t voice_store_read(VOICE_STORE_READER_T* reader, const uint8_t** data)
+{
+    const uint8_t* record;
+    uint32_t seq;
+    uint32_t erase_count;
+    uint32_t length;
+
+    /* stops where the log came round over the message, or where its writing stopped */
+    if (!mounted || reader->done || !sector_header(reader->sector, &seq, &erase_count) || (seq != reader->seq) ||
+        ((reader->offset + VOICE_STORE_RECORD_HDR_BYTES) > VOICE_FLASH_SECTOR_BYTES))
+    {
+        reader->done = true;
+        return 0U;
+    }
+
+    record = &flash[(reader->sector * VOICE_FLASH_SECTOR_BYTES) + reader->offset];
+    length = read16(&record[RECORD_LENGTH_D]);
+
+    if ((read16(record) != RECORD_MAGIC_D) || (read16(&record[RECORD_ID_D]) != reader->id) ||
+        (read16(&record[RECORD_CHUNK_D]) != reader->chunk))
+    {
+        reader->done = true;
+        return 0U;
+    }
+
+    *data = &record[VOICE_STORE_RECORD_HDR_BYTES];
+    reader->chunk++;
+
+    /* a chunk that isn't the last fills its sector, the next starts the next sector */
+    if ((record[RECORD_FLAGS_D] & RECORD_LAST_D) != 0U)
+    {
+        reader->done = true;
+    }
+    else
+    {
+        reader->sector = (reader->sector + 1U) % sector_count;
+        reader->offset = VOICE_STORE_SECTOR_HDR_BYTES;
+        reader->seq++;
+    }
+
+    return length;
+}
+
+void voice_store_get_stats(VOICE_STORE_STATS_T* stats_out)
+{
+    uint32_t sector;
+    uint32_t seq;
+    uint32_t erase_count;
+
+    *stats_out = stats;
+    stats_out->messages = entry_count;
+    stats_out->min_erase_count = 0xFFFFFFFFUL;
+    stats_out->max_erase_count = 0U;
+
+    for (sector = 0U; mounted && (sector < sector_count); sector++)
+    {
+        erase_count = sector_header(sector, &seq, &erase_count) ? erase_count : 0U;
+        stats_out->min_erase_count = (erase_count < stats_out->min_erase_count) ? erase_count : stats_out->min_erase_count;
+        stats_out->max_erase_count = (erase_count > stats_out->max_erase_count) ? erase_count : stats_out->max_erase_count;
+    }
+
+    stats_out->min_erase_count = (stats_out->min_erase_count > stats_out->max_erase_count) ? 0U : stats_out->min_erase_count;
+}
@@ -0,0 +1,168 @@
+/**
+ ********************************************************************************
+ * @file    wm8960.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Minimal WM8960 codec driver
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wm8960.h"
+#include <stddef.h>
+#include "driver/i2c_master.h"
+#include "logging.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define TAG "WM8960"
+
+#define I2C_SPEED_HZ_D (100000U)
+#define I2C_TIMEOUT_MS_D (50)
+
+/* registers used, see WM8960 datasheet register map */
+#define REG_LEFT_INPUT_VOLUME_D (0x00U)
+#define REG_RIGHT_INPUT_VOLUME_D (0x01U)
+#define REG_LOUT1_VOLUME_D (0x02U)
+#define REG_ROUT1_VOLUME_D (0x03U)
+#define REG_CLOCKING1_D (0x04U)
+#define REG_ADC_DAC_CONTROL1_D (0x05U)
+#define REG_AUDIO_INTERFACE_D (0x07U)
+#define REG_LEFT_DAC_VOLUME_D (0x0AU)
+#define REG_RIGHT_DAC_VOLUME_D (0x0BU)
+#define REG_RESET_D (0x0FU)
+#define REG_LEFT_ADC_VOLUME_D (0x15U)
+#define REG_RIGHT_ADC_VOLUME_D (0x16U)
+#define REG_ADDITIONAL_CONTROL1_D (0x17U)
+#define REG_POWER_MGMT1_D (0x19U)
+#define REG_POWER_MGMT2_D (0x1AU)
+#define REG_ADCL_SIGNAL_PATH_D (0x20U)
+#define REG_ADCR_SIGNAL_PATH_D (0x21U)
+#define REG_LEFT_OUT_MIX_D (0x22U)
+#define REG_RIGHT_OUT_MIX_D (0x25U)
+#define REG_POWER_MGMT3_D (0x2FU)
+
+/* volume update bit, a left/right pair only takes effect once it's set on the second write */
+#define VOLUME_UPDATE_D (0x100U)
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+typedef struct
+{
+    uint8_t reg;
+    uint16_t value;
+} REGISTER_WRITE_T;
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static i2c_master_bus_handle_t bus = NULL;
+static i2c_master_dev_handle_t codec = NULL;
+
+/* 16 bit I2S slave, MCLK = SYSCLK = 256 fs. Mic on LINPUT1/RINPUT1 with +13 dB boost,
+   DAC mixed to mono on both headphone channels since only left slot carries audio */
+static const REGISTER_WRITE_T init_sequence[] = {
+    {REG_RESET_D, 0x000U},
+    {REG_POWER_MGMT1_D, 0x0FEU},         /* vmid 2x50k, vref, ain l/r, adc l/r, mic bias */
+    {REG_POWER_MGMT2_D, 0x1E0U},         /* dac l/r, lout1, rout1 */
+    {REG_POWER_MGMT3_D, 0x03CU},         /* mic pga l/r, output mixers l/r */
+    {REG_CLOCKING1_D, 0x000U},
+    {REG_AUDIO_INTERFACE_D, 0x002U},     /* i2s format, 16 bit, slave */
+    {REG_ADDITIONAL_CONTROL1_D, 0x1D0U}, /* defaults plus dac mono mix */
+    {REG_ADCL_SIGNAL_PATH_D, 0x118U},
+    {REG_ADCR_SIGNAL_PATH_D, 0x118U},
+    {REG_LEFT_INPUT_VOLUME_D, 0x017U},   /* 0 dB */
+    {REG_RIGHT_INPUT_VOLUME_D, 0x017U | VOLUME_UPDATE_D},
+    {REG_LEFT_ADC_VOLUME_D, 0x0C3U},     /* 0 dB */
+    {REG_RIGHT_ADC_VOLUME_D, 0x0C3U | VOLUME_UPDATE_D},
+    {REG_LEFT_DAC_VOLUME_D, 0x0FFU},     /* 0 dB */
+    {REG_RIGHT_DAC_VOLUME_D, 0x0FFU | VOLUME_UPDATE_D},
+    {REG_LEFT_OUT_MIX_D, 0x100U},        /* left dac to left output mixer */
+    {REG_RIGHT_OUT_MIX_D, 0x100U},       /* right dac to right output mixer */
+    {REG_LOUT1_VOLUME_D, WM8960_VOLUME_0DB},
+    {REG_ROUT1_VOLUME_D, WM8960_VOLUME_0DB | VOLUME_UPDATE_D},
+    {REG_ADC_DAC_CONTROL1_D, 0x000U},    /* dac unmute */
+};
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static bool write_register(uint8_t reg, uint16_t value);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* registers are 9 bits wide, sent as 7 bit address and data msb followed by 8 data bits */
+static bool write_register(uint8_t reg, uint16_t value)
+{
+    uint8_t data[2U];
+
+    data[0] = (uint8_t)((reg << 1U) | ((value >> 8U) & 1U));
+    data[1] = (uint8_t)(value & 0xFFU);
+
+    return i2c_master_transmit(codec, data, sizeof(data), I2C_TIMEOUT_MS_D) == ESP_OK;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool wm8960_init(int32_t sda_pin, int32_t scl_pin)
+{
+    i2c_master_bus_config_t bus_config = {
+        .i2c_port = -1,
+        .sda_io_num = sda_pin,
+        .scl_io_num = scl_pin,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    i2c_device_config_t device_config = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = WM8960_I2C_ADDRESS,
+        .scl_speed_hz = I2C_SPEED_HZ_D,
+    };
+    uint32_t i;
+
+    if ((bus == NULL) && (i2c_new_master_bus(&bus_config, &bus) != ESP_OK))
+    {
+        logging_log(LOG_LEVEL_ERROR, TAG, "i2c bus setup failed");
+        return false;
+    }
+
+    if ((codec == NULL) && (i2c_master_bus_add_device(bus, &device_config, &codec) != ESP_OK))
+    {
+        logging_log(LOG_LEVEL_ERROR, TAG, "i2c device setup failed");
+        return false;
+    }
+
+    for (i = 0U; i < (sizeof(init_sequence) / sizeof(init_sequence[0])); i++)
+    {
+        if (!write_register(init_sequence[i].reg, init_sequence[i].value))
+        {
+            logging_log(LOG_LEVEL_ERROR, TAG, "write to register 0x%02X failed", init_sequence[i].reg);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool wm8960_set_volume(uint8_t volume)
+{
+    if (codec == NULL)
+    {
+        return false;
+    }
+
+    if (volume > WM8960_VOLUME_MAX)
+    {
+        volume = WM8960_VOLUME_MAX;
+    }
+
+    return write_register(REG_LOUT1_VOLUME_D, volume) && write_register(REG_ROUT1_VOLUME_D, volume | VOLUME_UPDATE_D);
+}
@@ -0,0 +1,325 @@
+/**
+ ********************************************************************************
+ * @file    wt20_bulk.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Selective repeat reliable transfer of fragmented messages
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_bulk.h"
+#include <string.h>
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define BIT_GET_D(map, i) ((((map)[(i) >> 3U]) >> ((i) & 7U)) & 1U)
+#define BIT_SET_D(map, i) ((map)[(i) >> 3U] |= (uint8_t)(1U << ((i) & 7U)))
+#define BIT_CLR_D(map, i) ((map)[(i) >> 3U] &= (uint8_t)~(1U << ((i) & 7U)))
+
+/* a poll is attached at least this often so losses are found before the window drains */
+#define POLL_INTERVAL_D ((WT20_BULK_WINDOW + 1U) / 2U)
+
+/* slack added to the round trip so scheduling jitter doesn't cause spurious timeouts */
+#define MIN_ACK_TIMEOUT_MS_D (2U)
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static int32_t next_candidate(const WT20_BULK_TX_T* tx, uint16_t from);
+static int32_t oldest_outstanding(const WT20_BULK_TX_T* tx);
+static uint32_t ack_timeout(const WT20_BULK_TX_T* tx);
+static void mark_lost(WT20_BULK_TX_T* tx, uint16_t up_to_seq);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* lowest fragment at or after from that is neither acked nor waiting on an ack */
+static int32_t next_candidate(const WT20_BULK_TX_T* tx, uint16_t from)
+{
+    uint16_t i;
+
+    for (i = from; i < tx->count; i++)
+    {
+        if ((BIT_GET_D(tx->acked, i) == 0U) && (BIT_GET_D(tx->outstanding, i) == 0U))
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+static int32_t oldest_outstanding(const WT20_BULK_TX_T* tx)
+{
+    uint16_t i;
+
+    for (i = tx->first_unacked; i < tx->count; i++)
+    {
+        if (BIT_GET_D(tx->outstanding, i) != 0U)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/* twice the measured round trip, capped by WT20_BULK_ACK_TIMEOUT_MS which is also used until a round trip is measured */
+static uint32_t ack_timeout(const WT20_BULK_TX_T* tx)
+{
+    uint32_t timeout = (2U * tx->srtt_ms) + MIN_ACK_TIMEOUT_MS_D;
+
+    if ((tx->srtt_ms == 0U) || (timeout > WT20_BULK_ACK_TIMEOUT_MS))
+    {
+        timeout = WT20_BULK_ACK_TIMEOUT_MS;
+    }
+
+    return timeout;
+}
+
+/* outstanding fragments last sent at or before up_to_seq are assumed lost and become candidates again */
+static void mark_lost(WT20_BULK_TX_T* tx, uint16_t up_to_seq)
+{
+    uint16_t i;
+
+    for (i = tx->first_unacked; i < tx->count; i++)
+    {
+        if ((BIT_GET_D(tx->outstanding, i) != 0U) && ((uint16_t)(up_to_seq - tx->last_send_seq[i]) < 0x8000U))
+        {
+            BIT_CLR_D(tx->outstanding, i);
+            tx->outstanding_count--;
+        }
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_bulk_tx_start(WT20_BULK_TX_T* tx,
+                        uint8_t msg_id,
+                        const uint8_t* message,
+                        uint32_t length,
+                        uint8_t data_command,
+                        uint8_t poll_command,
+                        uint32_t now_ms)
+{
+    memset(tx, 0U, sizeof(*tx));
+
+    tx->message = message;
+    tx->length = length;
+    tx->count = wt20_frag_count(length);
+    tx->msg_id = msg_id;
+    tx->data_command = data_command;
+    tx->poll_command = poll_command;
+    tx->last_progress_ms = now_ms;
+    tx->state = (length <= WT20_FRAG_MAX_MESSAGE_BYTES) ? WT20_BULK_IN_PROGRESS : WT20_BULK_FAILED;
+}
+
+bool wt20_bulk_tx_next(WT20_BULK_TX_T* tx, uint32_t now_ms, uint8_t* frame, uint16_t* frame_length)
+{
+    int32_t index = -1;
+    bool force_poll = false;
+    bool poll;
+    bool retransmit;
+    uint16_t length;
+
+    if (tx->state != WT20_BULK_IN_PROGRESS)
+    {
+        return false;
+    }
+
+    if ((now_ms - tx->last_progress_ms) >= WT20_BULK_GIVE_UP_MS)
+    {
+        tx->state = WT20_BULK_FAILED;
+        return false;
+    }
+
+    /* poll or its ack was lost. Rather than resending everything the poll covered,
+       resend only the oldest outstanding fragment as a new poll and let its ack sort out the rest */
+    if (tx->awaiting_ack && ((now_ms - tx->last_poll_ms) >= ack_timeout(tx)))
+    {
+        tx->awaiting_ack = false;
+        tx->stats.ack_timeouts++;
+        index = oldest_outstanding(tx);
+        force_poll = (index >= 0);
+    }
+
+    if (!force_poll)
+    {
+        if (tx->outstanding_count >= WT20_BULK_WINDOW)
+        {
+            return false;
+        }
+
+        index = next_candidate(tx, tx->first_unacked);
+
+        if (index < 0)
+        {
+            return false;
+        }
+    }
+
+    length = wt20_frag_build(tx->msg_id, tx->message, tx->length, (uint16_t)index, &frame[1]);
+
+    if (length == 0U)
+    {
+        tx->state = WT20_BULK_FAILED;
+        return false;
+    }
+
+    retransmit = (BIT_GET_D(tx->sent_once, index) != 0U);
+
+    /* ask for an ack periodically, when the window fills and when nothing else is left to send.
+       Retransmissions always poll, so one lost poll near the end doesn't stall the transfer for a timeout */
+    poll = force_poll || retransmit || ((tx->sends_since_poll + 1U) >= POLL_INTERVAL_D) ||
+           ((tx->outstanding_count + 1U) >= WT20_BULK_WINDOW) ||
+           (next_candidate(tx, (uint16_t)(index + 1)) < 0);
+
+    if (BIT_GET_D(tx->outstanding, index) == 0U)
+    {
+        BIT_SET_D(tx->outstanding, index);
+        tx->outstanding_count++;
+    }
+
+    BIT_SET_D(tx->sent_once, index);
+    tx->last_send_seq[index] = tx->send_seq;
+
+    frame[0] = poll ? tx->poll_command : tx->data_command;
+    *frame_length = (uint16_t)(length + 1U);
+
+    if (poll)
+    {
+        tx->awaiting_ack = true;
+        tx->last_poll_seq = tx->send_seq;
+        tx->last_poll_ms = now_ms;
+        tx->sends_since_poll = 0U;
+        tx->stats.polls++;
+    }
+    else
+    {
+        tx->sends_since_poll++;
+    }
+
+    tx->send_seq++;
+    tx->stats.frames_sent++;
+    tx->stats.retransmits += retransmit ? 1U : 0U;
+
+    return true;
+}
+
+void wt20_bulk_tx_on_ack(WT20_BULK_TX_T* tx, const uint8_t* ack, uint16_t ack_length, uint32_t now_ms)
+{
+    const uint8_t* bitmap = &ack[WT20_BULK_ACK_HDR_BYTES];
+    uint16_t poll_index;
+    uint16_t count;
+    uint16_t poll_seq;
+    uint16_t i;
+    bool progress = false;
+
+    if ((tx->state != WT20_BULK_IN_PROGRESS) || (ack_length < WT20_BULK_ACK_HDR_BYTES) || (ack[1] != tx->msg_id))
+    {
+        return;
+    }
+
+    poll_index = (uint16_t)ack[2] | (uint16_t)((uint16_t)ack[3] << 8U);
+    count = (uint16_t)ack[4] | (uint16_t)((uint16_t)ack[5] << 8U);
+
+    if ((count != tx->count) || (poll_index >= count) ||
+        (ack_length < (WT20_BULK_ACK_HDR_BYTES + ((count + 7U) / 8U))))
+    {
+        return;
+    }
+
+    tx->stats.acks++;
+    poll_seq = tx->last_send_seq[poll_index];
+
+    for (i = tx->first_unacked; i < count; i++)
+    {
+        if (BIT_GET_D(tx->acked, i) != 0U)
+        {
+            continue;
+        }
+
+        if (BIT_GET_D(bitmap, i) != 0U)
+        {
+            BIT_SET_D(tx->acked, i);
+            tx->acked_count++;
+            progress = true;
+
+            if (BIT_GET_D(tx->outstanding, i) != 0U)
+            {
+                BIT_CLR_D(tx->outstanding, i);
+                tx->outstanding_count--;
+            }
+        }
+    }
+
+    /* anything sent before the poll but missing from the bitmap was lost.
+       Fragments sent after the poll may still be on their way */
+    mark_lost(tx, poll_seq);
+
+    if (tx->awaiting_ack && (poll_seq == tx->last_poll_seq))
+    {
+        tx->awaiting_ack = false;
+
+        /* smoothed round trip, srtt += (sample - srtt) / 8 */
+        if (tx->srtt_ms == 0U)
+        {
+            tx->srtt_ms = (now_ms - tx->last_poll_ms) + 1U;
+        }
+        else
+        {
+            tx->srtt_ms = (uint32_t)((int32_t)tx->srtt_ms + (((int32_t)(now_ms - tx->last_poll_ms) - (int32_t)tx->srtt_ms) / 8));
+        }
+    }
+
+    while ((tx->first_unacked < count) && (BIT_GET_D(tx->acked, tx->first_unacked) != 0U))
+    {
+        tx->first_unacked++;
+    }
+
+    if (progress)
+    {
+        tx->last_progress_ms = now_ms;
+    }
+
+    if (tx->acked_count == count)
+    {
+        tx->state = WT20_BULK_COMPLETE;
+    }
+}
+
+WT20_BULK_STATE_T wt20_bulk_tx_state(const WT20_BULK_TX_T* tx)
+{
+    return tx->state;
+}
+
+uint16_t wt20_bulk_build_ack(WT20_FRAG_REASSEMBLER_T* reassembler,
+                             const uint8_t* src_mac,
+                             uint8_t msg_id,
+                             uint16_t poll_index,
+                             uint8_t ack_command,
+                             uint8_t* ack)
+{
+    uint16_t count;
+
+    if (!wt20_frag_get_progress(reassembler, src_mac, msg_id, &count, &ack[WT20_BULK_ACK_HDR_BYTES]))
+    {
+        return 0U;
+    }
+
+    ack[0] = ack_command;
+    ack[1] = msg_id;
+    ack[2] = (uint8_t)(poll_index & 0xFFU);
+    ack[3] = (uint8_t)(poll_index >> 8U);
+    ack[4] = (uint8_t)(count & 0xFFU);
+    ack[5] = (uint8_t)(count >> 8U);
+
+    return (uint16_t)(WT20_BULK_ACK_HDR_BYTES + ((count + 7U) / 8U));
+}
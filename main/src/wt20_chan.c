@@ -0,0 +1,217 @@
+/**
+ ********************************************************************************
+ * @file    wt20_chan.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Group wide channel switch handshake
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_chan.h"
+#include "espnow_link_chan.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define ID_OFFSET_D (0U)
+#define CHANNEL_OFFSET_D (2U)
+#define COUNTDOWN_OFFSET_D (3U)
+
+_Static_assert(WT20_PEER_MAX <= 32U, "acks are kept in a 32 bit mask");
+_Static_assert(WT20_CHAN_SWITCH_DELAY_MS < 0xFFFFU, "countdown must fit in 16 bits");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static bool announcing(const WT20_CHAN_T* chan);
+static uint32_t count_bits(uint32_t bits);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* until every expected peer acked. With none expected, nobody is known to be listening, so all the way */
+static bool announcing(const WT20_CHAN_T* chan)
+{
+    return (chan->state == WT20_CHAN_LEADING) && ((chan->expected == 0U) || ((chan->acked & chan->expected) != chan->expected)) &&
+           ((int32_t)(chan->switch_ms - chan->next_announce_ms) > 0);
+}
+
+static uint32_t count_bits(uint32_t bits)
+{
+    uint32_t count = 0U;
+
+    for (; bits != 0U; bits &= bits - 1U)
+    {
+        count++;
+    }
+
+    return count;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_chan_init(WT20_CHAN_T* chan, const uint8_t* own_mac)
+{
+    memset(chan, 0, sizeof(*chan));
+    memcpy(chan->own_mac, own_mac, sizeof(chan->own_mac));
+}
+
+bool wt20_chan_start(WT20_CHAN_T* chan, uint8_t channel, uint16_t id, uint32_t expected, uint32_t now_ms)
+{
+    if ((chan->state == WT20_CHAN_FOLLOWING) && (memcmp(chan->leader, chan->own_mac, sizeof(chan->leader)) < 0))
+    {
+        chan->stats.conflicts++;
+        return false;
+    }
+
+    /* a leader with a higher mac gives way once it hears this one */
+    chan->state = WT20_CHAN_LEADING;
+    memcpy(chan->leader, chan->own_mac, sizeof(chan->leader));
+    chan->id = id;
+    chan->channel = channel;
+    chan->switch_ms = now_ms + WT20_CHAN_SWITCH_DELAY_MS;
+    chan->next_announce_ms = now_ms;
+    chan->expected = expected;
+    chan->acked = 0U;
+
+    return true;
+}
+
+uint16_t wt20_chan_next_announce(WT20_CHAN_T* chan, uint32_t now_ms, uint8_t* payload)
+{
+    uint32_t countdown_ms;
+
+    if (!announcing(chan) || ((int32_t)(now_ms - chan->next_announce_ms) < 0) || ((int32_t)(chan->switch_ms - now_ms) <= 0))
+    {
+        return 0U;
+    }
+
+    /* each one carries the time left, so late ones still line every unit up on the same moment */
+    countdown_ms = chan->switch_ms - now_ms;
+    payload[ID_OFFSET_D] = (uint8_t)(chan->id & 0xFFU);
+    payload[ID_OFFSET_D + 1U] = (uint8_t)(chan->id >> 8U);
+    payload[CHANNEL_OFFSET_D] = chan->channel;
+    payload[COUNTDOWN_OFFSET_D] = (uint8_t)(countdown_ms & 0xFFU);
+    payload[COUNTDOWN_OFFSET_D + 1U] = (uint8_t)(countdown_ms >> 8U);
+
+    chan->next_announce_ms = now_ms + WT20_CHAN_ANNOUNCE_INTERVAL_MS;
+    chan->stats.announcements_sent++;
+
+    return WT20_CHAN_SWITCH_BYTES;
+}
+
+bool wt20_chan_on_announce(WT20_CHAN_T* chan, const uint8_t* src_mac, const uint8_t* payload, uint16_t length, uint32_t now_ms)
+{
+    uint16_t countdown_ms;
+    uint8_t channel;
+    int32_t order;
+
+    if ((length != WT20_CHAN_SWITCH_BYTES) || (memcmp(src_mac, chan->own_mac, sizeof(chan->own_mac)) == 0))
+    {
+        return false;
+    }
+
+    channel = payload[CHANNEL_OFFSET_D];
+    countdown_ms = (uint16_t)payload[COUNTDOWN_OFFSET_D] | (uint16_t)((uint16_t)payload[COUNTDOWN_OFFSET_D + 1U] << 8U);
+
+    if ((channel < ESPNOW_LINK_CHAN_FIRST) || (channel > ESPNOW_LINK_CHAN_LAST) || (countdown_ms > WT20_CHAN_SWITCH_DELAY_MS))
+    {
+        return false;
+    }
+
+    /* another switch under way, led by this unit or someone else. The lower mac goes ahead */
+    if (chan->state != WT20_CHAN_IDLE)
+    {
+        order = memcmp(src_mac, chan->leader, sizeof(chan->leader));
+
+        if (order != 0)
+        {
+            chan->stats.conflicts++;
+
+            if (order > 0)
+            {
+                return false;
+            }
+        }
+    }
+
+    chan->state = WT20_CHAN_FOLLOWING;
+    memcpy(chan->leader, src_mac, sizeof(chan->leader));
+    chan->id = (uint16_t)payload[ID_OFFSET_D] | (uint16_t)((uint16_t)payload[ID_OFFSET_D + 1U] << 8U);
+    chan->channel = channel;
+    chan->switch_ms = now_ms + countdown_ms;
+
+    return true;
+}
+
+uint16_t wt20_chan_build_ack(WT20_CHAN_T* chan, uint8_t* payload)
+{
+    payload[ID_OFFSET_D] = (uint8_t)(chan->id & 0xFFU);
+    payload[ID_OFFSET_D + 1U] = (uint8_t)(chan->id >> 8U);
+    payload[CHANNEL_OFFSET_D] = chan->channel;
+    chan->stats.acks_sent++;
+
+    return WT20_CHAN_ACK_BYTES;
+}
+
+bool wt20_chan_on_ack(WT20_CHAN_T* chan, WT20_PEER_ID_T peer_id, const uint8_t* payload, uint16_t length)
+{
+    uint32_t bit;
+
+    if ((chan->state != WT20_CHAN_LEADING) || (length != WT20_CHAN_ACK_BYTES) ||
+        (((uint16_t)payload[ID_OFFSET_D] | (uint16_t)((uint16_t)payload[ID_OFFSET_D + 1U] << 8U)) != chan->id) ||
+        (payload[CHANNEL_OFFSET_D] != chan->channel))
+    {
+        return false;
+    }
+
+    /* acks from units that were never added still count as heard, they just aren't waited on */
+    if ((peer_id != WT20_PEER_ID_NONE) && (peer_id <= WT20_PEER_MAX))
+    {
+        bit = 1UL << (peer_id - 1U);
+        chan->stats.acks_received += ((chan->acked & bit) == 0U) ? 1U : 0U;
+        chan->acked |= bit;
+    }
+
+    return true;
+}
+
+bool wt20_chan_due(WT20_CHAN_T* chan, uint32_t now_ms, uint8_t* channel)
+{
+    if ((chan->state == WT20_CHAN_IDLE) || ((int32_t)(now_ms - chan->switch_ms) < 0))
+    {
+        return false;
+    }
+
+    if (chan->state == WT20_CHAN_LEADING)
+    {
+        chan->stats.unacked += count_bits(chan->expected & ~chan->acked);
+    }
+
+    chan->state = WT20_CHAN_IDLE;
+    chan->stats.switches++;
+    *channel = chan->channel;
+
+    return true;
+}
+
+bool wt20_chan_pending(const WT20_CHAN_T* chan, uint32_t* due_ms)
+{
+    if (chan->state == WT20_CHAN_IDLE)
+    {
+        return false;
+    }
+
+    if (due_ms != NULL)
+    {
+        *due_ms = announcing(chan) ? chan->next_announce_ms : chan->switch_ms;
+    }
+
+    return true;
+}
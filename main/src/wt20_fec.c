@@ -0,0 +1,524 @@
+/**
+ ********************************************************************************
+ * @file    wt20_fec.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Forward error correction for live frames
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_fec.h"
+#include <string.h>
+#include <stddef.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+
+/* data and parity bitmaps are uint32_t */
+#if (WT20_FEC_MAX_DATA_FRAMES > 32U) || (WT20_FEC_MAX_PARITY_FRAMES > 32U)
+#error "WT20_FEC_MAX_DATA_FRAMES and WT20_FEC_MAX_PARITY_FRAMES must be 32 or less"
+#endif
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static bool code_init(WT20_FEC_CODE_T* code, const WT20_FEC_CONFIG_T* config);
+static uint32_t count_bits(uint32_t bits);
+static uint32_t all_data(const WT20_FEC_CONFIG_T* config);
+static void write_header(uint8_t* out, uint8_t group, uint8_t index, const WT20_FEC_CONFIG_T* config);
+static bool invert(uint8_t matrix[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_PARITY_FRAMES], uint32_t size);
+static WT20_FEC_GROUP_T* find_group(WT20_FEC_DECODER_T* decoder, uint32_t number);
+static void close_group(WT20_FEC_DECODER_T* decoder, WT20_FEC_GROUP_T* group);
+static void recover(WT20_FEC_DECODER_T* decoder, WT20_FEC_GROUP_T* group);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/*
+ * parity row j, data column i is 1 / (x_j + y_i) with x_j = j and y_i = m + i. Every square
+ * submatrix of a Cauchy matrix is invertible, so any m losses can be undone. Columns are then
+ * scaled so row 0 is all ones, which keeps that property and makes the first parity plain xor
+ */
+static bool code_init(WT20_FEC_CODE_T* code, const WT20_FEC_CONFIG_T* config)
+{
+    uint32_t i;
+    uint32_t j;
+
+    if ((config->k == 0U) || (config->k > WT20_FEC_MAX_DATA_FRAMES) || (config->m > WT20_FEC_MAX_PARITY_FRAMES) ||
+        (config->frame_bytes == 0U) || (config->frame_bytes > WT20_FEC_MAX_FRAME_BYTES))
+    {
+        return false;
+    }
+
+    gf256_init();
+    code->config = *config;
+
+    for (j = 0U; j < config->m; j++)
+    {
+        for (i = 0U; i < config->k; i++)
+        {
+            uint8_t y = (uint8_t)(config->m + i);
+
+            code->coefficients[j][i] = gf256_mul(gf256_inv((uint8_t)(j ^ y)), y);
+            gf256_mul_table(code->coefficients[j][i], &code->tables[j][i]);
+        }
+    }
+
+    return true;
+}
+
+static uint32_t count_bits(uint32_t bits)
+{
+    uint32_t count = 0U;
+
+    while (bits != 0U)
+    {
+        count++;
+        bits &= bits - 1U;
+    }
+
+    return count;
+}
+
+/* received_data once every data frame of a group is in */
+static uint32_t all_data(const WT20_FEC_CONFIG_T* config)
+{
+    return (config->k == 32U) ? 0xFFFFFFFFU : ((1UL << config->k) - 1U);
+}
+
+static void write_header(uint8_t* out, uint8_t group, uint8_t index, const WT20_FEC_CONFIG_T* config)
+{
+    out[0] = group;
+    out[1] = index;
+    out[2] = config->k;
+    out[3] = config->m;
+}
+
+/* gauss-jordan in place, size is at most WT20_FEC_MAX_PARITY_FRAMES */
+static bool invert(uint8_t matrix[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_PARITY_FRAMES], uint32_t size)
+{
+    uint8_t result[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_PARITY_FRAMES];
+    uint32_t row;
+    uint32_t col;
+    uint32_t pivot;
+    uint32_t i;
+
+    memset(result, 0U, sizeof(result));
+    for (i = 0U; i < size; i++)
+    {
+        result[i][i] = 1U;
+    }
+
+    for (col = 0U; col < size; col++)
+    {
+        uint8_t scale;
+
+        for (pivot = col; (pivot < size) && (matrix[pivot][col] == 0U); pivot++)
+        {
+        }
+
+        if (pivot == size)
+        {
+            return false;
+        }
+
+        for (i = 0U; i < size; i++)
+        {
+            uint8_t tmp = matrix[col][i];
+            matrix[col][i] = matrix[pivot][i];
+            matrix[pivot][i] = tmp;
+            tmp = result[col][i];
+            result[col][i] = result[pivot][i];
+            result[pivot][i] = tmp;
+        }
+
+        scale = gf256_inv(matrix[col][col]);
+        for (i = 0U; i < size; i++)
+        {
+            matrix[col][i] = gf256_mul(matrix[col][i], scale);
+            result[col][i] = gf256_mul(result[col][i], scale);
+        }
+
+        for (row = 0U; row < size; row++)
+        {
+            uint8_t factor = matrix[row][col];
+
+            if ((row == col) || (factor == 0U))
+            {
+                continue;
+            }
+
+            for (i = 0U; i < size; i++)
+            {
+                matrix[row][i] ^= gf256_mul(factor, matrix[col][i]);
+                result[row][i] ^= gf256_mul(factor, result[col][i]);
+            }
+        }
+    }
+
+    memcpy(matrix, result, sizeof(result));
+
+    return true;
+}
+
+static WT20_FEC_GROUP_T* find_group(WT20_FEC_DECODER_T* decoder, uint32_t number)
+{
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FEC_DECODER_GROUPS; i++)
+    {
+        if (decoder->groups[i].in_use && (decoder->groups[i].number == number))
+        {
+            return &decoder->groups[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* group is being replaced, whatever data it is still missing won't come back */
+static void close_group(WT20_FEC_DECODER_T* decoder, WT20_FEC_GROUP_T* group)
+{
+    decoder->stats.unrecoverable += count_bits(all_data(&decoder->code.config) & ~group->received_data);
+    group->in_use = false;
+}
+
+/* rebuilds every missing data frame. Caller has checked at least k frames of group are in */
+static void recover(WT20_FEC_DECODER_T* decoder, WT20_FEC_GROUP_T* group)
+{
+    const WT20_FEC_CODE_T* code = &decoder->code;
+    uint8_t matrix[WT20_FEC_MAX_PARITY_FRAMES][WT20_FEC_MAX_PARITY_FRAMES];
+    uint8_t missing[WT20_FEC_MAX_PARITY_FRAMES];
+    uint8_t rows[WT20_FEC_MAX_PARITY_FRAMES];
+    GF256_MUL_TABLE_T table;
+    uint32_t lost = 0U;
+    uint32_t used = 0U;
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; (i < code->config.k) && (lost < code->config.m); i++)
+    {
+        if ((group->received_data & (1UL << i)) == 0U)
+        {
+            missing[lost++] = (uint8_t)i;
+        }
+    }
+
+    for (j = 0U; (j < code->config.m) && (used < lost); j++)
+    {
+        if ((group->received_parity & (1UL << j)) != 0U)
+        {
+            rows[used++] = (uint8_t)j;
+        }
+    }
+
+    /* strip the known data out of each parity frame, leaving a combination of just the lost frames */
+    for (j = 0U; j < lost; j++)
+    {
+        uint8_t* syndrome = group->parity[rows[j]];
+
+        for (i = 0U; i < code->config.k; i++)
+        {
+            if ((group->received_data & (1UL << i)) != 0U)
+            {
+                gf256_mul_add_region(syndrome, group->data[i], &code->tables[rows[j]][i], code->config.frame_bytes);
+            }
+        }
+
+        for (i = 0U; i < lost; i++)
+        {
+            matrix[j][i] = code->coefficients[rows[j]][missing[i]];
+        }
+    }
+
+    if (!invert(matrix, lost))
+    {
+        return; /* can't happen with a cauchy code, but don't hand out garbage if it does */
+    }
+
+    for (i = 0U; i < lost; i++)
+    {
+        uint8_t* frame = group->data[missing[i]];
+
+        memset(frame, 0U, code->config.frame_bytes);
+
+        for (j = 0U; j < lost; j++)
+        {
+            gf256_mul_table(matrix[i][j], &table);
+            gf256_mul_add_region(frame, group->parity[rows[j]], &table, code->config.frame_bytes);
+        }
+
+        group->received_data |= (1UL << missing[i]);
+        decoder->stats.recovered++;
+
+        if (decoder->callback != NULL)
+        {
+            decoder->callback((group->number * code->config.k) + missing[i], frame, code->config.frame_bytes, true,
+                              decoder->context);
+        }
+    }
+
+    /* syndromes replaced the parity, so the group can't be decoded again */
+    group->received_parity = 0U;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool wt20_fec_encoder_init(WT20_FEC_ENCODER_T* encoder, const WT20_FEC_CONFIG_T* config)
+{
+    if (!code_init(&encoder->code, config))
+    {
+        return false;
+    }
+
+    encoder->group = 0U;
+    encoder->next_index = 0U;
+    encoder->next_parity = 0U;
+    memset(encoder->parity, 0U, sizeof(encoder->parity));
+
+    return true;
+}
+
+bool wt20_fec_encoder_resize(WT20_FEC_ENCODER_T* encoder, uint16_t frame_bytes)
+{
+    if ((frame_bytes == 0U) || (frame_bytes > WT20_FEC_MAX_FRAME_BYTES) || (encoder->next_index != 0U) ||
+        (encoder->next_parity != 0U))
+    {
+        return false;
+    }
+
+    /* parity is cleared as it is taken, so it is all zeros between groups whatever the size was */
+    encoder->code.config.frame_bytes = frame_bytes;
+
+    return true;
+}
+
+uint16_t wt20_fec_encode(WT20_FEC_ENCODER_T* encoder, const uint8_t* frame, uint16_t length, uint8_t* out)
+{
+    const WT20_FEC_CODE_T* code = &encoder->code;
+    uint32_t j;
+
+    if ((length > code->config.frame_bytes) || (encoder->next_index >= code->config.k))
+    {
+        return 0U;
+    }
+
+    /* parity is accumulated as frames go by, so data frames never need to be kept */
+    for (j = 0U; j < code->config.m; j++)
+    {
+        if (j == 0U)
+        {
+            gf256_add_region(encoder->parity[0], frame, length);
+        }
+        else
+        {
+            gf256_mul_add_region(encoder->parity[j], frame, &code->tables[j][encoder->next_index], length);
+        }
+    }
+
+    write_header(out, encoder->group, encoder->next_index, &code->config);
+    memcpy(&out[WT20_FEC_HDR_BYTES], frame, length);
+    memset(&out[WT20_FEC_HDR_BYTES + length], 0U, code->config.frame_bytes - length);
+    encoder->next_index++;
+
+    /* without parity a group ends right here */
+    if ((code->config.m == 0U) && (encoder->next_index == code->config.k))
+    {
+        encoder->next_index = 0U;
+        encoder->group++;
+    }
+
+    return (uint16_t)(WT20_FEC_HDR_BYTES + code->config.frame_bytes);
+}
+
+uint16_t wt20_fec_next_parity(WT20_FEC_ENCODER_T* encoder, uint8_t* out)
+{
+    const WT20_FEC_CODE_T* code = &encoder->code;
+    uint8_t j = encoder->next_parity;
+
+    if ((encoder->next_index < code->config.k) || (j >= code->config.m))
+    {
+        return 0U;
+    }
+
+    write_header(out, encoder->group, (uint8_t)(code->config.k + j), &code->config);
+    memcpy(&out[WT20_FEC_HDR_BYTES], encoder->parity[j], code->config.frame_bytes);
+    memset(encoder->parity[j], 0U, code->config.frame_bytes);
+    encoder->next_parity++;
+
+    if (encoder->next_parity == code->config.m)
+    {
+        encoder->next_parity = 0U;
+        encoder->next_index = 0U;
+        encoder->group++;
+    }
+
+    return (uint16_t)(WT20_FEC_HDR_BYTES + code->config.frame_bytes);
+}
+
+bool wt20_fec_decoder_init(WT20_FEC_DECODER_T* decoder,
+                           const WT20_FEC_CONFIG_T* config,
+                           WT20_FEC_FRAME_CB_T callback,
+                           void* context)
+{
+    uint32_t i;
+
+    if (!code_init(&decoder->code, config))
+    {
+        return false;
+    }
+
+    for (i = 0U; i < WT20_FEC_DECODER_GROUPS; i++)
+    {
+        decoder->groups[i].in_use = false;
+    }
+
+    decoder->newest_group = 0U;
+    decoder->started = false;
+    decoder->callback = callback;
+    decoder->context = context;
+    memset(&decoder->stats, 0U, sizeof(decoder->stats));
+
+    return true;
+}
+
+bool wt20_fec_decoder_resize(WT20_FEC_DECODER_T* decoder, uint16_t frame_bytes)
+{
+    uint32_t i;
+
+    if ((frame_bytes == 0U) || (frame_bytes > WT20_FEC_MAX_FRAME_BYTES))
+    {
+        return false;
+    }
+
+    /* frames of an open group came at the old length, any still to come are lost either way */
+    for (i = 0U; i < WT20_FEC_DECODER_GROUPS; i++)
+    {
+        if (decoder->groups[i].in_use)
+        {
+            close_group(decoder, &decoder->groups[i]);
+        }
+    }
+
+    decoder->code.config.frame_bytes = frame_bytes;
+
+    return true;
+}
+
+bool wt20_fec_decode(WT20_FEC_DECODER_T* decoder, const uint8_t* coded, uint16_t length)
+{
+    const WT20_FEC_CONFIG_T* config = &decoder->code.config;
+    WT20_FEC_GROUP_T* group;
+    const uint8_t* frame = &coded[WT20_FEC_HDR_BYTES];
+    uint32_t number;
+    uint8_t index;
+    uint32_t i;
+
+    if ((length != (WT20_FEC_HDR_BYTES + config->frame_bytes)) || (coded[2] != config->k) || (coded[3] != config->m) ||
+        (coded[1] >= (config->k + config->m)))
+    {
+        decoder->stats.invalid++;
+        return false;
+    }
+
+    decoder->stats.received++;
+    index = coded[1];
+
+    /* group id is 8 bits, widen it relative to the newest group so ordering survives wrap around */
+    if (!decoder->started)
+    {
+        decoder->started = true;
+        decoder->newest_group = coded[0];
+    }
+
+    number = decoder->newest_group + (uint32_t)(int32_t)(int8_t)(uint8_t)(coded[0] - (uint8_t)decoder->newest_group);
+
+    if ((int32_t)(number - decoder->newest_group) > 0)
+    {
+        decoder->newest_group = number;
+    }
+
+    group = find_group(decoder, number);
+
+    if (group == NULL)
+    {
+        WT20_FEC_GROUP_T* oldest = NULL;
+
+        for (i = 0U; i < WT20_FEC_DECODER_GROUPS; i++)
+        {
+            WT20_FEC_GROUP_T* candidate = &decoder->groups[i];
+
+            if (!candidate->in_use)
+            {
+                oldest = candidate;
+                break;
+            }
+
+            if ((oldest == NULL) || ((int32_t)(candidate->number - oldest->number) < 0))
+            {
+                oldest = candidate;
+            }
+        }
+
+        /* a straggler from a group that was already given up on */
+        if (oldest->in_use && ((int32_t)(number - oldest->number) < 0))
+        {
+            return true;
+        }
+
+        if (oldest->in_use)
+        {
+            close_group(decoder, oldest);
+        }
+
+        group = oldest;
+        group->in_use = true;
+        group->number = number;
+        group->received_data = 0U;
+        group->received_parity = 0U;
+    }
+
+    if (index < config->k)
+    {
+        if ((group->received_data & (1UL << index)) != 0U)
+        {
+            return true; /* duplicate, or already rebuilt */
+        }
+
+        memcpy(group->data[index], frame, config->frame_bytes);
+        group->received_data |= (1UL << index);
+
+        if (decoder->callback != NULL)
+        {
+            decoder->callback((number * config->k) + index, frame, config->frame_bytes, false, decoder->context);
+        }
+    }
+    else
+    {
+        index = (uint8_t)(index - config->k);
+
+        if ((group->received_data == all_data(config)) ||
+            ((group->received_parity & (1UL << index)) != 0U))
+        {
+            return true; /* nothing left to rebuild */
+        }
+
+        memcpy(group->parity[index], frame, config->frame_bytes);
+        group->received_parity |= (1UL << index);
+    }
+
+    /* any k frames of a group are enough to rebuild the rest */
+    if ((group->received_data != all_data(config)) &&
+        ((count_bits(group->received_data) + count_bits(group->received_parity)) >= config->k))
+    {
+        recover(decoder, group);
+    }
+
+    return true;
+}
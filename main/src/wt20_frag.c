@@ -0,0 +1,341 @@
+/**
+ ********************************************************************************
+ * @file    wt20_frag.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Splits messages larger than one frame into numbered fragments and reassembles them
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_frag.h"
+#include <string.h>
+#include <stddef.h>
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static WT20_FRAG_SLOT_T* find_slot(WT20_FRAG_REASSEMBLER_T* reassembler, const uint8_t* src_mac, uint8_t msg_id);
+static WT20_FRAG_SLOT_T* claim_slot(WT20_FRAG_REASSEMBLER_T* reassembler);
+static const WT20_FRAG_COMPLETION_T* find_recent(WT20_FRAG_REASSEMBLER_T* reassembler, const uint8_t* src_mac, uint8_t msg_id);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static WT20_FRAG_SLOT_T* find_slot(WT20_FRAG_REASSEMBLER_T* reassembler, const uint8_t* src_mac, uint8_t msg_id)
+{
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FRAG_REASSEMBLY_SLOTS; i++)
+    {
+        WT20_FRAG_SLOT_T* slot = &reassembler->slots[i];
+
+        if (slot->in_use && !slot->complete && (slot->msg_id == msg_id) &&
+            (memcmp(slot->src_mac, src_mac, WT20_FRAG_MAC_BYTES) == 0))
+        {
+            return slot;
+        }
+    }
+
+    return NULL;
+}
+
+static const WT20_FRAG_COMPLETION_T* find_recent(WT20_FRAG_REASSEMBLER_T* reassembler, const uint8_t* src_mac, uint8_t msg_id)
+{
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FRAG_RECENT_COMPLETIONS; i++)
+    {
+        const WT20_FRAG_COMPLETION_T* recent = &reassembler->recent[i];
+
+        if ((recent->count != 0U) && (recent->msg_id == msg_id) &&
+            (memcmp(recent->src_mac, src_mac, WT20_FRAG_MAC_BYTES) == 0))
+        {
+            return recent;
+        }
+    }
+
+    return NULL;
+}
+
+/* returns a free slot, evicting the least recently updated incomplete message if needed */
+static WT20_FRAG_SLOT_T* claim_slot(WT20_FRAG_REASSEMBLER_T* reassembler)
+{
+    WT20_FRAG_SLOT_T* oldest = NULL;
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FRAG_REASSEMBLY_SLOTS; i++)
+    {
+        WT20_FRAG_SLOT_T* slot = &reassembler->slots[i];
+
+        if (!slot->in_use)
+        {
+            return slot;
+        }
+
+        if (!slot->complete && ((oldest == NULL) || ((int32_t)(slot->last_update_ms - oldest->last_update_ms) < 0)))
+        {
+            oldest = slot;
+        }
+    }
+
+    if (oldest != NULL)
+    {
+        reassembler->stats.evicted++;
+    }
+
+    return oldest;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+uint16_t wt20_frag_count(uint32_t length)
+{
+    if (length == 0U)
+    {
+        return 1U; /* empty message still needs one fragment to arrive */
+    }
+
+    return (uint16_t)((length + WT20_FRAG_DATA_BYTES - 1U) / WT20_FRAG_DATA_BYTES);
+}
+
+uint16_t wt20_frag_build(uint8_t msg_id, const uint8_t* message, uint32_t length, uint16_t index, uint8_t* out)
+{
+    uint16_t count = wt20_frag_count(length);
+    uint32_t offset = (uint32_t)index * WT20_FRAG_DATA_BYTES;
+    uint32_t chunk;
+
+    if (index >= count)
+    {
+        return 0U;
+    }
+
+    chunk = length - offset;
+    if (chunk > WT20_FRAG_DATA_BYTES)
+    {
+        chunk = WT20_FRAG_DATA_BYTES;
+    }
+
+    /* little endian, independent of struct packing */
+    out[0] = msg_id;
+    out[1] = (uint8_t)(index & 0xFFU);
+    out[2] = (uint8_t)(index >> 8U);
+    out[3] = (uint8_t)(count & 0xFFU);
+    out[4] = (uint8_t)(count >> 8U);
+
+    if (chunk > 0U)
+    {
+        memcpy(&out[WT20_FRAG_HDR_BYTES], &message[offset], chunk);
+    }
+
+    return (uint16_t)(WT20_FRAG_HDR_BYTES + chunk);
+}
+
+bool wt20_frag_parse_header(const uint8_t* data, uint16_t length, WT20_FRAG_HDR_T* hdr)
+{
+    uint16_t chunk;
+
+    if ((length < WT20_FRAG_HDR_BYTES) || (length > WT20_FRAG_FRAME_BYTES))
+    {
+        return false;
+    }
+
+    hdr->msg_id = data[0];
+    hdr->index = (uint16_t)(data[1] | ((uint16_t)data[2] << 8U));
+    hdr->count = (uint16_t)(data[3] | ((uint16_t)data[4] << 8U));
+    chunk = (uint16_t)(length - WT20_FRAG_HDR_BYTES);
+
+    if ((hdr->count == 0U) || (hdr->count > WT20_FRAG_MAX_FRAGMENTS) || (hdr->index >= hdr->count))
+    {
+        return false;
+    }
+
+    /* WT20_FRAG_MAX_FRAGMENTS is rounded up, so a full last fragment could run past the
+       reassembly buffer */
+    if ((((uint32_t)hdr->index * WT20_FRAG_DATA_BYTES) + chunk) > WT20_FRAG_MAX_MESSAGE_BYTES)
+    {
+        return false;
+    }
+
+    /* every fragment but the last is full, and only a single fragment message may be empty */
+    if (hdr->index < (hdr->count - 1U))
+    {
+        return chunk == WT20_FRAG_DATA_BYTES;
+    }
+
+    return (chunk > 0U) || (hdr->count == 1U);
+}
+
+void wt20_frag_reassembly_init(WT20_FRAG_REASSEMBLER_T* reassembler)
+{
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FRAG_REASSEMBLY_SLOTS; i++)
+    {
+        reassembler->slots[i].in_use = false;
+        reassembler->slots[i].complete = false;
+    }
+
+    memset(reassembler->recent, 0U, sizeof(reassembler->recent));
+    reassembler->recent_next = 0U;
+    memset(&reassembler->stats, 0U, sizeof(reassembler->stats));
+}
+
+WT20_FRAG_RESULT_T wt20_frag_accept(WT20_FRAG_REASSEMBLER_T* reassembler,
+                                    const uint8_t* src_mac,
+                                    const uint8_t* data,
+                                    uint16_t length,
+                                    uint32_t now_ms,
+                                    WT20_FRAG_MESSAGE_T* message)
+{
+    WT20_FRAG_HDR_T hdr;
+    WT20_FRAG_SLOT_T* slot;
+    uint32_t chunk;
+
+    if (!wt20_frag_parse_header(data, length, &hdr))
+    {
+        reassembler->stats.invalid++;
+        return WT20_FRAG_INVALID;
+    }
+
+    wt20_frag_expire(reassembler, now_ms);
+
+    slot = find_slot(reassembler, src_mac, hdr.msg_id);
+
+    /* a retransmit of a message we already delivered */
+    if ((slot == NULL) && (find_recent(reassembler, src_mac, hdr.msg_id) != NULL))
+    {
+        reassembler->stats.duplicates++;
+        return WT20_FRAG_DUPLICATE;
+    }
+
+    if ((slot != NULL) && (slot->count != hdr.count))
+    {
+        /* msg_id was reused for a different message before the old one finished, start over */
+        slot->in_use = false;
+        slot = NULL;
+    }
+
+    if (slot == NULL)
+    {
+        slot = claim_slot(reassembler);
+
+        if (slot == NULL)
+        {
+            /* every slot holds a completed message the caller hasn't released */
+            reassembler->stats.invalid++;
+            return WT20_FRAG_INVALID;
+        }
+
+        slot->in_use = true;
+        slot->complete = false;
+        memcpy(slot->src_mac, src_mac, WT20_FRAG_MAC_BYTES);
+        slot->msg_id = hdr.msg_id;
+        slot->count = hdr.count;
+        slot->received = 0U;
+        slot->length = 0U;
+        memset(slot->bitmap, 0U, sizeof(slot->bitmap));
+    }
+
+    slot->last_update_ms = now_ms;
+
+    if ((slot->bitmap[hdr.index / 32U] & (1UL << (hdr.index % 32U))) != 0U)
+    {
+        reassembler->stats.duplicates++;
+        return WT20_FRAG_DUPLICATE;
+    }
+
+    /* fragments land directly at their final offset, so arrival order doesn't matter */
+    chunk = (uint32_t)length - WT20_FRAG_HDR_BYTES;
+    memcpy(&slot->buffer[(uint32_t)hdr.index * WT20_FRAG_DATA_BYTES], &data[WT20_FRAG_HDR_BYTES], chunk);
+    slot->bitmap[hdr.index / 32U] |= (1UL << (hdr.index % 32U));
+    slot->received++;
+
+    if (hdr.index == (hdr.count - 1U))
+    {
+        slot->length = ((uint32_t)hdr.index * WT20_FRAG_DATA_BYTES) + chunk;
+    }
+
+    if (slot->received < slot->count)
+    {
+        return WT20_FRAG_INCOMPLETE;
+    }
+
+    slot->complete = true;
+    reassembler->stats.completed++;
+
+    memcpy(reassembler->recent[reassembler->recent_next].src_mac, src_mac, WT20_FRAG_MAC_BYTES);
+    reassembler->recent[reassembler->recent_next].msg_id = hdr.msg_id;
+    reassembler->recent[reassembler->recent_next].count = hdr.count;
+    reassembler->recent_next = (uint8_t)((reassembler->recent_next + 1U) % WT20_FRAG_RECENT_COMPLETIONS);
+
+    message->src_mac = slot->src_mac;
+    message->msg_id = slot->msg_id;
+    message->data = slot->buffer;
+    message->length = slot->length;
+    message->slot = (uint32_t)(slot - reassembler->slots);
+
+    return WT20_FRAG_COMPLETE;
+}
+
+void wt20_frag_release(WT20_FRAG_REASSEMBLER_T* reassembler, uint32_t slot)
+{
+    if (slot < WT20_FRAG_REASSEMBLY_SLOTS)
+    {
+        reassembler->slots[slot].in_use = false;
+        reassembler->slots[slot].complete = false;
+    }
+}
+
+void wt20_frag_expire(WT20_FRAG_REASSEMBLER_T* reassembler, uint32_t now_ms)
+{
+    uint32_t i;
+
+    for (i = 0U; i < WT20_FRAG_REASSEMBLY_SLOTS; i++)
+    {
+        WT20_FRAG_SLOT_T* slot = &reassembler->slots[i];
+
+        if (slot->in_use && !slot->complete && ((now_ms - slot->last_update_ms) >= WT20_FRAG_TIMEOUT_MS))
+        {
+            slot->in_use = false;
+            reassembler->stats.timed_out++;
+        }
+    }
+}
+
+bool wt20_frag_get_progress(WT20_FRAG_REASSEMBLER_T* reassembler,
+                            const uint8_t* src_mac,
+                            uint8_t msg_id,
+                            uint16_t* count,
+                            uint8_t* bitmap)
+{
+    WT20_FRAG_SLOT_T* slot = find_slot(reassembler, src_mac, msg_id);
+    const WT20_FRAG_COMPLETION_T* recent;
+    uint16_t i;
+
+    if (slot != NULL)
+    {
+        *count = slot->count;
+        for (i = 0U; i < ((slot->count + 7U) / 8U); i++)
+        {
+            bitmap[i] = (uint8_t)(slot->bitmap[i / 4U] >> ((i % 4U) * 8U));
+        }
+
+        return true;
+    }
+
+    recent = find_recent(reassembler, src_mac, msg_id);
+
+    if (recent != NULL)
+    {
+        *count = recent->count;
+        memset(bitmap, 0xFFU, (recent->count + 7U) / 8U);
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,316 @@
+/**
+ ********************************************************************************
+ * @file    wt20_group.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Group talk with receiver driven repair
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_group.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+_Static_assert(WT20_GROUP_HISTORY <= 32U, "NACK bitmap covers at most 32 frames");
+_Static_assert(WT20_GROUP_HISTORY <= WT20_DEDUP_WINDOW, "history must fit in a talker's sequence window");
+
+#define MEMBER_WORD_D(group) ((uint32_t)(group) / 32U)
+#define MEMBER_BIT_D(group) (1UL << ((uint32_t)(group) % 32U))
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static bool has_bit(const atomic_uint_least32_t* bits, uint8_t group);
+static void set_bit(atomic_uint_least32_t* bits, uint8_t group, bool set);
+static WT20_GROUP_SOURCE_T* find_source(WT20_GROUP_RX_T* rx, const uint8_t* src_mac, uint8_t group, bool create);
+static bool copy_slot(const WT20_GROUP_SLOT_T* slot, uint8_t group, uint16_t seq, uint8_t* payload, uint16_t* length);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static bool has_bit(const atomic_uint_least32_t* bits, uint8_t group)
+{
+    return (atomic_load_explicit(&bits[MEMBER_WORD_D(group)], memory_order_relaxed) & MEMBER_BIT_D(group)) != 0U;
+}
+
+static void set_bit(atomic_uint_least32_t* bits, uint8_t group, bool set)
+{
+    if (set)
+    {
+        (void)atomic_fetch_or_explicit(&bits[MEMBER_WORD_D(group)], MEMBER_BIT_D(group), memory_order_relaxed);
+    }
+    else
+    {
+        (void)atomic_fetch_and_explicit(&bits[MEMBER_WORD_D(group)], ~MEMBER_BIT_D(group), memory_order_relaxed);
+    }
+}
+
+/* talker's entry for group, replacing the one heard from least recently if create is set */
+static WT20_GROUP_SOURCE_T* find_source(WT20_GROUP_RX_T* rx, const uint8_t* src_mac, uint8_t group, bool create)
+{
+    WT20_GROUP_SOURCE_T* oldest = &rx->sources[0];
+    uint32_t i;
+
+    for (i = 0U; i < WT20_GROUP_SOURCES; i++)
+    {
+        if (rx->sources[i].window.used && (rx->sources[i].group == group) &&
+            (memcmp(rx->sources[i].mac, src_mac, WT20_DEDUP_MAC_BYTES) == 0))
+        {
+            return &rx->sources[i];
+        }
+
+        if (!rx->sources[i].window.used || (rx->sources[i].last_used < oldest->last_used))
+        {
+            oldest = &rx->sources[i];
+        }
+    }
+
+    if (!create)
+    {
+        return NULL;
+    }
+
+    memset(oldest, 0, sizeof(*oldest));
+    memcpy(oldest->mac, src_mac, WT20_DEDUP_MAC_BYTES);
+    oldest->group = group;
+
+    return oldest;
+}
+
+/* copies slot out if it still holds group and seq, and wasn't rewritten while being copied */
+static bool copy_slot(const WT20_GROUP_SLOT_T* slot, uint8_t group, uint16_t seq, uint8_t* payload, uint16_t* length)
+{
+    uint32_t version = atomic_load_explicit(&slot->version, memory_order_acquire);
+
+    if (((version & 1U) != 0U) || (slot->group != group) || (slot->seq != seq) || (slot->length == 0U))
+    {
+        return false;
+    }
+
+    *length = slot->length;
+    memcpy(payload, slot->payload, *length);
+    atomic_thread_fence(memory_order_acquire);
+
+    return atomic_load_explicit(&slot->version, memory_order_relaxed) == version;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_group_tx_init(WT20_GROUP_TX_T* tx)
+{
+    memset(tx, 0, sizeof(*tx));
+}
+
+uint16_t wt20_group_tx_build(WT20_GROUP_TX_T* tx, uint8_t group, const uint8_t* frame, uint16_t length, uint8_t* payload)
+{
+    WT20_GROUP_SLOT_T* slot = &tx->history[tx->next_slot];
+    uint16_t seq = tx->next_seq[group];
+    uint32_t version;
+
+    if (length > WT20_GROUP_MAX_FRAME_BYTES)
+    {
+        return 0U;
+    }
+
+    payload[0] = group;
+    payload[1] = (uint8_t)(seq & 0xFFU);
+    payload[2] = (uint8_t)(seq >> 8U);
+    memcpy(&payload[WT20_GROUP_HDR_BYTES], frame, length);
+    length += WT20_GROUP_HDR_BYTES;
+
+    tx->next_seq[group]++;
+    tx->next_slot = (tx->next_slot + 1U) % WT20_GROUP_HISTORY;
+
+    /* overwrites the oldest frame, marked odd so a repair being copied out of it is dropped */
+    version = atomic_load_explicit(&slot->version, memory_order_relaxed);
+    atomic_store_explicit(&slot->version, version + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    slot->group = group;
+    slot->seq = seq;
+    slot->length = length;
+    memcpy(slot->payload, payload, length);
+
+    atomic_store_explicit(&slot->version, version + 2U, memory_order_release);
+
+    return length;
+}
+
+bool wt20_group_tx_on_nack(WT20_GROUP_TX_T* tx, const uint8_t* nack, uint16_t length)
+{
+    if (length < WT20_GROUP_NACK_BYTES)
+    {
+        return false;
+    }
+
+    tx->nack_group = nack[0];
+    tx->nack_newest = (uint16_t)nack[1] | (uint16_t)((uint16_t)nack[2] << 8U);
+    tx->nack_missing = (uint32_t)nack[3] | ((uint32_t)nack[4] << 8U) | ((uint32_t)nack[5] << 16U) |
+                       ((uint32_t)nack[6] << 24U);
+
+    /* only the history could be repaired, bit 0 is the newest frame, which the receiver has */
+    tx->nack_missing &= (WT20_GROUP_HISTORY >= 32U) ? 0xFFFFFFFEUL : (((1UL << WT20_GROUP_HISTORY) - 1U) & ~1UL);
+
+    return true;
+}
+
+uint16_t wt20_group_tx_next_repair(WT20_GROUP_TX_T* tx, uint32_t now_ms, uint8_t* payload)
+{
+    uint16_t length;
+    uint16_t seq;
+    uint32_t behind;
+    uint32_t i;
+
+    /* oldest missing frame first, it is closest to its playout deadline */
+    for (behind = WT20_GROUP_HISTORY - 1U; (behind > 0U) && (tx->nack_missing != 0U); behind--)
+    {
+        if ((tx->nack_missing & (1UL << behind)) == 0U)
+        {
+            continue;
+        }
+
+        tx->nack_missing &= ~(1UL << behind);
+        seq = (uint16_t)(tx->nack_newest - behind);
+
+        for (i = 0U; i < WT20_GROUP_HISTORY; i++)
+        {
+            /* another member just asked for this frame, the rebroadcast serves them both */
+            if (tx->repaired[i] && (tx->repaired_group[i] == tx->nack_group) && (tx->repaired_seq[i] == seq) &&
+                ((now_ms - tx->repaired_ms[i]) < WT20_GROUP_NACK_HOLDOFF_MS))
+            {
+                break;
+            }
+
+            if (copy_slot(&tx->history[i], tx->nack_group, seq, payload, &length))
+            {
+                tx->repaired[i] = true;
+                tx->repaired_group[i] = tx->nack_group;
+                tx->repaired_seq[i] = seq;
+                tx->repaired_ms[i] = now_ms;
+
+                return length;
+            }
+        }
+    }
+
+    return 0U;
+}
+
+void wt20_group_rx_init(WT20_GROUP_RX_T* rx)
+{
+    uint32_t i;
+
+    for (i = 0U; i < (WT20_GROUP_COUNT / 32U); i++)
+    {
+        atomic_store_explicit(&rx->members[i], 0U, memory_order_relaxed);
+        atomic_store_explicit(&rx->repair[i], 0U, memory_order_relaxed);
+    }
+
+    memset(rx->sources, 0, sizeof(rx->sources));
+    rx->clock = 0U;
+}
+
+void wt20_group_rx_set_member(WT20_GROUP_RX_T* rx, uint8_t group, bool member, bool repair)
+{
+    set_bit(rx->repair, group, member && repair);
+    set_bit(rx->members, group, member);
+}
+
+WT20_GROUP_RESULT_T wt20_group_rx_accept(WT20_GROUP_RX_T* rx,
+                                         const uint8_t* src_mac,
+                                         const uint8_t* payload,
+                                         uint16_t length,
+                                         bool repair,
+                                         WT20_GROUP_FRAME_T* frame)
+{
+    WT20_GROUP_SOURCE_T* source;
+    uint16_t seq;
+    bool restart;
+
+    if (length < WT20_GROUP_HDR_BYTES)
+    {
+        return WT20_GROUP_INVALID;
+    }
+
+    if (!has_bit(rx->members, payload[0]))
+    {
+        return WT20_GROUP_NOT_MEMBER;
+    }
+
+    seq = (uint16_t)payload[1] | (uint16_t)((uint16_t)payload[2] << 8U);
+    source = find_source(rx, src_mac, payload[0], true);
+    rx->clock++;
+    source->last_used = rx->clock;
+
+    /* same test wt20_seq_window_accept() uses to start over */
+    restart = !source->window.used || ((int16_t)(seq - source->window.newest_seq) <= -(int16_t)WT20_DEDUP_WINDOW);
+
+    if (!wt20_seq_window_accept(&source->window, seq))
+    {
+        return WT20_GROUP_DUPLICATE;
+    }
+
+    if (restart)
+    {
+        source->first_seq = seq;
+    }
+
+    /* frames that fell out of the talker's history can't be repaired, stop asking for them */
+    if ((uint16_t)(source->window.newest_seq - source->first_seq) >= WT20_GROUP_HISTORY)
+    {
+        source->first_seq = (uint16_t)(source->window.newest_seq - (WT20_GROUP_HISTORY - 1U));
+    }
+
+    frame->group = payload[0];
+    frame->seq = seq;
+    frame->data = &payload[WT20_GROUP_HDR_BYTES];
+    frame->length = length - WT20_GROUP_HDR_BYTES;
+
+    return repair ? WT20_GROUP_REPAIRED : WT20_GROUP_NEW;
+}
+
+uint16_t wt20_group_rx_build_nack(WT20_GROUP_RX_T* rx, const uint8_t* src_mac, uint8_t group, uint32_t now_ms, uint8_t* nack)
+{
+    WT20_GROUP_SOURCE_T* source;
+    uint32_t span;
+    uint32_t missing;
+
+    if (!has_bit(rx->repair, group))
+    {
+        return 0U;
+    }
+
+    source = find_source(rx, src_mac, group, false);
+
+    if ((source == NULL) || (source->nacked && ((now_ms - source->last_nack_ms) < WT20_GROUP_NACK_HOLDOFF_MS)))
+    {
+        return 0U;
+    }
+
+    span = (uint32_t)(uint16_t)(source->window.newest_seq - source->first_seq) + 1U;
+    missing = ~source->window.seen & ((span >= 32U) ? 0xFFFFFFFFUL : ((1UL << span) - 1U));
+
+    if (missing == 0U)
+    {
+        return 0U;
+    }
+
+    source->nacked = true;
+    source->last_nack_ms = now_ms;
+
+    nack[0] = group;
+    nack[1] = (uint8_t)(source->window.newest_seq & 0xFFU);
+    nack[2] = (uint8_t)(source->window.newest_seq >> 8U);
+    nack[3] = (uint8_t)(missing & 0xFFU);
+    nack[4] = (uint8_t)((missing >> 8U) & 0xFFU);
+    nack[5] = (uint8_t)((missing >> 16U) & 0xFFU);
+    nack[6] = (uint8_t)(missing >> 24U);
+
+    return WT20_GROUP_NACK_BYTES;
+}
@@ -0,0 +1,176 @@
+/**
+ ********************************************************************************
+ * @file    wt20_header.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Header at the front of every wt20 frame, and duplicate suppression
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_header.h"
+#include <string.h>
+#include "crc16.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+
+/* header bytes in front of the crc */
+#define CRC_OFFSET_D (WT20_HDR_BYTES - 2U)
+
+_Static_assert(WT20_DEDUP_WINDOW <= 32U, "dedup window must fit its bitmap");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint16_t frame_crc(const uint8_t* frame, uint16_t length);
+static WT20_DEDUP_PEER_T* find_peer(WT20_DEDUP_T* dedup, const uint8_t* src_mac);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static uint16_t frame_crc(const uint8_t* frame, uint16_t length)
+{
+    uint16_t crc = crc16_update(CRC16_INIT, frame, CRC_OFFSET_D);
+
+    return crc16_update(crc, &frame[WT20_HDR_BYTES], (uint32_t)length - WT20_HDR_BYTES);
+}
+
+/* finds sender, or takes the slot of the one heard from least recently */
+static WT20_DEDUP_PEER_T* find_peer(WT20_DEDUP_T* dedup, const uint8_t* src_mac)
+{
+    WT20_DEDUP_PEER_T* oldest = &dedup->peers[0];
+    uint32_t i;
+
+    for (i = 0U; i < WT20_DEDUP_PEERS; i++)
+    {
+        if (dedup->peers[i].window.used && (memcmp(dedup->peers[i].mac, src_mac, WT20_DEDUP_MAC_BYTES) == 0))
+        {
+            return &dedup->peers[i];
+        }
+
+        if (!dedup->peers[i].window.used)
+        {
+            oldest = &dedup->peers[i];
+        }
+        else if (oldest->window.used && ((dedup->clock - dedup->peers[i].last_used) > (dedup->clock - oldest->last_used)))
+        {
+            oldest = &dedup->peers[i];
+        }
+    }
+
+    oldest->window.used = false;
+    memcpy(oldest->mac, src_mac, WT20_DEDUP_MAC_BYTES);
+
+    return oldest;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+uint16_t wt20_header_build(const WT20_HDR_T* hdr, uint8_t* frame, uint16_t payload_length)
+{
+    uint16_t length = WT20_HDR_BYTES + payload_length;
+    uint16_t crc;
+
+    frame[0] = (uint8_t)((WT20_HDR_VERSION << 4U) | (hdr->flags & WT20_HDR_FLAGS_MASK));
+    frame[1] = hdr->type;
+    frame[2] = (uint8_t)(hdr->seq & 0xFFU);
+    frame[3] = (uint8_t)(hdr->seq >> 8U);
+    frame[4] = (uint8_t)(hdr->timestamp_ms & 0xFFU);
+    frame[5] = (uint8_t)(hdr->timestamp_ms >> 8U);
+
+    crc = frame_crc(frame, length);
+    frame[6] = (uint8_t)(crc & 0xFFU);
+    frame[7] = (uint8_t)(crc >> 8U);
+
+    return length;
+}
+
+WT20_HDR_RESULT_T wt20_header_parse(const uint8_t* frame, uint16_t length, WT20_HDR_T* hdr)
+{
+    uint16_t crc;
+
+    if (length < WT20_HDR_BYTES)
+    {
+        return WT20_HDR_TOO_SHORT;
+    }
+
+    if ((frame[0] >> 4U) != WT20_HDR_VERSION)
+    {
+        return WT20_HDR_BAD_VERSION;
+    }
+
+    crc = (uint16_t)frame[6] | (uint16_t)((uint16_t)frame[7] << 8U);
+
+    if (crc != frame_crc(frame, length))
+    {
+        return WT20_HDR_BAD_CRC;
+    }
+
+    hdr->version = frame[0] >> 4U;
+    hdr->flags = frame[0] & WT20_HDR_FLAGS_MASK;
+    hdr->type = frame[1];
+    hdr->seq = (uint16_t)frame[2] | (uint16_t)((uint16_t)frame[3] << 8U);
+    hdr->timestamp_ms = (uint16_t)frame[4] | (uint16_t)((uint16_t)frame[5] << 8U);
+
+    return WT20_HDR_OK;
+}
+
+void wt20_dedup_init(WT20_DEDUP_T* dedup)
+{
+    memset(dedup, 0, sizeof(*dedup));
+}
+
+bool wt20_seq_window_accept(WT20_SEQ_WINDOW_T* window, uint16_t seq)
+{
+    int16_t ahead = (int16_t)(seq - window->newest_seq);
+    uint32_t behind;
+
+    if (!window->used || (ahead <= -(int16_t)WT20_DEDUP_WINDOW))
+    {
+        /* new sender, or one that restarted its count */
+        window->used = true;
+        window->newest_seq = seq;
+        window->seen = 1U;
+        return true;
+    }
+
+    if (ahead > 0)
+    {
+        window->seen = ((uint32_t)ahead >= WT20_DEDUP_WINDOW) ? 1U : ((window->seen << (uint32_t)ahead) | 1U);
+        window->newest_seq = seq;
+        return true;
+    }
+
+    behind = (uint32_t)(-ahead);
+
+    if ((window->seen & (1UL << behind)) != 0U)
+    {
+        return false;
+    }
+
+    /* arrived out of order */
+    window->seen |= 1UL << behind;
+
+    return true;
+}
+
+bool wt20_dedup_accept(WT20_DEDUP_T* dedup, const uint8_t* src_mac, uint16_t seq)
+{
+    WT20_DEDUP_PEER_T* peer = find_peer(dedup, src_mac);
+
+    dedup->clock++;
+    peer->last_used = dedup->clock;
+
+    if (!wt20_seq_window_accept(&peer->window, seq))
+    {
+        dedup->duplicates++;
+        return false;
+    }
+
+    return true;
+}
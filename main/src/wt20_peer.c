@@ -0,0 +1,165 @@
+/**
+ ********************************************************************************
+ * @file    wt20_peer.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Peer table hashed on MAC
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_peer.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define SLOT_MASK_D (WT20_PEER_HASH_SLOTS - 1U)
+
+/* 2^32 / golden ratio, spreads nearby MACs across the index */
+#define HASH_MULTIPLIER_D (0x9E3779B1U)
+
+_Static_assert((WT20_PEER_MAX * 2U) <= WT20_PEER_HASH_SLOTS, "peer hash index must be at least twice WT20_PEER_MAX");
+_Static_assert(WT20_PEER_MAX < 256U, "peer ids must fit in a byte");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t home_slot(const uint8_t* mac);
+static bool between(uint32_t from, uint32_t slot, uint32_t to);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* vendor bytes are shared by most peers, so every byte goes in */
+static uint32_t home_slot(const uint8_t* mac)
+{
+    uint32_t key = ((uint32_t)mac[2] << 24U) | ((uint32_t)mac[3] << 16U) | ((uint32_t)mac[4] << 8U) | (uint32_t)mac[5];
+
+    key ^= ((uint32_t)mac[0] << 8U) | (uint32_t)mac[1];
+
+    return (uint32_t)(key * HASH_MULTIPLIER_D) >> (32U - WT20_PEER_HASH_BITS);
+}
+
+/* whether slot is in the cyclic run (from, to] */
+static bool between(uint32_t from, uint32_t slot, uint32_t to)
+{
+    return ((slot - from - 1U) & SLOT_MASK_D) < ((to - from) & SLOT_MASK_D);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_peer_table_init(WT20_PEER_TABLE_T* table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+WT20_PEER_ID_T wt20_peer_add(WT20_PEER_TABLE_T* table, const uint8_t* mac)
+{
+    WT20_PEER_ID_T id = wt20_peer_find(table, mac);
+    WT20_PEER_T* peer = NULL;
+    uint32_t slot;
+    uint32_t i;
+
+    if (id != WT20_PEER_ID_NONE)
+    {
+        return id;
+    }
+
+    for (i = 0U; i < WT20_PEER_MAX; i++)
+    {
+        if (table->peers[i].id == WT20_PEER_ID_NONE)
+        {
+            peer = &table->peers[i];
+            id = (WT20_PEER_ID_T)(i + 1U);
+            break;
+        }
+    }
+
+    if (peer == NULL)
+    {
+        return WT20_PEER_ID_NONE;
+    }
+
+    memset(peer, 0, sizeof(*peer));
+    memcpy(peer->mac, mac, WT20_PEER_MAC_BYTES);
+    peer->id = id;
+
+    /* the index is never more than half full, so there is always an empty slot */
+    for (slot = home_slot(mac); table->index[slot] != WT20_PEER_ID_NONE; slot = (slot + 1U) & SLOT_MASK_D)
+    {
+    }
+
+    table->index[slot] = id;
+    table->count++;
+
+    return id;
+}
+
+bool wt20_peer_remove(WT20_PEER_TABLE_T* table, WT20_PEER_ID_T id)
+{
+    WT20_PEER_T* peer = wt20_peer_get(table, id);
+    uint32_t hole;
+    uint32_t slot;
+    uint32_t home;
+
+    if (peer == NULL)
+    {
+        return false;
+    }
+
+    for (hole = home_slot(peer->mac); table->index[hole] != id; hole = (hole + 1U) & SLOT_MASK_D)
+    {
+    }
+
+    /* pull later members of the run back into the hole, so lookups never need tombstones */
+    table->index[hole] = WT20_PEER_ID_NONE;
+
+    for (slot = (hole + 1U) & SLOT_MASK_D; table->index[slot] != WT20_PEER_ID_NONE; slot = (slot + 1U) & SLOT_MASK_D)
+    {
+        home = home_slot(table->peers[table->index[slot] - 1U].mac);
+
+        /* a member whose home is after the hole would no longer be found if it moved before it */
+        if (!between(hole, home, slot))
+        {
+            table->index[hole] = table->index[slot];
+            table->index[slot] = WT20_PEER_ID_NONE;
+            hole = slot;
+        }
+    }
+
+    peer->id = WT20_PEER_ID_NONE;
+    table->count--;
+
+    return true;
+}
+
+WT20_PEER_ID_T wt20_peer_find(const WT20_PEER_TABLE_T* table, const uint8_t* mac)
+{
+    WT20_PEER_ID_T id;
+    uint32_t slot;
+
+    for (slot = home_slot(mac); (id = table->index[slot]) != WT20_PEER_ID_NONE; slot = (slot + 1U) & SLOT_MASK_D)
+    {
+        if (memcmp(table->peers[id - 1U].mac, mac, WT20_PEER_MAC_BYTES) == 0)
+        {
+            return id;
+        }
+    }
+
+    return WT20_PEER_ID_NONE;
+}
+
+WT20_PEER_T* wt20_peer_get(WT20_PEER_TABLE_T* table, WT20_PEER_ID_T id)
+{
+    if ((id == WT20_PEER_ID_NONE) || (id > WT20_PEER_MAX) || (table->peers[id - 1U].id != id))
+    {
+        return NULL;
+    }
+
+    return &table->peers[id - 1U];
+}
@@ -12,71 +12,1384 @@
  ************************************/
 #include <string.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #include "wt20_protocol.h"
+#include "wt20_frag.h"
+#include "wt20_bulk.h"
+#include "wt20_fec.h"
+#include "wt20_header.h"
+#include "wt20_peer.h"
+#include "wt20_group.h"
+#include "wt20_relay.h"
+#include "wt20_chan.h"
+#include "wt20_vrate.h"
+#include "adpcm.h"
 #include "espnow_link.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "timing.h"
 
 /************************************
  * PRIVATE MACROS AND DEFINES
  ************************************/
 
+/* longest the receiving task sleeps while a reliable transfer is running, so ack timeouts are
+   noticed. The link sleeps at least a tick, so with a coarse tick this is a tick */
+#define BULK_SERVICE_MS_D (5U)
+
+#ifdef CONFIG_WT20_FEC_DATA_FRAMES
+#define FEC_DATA_FRAMES_D (CONFIG_WT20_FEC_DATA_FRAMES)
+#else
+#define FEC_DATA_FRAMES_D (4U)
+#endif
+
+#ifdef CONFIG_WT20_FEC_PARITY_FRAMES
+#define FEC_PARITY_FRAMES_D (CONFIG_WT20_FEC_PARITY_FRAMES)
+#else
+#define FEC_PARITY_FRAMES_D (1U)
+#endif
+
+/* wt20_bulk builds frames that start with a command byte. Built at this offset, that byte is
+   the last header byte, and is moved into the header's type field when the header is filled in */
+#define COMMAND_OFFSET_D (WT20_HDR_BYTES - 1U)
+
+_Static_assert(WT20_FRAME_BYTES <= ESPNOW_DATA_BYTES, "wt20 frame is larger than esp now allows");
+_Static_assert(WT20_HDR_BYTES > ESPNOW_LINK_PS_BEACON_BYTES, "link beacons are told apart from wt20 frames by length");
+
+/* longest a fragment waits for room in the link's pipeline while other writers fill it. Frames
+   held for a sleeping peer free theirs within a wake interval */
+#define SEND_SLOT_WAIT_MS_D (2U * ESPNOW_LINK_PS_INTERVAL_MS)
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+
+/* results of one wt20_send_message()'s fragments, counted by fragment_sent() from the wifi task */
+typedef struct
+{
+    atomic_uint_least32_t done;
+    atomic_uint_least32_t failed;
+} SEND_PROGRESS_T;
+
+/* frames on their way to or from the link are built in pool blocks, not on task stacks */
+typedef union
+{
+    ESPNOW_LINK_MSG_T link;         /* frame read from link */
+    WT20_MSG_T msg;                 /* message handed to a wt20_receive_all() handler */
+    uint8_t tx[ESPNOW_DATA_BYTES];  /* frame being sent */
+} FRAME_BUFFER_T;
+
 /************************************
  * STATIC VARIABLES
  ************************************/
 
-static bool initialized = false;
+static bool initialized = false;
+static MEM_POOL_T frame_pool;
+MEM_POOL_STORAGE(frame_pool_storage, sizeof(FRAME_BUFFER_T), WT20_FRAME_POOL_BLOCKS);
+static WT20_FRAG_REASSEMBLER_T reassembler;
+static uint8_t next_msg_id = 0U;
+static atomic_uint_least32_t next_seq = 0U;
+static WT20_PEER_TABLE_T peers;
+static WT20_DEDUP_T dedup;      /* for senders that aren't in the peer table */
+static WT20_RX_STATS_T rx_stats;
+static WT20_MESSAGE_CB_T message_callback = NULL;
+static void* message_callback_context = NULL;
+
+/* reliable transfer. Started by any task, then owned by the receiving task until bulk_active clears */
+static WT20_BULK_TX_T bulk_tx;
+static uint8_t bulk_peer_mac[6U];
+static WT20_TRANSFER_DONE_CB_T bulk_done_callback = NULL;
+static void* bulk_done_context = NULL;
+static atomic_bool bulk_active = false;
+
+/* group talk */
+static const uint8_t broadcast_mac[6U] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+static bool broadcast_registered = false;
+static WT20_GROUP_TX_T group_tx;
+static WT20_GROUP_RX_T group_rx;
+static WT20_GROUP_STATS_T group_stats;
+static WT20_GROUP_CB_T group_callback = NULL;
+static void* group_callback_context = NULL;
+
+/* multi-hop relay. relay_enabled is set by any task, the cache and queue belong to the receiving task */
+static atomic_bool relay_enabled = false;
+static atomic_uint_least32_t next_relay_seq = 0U;
+static WT20_RELAY_T relay;
+static WT20_RELAY_STATS_T relay_stats;
+static uint8_t device_mac[6U];
+
+/* group channel switch. chan_request is set by any task, the switch belongs to the receiving task */
+static atomic_uint_least32_t chan_request = 0U;
+static WT20_CHAN_T chan;
+static uint16_t next_chan_id = 0U;
+
+/* live frames */
+static WT20_FEC_ENCODER_T stream_encoder;
+static WT20_FEC_DECODER_T stream_decoder;
+static WT20_STREAM_CB_T stream_callback = NULL;
+static void* stream_callback_context = NULL;
+static uint16_t stream_frame_bytes = WT20_FEC_MAX_FRAME_BYTES; /* as configured, voice modes size groups under it */
+
+/* voice rate. The controller belongs to the task writing the stream, and reports reach it
+   through voice_report. The listener side belongs to the receiving task */
+static WT20_VRATE_T voice_rate;
+static atomic_uint_least32_t voice_report = 0U; /* loss of the newest report + 1, 0 if none */
+static WT20_VRATE_RX_T voice_rx;
+static bool voice_report_due = false;
+static uint32_t stream_lost = 0U;               /* decoder's unrecoverable count already passed on */
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint16_t finish_frame(uint8_t* frame, uint8_t type, uint16_t payload_length);
+static uint16_t finish_command_frame(uint8_t* frame, uint16_t command_frame_length);
+static WT20_ERR_T read_message(const WT20_MSG_T* msg_buffer);
+static WT20_FRAG_RESULT_T handle_fragment(const ESPNOW_LINK_MSG_T* recv_msg);
+static void handle_bulk_fragment(const ESPNOW_LINK_MSG_T* recv_msg, uint8_t type);
+static void handle_bulk_ack(const ESPNOW_LINK_MSG_T* recv_msg);
+static void handle_echo_request(const ESPNOW_LINK_MSG_T* recv_msg, bool relayed);
+static void service_bulk(void);
+static void bulk_frame_sent(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context);
+static void fragment_sent(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context);
+static bool wait_for_frames(uint32_t timeout_ms);
+static void handle_stream_frame(const ESPNOW_LINK_MSG_T* recv_msg);
+static void stream_frame_ready(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context);
+static void send_stream_report(const uint8_t* dest_mac);
+static void handle_stream_report(const ESPNOW_LINK_MSG_T* recv_msg);
+static WT20_ERR_T register_broadcast(void);
+static void handle_group_frame(const ESPNOW_LINK_MSG_T* recv_msg, WT20_PEER_ID_T peer_id, bool repair);
+static void handle_group_nack(const ESPNOW_LINK_MSG_T* recv_msg);
+static WT20_ERR_T send_relayed(const uint8_t* dest_mac, uint8_t command, const uint8_t* payload, uint16_t payload_length);
+static bool handle_relay_frame(ESPNOW_LINK_MSG_T* recv_msg, WT20_HDR_T* hdr);
+static void service_relay(void);
+static void handle_channel_switch(const ESPNOW_LINK_MSG_T* recv_msg);
+static void handle_channel_ack(const ESPNOW_LINK_MSG_T* recv_msg, WT20_PEER_ID_T peer_id);
+static void service_channel(void);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* fills in the header in front of a frame's payload. Returns length of whole frame */
+static uint16_t finish_frame(uint8_t* frame, uint8_t type, uint16_t payload_length)
+{
+    WT20_HDR_T hdr = {
+        .flags = 0U,
+        .type = type,
+        .seq = (uint16_t)atomic_fetch_add_explicit(&next_seq, 1U, memory_order_relaxed),
+        .timestamp_ms = (uint16_t)timing_get_ms()
+    };
+
+    return wt20_header_build(&hdr, frame, payload_length);
+}
+
+/* same, for a frame wt20_bulk built at COMMAND_OFFSET_D */
+static uint16_t finish_command_frame(uint8_t* frame, uint16_t command_frame_length)
+{
+    return finish_frame(frame, frame[COMMAND_OFFSET_D], command_frame_length - 1U);
+}
+
+/* feeds fragment to reassembly, passing the message on once it is complete */
+static WT20_FRAG_RESULT_T handle_fragment(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    WT20_FRAG_MESSAGE_T message;
+    WT20_FRAG_RESULT_T result;
+
+    result = wt20_frag_accept(&reassembler, recv_msg->info.src_mac, &recv_msg->data[WT20_HDR_BYTES],
+                              recv_msg->info.data_len - WT20_HDR_BYTES, timing_get_ms(), &message);
+
+    if (result == WT20_FRAG_COMPLETE)
+    {
+        metrics_inc(METRIC_WT20_MESSAGES);
+
+        if (message_callback != NULL)
+        {
+            message_callback(message.src_mac, message.data, message.length, message_callback_context);
+        }
+
+        wt20_frag_release(&reassembler, message.slot);
+    }
+
+    return result;
+}
+
+/* receiver side of a reliable transfer. Acks polls, and the fragment that completes a message */
+static void handle_bulk_fragment(const ESPNOW_LINK_MSG_T* recv_msg, uint8_t type)
+{
+    uint8_t ack[COMMAND_OFFSET_D + WT20_BULK_ACK_MAX_BYTES];
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    WT20_FRAG_HDR_T hdr;
+    WT20_FRAG_RESULT_T result;
+    uint16_t ack_length;
+
+    if (!wt20_frag_parse_header(&recv_msg->data[WT20_HDR_BYTES], recv_msg->info.data_len - WT20_HDR_BYTES, &hdr))
+    {
+        return;
+    }
+
+    result = handle_fragment(recv_msg);
+
+    if ((result != WT20_FRAG_INVALID) && ((type == WT20_COMMAND_BULK_POLL) || (result == WT20_FRAG_COMPLETE)))
+    {
+        ack_length = wt20_bulk_build_ack(&reassembler, recv_msg->info.src_mac, hdr.msg_id, hdr.index,
+                                         (uint8_t)WT20_COMMAND_BULK_ACK, &ack[COMMAND_OFFSET_D]);
+
+        /* never wait here. If the pipeline is full the sender times out and polls again */
+        if (ack_length > 0U)
+        {
+            ack_length = finish_command_frame(ack, ack_length);
+            (void)espnow_link_write_async(recv_msg->info.src_mac, ack, ack_length, NULL, NULL, &handle);
+        }
+    }
+}
+
+/* sender side of a reliable transfer */
+static void handle_bulk_ack(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    if (!atomic_load_explicit(&bulk_active, memory_order_acquire) ||
+        (memcmp(recv_msg->info.src_mac, bulk_peer_mac, sizeof(bulk_peer_mac)) != 0))
+    {
+        return;
+    }
+
+    /* ack is read from its command byte position, which wt20_bulk skips */
+    wt20_bulk_tx_on_ack(&bulk_tx, &recv_msg->data[COMMAND_OFFSET_D], recv_msg->info.data_len - COMMAND_OFFSET_D,
+                        timing_get_ms());
+    service_bulk();
+}
+
+/* answers with the request's payload, the way it came. Never waits, a lost answer looks like a lost request */
+static void handle_echo_request(const ESPNOW_LINK_MSG_T* recv_msg, bool relayed)
+{
+    uint8_t* reply;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint16_t payload_length = recv_msg->info.data_len - WT20_HDR_BYTES;
+    uint16_t length;
+
+    if (relayed)
+    {
+        (void)send_relayed(recv_msg->info.src_mac, (uint8_t)WT20_COMMAND_ECHO_REPLY, &recv_msg->data[WT20_HDR_BYTES],
+                           payload_length);
+        return;
+    }
+
+    reply = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    if (reply == NULL)
+    {
+        return;
+    }
+
+    memcpy(&reply[WT20_HDR_BYTES], &recv_msg->data[WT20_HDR_BYTES], payload_length);
+    length = finish_frame(reply, (uint8_t)WT20_COMMAND_ECHO_REPLY, payload_length);
+    (void)espnow_link_write_async(recv_msg->info.src_mac, reply, length, NULL, NULL, &handle);
+    mem_pool_free(&frame_pool, reply);
+}
+
+/* sends whatever the reliable transfer allows right now, and finishes it once it is done */
+static void service_bulk(void)
+{
+    FRAME_BUFFER_T* frame;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    WT20_TRANSFER_DONE_CB_T done_callback;
+    uint16_t frame_length;
+    WT20_BULK_STATE_T state;
+
+    if (!atomic_load_explicit(&bulk_active, memory_order_acquire))
+    {
+        return;
+    }
+
+    /* no buffer just means nothing goes out this time, the transfer's timers recover */
+    frame = (FRAME_BUFFER_T*)mem_pool_alloc(&frame_pool);
+
+    /* only hand esp now as many frames as it can take, the rest wait for bulk_frame_sent() */
+    while ((frame != NULL) && (espnow_link_tx_pending() < ESPNOW_LINK_TX_MAX_IN_FLIGHT) &&
+           wt20_bulk_tx_next(&bulk_tx, timing_get_ms(), &frame->tx[COMMAND_OFFSET_D], &frame_length))
+    {
+        frame_length = finish_command_frame(frame->tx, frame_length);
+
+        /* a frame that doesn't go out is treated like one lost in the air */
+        (void)espnow_link_write_async(bulk_peer_mac, frame->tx, frame_length, bulk_frame_sent, NULL, &handle);
+    }
+
+    mem_pool_free(&frame_pool, frame);
+
+    state = wt20_bulk_tx_state(&bulk_tx);
+
+    if ((state == WT20_BULK_COMPLETE) || (state == WT20_BULK_FAILED))
+    {
+        /* clear before calling back so callback can start the next transfer */
+        done_callback = bulk_done_callback;
+        atomic_store_explicit(&bulk_active, false, memory_order_release);
+
+        if (done_callback != NULL)
+        {
+            done_callback(state == WT20_BULK_COMPLETE, bulk_done_context);
+        }
+    }
+}
+
+/* runs from esp now's send callback. A pipeline slot freed up, so let the receiving task send more */
+static void bulk_frame_sent(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context)
+{
+    espnow_link_wake_reader();
+}
+
+/* wifi task, once per fragment of a wt20_send_message(). Fragments complete in send order */
+static void fragment_sent(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context)
+{
+    SEND_PROGRESS_T* progress = (SEND_PROGRESS_T*)context;
+
+    if (!success)
+    {
+        atomic_fetch_add_explicit(&progress->failed, 1U, memory_order_relaxed);
+    }
+
+    atomic_fetch_add_explicit(&progress->done, 1U, memory_order_release);
+}
+
+/* live frame, rebuilt frames come out through stream_frame_ready() */
+static void handle_stream_frame(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    const uint8_t* coded = &recv_msg->data[WT20_HDR_BYTES];
+    uint16_t length;
+    WT20_FEC_CONFIG_T config;
+
+    if (recv_msg->info.data_len < (WT20_HDR_BYTES + WT20_FEC_HDR_BYTES))
+    {
+        return;
+    }
+
+    length = recv_msg->info.data_len - WT20_HDR_BYTES;
+    config.k = coded[2];
+    config.m = coded[3];
+    config.frame_bytes = length - WT20_FEC_HDR_BYTES;
+
+    /* sender changed its fec config, follow it. A new frame length alone is a voice mode
+       change, seq carries on across it */
+    if ((config.k != stream_decoder.code.config.k) || (config.m != stream_decoder.code.config.m))
+    {
+        if (!wt20_fec_decoder_init(&stream_decoder, &config, stream_frame_ready, NULL))
+        {
+            return;
+        }
+
+        stream_lost = 0U;
+    }
+    else if (config.frame_bytes != stream_decoder.code.config.frame_bytes)
+    {
+        if (!wt20_fec_decoder_resize(&stream_decoder, config.frame_bytes))
+        {
+            return;
+        }
+    }
+
+    (void)wt20_fec_decode(&stream_decoder, coded, length);
+
+    if (stream_decoder.stats.unrecoverable != stream_lost)
+    {
+        wt20_vrate_rx_on_lost(&voice_rx, stream_decoder.stats.unrecoverable - stream_lost);
+        stream_lost = stream_decoder.stats.unrecoverable;
+    }
+
+    if (voice_report_due)
+    {
+        voice_report_due = false;
+        send_stream_report(recv_msg->info.src_mac);
+    }
+}
+
+static void stream_frame_ready(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    voice_report_due |= wt20_vrate_rx_on_frame(&voice_rx, recovered);
+
+    if (stream_callback != NULL)
+    {
+        stream_callback(seq, frame, length, recovered, stream_callback_context);
+    }
+}
+
+/* tells the talker the loss since the last report. Not waited on, a lost report just means
+   the talker goes on what it sees itself until the next one */
+static void send_stream_report(const uint8_t* dest_mac)
+{
+    uint8_t report[WT20_HDR_BYTES + WT20_VRATE_REPORT_BYTES];
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint16_t length;
+
+    length = wt20_vrate_rx_build_report(&voice_rx, &report[WT20_HDR_BYTES]);
+    length = finish_frame(report, (uint8_t)WT20_COMMAND_STREAM_REPORT, length);
+    (void)espnow_link_write_async(dest_mac, report, length, NULL, NULL, &handle);
+}
+
+/* only the newest report matters, one the sending task hasn't picked up yet is replaced */
+static void handle_stream_report(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    uint16_t loss_permille;
+
+    if (wt20_vrate_parse_report(&recv_msg->data[WT20_HDR_BYTES], recv_msg->info.data_len - WT20_HDR_BYTES, &loss_permille))
+    {
+        atomic_store_explicit(&voice_report, (uint32_t)loss_permille + 1U, memory_order_release);
+    }
+}
+
+/* esp now only sends to registered peers, broadcast included */
+static WT20_ERR_T register_broadcast(void)
+{
+    if (!broadcast_registered)
+    {
+        broadcast_registered = (espnow_link_register_peer(broadcast_mac) == ESPNOW_LINK_ERR_NONE);
+    }
+
+    return broadcast_registered ? WT20_ERR_NONE : WT20_SEND_FAILURE;
+}
+
+/* group frame or rebroadcast. Gaps are NACKed straight to the talker, so only added peers get repairs */
+static void handle_group_frame(const ESPNOW_LINK_MSG_T* recv_msg, WT20_PEER_ID_T peer_id, bool repair)
+{
+    uint8_t nack[WT20_HDR_BYTES + WT20_GROUP_NACK_BYTES];
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    WT20_GROUP_FRAME_T frame;
+    WT20_GROUP_RESULT_T result;
+    uint16_t length;
+
+    result = wt20_group_rx_accept(&group_rx, recv_msg->info.src_mac, &recv_msg->data[WT20_HDR_BYTES],
+                                  recv_msg->info.data_len - WT20_HDR_BYTES, repair, &frame);
+
+    group_stats.duplicates += (result == WT20_GROUP_DUPLICATE) ? 1U : 0U;
+    group_stats.not_member += (result == WT20_GROUP_NOT_MEMBER) ? 1U : 0U;
+
+    if ((result != WT20_GROUP_NEW) && (result != WT20_GROUP_REPAIRED))
+    {
+        return;
+    }
+
+    group_stats.frames_received++;
+    group_stats.repairs_received += (result == WT20_GROUP_REPAIRED) ? 1U : 0U;
+
+    if (group_callback != NULL)
+    {
+        group_callback(frame.group, recv_msg->info.src_mac, frame.seq, frame.data, frame.length,
+                       result == WT20_GROUP_REPAIRED, group_callback_context);
+    }
+
+    length = (peer_id == WT20_PEER_ID_NONE) ? 0U :
+             wt20_group_rx_build_nack(&group_rx, recv_msg->info.src_mac, frame.group, timing_get_ms(), &nack[WT20_HDR_BYTES]);
+
+    /* never wait here, a lost NACK is sent again with the next frame after the holdoff */
+    if (length > 0U)
+    {
+        length = finish_frame(nack, (uint8_t)WT20_COMMAND_GROUP_NACK, length);
+        group_stats.nacks_sent += (espnow_link_write_async(recv_msg->info.src_mac, nack, length, NULL, NULL, &handle) ==
+                                   ESPNOW_LINK_ERR_NONE) ? 1U : 0U;
+    }
+}
+
+/* talker side. Rebroadcasts whatever the NACK asks for that is still in the history */
+static void handle_group_nack(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    uint8_t* repair;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint16_t length;
+
+    if (!wt20_group_tx_on_nack(&group_tx, &recv_msg->data[WT20_HDR_BYTES], recv_msg->info.data_len - WT20_HDR_BYTES))
+    {
+        return;
+    }
+
+    group_stats.nacks_received++;
+    repair = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    if (repair == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return;
+    }
+
+    while ((length = wt20_group_tx_next_repair(&group_tx, timing_get_ms(), &repair[WT20_HDR_BYTES])) > 0U)
+    {
+        length = finish_frame(repair, (uint8_t)WT20_COMMAND_GROUP_REPAIR, length);
+
+        if (espnow_link_write_async(broadcast_mac, repair, length, NULL, NULL, &handle) != ESPNOW_LINK_ERR_NONE)
+        {
+            break;
+        }
+
+        group_stats.repairs_sent++;
+    }
+
+    mem_pool_free(&frame_pool, repair);
+}
+
+/* broadcasts a frame for dest_mac for relays to pass on. Never waits, nothing acks it anyway */
+static WT20_ERR_T send_relayed(const uint8_t* dest_mac, uint8_t command, const uint8_t* payload, uint16_t payload_length)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    WT20_RELAY_FRAME_T frame = {
+        .seq = (uint16_t)atomic_fetch_add_explicit(&next_relay_seq, 1U, memory_order_relaxed),
+        .hops = WT20_RELAY_MAX_HOPS,
+        .command = command,
+        .data = payload,
+        .length = payload_length
+    };
+    uint8_t* data;
+    uint16_t length;
+    WT20_ERR_T ret = register_broadcast();
+
+    if (ret != WT20_ERR_NONE)
+    {
+        return ret;
+    }
+
+    data = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    if (data == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return WT20_NO_BUFFER;
+    }
+
+    memcpy(frame.origin, device_mac, sizeof(frame.origin));
+    memcpy(frame.dest, dest_mac, sizeof(frame.dest));
+    length = wt20_relay_build(&frame, &data[WT20_HDR_BYTES]);
+    length = finish_frame(data, (uint8_t)WT20_COMMAND_RELAY, length);
+    ret = (espnow_link_write_async(broadcast_mac, data, length, NULL, NULL, &handle) == ESPNOW_LINK_ERR_NONE) ?
+          WT20_ERR_NONE : WT20_SEND_FAILURE;
+    relay_stats.frames_sent += (ret == WT20_ERR_NONE) ? 1U : 0U;
+    mem_pool_free(&frame_pool, data);
+
+    return ret;
+}
+
+/* relayed frame. Queued to go on if relay mode is on and it is someone else's, and unwrapped
+   in place if it is this unit's, so it is handled as if it came straight from its origin.
+   Returns true if it was unwrapped */
+static bool handle_relay_frame(ESPNOW_LINK_MSG_T* recv_msg, WT20_HDR_T* hdr)
+{
+    const uint8_t* payload = &recv_msg->data[WT20_HDR_BYTES];
+    uint16_t length = recv_msg->info.data_len - WT20_HDR_BYTES;
+    WT20_RELAY_FRAME_T frame;
+    bool for_me;
+
+    if (!wt20_relay_parse(payload, length, &frame) || (frame.command == (uint8_t)WT20_COMMAND_RELAY))
+    {
+        return false;
+    }
+
+    /* own frames coming back around, and copies of one already heard from another relay */
+    if ((memcmp(frame.origin, device_mac, sizeof(device_mac)) == 0) || wt20_relay_seen(&relay, frame.origin, frame.seq))
+    {
+        relay_stats.duplicates++;
+        return false;
+    }
+
+    for_me = (memcmp(frame.dest, device_mac, sizeof(device_mac)) == 0);
+
+    if (!for_me && atomic_load_explicit(&relay_enabled, memory_order_relaxed))
+    {
+        if (frame.hops < 2U)
+        {
+            relay_stats.hop_limit++;
+        }
+        else if (!wt20_relay_queue(&relay, payload, length, timing_get_us()))
+        {
+            relay_stats.queue_full++;
+        }
+    }
+
+    if (!for_me && (memcmp(frame.dest, broadcast_mac, sizeof(broadcast_mac)) != 0))
+    {
+        return false;
+    }
+
+    relay_stats.frames_delivered++;
+    memcpy(recv_msg->info.src_mac, frame.origin, sizeof(frame.origin));
+    hdr->type = frame.command;
+    hdr->seq = frame.seq;
+    memmove(&recv_msg->data[WT20_HDR_BYTES], frame.data, frame.length);
+    recv_msg->info.data_len = WT20_HDR_BYTES + frame.length;
+
+    return true;
+}
+
+/* sends the forwards whose backoff is over. Without a buffer they just go out next time */
+static void service_relay(void)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint8_t* frame;
+    uint16_t length;
+
+    if (!wt20_relay_pending(&relay, NULL))
+    {
+        return;
+    }
+
+    frame = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    while ((frame != NULL) && ((length = wt20_relay_next(&relay, timing_get_us(), &frame[WT20_HDR_BYTES])) > 0U))
+    {
+        length = finish_frame(frame, (uint8_t)WT20_COMMAND_RELAY, length);
+        relay_stats.frames_forwarded +=
+            (espnow_link_write_async(broadcast_mac, frame, length, NULL, NULL, &handle) == ESPNOW_LINK_ERR_NONE) ? 1U : 0U;
+    }
+
+    mem_pool_free(&frame_pool, frame);
+}
+
+/* follows a switch, acking it by broadcast so the leader needn't have this unit as a peer.
+   A lost ack just means another announcement, answered the same way */
+static void handle_channel_switch(const ESPNOW_LINK_MSG_T* recv_msg)
+{
+    uint8_t ack[WT20_HDR_BYTES + WT20_CHAN_ACK_BYTES];
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint16_t length;
+
+    if (!wt20_chan_on_announce(&chan, recv_msg->info.src_mac, &recv_msg->data[WT20_HDR_BYTES],
+                               recv_msg->info.data_len - WT20_HDR_BYTES, timing_get_ms()) ||
+        (register_broadcast() != WT20_ERR_NONE))
+    {
+        return;
+    }
+
+    length = wt20_chan_build_ack(&chan, &ack[WT20_HDR_BYTES]);
+    length = finish_frame(ack, (uint8_t)WT20_COMMAND_CHANNEL_ACK, length);
+    (void)espnow_link_write_async(broadcast_mac, ack, length, NULL, NULL, &handle);
+}
+
+static void handle_channel_ack(const ESPNOW_LINK_MSG_T* recv_msg, WT20_PEER_ID_T peer_id)
+{
+    (void)wt20_chan_on_ack(&chan, peer_id, &recv_msg->data[WT20_HDR_BYTES], recv_msg->info.data_len - WT20_HDR_BYTES);
+}
+
+/* starts a requested switch, sends the announcements that are due, and moves the radio once the time comes */
+static void service_channel(void)
+{
+    uint8_t announce[WT20_HDR_BYTES + WT20_CHAN_SWITCH_BYTES];
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    WT20_PEER_ID_T id;
+    uint32_t expected = 0U;
+    uint32_t request;
+    uint16_t length;
+    uint8_t channel;
+
+    request = atomic_exchange_explicit(&chan_request, 0U, memory_order_acquire);
+
+    if (request != 0U)
+    {
+        for (id = 1U; id <= WT20_PEER_MAX; id++)
+        {
+            expected |= (wt20_peer_get(&peers, id) != NULL) ? (1UL << (id - 1U)) : 0U;
+        }
+
+        (void)wt20_chan_start(&chan, (uint8_t)request, next_chan_id++, expected, timing_get_ms());
+    }
+
+    if ((length = wt20_chan_next_announce(&chan, timing_get_ms(), &announce[WT20_HDR_BYTES])) > 0U)
+    {
+        length = finish_frame(announce, (uint8_t)WT20_COMMAND_CHANNEL_SWITCH, length);
+        (void)espnow_link_write_async(broadcast_mac, announce, length, NULL, NULL, &handle);
+    }
+
+    if (wt20_chan_due(&chan, timing_get_ms(), &channel))
+    {
+        (void)espnow_link_set_wifi_channel(channel);
+    }
+}
+
+/* waits for frames, servicing a reliable transfer, forwarding relayed frames and running a
+   channel switch in the meantime */
+static bool wait_for_frames(uint32_t timeout_ms)
+{
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t wait_ms;
+    uint32_t relay_due_us = 0U;
+    uint32_t chan_due_ms = 0U;
+    int32_t relay_wait_us;
+    int32_t chan_wait_ms;
+    bool relay_pending;
+    bool chan_pending;
+
+    if (!atomic_load_explicit(&bulk_active, memory_order_acquire) && !wt20_relay_pending(&relay, NULL) &&
+        (atomic_load_explicit(&chan_request, memory_order_relaxed) == 0U) && !wt20_chan_pending(&chan, NULL))
+    {
+        return espnow_link_messages_available() || espnow_link_wait_for_messages(timeout_ms);
+    }
+
+    start = timing_get_ms();
+
+    for (;;)
+    {
+        service_bulk();
+        service_relay();
+        service_channel();
+        relay_pending = wt20_relay_pending(&relay, &relay_due_us);
+        chan_pending = wt20_chan_pending(&chan, &chan_due_ms);
+
+        if (espnow_link_messages_available())
+        {
+            return true;
+        }
+
+        elapsed = timing_get_ms() - start;
+
+        if ((timeout_ms != WT20_WAIT_FOREVER) && (elapsed >= timeout_ms))
+        {
+            return false;
+        }
+
+        if (!atomic_load_explicit(&bulk_active, memory_order_acquire) && !relay_pending && !chan_pending)
+        {
+            return espnow_link_wait_for_messages((timeout_ms == WT20_WAIT_FOREVER) ? ESPNOW_LINK_WAIT_FOREVER
+                                                                                   : (timeout_ms - elapsed));
+        }
+
+        wait_ms = BULK_SERVICE_MS_D;
+
+        /* wake for the next forward. The link sleeps at least a tick for any wait, so a forward due
+           sooner than that goes out up to a tick late rather than this loop spinning */
+        relay_wait_us = relay_pending ? (int32_t)(relay_due_us - timing_get_us()) : INT32_MAX;
+
+        if (relay_wait_us < (int32_t)(wait_ms * 1000U))
+        {
+            wait_ms = (relay_wait_us > 1000) ? (((uint32_t)relay_wait_us + 999U) / 1000U) : 1U;
+        }
+
+        /* and for the next announcement or the switch itself, again at least a tick on, so the
+           task sleeps between announcements for the whole handshake */
+        chan_wait_ms = chan_pending ? (int32_t)(chan_due_ms - timing_get_ms()) : INT32_MAX;
+
+        if (chan_wait_ms < (int32_t)wait_ms)
+        {
+            wait_ms = (chan_wait_ms > 1) ? (uint32_t)chan_wait_ms : 1U;
+        }
+
+        if ((timeout_ms != WT20_WAIT_FOREVER) && ((timeout_ms - elapsed) < wait_ms))
+        {
+            wait_ms = timeout_ms - elapsed;
+        }
+
+        (void)espnow_link_wait_for_messages(wait_ms);
+    }
+}
+
+/*
+ * reads one message from espnow link and converts it to WT20 format for higher level processing.
+ * Damaged and duplicate frames are dropped, and fragments are consumed here, so only other
+ * commands reach the caller
+ */
+static WT20_ERR_T read_message(const WT20_MSG_T* msg_buffer)
+{
+    WT20_MSG_T* msg = (WT20_MSG_T*)msg_buffer;
+    FRAME_BUFFER_T* buffer = (FRAME_BUFFER_T*)mem_pool_alloc(&frame_pool);
+    ESPNOW_LINK_MSG_T* recv_msg;
+    WT20_HDR_T hdr;
+    WT20_HDR_RESULT_T result;
+    WT20_PEER_ID_T peer_id;
+    WT20_PEER_T* peer;
+    bool fresh;
+    bool relayed;
+
+    if (buffer == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return WT20_NO_BUFFER;
+    }
+
+    recv_msg = &buffer->link;
+
+    do
+    {
+        if (espnow_link_read(recv_msg) != ESPNOW_LINK_ERR_NONE)
+        {
+            mem_pool_free(&frame_pool, buffer);
+            return WT20_NO_DATA_AVAILABLE;
+        }
+
+        rx_stats.frames++;
+        metrics_inc(METRIC_WT20_RX_FRAMES);
+        result = wt20_header_parse(recv_msg->data, recv_msg->info.data_len, &hdr);
+
+        if (result != WT20_HDR_OK)
+        {
+            rx_stats.crc_errors += (result == WT20_HDR_BAD_CRC) ? 1U : 0U;
+            rx_stats.malformed += (result == WT20_HDR_BAD_CRC) ? 0U : 1U;
+            metrics_inc(METRIC_WT20_RX_DROPPED);
+            recv_msg->info.data_len = 0U;
+            continue;
+        }
+
+        /* known peers keep their own window, found by hash instead of a scan of recent senders */
+        peer_id = wt20_peer_find(&peers, recv_msg->info.src_mac);
+        peer = wt20_peer_get(&peers, peer_id);
+
+        if (peer != NULL)
+        {
+            peer->stats.frames_rx++;
+            peer->stats.last_rssi = recv_msg->info.rssi;
+            peer->stats.last_heard_ms = timing_get_ms();
+            fresh = wt20_seq_window_accept(&peer->rx_window, hdr.seq);
+            peer->stats.duplicates += fresh ? 0U : 1U;
+        }
+        else
+        {
+            fresh = wt20_dedup_accept(&dedup, recv_msg->info.src_mac, hdr.seq);
+        }
+
+        if (!fresh)
+        {
+            rx_stats.duplicates++;
+            metrics_inc(METRIC_WT20_RX_DROPPED);
+            recv_msg->info.data_len = 0U;
+            continue;
+        }
+
+        relayed = (hdr.type == WT20_COMMAND_RELAY);
+
+        if (relayed)
+        {
+            if (!handle_relay_frame(recv_msg, &hdr))
+            {
+                recv_msg->info.data_len = 0U;
+                continue;
+            }
+
+            /* from here on it is the origin's frame */
+            peer_id = wt20_peer_find(&peers, recv_msg->info.src_mac);
+        }
+
+        switch (hdr.type)
+        {
+        case WT20_COMMAND_FRAGMENT:
+            (void)handle_fragment(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_BULK_DATA:
+        case WT20_COMMAND_BULK_POLL:
+            handle_bulk_fragment(recv_msg, hdr.type);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_BULK_ACK:
+            handle_bulk_ack(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_STREAM:
+            handle_stream_frame(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_ECHO_REQUEST:
+            handle_echo_request(recv_msg, relayed);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_GROUP_DATA:
+        case WT20_COMMAND_GROUP_REPAIR:
+            handle_group_frame(recv_msg, peer_id, hdr.type == WT20_COMMAND_GROUP_REPAIR);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_GROUP_NACK:
+            handle_group_nack(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_CHANNEL_SWITCH:
+            handle_channel_switch(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_CHANNEL_ACK:
+            handle_channel_ack(recv_msg, peer_id);
+            recv_msg->info.data_len = 0U;
+            break;
+        case WT20_COMMAND_STREAM_REPORT:
+            handle_stream_report(recv_msg);
+            recv_msg->info.data_len = 0U;
+            break;
+        default:
+            break;
+        }
+    } while (recv_msg->info.data_len == 0U);
+
+    memcpy(msg->src_mac, recv_msg->info.src_mac, 6U);
+    msg->peer_id = peer_id;
+    msg->command = hdr.type;
+    msg->seq = hdr.seq;
+    msg->timestamp_ms = hdr.timestamp_ms;
+    msg->rx_us = recv_msg->info.timestamp_us;
+    msg->rssi = recv_msg->info.rssi;
+    msg->length = recv_msg->info.data_len - WT20_HDR_BYTES;
+    memcpy(msg->payload, &recv_msg->data[WT20_HDR_BYTES], msg->length);
+    memset(&msg->payload[msg->length], 0U, WT20_PAYLOAD_BYTES - msg->length);
+
+    mem_pool_free(&frame_pool, buffer);
+
+    return WT20_ERR_NONE;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+WT20_ERR_T wt20_write(const uint8_t* peer_mac,
+                WT20_COMMAND_T command,
+                const uint8_t* payload,
+                uint16_t payload_length)
+{
+    WT20_ERR_T ret;
+    WT20_PEER_T* peer;
+    ESPNOW_LINK_ERR_T link_err;
+    uint8_t* data;
+    uint16_t length;
+
+    if (payload_length > WT20_PAYLOAD_BYTES)
+    {
+        ret = WT20_MESSAGE_TOO_LONG;
+    }
+    else if (initialized)
+    {
+        data = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+        if (data == NULL)
+        {
+            metrics_inc(METRIC_WT20_NO_BUFFER);
+            return WT20_NO_BUFFER;
+        }
+
+        if (payload_length > 0U)
+        {
+            memcpy(&data[WT20_HDR_BYTES], payload, payload_length);
+        }
+
+        length = finish_frame(data, (uint8_t)command, payload_length);
+        link_err = espnow_link_write(peer_mac, data, length);
+        mem_pool_free(&frame_pool, data);
+
+        peer = wt20_peer_get(&peers, wt20_peer_find(&peers, peer_mac));
+
+        if (peer != NULL)
+        {
+            peer->stats.frames_tx++;
+            peer->stats.tx_failures += (link_err == ESPNOW_LINK_ERR_NONE) ? 0U : 1U;
+        }
+
+        ret = (link_err == ESPNOW_LINK_ERR_NONE) ? WT20_ERR_NONE : WT20_SEND_FAILURE;
+    }
+    else
+    {
+        ret = WT20_NOT_INITIALIZED;
+    }
+
+    return ret;
+}
+
+WT20_ERR_T wt20_send_message(const uint8_t* peer_mac, const uint8_t* message, uint32_t length)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    ESPNOW_LINK_TX_HANDLE_T last = ESPNOW_LINK_TX_INVALID_HANDLE;
+    SEND_PROGRESS_T progress;
+    uint8_t* data;
+    uint16_t count;
+    uint16_t index;
+    uint16_t sent = 0U;
+    uint16_t data_length;
+    uint32_t busy_since;
+    uint8_t msg_id;
+    ESPNOW_LINK_ERR_T link_err = ESPNOW_LINK_ERR_NONE;
+
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (length > WT20_FRAG_MAX_MESSAGE_BYTES)
+    {
+        return WT20_MESSAGE_TOO_LONG;
+    }
+
+    data = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    if (data == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return WT20_NO_BUFFER;
+    }
+
+    atomic_init(&progress.done, 0U);
+    atomic_init(&progress.failed, 0U);
+    count = wt20_frag_count(length);
+    msg_id = next_msg_id++;
+
+    /* fragments go to the link as fast as it takes them, their results come back through
+       fragment_sent() */
+    for (index = 0U; (index < count) && (link_err == ESPNOW_LINK_ERR_NONE); index++)
+    {
+        data_length = wt20_frag_build(msg_id, message, length, index, &data[WT20_HDR_BYTES]);
+        data_length = finish_frame(data, (uint8_t)WT20_COMMAND_FRAGMENT, data_length);
+
+        link_err = espnow_link_write_async(peer_mac, data, data_length, fragment_sent, &progress, &handle);
+        busy_since = timing_get_ms();
+
+        /* the pipeline is shared with every other writer, a full one just means waiting a turn */
+        while ((link_err == ESPNOW_LINK_ERR_BUSY) && ((timing_get_ms() - busy_since) < SEND_SLOT_WAIT_MS_D))
+        {
+            (void)espnow_link_wait_tx_slot(SEND_SLOT_WAIT_MS_D - (timing_get_ms() - busy_since));
+            link_err = espnow_link_write_async(peer_mac, data, data_length, fragment_sent, &progress, &handle);
+        }
+
+        if (link_err == ESPNOW_LINK_ERR_NONE)
+        {
+            last = handle;
+            sent++;
+        }
+    }
+
+    /* esp now copied every fragment, only their results are still needed */
+    mem_pool_free(&frame_pool, data);
+
+    /* a fragment that never made it to the radio stops the rest, but those already sent report
+       into progress on this stack, so wait for them all. They complete in send order, so this
+       only ever sleeps on the last one */
+    while (atomic_load_explicit(&progress.done, memory_order_acquire) < sent)
+    {
+        (void)espnow_link_wait_tx(last, ESPNOW_LINK_WAIT_FOREVER);
+    }
+
+    return ((link_err == ESPNOW_LINK_ERR_NONE) && (atomic_load_explicit(&progress.failed, memory_order_relaxed) == 0U))
+               ? WT20_ERR_NONE
+               : WT20_SEND_FAILURE;
+}
+
+WT20_ERR_T wt20_send_message_reliable(const uint8_t* peer_mac,
+                                      const uint8_t* message,
+                                      uint32_t length,
+                                      WT20_TRANSFER_DONE_CB_T done_callback,
+                                      void* context)
+{
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (length > WT20_FRAG_MAX_MESSAGE_BYTES)
+    {
+        return WT20_MESSAGE_TOO_LONG;
+    }
+
+    if (atomic_load_explicit(&bulk_active, memory_order_acquire))
+    {
+        return WT20_TRANSFER_IN_PROGRESS;
+    }
+
+    memcpy(bulk_peer_mac, peer_mac, sizeof(bulk_peer_mac));
+    bulk_done_callback = done_callback;
+    bulk_done_context = context;
+    wt20_bulk_tx_start(&bulk_tx, next_msg_id++, message, length, (uint8_t)WT20_COMMAND_BULK_DATA,
+                       (uint8_t)WT20_COMMAND_BULK_POLL, timing_get_ms());
+
+    /* hand transfer over to the receiving task and get it started */
+    atomic_store_explicit(&bulk_active, true, memory_order_release);
+    espnow_link_wake_reader();
 
-/************************************
- * GLOBAL FUNCTIONS
- ************************************/
-WT20_ERR_T wt20_write(const uint8_t* peer_mac,
-                WT20_COMMAND_T command,
-                const uint8_t* payload,
-                uint16_t payload_length)
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_set_stream_fec(const WT20_FEC_CONFIG_T* config)
+{
+    if (!wt20_fec_encoder_init(&stream_encoder, config))
+    {
+        return WT20_INITIALIZATION_ERR;
+    }
+
+    stream_frame_bytes = config->frame_bytes;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_write_stream(const uint8_t* peer_mac, const uint8_t* frame, uint16_t length)
 {
+    uint8_t* coded;
+    uint16_t coded_length;
     WT20_ERR_T ret;
+    WT20_ERR_T parity_ret;
 
-    if (initialized)
+    if (!initialized)
     {
-        uint8_t data[ESPNOW_DATA_BYTES];
+        return WT20_NOT_INITIALIZED;
+    }
 
-        data[0] = (uint8_t)command;
+    coded = (uint8_t*)mem_pool_alloc(&frame_pool);
 
-        if (payload_length > 0U)
-        {
-            memset((data+1), 0U, ESPNOW_DATA_BYTES-1U);
-            memcpy((data+1), payload, payload_length);
-        }
+    if (coded == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return WT20_NO_BUFFER;
+    }
 
-        espnow_link_write(peer_mac, data, payload_length + 1U);
+    coded_length = wt20_fec_encode(&stream_encoder, frame, length, coded);
 
-        ret = WT20_ERR_NONE;
+    if (coded_length == 0U)
+    {
+        mem_pool_free(&frame_pool, coded);
+        return WT20_MESSAGE_TOO_LONG;
     }
-    else
+
+    ret = wt20_write(peer_mac, WT20_COMMAND_STREAM, coded, coded_length);
+    wt20_vrate_on_send(&voice_rate, ret == WT20_ERR_NONE);
+
+    /* parity goes out right behind the frame that completes its group, even when that frame
+       failed, since parity is what rebuilds it. The group can't close until its parity is out */
+    while ((coded_length = wt20_fec_next_parity(&stream_encoder, coded)) > 0U)
     {
-        ret = WT20_NOT_INITIALIZED;
+        parity_ret = wt20_write(peer_mac, WT20_COMMAND_STREAM, coded, coded_length);
+        ret = (ret == WT20_ERR_NONE) ? parity_ret : ret;
+    }
+
+    mem_pool_free(&frame_pool, coded);
+
+    return ret;
+}
+
+WT20_ERR_T wt20_next_voice_mode(uint32_t queued_frames, ADPCM_MODE_T* mode)
+{
+    uint32_t report;
+    uint16_t frame_bytes;
+    bool group_start;
+
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    report = atomic_exchange_explicit(&voice_report, 0U, memory_order_acquire);
+
+    if (report != 0U)
+    {
+        wt20_vrate_on_report(&voice_rate, (uint16_t)(report - 1U));
+    }
+
+    /* every frame of a group is padded to the same length, so the group is sized for the mode
+       it starts in and the mode may only go down until the next one */
+    group_start = (stream_encoder.next_index == 0U) && (stream_encoder.next_parity == 0U);
+    *mode = wt20_vrate_next(&voice_rate, queued_frames, group_start);
+
+    if (group_start)
+    {
+        frame_bytes = adpcm_block_bytes(*mode, ADPCM_BLOCK_SAMPLES);
+        (void)wt20_fec_encoder_resize(&stream_encoder, (frame_bytes < stream_frame_bytes) ? frame_bytes : stream_frame_bytes);
+    }
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_get_voice_rate_stats(WT20_VRATE_STATS_T* stats, WT20_VRATE_RX_STATS_T* rx_stats)
+{
+    if (stats != NULL)
+    {
+        wt20_vrate_get_stats(&voice_rate, stats);
+    }
+
+    if (rx_stats != NULL)
+    {
+        *rx_stats = voice_rx.stats;
+    }
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_join_group(uint8_t group, bool repair)
+{
+    WT20_ERR_T ret = register_broadcast();
+
+    if (ret == WT20_ERR_NONE)
+    {
+        wt20_group_rx_set_member(&group_rx, group, true, repair);
+    }
+
+    return ret;
+}
+
+WT20_ERR_T wt20_leave_group(uint8_t group)
+{
+    wt20_group_rx_set_member(&group_rx, group, false, false);
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_write_group(uint8_t group, const uint8_t* frame, uint16_t length)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    uint8_t* data;
+    uint16_t data_length;
+    WT20_ERR_T ret;
+
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (length > WT20_GROUP_MAX_FRAME_BYTES)
+    {
+        return WT20_MESSAGE_TOO_LONG;
+    }
+
+    ret = register_broadcast();
+
+    if (ret != WT20_ERR_NONE)
+    {
+        return ret;
+    }
+
+    data = (uint8_t*)mem_pool_alloc(&frame_pool);
+
+    if (data == NULL)
+    {
+        metrics_inc(METRIC_WT20_NO_BUFFER);
+        return WT20_NO_BUFFER;
+    }
+
+    /* kept in the history even if it doesn't go out, so a NACK can still bring it back */
+    data_length = wt20_group_tx_build(&group_tx, group, frame, length, &data[WT20_HDR_BYTES]);
+    data_length = finish_frame(data, (uint8_t)WT20_COMMAND_GROUP_DATA, data_length);
+
+    /* one send reaches every member. Nothing acks a broadcast, so there is nothing to wait for */
+    ret = (espnow_link_write_async(broadcast_mac, data, data_length, NULL, NULL, &handle) == ESPNOW_LINK_ERR_NONE) ?
+          WT20_ERR_NONE : WT20_SEND_FAILURE;
+    group_stats.frames_sent += (ret == WT20_ERR_NONE) ? 1U : 0U;
+    mem_pool_free(&frame_pool, data);
+
+    return ret;
+}
+
+WT20_ERR_T wt20_set_group_callback(WT20_GROUP_CB_T callback, void* context)
+{
+    group_callback = callback;
+    group_callback_context = context;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_get_group_stats(WT20_GROUP_STATS_T* stats)
+{
+    *stats = group_stats;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_set_relay(bool enabled)
+{
+    WT20_ERR_T ret = enabled ? register_broadcast() : WT20_ERR_NONE;
+
+    if (ret == WT20_ERR_NONE)
+    {
+        atomic_store_explicit(&relay_enabled, enabled, memory_order_relaxed);
     }
 
     return ret;
 }
 
+WT20_ERR_T wt20_write_relayed(const uint8_t* dest_mac, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length)
+{
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (payload_length > WT20_RELAY_MAX_PAYLOAD_BYTES)
+    {
+        return WT20_MESSAGE_TOO_LONG;
+    }
+
+    return send_relayed(dest_mac, (uint8_t)command, payload, payload_length);
+}
+
+WT20_ERR_T wt20_get_relay_stats(WT20_RELAY_STATS_T* stats)
+{
+    *stats = relay_stats;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_switch_channel(uint8_t channel)
+{
+    WT20_ERR_T ret;
+
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if ((channel < ESPNOW_LINK_CHAN_FIRST) || (channel > ESPNOW_LINK_CHAN_LAST))
+    {
+        return WT20_CHANNEL_ERR;
+    }
+
+    ret = register_broadcast();
+
+    if (ret != WT20_ERR_NONE)
+    {
+        return ret;
+    }
+
+    /* hand the switch over to the receiving task */
+    atomic_store_explicit(&chan_request, channel, memory_order_release);
+    espnow_link_wake_reader();
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_auto_channel(uint32_t dwell_ms, uint8_t* channel)
+{
+    ESPNOW_LINK_CHAN_SURVEY_T survey;
+    uint8_t current;
+    uint8_t pick;
+
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (espnow_link_scan_channels(dwell_ms, &survey) != ESPNOW_LINK_ERR_NONE)
+    {
+        return WT20_CHANNEL_ERR;
+    }
+
+    current = espnow_link_get_wifi_channel();
+    pick = espnow_link_chan_pick(&survey, current);
+    *channel = pick;
+
+    return (pick == current) ? WT20_ERR_NONE : wt20_switch_channel(pick);
+}
+
+WT20_ERR_T wt20_get_chan_stats(WT20_CHAN_STATS_T* stats)
+{
+    *stats = chan.stats;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_set_stream_callback(WT20_STREAM_CB_T callback, void* context)
+{
+    stream_callback = callback;
+    stream_callback_context = context;
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_set_message_callback(WT20_MESSAGE_CB_T callback, void* context)
+{
+    message_callback = callback;
+    message_callback_context = context;
+
+    return WT20_ERR_NONE;
+}
+
 WT20_ERR_T wt20_protocol_function(const WT20_MSG_T* msg_buffer)
 {
     WT20_ERR_T ret;
-    ESPNOW_LINK_MSG_T recv_msg;
 
     if (initialized)
     {
         if (espnow_link_messages_available())
         {
-            /* get message */
-            espnow_link_read(&recv_msg);
-
-            /* convert to WT20 format for higher level processing */
-            memcpy(&(msg_buffer->src_mac), recv_msg.recv_info.src_addr, 6U);
-            memcpy(&(msg_buffer->command), recv_msg.data, ESPNOW_DATA_BYTES);
-
-            ret = WT20_ERR_NONE;
+            ret = read_message(msg_buffer);
         }
         else
         {
@@ -91,13 +1404,112 @@ WT20_ERR_T wt20_protocol_function(const WT20_MSG_T* msg_buffer)
     return ret;
 }
 
+WT20_ERR_T wt20_receive(const WT20_MSG_T* msg_buffer, uint32_t timeout_ms)
+{
+    if (!initialized)
+    {
+        return WT20_NOT_INITIALIZED;
+    }
+
+    if (!wait_for_frames(timeout_ms))
+    {
+        return WT20_NO_DATA_AVAILABLE;
+    }
+
+    return read_message(msg_buffer);
+}
+
+WT20_ERR_T wt20_receive_all(WT20_MSG_HANDLER_T handler, void* context, uint32_t timeout_ms, uint32_t* processed)
+{
+    FRAME_BUFFER_T* buffer;
+    uint32_t count = 0U;
+    WT20_ERR_T ret;
+
+    if (!initialized)
+    {
+        ret = WT20_NOT_INITIALIZED;
+    }
+    else if (!wait_for_frames(timeout_ms))
+    {
+        ret = WT20_NO_DATA_AVAILABLE;
+    }
+    else
+    {
+        buffer = (FRAME_BUFFER_T*)mem_pool_alloc(&frame_pool);
+        ret = (buffer != NULL) ? WT20_ERR_NONE : WT20_NO_BUFFER;
+
+        if (buffer == NULL)
+        {
+            metrics_inc(METRIC_WT20_NO_BUFFER);
+        }
+
+        /* drain everything that is pending, so one wakeup handles a whole burst */
+        while ((buffer != NULL) && (read_message(&buffer->msg) == WT20_ERR_NONE))
+        {
+            handler(&buffer->msg, context);
+            count++;
+        }
+
+        mem_pool_free(&frame_pool, buffer);
+    }
+
+    if (processed != NULL)
+    {
+        *processed = count;
+    }
+
+    return ret;
+}
+
 WT20_ERR_T wt20_init(void)
 {
     initialized = true;
+    (void)mem_pool_init(&frame_pool, "wt20_frame", frame_pool_storage, sizeof(FRAME_BUFFER_T), WT20_FRAME_POOL_BLOCKS);
+    wt20_frag_reassembly_init(&reassembler);
+    wt20_peer_table_init(&peers);
+    wt20_dedup_init(&dedup);
+    wt20_group_tx_init(&group_tx);
+    wt20_group_rx_init(&group_rx);
+    memset(&group_stats, 0, sizeof(group_stats));
+    broadcast_registered = false;
+    memset(&rx_stats, 0, sizeof(rx_stats));
+    atomic_store(&bulk_active, false);
+
+    WT20_FEC_CONFIG_T fec_config = {
+        .k = FEC_DATA_FRAMES_D,
+        .m = FEC_PARITY_FRAMES_D,
+        .frame_bytes = WT20_FEC_MAX_FRAME_BYTES
+    };
+    (void)wt20_fec_encoder_init(&stream_encoder, &fec_config);
+    (void)wt20_fec_decoder_init(&stream_decoder, &fec_config, stream_frame_ready, NULL);
+    stream_frame_bytes = fec_config.frame_bytes;
+    stream_lost = 0U;
+    wt20_vrate_init(&voice_rate);
+    wt20_vrate_rx_init(&voice_rx);
+    voice_report_due = false;
+    atomic_store(&voice_report, 0U);
 
     ESPNOW_LINK_ERR_T esp_err;
     esp_err = espnow_link_init();
 
+    /* relayed frames name their origin and destination by mac, and the mac seeds the backoff
+       so relays that heard the same frame pick different ones */
+    memset(device_mac, 0, sizeof(device_mac));
+    (void)espnow_link_get_device_mac(device_mac);
+    wt20_relay_init(&relay, ((uint32_t)device_mac[2] << 24U) | ((uint32_t)device_mac[3] << 16U) |
+                            ((uint32_t)device_mac[4] << 8U) | (uint32_t)device_mac[5]);
+    memset(&relay_stats, 0, sizeof(relay_stats));
+    atomic_store(&relay_enabled, false);
+
+    /* a unit that restarts picks up at some other count, so caches that still hold its last
+       frames don't take its new ones for copies */
+    atomic_store(&next_relay_seq, timing_get_us());
+
+    /* conflicting switches are settled by mac, and the id keeps a restarted unit's acks apart */
+    wt20_chan_init(&chan, device_mac);
+    atomic_store(&chan_request, 0U);
+    next_chan_id = (uint16_t)timing_get_us();
+
     return (esp_err == ESPNOW_LINK_ERR_NONE) ? WT20_ERR_NONE : WT20_INITIALIZATION_ERR;
 }
 
@@ -117,6 +1529,13 @@ WT20_ERR_T wt20_deinit(void)
     return ret;
 }
 
+WT20_ERR_T wt20_get_rx_stats(WT20_RX_STATS_T* stats)
+{
+    *stats = rx_stats;
+
+    return WT20_ERR_NONE;
+}
+
 WT20_ERR_T wt20_get_device_mac(const uint8_t* buffer)
 {
     
@@ -127,7 +1546,82 @@ WT20_ERR_T wt20_get_device_mac(const uint8_t* buffer)
 
 WT20_ERR_T wt20_add_contact(const uint8_t* mac)
 {
-    espnow_link_register_peer(mac);
+    return wt20_add_peer(mac, NULL);
+}
+
+WT20_ERR_T wt20_add_peer(const uint8_t* mac, WT20_PEER_ID_T* id)
+{
+    WT20_PEER_ID_T new_id = wt20_peer_find(&peers, mac);
+
+    if (new_id == WT20_PEER_ID_NONE)
+    {
+        new_id = wt20_peer_add(&peers, mac);
+
+        if (new_id == WT20_PEER_ID_NONE)
+        {
+            return WT20_PEER_TABLE_FULL;
+        }
+
+        /* esp now has room for fewer peers than the table once broadcast is in. A peer it won't
+           take couldn't be sent to, so isn't added */
+        if (espnow_link_register_peer(mac) != ESPNOW_LINK_ERR_NONE)
+        {
+            (void)wt20_peer_remove(&peers, new_id);
+            return WT20_PEER_TABLE_FULL;
+        }
+    }
+
+    if (id != NULL)
+    {
+        *id = new_id;
+    }
+
+    return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_remove_peer(WT20_PEER_ID_T id)
+{
+    WT20_PEER_T* peer = wt20_peer_get(&peers, id);
+
+    if (peer == NULL)
+    {
+        return WT20_UNKNOWN_PEER;
+    }
+
+    /* frees its slot in esp now too, so adding and removing peers never fills esp now's list */
+    (void)espnow_link_unregister_peer(peer->mac);
+    (void)wt20_peer_remove(&peers, id);
+
+    return WT20_ERR_NONE;
+}
+
+WT20_PEER_ID_T wt20_find_peer(const uint8_t* mac)
+{
+    return wt20_peer_find(&peers, mac);
+}
+
+WT20_ERR_T wt20_get_peer(WT20_PEER_ID_T id, WT20_PEER_T* peer)
+{
+    const WT20_PEER_T* entry = wt20_peer_get(&peers, id);
+
+    if (entry == NULL)
+    {
+        return WT20_UNKNOWN_PEER;
+    }
+
+    *peer = *entry;
 
     return WT20_ERR_NONE;
+}
+
+WT20_ERR_T wt20_write_peer(WT20_PEER_ID_T id, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length)
+{
+    const WT20_PEER_T* peer = wt20_peer_get(&peers, id);
+
+    if (peer == NULL)
+    {
+        return WT20_UNKNOWN_PEER;
+    }
+
+    return wt20_write(peer->mac, command, payload, payload_length);
 }
\ No newline at end of file
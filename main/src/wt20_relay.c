@@ -0,0 +1,211 @@
+/**
+ ********************************************************************************
+ * @file    wt20_relay.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Multi-hop relay with a duplicate suppressing seen cache
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_relay.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+
+/* 2^32 / golden ratio, spreads an origin's consecutive frames across the sets */
+#define HASH_MULTIPLIER_D (0x9E3779B1U)
+
+#define ORIGIN_OFFSET_D (0U)
+#define DEST_OFFSET_D (6U)
+#define SEQ_OFFSET_D (12U)
+#define HOPS_OFFSET_D (14U)
+#define COMMAND_OFFSET_D (15U)
+
+_Static_assert(WT20_RELAY_HDR_BYTES == (COMMAND_OFFSET_D + 1U), "relay header layout");
+_Static_assert((WT20_RELAY_MAX_HOPS > 0U) && (WT20_RELAY_MAX_HOPS < 256U), "hops left must fit in a byte");
+_Static_assert(WT20_RELAY_CACHE_WAYS < 256U, "next way must fit in a byte");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t cache_set(const uint8_t* origin, uint16_t seq);
+static uint32_t backoff_us(WT20_RELAY_T* relay);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* vendor bytes are shared by most units, so every byte goes in */
+static uint32_t cache_set(const uint8_t* origin, uint16_t seq)
+{
+    uint32_t key = ((uint32_t)origin[2] << 24U) | ((uint32_t)origin[3] << 16U) | ((uint32_t)origin[4] << 8U) | (uint32_t)origin[5];
+
+    key ^= ((uint32_t)origin[0] << 8U) | (uint32_t)origin[1];
+    key += seq;
+
+    return (uint32_t)(key * HASH_MULTIPLIER_D) >> (32U - WT20_RELAY_CACHE_BITS);
+}
+
+/* xorshift32, uniform from 0 to WT20_RELAY_JITTER_US */
+static uint32_t backoff_us(WT20_RELAY_T* relay)
+{
+    uint32_t x = relay->random;
+
+    x ^= x << 13U;
+    x ^= x >> 17U;
+    x ^= x << 5U;
+    relay->random = x;
+
+    return x % (WT20_RELAY_JITTER_US + 1U);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_relay_init(WT20_RELAY_T* relay, uint32_t seed)
+{
+    memset(relay, 0, sizeof(*relay));
+
+    /* xorshift never leaves 0 */
+    relay->random = (seed != 0U) ? seed : HASH_MULTIPLIER_D;
+}
+
+uint16_t wt20_relay_build(const WT20_RELAY_FRAME_T* frame, uint8_t* payload)
+{
+    if (frame->length > WT20_RELAY_MAX_PAYLOAD_BYTES)
+    {
+        return 0U;
+    }
+
+    memcpy(&payload[ORIGIN_OFFSET_D], frame->origin, WT20_RELAY_MAC_BYTES);
+    memcpy(&payload[DEST_OFFSET_D], frame->dest, WT20_RELAY_MAC_BYTES);
+    payload[SEQ_OFFSET_D] = (uint8_t)(frame->seq & 0xFFU);
+    payload[SEQ_OFFSET_D + 1U] = (uint8_t)(frame->seq >> 8U);
+    payload[HOPS_OFFSET_D] = frame->hops;
+    payload[COMMAND_OFFSET_D] = frame->command;
+
+    if (frame->length > 0U)
+    {
+        memcpy(&payload[WT20_RELAY_HDR_BYTES], frame->data, frame->length);
+    }
+
+    return (uint16_t)(WT20_RELAY_HDR_BYTES + frame->length);
+}
+
+bool wt20_relay_parse(const uint8_t* payload, uint16_t length, WT20_RELAY_FRAME_T* frame)
+{
+    if ((length < WT20_RELAY_HDR_BYTES) || (length > WT20_PAYLOAD_BYTES) || (payload[HOPS_OFFSET_D] == 0U))
+    {
+        return false;
+    }
+
+    memcpy(frame->origin, &payload[ORIGIN_OFFSET_D], WT20_RELAY_MAC_BYTES);
+    memcpy(frame->dest, &payload[DEST_OFFSET_D], WT20_RELAY_MAC_BYTES);
+    frame->seq = (uint16_t)payload[SEQ_OFFSET_D] | (uint16_t)((uint16_t)payload[SEQ_OFFSET_D + 1U] << 8U);
+    frame->hops = payload[HOPS_OFFSET_D];
+    frame->command = payload[COMMAND_OFFSET_D];
+    frame->data = &payload[WT20_RELAY_HDR_BYTES];
+    frame->length = length - WT20_RELAY_HDR_BYTES;
+
+    return true;
+}
+
+bool wt20_relay_seen(WT20_RELAY_T* relay, const uint8_t* origin, uint16_t seq)
+{
+    uint32_t set = cache_set(origin, seq);
+    WT20_RELAY_SEEN_T* entry;
+    uint32_t way;
+
+    for (way = 0U; way < WT20_RELAY_CACHE_WAYS; way++)
+    {
+        entry = &relay->seen[set][way];
+
+        if (entry->used && (entry->seq == seq) && (memcmp(entry->origin, origin, WT20_RELAY_MAC_BYTES) == 0))
+        {
+            return true;
+        }
+    }
+
+    entry = &relay->seen[set][relay->next_way[set]];
+    relay->next_way[set] = (uint8_t)((relay->next_way[set] + 1U) % WT20_RELAY_CACHE_WAYS);
+    memcpy(entry->origin, origin, WT20_RELAY_MAC_BYTES);
+    entry->seq = seq;
+    entry->used = true;
+
+    return false;
+}
+
+bool wt20_relay_queue(WT20_RELAY_T* relay, const uint8_t* payload, uint16_t length, uint32_t now_us)
+{
+    WT20_RELAY_SLOT_T* slot;
+    uint32_t i;
+
+    if ((length < WT20_RELAY_HDR_BYTES) || (length > WT20_PAYLOAD_BYTES) || (payload[HOPS_OFFSET_D] < 2U))
+    {
+        return false;
+    }
+
+    for (i = 0U; i < WT20_RELAY_QUEUE; i++)
+    {
+        slot = &relay->queue[i];
+
+        if (!slot->used)
+        {
+            memcpy(slot->payload, payload, length);
+            slot->payload[HOPS_OFFSET_D]--;
+            slot->length = length;
+            slot->due_us = now_us + backoff_us(relay);
+            slot->used = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint16_t wt20_relay_next(WT20_RELAY_T* relay, uint32_t now_us, uint8_t* payload)
+{
+    WT20_RELAY_SLOT_T* slot;
+    uint32_t i;
+
+    for (i = 0U; i < WT20_RELAY_QUEUE; i++)
+    {
+        slot = &relay->queue[i];
+
+        /* due_us - now_us wraps past half the range once due */
+        if (slot->used && ((int32_t)(slot->due_us - now_us) <= 0))
+        {
+            memcpy(payload, slot->payload, slot->length);
+            slot->used = false;
+            return slot->length;
+        }
+    }
+
+    return 0U;
+}
+
+bool wt20_relay_pending(const WT20_RELAY_T* relay, uint32_t* due_us)
+{
+    const WT20_RELAY_SLOT_T* first = NULL;
+    uint32_t i;
+
+    for (i = 0U; i < WT20_RELAY_QUEUE; i++)
+    {
+        if (relay->queue[i].used && ((first == NULL) || ((int32_t)(relay->queue[i].due_us - first->due_us) < 0)))
+        {
+            first = &relay->queue[i];
+        }
+    }
+
+    if ((first != NULL) && (due_us != NULL))
+    {
+        *due_us = first->due_us;
+    }
+
+    return first != NULL;
+}
@@ -0,0 +1,200 @@
+/**
+ ********************************************************************************
+ * @file    wt20_vrate.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Voice bitrate control, talker and listener sides
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "wt20_vrate.h"
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define LOSS_OFFSET_D (0U)
+#define FRAMES_OFFSET_D (2U)
+
+/* send failures are averaged over about 16 frames, so one failure alone stays under the threshold */
+#define FAIL_SHIFT_D (4U)
+
+#define LOWEST_MODE_D ((ADPCM_MODE_T)(ADPCM_MODES - 1))
+
+_Static_assert(((1000U >> FAIL_SHIFT_D) < WT20_VRATE_DOWN_FAIL_PERMILLE), "a single failed send must not drop a mode");
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static void put_u16(uint8_t* out, uint16_t value);
+static uint16_t get_u16(const uint8_t* in);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static void put_u16(uint8_t* out, uint16_t value)
+{
+    out[0] = (uint8_t)(value & 0xFFU);
+    out[1] = (uint8_t)(value >> 8U);
+}
+
+static uint16_t get_u16(const uint8_t* in)
+{
+    return (uint16_t)in[0] | (uint16_t)((uint16_t)in[1] << 8U);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void wt20_vrate_init(WT20_VRATE_T* ctl)
+{
+    memset(ctl, 0, sizeof(*ctl));
+    ctl->mode = ADPCM_MODE_16K;
+    ctl->backoff = 1U;
+    ctl->stats.mode = ADPCM_MODE_16K;
+}
+
+void wt20_vrate_on_send(WT20_VRATE_T* ctl, bool sent)
+{
+    ctl->fail_permille = (uint16_t)(ctl->fail_permille - (ctl->fail_permille >> FAIL_SHIFT_D) +
+                                    (sent ? 0U : (1000U >> FAIL_SHIFT_D)));
+    ctl->stats.fail_permille = ctl->fail_permille;
+}
+
+void wt20_vrate_on_report(WT20_VRATE_T* ctl, uint16_t loss_permille)
+{
+    ctl->loss_permille = loss_permille;
+    ctl->report_pending = true;
+    ctl->stats.loss_permille = loss_permille;
+    ctl->stats.reports++;
+}
+
+ADPCM_MODE_T wt20_vrate_next(WT20_VRATE_T* ctl, uint32_t queued_frames, bool may_raise)
+{
+    bool reported_loss = ctl->report_pending && (ctl->loss_permille > WT20_VRATE_DOWN_LOSS_PERMILLE);
+    bool reported_some = ctl->report_pending && (ctl->loss_permille > (WT20_VRATE_DOWN_LOSS_PERMILLE / 2U));
+    bool trouble = (ctl->fail_permille > WT20_VRATE_DOWN_FAIL_PERMILLE) || reported_loss ||
+                   (queued_frames >= WT20_VRATE_QUEUE_FRAMES);
+
+    ctl->report_pending = false;
+    ctl->hold = (ctl->hold > 0U) ? (ctl->hold - 1U) : 0U;
+
+    /* a mode up that lasted. The next one needn't wait as long */
+    if (ctl->on_trial && (++ctl->since_up >= WT20_VRATE_RAISE_FRAMES))
+    {
+        ctl->on_trial = false;
+        ctl->backoff = (ctl->backoff > 1U) ? (ctl->backoff / 2U) : 1U;
+    }
+
+    if (trouble)
+    {
+        ctl->clean = 0U;
+
+        if ((ctl->hold == 0U) && (ctl->mode != LOWEST_MODE_D))
+        {
+            ctl->mode = (queued_frames >= WT20_VRATE_QUEUE_SEVERE_FRAMES) ? LOWEST_MODE_D : (ADPCM_MODE_T)(ctl->mode + 1);
+            ctl->hold = WT20_VRATE_HOLD_FRAMES;
+            ctl->fail_permille = 0U; /* failures from here on are the ones at the new mode */
+            ctl->stats.downs++;
+
+            /* the last mode up didn't last, wait longer before the next */
+            if (ctl->on_trial)
+            {
+                ctl->on_trial = false;
+                ctl->backoff = (ctl->backoff < WT20_VRATE_MAX_BACKOFF) ? (ctl->backoff * 2U) : WT20_VRATE_MAX_BACKOFF;
+            }
+        }
+    }
+    else
+    {
+        /* close to the thresholds isn't trouble, but isn't clean either */
+        ctl->clean = ((queued_frames == 0U) && (ctl->fail_permille <= (WT20_VRATE_DOWN_FAIL_PERMILLE / 2U)) && !reported_some)
+                         ? (ctl->clean + 1U)
+                         : 0U;
+
+        if (may_raise && (ctl->mode != ADPCM_MODE_16K) && (ctl->clean >= (WT20_VRATE_RAISE_FRAMES * ctl->backoff)))
+        {
+            ctl->mode = (ADPCM_MODE_T)(ctl->mode - 1);
+            ctl->clean = 0U;
+            ctl->on_trial = true;
+            ctl->since_up = 0U;
+            ctl->stats.ups++;
+        }
+    }
+
+    ctl->stats.mode = ctl->mode;
+    ctl->stats.frames[ctl->mode]++;
+    ctl->stats.fail_permille = ctl->fail_permille;
+
+    return ctl->mode;
+}
+
+void wt20_vrate_get_stats(const WT20_VRATE_T* ctl, WT20_VRATE_STATS_T* stats)
+{
+    *stats = ctl->stats;
+}
+
+void wt20_vrate_rx_init(WT20_VRATE_RX_T* rx)
+{
+    memset(rx, 0, sizeof(*rx));
+}
+
+void wt20_vrate_rx_on_lost(WT20_VRATE_RX_T* rx, uint32_t count)
+{
+    rx->stats.lost += count;
+    count = (count > (0xFFFFU - rx->frames)) ? (0xFFFFU - rx->frames) : count;
+    rx->frames = (uint16_t)(rx->frames + count);
+    rx->missed = (uint16_t)(rx->missed + count);
+}
+
+bool wt20_vrate_rx_on_frame(WT20_VRATE_RX_T* rx, bool recovered)
+{
+    rx->stats.delivered++;
+    rx->stats.recovered += recovered ? 1U : 0U;
+
+    if (rx->frames < 0xFFFFU)
+    {
+        rx->frames++;
+        rx->missed = (uint16_t)(rx->missed + (recovered ? 1U : 0U));
+    }
+
+    return rx->frames >= WT20_VRATE_REPORT_FRAMES;
+}
+
+uint16_t wt20_vrate_rx_build_report(WT20_VRATE_RX_T* rx, uint8_t* payload)
+{
+    uint16_t loss_permille = (rx->frames > 0U) ? (uint16_t)(((uint32_t)rx->missed * 1000U) / rx->frames) : 0U;
+
+    put_u16(&payload[LOSS_OFFSET_D], loss_permille);
+    put_u16(&payload[FRAMES_OFFSET_D], rx->frames);
+    rx->frames = 0U;
+    rx->missed = 0U;
+    rx->stats.reports++;
+
+    return WT20_VRATE_REPORT_BYTES;
+}
+
+bool wt20_vrate_parse_report(const uint8_t* payload, uint16_t length, uint16_t* loss_permille)
+{
+    uint16_t loss;
+
+    if (length < WT20_VRATE_REPORT_BYTES)
+    {
+        return false;
+    }
+
+    loss = get_u16(&payload[LOSS_OFFSET_D]);
+
+    /* a report of no frames says nothing */
+    if ((loss > 1000U) || (get_u16(&payload[FRAMES_OFFSET_D]) == 0U))
+    {
+        return false;
+    }
+
+    *loss_permille = loss;
+
+    return true;
+}
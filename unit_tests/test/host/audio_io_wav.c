@@ -0,0 +1,376 @@
+/**
+ ********************************************************************************
+ * @file    audio_io_wav.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   audio_io off target, backed by WAV files
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "audio_io_wav.h"
+#include <stdio.h>
+#include <string.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define WAV_HEADER_BYTES_D (44U)
+#define WAV_FORMAT_PCM_D (1U)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static AUDIO_FRAME_POOL_T pool;
+static AUDIO_FRAME_QUEUE_T capture_queue;
+static AUDIO_FRAME_QUEUE_T playback_queue;
+
+static FILE* capture_file = NULL;
+static FILE* playback_file = NULL;
+static uint32_t capture_bytes_left = 0U;
+static uint32_t playback_bytes = 0U;
+
+static bool running = false;
+static bool playing = false;
+static uint32_t capture_seq = 0U;
+static AUDIO_IO_STATS_T stats;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t read_le(const uint8_t* bytes, uint32_t count);
+static void write_le(uint8_t* bytes, uint32_t value, uint32_t count);
+static bool open_capture(const char* path);
+static void write_header(void);
+static void capture_frame(void);
+static void play_frame(void);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+static uint32_t read_le(const uint8_t* bytes, uint32_t count)
+{
+    uint32_t value = 0U;
+
+    while (count > 0U)
+    {
+        count--;
+        value = (value << 8U) | bytes[count];
+    }
+
+    return value;
+}
+
+static void write_le(uint8_t* bytes, uint32_t value, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        bytes[i] = (uint8_t)(value >> (8U * i));
+    }
+}
+
+/* walks chunks to the data chunk, checking fmt on the way */
+static bool open_capture(const char* path)
+{
+    uint8_t header[12U];
+    uint8_t chunk[8U];
+    uint8_t format[16U];
+    bool format_ok = false;
+    uint32_t chunk_bytes;
+
+    capture_file = fopen(path, "rb");
+
+    if ((capture_file == NULL) || (fread(header, 1U, sizeof(header), capture_file) != sizeof(header)) ||
+        (memcmp(header, "RIFF", 4U) != 0) || (memcmp(&header[8], "WAVE", 4U) != 0))
+    {
+        return false;
+    }
+
+    while (fread(chunk, 1U, sizeof(chunk), capture_file) == sizeof(chunk))
+    {
+        chunk_bytes = read_le(&chunk[4], 4U);
+
+        if (memcmp(chunk, "data", 4U) == 0)
+        {
+            capture_bytes_left = chunk_bytes;
+            return format_ok;
+        }
+
+        if ((memcmp(chunk, "fmt ", 4U) == 0) && (chunk_bytes >= sizeof(format)))
+        {
+            if (fread(format, 1U, sizeof(format), capture_file) != sizeof(format))
+            {
+                return false;
+            }
+
+            format_ok = (read_le(&format[0], 2U) == WAV_FORMAT_PCM_D) && (read_le(&format[2], 2U) == 1U) &&
+                        (read_le(&format[4], 4U) == AUDIO_SAMPLE_RATE_HZ) && (read_le(&format[14], 2U) == 16U);
+            chunk_bytes -= sizeof(format);
+        }
+
+        /* chunks are padded to an even length */
+        if (fseek(capture_file, (long)(chunk_bytes + (chunk_bytes & 1U)), SEEK_CUR) != 0)
+        {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+/* 16 bit mono PCM. Sizes are filled in again on close */
+static void write_header(void)
+{
+    uint8_t header[WAV_HEADER_BYTES_D];
+
+    memcpy(&header[0], "RIFF", 4U);
+    write_le(&header[4], 36U + playback_bytes, 4U);
+    memcpy(&header[8], "WAVEfmt ", 8U);
+    write_le(&header[16], 16U, 4U);
+    write_le(&header[20], WAV_FORMAT_PCM_D, 2U);
+    write_le(&header[22], 1U, 2U);
+    write_le(&header[24], AUDIO_SAMPLE_RATE_HZ, 4U);
+    write_le(&header[28], AUDIO_SAMPLE_RATE_HZ * sizeof(int16_t), 4U);
+    write_le(&header[32], sizeof(int16_t), 2U);
+    write_le(&header[34], 16U, 2U);
+    memcpy(&header[36], "data", 4U);
+    write_le(&header[40], playback_bytes, 4U);
+
+    fseek(playback_file, 0L, SEEK_SET);
+    fwrite(header, 1U, sizeof(header), playback_file);
+    fseek(playback_file, 0L, SEEK_END);
+}
+
+static void capture_frame(void)
+{
+    uint8_t bytes[AUDIO_FRAME_BYTES];
+    uint32_t wanted = (capture_bytes_left < AUDIO_FRAME_BYTES) ? capture_bytes_left : AUDIO_FRAME_BYTES;
+    uint32_t got;
+    uint32_t i;
+    AUDIO_FRAME_T* frame;
+
+    if ((capture_file == NULL) || (capture_bytes_left == 0U))
+    {
+        return;
+    }
+
+    got = (uint32_t)fread(bytes, 1U, wanted, capture_file);
+    capture_bytes_left = (got == wanted) ? (capture_bytes_left - got) : 0U;
+    memset(&bytes[got], 0, AUDIO_FRAME_BYTES - got);
+
+    frame = audio_frame_pool_alloc(&pool);
+
+    if (frame == NULL)
+    {
+        stats.capture_overruns++;
+        return;
+    }
+
+    for (i = 0U; i < AUDIO_FRAME_SAMPLES; i++)
+    {
+        frame->pcm[i] = (int16_t)read_le(&bytes[2U * i], 2U);
+    }
+
+    frame->seq = capture_seq;
+    frame->timestamp_us = capture_seq * AUDIO_FRAME_PERIOD_US;
+    capture_seq++;
+
+    if (!audio_frame_queue_push(&capture_queue, frame))
+    {
+        audio_frame_pool_free(&pool, frame);
+        stats.capture_overruns++;
+        return;
+    }
+
+    stats.frames_captured++;
+}
+
+/* like the codec, output keeps running and gets silence while nothing is queued */
+static void play_frame(void)
+{
+    uint8_t bytes[AUDIO_FRAME_BYTES];
+    AUDIO_FRAME_T* frame = audio_frame_queue_pop(&playback_queue);
+    uint32_t i;
+
+    memset(bytes, 0, sizeof(bytes));
+
+    if (frame == NULL)
+    {
+        if (playing)
+        {
+            stats.playback_underruns++;
+            playing = false;
+        }
+    }
+    else
+    {
+        for (i = 0U; i < AUDIO_FRAME_SAMPLES; i++)
+        {
+            write_le(&bytes[2U * i], (uint16_t)frame->pcm[i], 2U);
+        }
+
+        audio_frame_pool_free(&pool, frame);
+        stats.frames_played++;
+        playing = true;
+    }
+
+    if (playback_file != NULL)
+    {
+        fwrite(bytes, 1U, sizeof(bytes), playback_file);
+        playback_bytes += sizeof(bytes);
+    }
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool audio_io_wav_open(const char* capture_path, const char* playback_path)
+{
+    if ((capture_path != NULL) && !open_capture(capture_path))
+    {
+        audio_io_wav_close();
+        return false;
+    }
+
+    if (playback_path != NULL)
+    {
+        playback_file = fopen(playback_path, "wb");
+
+        if (playback_file == NULL)
+        {
+            audio_io_wav_close();
+            return false;
+        }
+
+        playback_bytes = 0U;
+        write_header();
+    }
+
+    return true;
+}
+
+void audio_io_wav_tick(void)
+{
+    if (!running)
+    {
+        return;
+    }
+
+    capture_frame();
+    play_frame();
+}
+
+bool audio_io_wav_capture_done(void)
+{
+    return (capture_file == NULL) || (capture_bytes_left == 0U);
+}
+
+void audio_io_wav_close(void)
+{
+    while (running && (audio_frame_queue_count(&playback_queue) > 0U))
+    {
+        play_frame();
+    }
+
+    if (capture_file != NULL)
+    {
+        fclose(capture_file);
+        capture_file = NULL;
+    }
+
+    if (playback_file != NULL)
+    {
+        write_header();
+        fclose(playback_file);
+        playback_file = NULL;
+    }
+
+    capture_bytes_left = 0U;
+}
+
+AUDIO_IO_ERR_T audio_io_init(void)
+{
+    audio_frame_pool_init(&pool);
+    audio_frame_queue_init(&capture_queue);
+    audio_frame_queue_init(&playback_queue);
+    memset(&stats, 0, sizeof(stats));
+    running = false;
+    playing = false;
+
+    return AUDIO_IO_OK;
+}
+
+AUDIO_IO_ERR_T audio_io_start(void)
+{
+    capture_seq = 0U;
+    running = true;
+
+    return AUDIO_IO_OK;
+}
+
+void audio_io_stop(void)
+{
+    AUDIO_FRAME_T* frame;
+
+    while ((frame = audio_frame_queue_pop(&playback_queue)) != NULL)
+    {
+        audio_frame_pool_free(&pool, frame);
+    }
+
+    running = false;
+    playing = false;
+}
+
+/* waiting for a frame is the same as letting frame periods go by */
+AUDIO_FRAME_T* audio_io_capture_get(uint32_t timeout_ms)
+{
+    if (running && (audio_frame_queue_count(&capture_queue) == 0U) && !audio_io_wav_capture_done())
+    {
+        audio_io_wav_tick();
+    }
+
+    return audio_frame_queue_pop(&capture_queue);
+}
+
+AUDIO_FRAME_T* audio_io_frame_alloc(void)
+{
+    return audio_frame_pool_alloc(&pool);
+}
+
+AUDIO_IO_ERR_T audio_io_play(AUDIO_FRAME_T* frame)
+{
+    if (!running)
+    {
+        audio_frame_pool_free(&pool, frame);
+        return AUDIO_IO_ERR_NOT_STARTED;
+    }
+
+    if (!audio_frame_queue_push(&playback_queue, frame))
+    {
+        audio_frame_pool_free(&pool, frame);
+        return AUDIO_IO_ERR_FULL;
+    }
+
+    return AUDIO_IO_OK;
+}
+
+void audio_io_frame_release(AUDIO_FRAME_T* frame)
+{
+    audio_frame_pool_free(&pool, frame);
+}
+
+uint32_t audio_io_playback_queued(void)
+{
+    return audio_frame_queue_count(&playback_queue);
+}
+
+void audio_io_get_stats(AUDIO_IO_STATS_T* stats_out)
+{
+    *stats_out = stats;
+    stats_out->pool_high_water = atomic_load_explicit(&pool.blocks.high_water, memory_order_relaxed);
+    stats_out->pool_alloc_failures = atomic_load_explicit(&pool.blocks.alloc_failures, memory_order_relaxed);
+}
@@ -0,0 +1,60 @@
+/**
+ ********************************************************************************
+ * @file    audio_io_wav.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   audio_io off target. Capture reads a WAV file and playback writes one, one frame
+ *          per simulated frame period, so audio code can be tested without a codec
+ ********************************************************************************
+ */
+
+#ifndef AUDIO_IO_WAV_H
+#define AUDIO_IO_WAV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "audio_io.h"
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief opens files used by audio_io. Call after audio_io_init()
+ *
+ * \param capture_path 16 bit mono WAV at AUDIO_SAMPLE_RATE_HZ, NULL captures nothing
+ * \param playback_path WAV written with everything played, NULL discards playback
+ *
+ * \return false if a file can't be opened or capture file has the wrong format
+ */
+bool audio_io_wav_open(const char* capture_path, const char* playback_path);
+
+/**
+ * \brief runs one frame period. Next frame of capture file is queued for audio_io_capture_get()
+ *        and one queued playback frame, or silence, is written. audio_io_capture_get() runs
+ *        this itself while no captured frame is waiting
+ */
+void audio_io_wav_tick(void);
+
+/**
+ * \brief returns true once every sample of capture file has been captured
+ */
+bool audio_io_wav_capture_done(void);
+
+/**
+ * \brief writes out queued playback, finishes playback file and closes both files
+ */
+void audio_io_wav_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
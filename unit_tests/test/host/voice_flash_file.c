@@ -0,0 +1,210 @@
+/**
+ ********************************************************************************
+ * @file    voice_flash_file.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   voice_flash off target, backed by a memory mapped file
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "voice_flash_file.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define PATH_BYTES_D (256U)
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static char file_path[PATH_BYTES_D];
+static uint32_t file_bytes = 0U;
+static int file = -1;
+static uint8_t* map = NULL;
+
+/* bytes left before power is cut */
+static uint32_t power_left = VOICE_FLASH_FILE_NO_CUT;
+static bool cut = false;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t take_power(uint32_t length);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* how much of a length byte operation gets done before power goes */
+static uint32_t take_power(uint32_t length)
+{
+    if (cut)
+    {
+        return 0U;
+    }
+
+    if (power_left == VOICE_FLASH_FILE_NO_CUT)
+    {
+        return length;
+    }
+
+    if (power_left <= length)
+    {
+        length = power_left;
+        power_left = 0U;
+        cut = true;
+        return length;
+    }
+
+    power_left -= length;
+
+    return length;
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+bool voice_flash_file_create(const char* path, uint32_t bytes)
+{
+    static const uint8_t blank[VOICE_FLASH_SECTOR_BYTES] = {[0 ... (VOICE_FLASH_SECTOR_BYTES - 1U)] = 0xFFU};
+    FILE* created;
+    uint32_t i;
+
+    voice_flash_close();
+    (void)snprintf(file_path, sizeof(file_path), "%s", path);
+    file_bytes = bytes - (bytes % VOICE_FLASH_SECTOR_BYTES);
+    created = fopen(path, "wb");
+
+    if (created == NULL)
+    {
+        return false;
+    }
+
+    for (i = 0U; i < (file_bytes / VOICE_FLASH_SECTOR_BYTES); i++)
+    {
+        if (fwrite(blank, 1U, sizeof(blank), created) != sizeof(blank))
+        {
+            (void)fclose(created);
+            return false;
+        }
+    }
+
+    return fclose(created) == 0;
+}
+
+void voice_flash_file_cut_power_after(uint32_t bytes)
+{
+    power_left = bytes;
+    cut = false;
+}
+
+bool voice_flash_file_power_cut(void)
+{
+    return cut;
+}
+
+bool voice_flash_open(const uint8_t** area, uint32_t* bytes)
+{
+    void* mapped;
+
+    voice_flash_close();
+    file = open(file_path, O_RDWR);
+
+    if (file < 0)
+    {
+        return false;
+    }
+
+    /* shared, so writes through the file show in the map like flash writes through the cache */
+    mapped = mmap(NULL, file_bytes, PROT_READ, MAP_SHARED, file, 0);
+
+    if (mapped == MAP_FAILED)
+    {
+        (void)close(file);
+        file = -1;
+        return false;
+    }
+
+    map = (uint8_t*)mapped;
+    *area = map;
+    *bytes = file_bytes;
+
+    return true;
+}
+
+bool voice_flash_erase_sector(uint32_t offset)
+{
+    static const uint8_t blank[VOICE_FLASH_SECTOR_BYTES] = {[0 ... (VOICE_FLASH_SECTOR_BYTES - 1U)] = 0xFFU};
+    uint32_t length;
+
+    if ((map == NULL) || ((offset % VOICE_FLASH_SECTOR_BYTES) != 0U) || (offset >= file_bytes))
+    {
+        return false;
+    }
+
+    /* an erase cut short leaves the sector part erased */
+    length = take_power(VOICE_FLASH_SECTOR_BYTES);
+
+    return (pwrite(file, blank, length, (off_t)offset) == (ssize_t)length) && (length == VOICE_FLASH_SECTOR_BYTES);
+}
+
+bool voice_flash_write(uint32_t offset, const void* data, uint32_t length)
+{
+    uint8_t programmed[VOICE_FLASH_SECTOR_BYTES];
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t done;
+    uint32_t count;
+    uint32_t i;
+
+    if ((map == NULL) || (offset > file_bytes) || (length > (file_bytes - offset)))
+    {
+        return false;
+    }
+
+    for (done = 0U; done < length; done += count)
+    {
+        count = ((length - done) < sizeof(programmed)) ? (length - done) : sizeof(programmed);
+        count = take_power(count);
+
+        if (count == 0U)
+        {
+            return false;
+        }
+
+        /* programming only clears bits */
+        for (i = 0U; i < count; i++)
+        {
+            programmed[i] = map[offset + done + i] & bytes[done + i];
+        }
+
+        if (pwrite(file, programmed, count, (off_t)(offset + done)) != (ssize_t)count)
+        {
+            return false;
+        }
+    }
+
+    return !cut;
+}
+
+void voice_flash_close(void)
+{
+    if (map != NULL)
+    {
+        (void)munmap(map, file_bytes);
+        map = NULL;
+    }
+
+    if (file >= 0)
+    {
+        (void)close(file);
+        file = -1;
+    }
+}
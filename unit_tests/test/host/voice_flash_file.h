@@ -0,0 +1,57 @@
+/**
+ ********************************************************************************
+ * @file    voice_flash_file.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   voice_flash off target, a file mapped with mmap. Writes behave like NOR flash and
+ *          power can be cut part way through a write, so recovery can be tested
+ ********************************************************************************
+ */
+
+#ifndef VOICE_FLASH_FILE_H
+#define VOICE_FLASH_FILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "voice_flash.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define VOICE_FLASH_FILE_NO_CUT (0xFFFFFFFFUL)
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief creates a blank, all 0xFF, flash file that voice_flash_open() maps from then on
+ *
+ * \param bytes rounded down to whole sectors
+ */
+bool voice_flash_file_create(const char* path, uint32_t bytes);
+
+/**
+ * \brief cuts power after bytes more bytes are programmed or erased. The write or erase it
+ *        happens in stops there, and every one after fails until power is restored with
+ *        VOICE_FLASH_FILE_NO_CUT
+ */
+void voice_flash_file_cut_power_after(uint32_t bytes);
+
+/**
+ * \brief returns true once power has been cut
+ */
+bool voice_flash_file_power_cut(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
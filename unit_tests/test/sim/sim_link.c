@@ -0,0 +1,1111 @@
+/**
+ ********************************************************************************
+ * @file    sim_link.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Host stand-in for espnow_link and timing, see sim_link.h
+ ********************************************************************************
+ */
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "sim_link.h"
+#include <string.h>
+#include "timing.h"
+
+/************************************
+ * PRIVATE MACROS AND DEFINES
+ ************************************/
+#define MAC_BYTES_D (6U)
+
+/* times a receiving task is rerun for frames that arrived while it was running */
+#define RX_TASK_ROUNDS_D (8U)
+
+/* simulated cpu clock for timing_get_cycles(), esp32c6 runs at 160 MHz */
+#define CPU_MHZ_D (160ULL)
+
+#define US_PER_S_D (1000000ULL)
+
+/* wifi channels are indexed by number, 0 is never used */
+#define WIFI_CHANNELS_D (ESPNOW_LINK_CHAN_LAST + 1U)
+
+/* foreign traffic heard in a survey, in frames of this length */
+#define LOAD_FRAME_BYTES_D (1500U)
+
+/* a channel nobody loaded, and the deferral cap so a loaded channel still lets frames out */
+#define QUIET_NOISE_DBM_D (-96)
+#define MAX_LOAD_PERMILLE_D (900U)
+
+/* with adapt_rate, a rate delivers everything from this much over its min_rssi, and nothing
+   from RATE_LOSS_ALL_DB_D under it, losing linearly in between */
+#define RATE_LOSS_NONE_DB_D (2)
+#define RATE_LOSS_ALL_DB_D (-4)
+
+/************************************
+ * PRIVATE TYPEDEFS
+ ************************************/
+typedef enum
+{
+    EVENT_DELIVER,  /* frame reaches a node's receive callback */
+    EVENT_TX_DONE   /* send callback for a node's oldest frame in flight */
+} EVENT_KIND_T;
+
+typedef struct
+{
+    uint64_t time_us;
+    uint32_t order;         /* events due at the same time run in the order they were made */
+    EVENT_KIND_T kind;
+    uint32_t node;          /* receiver for EVENT_DELIVER, sender for EVENT_TX_DONE */
+    bool success;
+    uint8_t mac[MAC_BYTES_D];   /* sender for EVENT_DELIVER, destination for EVENT_TX_DONE */
+    int8_t rssi;
+    uint16_t data_len;
+    uint8_t data[ESPNOW_DATA_BYTES];
+} EVENT_T;
+
+typedef struct
+{
+    SIM_LINK_PARAMS_T params;
+    bool bad_state;
+    uint64_t last_delivery_us;
+} LINK_T;
+
+typedef struct
+{
+    uint8_t mac[MAC_BYTES_D];
+    ESPNOW_LINK_RING_T rx_ring;
+    uint32_t rx_ring_storage[ESPNOW_LINK_RX_RING_BYTES / sizeof(uint32_t)];
+    ESPNOW_LINK_TX_TRACKER_T tx_tracker;
+    bool wake_requested;
+    uint32_t peers_registered;
+    SIM_LINK_TASK_T rx_task;
+    void* rx_task_context;
+    bool in_rx_task;
+    uint32_t busy;          /* calls of this node that are running events */
+    SIM_LINK_NODE_STATS_T stats;
+    uint8_t wifi_channel;
+    ESPNOW_LINK_CHAN_MONITOR_T chan_monitor;
+    uint32_t channel_switches;
+    ESPNOW_LINK_RATE_TABLE_T rate_table;
+} NODE_T;
+
+/* one wifi channel, shared by the nodes tuned to it and by traffic from outside the sim */
+typedef struct
+{
+    uint64_t free_us;
+    uint64_t busy_us;       /* nodes' own frames, acks and retries */
+    uint32_t load_permille;
+    int8_t noise_floor;
+} WIFI_CHANNEL_T;
+
+typedef bool (*READY_FN_T)(uint32_t node, uint32_t arg);
+
+/************************************
+ * STATIC VARIABLES
+ ************************************/
+static const uint8_t broadcast_mac[MAC_BYTES_D] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+
+static const SIM_LINK_CHANNEL_T default_channel = {
+    .bitrate_bps = 1000000U,
+    .preamble_us = 192U,
+    .overhead_bytes = 43U,
+    .gap_us = 360U,
+    .ack_us = 314U,
+    .mac_retries = 0U
+};
+
+static const SIM_LINK_PARAMS_T default_params = {
+    .latency_us = 200U,
+    .rssi_dbm = -50
+};
+
+static NODE_T nodes[SIM_LINK_MAX_NODES];
+static LINK_T links[SIM_LINK_MAX_NODES][SIM_LINK_MAX_NODES];
+static uint32_t node_count = 0U;
+static uint32_t selected = 0U;
+static SIM_LINK_CHANNEL_T channel;
+
+static uint64_t now_us = 0U;
+static uint64_t channel_busy_us = 0U;
+static WIFI_CHANNEL_T wifi_channels[WIFI_CHANNELS_D];
+static uint32_t rng_state = 1U;
+
+/* events live in a pool, a min heap of indexes keeps them in time order */
+static EVENT_T events[SIM_LINK_MAX_EVENTS];
+static uint16_t free_events[SIM_LINK_MAX_EVENTS];
+static uint32_t free_count = 0U;
+static uint16_t heap[SIM_LINK_MAX_EVENTS];
+static uint32_t heap_count = 0U;
+static uint32_t next_order = 0U;
+
+/************************************
+ * STATIC FUNCTION PROTOTYPES
+ ************************************/
+static uint32_t rng_next(void);
+static bool rng_chance(uint32_t ppm);
+static bool event_before(uint16_t a, uint16_t b);
+static EVENT_T* event_alloc(uint64_t time_us, EVENT_KIND_T kind, uint32_t node);
+static void event_schedule(EVENT_T* event);
+static EVENT_T* event_pop(void);
+static int32_t find_node(const uint8_t* mac);
+static uint64_t frame_airtime_us(uint16_t data_length);
+static uint64_t rate_airtime_us(ESPNOW_LINK_RATE_T rate, uint16_t data_length);
+static bool link_attempt(uint32_t from, uint32_t to);
+static bool rate_attempt(uint32_t from, uint32_t to, ESPNOW_LINK_RATE_T rate);
+static void schedule_delivery(uint32_t from, uint32_t to, uint64_t end_us, const uint8_t* data, uint16_t data_length);
+static void run_rx_task(uint32_t node);
+static void process_event(EVENT_T* event);
+static bool run_until_ready(uint64_t deadline_us, READY_FN_T ready, uint32_t node, uint32_t arg);
+static uint64_t deadline_from_ms(uint32_t timeout_ms);
+static bool rx_ready(uint32_t node, uint32_t arg);
+static bool tx_done(uint32_t node, uint32_t handle);
+static bool tx_slot_free(uint32_t node, uint32_t arg);
+static bool never_ready(uint32_t node, uint32_t arg);
+static uint64_t load_deferral_us(const WIFI_CHANNEL_T* wifi, uint64_t airtime_us);
+
+/************************************
+ * STATIC FUNCTIONS
+ ************************************/
+
+/* xorshift32, plenty for loss and jitter and the same on every host */
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13U;
+    rng_state ^= rng_state >> 17U;
+    rng_state ^= rng_state << 5U;
+
+    return rng_state;
+}
+
+static bool rng_chance(uint32_t ppm)
+{
+    return (ppm > 0U) && ((rng_next() % SIM_LINK_PPM) < ppm);
+}
+
+static bool event_before(uint16_t a, uint16_t b)
+{
+    if (events[a].time_us != events[b].time_us)
+    {
+        return events[a].time_us < events[b].time_us;
+    }
+
+    return (int32_t)(events[a].order - events[b].order) < 0;
+}
+
+static EVENT_T* event_alloc(uint64_t time_us, EVENT_KIND_T kind, uint32_t node)
+{
+    EVENT_T* event;
+
+    if (free_count == 0U)
+    {
+        return NULL;
+    }
+
+    event = &events[free_events[--free_count]];
+    event->time_us = time_us;
+    event->order = next_order++;
+    event->kind = kind;
+    event->node = node;
+    event->success = false;
+    event->data_len = 0U;
+
+    return event;
+}
+
+static void event_schedule(EVENT_T* event)
+{
+    uint32_t i = heap_count++;
+    uint16_t index = (uint16_t)(event - events);
+    uint32_t parent;
+
+    heap[i] = index;
+
+    while (i > 0U)
+    {
+        parent = (i - 1U) / 2U;
+
+        if (!event_before(heap[i], heap[parent]))
+        {
+            break;
+        }
+
+        heap[i] = heap[parent];
+        heap[parent] = index;
+        i = parent;
+    }
+}
+
+/* takes earliest event off the heap. Caller returns it to the pool once done with it */
+static EVENT_T* event_pop(void)
+{
+    uint16_t top = heap[0];
+    uint32_t i = 0U;
+    uint32_t child;
+    uint16_t moved;
+
+    heap_count--;
+    moved = heap[heap_count];
+
+    while ((child = (2U * i) + 1U) < heap_count)
+    {
+        if (((child + 1U) < heap_count) && event_before(heap[child + 1U], heap[child]))
+        {
+            child++;
+        }
+
+        if (!event_before(heap[child], moved))
+        {
+            break;
+        }
+
+        heap[i] = heap[child];
+        i = child;
+    }
+
+    heap[i] = moved;
+
+    return &events[top];
+}
+
+static int32_t find_node(const uint8_t* mac)
+{
+    uint32_t i;
+
+    for (i = 0U; i < node_count; i++)
+    {
+        if (memcmp(nodes[i].mac, mac, MAC_BYTES_D) == 0)
+        {
+            return (int32_t)i;
+        }
+    }
+
+    return -1;
+}
+
+/* one attempt: gap and backoff, preamble, then the frame itself */
+static uint64_t frame_airtime_us(uint16_t data_length)
+{
+    uint64_t bits = ((uint64_t)channel.overhead_bytes + data_length) * 8U;
+
+    return channel.gap_us + channel.preamble_us + (((bits * US_PER_S_D) + channel.bitrate_bps - 1U) / channel.bitrate_bps);
+}
+
+/* the same at a peer's rate, acks still go at the basic rate */
+static uint64_t rate_airtime_us(ESPNOW_LINK_RATE_T rate, uint16_t data_length)
+{
+    return channel.gap_us + espnow_link_rate_frame_us(rate, (uint16_t)(channel.overhead_bytes + data_length));
+}
+
+/* moves link's loss state along by one frame, returns true if the frame gets through */
+static bool link_attempt(uint32_t from, uint32_t to)
+{
+    LINK_T* link = &links[from][to];
+    bool lost;
+
+    if (link->bad_state)
+    {
+        link->bad_state = !rng_chance(link->params.bad_to_good_ppm);
+    }
+    else
+    {
+        link->bad_state = rng_chance(link->params.good_to_bad_ppm);
+    }
+
+    lost = rng_chance(link->bad_state ? link->params.loss_bad_ppm : link->params.loss_good_ppm);
+
+    if (lost)
+    {
+        nodes[to].stats.frames_lost++;
+    }
+
+    return !lost;
+}
+
+/* link_attempt, then the loss of sending at rate with the link's rssi */
+static bool rate_attempt(uint32_t from, uint32_t to, ESPNOW_LINK_RATE_T rate)
+{
+    int32_t margin = (int32_t)links[from][to].params.rssi_dbm - espnow_link_rate_info(rate)->min_rssi;
+    uint32_t loss_ppm;
+
+    if (!link_attempt(from, to))
+    {
+        return false;
+    }
+
+    if (margin >= RATE_LOSS_NONE_DB_D)
+    {
+        return true;
+    }
+
+    loss_ppm = (margin <= RATE_LOSS_ALL_DB_D) ? SIM_LINK_PPM :
+               (uint32_t)(((RATE_LOSS_NONE_DB_D - margin) * (int32_t)SIM_LINK_PPM) / (RATE_LOSS_NONE_DB_D - RATE_LOSS_ALL_DB_D));
+
+    if (rng_chance(loss_ppm))
+    {
+        nodes[to].stats.frames_lost++;
+        return false;
+    }
+
+    return true;
+}
+
+static void schedule_delivery(uint32_t from, uint32_t to, uint64_t end_us, const uint8_t* data, uint16_t data_length)
+{
+    LINK_T* link = &links[from][to];
+    uint64_t time_us = end_us + link->params.latency_us;
+    EVENT_T* event;
+
+    if (link->params.jitter_us > 0U)
+    {
+        time_us += rng_next() % (link->params.jitter_us + 1U);
+    }
+
+    if (!link->params.reorder && (time_us < link->last_delivery_us))
+    {
+        time_us = link->last_delivery_us;
+    }
+
+    link->last_delivery_us = time_us;
+
+    /* pool is sized so a full tx pipeline on every node fits, this only trips on a config error */
+    event = event_alloc(time_us, EVENT_DELIVER, to);
+
+    if (event == NULL)
+    {
+        nodes[to].stats.frames_lost++;
+        return;
+    }
+
+    memcpy(event->mac, nodes[from].mac, MAC_BYTES_D);
+    event->rssi = link->params.rssi_dbm;
+    event->data_len = data_length;
+    memcpy(event->data, data, data_length);
+    event_schedule(event);
+}
+
+static void run_rx_task(uint32_t node)
+{
+    NODE_T* target = &nodes[node];
+    uint32_t previous;
+    uint32_t rounds = 0U;
+
+    if ((target->rx_task == NULL) || (target->busy > 0U) || target->in_rx_task)
+    {
+        return;
+    }
+
+    target->in_rx_task = true;
+    previous = sim_link_select(node);
+
+    do
+    {
+        target->rx_task(node, target->rx_task_context);
+        rounds++;
+    } while ((!espnow_link_ring_is_empty(&target->rx_ring) || target->wake_requested) && (rounds < RX_TASK_ROUNDS_D));
+
+    (void)sim_link_select(previous);
+    target->in_rx_task = false;
+}
+
+static void process_event(EVENT_T* event)
+{
+    uint32_t node = event->node;
+    ESPNOW_LINK_RX_DESC_T desc;
+    ESPNOW_LINK_TX_COMPLETION_T completion;
+    bool completed;
+    bool success = event->success;
+    uint32_t previous;
+
+    now_us = event->time_us;
+
+    /* event goes back to the pool first, what runs from here can send */
+    free_events[free_count++] = (uint16_t)(event - events);
+
+    if (event->kind == EVENT_DELIVER)
+    {
+        memset(&desc, 0, sizeof(desc));
+        memcpy(desc.src_mac, event->mac, MAC_BYTES_D);
+        desc.rssi = event->rssi;
+        desc.timestamp_us = (uint32_t)now_us;
+        desc.data_len = event->data_len;
+        desc.noise_floor = wifi_channels[nodes[node].wifi_channel].noise_floor;
+
+        nodes[node].stats.frames_received++;
+        espnow_link_chan_on_rx(&nodes[node].chan_monitor, desc.rssi, desc.noise_floor);
+        espnow_link_rate_on_rx(&nodes[node].rate_table, desc.src_mac, desc.rssi, (uint32_t)(now_us / 1000U));
+        (void)espnow_link_ring_push(&nodes[node].rx_ring, &desc, event->data);
+        run_rx_task(node);
+        return;
+    }
+
+    if (memcmp(event->mac, broadcast_mac, MAC_BYTES_D) != 0)
+    {
+        espnow_link_chan_on_tx(&nodes[node].chan_monitor, success);
+        espnow_link_rate_on_tx(&nodes[node].rate_table, event->mac, success);
+    }
+
+    completed = espnow_link_tx_complete(&nodes[node].tx_tracker, event->mac, success, &completion);
+
+    if (completed && (completion.callback != NULL))
+    {
+        /* send callbacks run as the sending node, like they would on its wifi task */
+        previous = sim_link_select(node);
+        completion.callback(completion.handle, success, completion.context);
+        (void)sim_link_select(previous);
+    }
+}
+
+/* runs events until ready() holds or deadline passes. Stops early if nothing is left to happen */
+static bool run_until_ready(uint64_t deadline_us, READY_FN_T ready, uint32_t node, uint32_t arg)
+{
+    for (;;)
+    {
+        if (ready(node, arg))
+        {
+            return true;
+        }
+
+        if ((heap_count == 0U) || (events[heap[0]].time_us > deadline_us))
+        {
+            if ((deadline_us != SIM_LINK_FOREVER) && (deadline_us > now_us))
+            {
+                now_us = deadline_us;
+            }
+
+            return ready(node, arg);
+        }
+
+        process_event(event_pop());
+    }
+}
+
+static uint64_t deadline_from_ms(uint32_t timeout_ms)
+{
+    return (timeout_ms == ESPNOW_LINK_WAIT_FOREVER) ? SIM_LINK_FOREVER : (now_us + ((uint64_t)timeout_ms * 1000U));
+}
+
+static bool rx_ready(uint32_t node, uint32_t arg)
+{
+    return !espnow_link_ring_is_empty(&nodes[node].rx_ring) || nodes[node].wake_requested;
+}
+
+static bool tx_done(uint32_t node, uint32_t handle)
+{
+    return espnow_link_tx_get_state(&nodes[node].tx_tracker, handle) != ESPNOW_LINK_TX_STATE_PENDING;
+}
+
+static bool tx_slot_free(uint32_t node, uint32_t arg)
+{
+    return espnow_link_tx_in_flight(&nodes[node].tx_tracker) < ESPNOW_LINK_TX_MAX_IN_FLIGHT;
+}
+
+static bool never_ready(uint32_t node, uint32_t arg)
+{
+    return false;
+}
+
+/* time an attempt waits for foreign traffic. A channel busy p of the time leaves a frame
+   waiting p / (1 - p) of its own airtime on average */
+static uint64_t load_deferral_us(const WIFI_CHANNEL_T* wifi, uint64_t airtime_us)
+{
+    uint32_t permille = (wifi->load_permille > MAX_LOAD_PERMILLE_D) ? MAX_LOAD_PERMILLE_D : wifi->load_permille;
+
+    return (airtime_us * permille) / (1000U - permille);
+}
+
+/************************************
+ * GLOBAL FUNCTIONS
+ ************************************/
+void sim_link_init(uint32_t count, uint32_t seed)
+{
+    uint32_t i;
+
+    node_count = (count > SIM_LINK_MAX_NODES) ? SIM_LINK_MAX_NODES : count;
+    selected = 0U;
+    channel = default_channel;
+    now_us = 0U;
+    channel_busy_us = 0U;
+    rng_state = (seed != 0U) ? seed : 1U;
+
+    memset(nodes, 0, sizeof(nodes));
+    memset(links, 0, sizeof(links));
+    memset(wifi_channels, 0, sizeof(wifi_channels));
+
+    for (i = 0U; i < WIFI_CHANNELS_D; i++)
+    {
+        wifi_channels[i].noise_floor = QUIET_NOISE_DBM_D;
+    }
+
+    for (i = 0U; i < SIM_LINK_MAX_NODES; i++)
+    {
+        /* locally administered, and spells SIM */
+        nodes[i].mac[0] = 0x02U;
+        nodes[i].mac[1] = 'S';
+        nodes[i].mac[2] = 'I';
+        nodes[i].mac[3] = 'M';
+        nodes[i].mac[5] = (uint8_t)i;
+        (void)espnow_link_ring_init(&nodes[i].rx_ring, (uint8_t*)nodes[i].rx_ring_storage, ESPNOW_LINK_RX_RING_BYTES,
+                                    ESPNOW_LINK_RING_DROP_NEWEST);
+        espnow_link_tx_init(&nodes[i].tx_tracker);
+        nodes[i].wifi_channel = ESPNOW_LINK_CHAN_DEFAULT;
+        espnow_link_chan_monitor_init(&nodes[i].chan_monitor);
+        espnow_link_rate_init(&nodes[i].rate_table, false);
+    }
+
+    sim_link_set_all_params(&default_params);
+
+    for (i = 0U; i < SIM_LINK_MAX_EVENTS; i++)
+    {
+        free_events[i] = (uint16_t)(SIM_LINK_MAX_EVENTS - 1U - i);
+    }
+
+    free_count = SIM_LINK_MAX_EVENTS;
+    heap_count = 0U;
+    next_order = 0U;
+}
+
+void sim_link_set_channel(const SIM_LINK_CHANNEL_T* new_channel)
+{
+    uint32_t i;
+
+    channel = *new_channel;
+
+    /* what was learned at other rates doesn't carry over */
+    for (i = 0U; i < SIM_LINK_MAX_NODES; i++)
+    {
+        espnow_link_rate_init(&nodes[i].rate_table, channel.long_range);
+    }
+}
+
+void sim_link_set_wifi_load(uint8_t wifi_channel, uint32_t busy_permille, int8_t noise_floor)
+{
+    if ((wifi_channel >= ESPNOW_LINK_CHAN_FIRST) && (wifi_channel <= ESPNOW_LINK_CHAN_LAST))
+    {
+        wifi_channels[wifi_channel].load_permille = busy_permille;
+        wifi_channels[wifi_channel].noise_floor = noise_floor;
+    }
+}
+
+void sim_link_set_params(uint32_t from, uint32_t to, const SIM_LINK_PARAMS_T* params)
+{
+    links[from][to].params = *params;
+    links[from][to].bad_state = false;
+}
+
+void sim_link_set_all_params(const SIM_LINK_PARAMS_T* params)
+{
+    uint32_t from;
+    uint32_t to;
+
+    for (from = 0U; from < SIM_LINK_MAX_NODES; from++)
+    {
+        for (to = 0U; to < SIM_LINK_MAX_NODES; to++)
+        {
+            if (from != to)
+            {
+                sim_link_set_params(from, to, params);
+            }
+        }
+    }
+}
+
+void sim_link_set_rx_task(uint32_t node, SIM_LINK_TASK_T task, void* context)
+{
+    nodes[node].rx_task = task;
+    nodes[node].rx_task_context = context;
+}
+
+uint32_t sim_link_select(uint32_t node)
+{
+    uint32_t previous = selected;
+
+    selected = node;
+
+    return previous;
+}
+
+const uint8_t* sim_link_mac(uint32_t node)
+{
+    return nodes[node].mac;
+}
+
+uint64_t sim_link_now_us(void)
+{
+    return now_us;
+}
+
+void sim_link_run_until(uint64_t time_us)
+{
+    while ((heap_count > 0U) && (events[heap[0]].time_us <= time_us))
+    {
+        process_event(event_pop());
+    }
+
+    if (time_us > now_us)
+    {
+        now_us = time_us;
+    }
+}
+
+bool sim_link_idle(void)
+{
+    return heap_count == 0U;
+}
+
+uint64_t sim_link_channel_busy_us(void)
+{
+    return channel_busy_us;
+}
+
+void sim_link_get_stats(uint32_t node, SIM_LINK_NODE_STATS_T* stats)
+{
+    *stats = nodes[node].stats;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_init(uint32_t node)
+{
+    nodes[node].wake_requested = false;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_close(uint32_t node)
+{
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_register_peer(uint32_t node, const uint8_t* peer_mac)
+{
+    /* recorded only, frames to unregistered peers still go out */
+    nodes[node].peers_registered++;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_unregister_peer(uint32_t node, const uint8_t* peer_mac)
+{
+    nodes[node].peers_registered -= (nodes[node].peers_registered > 0U) ? 1U : 0U;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_write(uint32_t node, const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    ESPNOW_LINK_ERR_T err;
+
+    /* same as on target: wait for room in the pipeline, then for this frame's send callback */
+    nodes[node].busy++;
+
+    while ((err = sim_link_node_write_async(node, peer_mac, data, data_length, NULL, NULL, &handle)) == ESPNOW_LINK_ERR_BUSY)
+    {
+        (void)run_until_ready(SIM_LINK_FOREVER, tx_slot_free, node, 0U);
+    }
+
+    nodes[node].busy--;
+
+    if (err != ESPNOW_LINK_ERR_NONE)
+    {
+        return err;
+    }
+
+    return sim_link_node_wait_tx(node, handle, ESPNOW_LINK_WAIT_FOREVER);
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_write_async(uint32_t node,
+                                            const uint8_t* peer_mac,
+                                            const uint8_t* data,
+                                            uint16_t data_length,
+                                            ESPNOW_LINK_TX_DONE_CB_T callback,
+                                            void* context,
+                                            ESPNOW_LINK_TX_HANDLE_T* handle)
+{
+    NODE_T* sender = &nodes[node];
+    ESPNOW_LINK_TX_HANDLE_T local_handle;
+    bool broadcast = (memcmp(peer_mac, broadcast_mac, MAC_BYTES_D) == 0);
+    int32_t peer = broadcast ? -1 : find_node(peer_mac);
+    WIFI_CHANNEL_T* wifi = &wifi_channels[sender->wifi_channel];
+    uint64_t start_us;
+    uint64_t end_us;
+    uint64_t airtime_us = frame_airtime_us(data_length);
+    uint64_t defer_us = load_deferral_us(wifi, airtime_us);
+    uint64_t deferred_us = 0U;
+    uint32_t attempt;
+    uint32_t to;
+    bool acked = false;
+    bool reconfigure;
+    ESPNOW_LINK_RATE_T rate = ESPNOW_LINK_RATE_1M;
+    EVENT_T* done;
+
+    if ((data_length == 0U) || (data_length > ESPNOW_DATA_BYTES))
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    if (handle == NULL)
+    {
+        handle = &local_handle;
+    }
+
+    /* every receiver of a broadcast, plus the send callback, must fit in the event pool */
+    if (free_count < (node_count + 1U))
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    if (espnow_link_tx_reserve(&sender->tx_tracker, peer_mac, callback, context, handle) < 0)
+    {
+        sender->stats.tx_busy++;
+        return ESPNOW_LINK_ERR_BUSY;
+    }
+
+    sender->stats.frames_sent++;
+
+    /* channel is taken in the order frames are handed over, by any node tuned to it. Only
+       nodes on the same channel hear each other */
+    start_us = (wifi->free_us > now_us) ? wifi->free_us : now_us;
+    end_us = start_us;
+
+    if (broadcast)
+    {
+        deferred_us += defer_us;
+        end_us += defer_us + airtime_us;
+
+        for (to = 0U; to < node_count; to++)
+        {
+            if ((to != node) && (nodes[to].wifi_channel == sender->wifi_channel) && link_attempt(node, to))
+            {
+                schedule_delivery(node, to, end_us, data, data_length);
+            }
+        }
+
+        /* nobody acks a broadcast, esp now reports it sent */
+        acked = true;
+    }
+    else
+    {
+        /* retries go at the same rate, the result counts once */
+        if (channel.adapt_rate)
+        {
+            rate = espnow_link_rate_select(&sender->rate_table, peer_mac, (uint32_t)(now_us / 1000U), &reconfigure);
+            airtime_us = rate_airtime_us(rate, data_length);
+            defer_us = load_deferral_us(wifi, airtime_us);
+        }
+
+        for (attempt = 0U; !acked && (attempt <= channel.mac_retries); attempt++)
+        {
+            deferred_us += defer_us;
+            end_us += defer_us + airtime_us;
+            sender->stats.retries += (attempt > 0U) ? 1U : 0U;
+
+            if ((peer >= 0) && ((uint32_t)peer != node) && (nodes[peer].wifi_channel == sender->wifi_channel) &&
+                (channel.adapt_rate ? rate_attempt(node, (uint32_t)peer, rate) : link_attempt(node, (uint32_t)peer)))
+            {
+                schedule_delivery(node, (uint32_t)peer, end_us, data, data_length);
+                acked = true;
+            }
+
+            /* ack, or the wait for one that never comes */
+            end_us += channel.ack_us;
+        }
+    }
+
+    /* the wait for foreign traffic isn't the nodes' own airtime */
+    channel_busy_us += end_us - start_us - deferred_us;
+    wifi->busy_us += end_us - start_us - deferred_us;
+    wifi->free_us = end_us;
+
+    sender->stats.frames_acked += (acked && !broadcast) ? 1U : 0U;
+    sender->stats.frames_failed += acked ? 0U : 1U;
+
+    done = event_alloc(end_us, EVENT_TX_DONE, node);
+    done->success = acked;
+    memcpy(done->mac, peer_mac, MAC_BYTES_D);
+    event_schedule(done);
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_wait_tx(uint32_t node, ESPNOW_LINK_TX_HANDLE_T handle, uint32_t timeout_ms)
+{
+    bool done;
+
+    nodes[node].busy++;
+    done = run_until_ready(deadline_from_ms(timeout_ms), tx_done, node, handle);
+    nodes[node].busy--;
+
+    if (!done)
+    {
+        return ESPNOW_LINK_ERR_TIMEOUT;
+    }
+
+    return (espnow_link_tx_get_state(&nodes[node].tx_tracker, handle) == ESPNOW_LINK_TX_STATE_SUCCESS) ? ESPNOW_LINK_ERR_NONE
+                                                                                                        : ESPNOW_LINK_ERR;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_wait_tx_slot(uint32_t node, uint32_t timeout_ms)
+{
+    bool free;
+
+    nodes[node].busy++;
+    free = run_until_ready(deadline_from_ms(timeout_ms), tx_slot_free, node, 0U);
+    nodes[node].busy--;
+
+    return free ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR_TIMEOUT;
+}
+
+uint32_t sim_link_node_tx_pending(uint32_t node)
+{
+    return espnow_link_tx_in_flight(&nodes[node].tx_tracker);
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_get_device_mac(uint32_t node, uint8_t* buffer)
+{
+    memcpy(buffer, nodes[node].mac, MAC_BYTES_D);
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_read(uint32_t node, ESPNOW_LINK_MSG_T* msg_buffer)
+{
+    return espnow_link_ring_pop(&nodes[node].rx_ring, &msg_buffer->info, msg_buffer->data, ESPNOW_DATA_BYTES)
+               ? ESPNOW_LINK_ERR_NONE
+               : ESPNOW_LINK_ERR;
+}
+
+bool sim_link_node_messages_available(uint32_t node)
+{
+    return !espnow_link_ring_is_empty(&nodes[node].rx_ring);
+}
+
+bool sim_link_node_wait_for_messages(uint32_t node, uint32_t timeout_ms)
+{
+    nodes[node].busy++;
+    (void)run_until_ready(deadline_from_ms(timeout_ms), rx_ready, node, 0U);
+    nodes[node].busy--;
+    nodes[node].wake_requested = false;
+
+    return sim_link_node_messages_available(node);
+}
+
+void sim_link_node_wake_reader(uint32_t node)
+{
+    nodes[node].wake_requested = true;
+    run_rx_task(node);
+}
+
+void sim_link_node_set_rx_overflow_policy(uint32_t node, ESPNOW_LINK_RING_POLICY_T policy)
+{
+    espnow_link_ring_set_policy(&nodes[node].rx_ring, policy);
+}
+
+void sim_link_node_get_rx_stats(uint32_t node, ESPNOW_LINK_RX_STATS_T* stats)
+{
+    stats->frames_received = nodes[node].stats.frames_received;
+    espnow_link_ring_get_stats(&nodes[node].rx_ring, &stats->ring);
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_set_wifi_channel(uint32_t node, uint8_t wifi_channel)
+{
+    if ((wifi_channel < ESPNOW_LINK_CHAN_FIRST) || (wifi_channel > ESPNOW_LINK_CHAN_LAST))
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    nodes[node].wifi_channel = wifi_channel;
+    nodes[node].channel_switches++;
+    espnow_link_chan_monitor_init(&nodes[node].chan_monitor);
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+uint8_t sim_link_node_get_wifi_channel(uint32_t node)
+{
+    return nodes[node].wifi_channel;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_scan_channels(uint32_t node, uint32_t dwell_ms, ESPNOW_LINK_CHAN_SURVEY_T* survey)
+{
+    NODE_T* scanner = &nodes[node];
+    WIFI_CHANNEL_T* wifi;
+    uint8_t home = scanner->wifi_channel;
+    uint32_t dwell_us = dwell_ms * 1000U;
+    uint32_t load_airtime_us = espnow_link_chan_airtime_us(LOAD_FRAME_BYTES_D);
+    uint32_t frames;
+    uint64_t own_busy_us;
+    uint8_t wifi_channel;
+
+    espnow_link_chan_survey_init(survey);
+
+    /* like on target the node keeps running meanwhile, just tuned away from its peers */
+    scanner->busy++;
+
+    for (wifi_channel = ESPNOW_LINK_CHAN_FIRST; wifi_channel <= ESPNOW_LINK_CHAN_LAST; wifi_channel++)
+    {
+        wifi = &wifi_channels[wifi_channel];
+        scanner->wifi_channel = wifi_channel;
+        own_busy_us = wifi->busy_us;
+        (void)run_until_ready(now_us + dwell_us, never_ready, node, 0U);
+
+        /* foreign traffic as whole frames, the other nodes' own as it was sent */
+        for (frames = (uint32_t)(((uint64_t)dwell_us * wifi->load_permille) / 1000U) / load_airtime_us; frames > 0U; frames--)
+        {
+            espnow_link_chan_scan_add(survey, wifi_channel, -70, wifi->noise_floor, load_airtime_us);
+        }
+
+        if (wifi->busy_us > own_busy_us)
+        {
+            espnow_link_chan_scan_add(survey, wifi_channel, default_params.rssi_dbm, wifi->noise_floor,
+                                      (uint32_t)(wifi->busy_us - own_busy_us));
+        }
+
+        espnow_link_chan_scan_dwell(survey, wifi_channel, dwell_us);
+    }
+
+    scanner->wifi_channel = home;
+    scanner->busy--;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+void sim_link_node_get_chan_stats(uint32_t node, ESPNOW_LINK_CHAN_STATS_T* stats)
+{
+    espnow_link_chan_get_stats(&nodes[node].chan_monitor, stats);
+    stats->channel = nodes[node].wifi_channel;
+    stats->switches = nodes[node].channel_switches;
+}
+
+ESPNOW_LINK_ERR_T sim_link_node_get_peer_rate(uint32_t node, const uint8_t* peer_mac, ESPNOW_LINK_RATE_STATS_T* stats)
+{
+    return espnow_link_rate_get_stats(&nodes[node].rate_table, peer_mac, stats) ? ESPNOW_LINK_ERR_NONE : ESPNOW_LINK_ERR;
+}
+
+/* espnow_link.h, acting for the selected node */
+
+ESPNOW_LINK_ERR_T espnow_link_init(void)
+{
+    return sim_link_node_init(selected);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_close(void)
+{
+    return sim_link_node_close(selected);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_register_peer(const uint8_t* peer_mac_address)
+{
+    return sim_link_node_register_peer(selected, peer_mac_address);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_unregister_peer(const uint8_t* peer_mac_address)
+{
+    return sim_link_node_unregister_peer(selected, peer_mac_address);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_write(const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length)
+{
+    return sim_link_node_write(selected, peer_mac, data, data_length);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_write_async(const uint8_t* peer_mac,
+                                          const uint8_t* data,
+                                          uint16_t data_length,
+                                          ESPNOW_LINK_TX_DONE_CB_T callback,
+                                          void* context,
+                                          ESPNOW_LINK_TX_HANDLE_T* handle)
+{
+    return sim_link_node_write_async(selected, peer_mac, data, data_length, callback, context, handle);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_wait_tx(ESPNOW_LINK_TX_HANDLE_T handle, uint32_t timeout_ms)
+{
+    return sim_link_node_wait_tx(selected, handle, timeout_ms);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_wait_tx_slot(uint32_t timeout_ms)
+{
+    return sim_link_node_wait_tx_slot(selected, timeout_ms);
+}
+
+uint32_t espnow_link_tx_pending(void)
+{
+    return sim_link_node_tx_pending(selected);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_get_device_mac(const uint8_t* buffer)
+{
+    return sim_link_node_get_device_mac(selected, (uint8_t*)buffer);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_read(const ESPNOW_LINK_MSG_T* msg_buffer)
+{
+    return sim_link_node_read(selected, (ESPNOW_LINK_MSG_T*)msg_buffer);
+}
+
+bool espnow_link_messages_available(void)
+{
+    return sim_link_node_messages_available(selected);
+}
+
+bool espnow_link_wait_for_messages(uint32_t timeout_ms)
+{
+    return sim_link_node_wait_for_messages(selected, timeout_ms);
+}
+
+void espnow_link_wake_reader(void)
+{
+    sim_link_node_wake_reader(selected);
+}
+
+void espnow_link_set_rx_overflow_policy(ESPNOW_LINK_RING_POLICY_T policy)
+{
+    sim_link_node_set_rx_overflow_policy(selected, policy);
+}
+
+void espnow_link_get_rx_stats(ESPNOW_LINK_RX_STATS_T* stats)
+{
+    sim_link_node_get_rx_stats(selected, stats);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_set_wifi_channel(uint8_t wifi_channel)
+{
+    return sim_link_node_set_wifi_channel(selected, wifi_channel);
+}
+
+uint8_t espnow_link_get_wifi_channel(void)
+{
+    return sim_link_node_get_wifi_channel(selected);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_scan_channels(uint32_t dwell_ms, ESPNOW_LINK_CHAN_SURVEY_T* survey)
+{
+    return sim_link_node_scan_channels(selected, dwell_ms, survey);
+}
+
+void espnow_link_get_chan_stats(ESPNOW_LINK_CHAN_STATS_T* stats)
+{
+    sim_link_node_get_chan_stats(selected, stats);
+}
+
+ESPNOW_LINK_ERR_T espnow_link_get_peer_rate(const uint8_t* peer_mac, ESPNOW_LINK_RATE_STATS_T* stats)
+{
+    return sim_link_node_get_peer_rate(selected, peer_mac, stats);
+}
+
+/* timing.h, on the simulated clock */
+
+uint32_t timing_get_ms(void)
+{
+    return (uint32_t)(now_us / 1000U);
+}
+
+uint32_t timing_get_us(void)
+{
+    return (uint32_t)now_us;
+}
+
+uint32_t timing_get_cycles(void)
+{
+    return (uint32_t)(now_us * CPU_MHZ_D);
+}
@@ -0,0 +1,203 @@
+/**
+ ********************************************************************************
+ * @file    sim_link.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Host stand-in for espnow_link and timing. Connects up to SIM_LINK_MAX_NODES virtual
+ *          devices over one shared channel, as a discrete event simulation on a simulated clock.
+ *          Each link has its own latency, jitter, Gilbert-Elliott loss and RSSI, and frames
+ *          take airtime on the channel, so senders queue behind each other under load.
+ *          Everything is driven from the calling thread and seeded, so runs repeat exactly
+ *
+ *          espnow_link_*() calls act for the selected node. Blocking calls (write, wait_tx,
+ *          wait_for_messages) advance the clock, delivering frames to every node meanwhile,
+ *          instead of sleeping. sim_wt20.h runs a separate wt20 stack on each node
+ ********************************************************************************
+ */
+
+#ifndef SIM_LINK_H
+#define SIM_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "espnow_link.h"
+
+/************************************
+ * MACROS AND DEFINES
+ ************************************/
+#define SIM_LINK_MAX_NODES (4U)
+
+/* frames on the air or waiting for their send result, across all nodes */
+#define SIM_LINK_MAX_EVENTS (512U)
+
+/* timeout for sim_link_run_until() style waits that never expire */
+#define SIM_LINK_FOREVER (UINT64_MAX)
+
+#define SIM_LINK_PPM (1000000U)
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* stands in for a node's receiving task */
+typedef void (*SIM_LINK_TASK_T)(uint32_t node, void* context);
+
+/* the medium every node shares. Defaults are 802.11b at 1 Mbps, what esp now uses out of the box */
+typedef struct
+{
+    uint32_t bitrate_bps;
+    uint32_t preamble_us;     /* PLCP preamble and header, sent before every frame */
+    uint16_t overhead_bytes;  /* MAC header, vendor action frame and FCS around the payload */
+    uint32_t gap_us;          /* DIFS and mean backoff before every attempt */
+    uint32_t ack_us;          /* MAC ack after a unicast frame, plus the gaps around it */
+    uint8_t mac_retries;      /* resends of a unicast frame that got no ack. 0 by default, so the
+                                 loss set on a link is exactly the loss the stack sees */
+    bool adapt_rate;          /* unicast frames go at each peer's rate from espnow_link_rate,
+                                 instead of bitrate_bps and preamble_us, and a link whose rssi is
+                                 short of what the rate needs loses frames too. Off by default */
+    bool long_range;          /* lets adapt_rate use the LR rates */
+} SIM_LINK_CHANNEL_T;
+
+/* one direction of a link. Loss follows a Gilbert-Elliott model: the link moves between a
+   good and a bad state once per frame, and loses frames at the rate of its current state.
+   Mean burst length is SIM_LINK_PPM / bad_to_good_ppm frames */
+typedef struct
+{
+    uint32_t latency_us;      /* from end of airtime to the receive callback */
+    uint32_t jitter_us;       /* extra delay, uniform from 0 to this */
+    bool reorder;             /* let jitter reorder frames, otherwise each link stays in order */
+    uint32_t loss_good_ppm;
+    uint32_t loss_bad_ppm;
+    uint32_t good_to_bad_ppm;
+    uint32_t bad_to_good_ppm;
+    int8_t rssi_dbm;
+} SIM_LINK_PARAMS_T;
+
+typedef struct
+{
+    uint32_t frames_sent;     /* handed to the link, broadcasts count once */
+    uint32_t frames_acked;
+    uint32_t frames_failed;   /* unicast frames that used up their retries */
+    uint32_t retries;
+    uint32_t frames_received; /* delivered to this node, including ones its ring dropped */
+    uint32_t frames_lost;     /* addressed to this node and lost in the air, per attempt */
+    uint32_t tx_busy;         /* writes refused because the tx pipeline was full */
+} SIM_LINK_NODE_STATS_T;
+
+/************************************
+ * GLOBAL FUNCTION PROTOTYPES
+ ************************************/
+
+/**
+ * \brief resets clock to 0 and sets up nodes with default channel, perfect links at -50 dBm and
+ *        200 us latency, empty rings and node 0 selected
+ *
+ * \param nodes 1 to SIM_LINK_MAX_NODES
+ * \param seed seeds jitter and loss, same seed gives the same run
+ */
+void sim_link_init(uint32_t nodes, uint32_t seed);
+
+void sim_link_set_channel(const SIM_LINK_CHANNEL_T* channel);
+
+/**
+ * \brief loads wifi_channel with traffic from outside the sim. Nodes' frames on it wait
+ *        for that traffic, and surveys hear it. Every node starts on ESPNOW_LINK_CHAN_DEFAULT,
+ *        and only nodes on the same channel hear each other. Channels start unloaded at -96 dBm
+ *
+ * \param busy_permille share of the time the channel is taken, up to 900 slows nodes down
+ * \param noise_floor reported with every frame received on it
+ */
+void sim_link_set_wifi_load(uint8_t wifi_channel, uint32_t busy_permille, int8_t noise_floor);
+
+/**
+ * \brief sets the link from one node to another. Only that direction changes
+ */
+void sim_link_set_params(uint32_t from, uint32_t to, const SIM_LINK_PARAMS_T* params);
+
+/**
+ * \brief sets every link between different nodes
+ */
+void sim_link_set_all_params(const SIM_LINK_PARAMS_T* params);
+
+/**
+ * \brief gives node a receiving task, which runs with node selected whenever a frame is
+ *        delivered to node or its reader is woken. That lets a node receive while another one
+ *        is blocked sending. Skipped while node is inside a call of its own, it finds the frame
+ *        when it next reads
+ *
+ * \param task[in] NULL to remove
+ */
+void sim_link_set_rx_task(uint32_t node, SIM_LINK_TASK_T task, void* context);
+
+/**
+ * \brief makes espnow_link_*() act for node
+ *
+ * \return node selected before
+ */
+uint32_t sim_link_select(uint32_t node);
+
+const uint8_t* sim_link_mac(uint32_t node);
+
+uint64_t sim_link_now_us(void);
+
+/**
+ * \brief processes every event due up to time_us, then moves clock to time_us
+ */
+void sim_link_run_until(uint64_t time_us);
+
+/**
+ * \brief true if nothing is on the air or waiting for a send result
+ */
+bool sim_link_idle(void);
+
+/**
+ * \brief time the channels have been busy with nodes' frames, acks and retries since init
+ */
+uint64_t sim_link_channel_busy_us(void);
+
+void sim_link_get_stats(uint32_t node, SIM_LINK_NODE_STATS_T* stats);
+
+/**
+ * \brief espnow_link_*() for a given node, used by sim_wt20 stacks. Same behaviour as the
+ *        espnow_link.h functions of the same name
+ */
+ESPNOW_LINK_ERR_T sim_link_node_init(uint32_t node);
+ESPNOW_LINK_ERR_T sim_link_node_close(uint32_t node);
+ESPNOW_LINK_ERR_T sim_link_node_register_peer(uint32_t node, const uint8_t* peer_mac);
+ESPNOW_LINK_ERR_T sim_link_node_unregister_peer(uint32_t node, const uint8_t* peer_mac);
+ESPNOW_LINK_ERR_T sim_link_node_write(uint32_t node, const uint8_t* peer_mac, const uint8_t* data, uint16_t data_length);
+ESPNOW_LINK_ERR_T sim_link_node_write_async(uint32_t node,
+                                            const uint8_t* peer_mac,
+                                            const uint8_t* data,
+                                            uint16_t data_length,
+                                            ESPNOW_LINK_TX_DONE_CB_T callback,
+                                            void* context,
+                                            ESPNOW_LINK_TX_HANDLE_T* handle);
+ESPNOW_LINK_ERR_T sim_link_node_wait_tx(uint32_t node, ESPNOW_LINK_TX_HANDLE_T handle, uint32_t timeout_ms);
+ESPNOW_LINK_ERR_T sim_link_node_wait_tx_slot(uint32_t node, uint32_t timeout_ms);
+uint32_t sim_link_node_tx_pending(uint32_t node);
+ESPNOW_LINK_ERR_T sim_link_node_get_device_mac(uint32_t node, uint8_t* buffer);
+ESPNOW_LINK_ERR_T sim_link_node_read(uint32_t node, ESPNOW_LINK_MSG_T* msg_buffer);
+bool sim_link_node_messages_available(uint32_t node);
+bool sim_link_node_wait_for_messages(uint32_t node, uint32_t timeout_ms);
+void sim_link_node_wake_reader(uint32_t node);
+void sim_link_node_set_rx_overflow_policy(uint32_t node, ESPNOW_LINK_RING_POLICY_T policy);
+void sim_link_node_get_rx_stats(uint32_t node, ESPNOW_LINK_RX_STATS_T* stats);
+ESPNOW_LINK_ERR_T sim_link_node_set_wifi_channel(uint32_t node, uint8_t wifi_channel);
+uint8_t sim_link_node_get_wifi_channel(uint32_t node);
+ESPNOW_LINK_ERR_T sim_link_node_scan_channels(uint32_t node, uint32_t dwell_ms, ESPNOW_LINK_CHAN_SURVEY_T* survey);
+void sim_link_node_get_chan_stats(uint32_t node, ESPNOW_LINK_CHAN_STATS_T* stats);
+ESPNOW_LINK_ERR_T sim_link_node_get_peer_rate(uint32_t node, const uint8_t* peer_mac, ESPNOW_LINK_RATE_STATS_T* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ ********************************************************************************
+ * @file    sim_wt20.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   Separate copies of the real wt20 stack, one per simulated node. wt20_protocol.c keeps
+ *          its state in statics, so each node compiles its own copy (see sim_wt20_node.inc)
+ *          with the global names renamed, and reaches sim_link as that node. Include
+ *          sim_wt20_nodeN.h for every node a test uses, so its copy gets linked
+ ********************************************************************************
+ */
+
+#ifndef SIM_WT20_H
+#define SIM_WT20_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include <stdint.h>
+#include "wt20_protocol.h"
+#include "sim_link.h"
+
+/************************************
+ * TYPEDEFS
+ ************************************/
+
+/* a node's wt20_protocol.h functions */
+typedef struct
+{
+    uint32_t node;
+    WT20_ERR_T (*init)(void);
+    WT20_ERR_T (*deinit)(void);
+    WT20_ERR_T (*write)(const uint8_t* peer_mac, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length);
+    WT20_ERR_T (*send_message)(const uint8_t* peer_mac, const uint8_t* message, uint32_t length);
+    WT20_ERR_T (*send_message_reliable)(const uint8_t* peer_mac,
+                                        const uint8_t* message,
+                                        uint32_t length,
+                                        WT20_TRANSFER_DONE_CB_T done_callback,
+                                        void* context);
+    WT20_ERR_T (*set_stream_fec)(const WT20_FEC_CONFIG_T* config);
+    WT20_ERR_T (*write_stream)(const uint8_t* peer_mac, const uint8_t* frame, uint16_t length);
+    WT20_ERR_T (*next_voice_mode)(uint32_t queued_frames, ADPCM_MODE_T* mode);
+    WT20_ERR_T (*get_voice_rate_stats)(WT20_VRATE_STATS_T* stats, WT20_VRATE_RX_STATS_T* rx_stats);
+    WT20_ERR_T (*set_stream_callback)(WT20_STREAM_CB_T callback, void* context);
+    WT20_ERR_T (*set_message_callback)(WT20_MESSAGE_CB_T callback, void* context);
+    WT20_ERR_T (*receive)(const WT20_MSG_T* msg_buffer, uint32_t timeout_ms);
+    WT20_ERR_T (*receive_all)(WT20_MSG_HANDLER_T handler, void* context, uint32_t timeout_ms, uint32_t* processed);
+    WT20_ERR_T (*get_rx_stats)(WT20_RX_STATS_T* stats);
+    WT20_ERR_T (*add_peer)(const uint8_t* mac, WT20_PEER_ID_T* id);
+    WT20_ERR_T (*join_group)(uint8_t group, bool repair);
+    WT20_ERR_T (*write_group)(uint8_t group, const uint8_t* frame, uint16_t length);
+    WT20_ERR_T (*set_group_callback)(WT20_GROUP_CB_T callback, void* context);
+    WT20_ERR_T (*get_group_stats)(WT20_GROUP_STATS_T* stats);
+    WT20_ERR_T (*set_relay)(bool enabled);
+    WT20_ERR_T (*write_relayed)(const uint8_t* dest_mac, WT20_COMMAND_T command, const uint8_t* payload, uint16_t payload_length);
+    WT20_ERR_T (*get_relay_stats)(WT20_RELAY_STATS_T* stats);
+    WT20_ERR_T (*switch_channel)(uint8_t channel);
+    WT20_ERR_T (*auto_channel)(uint32_t dwell_ms, uint8_t* channel);
+    WT20_ERR_T (*get_chan_stats)(WT20_CHAN_STATS_T* stats);
+} SIM_WT20_T;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,11 @@
+/**
+ ********************************************************************************
+ * @file    sim_wt20_node0.c
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   wt20 stack of simulated node 0, see sim_wt20.h
+ ********************************************************************************
+ */
+
+#define SIM_WT20_NODE 0
+#include "sim_wt20_node.inc"
@@ -0,0 +1,31 @@
+/**
+ ********************************************************************************
+ * @file    sim_wt20_node0.h
+ * @author  Andrew Bevelhymer
+ * @date    2026/10/17
+ * @brief   wt20 stack of simulated node 0, see sim_wt20.h
+ ********************************************************************************
+ */
+
+#ifndef SIM_WT20_NODE0_H
+#define SIM_WT20_NODE0_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/************************************
+ * INCLUDES
+ ************************************/
+#include "sim_wt20.h"
+
+/************************************
+ * EXPORTED VARIABLES
+ ************************************/
+extern const SIM_WT20_T sim_wt20_node0;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
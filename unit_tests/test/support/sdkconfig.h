@@ -0,0 +1,2 @@
+
+/* empty stand-in for the generated sdkconfig.h, so defaults are used off target */
@@ -0,0 +1,371 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "adpcm.h"
+#include "gf256.h"
+#include "wt20_fec.h"
+
+#define TEST_BLOCKS (50U)
+#define TEST_SAMPLES (TEST_BLOCKS * ADPCM_BLOCK_SAMPLES)
+#define SAMPLE_RATE_HZ (16000U)
+#define BENCH_ROUNDS (200U)
+
+static int16_t input[TEST_SAMPLES];
+static int16_t output[TEST_SAMPLES];
+static int16_t reference[TEST_SAMPLES];
+static uint8_t blocks[TEST_BLOCKS][ADPCM_BLOCK_BYTES];
+
+/* textbook IMA step table and coder, sample by sample, to check the block coder against */
+static const int32_t ref_steps[89U] = {
+    7,     8,     9,     10,    11,    12,    13,    14,    16,    17,    19,    21,    23,    25,    28,
+    31,    34,    37,    41,    45,    50,    55,    60,    66,    73,    80,    88,    97,    107,   118,
+    130,   143,   157,   173,   190,   209,   230,   253,   279,   307,   337,   371,   408,   449,   494,
+    544,   598,   658,   724,   796,   876,   963,   1060,  1166,  1282,  1411,  1552,  1707,  1878,  2066,
+    2272,  2499,  2749,  3024,  3327,  3660,  4026,  4428,  4871,  5358,  5894,  6484,  7132,  7845,  8630,
+    9493,  10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767};
+static const int32_t ref_index_change[8U] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static uint8_t ref_encode(int32_t sample, int32_t* predictor, int32_t* index)
+{
+    int32_t step = ref_steps[*index];
+    int32_t diff = sample - *predictor;
+    int32_t sign = (diff < 0) ? 8 : 0;
+    int32_t code = 0;
+    int32_t vpdiff = step >> 3;
+
+    if (sign != 0)
+    {
+        diff = -diff;
+    }
+
+    if (diff >= step)
+    {
+        code = 4;
+        diff -= step;
+        vpdiff += step;
+    }
+
+    step >>= 1;
+
+    if (diff >= step)
+    {
+        code |= 2;
+        diff -= step;
+        vpdiff += step;
+    }
+
+    step >>= 1;
+
+    if (diff >= step)
+    {
+        code |= 1;
+        vpdiff += step;
+    }
+
+    *predictor += (sign != 0) ? -vpdiff : vpdiff;
+    *predictor = (*predictor > 32767) ? 32767 : ((*predictor < -32768) ? -32768 : *predictor);
+    *index += ref_index_change[code];
+    *index = (*index < 0) ? 0 : ((*index > 88) ? 88 : *index);
+
+    return (uint8_t)(code | sign);
+}
+
+/* speech like test signal, two integer sine oscillators with a slow amplitude swing */
+static void fill_input(void)
+{
+    int32_t x1 = 12000;
+    int32_t y1 = 0;
+    int32_t x2 = 4000;
+    int32_t y2 = 0;
+    int32_t envelope;
+    uint32_t i;
+
+    for (i = 0U; i < TEST_SAMPLES; i++)
+    {
+        x1 -= (3200 * y1) >> 15;
+        y1 += (3200 * x1) >> 15;
+        x2 -= (19000 * y2) >> 15;
+        y2 += (19000 * x2) >> 15;
+        envelope = (int32_t)((i % 8000U) < 4000U ? (i % 4000U) : (4000U - (i % 4000U)));
+        input[i] = (int16_t)((((y1 + y2) * (envelope + 1000)) / 5000));
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void encode_all(void)
+{
+    ADPCM_STATE_T state;
+    uint32_t b;
+
+    adpcm_init(&state);
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_BYTES,
+                              adpcm_encode_block(&state, &input[b * ADPCM_BLOCK_SAMPLES], ADPCM_BLOCK_SAMPLES, blocks[b]));
+    }
+}
+
+void setUp(void)
+{
+    fill_input();
+}
+
+void tearDown(void) { }
+
+void test_adpcm_block_fits_live_frame(void)
+{
+    TEST_ASSERT(ADPCM_BLOCK_BYTES <= WT20_FEC_MAX_FRAME_BYTES);
+    TEST_ASSERT_EQUAL_INT(0U, ADPCM_BLOCK_SAMPLES % (SAMPLE_RATE_HZ / 1000U));
+}
+
+void test_adpcm_matches_reference_coder_bit_for_bit(void)
+{
+    int32_t predictor = 0;
+    int32_t index = 0;
+    uint8_t code;
+    uint32_t b;
+    uint32_t i;
+
+    encode_all();
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        /* header holds coder state at start of block */
+        TEST_ASSERT_EQUAL_INT(predictor, (int16_t)(blocks[b][0] | (blocks[b][1] << 8)));
+        TEST_ASSERT_EQUAL_INT(index, blocks[b][2]);
+
+        for (i = 0U; i < ADPCM_BLOCK_SAMPLES; i++)
+        {
+            code = ref_encode(input[(b * ADPCM_BLOCK_SAMPLES) + i], &predictor, &index);
+            reference[(b * ADPCM_BLOCK_SAMPLES) + i] = (int16_t)predictor;
+            TEST_ASSERT_EQUAL_HEX8(code, (blocks[b][ADPCM_HDR_BYTES + (i / 2U)] >> ((i & 1U) * 4U)) & 0x0FU);
+        }
+    }
+
+    /* decoder reconstructs exactly what the encoder predicted */
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_SAMPLES,
+                              adpcm_decode_block(blocks[b], ADPCM_BLOCK_BYTES, &output[b * ADPCM_BLOCK_SAMPLES], NULL));
+    }
+
+    TEST_ASSERT_EQUAL_INT16_ARRAY(reference, output, TEST_SAMPLES);
+}
+
+void test_adpcm_blocks_decode_independently(void)
+{
+    ADPCM_STATE_T end_state;
+    int16_t alone[ADPCM_BLOCK_SAMPLES];
+    uint32_t b;
+
+    encode_all();
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        adpcm_decode_block(blocks[b], ADPCM_BLOCK_BYTES, &output[b * ADPCM_BLOCK_SAMPLES], &end_state);
+
+        /* end state of one block is the header of the next */
+        if ((b + 1U) < TEST_BLOCKS)
+        {
+            TEST_ASSERT_EQUAL_INT(end_state.predictor, (int16_t)(blocks[b + 1U][0] | (blocks[b + 1U][1] << 8)));
+            TEST_ASSERT_EQUAL_INT(end_state.step_index, blocks[b + 1U][2]);
+        }
+    }
+
+    /* every other block lost, the rest still decode to the same samples */
+    for (b = 1U; b < TEST_BLOCKS; b += 2U)
+    {
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_SAMPLES, adpcm_decode_block(blocks[b], ADPCM_BLOCK_BYTES, alone, NULL));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(&output[b * ADPCM_BLOCK_SAMPLES], alone, ADPCM_BLOCK_SAMPLES);
+    }
+}
+
+void test_adpcm_quality(void)
+{
+    int64_t signal = 0;
+    int64_t noise = 0;
+    int32_t error;
+    uint32_t b;
+    uint32_t i;
+
+    encode_all();
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        adpcm_decode_block(blocks[b], ADPCM_BLOCK_BYTES, &output[b * ADPCM_BLOCK_SAMPLES], NULL);
+    }
+
+    for (i = 0U; i < TEST_SAMPLES; i++)
+    {
+        error = (int32_t)input[i] - (int32_t)output[i];
+        signal += (int64_t)input[i] * input[i];
+        noise += (int64_t)error * error;
+    }
+
+    printf("adpcm snr: signal / noise = %u\n", (unsigned)(signal / (noise + 1)));
+
+    /* better than 20 dB */
+    TEST_ASSERT(signal > (100 * noise));
+}
+
+/* signal to noise of input coded a block at a time in mode, as a plain ratio */
+static uint32_t mode_snr(ADPCM_MODE_T mode)
+{
+    ADPCM_STATE_T state;
+    int64_t signal = 0;
+    int64_t noise = 0;
+    int32_t error;
+    uint32_t b;
+    uint32_t i;
+
+    adpcm_init(&state);
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        TEST_ASSERT_EQUAL_INT(adpcm_block_bytes(mode, ADPCM_BLOCK_SAMPLES),
+                              adpcm_encode_block_mode(&state, mode, &input[b * ADPCM_BLOCK_SAMPLES], ADPCM_BLOCK_SAMPLES, blocks[b]));
+        TEST_ASSERT_EQUAL(mode, adpcm_block_mode(blocks[b], adpcm_block_bytes(mode, ADPCM_BLOCK_SAMPLES)));
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_SAMPLES,
+                              adpcm_decode_block(blocks[b], adpcm_block_bytes(mode, ADPCM_BLOCK_SAMPLES), &output[b * ADPCM_BLOCK_SAMPLES], NULL));
+    }
+
+    for (i = 0U; i < TEST_SAMPLES; i++)
+    {
+        error = (int32_t)input[i] - (int32_t)output[i];
+        signal += (int64_t)input[i] * input[i];
+        noise += (int64_t)error * error;
+    }
+
+    return (uint32_t)(signal / (noise + 1));
+}
+
+void test_adpcm_modes_trade_quality_for_size(void)
+{
+    uint32_t snr_16k = mode_snr(ADPCM_MODE_16K);
+    uint32_t snr_8k = mode_snr(ADPCM_MODE_8K);
+    uint32_t snr_2bit = mode_snr(ADPCM_MODE_8K_2BIT);
+
+    printf("adpcm snr by mode: 16k %u, 8k %u, 8k 2 bit %u\n", (unsigned)snr_16k, (unsigned)snr_8k, (unsigned)snr_2bit);
+
+    TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_BYTES, adpcm_block_bytes(ADPCM_MODE_16K, ADPCM_BLOCK_SAMPLES));
+    TEST_ASSERT_EQUAL_INT(ADPCM_8K_BLOCK_BYTES, adpcm_block_bytes(ADPCM_MODE_8K, ADPCM_BLOCK_SAMPLES));
+    TEST_ASSERT_EQUAL_INT(ADPCM_8K_2BIT_BLOCK_BYTES, adpcm_block_bytes(ADPCM_MODE_8K_2BIT, ADPCM_BLOCK_SAMPLES));
+
+    /* each mode down is worse but still intelligible, better than 13 dB at 8 kHz and 7 dB at 2 bits */
+    TEST_ASSERT(snr_16k > snr_8k);
+    TEST_ASSERT(snr_8k > snr_2bit);
+    TEST_ASSERT(snr_8k > 20U);
+    TEST_ASSERT(snr_2bit > 5U);
+}
+
+void test_adpcm_mode_can_change_every_block(void)
+{
+    ADPCM_STATE_T encoder;
+    ADPCM_STATE_T decoder;
+    uint8_t padded[ADPCM_BLOCK_BYTES];
+    uint16_t length;
+    uint32_t b;
+
+    /* the decoder follows each block's own mode, with fec padding every frame to full length */
+    adpcm_init(&encoder);
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        ADPCM_MODE_T mode = (ADPCM_MODE_T)(b % (uint32_t)ADPCM_MODES);
+
+        length = adpcm_encode_block_mode(&encoder, mode, &input[b * ADPCM_BLOCK_SAMPLES], ADPCM_BLOCK_SAMPLES, blocks[b]);
+        memset(padded, 0xA5, sizeof(padded));
+        memcpy(padded, blocks[b], length);
+
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_SAMPLES,
+                              adpcm_decode_block(blocks[b], length, &reference[b * ADPCM_BLOCK_SAMPLES], &decoder));
+        TEST_ASSERT_EQUAL_INT(ADPCM_BLOCK_SAMPLES,
+                              adpcm_decode_block(padded, sizeof(padded), &output[b * ADPCM_BLOCK_SAMPLES], NULL));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(&reference[b * ADPCM_BLOCK_SAMPLES], &output[b * ADPCM_BLOCK_SAMPLES], ADPCM_BLOCK_SAMPLES);
+
+        /* the coder state carries straight over a mode change */
+        TEST_ASSERT_EQUAL_INT(encoder.predictor, decoder.predictor);
+        TEST_ASSERT_EQUAL_INT(encoder.step_index, decoder.step_index);
+    }
+
+    /* a half decoded block at 8 kHz still comes out as 16 kHz, an unknown mode not at all */
+    adpcm_init(&encoder);
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_encode_block_mode(&encoder, ADPCM_MODE_8K_2BIT, input, 12U, padded));
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_encode_block_mode(&encoder, ADPCM_MODES, input, 16U, padded));
+    TEST_ASSERT_EQUAL_INT(ADPCM_HDR_BYTES + 4U, adpcm_encode_block_mode(&encoder, ADPCM_MODE_8K, input, 16U, padded));
+    TEST_ASSERT_EQUAL_INT(16U, adpcm_decode_block(padded, ADPCM_HDR_BYTES + 4U, output, NULL));
+    padded[3] = (uint8_t)ADPCM_MODES;
+    TEST_ASSERT_EQUAL(ADPCM_MODES, adpcm_block_mode(padded, ADPCM_HDR_BYTES + 4U));
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_decode_block(padded, ADPCM_HDR_BYTES + 4U, output, NULL));
+}
+
+void test_adpcm_rejects_bad_input(void)
+{
+    ADPCM_STATE_T state;
+    uint8_t block[ADPCM_BLOCK_BYTES + 2U];
+
+    adpcm_init(&state);
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_encode_block(&state, input, 3U, block));
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_encode_block(&state, input, ADPCM_BLOCK_SAMPLES + 2U, block));
+
+    TEST_ASSERT_EQUAL_INT(ADPCM_HDR_BYTES + 5U, adpcm_encode_block(&state, input, 10U, block));
+    TEST_ASSERT_EQUAL_INT(10U, adpcm_decode_block(block, ADPCM_HDR_BYTES + 5U, output, NULL));
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_decode_block(block, ADPCM_HDR_BYTES - 1U, output, NULL));
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_decode_block(block, ADPCM_BLOCK_BYTES + 1U, output, NULL));
+
+    block[2] = ADPCM_MAX_STEP_INDEX + 1U;
+    TEST_ASSERT_EQUAL_INT(0U, adpcm_decode_block(block, ADPCM_HDR_BYTES + 5U, output, NULL));
+}
+
+void test_adpcm_benchmark(void)
+{
+    uint64_t start;
+    uint64_t encode_ns;
+    uint64_t decode_ns;
+    uint64_t samples = (uint64_t)BENCH_ROUNDS * TEST_SAMPLES;
+    uint64_t encode_rate;
+    uint64_t decode_rate;
+    uint32_t r;
+    uint32_t b;
+
+    start = now_ns();
+    for (r = 0U; r < BENCH_ROUNDS; r++)
+    {
+        encode_all();
+    }
+    encode_ns = now_ns() - start;
+
+    start = now_ns();
+    for (r = 0U; r < BENCH_ROUNDS; r++)
+    {
+        for (b = 0U; b < TEST_BLOCKS; b++)
+        {
+            adpcm_decode_block(blocks[b], ADPCM_BLOCK_BYTES, &output[b * ADPCM_BLOCK_SAMPLES], NULL);
+        }
+    }
+    decode_ns = now_ns() - start;
+
+    encode_rate = (samples * 1000000000ULL) / (encode_ns + 1U);
+    decode_rate = (samples * 1000000000ULL) / (decode_ns + 1U);
+
+    printf("adpcm encode %u samples/s (%ux real time), decode %u samples/s (%ux real time)\n",
+           (unsigned)encode_rate,
+           (unsigned)(encode_rate / SAMPLE_RATE_HZ),
+           (unsigned)decode_rate,
+           (unsigned)(decode_rate / SAMPLE_RATE_HZ));
+
+    /* leaves plenty of headroom for a core far slower than the host */
+    TEST_ASSERT(encode_rate > (100U * SAMPLE_RATE_HZ));
+    TEST_ASSERT(decode_rate > (100U * SAMPLE_RATE_HZ));
+}
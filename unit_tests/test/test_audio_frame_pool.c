@@ -0,0 +1,106 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "audio_frame_pool.h"
+#include "mem_pool.h"
+
+static AUDIO_FRAME_POOL_T pool;
+static AUDIO_FRAME_QUEUE_T queue;
+
+void setUp(void)
+{
+    audio_frame_pool_init(&pool);
+    audio_frame_queue_init(&queue);
+}
+
+void tearDown(void) { }
+
+void test_audio_frame_pool_hands_out_every_frame_once(void)
+{
+    AUDIO_FRAME_T* frames[AUDIO_FRAME_POOL_FRAMES];
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < AUDIO_FRAME_POOL_FRAMES; i++)
+    {
+        frames[i] = audio_frame_pool_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(frames[i]);
+
+        for (j = 0U; j < i; j++)
+        {
+            TEST_ASSERT(frames[i] != frames[j]);
+        }
+    }
+
+    TEST_ASSERT_NULL(audio_frame_pool_alloc(&pool));
+    TEST_ASSERT_EQUAL_INT(1U, pool.blocks.alloc_failures);
+    TEST_ASSERT_EQUAL_INT(AUDIO_FRAME_POOL_FRAMES, pool.blocks.high_water);
+    TEST_ASSERT_EQUAL_INT(0U, audio_frame_pool_available(&pool));
+
+    /* freed frame is the one handed out next */
+    audio_frame_pool_free(&pool, frames[3]);
+    TEST_ASSERT_EQUAL_INT(1U, audio_frame_pool_available(&pool));
+    TEST_ASSERT_EQUAL_PTR(frames[3], audio_frame_pool_alloc(&pool));
+}
+
+void test_audio_frame_pool_ignores_foreign_frames(void)
+{
+    AUDIO_FRAME_T other;
+    AUDIO_FRAME_T* frame = audio_frame_pool_alloc(&pool);
+
+    audio_frame_pool_free(&pool, &other);
+    audio_frame_pool_free(&pool, NULL);
+    TEST_ASSERT_EQUAL_INT(AUDIO_FRAME_POOL_FRAMES - 1U, audio_frame_pool_available(&pool));
+
+    audio_frame_pool_free(&pool, frame);
+    TEST_ASSERT_EQUAL_INT(AUDIO_FRAME_POOL_FRAMES, audio_frame_pool_available(&pool));
+    TEST_ASSERT_EQUAL_INT(1U, pool.blocks.high_water);
+}
+
+void test_audio_frame_queue_passes_pointers_in_order(void)
+{
+    AUDIO_FRAME_T* frame;
+    uint32_t round;
+    uint32_t i;
+
+    /* enough rounds for head and tail to wrap the queue several times */
+    for (round = 0U; round < (4U * AUDIO_FRAME_QUEUE_DEPTH); round++)
+    {
+        for (i = 0U; i < AUDIO_FRAME_POOL_FRAMES; i++)
+        {
+            frame = audio_frame_pool_alloc(&pool);
+            frame->seq = (round * AUDIO_FRAME_POOL_FRAMES) + i;
+            TEST_ASSERT(audio_frame_queue_push(&queue, frame));
+        }
+
+        TEST_ASSERT_EQUAL_INT(AUDIO_FRAME_POOL_FRAMES, audio_frame_queue_count(&queue));
+
+        for (i = 0U; i < AUDIO_FRAME_POOL_FRAMES; i++)
+        {
+            frame = audio_frame_queue_pop(&queue);
+            TEST_ASSERT_NOT_NULL(frame);
+            TEST_ASSERT_EQUAL_INT((round * AUDIO_FRAME_POOL_FRAMES) + i, frame->seq);
+            audio_frame_pool_free(&pool, frame);
+        }
+
+        TEST_ASSERT_NULL(audio_frame_queue_pop(&queue));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0U, pool.blocks.alloc_failures);
+}
+
+void test_audio_frame_queue_full(void)
+{
+    AUDIO_FRAME_T frame;
+    uint32_t i;
+
+    for (i = 0U; i < AUDIO_FRAME_QUEUE_DEPTH; i++)
+    {
+        TEST_ASSERT(audio_frame_queue_push(&queue, &frame));
+    }
+
+    TEST_ASSERT_FALSE(audio_frame_queue_push(&queue, &frame));
+    TEST_ASSERT_EQUAL_PTR(&frame, audio_frame_queue_pop(&queue));
+    TEST_ASSERT(audio_frame_queue_push(&queue, &frame));
+}
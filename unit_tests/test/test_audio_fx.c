@@ -0,0 +1,276 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "audio_fx.h"
+#include "mock_timing.h"
+
+#define FRAME_SAMPLES (AUDIO_FRAME_SAMPLES)
+#define ONE_SECOND_FRAMES (AUDIO_SAMPLE_RATE_HZ / FRAME_SAMPLES)
+#define FRAME_PERIOD_NS ((uint64_t)AUDIO_FRAME_PERIOD_US * 1000U)
+#define BENCH_FRAMES (2000U)
+
+static AUDIO_FX_T fx;
+static int16_t frame[FRAME_SAMPLES];
+
+/* host stand-in for the cycle counter, so chain stats hold host nanoseconds */
+static uint32_t host_cycles(int num_calls)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec);
+}
+
+/* integer oscillator, coefficient is 2 sin(pi f / rate) in Q15 */
+typedef struct
+{
+    int32_t x;
+    int32_t y;
+    int32_t coefficient;
+} OSCILLATOR_T;
+
+static void oscillator_fill(OSCILLATOR_T* osc, int16_t* pcm, uint32_t samples)
+{
+    uint32_t i;
+
+    for (i = 0U; i < samples; i++)
+    {
+        osc->x -= (osc->coefficient * osc->y) >> 15;
+        osc->y += (osc->coefficient * osc->x) >> 15;
+        pcm[i] = (int16_t)osc->y;
+    }
+}
+
+static uint32_t count_rising_zero_crossings(const int16_t* pcm, uint32_t samples, int16_t* previous)
+{
+    uint32_t crossings = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < samples; i++)
+    {
+        crossings += ((*previous < 0) && (pcm[i] >= 0)) ? 1U : 0U;
+        *previous = pcm[i];
+    }
+
+    return crossings;
+}
+
+/* runs a second of tone through chain and returns output frequency, skipping the first frame while grains fill */
+static uint32_t output_frequency(AUDIO_FX_CHAIN_T chain, int32_t coefficient)
+{
+    OSCILLATOR_T osc = {.x = 0, .y = 12000, .coefficient = coefficient};
+    int16_t previous = 0;
+    uint32_t crossings = 0U;
+    uint32_t f;
+
+    TEST_ASSERT(audio_fx_select(&fx, chain));
+
+    for (f = 0U; f <= ONE_SECOND_FRAMES; f++)
+    {
+        oscillator_fill(&osc, frame, FRAME_SAMPLES);
+        audio_fx_process(&fx, frame, FRAME_SAMPLES);
+
+        if (f > 0U)
+        {
+            crossings += count_rising_zero_crossings(frame, FRAME_SAMPLES, &previous);
+        }
+        else
+        {
+            previous = frame[FRAME_SAMPLES - 1U];
+        }
+    }
+
+    return (crossings * AUDIO_SAMPLE_RATE_HZ) / (ONE_SECOND_FRAMES * FRAME_SAMPLES);
+}
+
+void setUp(void)
+{
+    timing_get_cycles_IgnoreAndReturn(0U);
+    audio_fx_init(&fx);
+}
+
+void tearDown(void) { }
+
+void test_audio_fx_none_leaves_frame_alone(void)
+{
+    int16_t expected[FRAME_SAMPLES];
+    OSCILLATOR_T osc = {.x = 0, .y = 20000, .coefficient = 4000};
+
+    oscillator_fill(&osc, frame, FRAME_SAMPLES);
+    memcpy(expected, frame, sizeof(frame));
+
+    audio_fx_process(&fx, frame, FRAME_SAMPLES);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, frame, FRAME_SAMPLES);
+    TEST_ASSERT_FALSE(audio_fx_select(&fx, AUDIO_FX_CHAIN_COUNT));
+}
+
+void test_audio_fx_robot_modulates_at_carrier(void)
+{
+    int16_t previous = 0;
+    uint32_t crossings = 0U;
+    uint32_t f;
+    uint32_t i;
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_ROBOT));
+
+    /* dc in, carrier out */
+    for (f = 0U; f < ONE_SECOND_FRAMES; f++)
+    {
+        for (i = 0U; i < FRAME_SAMPLES; i++)
+        {
+            frame[i] = 20000;
+        }
+
+        audio_fx_process(&fx, frame, FRAME_SAMPLES);
+        crossings += count_rising_zero_crossings(frame, FRAME_SAMPLES, &previous);
+    }
+
+    TEST_ASSERT_UINT32_WITHIN(2U, AUDIO_FX_RING_MOD_HZ, crossings);
+    TEST_ASSERT_EQUAL_INT(ONE_SECOND_FRAMES, fx.stats[AUDIO_FX_ROBOT].frames);
+}
+
+void test_audio_fx_echo_repeats_impulse(void)
+{
+    enum { OUT_SAMPLES = (AUDIO_FX_ECHO_SAMPLES * 3U) };
+    int16_t out[OUT_SAMPLES];
+    uint32_t i;
+
+    memset(out, 0, sizeof(out));
+    out[0] = 30000;
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_ECHO));
+
+    for (i = 0U; i < OUT_SAMPLES; i += FRAME_SAMPLES)
+    {
+        audio_fx_process(&fx, &out[i], (uint16_t)(((OUT_SAMPLES - i) < FRAME_SAMPLES) ? (OUT_SAMPLES - i) : FRAME_SAMPLES));
+    }
+
+    TEST_ASSERT_EQUAL_INT(30000, out[0]);
+    TEST_ASSERT_EQUAL_INT((30000 * AUDIO_FX_ECHO_FEEDBACK_Q15) >> 15, out[AUDIO_FX_ECHO_SAMPLES]);
+    TEST_ASSERT_EQUAL_INT((((30000 * AUDIO_FX_ECHO_FEEDBACK_Q15) >> 15) * AUDIO_FX_ECHO_FEEDBACK_Q15) >> 15,
+                          out[2U * AUDIO_FX_ECHO_SAMPLES]);
+    TEST_ASSERT_EQUAL_INT(0, out[1]);
+    TEST_ASSERT_EQUAL_INT(0, out[AUDIO_FX_ECHO_SAMPLES - 1U]);
+}
+
+void test_audio_fx_echo_saturates_instead_of_wrapping(void)
+{
+    uint32_t f;
+    uint32_t i;
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_ECHO));
+
+    for (f = 0U; f < (2U * ONE_SECOND_FRAMES); f++)
+    {
+        for (i = 0U; i < FRAME_SAMPLES; i++)
+        {
+            frame[i] = 30000;
+        }
+
+        audio_fx_process(&fx, frame, FRAME_SAMPLES);
+
+        /* dc plus its echo is past full scale */
+        for (i = 0U; i < FRAME_SAMPLES; i++)
+        {
+            TEST_ASSERT_EQUAL_INT((((f * FRAME_SAMPLES) + i) < AUDIO_FX_ECHO_SAMPLES) ? 30000 : INT16_MAX, frame[i]);
+        }
+    }
+}
+
+void test_audio_fx_chipmunk_raises_pitch(void)
+{
+    /* 500 Hz in, 750 Hz out */
+    uint32_t in_hz = output_frequency(AUDIO_FX_NONE, 6423);
+    uint32_t out_hz = output_frequency(AUDIO_FX_CHIPMUNK, 6423);
+
+    TEST_ASSERT_UINT32_WITHIN(5U, 500U, in_hz);
+    TEST_ASSERT_UINT32_WITHIN(25U, (in_hz * AUDIO_FX_PITCH_RATIO_Q16) >> 16, out_hz);
+}
+
+void test_audio_fx_tremolo_swings_gain(void)
+{
+    int32_t lowest = INT16_MAX;
+    int32_t highest = 0;
+    uint32_t f;
+    uint32_t i;
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_TREMOLO));
+
+    for (f = 0U; f < ONE_SECOND_FRAMES; f++)
+    {
+        for (i = 0U; i < FRAME_SAMPLES; i++)
+        {
+            frame[i] = 20000;
+        }
+
+        audio_fx_process(&fx, frame, FRAME_SAMPLES);
+
+        for (i = 0U; i < FRAME_SAMPLES; i++)
+        {
+            lowest = (frame[i] < lowest) ? frame[i] : lowest;
+            highest = (frame[i] > highest) ? frame[i] : highest;
+        }
+    }
+
+    TEST_ASSERT_INT_WITHIN(100, 20000, highest);
+    TEST_ASSERT_INT_WITHIN(100, 20000 - ((20000 * AUDIO_FX_TREMOLO_DEPTH_Q15) >> 15), lowest);
+}
+
+void test_audio_fx_select_clears_delay_lines(void)
+{
+    uint32_t f;
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_ECHO));
+    memset(frame, 0, sizeof(frame));
+    frame[0] = 30000;
+    audio_fx_process(&fx, frame, FRAME_SAMPLES);
+
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_TREMOLO));
+    TEST_ASSERT(audio_fx_select(&fx, AUDIO_FX_ECHO));
+
+    /* old impulse isn't echoed */
+    for (f = 0U; f < ((AUDIO_FX_ECHO_SAMPLES / FRAME_SAMPLES) + 2U); f++)
+    {
+        memset(frame, 0, sizeof(frame));
+        audio_fx_process(&fx, frame, FRAME_SAMPLES);
+        TEST_ASSERT_EACH_EQUAL_INT16(0, frame, FRAME_SAMPLES);
+    }
+}
+
+void test_audio_fx_benchmark(void)
+{
+    static const char* names[AUDIO_FX_CHAIN_COUNT] = {
+        "none", "robot", "echo", "chipmunk", "tremolo", "robot+echo", "chipmunk+echo", "chipmunk+tremolo"};
+    OSCILLATOR_T osc = {.x = 0, .y = 12000, .coefficient = 6423};
+    uint32_t chain;
+    uint32_t f;
+    uint64_t average;
+
+    timing_get_cycles_StubWithCallback(host_cycles);
+
+    printf("chain              host ns/frame (avg)  max   %% of %u us frame\n", (unsigned)AUDIO_FRAME_PERIOD_US);
+
+    for (chain = AUDIO_FX_ROBOT; chain < AUDIO_FX_CHAIN_COUNT; chain++)
+    {
+        TEST_ASSERT(audio_fx_select(&fx, (AUDIO_FX_CHAIN_T)chain));
+
+        for (f = 0U; f < BENCH_FRAMES; f++)
+        {
+            oscillator_fill(&osc, frame, FRAME_SAMPLES);
+            audio_fx_process(&fx, frame, FRAME_SAMPLES);
+        }
+
+        average = fx.stats[chain].total_cycles / fx.stats[chain].frames;
+        printf("%-18s %19u  %5u  %.3f%%\n",
+               names[chain],
+               (unsigned)average,
+               (unsigned)fx.stats[chain].max_cycles,
+               (double)average * 100.0 / (double)FRAME_PERIOD_NS);
+
+        /* a small slice of the frame, even allowing for a much slower target core */
+        TEST_ASSERT(average < (FRAME_PERIOD_NS / 100U));
+    }
+}
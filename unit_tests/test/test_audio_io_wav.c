@@ -0,0 +1,189 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_frame_pool.h"
+#include "mem_pool.h"
+#include "audio_io.h"
+#include "audio_io_wav.h"
+
+#define INPUT_PATH "build/test_audio_io_in.wav"
+#define OUTPUT_PATH "build/test_audio_io_out.wav"
+
+#define TEST_FRAMES (25U)
+
+/* deterministic test signal, a ramp that differs from frame to frame */
+static int16_t test_sample(uint32_t frame, uint32_t sample)
+{
+    return (int16_t)((int32_t)(((frame * 7919U) + (sample * 37U)) % 65536U) - 32768);
+}
+
+/* writes test signal through playback, which leaves a WAV file to capture from */
+static void write_test_input(void)
+{
+    AUDIO_FRAME_T* frame;
+    uint32_t i;
+    uint32_t j;
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(NULL, INPUT_PATH));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    for (i = 0U; i < TEST_FRAMES; i++)
+    {
+        frame = audio_io_frame_alloc();
+        TEST_ASSERT_NOT_NULL(frame);
+
+        for (j = 0U; j < AUDIO_FRAME_SAMPLES; j++)
+        {
+            frame->pcm[j] = test_sample(i, j);
+        }
+
+        TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(frame));
+        audio_io_wav_tick();
+    }
+
+    audio_io_wav_close();
+    audio_io_stop();
+}
+
+void setUp(void)
+{
+    write_test_input();
+}
+
+void tearDown(void)
+{
+    audio_io_wav_close();
+    remove(INPUT_PATH);
+    remove(OUTPUT_PATH);
+}
+
+void test_audio_io_wav_capture_reads_frames_in_order(void)
+{
+    AUDIO_FRAME_T* frame;
+    AUDIO_IO_STATS_T stats;
+    uint32_t count = 0U;
+    uint32_t j;
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(INPUT_PATH, NULL));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    while ((frame = audio_io_capture_get(AUDIO_IO_WAIT_FOREVER)) != NULL)
+    {
+        TEST_ASSERT_EQUAL_INT(count, frame->seq);
+        TEST_ASSERT_EQUAL_INT(count * AUDIO_FRAME_PERIOD_US, frame->timestamp_us);
+
+        for (j = 0U; j < AUDIO_FRAME_SAMPLES; j++)
+        {
+            TEST_ASSERT_EQUAL_INT(test_sample(count, j), frame->pcm[j]);
+        }
+
+        audio_io_frame_release(frame);
+        count++;
+    }
+
+    audio_io_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(TEST_FRAMES, count);
+    TEST_ASSERT_EQUAL_INT(TEST_FRAMES, stats.frames_captured);
+    TEST_ASSERT_EQUAL_INT(0U, stats.capture_overruns);
+    TEST_ASSERT(audio_io_wav_capture_done());
+}
+
+void test_audio_io_wav_loopback_plays_captured_frames_without_copying(void)
+{
+    AUDIO_FRAME_T* frame;
+    AUDIO_IO_STATS_T stats;
+    uint32_t count = 0U;
+    uint32_t j;
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(INPUT_PATH, OUTPUT_PATH));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    /* captured frame goes straight back out, same buffer */
+    while ((frame = audio_io_capture_get(AUDIO_IO_WAIT_FOREVER)) != NULL)
+    {
+        TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(frame));
+    }
+
+    audio_io_wav_close();
+    audio_io_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(TEST_FRAMES, stats.frames_played);
+    TEST_ASSERT_EQUAL_INT(0U, stats.playback_underruns);
+    TEST_ASSERT_EQUAL_INT(0U, stats.capture_overruns);
+
+    /* one frame in capture, one in playback, never more */
+    TEST_ASSERT_EQUAL_INT(2U, stats.pool_high_water);
+    audio_io_stop();
+
+    /* output lags input by one frame period, the frame played while the first was captured */
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(OUTPUT_PATH, NULL));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    frame = audio_io_capture_get(AUDIO_IO_WAIT_FOREVER);
+    TEST_ASSERT_NOT_NULL(frame);
+    TEST_ASSERT_EACH_EQUAL_INT16(0, frame->pcm, AUDIO_FRAME_SAMPLES);
+    audio_io_frame_release(frame);
+
+    while ((frame = audio_io_capture_get(AUDIO_IO_WAIT_FOREVER)) != NULL)
+    {
+        for (j = 0U; j < AUDIO_FRAME_SAMPLES; j++)
+        {
+            TEST_ASSERT_EQUAL_INT(test_sample(count, j), frame->pcm[j]);
+        }
+
+        audio_io_frame_release(frame);
+        count++;
+    }
+
+    TEST_ASSERT_EQUAL_INT(TEST_FRAMES, count);
+}
+
+void test_audio_io_wav_counts_underruns_and_overruns(void)
+{
+    AUDIO_IO_STATS_T stats;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(INPUT_PATH, OUTPUT_PATH));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    /* nobody reads capture, so once every pool frame is queued the rest are dropped */
+    for (i = 0U; i < (AUDIO_FRAME_POOL_FRAMES + 2U); i++)
+    {
+        audio_io_wav_tick();
+    }
+
+    audio_io_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(AUDIO_FRAME_POOL_FRAMES, stats.frames_captured);
+    TEST_ASSERT_EQUAL_INT(2U, stats.capture_overruns);
+    TEST_ASSERT_EQUAL_INT(2U, stats.pool_alloc_failures);
+    TEST_ASSERT_EQUAL_INT(0U, stats.playback_underruns);
+
+    /* two frames played, then playback runs dry once */
+    audio_io_frame_release(audio_io_capture_get(0U));
+    audio_io_frame_release(audio_io_capture_get(0U));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(audio_io_frame_alloc()));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(audio_io_frame_alloc()));
+    TEST_ASSERT_EQUAL_INT(2U, audio_io_playback_queued());
+
+    for (i = 0U; i < 4U; i++)
+    {
+        audio_io_wav_tick();
+    }
+
+    audio_io_get_stats(&stats);
+    TEST_ASSERT_EQUAL_INT(2U, stats.frames_played);
+    TEST_ASSERT_EQUAL_INT(1U, stats.playback_underruns);
+}
+
+void test_audio_io_wav_rejects_missing_file(void)
+{
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT_FALSE(audio_io_wav_open("build/no_such_file.wav", NULL));
+    TEST_ASSERT(audio_io_wav_capture_done());
+}
@@ -0,0 +1,377 @@
+#include "unity.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio_vad.h"
+#include "adpcm.h"
+#include "jitter_buffer.h"
+#include "audio_frame_pool.h"
+#include "mem_pool.h"
+#include "audio_io.h"
+#include "audio_io_wav.h"
+
+#define CLIP_PATH "build/test_audio_vad_clip.wav"
+#define OUT_PATH "build/test_audio_vad_out.wav"
+
+/* 12 s of talking with pauses, as a push to talk press might hold */
+#define CLIP_FRAMES (414U)
+#define CLIP_SAMPLES (CLIP_FRAMES * AUDIO_FRAME_SAMPLES)
+
+#define PI_F (3.14159265f)
+
+typedef struct
+{
+    const char* name;
+    float noise;              /* mean absolute amplitude of background noise */
+    float voice;              /* peak of voiced speech */
+    float breath;             /* of fricatives and breaths, as a fraction of voice */
+} CLIP_T;
+
+typedef struct
+{
+    uint32_t speech_frames;   /* frames with the talker clearly over the background, as synthesized */
+    uint32_t missed;          /* of those, not sent */
+    uint32_t sent;
+    uint32_t sids;
+    uint32_t bytes;
+    uint32_t idle;            /* receiver went quiet mid clip */
+} CLIP_RESULT_T;
+
+static AUDIO_VAD_T vad;
+static JITTER_BUFFER_T jb;
+static int16_t clip[CLIP_SAMPLES];
+static bool speech[CLIP_FRAMES];
+static int16_t pcm[AUDIO_FRAME_SAMPLES];
+
+static uint32_t xorshift(uint32_t* s)
+{
+    *s ^= *s << 13U;
+    *s ^= *s >> 17U;
+    *s ^= *s << 5U;
+    return *s;
+}
+
+/* uniform from -1 to 1 */
+static float noise(uint32_t* s)
+{
+    return ((float)(xorshift(s) >> 8U) / 8388608.0f) - 1.0f;
+}
+
+/* phrases of 2 to 5 syllables with pauses between, over steady background noise. A syllable is
+   a vowel, harmonics of a gliding pitch shaped by two formants, sometimes with a fricative hiss
+   after it, and phrases end with a breath. speech[] marks frames where the talker is at least
+   twice as loud as the background */
+static void make_clip(const CLIP_T* c, uint32_t seed)
+{
+    static float voice[CLIP_SAMPLES];
+    float lowpass = 0.0f;
+    float phase = 0.0f;
+    float level;
+    float x;
+    uint32_t i = AUDIO_SAMPLE_RATE_HZ;   /* a second of room tone first */
+    uint32_t end;
+    uint32_t syllables;
+    uint32_t n;
+    uint32_t f;
+    uint32_t h;
+
+    memset(voice, 0, sizeof(voice));
+
+    while (i < (CLIP_SAMPLES - AUDIO_SAMPLE_RATE_HZ))
+    {
+        syllables = 2U + (xorshift(&seed) % 4U);
+
+        for (; (syllables > 0U) && (i < (CLIP_SAMPLES - AUDIO_SAMPLE_RATE_HZ)); syllables--)
+        {
+            float pitch = 110.0f + (float)(xorshift(&seed) % 90U);
+            float f1 = 400.0f + (float)(xorshift(&seed) % 500U);
+            float f2 = 1200.0f + (float)(xorshift(&seed) % 1200U);
+            uint32_t length = (AUDIO_SAMPLE_RATE_HZ / 7U) + (xorshift(&seed) % (AUDIO_SAMPLE_RATE_HZ / 6U));
+
+            for (n = 0U; n < length; n++)
+            {
+                float env = sinf((PI_F * (float)n) / (float)length);
+                float hz = pitch * (1.0f + (0.15f * (float)n / (float)length));
+                float sum = 0.0f;
+
+                phase += (2.0f * PI_F * hz) / (float)AUDIO_SAMPLE_RATE_HZ;
+                phase = (phase > (2.0f * PI_F)) ? (phase - (2.0f * PI_F)) : phase;
+
+                for (h = 1U; (h * hz) < 3500.0f; h++)
+                {
+                    float fh = (float)h * hz;
+                    float gain = (1.0f / (1.0f + (((fh - f1) * (fh - f1)) / 40000.0f))) +
+                                 (0.5f / (1.0f + (((fh - f2) * (fh - f2)) / 90000.0f)));
+                    sum += gain * sinf(phase * (float)h);
+                }
+
+                voice[i + n] = c->voice * 0.4f * env * sum;
+            }
+
+            i += length;
+
+            if ((xorshift(&seed) % 3U) == 0U)
+            {
+                /* fricative, high passed hiss */
+                length = (AUDIO_SAMPLE_RATE_HZ / 12U) + (xorshift(&seed) % (AUDIO_SAMPLE_RATE_HZ / 12U));
+
+                for (n = 0U; n < length; n++)
+                {
+                    x = noise(&seed);
+                    lowpass += 0.3f * (x - lowpass);
+                    voice[i + n] = c->voice * c->breath * sinf((PI_F * (float)n) / (float)length) * (x - lowpass);
+                }
+
+                i += length;
+            }
+
+            i += (AUDIO_SAMPLE_RATE_HZ / 25U) + (xorshift(&seed) % (AUDIO_SAMPLE_RATE_HZ / 12U));
+        }
+
+        /* breath, low and broad, then a pause of 0.4 to 1.6 s */
+        end = i + (AUDIO_SAMPLE_RATE_HZ / 5U);
+
+        for (n = 0U; (i < end) && (i < CLIP_SAMPLES); i++, n++)
+        {
+            voice[i] = c->voice * c->breath * 0.3f * sinf((PI_F * (float)n) / (float)(AUDIO_SAMPLE_RATE_HZ / 5U)) * noise(&seed);
+        }
+
+        i += (2U * AUDIO_SAMPLE_RATE_HZ / 5U) + (xorshift(&seed) % (6U * AUDIO_SAMPLE_RATE_HZ / 5U));
+    }
+
+    for (f = 0U; f < CLIP_FRAMES; f++)
+    {
+        level = 0.0f;
+
+        for (n = 0U; n < AUDIO_FRAME_SAMPLES; n++)
+        {
+            i = (f * AUDIO_FRAME_SAMPLES) + n;
+            level += fabsf(voice[i]);
+
+            /* background, a fan, lowpassed noise with mean absolute amplitude c->noise */
+            lowpass += 0.2f * (noise(&seed) - lowpass);
+            x = voice[i] + (c->noise * 6.5f * lowpass);
+            x = (x > 32767.0f) ? 32767.0f : ((x < -32768.0f) ? -32768.0f : x);
+            clip[i] = (int16_t)x;
+        }
+
+        speech[f] = (level / (float)AUDIO_FRAME_SAMPLES) > (2.0f * c->noise);
+    }
+}
+
+/* clip goes out through playback, so it is read back from a WAV file the way a recording would be */
+static void write_clip(void)
+{
+    AUDIO_FRAME_T* frame;
+    uint32_t f;
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(NULL, CLIP_PATH));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    for (f = 0U; f < CLIP_FRAMES; f++)
+    {
+        frame = audio_io_frame_alloc();
+        TEST_ASSERT_NOT_NULL(frame);
+        memcpy(frame->pcm, &clip[f * AUDIO_FRAME_SAMPLES], sizeof(frame->pcm));
+        TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(frame));
+        audio_io_wav_tick();
+    }
+
+    audio_io_wav_close();
+    audio_io_stop();
+}
+
+/* captures the clip and sends it over a perfect link, blocks for speech and markers for silence,
+   and plays what the receiver makes of it into OUT_PATH */
+static void run_clip(CLIP_RESULT_T* result)
+{
+    ADPCM_STATE_T encoder;
+    AUDIO_FRAME_T* frame;
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    uint16_t length;
+    uint32_t seq = 0U;
+    uint32_t f = 0U;
+    bool started = false;
+    JITTER_BUFFER_RESULT_T got;
+
+    memset(result, 0, sizeof(*result));
+    audio_vad_init(&vad);
+    adpcm_init(&encoder);
+    jitter_buffer_init(&jb);
+
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_init());
+    TEST_ASSERT(audio_io_wav_open(CLIP_PATH, OUT_PATH));
+    TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_start());
+
+    while ((frame = audio_io_capture_get(AUDIO_IO_WAIT_FOREVER)) != NULL)
+    {
+        switch (audio_vad_process(&vad, frame->pcm, AUDIO_FRAME_SAMPLES))
+        {
+            case AUDIO_VAD_SPEECH:
+                length = adpcm_encode_block(&encoder, frame->pcm, AUDIO_FRAME_SAMPLES, block);
+                break;
+            case AUDIO_VAD_SID:
+                length = audio_vad_sid(&vad, block);
+                result->sids++;
+                break;
+            default:
+                length = 0U;
+                result->missed += speech[f] ? 1U : 0U;
+                break;
+        }
+
+        result->speech_frames += speech[f] ? 1U : 0U;
+
+        if (length > 0U)
+        {
+            TEST_ASSERT(jitter_buffer_put(&jb, seq++, block, length, frame->timestamp_us + 5000U));
+            result->sent++;
+            result->bytes += length;
+        }
+
+        got = jitter_buffer_get(&jb, frame->timestamp_us + 6000U, frame->pcm);
+        started = started || (got != JITTER_BUFFER_IDLE);
+        result->idle += (started && (got == JITTER_BUFFER_IDLE)) ? 1U : 0U;
+        TEST_ASSERT_EQUAL_INT(AUDIO_IO_OK, audio_io_play(frame));
+        f++;
+    }
+
+    audio_io_wav_close();
+    audio_io_stop();
+    TEST_ASSERT_EQUAL_UINT32(CLIP_FRAMES, f);
+}
+
+void setUp(void)
+{
+    audio_vad_init(&vad);
+}
+
+void tearDown(void)
+{
+    audio_io_wav_close();
+    remove(CLIP_PATH);
+    remove(OUT_PATH);
+}
+
+void test_audio_vad_silence_sends_only_markers(void)
+{
+    uint16_t level;
+    uint32_t f;
+
+    memset(pcm, 0, sizeof(pcm));
+
+    /* a marker straight away, then one every interval */
+    for (f = 0U; f < (3U * AUDIO_VAD_SID_INTERVAL_FRAMES); f++)
+    {
+        TEST_ASSERT_EQUAL((f % AUDIO_VAD_SID_INTERVAL_FRAMES) == 0U ? AUDIO_VAD_SID : AUDIO_VAD_SILENCE,
+                          audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(3U, vad.stats.sids);
+    TEST_ASSERT_EQUAL_UINT32(0U, vad.stats.speech);
+
+    /* a marker is shorter than any block and says how loud the background is */
+    TEST_ASSERT_EQUAL_UINT16(AUDIO_VAD_SID_BYTES, audio_vad_sid(&vad, (uint8_t*)pcm));
+    TEST_ASSERT(audio_vad_parse_sid((const uint8_t*)pcm, AUDIO_VAD_SID_BYTES, &level));
+    TEST_ASSERT(level < 16U);
+    TEST_ASSERT_FALSE(audio_vad_parse_sid((const uint8_t*)pcm, ADPCM_HDR_BYTES, &level));
+}
+
+void test_audio_vad_hangover_keeps_word_endings(void)
+{
+    uint32_t seed = 1U;
+    uint32_t f;
+    uint32_t i;
+
+    for (i = 0U; i < AUDIO_FRAME_SAMPLES; i++)
+    {
+        pcm[i] = (int16_t)(8000.0f * sinf((2.0f * PI_F * 200.0f * (float)i) / (float)AUDIO_SAMPLE_RATE_HZ));
+    }
+
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SPEECH, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+
+    audio_vad_comfort_noise(&seed, 20U, pcm, AUDIO_FRAME_SAMPLES);
+
+    for (f = 0U; f < AUDIO_VAD_HANGOVER_FRAMES; f++)
+    {
+        TEST_ASSERT_EQUAL(AUDIO_VAD_SPEECH, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+    }
+
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SID, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SILENCE, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+    TEST_ASSERT_EQUAL_UINT32(1U, vad.stats.speech);
+    TEST_ASSERT_EQUAL_UINT32(AUDIO_VAD_HANGOVER_FRAMES, vad.stats.hangover);
+}
+
+void test_audio_vad_follows_background_and_passes_quiet_vowels(void)
+{
+    uint32_t seed = 7U;
+    uint32_t f;
+    uint32_t i;
+
+    /* steady hiss well over the starting floor. It is learnt, and stops counting as speech */
+    for (f = 0U; f < 200U; f++)
+    {
+        audio_vad_comfort_noise(&seed, 300U, pcm, AUDIO_FRAME_SAMPLES);
+        (void)audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES);
+    }
+
+    TEST_ASSERT_UINT32_WITHIN(150U, 300U, vad.floor);
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SILENCE, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+
+    /* a vowel over the hiss passes at a lower level than more hiss would */
+    for (i = 0U; i < AUDIO_FRAME_SAMPLES; i++)
+    {
+        pcm[i] = (int16_t)(pcm[i] + (int16_t)(1500.0f * sinf((2.0f * PI_F * 150.0f * (float)i) / (float)AUDIO_SAMPLE_RATE_HZ)));
+    }
+
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SPEECH, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+
+    /* hiss as loud as that vowel doesn't */
+    audio_vad_init(&vad);
+    vad.floor = 300U;
+    audio_vad_comfort_noise(&seed, 1000U, pcm, AUDIO_FRAME_SAMPLES);
+    TEST_ASSERT_EQUAL(AUDIO_VAD_SID, audio_vad_process(&vad, pcm, AUDIO_FRAME_SAMPLES));
+}
+
+/* host measurement. Synthetic clips stand in for recordings, with talking known frame by frame,
+   so frames cut from speech are counted as well as frames saved */
+void test_audio_vad_frame_reduction_on_clips(void)
+{
+    static const CLIP_T clips[] = {
+        {"quiet room", 20.0f, 9000.0f, 0.15f},
+        {"fan noise", 250.0f, 8000.0f, 0.2f},
+        {"soft talker", 40.0f, 2000.0f, 0.2f},
+    };
+    CLIP_RESULT_T result;
+    uint32_t c;
+
+    printf("clip          speech  on air  markers  reduction  bytes saved  speech cut\n");
+
+    for (c = 0U; c < (sizeof(clips) / sizeof(clips[0])); c++)
+    {
+        make_clip(&clips[c], 0x2545F491U + c);
+        write_clip();
+        run_clip(&result);
+
+        printf("%-12s  %5.0f%%  %5.0f%%  %7u  %8.0f%%  %10.0f%%  %u/%u\n", clips[c].name,
+               (100.0 * result.speech_frames) / CLIP_FRAMES,
+               (100.0 * result.sent) / CLIP_FRAMES,
+               (unsigned)result.sids,
+               100.0 - ((100.0 * result.sent) / CLIP_FRAMES),
+               100.0 - ((100.0 * result.bytes) / (CLIP_FRAMES * (double)ADPCM_BLOCK_BYTES)),
+               (unsigned)result.missed, (unsigned)result.speech_frames);
+
+        /* every frame with the talker in it goes out, and a good share of the rest doesn't */
+        TEST_ASSERT_EQUAL_UINT32(0U, result.missed);
+        TEST_ASSERT(result.sent < ((CLIP_FRAMES * 3U) / 4U));
+        TEST_ASSERT(result.sent > result.speech_frames);
+
+        /* the listener hears comfort noise through the pauses, never dead air */
+        TEST_ASSERT_EQUAL_UINT32(0U, result.idle);
+        TEST_ASSERT(jb.stats.comfort > 0U);
+    }
+}
@@ -0,0 +1,97 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+
+static BENCH_HIST_T hist;
+static char line[BENCH_LINE_BYTES];
+
+void setUp(void)
+{
+    bench_hist_init(&hist);
+}
+
+void tearDown(void) { }
+
+void test_bench_hist_percentiles_are_exact_for_small_values(void)
+{
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL_UINT32(0U, bench_hist_percentile(&hist, 500U));
+
+    for (i = 1U; i <= 7U; i++)
+    {
+        bench_hist_add(&hist, i);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(7U, hist.count);
+    TEST_ASSERT_EQUAL_UINT32(1U, hist.min);
+    TEST_ASSERT_EQUAL_UINT32(7U, hist.max);
+    TEST_ASSERT_EQUAL_UINT32(1U, bench_hist_percentile(&hist, 0U));
+    TEST_ASSERT_EQUAL_UINT32(4U, bench_hist_percentile(&hist, 500U));
+    TEST_ASSERT_EQUAL_UINT32(7U, bench_hist_percentile(&hist, 990U));
+    TEST_ASSERT_EQUAL_UINT32(7U, bench_hist_percentile(&hist, 1000U));
+}
+
+void test_bench_hist_stays_within_an_eighth_of_value(void)
+{
+    uint32_t value;
+    uint32_t reported;
+
+    /* one sample at a time, from a few us to over an hour */
+    for (value = 8U; value < 0x80000000UL; value += (value / 3U) + 1U)
+    {
+        bench_hist_init(&hist);
+        bench_hist_add(&hist, 1U);
+        bench_hist_add(&hist, value);
+        bench_hist_add(&hist, 0xFFFFFFFFUL);
+
+        reported = bench_hist_percentile(&hist, 500U);
+        TEST_ASSERT(reported >= value);
+        TEST_ASSERT((reported - value) <= (value / 8U));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFFFFUL, bench_hist_percentile(&hist, 1000U));
+}
+
+void test_bench_format_result_writes_one_json_line(void)
+{
+    BENCH_HIST_T rtt;
+    BENCH_RESULT_T result = {
+        .name = "write",
+        .link = "sim_clean",
+        .payload_bytes = 128U,
+        .sent = 10U,
+        .received = 8U,
+        .bytes = 1024U,
+        .elapsed_us = 20000U,
+        .latency = &hist,
+        .rtt = NULL
+    };
+    uint32_t length;
+    uint32_t i;
+
+    for (i = 1U; i <= 10U; i++)
+    {
+        bench_hist_add(&hist, i * 100U);
+    }
+
+    length = bench_format_result(&result, line, sizeof(line));
+    TEST_ASSERT_EQUAL_UINT32(strlen(line), length);
+    TEST_ASSERT_EQUAL_STRING(BENCH_LINE_PREFIX "{\"bench\":\"write\",\"link\":\"sim_clean\",\"payload\":128,\"sent\":10,"
+                             "\"received\":8,\"elapsed_us\":20000,\"per_s\":400,\"goodput_bps\":409600,"
+                             "\"latency_us\":{\"n\":10,\"min\":100,\"mean\":550,\"p50\":511,\"p90\":959,\"p99\":1000,\"max\":1000}}",
+                             line);
+
+    /* empty histograms are left out, a short buffer still ends in a terminator */
+    bench_hist_init(&rtt);
+    result.latency = NULL;
+    result.rtt = &rtt;
+    (void)bench_format_result(&result, line, sizeof(line));
+    TEST_ASSERT_NULL(strstr(line, "_us\":{"));
+
+    TEST_ASSERT_EQUAL_UINT32(15U, bench_format_result(&result, line, 16U));
+    TEST_ASSERT_EQUAL_UINT32(15U, strlen(line));
+}
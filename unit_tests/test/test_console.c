@@ -0,0 +1,125 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "console.h"
+
+static uint32_t calls;
+static uint32_t last_argc;
+static char last_args[CONSOLE_MAX_ARGS][CONSOLE_LINE_BYTES + 1U];
+
+static void record(uint32_t argc, char** argv)
+{
+    uint32_t i;
+
+    calls++;
+    last_argc = argc;
+
+    for (i = 0U; i < argc; i++)
+    {
+        strcpy(last_args[i], argv[i]);
+    }
+}
+
+static const CONSOLE_COMMAND_T metrics = {"metrics", "prints metrics", record};
+static const CONSOLE_COMMAND_T load = {"load", "starts a load test", record};
+
+static void feed(const char* text)
+{
+    console_feed((const uint8_t*)text, (uint32_t)strlen(text));
+}
+
+void setUp(void)
+{
+    calls = 0U;
+    last_argc = 0U;
+    console_init();
+    TEST_ASSERT_TRUE(console_register(&metrics));
+    TEST_ASSERT_TRUE(console_register(&load));
+}
+
+void tearDown(void) { }
+
+void test_console_runs_command_with_words(void)
+{
+    feed("load  1000\t242 5\r\n");
+
+    TEST_ASSERT_EQUAL_UINT32(1U, calls);
+    TEST_ASSERT_EQUAL_UINT32(4U, last_argc);
+    TEST_ASSERT_EQUAL_STRING("load", last_args[0]);
+    TEST_ASSERT_EQUAL_STRING("1000", last_args[1]);
+    TEST_ASSERT_EQUAL_STRING("242", last_args[2]);
+    TEST_ASSERT_EQUAL_STRING("5", last_args[3]);
+}
+
+void test_console_assembles_lines_across_feeds(void)
+{
+    feed("metr");
+    TEST_ASSERT_EQUAL_UINT32(0U, calls);
+    feed("ics res");
+    feed("et\nmetrics\n");
+
+    TEST_ASSERT_EQUAL_UINT32(2U, calls);
+    TEST_ASSERT_EQUAL_UINT32(1U, last_argc);
+
+    /* backspace fixes a typo, blank lines do nothing */
+    feed("loax\bd 7\n\n\r\n   \n");
+    TEST_ASSERT_EQUAL_UINT32(3U, calls);
+    TEST_ASSERT_EQUAL_STRING("load", last_args[0]);
+    TEST_ASSERT_EQUAL_STRING("7", last_args[1]);
+}
+
+void test_console_ignores_unknown_and_overlong_lines(void)
+{
+    char text[CONSOLE_LINE_BYTES + 8U];
+
+    feed("reboot\n");
+    TEST_ASSERT_EQUAL_UINT32(0U, calls);
+
+    memset(text, 'x', sizeof(text));
+    memcpy(text, "metrics ", 8U);
+    text[sizeof(text) - 1U] = '\n';
+    console_feed((const uint8_t*)text, sizeof(text));
+    TEST_ASSERT_EQUAL_UINT32(0U, calls);
+
+    /* the next line is fine again */
+    feed("metrics\n");
+    TEST_ASSERT_EQUAL_UINT32(1U, calls);
+}
+
+void test_console_register_rejects_duplicates_and_full_table(void)
+{
+    static CONSOLE_COMMAND_T extra[CONSOLE_MAX_COMMANDS];
+    static char names[CONSOLE_MAX_COMMANDS][8];
+    char text[8];
+    uint32_t registered = 0U;
+    uint32_t i;
+
+    TEST_ASSERT_FALSE(console_register(&metrics));
+
+    for (i = 0U; i < CONSOLE_MAX_COMMANDS; i++)
+    {
+        names[i][0] = 'c';
+        names[i][1] = (char)('a' + i);
+        names[i][2] = '\0';
+        extra[i].name = names[i];
+        extra[i].help = "";
+        extra[i].handler = record;
+        registered += console_register(&extra[i]) ? 1U : 0U;
+    }
+
+    /* help, metrics and load were already there */
+    TEST_ASSERT_EQUAL_UINT32(CONSOLE_MAX_COMMANDS - 3U, registered);
+    TEST_ASSERT_TRUE(console_execute(strcpy(text, "ca")));
+    TEST_ASSERT_TRUE(console_execute(strcpy(text, "help")));
+    TEST_ASSERT_FALSE(console_execute(strcpy(text, "  ")));
+}
+
+void test_console_extra_words_are_dropped(void)
+{
+    feed("load 1 2 3 4 5 6 7 8 9\n");
+
+    TEST_ASSERT_EQUAL_UINT32(1U, calls);
+    TEST_ASSERT_EQUAL_UINT32(CONSOLE_MAX_ARGS, last_argc);
+    TEST_ASSERT_EQUAL_STRING("7", last_args[CONSOLE_MAX_ARGS - 1U]);
+}
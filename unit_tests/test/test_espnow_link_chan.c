@@ -0,0 +1,154 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "espnow_link_chan.h"
+
+static ESPNOW_LINK_CHAN_MONITOR_T monitor;
+static ESPNOW_LINK_CHAN_SURVEY_T survey;
+
+/* channel heard busy for permille of a 100 ms dwell, in 1 ms frames at noise_floor */
+static void survey_channel(uint8_t channel, uint32_t permille, int8_t noise_floor)
+{
+    uint32_t i;
+
+    espnow_link_chan_scan_dwell(&survey, channel, 100000U);
+
+    for (i = 0U; i < (permille / 10U); i++)
+    {
+        espnow_link_chan_scan_add(&survey, channel, -60, noise_floor, 1000U);
+    }
+}
+
+/* the channels not surveyed yet, quiet */
+static void survey_rest(void)
+{
+    uint8_t channel;
+
+    for (channel = ESPNOW_LINK_CHAN_FIRST; channel <= ESPNOW_LINK_CHAN_LAST; channel++)
+    {
+        if (survey.channels[channel - ESPNOW_LINK_CHAN_FIRST].dwell_us == 0U)
+        {
+            survey_channel(channel, 0U, -97);
+        }
+    }
+}
+
+void setUp(void)
+{
+    espnow_link_chan_monitor_init(&monitor);
+    espnow_link_chan_survey_init(&survey);
+}
+
+void tearDown(void) { }
+
+void test_espnow_link_chan_monitor_averages_and_windows_delivery(void)
+{
+    ESPNOW_LINK_CHAN_STATS_T stats;
+    uint32_t i;
+
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_EQUAL_UINT16(1000U, stats.delivery_permille);
+    TEST_ASSERT_FALSE(stats.degraded);
+
+    /* starts at the first frame, then follows */
+    espnow_link_chan_on_rx(&monitor, -40, -96);
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_EQUAL_INT8(-40, stats.rssi);
+    TEST_ASSERT_EQUAL_INT8(-96, stats.noise_floor);
+
+    for (i = 0U; i < 64U; i++)
+    {
+        espnow_link_chan_on_rx(&monitor, -70, -88);
+    }
+
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_INT_WITHIN(1, -70, stats.rssi);
+    TEST_ASSERT_INT_WITHIN(1, -88, stats.noise_floor);
+    TEST_ASSERT_EQUAL_UINT32(65U, stats.frames_rx);
+
+    /* one failure in four. The ratio only moves once a whole window is in */
+    for (i = 0U; i < (ESPNOW_LINK_CHAN_TX_WINDOW - 1U); i++)
+    {
+        espnow_link_chan_on_tx(&monitor, (i % 4U) != 0U);
+    }
+
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_EQUAL_UINT16(1000U, stats.delivery_permille);
+
+    espnow_link_chan_on_tx(&monitor, true);
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_EQUAL_UINT16(750U, stats.delivery_permille);
+    TEST_ASSERT(stats.degraded);
+    TEST_ASSERT_EQUAL_UINT32(24U, stats.tx_acked);
+    TEST_ASSERT_EQUAL_UINT32(8U, stats.tx_failed);
+
+    for (i = 0U; i < ESPNOW_LINK_CHAN_TX_WINDOW; i++)
+    {
+        espnow_link_chan_on_tx(&monitor, true);
+    }
+
+    espnow_link_chan_get_stats(&monitor, &stats);
+    TEST_ASSERT_EQUAL_UINT16(1000U, stats.delivery_permille);
+    TEST_ASSERT_FALSE(stats.degraded);
+}
+
+void test_espnow_link_chan_score_counts_overlapping_neighbours(void)
+{
+    survey_channel(6U, 400U, -97);
+    survey_rest();
+
+    /* the busy channel itself, then half next to it, a quarter two away, nothing past that */
+    TEST_ASSERT_EQUAL_UINT32(400U, espnow_link_chan_score(&survey, 6U));
+    TEST_ASSERT_EQUAL_UINT32(200U, espnow_link_chan_score(&survey, 5U));
+    TEST_ASSERT_EQUAL_UINT32(200U, espnow_link_chan_score(&survey, 7U));
+    TEST_ASSERT_EQUAL_UINT32(100U, espnow_link_chan_score(&survey, 4U));
+    TEST_ASSERT_EQUAL_UINT32(100U, espnow_link_chan_score(&survey, 8U));
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_chan_score(&survey, 9U));
+
+    /* band edges have one side only, and nothing past the band counts */
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_chan_score(&survey, 1U));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, espnow_link_chan_score(&survey, 14U));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, espnow_link_chan_score(&survey, 0U));
+
+    /* airtime of a frame grows with its length */
+    TEST_ASSERT_EQUAL_UINT32(ESPNOW_LINK_CHAN_PREAMBLE_US + 334U, espnow_link_chan_airtime_us(250U));
+    TEST_ASSERT(espnow_link_chan_airtime_us(1500U) > espnow_link_chan_airtime_us(250U));
+}
+
+void test_espnow_link_chan_noise_above_quiet_costs_score(void)
+{
+    survey_channel(3U, 100U, ESPNOW_LINK_CHAN_QUIET_NOISE_DBM);
+    survey_channel(11U, 100U, ESPNOW_LINK_CHAN_QUIET_NOISE_DBM + 5);
+
+    TEST_ASSERT_EQUAL_UINT32(100U, espnow_link_chan_score(&survey, 3U));
+    TEST_ASSERT_EQUAL_UINT32(100U + (5U * ESPNOW_LINK_CHAN_NOISE_COST), espnow_link_chan_score(&survey, 11U));
+
+    /* nothing heard, nothing known about its noise */
+    survey_channel(7U, 0U, 0);
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_chan_score(&survey, 7U));
+}
+
+void test_espnow_link_chan_pick_needs_a_clear_win(void)
+{
+    /* nothing surveyed, stay */
+    TEST_ASSERT_EQUAL_UINT8(6U, espnow_link_chan_pick(&survey, 6U));
+
+    /* a house full of wifi on 1 to 8, 11 to 13 clear */
+    survey_channel(1U, 300U, -92);
+    survey_channel(3U, 200U, -94);
+    survey_channel(6U, 500U, -90);
+    survey_channel(8U, 200U, -96);
+    survey_rest();
+
+    TEST_ASSERT_EQUAL_UINT8(11U, espnow_link_chan_pick(&survey, 6U));
+    TEST_ASSERT_EQUAL_UINT8(11U, espnow_link_chan_pick(&survey, 1U));
+    TEST_ASSERT_EQUAL_UINT8(13U, espnow_link_chan_pick(&survey, 13U));
+
+    /* channel 10 only gets a quarter of channel 8, too small a gain to be worth the move */
+    TEST_ASSERT_EQUAL_UINT32(50U, espnow_link_chan_score(&survey, 10U));
+    TEST_ASSERT_EQUAL_UINT8(10U, espnow_link_chan_pick(&survey, 10U));
+
+    /* a current channel that wasn't surveyed has nothing to hold on with */
+    TEST_ASSERT_EQUAL_UINT8(11U, espnow_link_chan_pick(&survey, 14U));
+}
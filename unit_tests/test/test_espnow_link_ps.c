@@ -0,0 +1,102 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "espnow_link_ps.h"
+
+static ESPNOW_LINK_PS_T ps;
+
+static const uint8_t sleeper[6U] = {0x56U, 0x78U, 0x12U, 0xFEU, 0x4AU, 0x5BU};
+static const uint8_t stranger[6U] = {0x56U, 0x78U, 0x12U, 0xFEU, 0x4BU, 0x50U};
+
+/* sleeper says at now_us that it listens 20 ms out of every 100 ms */
+static void hear(bool window_open, uint16_t awake_ms, uint32_t now_us)
+{
+    uint8_t beacon[ESPNOW_LINK_PS_BEACON_BYTES];
+    uint16_t length = espnow_link_ps_build_beacon(window_open, 20U, 100U, awake_ms, beacon);
+
+    TEST_ASSERT_EQUAL_UINT16(ESPNOW_LINK_PS_BEACON_BYTES, length);
+    TEST_ASSERT(espnow_link_ps_on_beacon(&ps, sleeper, beacon, length, now_us));
+}
+
+void setUp(void)
+{
+    espnow_link_ps_init(&ps);
+}
+
+void tearDown(void) { }
+
+void test_espnow_link_ps_frames_wait_for_the_window(void)
+{
+    hear(true, 20U, 1000000U);
+
+    /* open, but not once too little of it is left for retries */
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 1000000U));
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 1000000U + 20000U - ESPNOW_LINK_PS_MARGIN_US));
+    TEST_ASSERT_EQUAL_UINT32(80000U + ESPNOW_LINK_PS_MARGIN_US - 1U,
+                             espnow_link_ps_wait_us(&ps, sleeper, 1000000U + 20000U - ESPNOW_LINK_PS_MARGIN_US + 1U));
+
+    /* windows keep repeating without more beacons */
+    TEST_ASSERT_EQUAL_UINT32(50000U, espnow_link_ps_wait_us(&ps, sleeper, 1000000U + 350000U));
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 1000000U + 405000U));
+
+    /* nothing known about it, so it is taken to be awake */
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, stranger, 1000000U + 50000U));
+}
+
+void test_espnow_link_ps_awake_beacons_keep_the_windows(void)
+{
+    hear(true, 20U, 0U);
+
+    /* holding awake mid interval, e.g. after hearing traffic */
+    hear(false, 200U, 50000U);
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 60000U));
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 240000U));
+
+    /* hold over, back to windows from the first beacon */
+    TEST_ASSERT_EQUAL_UINT32(40000U, espnow_link_ps_wait_us(&ps, sleeper, 260000U));
+
+    /* stopped duty cycling, e.g. for push to talk, until its next window beacon */
+    hear(false, ESPNOW_LINK_PS_AWAKE_FOREVER, 300000U);
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 10000000U));
+
+    hear(true, 20U, 10000000U);
+    TEST_ASSERT_EQUAL_UINT32(70000U, espnow_link_ps_wait_us(&ps, sleeper, 10030000U));
+}
+
+void test_espnow_link_ps_ignores_frames_that_are_not_beacons(void)
+{
+    uint8_t frame[ESPNOW_LINK_PS_BEACON_BYTES + 1U];
+
+    (void)espnow_link_ps_build_beacon(true, 20U, 100U, 20U, frame);
+
+    TEST_ASSERT_FALSE(espnow_link_ps_on_beacon(&ps, sleeper, frame, ESPNOW_LINK_PS_BEACON_BYTES + 1U, 0U));
+
+    frame[0] = 0U;
+    TEST_ASSERT_FALSE(espnow_link_ps_on_beacon(&ps, sleeper, frame, ESPNOW_LINK_PS_BEACON_BYTES, 0U));
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 50000U));
+}
+
+void test_espnow_link_ps_forgets_the_peer_heard_from_least_recently(void)
+{
+    uint8_t beacon[ESPNOW_LINK_PS_BEACON_BYTES];
+    uint8_t mac[6U];
+    uint32_t i;
+
+    (void)espnow_link_ps_build_beacon(true, 20U, 100U, 20U, beacon);
+    memcpy(mac, stranger, sizeof(mac));
+
+    /* sleeper first, then enough others to fill the table and one more */
+    hear(true, 20U, 0U);
+
+    for (i = 0U; i < ESPNOW_LINK_PS_PEERS; i++)
+    {
+        mac[5] = (uint8_t)i;
+        TEST_ASSERT(espnow_link_ps_on_beacon(&ps, mac, beacon, sizeof(beacon), 0U));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0U, espnow_link_ps_wait_us(&ps, sleeper, 50000U));
+
+    mac[5] = 1U;
+    TEST_ASSERT_EQUAL_UINT32(50000U, espnow_link_ps_wait_us(&ps, mac, 50000U));
+}
@@ -0,0 +1,164 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "espnow_link_rate.h"
+
+static const uint8_t peer_mac[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x03U};
+
+static ESPNOW_LINK_RATE_TABLE_T table;
+
+/* count frames to peer_mac from now_ms, a ms apart, acked while their rate is at most best.
+   Returns the rate the last one went at */
+static ESPNOW_LINK_RATE_T send(uint32_t* now_ms, uint32_t count, ESPNOW_LINK_RATE_T best)
+{
+    ESPNOW_LINK_RATE_T rate = ESPNOW_LINK_RATE_COUNT;
+    bool reconfigure;
+    uint32_t i;
+
+    for (i = 0U; i < count; i++, (*now_ms)++)
+    {
+        rate = espnow_link_rate_select(&table, peer_mac, *now_ms, &reconfigure);
+        espnow_link_rate_on_tx(&table, peer_mac, rate <= best);
+    }
+
+    return rate;
+}
+
+void setUp(void)
+{
+    espnow_link_rate_init(&table, false);
+}
+
+void tearDown(void) { }
+
+void test_espnow_link_rate_starts_at_what_rssi_allows(void)
+{
+    ESPNOW_LINK_RATE_STATS_T stats;
+    bool reconfigure;
+
+    TEST_ASSERT_EQUAL_UINT32(192U + 2000U, espnow_link_rate_frame_us(ESPNOW_LINK_RATE_1M, 250U));
+    TEST_ASSERT_EQUAL_UINT32(20U + 38U, espnow_link_rate_frame_us(ESPNOW_LINK_RATE_54M, 250U));
+
+    /* nothing heard, 1 Mbps. The radio is set the first time only */
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, espnow_link_rate_select(&table, peer_mac, 0U, &reconfigure));
+    TEST_ASSERT(reconfigure);
+    espnow_link_rate_cancel(&table, peer_mac);
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, espnow_link_rate_select(&table, peer_mac, 1U, &reconfigure));
+    TEST_ASSERT_FALSE(reconfigure);
+    espnow_link_rate_cancel(&table, peer_mac);
+
+    /* close by, the fastest. Far off, never under 1 Mbps without long range */
+    espnow_link_rate_on_rx(&table, peer_mac, -50, 2U);
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_54M, espnow_link_rate_select(&table, peer_mac, 2U, &reconfigure));
+    TEST_ASSERT(reconfigure);
+    espnow_link_rate_cancel(&table, peer_mac);
+
+    espnow_link_rate_init(&table, false);
+    espnow_link_rate_on_rx(&table, peer_mac, -98, 0U);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, stats.rate);
+    TEST_ASSERT_EQUAL_INT8(-98, stats.rssi);
+
+    espnow_link_rate_init(&table, true);
+    espnow_link_rate_on_rx(&table, peer_mac, -98, 0U);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_LR_250K, stats.rate);
+    TEST_ASSERT_EQUAL_UINT32(250U, stats.kbps);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.rate_changes);
+}
+
+void test_espnow_link_rate_falls_back_on_failures(void)
+{
+    ESPNOW_LINK_RATE_STATS_T stats;
+    uint32_t now_ms = 0U;
+
+    espnow_link_rate_on_rx(&table, peer_mac, -78, 0U);
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_24M, send(&now_ms, 1U, ESPNOW_LINK_RATE_24M));
+
+    /* the peer walks off. A few failures in a row drop a rate each, down to what still gets through */
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_5M5, send(&now_ms, 3U * ESPNOW_LINK_RATE_FALLBACK_FAILURES, ESPNOW_LINK_RATE_5M5));
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_5M5, stats.rate);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.rate_changes);
+    TEST_ASSERT_EQUAL_UINT32(1U + ESPNOW_LINK_RATE_FALLBACK_FAILURES, stats.frames_acked);
+    TEST_ASSERT_EQUAL_UINT32(2U * ESPNOW_LINK_RATE_FALLBACK_FAILURES, stats.frames_failed);
+
+    /* and stays there across intervals, probes up failing */
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_5M5, send(&now_ms, 10U * ESPNOW_LINK_RATE_INTERVAL_MS, ESPNOW_LINK_RATE_5M5));
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_5M5, stats.rate);
+    TEST_ASSERT_EQUAL_UINT16(1000U, stats.delivery_permille);
+    TEST_ASSERT(stats.probes > 0U);
+
+    /* never under the slowest */
+    send(&now_ms, 10U * ESPNOW_LINK_RATE_FALLBACK_FAILURES, ESPNOW_LINK_RATE_LR_250K);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, stats.rate);
+}
+
+void test_espnow_link_rate_probes_up_when_rssi_allows(void)
+{
+    ESPNOW_LINK_RATE_STATS_T stats;
+    uint32_t now_ms = 0U;
+    uint32_t i;
+
+    /* the link got better than it started. Probes find each rate up in turn */
+    espnow_link_rate_on_rx(&table, peer_mac, -90, 0U);
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_2M, send(&now_ms, 1U, ESPNOW_LINK_RATE_54M));
+
+    for (i = 0U; i < 32U; i++)
+    {
+        espnow_link_rate_on_rx(&table, peer_mac, -60, now_ms);
+    }
+
+    send(&now_ms, 20U * ESPNOW_LINK_RATE_INTERVAL_MS, ESPNOW_LINK_RATE_54M);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_54M, stats.rate);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.frames_failed);
+
+    /* too weak for anything above 2 Mbps to be worth trying */
+    espnow_link_rate_init(&table, false);
+    now_ms = 0U;
+    espnow_link_rate_on_rx(&table, peer_mac, -95, 0U);
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, send(&now_ms, 1U, ESPNOW_LINK_RATE_54M));
+    send(&now_ms, 20U * ESPNOW_LINK_RATE_INTERVAL_MS, ESPNOW_LINK_RATE_54M);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_2M, stats.rate);
+}
+
+void test_espnow_link_rate_table_makes_room_for_new_peers(void)
+{
+    ESPNOW_LINK_RATE_STATS_T stats;
+    uint8_t mac[6U];
+    bool reconfigure;
+    uint32_t i;
+
+    memcpy(mac, peer_mac, sizeof(mac));
+    TEST_ASSERT_FALSE(espnow_link_rate_get_stats(&table, peer_mac, &stats));
+
+    /* every peer has a frame in flight, none can be let go */
+    for (i = 0U; i < ESPNOW_LINK_RATE_MAX_PEERS; i++)
+    {
+        mac[5] = (uint8_t)i;
+        espnow_link_rate_select(&table, mac, i, &reconfigure);
+    }
+
+    mac[5] = 0xFFU;
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_1M, espnow_link_rate_select(&table, mac, 100U, &reconfigure));
+    TEST_ASSERT_FALSE(reconfigure);
+    TEST_ASSERT_FALSE(espnow_link_rate_get_stats(&table, mac, &stats));
+
+    /* the oldest one's frame never went out. It makes room */
+    mac[5] = 0U;
+    espnow_link_rate_cancel(&table, mac);
+    mac[5] = 0xFFU;
+    espnow_link_rate_on_rx(&table, mac, -40, 101U);
+    TEST_ASSERT(espnow_link_rate_get_stats(&table, mac, &stats));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_54M, stats.rate);
+    mac[5] = 0U;
+    TEST_ASSERT_FALSE(espnow_link_rate_get_stats(&table, mac, &stats));
+
+    /* a result for a peer that isn't known is let go */
+    espnow_link_rate_on_tx(&table, mac, true);
+}
@@ -0,0 +1,164 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "espnow_link_ring.h"
+
+#define RING_BYTES (512U)
+
+static ESPNOW_LINK_RING_T ring;
+static uint32_t ring_storage[RING_BYTES / 4U];
+
+static uint8_t src_mac[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4A, 0x5B};
+
+static void push_frame(uint8_t fill, uint16_t length, bool expected)
+{
+    ESPNOW_LINK_RX_DESC_T desc;
+    uint8_t data[250U];
+
+    memset(&desc, 0U, sizeof(desc));
+    memcpy(desc.src_mac, src_mac, 6U);
+    desc.rssi = -42;
+    desc.timestamp_us = fill;
+    desc.data_len = length;
+    memset(data, fill, length);
+
+    TEST_ASSERT_EQUAL_INT(expected, espnow_link_ring_push(&ring, &desc, data));
+}
+
+static void pop_frame(uint8_t fill, uint16_t length)
+{
+    ESPNOW_LINK_RX_DESC_T desc;
+    uint8_t data[250U];
+    uint8_t expected[250U];
+
+    memset(expected, fill, length);
+
+    TEST_ASSERT(espnow_link_ring_pop(&ring, &desc, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(length, desc.data_len);
+    TEST_ASSERT_EQUAL_INT(fill, desc.timestamp_us);
+    TEST_ASSERT_EQUAL_INT(-42, desc.rssi);
+    TEST_ASSERT_EQUAL_MEMORY(src_mac, desc.src_mac, 6U);
+    TEST_ASSERT_EQUAL_MEMORY(expected, data, length);
+}
+
+void setUp(void)
+{
+    espnow_link_ring_init(&ring, (uint8_t*)ring_storage, RING_BYTES, ESPNOW_LINK_RING_DROP_NEWEST);
+}
+
+void tearDown(void) { }
+
+void test_espnow_link_ring_init_rejects_bad_size(void)
+{
+    TEST_ASSERT_FALSE(espnow_link_ring_init(&ring, (uint8_t*)ring_storage, 500U, ESPNOW_LINK_RING_DROP_NEWEST));
+    TEST_ASSERT_FALSE(espnow_link_ring_init(&ring, NULL, RING_BYTES, ESPNOW_LINK_RING_DROP_NEWEST));
+}
+
+void test_espnow_link_ring_empty(void)
+{
+    ESPNOW_LINK_RX_DESC_T desc;
+    uint8_t data[8U];
+
+    TEST_ASSERT(espnow_link_ring_is_empty(&ring));
+    TEST_ASSERT_FALSE(espnow_link_ring_pop(&ring, &desc, data, sizeof(data)));
+}
+
+void test_espnow_link_ring_stores_only_data_len(void)
+{
+    push_frame(0x11, 1U, true);
+
+    /* 1 byte of data should only cost a descriptor plus alignment, not a full 250 byte frame */
+    TEST_ASSERT_EQUAL_INT(sizeof(ESPNOW_LINK_RX_DESC_T) + 4U, espnow_link_ring_used_bytes(&ring));
+
+    pop_frame(0x11, 1U);
+    TEST_ASSERT(espnow_link_ring_is_empty(&ring));
+}
+
+void test_espnow_link_ring_fifo_order_across_wrap(void)
+{
+    uint8_t i;
+
+    /* odd sizes force records to wrap at different offsets */
+    for (i = 0U; i < 40U; i++)
+    {
+        push_frame(i, (uint16_t)(37U + i), true);
+        push_frame((uint8_t)(i + 100U), 5U, true);
+        pop_frame(i, (uint16_t)(37U + i));
+        pop_frame((uint8_t)(i + 100U), 5U);
+    }
+
+    TEST_ASSERT(espnow_link_ring_is_empty(&ring));
+}
+
+void test_espnow_link_ring_drop_newest(void)
+{
+    ESPNOW_LINK_RING_STATS_T stats;
+
+    push_frame(1U, 200U, true);
+    push_frame(2U, 200U, true);
+    push_frame(3U, 200U, false); /* full */
+
+    espnow_link_ring_get_stats(&ring, &stats);
+    TEST_ASSERT_EQUAL_INT(1U, stats.dropped_newest);
+    TEST_ASSERT_EQUAL_INT(0U, stats.dropped_oldest);
+
+    /* oldest data survives */
+    pop_frame(1U, 200U);
+    pop_frame(2U, 200U);
+}
+
+void test_espnow_link_ring_drop_oldest(void)
+{
+    ESPNOW_LINK_RING_STATS_T stats;
+
+    espnow_link_ring_set_policy(&ring, ESPNOW_LINK_RING_DROP_OLDEST);
+
+    push_frame(1U, 200U, true);
+    push_frame(2U, 200U, true);
+    push_frame(3U, 200U, true);
+
+    espnow_link_ring_get_stats(&ring, &stats);
+    TEST_ASSERT_EQUAL_INT(0U, stats.dropped_newest);
+    TEST_ASSERT_EQUAL_INT(1U, stats.dropped_oldest);
+
+    /* newest data survives */
+    pop_frame(2U, 200U);
+    pop_frame(3U, 200U);
+    TEST_ASSERT(espnow_link_ring_is_empty(&ring));
+}
+
+void test_espnow_link_ring_rejects_oversized_frame(void)
+{
+    ESPNOW_LINK_RING_STATS_T stats;
+
+    push_frame(1U, 250U, false); /* record would be more than half of a 512 byte ring */
+
+    espnow_link_ring_get_stats(&ring, &stats);
+    TEST_ASSERT_EQUAL_INT(1U, stats.rejected);
+}
+
+void test_espnow_link_ring_truncates_to_capacity(void)
+{
+    ESPNOW_LINK_RX_DESC_T desc;
+    uint8_t data[4U];
+
+    push_frame(7U, 20U, true);
+
+    TEST_ASSERT(espnow_link_ring_pop(&ring, &desc, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(4U, desc.data_len);
+    TEST_ASSERT(espnow_link_ring_is_empty(&ring));
+}
+
+void test_espnow_link_ring_high_water(void)
+{
+    ESPNOW_LINK_RING_STATS_T stats;
+
+    push_frame(1U, 100U, true);
+    push_frame(2U, 100U, true);
+    pop_frame(1U, 100U);
+    pop_frame(2U, 100U);
+
+    espnow_link_ring_get_stats(&ring, &stats);
+    TEST_ASSERT_EQUAL_INT(2U * ESPNOW_LINK_RING_RECORD_BYTES(100U), stats.high_water_bytes);
+}
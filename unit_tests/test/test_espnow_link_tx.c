@@ -0,0 +1,136 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "espnow_link_tx.h"
+
+static ESPNOW_LINK_TX_TRACKER_T tracker;
+
+static uint8_t peer_mac1[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4A, 0x5B};
+static uint8_t peer_mac2[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4B, 0x50};
+
+static ESPNOW_LINK_TX_HANDLE_T callback_handle;
+static bool callback_success;
+static void* callback_context;
+
+static void done_callback(ESPNOW_LINK_TX_HANDLE_T handle, bool success, void* context)
+{
+    callback_handle = handle;
+    callback_success = success;
+    callback_context = context;
+}
+
+/* what espnow_send_callback() does with a completion */
+static void complete(const uint8_t* mac, bool success)
+{
+    ESPNOW_LINK_TX_COMPLETION_T completion;
+
+    TEST_ASSERT(espnow_link_tx_complete(&tracker, mac, success, &completion));
+
+    if (completion.callback != NULL)
+    {
+        completion.callback(completion.handle, success, completion.context);
+    }
+}
+
+void setUp(void)
+{
+    espnow_link_tx_init(&tracker);
+    callback_handle = ESPNOW_LINK_TX_INVALID_HANDLE;
+    callback_context = NULL;
+}
+
+void tearDown(void) { }
+
+void test_espnow_link_tx_multiple_frames_in_flight(void)
+{
+    ESPNOW_LINK_TX_HANDLE_T handles[ESPNOW_LINK_TX_MAX_IN_FLIGHT];
+    ESPNOW_LINK_TX_HANDLE_T extra;
+    uint32_t i;
+
+    for (i = 0U; i < ESPNOW_LINK_TX_MAX_IN_FLIGHT; i++)
+    {
+        TEST_ASSERT(espnow_link_tx_reserve(&tracker, peer_mac1, NULL, NULL, &handles[i]) >= 0);
+        TEST_ASSERT(handles[i] != ESPNOW_LINK_TX_INVALID_HANDLE);
+        TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_PENDING, espnow_link_tx_get_state(&tracker, handles[i]));
+    }
+
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_MAX_IN_FLIGHT, espnow_link_tx_in_flight(&tracker));
+
+    /* pipeline full */
+    TEST_ASSERT_EQUAL_INT(-1, espnow_link_tx_reserve(&tracker, peer_mac1, NULL, NULL, &extra));
+
+    /* one completion frees one slot */
+    complete(peer_mac1, true);
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_SUCCESS, espnow_link_tx_get_state(&tracker, handles[0]));
+    TEST_ASSERT(espnow_link_tx_reserve(&tracker, peer_mac1, NULL, NULL, &extra) >= 0);
+
+    /* oldest slot was reused, so its result is no longer tracked */
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_FREE, espnow_link_tx_get_state(&tracker, handles[0]));
+}
+
+void test_espnow_link_tx_completions_match_send_order(void)
+{
+    ESPNOW_LINK_TX_HANDLE_T first;
+    ESPNOW_LINK_TX_HANDLE_T second;
+    int context1 = 1;
+    int context2 = 2;
+
+    espnow_link_tx_reserve(&tracker, peer_mac1, done_callback, &context1, &first);
+    espnow_link_tx_reserve(&tracker, peer_mac2, done_callback, &context2, &second);
+
+    complete(peer_mac1, false);
+    TEST_ASSERT_EQUAL_INT(first, callback_handle);
+    TEST_ASSERT_FALSE(callback_success);
+    TEST_ASSERT_EQUAL_PTR(&context1, callback_context);
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_FAILED, espnow_link_tx_get_state(&tracker, first));
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_PENDING, espnow_link_tx_get_state(&tracker, second));
+
+    complete(peer_mac2, true);
+    TEST_ASSERT_EQUAL_INT(second, callback_handle);
+    TEST_ASSERT(callback_success);
+    TEST_ASSERT_EQUAL_PTR(&context2, callback_context);
+
+    TEST_ASSERT_EQUAL_INT(0U, espnow_link_tx_in_flight(&tracker));
+    TEST_ASSERT_EQUAL_INT(0U, tracker.mac_mismatches);
+}
+
+void test_espnow_link_tx_mac_mismatch_counted(void)
+{
+    ESPNOW_LINK_TX_HANDLE_T handle;
+
+    espnow_link_tx_reserve(&tracker, peer_mac1, NULL, NULL, &handle);
+    complete(peer_mac2, true);
+
+    TEST_ASSERT_EQUAL_INT(1U, tracker.mac_mismatches);
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_SUCCESS, espnow_link_tx_get_state(&tracker, handle));
+}
+
+void test_espnow_link_tx_unmatched_completion(void)
+{
+    ESPNOW_LINK_TX_COMPLETION_T completion;
+
+    TEST_ASSERT_FALSE(espnow_link_tx_complete(&tracker, peer_mac1, true, &completion));
+    TEST_ASSERT_EQUAL_INT(1U, tracker.unmatched_completions);
+}
+
+void test_espnow_link_tx_cancel_last(void)
+{
+    ESPNOW_LINK_TX_HANDLE_T first;
+    ESPNOW_LINK_TX_HANDLE_T cancelled;
+
+    espnow_link_tx_reserve(&tracker, peer_mac1, NULL, NULL, &first);
+    espnow_link_tx_reserve(&tracker, peer_mac2, NULL, NULL, &cancelled);
+
+    /* esp_now_send() refused the second frame */
+    espnow_link_tx_cancel_last(&tracker);
+
+    TEST_ASSERT_EQUAL_INT(1U, espnow_link_tx_in_flight(&tracker));
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_FREE, espnow_link_tx_get_state(&tracker, cancelled));
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_PENDING, espnow_link_tx_get_state(&tracker, first));
+}
+
+void test_espnow_link_tx_invalid_handle(void)
+{
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_TX_STATE_FREE, espnow_link_tx_get_state(&tracker, ESPNOW_LINK_TX_INVALID_HANDLE));
+}
@@ -0,0 +1,345 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "jitter_buffer.h"
+#include "adpcm.h"
+#include "audio_vad.h"
+
+#define TEST_BLOCKS (64U)
+#define FRAME_US (JITTER_BUFFER_FRAME_US)
+#define SIM_FRAMES (1200U)
+#define SIM_WARMUP_FRAMES (100U)
+
+static JITTER_BUFFER_T jb;
+static uint8_t blocks[TEST_BLOCKS][ADPCM_BLOCK_BYTES];
+static uint16_t lengths[TEST_BLOCKS];
+static int16_t decoded[TEST_BLOCKS][ADPCM_BLOCK_SAMPLES];
+static int16_t pcm[ADPCM_BLOCK_SAMPLES];
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t concealed;
+    uint64_t latency_us;
+} SIM_RESULT_T;
+
+/* whole cycles of test tone per block, about 400 Hz, so a block replayed for concealment starts
+   where the last one left off */
+#define TONE_CYCLES (12)
+#define TONE_COEF_Q15 ((int32_t)((6.2831853 * TONE_CYCLES * 32768.0) / ADPCM_BLOCK_SAMPLES))
+
+/* tone, encoded once and decoded on its own for reference */
+static void make_blocks(void)
+{
+    ADPCM_STATE_T state;
+    int16_t tone[ADPCM_BLOCK_SAMPLES];
+    int32_t x = 0;
+    int32_t y = 12000;
+    uint32_t b;
+    uint32_t i;
+
+    adpcm_init(&state);
+
+    for (b = 0U; b < TEST_BLOCKS; b++)
+    {
+        for (i = 0U; i < ADPCM_BLOCK_SAMPLES; i++)
+        {
+            x -= (TONE_COEF_Q15 * y) >> 15;
+            y += (TONE_COEF_Q15 * x) >> 15;
+            tone[i] = (int16_t)y;
+        }
+
+        lengths[b] = adpcm_encode_block(&state, tone, ADPCM_BLOCK_SAMPLES, blocks[b]);
+        TEST_ASSERT_EQUAL_UINT16(ADPCM_BLOCK_SAMPLES, adpcm_decode_block(blocks[b], lengths[b], decoded[b], NULL));
+    }
+}
+
+static bool put(uint32_t seq, uint32_t now_us)
+{
+    return jitter_buffer_put(&jb, seq, blocks[seq % TEST_BLOCKS], lengths[seq % TEST_BLOCKS], now_us);
+}
+
+static uint32_t xorshift(uint32_t* s)
+{
+    *s ^= *s << 13U;
+    *s ^= *s >> 17U;
+    *s ^= *s << 5U;
+    return *s;
+}
+
+/* sender sends a block every frame, each arrives after 5 ms plus up to jitter_us. Playback takes
+   a frame every frame period, offset half a frame from the sender */
+static void simulate(uint32_t first, uint32_t frames, uint32_t jitter_us, uint32_t* seed, SIM_RESULT_T* result)
+{
+    static uint32_t arrival[SIM_FRAMES + JITTER_BUFFER_SLOTS];
+    uint32_t tick;
+    uint32_t now_us;
+    uint32_t seq;
+    uint32_t played_seq;
+    JITTER_BUFFER_RESULT_T got;
+
+    for (seq = first; seq < (first + frames + JITTER_BUFFER_SLOTS); seq++)
+    {
+        arrival[seq] = (seq * FRAME_US) + 5000U + ((jitter_us == 0U) ? 0U : (xorshift(seed) % jitter_us));
+    }
+
+    memset(result, 0, sizeof(*result));
+
+    for (tick = first; tick < (first + frames); tick++)
+    {
+        now_us = (tick * FRAME_US) + (FRAME_US / 2U);
+
+        /* everything that has arrived since the last tick, in arrival order */
+        for (;;)
+        {
+            uint32_t earliest = UINT32_MAX;
+            uint32_t pick = 0U;
+
+            for (seq = (first > JITTER_BUFFER_SLOTS) ? (first - JITTER_BUFFER_SLOTS) : 0U;
+                 seq < (tick + JITTER_BUFFER_SLOTS);
+                 seq++)
+            {
+                if ((seq >= first) && (arrival[seq] <= now_us) && (arrival[seq] < earliest))
+                {
+                    earliest = arrival[seq];
+                    pick = seq;
+                }
+            }
+
+            if (earliest == UINT32_MAX)
+            {
+                break;
+            }
+
+            (void)put(pick, earliest);
+            arrival[pick] = UINT32_MAX;
+        }
+
+        played_seq = jb.next_seq;
+        got = jitter_buffer_get(&jb, now_us, pcm);
+
+        if ((tick - first) >= SIM_WARMUP_FRAMES)
+        {
+            result->frames++;
+            result->concealed += (got == JITTER_BUFFER_FRAME) ? 0U : 1U;
+
+            if (got == JITTER_BUFFER_FRAME)
+            {
+                result->latency_us += now_us - (played_seq * FRAME_US);
+            }
+        }
+    }
+}
+
+void setUp(void)
+{
+    make_blocks();
+    jitter_buffer_init(&jb);
+}
+
+void tearDown(void) { }
+
+void test_jitter_buffer_plays_in_order(void)
+{
+    uint32_t seq;
+
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_IDLE, jitter_buffer_get(&jb, 0U, pcm));
+    TEST_ASSERT_EACH_EQUAL_INT16(0, pcm, ADPCM_BLOCK_SAMPLES);
+
+    for (seq = 0U; seq < 10U; seq++)
+    {
+        TEST_ASSERT(put(seq, seq * FRAME_US));
+        TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, seq * FRAME_US, pcm));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[seq], pcm, ADPCM_BLOCK_SAMPLES);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(10U, jb.stats.played);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.concealed);
+    TEST_ASSERT_EQUAL_UINT8(JITTER_BUFFER_MIN_FRAMES, jb.target_frames);
+}
+
+void test_jitter_buffer_reorders(void)
+{
+    TEST_ASSERT(put(1U, 0U));
+    TEST_ASSERT(put(0U, 100U));
+    TEST_ASSERT(put(2U, 200U));
+
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 300U, pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[0], pcm, ADPCM_BLOCK_SAMPLES);
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 300U + FRAME_US, pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[1], pcm, ADPCM_BLOCK_SAMPLES);
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 300U + (2U * FRAME_US), pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[2], pcm, ADPCM_BLOCK_SAMPLES);
+}
+
+void test_jitter_buffer_conceals_lost_block_without_a_step(void)
+{
+    int16_t last;
+    int32_t step;
+
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT(put(2U, 2U * FRAME_US));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 0U, pcm));
+    last = pcm[ADPCM_BLOCK_SAMPLES - 1U];
+
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_CONCEALED, jitter_buffer_get(&jb, FRAME_US, pcm));
+    step = pcm[0] - last;
+    TEST_ASSERT_INT_WITHIN(2000, 0, step);
+
+    /* fading, not silent, not as loud as the tone */
+    TEST_ASSERT(pcm[ADPCM_BLOCK_SAMPLES / 2U] != 0);
+
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 2U * FRAME_US, pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(&decoded[2][JITTER_BUFFER_CROSSFADE_SAMPLES],
+                                  &pcm[JITTER_BUFFER_CROSSFADE_SAMPLES],
+                                  ADPCM_BLOCK_SAMPLES - JITTER_BUFFER_CROSSFADE_SAMPLES);
+
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.lost);
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.concealed);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.underruns);
+}
+
+void test_jitter_buffer_underrun_waits_for_late_block(void)
+{
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 0U, pcm));
+
+    /* block 1 is slow, its turn is held */
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_CONCEALED, jitter_buffer_get(&jb, FRAME_US, pcm));
+    TEST_ASSERT(put(1U, FRAME_US + 5000U));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 2U * FRAME_US, pcm));
+
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.underruns);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.lost);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.late);
+    TEST_ASSERT_EQUAL_UINT32(2U, jb.stats.played);
+}
+
+void test_jitter_buffer_drops_late_and_duplicate_blocks(void)
+{
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT(put(1U, FRAME_US));
+    TEST_ASSERT_FALSE(put(1U, FRAME_US + 10U));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, FRAME_US, pcm));
+    TEST_ASSERT_FALSE(put(0U, FRAME_US + 20U));
+    TEST_ASSERT_FALSE(jitter_buffer_put(&jb, 2U, blocks[2], ADPCM_HDR_BYTES - 1U, FRAME_US));
+
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.late);
+    TEST_ASSERT_EQUAL_UINT32(2U, jb.stats.received);
+}
+
+void test_jitter_buffer_fades_out_and_restarts(void)
+{
+    uint32_t f;
+
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 0U, pcm));
+
+    for (f = 1U; f <= JITTER_BUFFER_CONCEAL_FRAMES; f++)
+    {
+        TEST_ASSERT_EQUAL(JITTER_BUFFER_CONCEALED, jitter_buffer_get(&jb, f * FRAME_US, pcm));
+    }
+
+    /* last concealed frame ends silent */
+    TEST_ASSERT_INT_WITHIN(50, 0, pcm[ADPCM_BLOCK_SAMPLES - 1U]);
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_IDLE, jitter_buffer_get(&jb, f * FRAME_US, pcm));
+    TEST_ASSERT_FALSE(jb.playing);
+
+    /* a new stream may start anywhere */
+    TEST_ASSERT(put(40U, 40U * FRAME_US));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 40U * FRAME_US, pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[40], pcm, ADPCM_BLOCK_SAMPLES);
+}
+
+void test_jitter_buffer_resyncs_when_far_behind(void)
+{
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 0U, pcm));
+    TEST_ASSERT(put(1U + JITTER_BUFFER_SLOTS, FRAME_US));
+
+    TEST_ASSERT_EQUAL_UINT32(1U, jb.stats.resyncs);
+    TEST_ASSERT_EQUAL_UINT32(1U + JITTER_BUFFER_SLOTS, jb.next_seq);
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 10U * FRAME_US, pcm));
+}
+
+void test_jitter_buffer_fills_silence_with_comfort_noise(void)
+{
+    uint8_t sid[AUDIO_VAD_SID_BYTES] = {AUDIO_VAD_SID_MAGIC, 25U};
+    uint32_t sum = 0U;
+    uint32_t f;
+    uint32_t i;
+
+    TEST_ASSERT(put(0U, 0U));
+    TEST_ASSERT(jitter_buffer_put(&jb, 1U, sid, sizeof(sid), FRAME_US));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, FRAME_US, pcm));
+
+    /* nothing more is sent through the silence, and it doesn't count against the link */
+    for (f = 2U; f < 20U; f++)
+    {
+        TEST_ASSERT_EQUAL(JITTER_BUFFER_COMFORT, jitter_buffer_get(&jb, f * FRAME_US, pcm));
+    }
+
+    for (i = 0U; i < ADPCM_BLOCK_SAMPLES; i++)
+    {
+        sum += (uint32_t)((pcm[i] < 0) ? -pcm[i] : pcm[i]);
+    }
+
+    TEST_ASSERT_UINT32_WITHIN(20U, 25U << AUDIO_VAD_SID_LEVEL_SHIFT, sum / ADPCM_BLOCK_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.concealed);
+    TEST_ASSERT_EQUAL_UINT32(18U, jb.stats.comfort);
+
+    /* talking again, numbered straight on from the marker, plays without a resync */
+    TEST_ASSERT(put(2U, 20U * FRAME_US));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_FRAME, jitter_buffer_get(&jb, 20U * FRAME_US, pcm));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(decoded[2], pcm, ADPCM_BLOCK_SAMPLES);
+    TEST_ASSERT_EQUAL_UINT32(0U, jb.stats.resyncs);
+
+    /* markers stop coming, the noise ends after a few missed refreshes */
+    TEST_ASSERT(jitter_buffer_put(&jb, 3U, sid, sizeof(sid), 21U * FRAME_US));
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_COMFORT, jitter_buffer_get(&jb, 21U * FRAME_US, pcm));
+
+    for (f = 1U; f < JITTER_BUFFER_COMFORT_FRAMES; f++)
+    {
+        TEST_ASSERT_EQUAL(JITTER_BUFFER_COMFORT, jitter_buffer_get(&jb, (21U + f) * FRAME_US, pcm));
+    }
+
+    TEST_ASSERT_EQUAL(JITTER_BUFFER_IDLE, jitter_buffer_get(&jb, (21U + f) * FRAME_US, pcm));
+    TEST_ASSERT_EACH_EQUAL_INT16(0, pcm, ADPCM_BLOCK_SAMPLES);
+}
+
+void test_jitter_buffer_adapts_to_link(void)
+{
+    SIM_RESULT_T still;
+    SIM_RESULT_T jittery;
+    SIM_RESULT_T settled;
+    uint32_t seed = 0x2545F491U;
+    uint8_t jittery_target;
+
+    simulate(0U, 300U, 0U, &seed, &still);
+    TEST_ASSERT_EQUAL_UINT32(0U, still.concealed);
+    TEST_ASSERT_EQUAL_UINT8(JITTER_BUFFER_MIN_FRAMES, jb.target_frames);
+
+    /* up to 2 frames of jitter, depth grows until playback is glitch free */
+    simulate(300U, 600U, 2U * FRAME_US, &seed, &jittery);
+    jittery_target = jb.target_frames;
+    TEST_ASSERT(jittery_target > JITTER_BUFFER_MIN_FRAMES);
+    TEST_ASSERT(jittery.concealed <= (jittery.frames / 100U));
+
+    /* link calms down, depth and latency come back down */
+    simulate(900U, 300U, 0U, &seed, &settled);
+    TEST_ASSERT(jb.target_frames < jittery_target);
+    TEST_ASSERT(jb.stats.dropped > 0U);
+    TEST_ASSERT_EQUAL_UINT32(0U, settled.concealed);
+    TEST_ASSERT((settled.latency_us / settled.frames) < (jittery.latency_us / jittery.frames));
+
+    printf("link            latency ms  concealed\n");
+    printf("still           %10.1f  %u/%u\n", (double)still.latency_us / still.frames / 1000.0,
+           (unsigned)still.concealed, (unsigned)still.frames);
+    printf("jitter 0-%2u ms  %10.1f  %u/%u\n", (unsigned)((2U * FRAME_US) / 1000U),
+           (double)jittery.latency_us / jittery.frames / 1000.0, (unsigned)jittery.concealed, (unsigned)jittery.frames);
+    printf("settled         %10.1f  %u/%u\n", (double)settled.latency_us / settled.frames / 1000.0,
+           (unsigned)settled.concealed, (unsigned)settled.frames);
+}
@@ -0,0 +1,122 @@
+#include "unity.h"
+
+#include <stdarg.h>
+#include <string.h>
+
+#include "log_ring.h"
+
+#define TAG "LOG_RING_TEST"
+
+static LOG_RING_T ring;
+static LOG_RECORD_T record;
+static char text[128];
+
+static bool push(uint8_t level, const char* format, ...)
+{
+    va_list args;
+    bool pushed;
+
+    va_start(args, format);
+    pushed = log_ring_push(&ring, level, TAG, format, 1234U, args);
+    va_end(args);
+
+    return pushed;
+}
+
+static const char* pop_text(void)
+{
+    TEST_ASSERT(log_ring_pop(&ring, &record));
+    (void)log_record_format(&record, text, sizeof(text));
+
+    return text;
+}
+
+void setUp(void)
+{
+    log_ring_init(&ring);
+}
+
+void tearDown(void) { }
+
+void test_log_ring_formats_later_what_printf_would_now(void)
+{
+    unsigned long big = 4000000000UL;
+    long long huge = -123456789012345LL;
+    char expected[128];
+
+    TEST_ASSERT(push(3U, "plain"));
+    TEST_ASSERT(push(2U, "%d%% of %lu, %lld, %zu [%-5s] %c %04X %.2f", -42, big, huge, sizeof(record), "ab", 'z',
+                     0xBEEFU, 2.5));
+    TEST_ASSERT(push(1U, "mac " "%02x:%02x:%02x:%02x:%02x:%02x", 1, 2, 3, 0xaa, 0xbb, 0xcc));
+
+    TEST_ASSERT_EQUAL_STRING("plain", pop_text());
+    TEST_ASSERT_EQUAL_UINT8(3U, record.level);
+    TEST_ASSERT_EQUAL_STRING(TAG, record.tag);
+    TEST_ASSERT_EQUAL_UINT32(1234U, record.timestamp_ms);
+
+    (void)snprintf(expected, sizeof(expected), "%d%% of %lu, %lld, %zu [%-5s] %c %04X %.2f", -42, big, huge,
+                   sizeof(record), "ab", 'z', 0xBEEFU, 2.5);
+    TEST_ASSERT_EQUAL_STRING(expected, pop_text());
+    TEST_ASSERT_EQUAL_STRING("mac 01:02:03:aa:bb:cc", pop_text());
+    TEST_ASSERT_FALSE(log_ring_pop(&ring, &record));
+}
+
+void test_log_ring_copies_strings_when_logged(void)
+{
+    char name[8] = "first";
+
+    TEST_ASSERT(push(3U, "name %s, %s", name, NULL));
+    strcpy(name, "second");
+
+    TEST_ASSERT_EQUAL_STRING("name first, (null)", pop_text());
+}
+
+void test_log_ring_marks_arguments_that_dont_fit(void)
+{
+    char long_string[LOG_RING_ARG_BYTES * 2U];
+
+    memset(long_string, 'x', sizeof(long_string) - 1U);
+    long_string[sizeof(long_string) - 1U] = '\0';
+
+    TEST_ASSERT(push(3U, "%d %s %d", 7, long_string, 8));
+    (void)pop_text();
+    TEST_ASSERT(record.truncated);
+    TEST_ASSERT_EQUAL_UINT32(LOG_RING_ARG_BYTES, record.arg_bytes);
+    TEST_ASSERT_EQUAL_UINT32(2U + (LOG_RING_ARG_BYTES - sizeof(int) - 1U) + 1U + 3U, strlen(text));
+    TEST_ASSERT_EQUAL_STRING("...", &text[strlen(text) - 3U]);
+
+    /* * width isn't stored, record ends where it starts */
+    TEST_ASSERT(push(3U, "a %d b %*d c", 1, 4, 2));
+    TEST_ASSERT_EQUAL_STRING("a 1 b ...", pop_text());
+
+    /* output is cut to fit too */
+    TEST_ASSERT(push(3U, "0123456789 %d", 10));
+    TEST_ASSERT(log_ring_pop(&ring, &record));
+    TEST_ASSERT_EQUAL_UINT32(7U, log_record_format(&record, text, 8U));
+    TEST_ASSERT_EQUAL_STRING("0123456", text);
+}
+
+void test_log_ring_drops_and_counts_when_full(void)
+{
+    uint32_t i;
+    uint32_t lap;
+
+    for (lap = 0U; lap < 3U; lap++)
+    {
+        for (i = 0U; i < LOG_RING_RECORDS; i++)
+        {
+            TEST_ASSERT(push(3U, "record %lu", (unsigned long)i));
+        }
+
+        TEST_ASSERT_FALSE(push(3U, "record %lu", (unsigned long)i));
+        TEST_ASSERT_EQUAL_UINT32(lap + 1U, log_ring_dropped(&ring));
+
+        for (i = 0U; i < LOG_RING_RECORDS; i++)
+        {
+            (void)snprintf(text, sizeof(text), "record %lu", (unsigned long)i);
+            TEST_ASSERT_EQUAL_STRING(text, pop_text());
+        }
+
+        TEST_ASSERT_FALSE(log_ring_pop(&ring, &record));
+    }
+}
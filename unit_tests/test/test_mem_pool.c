@@ -0,0 +1,134 @@
+#include "unity.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "mem_pool.h"
+
+#define BLOCK_BYTES (10U)
+#define BLOCKS (5U)
+
+MEM_POOL_STORAGE(storage, BLOCK_BYTES, BLOCKS);
+MEM_POOL_STORAGE(other_storage, 4U, MEM_POOL_MAX_BLOCKS);
+
+static MEM_POOL_T pool;
+static MEM_POOL_T other_pool;
+
+void setUp(void)
+{
+    TEST_ASSERT(mem_pool_init(&pool, "test", storage, BLOCK_BYTES, BLOCKS));
+}
+
+void tearDown(void) { }
+
+void test_mem_pool_hands_out_every_block_once(void)
+{
+    uint8_t* blocks[BLOCKS];
+    uint32_t i;
+    uint32_t j;
+
+    TEST_ASSERT_EQUAL_UINT32(12U, MEM_POOL_BLOCK_STRIDE(BLOCK_BYTES));
+
+    for (i = 0U; i < BLOCKS; i++)
+    {
+        blocks[i] = (uint8_t*)mem_pool_alloc(&pool);
+        TEST_ASSERT_NOT_NULL(blocks[i]);
+        TEST_ASSERT_EQUAL_UINT32(0U, (uintptr_t)blocks[i] % MEM_POOL_ALIGN);
+        memset(blocks[i], (int)i, BLOCK_BYTES);
+
+        for (j = 0U; j < i; j++)
+        {
+            /* blocks never overlap */
+            TEST_ASSERT(((blocks[i] - blocks[j]) >= (ptrdiff_t)BLOCK_BYTES) ||
+                        ((blocks[j] - blocks[i]) >= (ptrdiff_t)BLOCK_BYTES));
+            TEST_ASSERT_EQUAL_UINT8(j, blocks[j][BLOCK_BYTES - 1U]);
+        }
+    }
+
+    TEST_ASSERT_NULL(mem_pool_alloc(&pool));
+    TEST_ASSERT_EQUAL_UINT32(0U, mem_pool_available(&pool));
+
+    /* freed block is the one handed out next */
+    mem_pool_free(&pool, blocks[2]);
+    TEST_ASSERT_EQUAL_UINT32(1U, mem_pool_available(&pool));
+    TEST_ASSERT_EQUAL_PTR(blocks[2], mem_pool_alloc(&pool));
+}
+
+void test_mem_pool_counts_high_water_and_failures(void)
+{
+    MEM_POOL_STATS_T stats;
+    void* a = mem_pool_alloc(&pool);
+    void* b = mem_pool_alloc(&pool);
+    void* c = mem_pool_alloc(&pool);
+
+    mem_pool_free(&pool, b);
+    mem_pool_free(&pool, c);
+    b = mem_pool_alloc(&pool);
+
+    mem_pool_get_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_STRING("test", stats.name);
+    TEST_ASSERT_EQUAL_UINT32(BLOCK_BYTES, stats.block_bytes);
+    TEST_ASSERT_EQUAL_UINT32(BLOCKS, stats.blocks);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.in_use);
+    TEST_ASSERT_EQUAL_UINT32(3U, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.alloc_failures);
+
+    while (mem_pool_alloc(&pool) != NULL)
+    {
+    }
+
+    TEST_ASSERT_NULL(mem_pool_alloc(&pool));
+    mem_pool_get_stats(&pool, &stats);
+    TEST_ASSERT_EQUAL_UINT32(BLOCKS, stats.high_water);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.alloc_failures);
+
+    mem_pool_free(&pool, a);
+    mem_pool_free(&pool, b);
+}
+
+void test_mem_pool_ignores_foreign_blocks(void)
+{
+    uint8_t* block = (uint8_t*)mem_pool_alloc(&pool);
+    uint32_t outside;
+
+    mem_pool_free(&pool, NULL);
+    mem_pool_free(&pool, &outside);
+    mem_pool_free(&pool, block + 1U);
+    mem_pool_free(&pool, (uint8_t*)storage + (BLOCKS * MEM_POOL_BLOCK_STRIDE(BLOCK_BYTES)));
+    TEST_ASSERT_EQUAL_UINT32(BLOCKS - 1U, mem_pool_available(&pool));
+
+    mem_pool_free(&pool, block);
+    TEST_ASSERT_EQUAL_UINT32(BLOCKS, mem_pool_available(&pool));
+}
+
+void test_mem_pool_rejects_bad_setup(void)
+{
+    TEST_ASSERT_FALSE(mem_pool_init(&other_pool, "bad", NULL, 4U, 1U));
+    TEST_ASSERT_FALSE(mem_pool_init(&other_pool, "bad", (uint8_t*)other_storage + 1U, 4U, 1U));
+    TEST_ASSERT_FALSE(mem_pool_init(&other_pool, "bad", other_storage, 0U, 1U));
+    TEST_ASSERT_FALSE(mem_pool_init(&other_pool, "bad", other_storage, 4U, 0U));
+    TEST_ASSERT_FALSE(mem_pool_init(&other_pool, "bad", other_storage, 4U, MEM_POOL_MAX_BLOCKS + 1U));
+
+    /* a full word of blocks */
+    TEST_ASSERT(mem_pool_init(&other_pool, "other", other_storage, 4U, MEM_POOL_MAX_BLOCKS));
+    TEST_ASSERT_EQUAL_UINT32(MEM_POOL_MAX_BLOCKS, mem_pool_available(&other_pool));
+}
+
+void test_mem_pool_registers_each_pool_once(void)
+{
+    MEM_POOL_T* registered;
+    uint32_t seen_pool = 0U;
+    uint32_t seen_other = 0U;
+
+    TEST_ASSERT(mem_pool_init(&other_pool, "other", other_storage, 4U, 2U));
+    TEST_ASSERT(mem_pool_init(&pool, "test", storage, BLOCK_BYTES, BLOCKS));
+
+    for (registered = mem_pool_first(); registered != NULL; registered = mem_pool_next(registered))
+    {
+        seen_pool += (registered == &pool) ? 1U : 0U;
+        seen_other += (registered == &other_pool) ? 1U : 0U;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(1U, seen_pool);
+    TEST_ASSERT_EQUAL_UINT32(1U, seen_other);
+}
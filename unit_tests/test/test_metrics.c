@@ -0,0 +1,124 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "metrics.h"
+
+static METRICS_SNAPSHOT_T snapshot;
+
+static void mac_of(uint8_t id, uint8_t* mac)
+{
+    memset(mac, 0x40, METRICS_MAC_BYTES);
+    mac[METRICS_MAC_BYTES - 1U] = id;
+}
+
+void setUp(void)
+{
+    metrics_reset();
+}
+
+void tearDown(void) { }
+
+void test_metrics_counters_and_gauges(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < 5U; i++)
+    {
+        metrics_inc(METRIC_LINK_TX_ATTEMPTS);
+    }
+
+    metrics_inc(METRIC_LINK_TX_FAILED);
+    metrics_gauge_max(METRIC_LINK_RX_QUEUE_HWM, 300U);
+    metrics_gauge_max(METRIC_LINK_RX_QUEUE_HWM, 100U);
+
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(5U, snapshot.values[METRIC_LINK_TX_ATTEMPTS]);
+    TEST_ASSERT_EQUAL_UINT32(1U, snapshot.values[METRIC_LINK_TX_FAILED]);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.values[METRIC_LINK_TX_ACKED]);
+    TEST_ASSERT_EQUAL_UINT32(300U, snapshot.values[METRIC_LINK_RX_QUEUE_HWM]);
+
+    metrics_reset();
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.values[METRIC_LINK_TX_ATTEMPTS]);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.values[METRIC_LINK_RX_QUEUE_HWM]);
+}
+
+void test_metrics_timer_min_mean_max(void)
+{
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.timers[METRIC_TIMER_LINK_SEND].count);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.timers[METRIC_TIMER_LINK_SEND].min_us);
+
+    metrics_timer_add(METRIC_TIMER_LINK_SEND, 900U);
+    metrics_timer_add(METRIC_TIMER_LINK_SEND, 1500U);
+    metrics_timer_add(METRIC_TIMER_LINK_SEND, 600U);
+
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(3U, snapshot.timers[METRIC_TIMER_LINK_SEND].count);
+    TEST_ASSERT_EQUAL_UINT32(600U, snapshot.timers[METRIC_TIMER_LINK_SEND].min_us);
+    TEST_ASSERT_EQUAL_UINT32(1000U, snapshot.timers[METRIC_TIMER_LINK_SEND].mean_us);
+    TEST_ASSERT_EQUAL_UINT32(1500U, snapshot.timers[METRIC_TIMER_LINK_SEND].max_us);
+}
+
+void test_metrics_peer_rssi(void)
+{
+    uint8_t mac[METRICS_MAC_BYTES];
+
+    mac_of(1U, mac);
+    metrics_peer_rssi(mac, -40);
+    metrics_peer_rssi(mac, -60);
+    mac_of(2U, mac);
+    metrics_peer_rssi(mac, -80);
+    mac_of(1U, mac);
+    metrics_peer_rssi(mac, -50);
+
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(2U, snapshot.peer_count);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(mac, snapshot.peers[0].mac, METRICS_MAC_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(3U, snapshot.peers[0].frames);
+    TEST_ASSERT_EQUAL_INT(-50, snapshot.peers[0].last_rssi);
+    TEST_ASSERT_EQUAL_INT(-60, snapshot.peers[0].min_rssi);
+    TEST_ASSERT_EQUAL_INT(-50, snapshot.peers[0].mean_rssi);
+    TEST_ASSERT_EQUAL_INT(-40, snapshot.peers[0].max_rssi);
+    TEST_ASSERT_EQUAL_UINT32(1U, snapshot.peers[1].frames);
+    TEST_ASSERT_EQUAL_INT(-80, snapshot.peers[1].mean_rssi);
+}
+
+void test_metrics_peer_table_fills_up(void)
+{
+    uint8_t mac[METRICS_MAC_BYTES];
+    uint32_t i;
+
+    /* peers past the table are ignored, the ones already in it keep counting */
+    for (i = 0U; i <= METRICS_MAX_PEERS; i++)
+    {
+        mac_of((uint8_t)i, mac);
+        metrics_peer_rssi(mac, -70);
+    }
+
+    mac_of(0U, mac);
+    metrics_peer_rssi(mac, -70);
+
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(METRICS_MAX_PEERS, snapshot.peer_count);
+    TEST_ASSERT_EQUAL_UINT32(2U, snapshot.peers[0].frames);
+
+    metrics_reset();
+    metrics_snapshot(&snapshot);
+    TEST_ASSERT_EQUAL_UINT32(0U, snapshot.peer_count);
+}
+
+void test_metrics_names(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < METRIC_COUNT; i++)
+    {
+        TEST_ASSERT_NOT_NULL(metrics_name((METRIC_ID_T)i));
+        TEST_ASSERT(strlen(metrics_name((METRIC_ID_T)i)) > 0U);
+    }
+
+    TEST_ASSERT_EQUAL_STRING("link_tx_failed", metrics_name(METRIC_LINK_TX_FAILED));
+    TEST_ASSERT_EQUAL_STRING("link_send_us", metrics_timer_name(METRIC_TIMER_LINK_SEND));
+}
@@ -0,0 +1,959 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim_link.h"
+#include "sim_wt20_node0.h"
+#include "sim_wt20_node1.h"
+#include "sim_wt20_node2.h"
+#include "espnow_link_ring.h"
+#include "espnow_link_tx.h"
+#include "wt20_frag.h"
+#include "wt20_bulk.h"
+#include "wt20_fec.h"
+#include "gf256.h"
+#include "wt20_header.h"
+#include "crc16.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "wt20_peer.h"
+#include "wt20_group.h"
+#include "wt20_relay.h"
+#include "wt20_chan.h"
+#include "wt20_vrate.h"
+#include "adpcm.h"
+#include "espnow_link_chan.h"
+#include "espnow_link_rate.h"
+
+#define SEED (0x2545F491U)
+
+/* how often each node's receiving task gets to run */
+#define TICK_US (1000U)
+
+#define STREAM_FRAME_US (29000U)
+#define STREAM_FRAMES (400U)
+
+#define MESSAGE_BYTES (WT20_FRAG_MAX_MESSAGE_BYTES)
+
+/* relay tests tick finer, so forwards go out close to when their backoff ends */
+#define RELAY_TICK_US (100U)
+#define RELAY_FRAMES (200U)
+#define RELAY_FRAME_US (20000U)
+
+#define SURVEY_DWELL_MS (20U)
+#define CHANNEL_TEST_FRAMES (100U)
+
+#define RATE_TEST_FRAMES (300U)
+
+/* live talk over a channel foreign traffic keeps busy most of the time. Capture hands over a
+   block every STREAM_FRAME_US and has AUDIO_FRAME_POOL_FRAMES buffers to queue them in */
+#define VOICE_FRAMES (300U)
+#define VOICE_QUEUE_FRAMES (8U)
+#define VOICE_LOAD_PERMILLE (890U)
+
+typedef struct
+{
+    bool done;
+    bool success;
+    uint64_t finished_us;
+} TRANSFER_T;
+
+typedef struct
+{
+    uint32_t frames;
+    uint32_t recovered;
+    uint32_t next_seq;
+    uint32_t gaps;
+} STREAM_T;
+
+typedef struct
+{
+    uint64_t finished_us;
+    uint32_t frames_sent;
+} RUN_RESULT_T;
+
+static const SIM_WT20_T* const stacks[] = {&sim_wt20_node0, &sim_wt20_node1, &sim_wt20_node2};
+
+static uint8_t message[MESSAGE_BYTES];
+static uint32_t received_bytes;
+static bool received_match;
+static TRANSFER_T transfer;
+static STREAM_T stream;
+
+/* bursty link: mostly clean, with bursts averaging 4 frames that lose 3 in 4 */
+static const SIM_LINK_PARAMS_T bursty = {
+    .latency_us = 300U,
+    .jitter_us = 200U,
+    .loss_good_ppm = 10000U,
+    .loss_bad_ppm = 750000U,
+    .good_to_bad_ppm = 20000U,
+    .bad_to_good_ppm = 250000U,
+    .rssi_dbm = -82
+};
+
+typedef struct
+{
+    uint64_t captured_us[VOICE_FRAMES]; /* by seq, when capture handed the block over */
+    uint32_t sent;
+    uint32_t overruns;                  /* blocks capture dropped with every buffer queued */
+    uint32_t delivered;
+    uint32_t modes[ADPCM_MODES];
+    uint64_t latency_sum_us;
+    uint64_t latency_max_us;
+    bool decoded;
+} VOICE_T;
+
+static VOICE_T voice;
+
+static bool group_heard[2U][STREAM_FRAMES];
+static uint32_t group_repaired;
+
+/* per node, relayed frames delivered and their total latency from the origin's write */
+static uint64_t relay_sent_us[RELAY_FRAMES];
+static uint32_t relay_delivered[3U];
+static uint64_t relay_latency_us[3U];
+
+static void drain(const WT20_MSG_T* msg, void* context) { }
+
+static void message_received(const uint8_t* src_mac, const uint8_t* data, uint32_t length, void* context)
+{
+    received_bytes = length;
+    received_match = (length == MESSAGE_BYTES) && (memcmp(data, message, length) == 0);
+}
+
+static void transfer_done(bool success, void* context)
+{
+    transfer.done = true;
+    transfer.success = success;
+    transfer.finished_us = sim_link_now_us();
+}
+
+static void stream_frame(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    stream.frames++;
+    stream.recovered += recovered ? 1U : 0U;
+    stream.gaps += seq - stream.next_seq;
+    stream.next_seq = seq + 1U;
+}
+
+/* from capture to the listener's stream callback */
+static void voice_frame(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    int16_t pcm[ADPCM_BLOCK_SAMPLES];
+    uint64_t latency_us;
+    ADPCM_MODE_T mode = adpcm_block_mode(frame, length);
+
+    if ((seq >= voice.sent) || (mode == ADPCM_MODES))
+    {
+        voice.decoded = false;
+        return;
+    }
+
+    latency_us = sim_link_now_us() - voice.captured_us[seq];
+    voice.delivered++;
+    voice.modes[mode]++;
+    voice.latency_sum_us += latency_us;
+    voice.latency_max_us = (latency_us > voice.latency_max_us) ? latency_us : voice.latency_max_us;
+
+    /* fec pads to its frame length, which may be more than a block */
+    length = (length > adpcm_block_bytes(mode, ADPCM_BLOCK_SAMPLES)) ? adpcm_block_bytes(mode, ADPCM_BLOCK_SAMPLES) : length;
+    voice.decoded &= (adpcm_decode_block(frame, length, pcm, NULL) == ADPCM_BLOCK_SAMPLES);
+}
+
+static void voice_rx_task(uint32_t node, void* context)
+{
+    (void)stacks[node]->receive_all(drain, NULL, 0U, NULL);
+}
+
+static void group_frame(uint8_t group, const uint8_t* src_mac, uint16_t seq, const uint8_t* frame, uint16_t length,
+                        bool repaired, void* context)
+{
+    group_heard[(uintptr_t)context][seq] = true;
+    group_repaired += repaired ? 1U : 0U;
+}
+
+static void relay_frame(const WT20_MSG_T* msg, void* context)
+{
+    uintptr_t node = (uintptr_t)context;
+    uint32_t index;
+
+    if ((msg->command != WT20_COMMAND_SEND_PAYLOAD) || (msg->length < sizeof(index)))
+    {
+        return;
+    }
+
+    /* arrives as if straight from node 0 */
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sim_link_mac(0U), msg->src_mac, 6U);
+    memcpy(&index, msg->payload, sizeof(index));
+    relay_delivered[node]++;
+    relay_latency_us[node] += sim_link_now_us() - relay_sent_us[index];
+}
+
+/* node 0 writes RELAY_FRAMES relayed frames to dest_mac, with every node reading each RELAY_TICK_US */
+static void run_relay(const uint8_t* dest_mac)
+{
+    uint8_t payload[100] = {0};
+    uint64_t start_us = sim_link_now_us();
+    uint32_t i;
+    uintptr_t node;
+
+    memset(relay_delivered, 0, sizeof(relay_delivered));
+    memset(relay_latency_us, 0, sizeof(relay_latency_us));
+
+    for (i = 0U; i < RELAY_FRAMES; i++)
+    {
+        memcpy(payload, &i, sizeof(i));
+        relay_sent_us[i] = sim_link_now_us();
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->write_relayed(dest_mac, WT20_COMMAND_SEND_PAYLOAD, payload, sizeof(payload)));
+
+        while (sim_link_now_us() < (start_us + ((uint64_t)(i + 1U) * RELAY_FRAME_US)))
+        {
+            for (node = 0U; node < 3U; node++)
+            {
+                (void)stacks[node]->receive_all(relay_frame, (void*)node, 0U, NULL);
+            }
+
+            sim_link_run_until(sim_link_now_us() + RELAY_TICK_US);
+        }
+    }
+}
+
+/* a lossy link may leave a write unacked, nothing else may go wrong */
+static void assert_written(WT20_ERR_T err)
+{
+    TEST_ASSERT((err == WT20_ERR_NONE) || (err == WT20_SEND_FAILURE));
+}
+
+/* gives each node's receiving task a turn every tick until done or until_us */
+static void run_nodes(uint32_t count, uint64_t until_us, const bool* done)
+{
+    uint32_t i;
+
+    while ((sim_link_now_us() < until_us) && !*done)
+    {
+        for (i = 0U; i < count; i++)
+        {
+            (void)stacks[i]->receive_all(drain, NULL, 0U, NULL);
+        }
+
+        sim_link_run_until(((sim_link_now_us() + TICK_US) < until_us) ? (sim_link_now_us() + TICK_US) : until_us);
+    }
+}
+
+/* node 0 writes CHANNEL_TEST_FRAMES unicast frames to node 1, returns how long they took */
+static uint64_t time_writes(void)
+{
+    uint8_t payload[200] = {0};
+    uint64_t start_us = sim_link_now_us();
+    uint32_t i;
+
+    for (i = 0U; i < CHANNEL_TEST_FRAMES; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->write(sim_link_mac(1U), WT20_COMMAND_SEND_PAYLOAD, payload, sizeof(payload)));
+    }
+
+    return sim_link_now_us() - start_us;
+}
+
+/* node 0 writes RATE_TEST_FRAMES raw frames to node 1 over links at rssi, once node 1 has been
+   heard. Returns frames acked, elapsed_us is how long they took */
+static uint32_t rate_writes(bool adapt_rate, bool long_range, int8_t rssi, uint64_t* elapsed_us)
+{
+    const SIM_LINK_CHANNEL_T channel = {
+        .bitrate_bps = 1000000U,
+        .preamble_us = 192U,
+        .overhead_bytes = 43U,
+        .gap_us = 360U,
+        .ack_us = 314U,
+        .adapt_rate = adapt_rate,
+        .long_range = long_range
+    };
+    const SIM_LINK_PARAMS_T link = {.latency_us = 200U, .rssi_dbm = rssi};
+    const uint8_t broadcast[6U] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+    uint8_t frame[ESPNOW_DATA_BYTES] = {0};
+    SIM_LINK_NODE_STATS_T stats;
+    uint64_t start_us;
+    uint32_t i;
+
+    sim_link_init(2U, SEED);
+    sim_link_set_channel(&channel);
+    sim_link_set_all_params(&link);
+
+    (void)sim_link_select(1U);
+    (void)espnow_link_write(broadcast, frame, 10U);
+    (void)sim_link_select(0U);
+    sim_link_run_until(sim_link_now_us() + 10000U);
+
+    start_us = sim_link_now_us();
+
+    for (i = 0U; i < RATE_TEST_FRAMES; i++)
+    {
+        (void)espnow_link_write(sim_link_mac(1U), frame, sizeof(frame));
+    }
+
+    *elapsed_us = sim_link_now_us() - start_us;
+    sim_link_get_stats(0U, &stats);
+
+    return stats.frames_acked;
+}
+
+/* every node adds every other as a peer */
+static void add_all_peers(uint32_t count)
+{
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < count; i++)
+    {
+        for (j = 0U; j < count; j++)
+        {
+            if (i != j)
+            {
+                TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[i]->add_peer(sim_link_mac(j), NULL));
+            }
+        }
+    }
+}
+
+static void start_stacks(uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[i]->init());
+    }
+}
+
+/* node 0 talks to node 1 for VOICE_FRAMES blocks, with the mode picked by
+   wt20_next_voice_mode() or fixed at 16 kHz */
+static void run_voice(bool adapt)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 300U, .jitter_us = 200U, .loss_good_ppm = 10000U, .rssi_dbm = -70};
+    int16_t pcm[ADPCM_BLOCK_SAMPLES];
+    uint8_t block[ADPCM_BLOCK_BYTES];
+    uint64_t queue[VOICE_QUEUE_FRAMES];
+    uint64_t next_capture_us;
+    uint32_t head = 0U;
+    uint32_t count = 0U;
+    uint32_t captured = 0U;
+    uint32_t i;
+    ADPCM_STATE_T state;
+    ADPCM_MODE_T mode = ADPCM_MODE_16K;
+
+    sim_link_init(2U, SEED);
+    sim_link_set_all_params(&link);
+    sim_link_set_wifi_load(ESPNOW_LINK_CHAN_DEFAULT, VOICE_LOAD_PERMILLE, -90);
+    start_stacks(2U);
+    sim_link_set_rx_task(1U, voice_rx_task, NULL);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_stream_callback(voice_frame, NULL));
+
+    memset(&voice, 0, sizeof(voice));
+    voice.decoded = true;
+    adpcm_init(&state);
+
+    for (i = 0U; i < ADPCM_BLOCK_SAMPLES; i++)
+    {
+        pcm[i] = (int16_t)(((i * 97U) % 2000U) * 8U);
+    }
+
+    next_capture_us = sim_link_now_us();
+
+    while ((captured < VOICE_FRAMES) || (count > 0U))
+    {
+        /* capture runs on its own clock */
+        while ((captured < VOICE_FRAMES) && (next_capture_us <= sim_link_now_us()))
+        {
+            if (count < VOICE_QUEUE_FRAMES)
+            {
+                queue[(head + count) % VOICE_QUEUE_FRAMES] = next_capture_us;
+                count++;
+            }
+            else
+            {
+                voice.overruns++;
+            }
+
+            captured++;
+            next_capture_us += STREAM_FRAME_US;
+        }
+
+        if (count == 0U)
+        {
+            sim_link_run_until(next_capture_us);
+            continue;
+        }
+
+        voice.captured_us[voice.sent] = queue[head];
+        head = (head + 1U) % VOICE_QUEUE_FRAMES;
+        count--;
+
+        /* the talker's own receiving task picks up reports between sends */
+        (void)stacks[0]->receive_all(drain, NULL, 0U, NULL);
+
+        if (adapt)
+        {
+            TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->next_voice_mode(count, &mode));
+        }
+
+        voice.sent++;
+        (void)stacks[0]->write_stream(sim_link_mac(1U), block,
+                                      adpcm_encode_block_mode(&state, mode, pcm, ADPCM_BLOCK_SAMPLES, block));
+    }
+
+    sim_link_run_until(sim_link_now_us() + 100000U);
+}
+
+/* node 0 sends node 1 a whole message reliably, node 2 optionally floods node 1 with stream frames */
+static void run_transfer(bool congested, RUN_RESULT_T* result)
+{
+    static const uint8_t stream_payload[WT20_FEC_MAX_FRAME_BYTES] = {0};
+    SIM_LINK_NODE_STATS_T stats;
+    bool never = false;
+
+    sim_link_init(3U, SEED);
+    sim_link_set_all_params(&bursty);
+    start_stacks(3U);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_message_callback(message_received, NULL));
+
+    memset(&transfer, 0, sizeof(transfer));
+    received_match = false;
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE,
+                          stacks[0]->send_message_reliable(sim_link_mac(1U), message, MESSAGE_BYTES, transfer_done, NULL));
+
+    while (!transfer.done && (sim_link_now_us() < 30000000U))
+    {
+        if (congested)
+        {
+            assert_written(stacks[2]->write_stream(sim_link_mac(1U), stream_payload, sizeof(stream_payload)));
+        }
+
+        run_nodes(2U, sim_link_now_us() + TICK_US, &transfer.done);
+    }
+
+    /* let the last acks land */
+    run_nodes(3U, sim_link_now_us() + 50000U, &never);
+
+    sim_link_get_stats(0U, &stats);
+    result->finished_us = transfer.finished_us;
+    result->frames_sent = stats.frames_sent;
+}
+
+void setUp(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < MESSAGE_BYTES; i++)
+    {
+        message[i] = (uint8_t)((i * 7U) ^ (i >> 8U));
+    }
+
+    sim_link_init(2U, SEED);
+}
+
+void tearDown(void) { }
+
+void test_sim_link_delivers_after_airtime_and_latency(void)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 500U, .rssi_dbm = -67};
+    uint8_t frame[ESPNOW_DATA_BYTES];
+    ESPNOW_LINK_MSG_T msg;
+    ESPNOW_LINK_TX_HANDLE_T handle;
+    const uint8_t stranger[6U] = {0x02, 0x11, 0x22, 0x33, 0x44, 0x55};
+    uint64_t airtime_us = 360U + 192U + ((43U + sizeof(frame)) * 8U);
+
+    memset(frame, 0x5A, sizeof(frame));
+    sim_link_set_params(0U, 1U, &link);
+
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE,
+                          espnow_link_write_async(sim_link_mac(1U), frame, sizeof(frame), NULL, NULL, &handle));
+    TEST_ASSERT_EQUAL_UINT32(1U, espnow_link_tx_pending());
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_TIMEOUT, espnow_link_wait_tx(handle, 0U));
+
+    /* send callback comes once the ack is in */
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE, espnow_link_wait_tx(handle, 100U));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)airtime_us + 314U, (uint32_t)sim_link_now_us());
+
+    (void)sim_link_select(1U);
+    TEST_ASSERT_FALSE(espnow_link_messages_available());
+    TEST_ASSERT(espnow_link_wait_for_messages(ESPNOW_LINK_WAIT_FOREVER));
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)airtime_us + 500U, (uint32_t)sim_link_now_us());
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE, espnow_link_read(&msg));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(sim_link_mac(0U), msg.info.src_mac, 6U);
+    TEST_ASSERT_EQUAL_INT8(-67, msg.info.rssi);
+    TEST_ASSERT_EQUAL_UINT16(sizeof(frame), msg.info.data_len);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(frame, msg.data, sizeof(frame));
+
+    /* nothing else will ever arrive, so waiting forever gives up instead of hanging */
+    TEST_ASSERT_FALSE(espnow_link_wait_for_messages(ESPNOW_LINK_WAIT_FOREVER));
+
+    /* nobody acks a frame for a node that isn't there */
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR, espnow_link_write(stranger, frame, 10U));
+}
+
+void test_sim_link_loses_frames_in_bursts(void)
+{
+    uint8_t frame[32] = {0};
+    ESPNOW_LINK_MSG_T msg;
+    SIM_LINK_NODE_STATS_T stats;
+    uint32_t sent = 4000U;
+    uint32_t i;
+    uint32_t expected = 0U;
+    uint32_t seq;
+    uint32_t lost = 0U;
+    uint32_t bursts = 0U;
+    static const SIM_LINK_PARAMS_T link = {
+        .latency_us = 100U,
+        .loss_bad_ppm = SIM_LINK_PPM,
+        .good_to_bad_ppm = 20000U,
+        .bad_to_good_ppm = 250000U
+    };
+
+    sim_link_set_params(0U, 1U, &link);
+
+    for (i = 0U; i < sent; i++)
+    {
+        memcpy(frame, &i, sizeof(i));
+        TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE, espnow_link_write_async(sim_link_mac(1U), frame, sizeof(frame), NULL,
+                                                                            NULL, NULL));
+        sim_link_run_until(sim_link_now_us() + 10000U);
+
+        (void)sim_link_select(1U);
+
+        while (espnow_link_read(&msg) == ESPNOW_LINK_ERR_NONE)
+        {
+            memcpy(&seq, msg.data, sizeof(seq));
+            bursts += (seq != expected) ? 1U : 0U;
+            lost += seq - expected;
+            expected = seq + 1U;
+        }
+
+        (void)sim_link_select(0U);
+    }
+
+    lost += sent - expected;
+    sim_link_get_stats(1U, &stats);
+    TEST_ASSERT_EQUAL_UINT32(lost, stats.frames_lost);
+
+    /* link spends 2 / 27 of its time in the bad state, and stays there 4 frames on average */
+    TEST_ASSERT((lost * 1000U) > (sent * 55U));
+    TEST_ASSERT((lost * 1000U) < (sent * 95U));
+    TEST_ASSERT((lost * 10U) > (bursts * 30U));
+    TEST_ASSERT((lost * 10U) < (bursts * 50U));
+}
+
+void test_sim_link_senders_share_the_channel(void)
+{
+    uint8_t frame[ESPNOW_DATA_BYTES] = {0};
+    SIM_LINK_NODE_STATS_T first;
+    SIM_LINK_NODE_STATS_T second;
+    ESPNOW_LINK_RX_STATS_T rx;
+    uint32_t node;
+
+    sim_link_init(3U, SEED);
+
+    /* two nodes keep their pipelines full for a second, nobody reads */
+    while (sim_link_now_us() < 1000000U)
+    {
+        for (node = 0U; node < 2U; node++)
+        {
+            (void)sim_link_select(node);
+            while (espnow_link_write_async(sim_link_mac(2U), frame, sizeof(frame), NULL, NULL, NULL) == ESPNOW_LINK_ERR_NONE)
+            {
+            }
+        }
+
+        sim_link_run_until(sim_link_now_us() + TICK_US);
+    }
+
+    sim_link_get_stats(0U, &first);
+    sim_link_get_stats(1U, &second);
+
+    /* each frame holds the channel about 3.2 ms, so about 310 fit in a second, split evenly */
+    TEST_ASSERT((first.frames_acked + second.frames_acked) > 300U);
+    TEST_ASSERT((first.frames_acked + second.frames_acked) < 330U);
+    TEST_ASSERT(((first.frames_acked > second.frames_acked) ? (first.frames_acked - second.frames_acked)
+                                                            : (second.frames_acked - first.frames_acked)) <= 8U);
+    TEST_ASSERT(first.tx_busy > 0U);
+    TEST_ASSERT(sim_link_channel_busy_us() > 990000U);
+
+    /* receiver never read, so its ring filled up and dropped the rest */
+    (void)sim_link_select(2U);
+    espnow_link_get_rx_stats(&rx);
+    TEST_ASSERT(rx.frames_received > 300U);
+    TEST_ASSERT(rx.ring.dropped_newest > 0U);
+}
+
+void test_sim_link_rate_adaptation_follows_the_link(void)
+{
+    ESPNOW_LINK_RATE_STATS_T rate;
+    uint64_t fixed_us;
+    uint64_t adapted_us;
+    uint32_t fixed;
+    uint32_t adapted;
+
+    /* close by, frames go at 54 Mbps from the start and hold the channel a quarter as long */
+    fixed = rate_writes(false, false, -50, &fixed_us);
+    adapted = rate_writes(true, false, -50, &adapted_us);
+    TEST_ASSERT_EQUAL_UINT32(RATE_TEST_FRAMES, fixed);
+    TEST_ASSERT_EQUAL_UINT32(RATE_TEST_FRAMES, adapted);
+    TEST_ASSERT((adapted_us * 4U) < fixed_us);
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE, espnow_link_get_peer_rate(sim_link_mac(1U), &rate));
+    TEST_ASSERT_EQUAL(ESPNOW_LINK_RATE_54M, rate.rate);
+    TEST_ASSERT_EQUAL_INT8(-50, rate.rssi);
+
+    /* too far for 1 Mbps. Only long range gets frames through */
+    fixed = rate_writes(true, false, -97, &fixed_us);
+    adapted = rate_writes(true, true, -97, &adapted_us);
+    TEST_ASSERT((fixed * 20U) < RATE_TEST_FRAMES);
+    TEST_ASSERT((adapted * 10U) > (RATE_TEST_FRAMES * 6U));
+    TEST_ASSERT_EQUAL_INT(ESPNOW_LINK_ERR_NONE, espnow_link_get_peer_rate(sim_link_mac(1U), &rate));
+    TEST_ASSERT(rate.rate <= ESPNOW_LINK_RATE_LR_500K);
+    TEST_ASSERT_EQUAL_UINT32(adapted, rate.frames_acked);
+}
+
+void test_sim_wt20_reliable_transfer_through_bursty_loss(void)
+{
+    RUN_RESULT_T clear;
+    RUN_RESULT_T again;
+    RUN_RESULT_T congested;
+    double seconds;
+
+    run_transfer(false, &clear);
+    TEST_ASSERT(transfer.done);
+    TEST_ASSERT(transfer.success);
+    TEST_ASSERT(received_match);
+
+    /* same seed, same run, down to the microsecond */
+    run_transfer(false, &again);
+    TEST_ASSERT(received_match);
+    TEST_ASSERT_EQUAL_UINT32((uint32_t)clear.finished_us, (uint32_t)again.finished_us);
+    TEST_ASSERT_EQUAL_UINT32(clear.frames_sent, again.frames_sent);
+
+    /* sharing the channel with a stream still gets there, only slower */
+    run_transfer(true, &congested);
+    TEST_ASSERT(transfer.success);
+    TEST_ASSERT(received_match);
+    TEST_ASSERT(congested.finished_us > clear.finished_us);
+
+    seconds = (double)clear.finished_us / 1000000.0;
+    printf("reliable %u bytes over bursty link: %.3f s, %.1f KB/s, %u frames\n", (unsigned)received_bytes, seconds,
+           (double)received_bytes / seconds / 1024.0, (unsigned)clear.frames_sent);
+    seconds = (double)congested.finished_us / 1000000.0;
+    printf("same, sharing channel with a stream: %.3f s, %.1f KB/s, %u frames\n", seconds,
+           (double)received_bytes / seconds / 1024.0, (unsigned)congested.frames_sent);
+}
+
+void test_sim_wt20_stream_fec_rebuilds_lost_frames(void)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 300U, .jitter_us = 500U, .loss_good_ppm = 50000U, .rssi_dbm = -75};
+    static const WT20_FEC_CONFIG_T fec = {.k = 4U, .m = 1U, .frame_bytes = 200U};
+    uint8_t frame[200] = {0};
+    SIM_LINK_NODE_STATS_T stats;
+    bool never = false;
+    uint32_t i;
+
+    sim_link_set_all_params(&link);
+    start_stacks(2U);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->set_stream_fec(&fec));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_stream_callback(stream_frame, NULL));
+    memset(&stream, 0, sizeof(stream));
+
+    for (i = 0U; i < STREAM_FRAMES; i++)
+    {
+        assert_written(stacks[0]->write_stream(sim_link_mac(1U), frame, sizeof(frame)));
+        run_nodes(2U, (uint64_t)(i + 1U) * STREAM_FRAME_US, &never);
+    }
+
+    sim_link_get_stats(1U, &stats);
+
+    /* 5% of frames are lost in the air, parity brings nearly all of them back */
+    TEST_ASSERT(stats.frames_lost > ((STREAM_FRAMES * 5U) / 4U / 40U));
+    TEST_ASSERT(stream.recovered > stream.gaps);
+    TEST_ASSERT((stream.gaps * 50U) < STREAM_FRAMES);
+
+    printf("stream over 5%% loss: %u frames lost in air, %u rebuilt, %u lost for good of %u\n",
+           (unsigned)stats.frames_lost, (unsigned)stream.recovered, (unsigned)stream.gaps, (unsigned)STREAM_FRAMES);
+}
+
+void test_sim_wt20_voice_rate_keeps_talk_live_on_a_busy_channel(void)
+{
+    WT20_VRATE_STATS_T stats;
+    WT20_VRATE_RX_STATS_T rx_stats;
+    VOICE_T fixed;
+
+    /* at 16 kHz every block takes longer to get out than capture takes to make it, so the queue
+       fills and capture starts dropping */
+    run_voice(false);
+    fixed = voice;
+    TEST_ASSERT(fixed.decoded);
+    TEST_ASSERT(fixed.overruns > 0U);
+    TEST_ASSERT(fixed.latency_max_us > ((VOICE_QUEUE_FRAMES - 1U) * STREAM_FRAME_US));
+
+    /* adapting, the talker settles on modes the channel can carry and talk stays live */
+    run_voice(true);
+    TEST_ASSERT(voice.decoded);
+    TEST_ASSERT_EQUAL_UINT32(0U, voice.overruns);
+    TEST_ASSERT_EQUAL_UINT32(VOICE_FRAMES, voice.sent);
+    TEST_ASSERT(voice.delivered > fixed.delivered);
+    /* the only wait is the few frames queued before the first mode down */
+    TEST_ASSERT(voice.latency_max_us < ((WT20_VRATE_QUEUE_SEVERE_FRAMES + 1U) * STREAM_FRAME_US));
+    TEST_ASSERT((voice.latency_max_us * 2U) < fixed.latency_max_us);
+    TEST_ASSERT((voice.latency_sum_us / voice.delivered) * 4U < (fixed.latency_sum_us / fixed.delivered));
+    TEST_ASSERT(voice.modes[ADPCM_MODE_8K] > voice.modes[ADPCM_MODE_16K]);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->get_voice_rate_stats(&stats, NULL));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->get_voice_rate_stats(NULL, &rx_stats));
+    TEST_ASSERT(stats.downs > 0U);
+    TEST_ASSERT(stats.reports > 0U);
+    TEST_ASSERT_EQUAL_UINT32(rx_stats.reports, stats.reports);
+    TEST_ASSERT_EQUAL_UINT32(voice.delivered, rx_stats.delivered);
+
+    printf("voice at 16 kHz over a %u%% busy channel: %u of %u blocks captured, %u heard, latency mean %lu us max %lu us\n",
+           (unsigned)(VOICE_LOAD_PERMILLE / 10U), (unsigned)fixed.sent, (unsigned)VOICE_FRAMES, (unsigned)fixed.delivered,
+           (unsigned long)(fixed.latency_sum_us / fixed.delivered), (unsigned long)fixed.latency_max_us);
+    printf("adapting: %u heard (16k %u, 8k %u, 8k 2 bit %u), %u downs %u ups, latency mean %lu us max %lu us\n",
+           (unsigned)voice.delivered, (unsigned)voice.modes[ADPCM_MODE_16K], (unsigned)voice.modes[ADPCM_MODE_8K],
+           (unsigned)voice.modes[ADPCM_MODE_8K_2BIT], (unsigned)stats.downs, (unsigned)stats.ups,
+           (unsigned long)(voice.latency_sum_us / voice.delivered), (unsigned long)voice.latency_max_us);
+}
+
+void test_sim_wt20_group_talk_sends_once_and_repairs_gaps(void)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 300U, .jitter_us = 500U, .loss_good_ppm = 50000U, .rssi_dbm = -75};
+    uint8_t frame[200] = {0};
+    SIM_LINK_NODE_STATS_T stats;
+    WT20_GROUP_STATS_T talker;
+    bool never = false;
+    uint32_t missed = 0U;
+    uint32_t i;
+    uintptr_t node;
+
+    sim_link_init(3U, SEED);
+    sim_link_set_all_params(&link);
+    start_stacks(3U);
+    memset(group_heard, 0, sizeof(group_heard));
+    group_repaired = 0U;
+
+    for (node = 1U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->add_peer(sim_link_mac(0U), NULL));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->join_group(5U, true));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->set_group_callback(group_frame, (void*)(node - 1U)));
+    }
+
+    for (i = 0U; i < STREAM_FRAMES; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->write_group(5U, frame, sizeof(frame)));
+        run_nodes(3U, (uint64_t)(i + 1U) * STREAM_FRAME_US, &never);
+    }
+
+    for (i = 0U; i < STREAM_FRAMES; i++)
+    {
+        missed += (group_heard[0][i] ? 0U : 1U) + (group_heard[1][i] ? 0U : 1U);
+    }
+
+    sim_link_get_stats(0U, &stats);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->get_group_stats(&talker));
+
+    /* one send per frame however many members, plus the rebroadcasts */
+    TEST_ASSERT_EQUAL_UINT32(STREAM_FRAMES, talker.frames_sent);
+    TEST_ASSERT_EQUAL_UINT32(STREAM_FRAMES + talker.repairs_sent, stats.frames_sent);
+
+    /* 5% lost at each member, repair brings nearly all of them back */
+    TEST_ASSERT(group_repaired > ((2U * STREAM_FRAMES) / 40U));
+    TEST_ASSERT((missed * 100U) < (2U * STREAM_FRAMES));
+
+    printf("group of 2 over 5%% loss: %u frames sent, %u nacks, %u rebroadcasts, %u repaired, %u lost for good of %u\n",
+           (unsigned)talker.frames_sent, (unsigned)talker.nacks_received, (unsigned)talker.repairs_sent,
+           (unsigned)group_repaired, (unsigned)missed, (unsigned)(2U * STREAM_FRAMES));
+}
+
+/* nodes in a line, 0 out of range of 2. Node 1 relays, and each hop costs about what a direct
+   frame does plus the mean backoff */
+void test_sim_wt20_relay_reaches_past_range_at_small_cost_per_hop(void)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 300U, .jitter_us = 200U, .rssi_dbm = -80};
+    static const SIM_LINK_PARAMS_T out_of_range = {.loss_good_ppm = SIM_LINK_PPM, .rssi_dbm = -100};
+    WT20_RELAY_STATS_T relay_stats;
+    WT20_RELAY_STATS_T origin_stats;
+    uint64_t one_hop_us;
+    uint64_t two_hop_us;
+
+    sim_link_init(3U, SEED);
+    sim_link_set_all_params(&link);
+    sim_link_set_params(0U, 2U, &out_of_range);
+    sim_link_set_params(2U, 0U, &out_of_range);
+    start_stacks(3U);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_relay(true));
+
+    /* one hop, node 1 is the destination so it doesn't pass it on */
+    run_relay(sim_link_mac(1U));
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, relay_delivered[1]);
+    TEST_ASSERT_EQUAL_UINT32(0U, relay_delivered[2]);
+    one_hop_us = relay_latency_us[1] / RELAY_FRAMES;
+
+    /* two hops through node 1 */
+    run_relay(sim_link_mac(2U));
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, relay_delivered[2]);
+    TEST_ASSERT_EQUAL_UINT32(0U, relay_delivered[1]);
+    two_hop_us = relay_latency_us[2] / RELAY_FRAMES;
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->get_relay_stats(&relay_stats));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->get_relay_stats(&origin_stats));
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, relay_stats.frames_forwarded);
+    TEST_ASSERT_EQUAL_UINT32(2U * RELAY_FRAMES, origin_stats.frames_sent);
+
+    /* node 0 hears its own frames come back from node 1, and drops them */
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, origin_stats.duplicates);
+
+    /* the relay hop adds the backoff and a tick at most on top of a direct hop */
+    TEST_ASSERT(two_hop_us > one_hop_us);
+    TEST_ASSERT((two_hop_us - one_hop_us) < (one_hop_us + WT20_RELAY_JITTER_US + RELAY_TICK_US));
+
+    printf("relay: 1 hop %lu us, 2 hops %lu us, relay hop adds %lu us (backoff up to %u us)\n",
+           (unsigned long)one_hop_us, (unsigned long)two_hop_us, (unsigned long)(two_hop_us - one_hop_us),
+           (unsigned)WT20_RELAY_JITTER_US);
+}
+
+/* every node in range of every other and relaying. Each frame is delivered and forwarded once
+   per node however many copies go around */
+void test_sim_wt20_relay_suppresses_duplicates_and_loops(void)
+{
+    static const SIM_LINK_PARAMS_T link = {.latency_us = 300U, .jitter_us = 200U, .rssi_dbm = -70};
+    static const uint8_t everyone[6U] = {0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU, 0xFFU};
+    WT20_RELAY_STATS_T stats[3U];
+    SIM_LINK_NODE_STATS_T link_stats;
+    uint32_t on_air = 0U;
+    uint32_t node;
+
+    sim_link_init(3U, SEED);
+    sim_link_set_all_params(&link);
+    start_stacks(3U);
+
+    for (node = 0U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->set_relay(true));
+    }
+
+    run_relay(everyone);
+
+    for (node = 0U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->get_relay_stats(&stats[node]));
+        sim_link_get_stats(node, &link_stats);
+        on_air += link_stats.frames_sent;
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0U, relay_delivered[0]);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, relay_delivered[1]);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, relay_delivered[2]);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, stats[1].frames_forwarded);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, stats[2].frames_forwarded);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats[0].frames_forwarded);
+
+    /* the origin's send and one forward per relay, nothing goes around again */
+    TEST_ASSERT_EQUAL_UINT32(3U * RELAY_FRAMES, on_air);
+    TEST_ASSERT_EQUAL_UINT32(2U * RELAY_FRAMES, stats[0].duplicates);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, stats[1].duplicates);
+    TEST_ASSERT_EQUAL_UINT32(RELAY_FRAMES, stats[2].duplicates);
+}
+
+/* a house full of wifi on the low channels. Node 0 surveys, picks the clear end of the band
+   and takes the others along, and the same writes go faster there */
+void test_sim_wt20_auto_channel_moves_the_group_off_a_busy_channel(void)
+{
+    ESPNOW_LINK_CHAN_STATS_T link_stats;
+    WT20_CHAN_STATS_T stats[3U];
+    uint64_t busy_us;
+    uint64_t clear_us;
+    uint8_t channel = 0U;
+    bool never = false;
+    uint32_t node;
+
+    sim_link_init(3U, SEED);
+    sim_link_set_wifi_load(1U, 600U, -88);
+    sim_link_set_wifi_load(3U, 300U, -92);
+    sim_link_set_wifi_load(6U, 500U, -90);
+    sim_link_set_wifi_load(8U, 200U, -94);
+    start_stacks(3U);
+    add_all_peers(3U);
+
+    busy_us = time_writes();
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->auto_channel(SURVEY_DWELL_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT8(11U, channel);
+
+    /* nobody moves before the switch time */
+    run_nodes(3U, sim_link_now_us() + ((WT20_CHAN_SWITCH_DELAY_MS - 10U) * 1000U), &never);
+
+    for (node = 0U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(ESPNOW_LINK_CHAN_DEFAULT, sim_link_node_get_wifi_channel(node));
+    }
+
+    run_nodes(3U, sim_link_now_us() + 20000U, &never);
+
+    for (node = 0U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(11U, sim_link_node_get_wifi_channel(node));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->get_chan_stats(&stats[node]));
+        TEST_ASSERT_EQUAL_UINT32(1U, stats[node].switches);
+    }
+
+    /* both acks were heard with the first announcement, so there was no second */
+    TEST_ASSERT_EQUAL_UINT32(1U, stats[0].announcements_sent);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats[0].acks_received);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats[0].unacked);
+
+    clear_us = time_writes();
+    sim_link_node_get_chan_stats(0U, &link_stats);
+    TEST_ASSERT_EQUAL_UINT8(11U, link_stats.channel);
+    TEST_ASSERT_EQUAL_UINT16(1000U, link_stats.delivery_permille);
+    TEST_ASSERT((clear_us * 2U) < busy_us);
+
+    printf("auto channel: 1 -> %u, %u writes took %lu us, now %lu us\n", (unsigned)channel, (unsigned)CHANNEL_TEST_FRAMES,
+           (unsigned long)busy_us, (unsigned long)clear_us);
+}
+
+/* nodes 1 and 2 both start a switch. The lower mac's wins everywhere. Then a unit out of range
+   misses the next one, and is counted as unacked */
+void test_sim_wt20_channel_switch_settles_conflicts_and_leaves_stragglers(void)
+{
+    static const SIM_LINK_PARAMS_T out_of_range = {.loss_good_ppm = SIM_LINK_PPM, .rssi_dbm = -100};
+    WT20_CHAN_STATS_T stats[3U];
+    bool never = false;
+    uint32_t node;
+
+    sim_link_init(3U, SEED);
+    start_stacks(3U);
+    add_all_peers(3U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_CHANNEL_ERR, stacks[0]->switch_channel(ESPNOW_LINK_CHAN_LAST + 1U));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[2]->switch_channel(6U));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->switch_channel(11U));
+    run_nodes(3U, sim_link_now_us() + ((WT20_CHAN_SWITCH_DELAY_MS + 20U) * 1000U), &never);
+
+    for (node = 0U; node < 3U; node++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(11U, sim_link_node_get_wifi_channel(node));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[node]->get_chan_stats(&stats[node]));
+    }
+
+    TEST_ASSERT(stats[2].conflicts > 0U);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats[1].unacked);
+
+    /* node 2 goes out of range and stays behind */
+    sim_link_set_params(0U, 2U, &out_of_range);
+    sim_link_set_params(1U, 2U, &out_of_range);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->switch_channel(3U));
+    run_nodes(3U, sim_link_now_us() + ((WT20_CHAN_SWITCH_DELAY_MS + 20U) * 1000U), &never);
+
+    TEST_ASSERT_EQUAL_UINT8(3U, sim_link_node_get_wifi_channel(0U));
+    TEST_ASSERT_EQUAL_UINT8(3U, sim_link_node_get_wifi_channel(1U));
+    TEST_ASSERT_EQUAL_UINT8(11U, sim_link_node_get_wifi_channel(2U));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[0]->get_chan_stats(&stats[0]));
+    TEST_ASSERT_EQUAL_UINT32(1U, stats[0].unacked);
+    TEST_ASSERT_EQUAL_UINT32(WT20_CHAN_SWITCH_DELAY_MS / WT20_CHAN_ANNOUNCE_INTERVAL_MS, stats[0].announcements_sent);
+}
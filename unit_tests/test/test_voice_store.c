@@ -0,0 +1,282 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "voice_store.h"
+#include "voice_flash_file.h"
+#include "crc16.h"
+
+#define FLASH_PATH "build/test_voice_store.bin"
+#define FLASH_SECTORS (16U)
+
+/* a few seconds of ADPCM, spanning several sectors */
+#define MESSAGE_BYTES (10000U)
+
+/* arrives the way the radio delivers it, a fragment at a time */
+#define FRAGMENT_BYTES (230U)
+
+static uint8_t message[MESSAGE_BYTES];
+
+static uint8_t message_byte(uint16_t id, uint32_t i)
+{
+    return (uint8_t)(((i * 31U) + (id * 7U)) ^ (i >> 8U));
+}
+
+static VOICE_STORE_ERR_T store_message(uint32_t bytes, uint16_t* id)
+{
+    VOICE_STORE_ERR_T err = voice_store_begin(id);
+    uint32_t done;
+    uint32_t count;
+
+    for (done = 0U; done < bytes; done++)
+    {
+        message[done] = message_byte(*id, done);
+    }
+
+    for (done = 0U; (err == VOICE_STORE_OK) && (done < bytes); done += count)
+    {
+        count = ((bytes - done) < FRAGMENT_BYTES) ? (bytes - done) : FRAGMENT_BYTES;
+        err = voice_store_append(&message[done], count);
+    }
+
+    return (err == VOICE_STORE_OK) ? voice_store_finish() : err;
+}
+
+/* reads message id straight out of the map, checking every byte. Returns bytes read */
+static uint32_t check_message(uint16_t id)
+{
+    VOICE_STORE_READER_T reader;
+    const uint8_t* data;
+    uint32_t length;
+    uint32_t bytes = 0U;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_open(id, &reader));
+
+    while ((length = voice_store_read(&reader, &data)) > 0U)
+    {
+        for (i = 0U; i < length; i++)
+        {
+            TEST_ASSERT_EQUAL_HEX8(message_byte(id, bytes + i), data[i]);
+        }
+
+        bytes += length;
+    }
+
+    return bytes;
+}
+
+static double seconds_since(const struct timespec* start)
+{
+    struct timespec now;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)(now.tv_sec - start->tv_sec) + ((double)(now.tv_nsec - start->tv_nsec) / 1e9);
+}
+
+void setUp(void)
+{
+    voice_flash_file_cut_power_after(VOICE_FLASH_FILE_NO_CUT);
+    TEST_ASSERT(voice_flash_file_create(FLASH_PATH, FLASH_SECTORS * VOICE_FLASH_SECTOR_BYTES));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+}
+
+void tearDown(void)
+{
+    voice_store_unmount();
+}
+
+void test_voice_store_messages_survive_remount(void)
+{
+    VOICE_STORE_MSG_T msg;
+    uint16_t first;
+    uint16_t second;
+
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(MESSAGE_BYTES, &first));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(100U, &second));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_ERR_NOT_OPEN, voice_store_finish());
+
+    voice_store_unmount();
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+
+    TEST_ASSERT_EQUAL_UINT32(2U, voice_store_count());
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(0U, &msg));
+    TEST_ASSERT_EQUAL_UINT16(first, msg.id);
+    TEST_ASSERT_EQUAL_UINT32(MESSAGE_BYTES, msg.bytes);
+    TEST_ASSERT(msg.complete);
+    TEST_ASSERT_EQUAL_UINT32(MESSAGE_BYTES, check_message(first));
+    TEST_ASSERT_EQUAL_UINT32(100U, check_message(second));
+
+    /* ids carry on after the newest */
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_begin(&first));
+    TEST_ASSERT_EQUAL_UINT16(second + 1U, first);
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_ERR_BUSY, voice_store_begin(&first));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_ERR_BUSY, voice_store_delete(first));
+}
+
+void test_voice_store_oldest_make_room_and_wear_stays_even(void)
+{
+    VOICE_STORE_STATS_T stats;
+    VOICE_STORE_MSG_T msg;
+    uint16_t id = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < 40U; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(MESSAGE_BYTES - (i * 97U), &id));
+    }
+
+    /* every message left reads back whole, the newest included */
+    for (i = 0U; i < voice_store_count(); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(i, &msg));
+        TEST_ASSERT_EQUAL_UINT32(msg.bytes, check_message(msg.id));
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(id, msg.id);
+
+    voice_store_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SECTORS, stats.sectors);
+    TEST_ASSERT_EQUAL_UINT32(40U - voice_store_count(), stats.messages_dropped);
+    TEST_ASSERT_GREATER_THAN_UINT32(FLASH_SECTORS, stats.sectors_erased);
+    TEST_ASSERT_UINT32_WITHIN(1U, stats.min_erase_count, stats.max_erase_count);
+
+    /* and the same after rebuilding the index */
+    voice_store_unmount();
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+    TEST_ASSERT_EQUAL_UINT32(stats.messages, voice_store_count());
+    TEST_ASSERT_EQUAL_UINT32(MESSAGE_BYTES - (39U * 97U), check_message(id));
+}
+
+void test_voice_store_deleted_messages_stay_deleted(void)
+{
+    VOICE_STORE_MSG_T msg;
+    uint16_t first;
+    uint16_t second;
+
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(5000U, &first));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(5000U, &second));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_delete(first));
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_ERR_NOT_FOUND, voice_store_delete(first));
+
+    voice_store_unmount();
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+
+    TEST_ASSERT_EQUAL_UINT32(1U, voice_store_count());
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(0U, &msg));
+    TEST_ASSERT_EQUAL_UINT16(second, msg.id);
+    TEST_ASSERT_EQUAL_UINT32(5000U, check_message(second));
+}
+
+void test_voice_store_message_larger_than_flash_keeps_what_fit(void)
+{
+    VOICE_STORE_MSG_T msg;
+    uint16_t id;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_begin(&id));
+
+    for (i = 0U; i < (FLASH_SECTORS + 1U); i++)
+    {
+        memset(message, 0, VOICE_STORE_CHUNK_BYTES);
+
+        if (voice_store_append(message, VOICE_STORE_CHUNK_BYTES) == VOICE_STORE_ERR_FULL)
+        {
+            break;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SECTORS, i);
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_finish());
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(0U, &msg));
+    TEST_ASSERT_EQUAL_UINT32(FLASH_SECTORS * VOICE_STORE_CHUNK_BYTES, msg.bytes);
+}
+
+/* power goes at every point of writing a message in turn. Whatever was finished before
+   survives, the message cut short keeps a correct start, and writing carries on after */
+void test_voice_store_recovers_from_power_loss(void)
+{
+    VOICE_STORE_STATS_T stats;
+    VOICE_STORE_MSG_T msg;
+    uint16_t kept;
+    uint16_t cut;
+    uint32_t bytes;
+    bool recovered = false;
+
+    for (bytes = 1U; bytes < (3U * VOICE_FLASH_SECTOR_BYTES); bytes += 509U)
+    {
+        voice_store_unmount();
+        TEST_ASSERT(voice_flash_file_create(FLASH_PATH, FLASH_SECTORS * VOICE_FLASH_SECTOR_BYTES));
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(3000U, &kept));
+
+        voice_flash_file_cut_power_after(bytes);
+        (void)store_message(MESSAGE_BYTES, &cut);
+        TEST_ASSERT(voice_flash_file_power_cut());
+
+        voice_flash_file_cut_power_after(VOICE_FLASH_FILE_NO_CUT);
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+        TEST_ASSERT_EQUAL_UINT32(3000U, check_message(kept));
+
+        if (voice_store_count() > 1U)
+        {
+            TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(1U, &msg));
+            TEST_ASSERT_FALSE(msg.complete);
+            TEST_ASSERT_EQUAL_UINT32(msg.bytes, check_message(cut));
+        }
+
+        voice_store_get_stats(&stats);
+        recovered = recovered || stats.recovered;
+
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(MESSAGE_BYTES, &cut));
+        TEST_ASSERT_EQUAL_UINT32(MESSAGE_BYTES, check_message(cut));
+    }
+
+    /* some of the cuts landed mid record */
+    TEST_ASSERT(recovered);
+}
+
+void test_voice_store_throughput(void)
+{
+    VOICE_STORE_MSG_T msg;
+    struct timespec start;
+    double write_s;
+    double read_s;
+    double mount_s;
+    uint32_t written = 0U;
+    uint32_t read = 0U;
+    uint16_t id;
+    uint32_t i;
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0U; i < 100U; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, store_message(MESSAGE_BYTES, &id));
+        written += MESSAGE_BYTES;
+    }
+
+    write_s = seconds_since(&start);
+
+    voice_store_unmount();
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+    TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_mount());
+    mount_s = seconds_since(&start);
+
+    (void)clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (i = 0U; i < voice_store_count(); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(VOICE_STORE_OK, voice_store_get(i, &msg));
+        read += check_message(msg.id);
+    }
+
+    read_s = seconds_since(&start);
+
+    printf("voice store: wrote %lu bytes at %.1f MB/s, read %lu bytes at %.1f MB/s, mount %.0f us\n",
+           (unsigned long)written, (written / 1e6) / write_s, (unsigned long)read, (read / 1e6) / read_s, mount_s * 1e6);
+    TEST_ASSERT_GREATER_THAN_UINT32(0U, read);
+}
@@ -0,0 +1,441 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "sim_link.h"
+#include "sim_wt20_node0.h"
+#include "sim_wt20_node1.h"
+#include "espnow_link_ring.h"
+#include "espnow_link_tx.h"
+#include "wt20_frag.h"
+#include "wt20_bulk.h"
+#include "wt20_fec.h"
+#include "gf256.h"
+#include "wt20_header.h"
+#include "crc16.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "wt20_peer.h"
+#include "wt20_group.h"
+#include "wt20_relay.h"
+#include "wt20_chan.h"
+#include "wt20_vrate.h"
+#include "adpcm.h"
+#include "espnow_link_chan.h"
+#include "espnow_link_rate.h"
+
+/*
+ * Throughput and latency of the wt20 stack over sim_link, one BENCH line per run. The link is
+ * simulated and seeded, so every number repeats exactly: diff the BENCH lines of two builds to
+ * see what a change did. Latency is one way, from the send call to the receiver's esp now
+ * callback, since both ends share the simulated clock
+ */
+
+#define SEED (0x2545F491U)
+
+#define WRITE_FRAMES (500U)
+#define ECHOES (200U)
+#define MESSAGES (8U)
+#define RELIABLE_TRANSFERS (3U)
+
+/* longest anything is waited for before it counts as lost */
+#define GIVE_UP_US (200000U)
+
+#define SENT_US_BYTES (sizeof(uint32_t))
+
+typedef struct
+{
+    const char* name;
+    SIM_LINK_PARAMS_T params;
+} LINK_PROFILE_T;
+
+typedef struct
+{
+    BENCH_HIST_T latency;
+    BENCH_HIST_T rtt;
+    uint32_t received;
+    uint64_t bytes;
+    uint64_t started_us;
+} STATE_T;
+
+static const SIM_WT20_T* const stacks[] = {&sim_wt20_node0, &sim_wt20_node1};
+
+/* payloads start with the send time, so the smallest one measured is that long */
+static const uint16_t payload_sizes[] = {SENT_US_BYTES, 64U, 128U, WT20_PAYLOAD_BYTES};
+static const uint32_t message_sizes[] = {1024U, 4096U, WT20_FRAG_MAX_MESSAGE_BYTES};
+
+static const LINK_PROFILE_T links[] = {
+    {"sim_clean", {.latency_us = 200U, .rssi_dbm = -50}},
+    {"sim_lossy", {.latency_us = 300U, .jitter_us = 300U, .loss_good_ppm = 10000U, .loss_bad_ppm = 500000U,
+                   .good_to_bad_ppm = 20000U, .bad_to_good_ppm = 250000U, .rssi_dbm = -85}}
+};
+
+static STATE_T state;
+static uint8_t payload[WT20_FRAG_MAX_MESSAGE_BYTES];
+static char line[BENCH_LINE_BYTES];
+static bool transfer_done;
+
+static uint32_t now_us(void)
+{
+    return (uint32_t)sim_link_now_us();
+}
+
+static void stamp(uint8_t* buffer)
+{
+    uint32_t sent_us = now_us();
+
+    memcpy(buffer, &sent_us, SENT_US_BYTES);
+}
+
+static uint32_t since_stamp(const uint8_t* buffer, uint32_t at_us)
+{
+    uint32_t sent_us;
+
+    memcpy(&sent_us, buffer, SENT_US_BYTES);
+
+    return at_us - sent_us;
+}
+
+static void handle_msg(const WT20_MSG_T* msg, void* context)
+{
+    if (msg->length < SENT_US_BYTES)
+    {
+        return;
+    }
+
+    if (msg->command == WT20_COMMAND_SEND_PAYLOAD)
+    {
+        bench_hist_add(&state.latency, since_stamp(msg->payload, msg->rx_us));
+    }
+    else if (msg->command == WT20_COMMAND_ECHO_REPLY)
+    {
+        bench_hist_add(&state.rtt, since_stamp(msg->payload, msg->rx_us));
+    }
+    else
+    {
+        return;
+    }
+
+    state.received++;
+    state.bytes += msg->length;
+}
+
+static void message_received(const uint8_t* src_mac, const uint8_t* message, uint32_t length, void* context)
+{
+    bench_hist_add(&state.latency, now_us() - (uint32_t)state.started_us);
+    state.received++;
+    state.bytes += length;
+}
+
+static void stream_frame(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    bench_hist_add(&state.latency, since_stamp(frame, now_us()));
+    state.received++;
+    state.bytes += length;
+}
+
+static void reliable_done(bool success, void* context)
+{
+    transfer_done = true;
+
+    if (success)
+    {
+        bench_hist_add(&state.latency, now_us() - (uint32_t)state.started_us);
+        state.received++;
+        state.bytes += *(const uint32_t*)context;
+    }
+}
+
+/* each node's receiving task, woken by sim_link whenever something arrives for it */
+static void rx_task(uint32_t node, void* context)
+{
+    (void)stacks[node]->receive_all(handle_msg, NULL, 0U, NULL);
+}
+
+static void start(const LINK_PROFILE_T* link)
+{
+    uint32_t i;
+
+    sim_link_init(2U, SEED);
+    sim_link_set_all_params(&link->params);
+
+    for (i = 0U; i < 2U; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[i]->init());
+        sim_link_set_rx_task(i, rx_task, NULL);
+    }
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_message_callback(message_received, NULL));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_stream_callback(stream_frame, NULL));
+
+    memset(&state, 0, sizeof(state));
+    bench_hist_init(&state.latency);
+    bench_hist_init(&state.rtt);
+}
+
+/* lets whatever is still in the air land */
+static void settle(void)
+{
+    sim_link_run_until(sim_link_now_us() + GIVE_UP_US);
+}
+
+static void wait_until(const uint32_t* count, uint32_t target)
+{
+    uint64_t give_up_us = sim_link_now_us() + GIVE_UP_US;
+
+    while ((*count < target) && (sim_link_now_us() < give_up_us))
+    {
+        sim_link_run_until(sim_link_now_us() + 100U);
+    }
+}
+
+static void report(const char* name, const LINK_PROFILE_T* link, uint32_t payload_bytes, uint32_t sent, uint32_t elapsed_us,
+                   BENCH_RESULT_T* result)
+{
+    result->name = name;
+    result->link = link->name;
+    result->payload_bytes = payload_bytes;
+    result->sent = sent;
+    result->received = state.received;
+    result->bytes = state.bytes;
+    result->elapsed_us = elapsed_us;
+    result->latency = (state.latency.count > 0U) ? &state.latency : NULL;
+    result->rtt = (state.rtt.count > 0U) ? &state.rtt : NULL;
+
+    (void)bench_format_result(result, line, sizeof(line));
+    printf("%s\n", line);
+}
+
+/* a lossy link may leave a write unacked, nothing else may go wrong. The receiver counts delivery */
+static void assert_written(WT20_ERR_T err)
+{
+    TEST_ASSERT((err == WT20_ERR_NONE) || (err == WT20_SEND_FAILURE));
+}
+
+/* single frame writes, back to back */
+static void bench_write(const LINK_PROFILE_T* link, uint16_t size, BENCH_RESULT_T* result)
+{
+    uint32_t start_us;
+    uint32_t elapsed_us;
+    uint32_t i;
+
+    start(link);
+    start_us = now_us();
+
+    for (i = 0U; i < WRITE_FRAMES; i++)
+    {
+        stamp(payload);
+        assert_written(stacks[0]->write(sim_link_mac(1U), WT20_COMMAND_SEND_PAYLOAD, payload, size));
+    }
+
+    elapsed_us = now_us() - start_us;
+    settle();
+    report("write", link, size, WRITE_FRAMES, elapsed_us, result);
+}
+
+/* one echo request at a time, each waiting for its reply */
+static void bench_echo(const LINK_PROFILE_T* link, uint16_t size, BENCH_RESULT_T* result)
+{
+    uint32_t start_us;
+    uint32_t target;
+    uint32_t i;
+
+    start(link);
+    start_us = now_us();
+
+    for (i = 0U; i < ECHOES; i++)
+    {
+        /* a lost request or reply is waited out, then the next one goes */
+        target = state.received + 1U;
+        stamp(payload);
+        (void)stacks[0]->write(sim_link_mac(1U), WT20_COMMAND_ECHO_REQUEST, payload, size);
+        wait_until(&state.received, target);
+    }
+
+    report("echo", link, size, ECHOES, now_us() - start_us, result);
+}
+
+/* fragmented messages, latency is send call to the last fragment arriving */
+static void bench_message(const LINK_PROFILE_T* link, uint32_t size, BENCH_RESULT_T* result)
+{
+    uint32_t start_us;
+    uint32_t target;
+    uint32_t elapsed_us = 0U;
+    uint32_t i;
+
+    start(link);
+
+    for (i = 0U; i < MESSAGES; i++)
+    {
+        target = state.received + 1U;
+        start_us = now_us();
+        state.started_us = start_us;
+        (void)stacks[0]->send_message(sim_link_mac(1U), payload, size);
+        wait_until(&state.received, target);
+        elapsed_us += now_us() - start_us;
+    }
+
+    report("message", link, size, MESSAGES, elapsed_us, result);
+}
+
+/* reliable messages, latency is send call to the sender's done callback */
+static void bench_reliable(const LINK_PROFILE_T* link, uint32_t size, BENCH_RESULT_T* result)
+{
+    uint32_t start_us;
+    uint32_t elapsed_us = 0U;
+    uint64_t give_up_us;
+    uint32_t i;
+
+    start(link);
+
+    /* timed at the sender, whose callback only fires once the receiver has acked everything */
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, stacks[1]->set_message_callback(NULL, NULL));
+
+    for (i = 0U; i < RELIABLE_TRANSFERS; i++)
+    {
+        start_us = now_us();
+        state.started_us = start_us;
+        transfer_done = false;
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE,
+                              stacks[0]->send_message_reliable(sim_link_mac(1U), payload, size, reliable_done, &size));
+
+        give_up_us = sim_link_now_us() + (10U * GIVE_UP_US);
+
+        while (!transfer_done && (sim_link_now_us() < give_up_us))
+        {
+            sim_link_run_until(sim_link_now_us() + 100U);
+        }
+
+        elapsed_us += now_us() - start_us;
+    }
+
+    report("reliable", link, size, RELIABLE_TRANSFERS, elapsed_us, result);
+}
+
+/* fec coded live frames, back to back. Parity frames go out too, but aren't counted as sent */
+static void bench_stream(const LINK_PROFILE_T* link, BENCH_RESULT_T* result)
+{
+    uint32_t start_us;
+    uint32_t elapsed_us;
+    uint32_t i;
+
+    start(link);
+    start_us = now_us();
+
+    for (i = 0U; i < WRITE_FRAMES; i++)
+    {
+        stamp(payload);
+        assert_written(stacks[0]->write_stream(sim_link_mac(1U), payload, WT20_FEC_MAX_FRAME_BYTES));
+    }
+
+    elapsed_us = now_us() - start_us;
+    settle();
+    report("stream", link, WT20_FEC_MAX_FRAME_BYTES, WRITE_FRAMES, elapsed_us, result);
+}
+
+void setUp(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t)(i * 13U);
+    }
+}
+
+void tearDown(void) { }
+
+void test_bench_write(void)
+{
+    BENCH_RESULT_T result;
+    uint64_t last_goodput = 0U;
+    uint64_t goodput;
+    uint32_t i;
+
+    for (i = 0U; i < (sizeof(payload_sizes) / sizeof(payload_sizes[0])); i++)
+    {
+        bench_write(&links[0], payload_sizes[i], &result);
+
+        /* clean link delivers everything, at least one airtime late. Bigger frames carry more */
+        TEST_ASSERT_EQUAL_UINT32(WRITE_FRAMES, result.received);
+        TEST_ASSERT(bench_hist_percentile(result.latency, 500U) > 552U + ((43U + WT20_HDR_BYTES + payload_sizes[i]) * 8U));
+        goodput = (result.bytes * 1000000U) / result.elapsed_us;
+        TEST_ASSERT(goodput > last_goodput);
+        last_goodput = goodput;
+
+        bench_write(&links[1], payload_sizes[i], &result);
+        TEST_ASSERT(result.received < WRITE_FRAMES);
+        TEST_ASSERT(result.received > ((WRITE_FRAMES * 9U) / 10U));
+    }
+}
+
+void test_bench_echo(void)
+{
+    BENCH_RESULT_T echo;
+    BENCH_RESULT_T write;
+    uint32_t rtt_us;
+    uint32_t i;
+
+    for (i = 0U; i < (sizeof(payload_sizes) / sizeof(payload_sizes[0])); i++)
+    {
+        bench_echo(&links[0], payload_sizes[i], &echo);
+        TEST_ASSERT_EQUAL_UINT32(ECHOES, echo.received);
+        TEST_ASSERT_NULL(echo.latency);
+        TEST_ASSERT_EQUAL_UINT32(ECHOES, echo.rtt->count);
+        rtt_us = bench_hist_percentile(echo.rtt, 500U);
+
+        /* a round trip is at least two one way trips */
+        bench_write(&links[0], payload_sizes[i], &write);
+        TEST_ASSERT(rtt_us > (2U * write.latency->min));
+
+        bench_echo(&links[1], payload_sizes[i], &echo);
+        TEST_ASSERT(echo.received < ECHOES);
+    }
+}
+
+void test_bench_messages(void)
+{
+    BENCH_RESULT_T result;
+    uint32_t i;
+
+    for (i = 0U; i < (sizeof(message_sizes) / sizeof(message_sizes[0])); i++)
+    {
+        bench_message(&links[0], message_sizes[i], &result);
+        TEST_ASSERT_EQUAL_UINT32(MESSAGES, result.received);
+
+        /* without retries, a lossy link loses bigger messages more often */
+        bench_message(&links[1], message_sizes[i], &result);
+        TEST_ASSERT(result.received <= MESSAGES);
+
+        bench_reliable(&links[0], message_sizes[i], &result);
+        TEST_ASSERT_EQUAL_UINT32(RELIABLE_TRANSFERS, result.received);
+
+        bench_reliable(&links[1], message_sizes[i], &result);
+        TEST_ASSERT_EQUAL_UINT32(RELIABLE_TRANSFERS, result.received);
+    }
+}
+
+void test_bench_stream(void)
+{
+    BENCH_RESULT_T result;
+
+    bench_stream(&links[0], &result);
+    TEST_ASSERT_EQUAL_UINT32(WRITE_FRAMES, result.received);
+
+    /* parity rebuilds most of what the lossy link drops */
+    bench_stream(&links[1], &result);
+    TEST_ASSERT(result.received > ((WRITE_FRAMES * 97U) / 100U));
+}
+
+void test_bench_repeats_exactly(void)
+{
+    static char first[BENCH_LINE_BYTES];
+    BENCH_RESULT_T result;
+
+    bench_write(&links[1], 128U, &result);
+    strcpy(first, line);
+    bench_write(&links[1], 128U, &result);
+    TEST_ASSERT_EQUAL_STRING(first, line);
+}
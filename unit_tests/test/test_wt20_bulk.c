@@ -0,0 +1,257 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "wt20_frag.h"
+#include "wt20_bulk.h"
+
+#define DATA_COMMAND (0xA0U)
+#define POLL_COMMAND (0xA1U)
+#define ACK_COMMAND (0xA2U)
+
+#define MESSAGE_BYTES (WT20_FRAG_MAX_MESSAGE_BYTES)
+
+/* one tick is the airtime of one frame, frames arrive LATENCY_TICKS after they are sent */
+#define LATENCY_TICKS (2U)
+#define MAX_TICKS (20000U)
+#define QUEUE_DEPTH (64U)
+#define TRANSFERS_PER_RATE (8U)
+
+typedef struct
+{
+    uint32_t arrival;
+    uint16_t length;
+    uint8_t data[WT20_BULK_DATA_FRAME_BYTES];
+} SIM_FRAME_T;
+
+typedef struct
+{
+    SIM_FRAME_T frames[QUEUE_DEPTH];
+    uint32_t head;
+    uint32_t tail;
+} SIM_QUEUE_T;
+
+static WT20_FRAG_REASSEMBLER_T reassembler;
+static WT20_BULK_TX_T tx;
+static uint8_t message[MESSAGE_BYTES];
+static SIM_QUEUE_T to_receiver;
+static SIM_QUEUE_T to_sender;
+static uint32_t lcg_state;
+
+static uint8_t sender_mac[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4A, 0x5B};
+
+/* deterministic loss so results are repeatable */
+static bool lost(uint32_t loss_percent)
+{
+    lcg_state = (lcg_state * 1664525U) + 1013904223U;
+    return ((lcg_state >> 16U) % 100U) < loss_percent;
+}
+
+static void queue_push(SIM_QUEUE_T* queue, const uint8_t* data, uint16_t length, uint32_t now)
+{
+    SIM_FRAME_T* frame;
+
+    TEST_ASSERT((queue->tail - queue->head) < QUEUE_DEPTH);
+    frame = &queue->frames[queue->tail % QUEUE_DEPTH];
+    frame->arrival = now + LATENCY_TICKS;
+    frame->length = length;
+    memcpy(frame->data, data, length);
+    queue->tail++;
+}
+
+static SIM_FRAME_T* queue_pop(SIM_QUEUE_T* queue, uint32_t now)
+{
+    SIM_FRAME_T* frame;
+
+    if ((queue->head == queue->tail) || (queue->frames[queue->head % QUEUE_DEPTH].arrival > now))
+    {
+        return NULL;
+    }
+
+    frame = &queue->frames[queue->head % QUEUE_DEPTH];
+    queue->head++;
+    return frame;
+}
+
+/* what wt20_protocol does with a received bulk frame */
+static bool receiver_handle(const SIM_FRAME_T* frame, uint32_t now, uint32_t loss_percent)
+{
+    WT20_FRAG_MESSAGE_T result;
+    WT20_FRAG_HDR_T hdr;
+    WT20_FRAG_RESULT_T ret;
+    uint8_t ack[WT20_BULK_ACK_MAX_BYTES];
+    uint16_t ack_length;
+    bool complete = false;
+
+    TEST_ASSERT(wt20_frag_parse_header(&frame->data[1], (uint16_t)(frame->length - 1U), &hdr));
+    ret = wt20_frag_accept(&reassembler, sender_mac, &frame->data[1], (uint16_t)(frame->length - 1U), now, &result);
+
+    if (ret == WT20_FRAG_COMPLETE)
+    {
+        TEST_ASSERT_EQUAL_INT(MESSAGE_BYTES, result.length);
+        TEST_ASSERT_EQUAL_MEMORY(message, result.data, MESSAGE_BYTES);
+        wt20_frag_release(&reassembler, result.slot);
+        complete = true;
+    }
+
+    if ((frame->data[0] == POLL_COMMAND) || (ret == WT20_FRAG_COMPLETE))
+    {
+        ack_length = wt20_bulk_build_ack(&reassembler, sender_mac, hdr.msg_id, hdr.index, ACK_COMMAND, ack);
+        TEST_ASSERT(ack_length > 0U);
+
+        if (!lost(loss_percent))
+        {
+            queue_push(&to_sender, ack, ack_length, now);
+        }
+    }
+
+    return complete;
+}
+
+/* runs one transfer and returns ticks taken */
+static uint32_t run_transfer(uint32_t loss_percent, uint8_t msg_id)
+{
+    uint8_t frame[WT20_BULK_DATA_FRAME_BYTES];
+    uint16_t frame_length;
+    SIM_FRAME_T* received;
+    uint32_t now;
+    bool delivered = false;
+
+    memset(&to_receiver, 0U, sizeof(to_receiver));
+    memset(&to_sender, 0U, sizeof(to_sender));
+    wt20_bulk_tx_start(&tx, msg_id, message, MESSAGE_BYTES, DATA_COMMAND, POLL_COMMAND, 0U);
+
+    for (now = 0U; (now < MAX_TICKS) && (wt20_bulk_tx_state(&tx) == WT20_BULK_IN_PROGRESS); now++)
+    {
+        while ((received = queue_pop(&to_sender, now)) != NULL)
+        {
+            wt20_bulk_tx_on_ack(&tx, received->data, received->length, now);
+        }
+
+        while ((received = queue_pop(&to_receiver, now)) != NULL)
+        {
+            delivered |= receiver_handle(received, now, loss_percent);
+        }
+
+        if (wt20_bulk_tx_next(&tx, now, frame, &frame_length) && !lost(loss_percent))
+        {
+            queue_push(&to_receiver, frame, frame_length, now);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(WT20_BULK_COMPLETE, wt20_bulk_tx_state(&tx));
+    TEST_ASSERT(delivered);
+
+    return now;
+}
+
+void setUp(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < MESSAGE_BYTES; i++)
+    {
+        message[i] = (uint8_t)((i * 13U) ^ (i >> 8U));
+    }
+
+    lcg_state = 12345U;
+    wt20_frag_reassembly_init(&reassembler);
+}
+
+void tearDown(void) { }
+
+void test_wt20_bulk_lossless_sends_each_fragment_once(void)
+{
+    uint32_t ticks = run_transfer(0U, 1U);
+
+    TEST_ASSERT_EQUAL_INT(wt20_frag_count(MESSAGE_BYTES), tx.stats.frames_sent);
+    TEST_ASSERT_EQUAL_INT(0U, tx.stats.retransmits);
+
+    /* window keeps the link busy, so only the final round trip is spent waiting */
+    TEST_ASSERT(ticks <= (wt20_frag_count(MESSAGE_BYTES) + (3U * LATENCY_TICKS)));
+}
+
+void test_wt20_bulk_goodput_vs_loss(void)
+{
+    static const uint32_t loss_rates[] = {0U, 5U, 10U, 20U, 30U};
+    uint16_t count = wt20_frag_count(MESSAGE_BYTES);
+    uint32_t i;
+    uint32_t j;
+
+    printf("loss %%  ticks  sent  retx  goodput (%% of link rate, averaged over %u transfers)\n",
+           (unsigned)TRANSFERS_PER_RATE);
+
+    for (i = 0U; i < (sizeof(loss_rates) / sizeof(loss_rates[0])); i++)
+    {
+        uint32_t ticks = 0U;
+        uint32_t sent = 0U;
+        uint32_t retransmits = 0U;
+        uint32_t goodput_pct;
+
+        for (j = 0U; j < TRANSFERS_PER_RATE; j++)
+        {
+            ticks += run_transfer(loss_rates[i], (uint8_t)((i * TRANSFERS_PER_RATE) + j));
+            sent += tx.stats.frames_sent;
+            retransmits += tx.stats.retransmits;
+        }
+
+        goodput_pct = (count * TRANSFERS_PER_RATE * 100U) / ticks;
+
+        printf("%6u  %5u  %4u  %4u  %u%%\n",
+               (unsigned)loss_rates[i],
+               (unsigned)(ticks / TRANSFERS_PER_RATE),
+               (unsigned)(sent / TRANSFERS_PER_RATE),
+               (unsigned)(retransmits / TRANSFERS_PER_RATE),
+               (unsigned)goodput_pct);
+
+        /* only lost frames are resent, so goodput tracks 1 - loss. The margin covers the final
+           round trips, which dominate a message this short. Stop and wait would manage
+           (1 - loss)^2 / (2 * LATENCY_TICKS + 1) */
+        TEST_ASSERT((goodput_pct * 2U) >= (100U - loss_rates[i]));
+    }
+
+    /* lossless link runs at nearly the raw rate */
+    TEST_ASSERT(((count * 100U) / run_transfer(0U, 0xFFU)) >= 90U);
+}
+
+void test_wt20_bulk_gives_up_without_acks(void)
+{
+    uint8_t frame[WT20_BULK_DATA_FRAME_BYTES];
+    uint16_t frame_length;
+    uint32_t now;
+
+    wt20_bulk_tx_start(&tx, 7U, message, MESSAGE_BYTES, DATA_COMMAND, POLL_COMMAND, 0U);
+
+    for (now = 0U; now <= WT20_BULK_GIVE_UP_MS; now++)
+    {
+        (void)wt20_bulk_tx_next(&tx, now, frame, &frame_length);
+    }
+
+    TEST_ASSERT_EQUAL_INT(WT20_BULK_FAILED, wt20_bulk_tx_state(&tx));
+    TEST_ASSERT(tx.stats.ack_timeouts > 0U);
+}
+
+void test_wt20_bulk_ignores_ack_for_other_message(void)
+{
+    uint8_t ack[WT20_BULK_ACK_MAX_BYTES];
+    uint16_t count = wt20_frag_count(MESSAGE_BYTES);
+
+    wt20_bulk_tx_start(&tx, 3U, message, MESSAGE_BYTES, DATA_COMMAND, POLL_COMMAND, 0U);
+
+    memset(ack, 0xFFU, sizeof(ack));
+    ack[0] = ACK_COMMAND;
+    ack[1] = 4U;
+    ack[2] = 0U;
+    ack[3] = 0U;
+    ack[4] = (uint8_t)(count & 0xFFU);
+    ack[5] = (uint8_t)(count >> 8U);
+    wt20_bulk_tx_on_ack(&tx, ack, sizeof(ack), 0U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_BULK_IN_PROGRESS, wt20_bulk_tx_state(&tx));
+    TEST_ASSERT_EQUAL_INT(0U, tx.stats.acks);
+
+    ack[1] = 3U;
+    wt20_bulk_tx_on_ack(&tx, ack, sizeof(ack), 0U);
+    TEST_ASSERT_EQUAL_INT(WT20_BULK_COMPLETE, wt20_bulk_tx_state(&tx));
+}
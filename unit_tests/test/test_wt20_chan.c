@@ -0,0 +1,178 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_chan.h"
+#include "espnow_link_chan.h"
+
+static const uint8_t low_mac[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x01U};
+static const uint8_t mid_mac[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x05U};
+static const uint8_t high_mac[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x09U};
+
+static WT20_CHAN_T leader;
+static WT20_CHAN_T follower;
+
+/* runs leader from start_ms to end_ms a ms at a time, follower hearing each announcement and
+   leader hearing each ack if acks_heard. Returns announcements sent */
+static uint32_t run(uint32_t start_ms, uint32_t end_ms, bool acks_heard)
+{
+    uint8_t payload[WT20_CHAN_SWITCH_BYTES];
+    uint8_t ack[WT20_CHAN_ACK_BYTES];
+    uint32_t sent = 0U;
+    uint32_t now_ms;
+    uint16_t length;
+
+    for (now_ms = start_ms; now_ms < end_ms; now_ms++)
+    {
+        length = wt20_chan_next_announce(&leader, now_ms, payload);
+
+        if (length == 0U)
+        {
+            continue;
+        }
+
+        sent++;
+
+        if (wt20_chan_on_announce(&follower, mid_mac, payload, length, now_ms))
+        {
+            TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_ACK_BYTES, wt20_chan_build_ack(&follower, ack));
+
+            if (acks_heard)
+            {
+                TEST_ASSERT(wt20_chan_on_ack(&leader, 3U, ack, sizeof(ack)));
+            }
+        }
+    }
+
+    return sent;
+}
+
+void setUp(void)
+{
+    wt20_chan_init(&leader, mid_mac);
+    wt20_chan_init(&follower, high_mac);
+}
+
+void tearDown(void) { }
+
+void test_wt20_chan_leader_and_follower_switch_together(void)
+{
+    uint32_t due_ms = 0U;
+    uint8_t channel = 0U;
+
+    TEST_ASSERT_FALSE(wt20_chan_pending(&leader, NULL));
+    TEST_ASSERT(wt20_chan_start(&leader, 11U, 7U, 1UL << 2U, 1000U));
+    TEST_ASSERT(wt20_chan_pending(&leader, &due_ms));
+    TEST_ASSERT_EQUAL_UINT32(1000U, due_ms);
+
+    /* one announcement, one ack, then quiet until the switch */
+    TEST_ASSERT_EQUAL_UINT32(1U, run(1000U, 1100U, true));
+    TEST_ASSERT(wt20_chan_pending(&leader, &due_ms));
+    TEST_ASSERT_EQUAL_UINT32(1000U + WT20_CHAN_SWITCH_DELAY_MS, due_ms);
+    TEST_ASSERT(wt20_chan_pending(&follower, &due_ms));
+    TEST_ASSERT_EQUAL_UINT32(1000U + WT20_CHAN_SWITCH_DELAY_MS, due_ms);
+
+    /* both move on the same ms */
+    TEST_ASSERT_FALSE(wt20_chan_due(&leader, 999U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_FALSE(wt20_chan_due(&follower, 999U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT(wt20_chan_due(&leader, 1000U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT8(11U, channel);
+    channel = 0U;
+    TEST_ASSERT(wt20_chan_due(&follower, 1000U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT8(11U, channel);
+
+    TEST_ASSERT_FALSE(wt20_chan_pending(&leader, NULL));
+    TEST_ASSERT_EQUAL_UINT32(1U, leader.stats.switches);
+    TEST_ASSERT_EQUAL_UINT32(1U, leader.stats.acks_received);
+    TEST_ASSERT_EQUAL_UINT32(0U, leader.stats.unacked);
+    TEST_ASSERT_EQUAL_UINT32(1U, follower.stats.switches);
+    TEST_ASSERT_EQUAL_UINT32(1U, follower.stats.acks_sent);
+}
+
+void test_wt20_chan_leader_repeats_until_acked_or_time_is_up(void)
+{
+    uint8_t channel;
+    uint32_t sent;
+
+    /* the ack never makes it back. Announcements go on at the interval up to the switch */
+    TEST_ASSERT(wt20_chan_start(&leader, 6U, 1U, 1UL << 2U, 0U));
+    sent = run(0U, WT20_CHAN_SWITCH_DELAY_MS + 50U, false);
+    TEST_ASSERT_EQUAL_UINT32((WT20_CHAN_SWITCH_DELAY_MS + WT20_CHAN_ANNOUNCE_INTERVAL_MS - 1U) / WT20_CHAN_ANNOUNCE_INTERVAL_MS, sent);
+    TEST_ASSERT_EQUAL_UINT32(sent, follower.stats.acks_sent);
+
+    /* the follower heard the first and every later one, and still switches on the first's time */
+    TEST_ASSERT(wt20_chan_due(&follower, WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT(wt20_chan_due(&leader, WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT32(1U, leader.stats.unacked);
+
+    /* with no peers to wait on it also announces all the way */
+    TEST_ASSERT(wt20_chan_start(&leader, 1U, 2U, 0U, 5000U));
+    TEST_ASSERT_EQUAL_UINT32(sent, run(5000U, 5000U + WT20_CHAN_SWITCH_DELAY_MS, true));
+    TEST_ASSERT(wt20_chan_due(&leader, 5000U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT32(1U, leader.stats.unacked);
+}
+
+void test_wt20_chan_lower_mac_wins_a_conflict(void)
+{
+    uint8_t payload[WT20_CHAN_SWITCH_BYTES];
+    uint8_t ack[WT20_CHAN_ACK_BYTES];
+    WT20_CHAN_T low;
+    uint8_t channel;
+
+    wt20_chan_init(&low, low_mac);
+
+    /* leader and follower both start, then hear each other. The follower's mac is higher */
+    TEST_ASSERT(wt20_chan_start(&leader, 11U, 1U, 0U, 0U));
+    TEST_ASSERT(wt20_chan_start(&follower, 3U, 9U, 0U, 0U));
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_SWITCH_BYTES, wt20_chan_next_announce(&follower, 0U, payload));
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&leader, high_mac, payload, sizeof(payload), 1U));
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_SWITCH_BYTES, wt20_chan_next_announce(&leader, 1U, payload));
+    TEST_ASSERT(wt20_chan_on_announce(&follower, mid_mac, payload, sizeof(payload), 2U));
+    TEST_ASSERT_EQUAL_UINT32(1U, leader.stats.conflicts);
+    TEST_ASSERT_EQUAL_UINT32(1U, follower.stats.conflicts);
+
+    /* an ack for the given up switch isn't taken */
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_ACK_BYTES, wt20_chan_build_ack(&follower, ack));
+    TEST_ASSERT(wt20_chan_on_ack(&leader, 1U, ack, sizeof(ack)));
+    ack[0] ^= 0xFFU;
+    TEST_ASSERT_FALSE(wt20_chan_on_ack(&leader, 1U, ack, sizeof(ack)));
+
+    /* a unit following a lower mac can't start its own */
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_SWITCH_BYTES, wt20_chan_next_announce(&leader, 30U, payload));
+    TEST_ASSERT(wt20_chan_on_announce(&low, mid_mac, payload, sizeof(payload), 30U));
+    TEST_ASSERT(wt20_chan_start(&low, 6U, 4U, 0U, 31U));
+    TEST_ASSERT_FALSE(wt20_chan_start(&follower, 6U, 10U, 0U, 31U));
+
+    /* and the lowest of all takes everyone along */
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_SWITCH_BYTES, wt20_chan_next_announce(&low, 31U, payload));
+    TEST_ASSERT(wt20_chan_on_announce(&leader, low_mac, payload, sizeof(payload), 31U));
+    TEST_ASSERT(wt20_chan_on_announce(&follower, low_mac, payload, sizeof(payload), 31U));
+    TEST_ASSERT(wt20_chan_due(&follower, 31U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT8(6U, channel);
+    TEST_ASSERT(wt20_chan_due(&leader, 31U + WT20_CHAN_SWITCH_DELAY_MS, &channel));
+    TEST_ASSERT_EQUAL_UINT8(6U, channel);
+}
+
+void test_wt20_chan_rejects_bad_announcements(void)
+{
+    uint8_t payload[WT20_CHAN_SWITCH_BYTES];
+
+    TEST_ASSERT(wt20_chan_start(&leader, ESPNOW_LINK_CHAN_LAST, 1U, 0U, 0U));
+    TEST_ASSERT_EQUAL_UINT16(WT20_CHAN_SWITCH_BYTES, wt20_chan_next_announce(&leader, 0U, payload));
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&follower, mid_mac, payload, sizeof(payload) - 1U, 0U));
+
+    /* its own, coming back */
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&leader, mid_mac, payload, sizeof(payload), 0U));
+
+    payload[2] = ESPNOW_LINK_CHAN_LAST + 1U;
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&follower, mid_mac, payload, sizeof(payload), 0U));
+    payload[2] = 0U;
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&follower, mid_mac, payload, sizeof(payload), 0U));
+
+    /* a countdown longer than any switch takes */
+    payload[2] = ESPNOW_LINK_CHAN_LAST;
+    payload[3] = 0xFFU;
+    payload[4] = 0xFFU;
+    TEST_ASSERT_FALSE(wt20_chan_on_announce(&follower, mid_mac, payload, sizeof(payload), 0U));
+    TEST_ASSERT_FALSE(wt20_chan_pending(&follower, NULL));
+}
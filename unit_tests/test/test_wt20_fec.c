@@ -0,0 +1,375 @@
+#include "unity.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "gf256.h"
+#include "wt20_fec.h"
+
+#define FRAME_BYTES (WT20_FEC_MAX_FRAME_BYTES)
+#define CODED_BYTES (WT20_FEC_HDR_BYTES + FRAME_BYTES)
+#define MAX_GROUP (WT20_FEC_MAX_DATA_FRAMES + WT20_FEC_MAX_PARITY_FRAMES)
+
+/* a voice frame every 20 ms is the real time budget the coding cost is compared against */
+#define FRAME_PERIOD_US (20000U)
+#define BENCH_GROUPS (2000U)
+
+static WT20_FEC_ENCODER_T encoder;
+static WT20_FEC_DECODER_T decoder;
+static uint8_t frames[WT20_FEC_MAX_DATA_FRAMES][FRAME_BYTES];
+static uint8_t coded[MAX_GROUP][CODED_BYTES];
+
+static uint32_t delivered;
+static uint32_t delivered_recovered;
+static uint32_t next_seq_bits;
+static bool contents_match;
+
+static void frame_callback(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    uint32_t k = *(const uint32_t*)context;
+
+    delivered++;
+    delivered_recovered += recovered ? 1U : 0U;
+    next_seq_bits |= (1UL << (seq % k));
+
+    if ((length != FRAME_BYTES) || (memcmp(frame, frames[seq % k], FRAME_BYTES) != 0))
+    {
+        contents_match = false;
+    }
+}
+
+static void fill_frames(uint32_t seed)
+{
+    uint32_t i;
+    uint32_t j;
+
+    for (i = 0U; i < WT20_FEC_MAX_DATA_FRAMES; i++)
+    {
+        for (j = 0U; j < FRAME_BYTES; j++)
+        {
+            seed = (seed * 1103515245U) + 12345U;
+            frames[i][j] = (uint8_t)(seed >> 16U);
+        }
+    }
+}
+
+/* codes one group into coded[], data first then parity */
+static void encode_group(uint32_t k, uint32_t m)
+{
+    uint32_t i;
+
+    for (i = 0U; i < k; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(CODED_BYTES, wt20_fec_encode(&encoder, frames[i], FRAME_BYTES, coded[i]));
+    }
+
+    for (i = 0U; i < m; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(CODED_BYTES, wt20_fec_next_parity(&encoder, coded[k + i]));
+    }
+
+    TEST_ASSERT_EQUAL_INT(0U, wt20_fec_next_parity(&encoder, coded[0]));
+}
+
+static void setup_code(uint32_t k, uint32_t m, uint32_t* k_context)
+{
+    WT20_FEC_CONFIG_T config = {.k = (uint8_t)k, .m = (uint8_t)m, .frame_bytes = FRAME_BYTES};
+
+    *k_context = k;
+    TEST_ASSERT(wt20_fec_encoder_init(&encoder, &config));
+    TEST_ASSERT(wt20_fec_decoder_init(&decoder, &config, frame_callback, k_context));
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void setUp(void)
+{
+    gf256_init();
+    fill_frames(1U);
+    delivered = 0U;
+    delivered_recovered = 0U;
+    next_seq_bits = 0U;
+    contents_match = true;
+}
+
+void tearDown(void) { }
+
+void test_gf256_field_identities(void)
+{
+    GF256_MUL_TABLE_T table;
+    uint8_t region[256U];
+    uint8_t expected[256U];
+    uint32_t a;
+    uint32_t b;
+
+    for (a = 1U; a < 256U; a++)
+    {
+        TEST_ASSERT_EQUAL_INT(1U, gf256_mul((uint8_t)a, gf256_inv((uint8_t)a)));
+    }
+
+    /* bulk nibble tables agree with log/exp multiply for every constant and byte */
+    for (a = 0U; a < 256U; a++)
+    {
+        gf256_mul_table((uint8_t)a, &table);
+
+        for (b = 0U; b < 256U; b++)
+        {
+            region[b] = (uint8_t)b;
+            expected[b] = gf256_mul((uint8_t)a, (uint8_t)b);
+        }
+
+        gf256_mul_region(region, &table, sizeof(region));
+        TEST_ASSERT_EQUAL_MEMORY(expected, region, sizeof(region));
+    }
+}
+
+void test_wt20_fec_xor_parity_rebuilds_any_single_loss(void)
+{
+    uint32_t k_context;
+    uint32_t lost;
+    uint32_t i;
+
+    setup_code(4U, 1U, &k_context);
+
+    for (lost = 0U; lost < 4U; lost++)
+    {
+        encode_group(4U, 1U);
+        next_seq_bits = 0U;
+
+        for (i = 0U; i < 5U; i++)
+        {
+            if (i != lost)
+            {
+                TEST_ASSERT(wt20_fec_decode(&decoder, coded[i], CODED_BYTES));
+            }
+        }
+
+        TEST_ASSERT_EQUAL_HEX32(0x0FU, next_seq_bits);
+    }
+
+    TEST_ASSERT_EQUAL_INT(4U, decoder.stats.recovered);
+    TEST_ASSERT(contents_match);
+}
+
+void test_wt20_fec_reed_solomon_rebuilds_every_erasure_pattern(void)
+{
+    uint32_t k_context;
+    uint32_t k = WT20_FEC_MAX_DATA_FRAMES;
+    uint32_t m = WT20_FEC_MAX_PARITY_FRAMES;
+    uint32_t n = k + m;
+    uint32_t pattern;
+    uint32_t patterns = 0U;
+    uint32_t i;
+
+    setup_code(k, m, &k_context);
+
+    /* every way of losing up to m frames of a group */
+    for (pattern = 0U; pattern < (1UL << n); pattern++)
+    {
+        uint32_t losses = 0U;
+
+        for (i = 0U; i < n; i++)
+        {
+            losses += (pattern >> i) & 1U;
+        }
+
+        if (losses > m)
+        {
+            continue;
+        }
+
+        encode_group(k, m);
+        next_seq_bits = 0U;
+
+        for (i = 0U; i < n; i++)
+        {
+            if (((pattern >> i) & 1U) == 0U)
+            {
+                TEST_ASSERT(wt20_fec_decode(&decoder, coded[i], CODED_BYTES));
+            }
+        }
+
+        TEST_ASSERT_EQUAL_HEX32((1UL << k) - 1U, next_seq_bits);
+        patterns++;
+    }
+
+    TEST_ASSERT(contents_match);
+    TEST_ASSERT_EQUAL_INT(0U, decoder.stats.unrecoverable);
+    printf("%u erasure patterns of up to %u frames rebuilt, k = %u\n", (unsigned)patterns, (unsigned)m, (unsigned)k);
+}
+
+void test_wt20_fec_too_many_losses_counted(void)
+{
+    uint32_t k_context;
+
+    setup_code(4U, 1U, &k_context);
+
+    /* two data frames of first group lost, so xor parity can't help */
+    encode_group(4U, 1U);
+    wt20_fec_decode(&decoder, coded[0], CODED_BYTES);
+    wt20_fec_decode(&decoder, coded[1], CODED_BYTES);
+    wt20_fec_decode(&decoder, coded[4], CODED_BYTES);
+
+    /* groups that follow push it out of the decoder */
+    encode_group(4U, 1U);
+    wt20_fec_decode(&decoder, coded[0], CODED_BYTES);
+    encode_group(4U, 1U);
+    wt20_fec_decode(&decoder, coded[0], CODED_BYTES);
+
+    TEST_ASSERT_EQUAL_INT(2U, decoder.stats.unrecoverable);
+    TEST_ASSERT_EQUAL_INT(0U, decoder.stats.recovered);
+}
+
+void test_wt20_fec_sequence_survives_group_id_wrap(void)
+{
+    uint32_t k_context;
+    uint32_t group;
+
+    setup_code(2U, 1U, &k_context);
+
+    for (group = 0U; group < 300U; group++)
+    {
+        encode_group(2U, 1U);
+        wt20_fec_decode(&decoder, coded[0], CODED_BYTES);
+        wt20_fec_decode(&decoder, coded[2], CODED_BYTES);
+    }
+
+    /* group ids wrapped, group count keeps going */
+    TEST_ASSERT_EQUAL_INT(299U, decoder.newest_group);
+    TEST_ASSERT_EQUAL_INT(300U, decoder.stats.recovered);
+    TEST_ASSERT(contents_match);
+}
+
+void test_wt20_fec_rejects_mismatched_frames(void)
+{
+    uint32_t k_context;
+
+    setup_code(4U, 2U, &k_context);
+    encode_group(4U, 2U);
+
+    TEST_ASSERT_FALSE(wt20_fec_decode(&decoder, coded[0], CODED_BYTES - 1U));
+    coded[0][2] = 5U; /* k */
+    TEST_ASSERT_FALSE(wt20_fec_decode(&decoder, coded[0], CODED_BYTES));
+    TEST_ASSERT_EQUAL_INT(2U, decoder.stats.invalid);
+}
+
+static uint32_t resized_seqs[16U];
+static uint16_t resized_lengths[16U];
+static uint32_t resized_count;
+
+static void resized_callback(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    if (resized_count < 16U)
+    {
+        resized_seqs[resized_count] = seq;
+        resized_lengths[resized_count] = length;
+    }
+
+    resized_count++;
+}
+
+void test_wt20_fec_frame_size_changes_between_groups(void)
+{
+    WT20_FEC_CONFIG_T config = {.k = 2U, .m = 1U, .frame_bytes = FRAME_BYTES};
+
+    resized_count = 0U;
+    TEST_ASSERT(wt20_fec_encoder_init(&encoder, &config));
+    TEST_ASSERT(wt20_fec_decoder_init(&decoder, &config, resized_callback, NULL));
+
+    TEST_ASSERT_EQUAL_INT(CODED_BYTES, wt20_fec_encode(&encoder, frames[0], FRAME_BYTES, coded[0]));
+
+    /* not in the middle of a group, and never out of range */
+    TEST_ASSERT_FALSE(wt20_fec_encoder_resize(&encoder, 60U));
+    TEST_ASSERT_EQUAL_INT(CODED_BYTES, wt20_fec_encode(&encoder, frames[1], FRAME_BYTES, coded[1]));
+    TEST_ASSERT_FALSE(wt20_fec_encoder_resize(&encoder, 60U));
+    TEST_ASSERT_EQUAL_INT(CODED_BYTES, wt20_fec_next_parity(&encoder, coded[2]));
+    TEST_ASSERT_FALSE(wt20_fec_encoder_resize(&encoder, 0U));
+    TEST_ASSERT_FALSE(wt20_fec_encoder_resize(&encoder, FRAME_BYTES + 1U));
+    TEST_ASSERT(wt20_fec_encoder_resize(&encoder, 60U));
+
+    /* next group goes out shorter, and its parity still rebuilds a frame */
+    TEST_ASSERT_EQUAL_INT(WT20_FEC_HDR_BYTES + 60U, wt20_fec_encode(&encoder, frames[2], 60U, coded[3]));
+    TEST_ASSERT_EQUAL_INT(WT20_FEC_HDR_BYTES + 60U, wt20_fec_encode(&encoder, frames[3], 60U, coded[4]));
+    TEST_ASSERT_EQUAL_INT(WT20_FEC_HDR_BYTES + 60U, wt20_fec_next_parity(&encoder, coded[5]));
+
+    /* first group lost its first frame, the decoder is told about the new size once the parity
+       that would have rebuilt it is lost too */
+    TEST_ASSERT(wt20_fec_decode(&decoder, coded[1], CODED_BYTES));
+    TEST_ASSERT_FALSE(wt20_fec_decode(&decoder, coded[3], WT20_FEC_HDR_BYTES + 60U));
+    TEST_ASSERT(wt20_fec_decoder_resize(&decoder, 60U));
+    TEST_ASSERT_EQUAL_INT(1U, decoder.stats.unrecoverable);
+    TEST_ASSERT(wt20_fec_decode(&decoder, coded[4], WT20_FEC_HDR_BYTES + 60U));
+    TEST_ASSERT(wt20_fec_decode(&decoder, coded[5], WT20_FEC_HDR_BYTES + 60U));
+    TEST_ASSERT_FALSE(wt20_fec_decoder_resize(&decoder, FRAME_BYTES + 1U));
+
+    /* seq carried on across the change */
+    TEST_ASSERT_EQUAL_INT(3U, resized_count);
+    TEST_ASSERT_EQUAL_INT(1U, resized_seqs[0]);
+    TEST_ASSERT_EQUAL_INT(FRAME_BYTES, resized_lengths[0]);
+    TEST_ASSERT_EQUAL_INT(3U, resized_seqs[1]);
+    TEST_ASSERT_EQUAL_INT(2U, resized_seqs[2]);
+    TEST_ASSERT_EQUAL_INT(60U, resized_lengths[2]);
+
+    TEST_ASSERT_EQUAL_INT(1U, decoder.stats.recovered);
+}
+
+void test_wt20_fec_benchmark(void)
+{
+    static const uint8_t codes[][2] = {{4U, 1U}, {8U, 1U}, {8U, 2U}, {8U, 4U}};
+    uint32_t k_context;
+    uint32_t c;
+    uint32_t g;
+    uint32_t i;
+
+    printf("  k  m  overhead  encode ns/frame  decode ns/frame (m losses)  %% of %u us budget\n",
+           (unsigned)FRAME_PERIOD_US);
+
+    for (c = 0U; c < (sizeof(codes) / sizeof(codes[0])); c++)
+    {
+        uint32_t k = codes[c][0];
+        uint32_t m = codes[c][1];
+        uint64_t encode_ns = 0U;
+        uint64_t decode_ns = 0U;
+        uint64_t start;
+        uint64_t per_frame;
+
+        setup_code(k, m, &k_context);
+
+        for (g = 0U; g < BENCH_GROUPS; g++)
+        {
+            start = now_ns();
+            encode_group(k, m);
+            encode_ns += now_ns() - start;
+
+            /* worst case, the first m data frames are lost and have to be rebuilt */
+            start = now_ns();
+            for (i = m; i < (k + m); i++)
+            {
+                wt20_fec_decode(&decoder, coded[i], CODED_BYTES);
+            }
+            decode_ns += now_ns() - start;
+        }
+
+        TEST_ASSERT(contents_match);
+        TEST_ASSERT_EQUAL_INT(BENCH_GROUPS * m, decoder.stats.recovered);
+
+        per_frame = (encode_ns + decode_ns) / ((uint64_t)BENCH_GROUPS * k);
+        printf("%3u %2u  %7u%%  %15u  %26u  %.3f%%\n",
+               (unsigned)k,
+               (unsigned)m,
+               (unsigned)((m * 100U) / k),
+               (unsigned)(encode_ns / ((uint64_t)BENCH_GROUPS * k)),
+               (unsigned)(decode_ns / ((uint64_t)BENCH_GROUPS * k)),
+               (double)per_frame / (FRAME_PERIOD_US * 10.0));
+
+        /* coding must be a small fraction of real time, even allowing for a much slower target core */
+        TEST_ASSERT(per_frame < ((uint64_t)FRAME_PERIOD_US * 1000U / 100U));
+    }
+}
@@ -0,0 +1,223 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_frag.h"
+
+#define MESSAGE_BYTES (3000U)
+
+static WT20_FRAG_REASSEMBLER_T reassembler;
+static uint8_t message[MESSAGE_BYTES];
+static uint8_t frames[WT20_FRAG_MAX_FRAGMENTS][WT20_FRAG_FRAME_BYTES];
+static uint16_t frame_lengths[WT20_FRAG_MAX_FRAGMENTS];
+
+static uint8_t peer_mac1[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4A, 0x5B};
+static uint8_t peer_mac2[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4B, 0x50};
+
+static uint16_t build_all(uint8_t msg_id, uint32_t length)
+{
+    uint16_t count = wt20_frag_count(length);
+    uint16_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        frame_lengths[i] = wt20_frag_build(msg_id, message, length, i, frames[i]);
+    }
+
+    return count;
+}
+
+void setUp(void)
+{
+    uint32_t i;
+
+    for (i = 0U; i < MESSAGE_BYTES; i++)
+    {
+        message[i] = (uint8_t)(i * 7U);
+    }
+
+    wt20_frag_reassembly_init(&reassembler);
+}
+
+void tearDown(void) { }
+
+void test_wt20_frag_count(void)
+{
+    TEST_ASSERT_EQUAL_INT(1U, wt20_frag_count(0U));
+    TEST_ASSERT_EQUAL_INT(1U, wt20_frag_count(WT20_FRAG_DATA_BYTES));
+    TEST_ASSERT_EQUAL_INT(2U, wt20_frag_count(WT20_FRAG_DATA_BYTES + 1U));
+}
+
+void test_wt20_frag_build_out_of_range(void)
+{
+    TEST_ASSERT_EQUAL_INT(0U, wt20_frag_build(1U, message, 10U, 1U, frames[0]));
+}
+
+void test_wt20_frag_in_order(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint16_t count = build_all(3U, MESSAGE_BYTES);
+    uint16_t i;
+
+    for (i = 0U; i < (count - 1U); i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_FRAG_INCOMPLETE,
+                              wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], 0U, &result));
+    }
+
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_COMPLETE,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], 0U, &result));
+    TEST_ASSERT_EQUAL_INT(MESSAGE_BYTES, result.length);
+    TEST_ASSERT_EQUAL_INT(3U, result.msg_id);
+    TEST_ASSERT_EQUAL_MEMORY(peer_mac1, result.src_mac, 6U);
+    TEST_ASSERT_EQUAL_MEMORY(message, result.data, MESSAGE_BYTES);
+
+    wt20_frag_release(&reassembler, result.slot);
+    TEST_ASSERT_EQUAL_INT(1U, reassembler.stats.completed);
+}
+
+void test_wt20_frag_out_of_order_with_duplicates(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint16_t count = build_all(9U, MESSAGE_BYTES);
+    WT20_FRAG_RESULT_T ret = WT20_FRAG_INCOMPLETE;
+    int32_t i;
+
+    /* last fragment first, so length is learned before the rest arrive */
+    for (i = (int32_t)count - 1; i >= 1; i--)
+    {
+        ret = wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], 0U, &result);
+        TEST_ASSERT_EQUAL_INT(WT20_FRAG_INCOMPLETE, ret);
+    }
+
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_DUPLICATE,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[2], frame_lengths[2], 0U, &result));
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_COMPLETE,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[0], frame_lengths[0], 0U, &result));
+    TEST_ASSERT_EQUAL_INT(MESSAGE_BYTES, result.length);
+    TEST_ASSERT_EQUAL_MEMORY(message, result.data, MESSAGE_BYTES);
+    TEST_ASSERT_EQUAL_INT(1U, reassembler.stats.duplicates);
+}
+
+void test_wt20_frag_interleaved_senders(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint16_t count = build_all(1U, 500U);
+    uint16_t i;
+    uint32_t completed = 0U;
+
+    /* same msg_id from two peers must not be mixed */
+    for (i = 0U; i < count; i++)
+    {
+        completed += (wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], 0U, &result) == WT20_FRAG_COMPLETE) ? 1U : 0U;
+        completed += (wt20_frag_accept(&reassembler, peer_mac2, frames[i], frame_lengths[i], 0U, &result) == WT20_FRAG_COMPLETE) ? 1U : 0U;
+    }
+
+    TEST_ASSERT_EQUAL_INT(2U, completed);
+}
+
+void test_wt20_frag_timeout(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint16_t count = build_all(4U, MESSAGE_BYTES);
+    uint16_t i;
+
+    wt20_frag_accept(&reassembler, peer_mac1, frames[0], frame_lengths[0], 0U, &result);
+
+    /* remaining fragments show up too late, so the message starts over and never completes */
+    for (i = 1U; i < count; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_FRAG_INCOMPLETE,
+                              wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], WT20_FRAG_TIMEOUT_MS, &result));
+    }
+
+    TEST_ASSERT_EQUAL_INT(1U, reassembler.stats.timed_out);
+    TEST_ASSERT_EQUAL_INT(0U, reassembler.stats.completed);
+}
+
+void test_wt20_frag_evicts_oldest_when_pool_full(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint32_t i;
+
+    build_all(0U, MESSAGE_BYTES);
+
+    /* start one more message than there are slots */
+    for (i = 0U; i <= WT20_FRAG_REASSEMBLY_SLOTS; i++)
+    {
+        frames[0][0] = (uint8_t)i; /* msg_id */
+        wt20_frag_accept(&reassembler, peer_mac1, frames[0], frame_lengths[0], i, &result);
+    }
+
+    TEST_ASSERT_EQUAL_INT(1U, reassembler.stats.evicted);
+}
+
+void test_wt20_frag_rejects_malformed(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+
+    build_all(2U, MESSAGE_BYTES);
+
+    /* a middle fragment that isn't full */
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_INVALID, wt20_frag_accept(&reassembler, peer_mac1, frames[1], 20U, 0U, &result));
+
+    /* index past count */
+    frames[0][1] = 0xFFU;
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_INVALID,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[0], frame_lengths[0], 0U, &result));
+
+    /* too short for header */
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_INVALID, wt20_frag_accept(&reassembler, peer_mac1, frames[0], 3U, 0U, &result));
+    TEST_ASSERT_EQUAL_INT(3U, reassembler.stats.invalid);
+}
+
+void test_wt20_frag_rejects_fragment_past_max_message(void)
+{
+    static uint8_t big[WT20_FRAG_MAX_MESSAGE_BYTES];
+    WT20_FRAG_MESSAGE_T result;
+    WT20_FRAG_HDR_T hdr;
+    uint16_t last = WT20_FRAG_MAX_FRAGMENTS - 1U;
+    uint16_t length;
+
+    /* the last fragment of the largest message fits exactly */
+    length = wt20_frag_build(4U, big, sizeof(big), last, frames[0]);
+    TEST_ASSERT(wt20_frag_parse_header(frames[0], length, &hdr));
+
+    /* padded out to a full chunk, it would run past the slot's buffer */
+    memset(&frames[0][length], 0xEEU, WT20_FRAG_FRAME_BYTES - length);
+    TEST_ASSERT_FALSE(wt20_frag_parse_header(frames[0], WT20_FRAG_FRAME_BYTES, &hdr));
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_INVALID,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[0], WT20_FRAG_FRAME_BYTES, 0U, &result));
+    TEST_ASSERT_FALSE(reassembler.slots[0].in_use);
+    TEST_ASSERT_FALSE(reassembler.slots[1].in_use);
+}
+
+void test_wt20_frag_progress_bitmap(void)
+{
+    WT20_FRAG_MESSAGE_T result;
+    uint8_t bitmap[WT20_FRAG_BITMAP_BYTES];
+    uint16_t count = build_all(5U, MESSAGE_BYTES);
+    uint16_t reported_count;
+    uint16_t i;
+
+    TEST_ASSERT_FALSE(wt20_frag_get_progress(&reassembler, peer_mac1, 5U, &reported_count, bitmap));
+
+    wt20_frag_accept(&reassembler, peer_mac1, frames[0], frame_lengths[0], 0U, &result);
+    wt20_frag_accept(&reassembler, peer_mac1, frames[2], frame_lengths[2], 0U, &result);
+
+    TEST_ASSERT(wt20_frag_get_progress(&reassembler, peer_mac1, 5U, &reported_count, bitmap));
+    TEST_ASSERT_EQUAL_INT(count, reported_count);
+    TEST_ASSERT_EQUAL_HEX8(0x05U, bitmap[0]);
+
+    for (i = 1U; i < count; i++)
+    {
+        wt20_frag_accept(&reassembler, peer_mac1, frames[i], frame_lengths[i], 0U, &result);
+    }
+    wt20_frag_release(&reassembler, result.slot);
+
+    /* completed message still reports every fragment, and late copies are duplicates */
+    TEST_ASSERT(wt20_frag_get_progress(&reassembler, peer_mac1, 5U, &reported_count, bitmap));
+    TEST_ASSERT_EQUAL_HEX8(0xFFU, bitmap[0]);
+    TEST_ASSERT_EQUAL_INT(WT20_FRAG_DUPLICATE,
+                          wt20_frag_accept(&reassembler, peer_mac1, frames[1], frame_lengths[1], 0U, &result));
+}
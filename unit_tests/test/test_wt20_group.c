@@ -0,0 +1,150 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_group.h"
+#include "wt20_header.h"
+#include "crc16.h"
+
+static const uint8_t talker[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x03U};
+
+static WT20_GROUP_TX_T tx;
+static WT20_GROUP_RX_T rx;
+static uint8_t payloads[40U][WT20_PAYLOAD_BYTES];
+static uint16_t lengths[40U];
+
+/* talker sends count frames to group, each filled with its index */
+static void send_frames(uint8_t group, uint32_t count)
+{
+    uint8_t frame[20U];
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        memset(frame, (int)i, sizeof(frame));
+        lengths[i] = wt20_group_tx_build(&tx, group, frame, sizeof(frame), payloads[i]);
+    }
+}
+
+static WT20_GROUP_RESULT_T deliver(uint32_t i, bool repair, WT20_GROUP_FRAME_T* frame)
+{
+    return wt20_group_rx_accept(&rx, talker, payloads[i], lengths[i], repair, frame);
+}
+
+void setUp(void)
+{
+    wt20_group_tx_init(&tx);
+    wt20_group_rx_init(&rx);
+}
+
+void tearDown(void) { }
+
+void test_wt20_group_keeps_joined_groups_only(void)
+{
+    WT20_GROUP_FRAME_T frame;
+
+    send_frames(7U, 2U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NOT_MEMBER, deliver(0U, false, &frame));
+
+    wt20_group_rx_set_member(&rx, 7U, true, false);
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(0U, false, &frame));
+    TEST_ASSERT_EQUAL_UINT8(7U, frame.group);
+    TEST_ASSERT_EQUAL_UINT16(0U, frame.seq);
+    TEST_ASSERT_EQUAL_UINT16(20U, frame.length);
+    TEST_ASSERT_EQUAL_UINT8(0U, frame.data[19]);
+
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_DUPLICATE, deliver(0U, false, &frame));
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_INVALID, wt20_group_rx_accept(&rx, talker, payloads[1], 2U, false, &frame));
+
+    wt20_group_rx_set_member(&rx, 7U, false, false);
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NOT_MEMBER, deliver(1U, false, &frame));
+}
+
+void test_wt20_group_counts_each_group_separately(void)
+{
+    uint8_t frame[4U] = {0};
+    uint8_t payload[WT20_PAYLOAD_BYTES];
+
+    (void)wt20_group_tx_build(&tx, 1U, frame, sizeof(frame), payload);
+    (void)wt20_group_tx_build(&tx, 2U, frame, sizeof(frame), payload);
+    (void)wt20_group_tx_build(&tx, 1U, frame, sizeof(frame), payload);
+
+    TEST_ASSERT_EQUAL_UINT8(1U, payload[0]);
+    TEST_ASSERT_EQUAL_UINT8(1U, payload[1]);
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_tx_build(&tx, 1U, payloads[0], WT20_GROUP_MAX_FRAME_BYTES + 1U, payload));
+}
+
+void test_wt20_group_nack_brings_back_lost_frames(void)
+{
+    WT20_GROUP_FRAME_T frame;
+    uint8_t nack[WT20_GROUP_NACK_BYTES];
+    uint8_t repair[WT20_PAYLOAD_BYTES];
+    uint16_t length;
+
+    wt20_group_rx_set_member(&rx, 3U, true, true);
+    send_frames(3U, 6U);
+
+    /* 1 and 3 lost in the air */
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(0U, false, &frame));
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_rx_build_nack(&rx, talker, 3U, 100U, nack));
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(2U, false, &frame));
+    TEST_ASSERT_EQUAL_UINT16(WT20_GROUP_NACK_BYTES, wt20_group_rx_build_nack(&rx, talker, 3U, 100U, nack));
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(4U, false, &frame));
+
+    /* held off, then asks for both */
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_rx_build_nack(&rx, talker, 3U, 100U + WT20_GROUP_NACK_HOLDOFF_MS - 1U, nack));
+    TEST_ASSERT_EQUAL_UINT16(WT20_GROUP_NACK_BYTES,
+                             wt20_group_rx_build_nack(&rx, talker, 3U, 100U + WT20_GROUP_NACK_HOLDOFF_MS, nack));
+    TEST_ASSERT_EQUAL_UINT8(4U, nack[1]);
+    TEST_ASSERT_EQUAL_UINT8(0x0AU, nack[3]);
+
+    TEST_ASSERT(wt20_group_tx_on_nack(&tx, nack, sizeof(nack)));
+
+    /* oldest first */
+    length = wt20_group_tx_next_repair(&tx, 200U, repair);
+    TEST_ASSERT_EQUAL_UINT16(lengths[1], length);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(payloads[1], repair, length);
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_REPAIRED, wt20_group_rx_accept(&rx, talker, repair, length, true, &frame));
+    TEST_ASSERT_EQUAL_UINT16(1U, frame.seq);
+
+    length = wt20_group_tx_next_repair(&tx, 200U, repair);
+    TEST_ASSERT_EQUAL_UINT16(lengths[3], length);
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_REPAIRED, wt20_group_rx_accept(&rx, talker, repair, length, true, &frame));
+    TEST_ASSERT_EQUAL_UINT16(3U, frame.seq);
+
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_tx_next_repair(&tx, 200U, repair));
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_rx_build_nack(&rx, talker, 3U, 1000U, nack));
+
+    /* second member asking for the same frame right away gets the rebroadcast already sent */
+    TEST_ASSERT(wt20_group_tx_on_nack(&tx, (const uint8_t[]){3U, 4U, 0U, 0x02U, 0U, 0U, 0U}, WT20_GROUP_NACK_BYTES));
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_tx_next_repair(&tx, 201U, repair));
+    TEST_ASSERT_FALSE(wt20_group_tx_on_nack(&tx, nack, WT20_GROUP_NACK_BYTES - 1U));
+}
+
+void test_wt20_group_only_nacks_what_the_history_holds(void)
+{
+    WT20_GROUP_FRAME_T frame;
+    uint8_t nack[WT20_GROUP_NACK_BYTES];
+    uint8_t repair[WT20_PAYLOAD_BYTES];
+    uint32_t last = WT20_GROUP_HISTORY + 4U;
+    uint32_t missing;
+
+    wt20_group_rx_set_member(&rx, 9U, true, true);
+    send_frames(9U, last + 1U);
+
+    /* first frame, then a long gap */
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(0U, false, &frame));
+    TEST_ASSERT_EQUAL_INT(WT20_GROUP_NEW, deliver(last, false, &frame));
+    TEST_ASSERT_EQUAL_UINT16(WT20_GROUP_NACK_BYTES, wt20_group_rx_build_nack(&rx, talker, 9U, 0U, nack));
+
+    missing = (uint32_t)nack[3] | ((uint32_t)nack[4] << 8U) | ((uint32_t)nack[5] << 16U) | ((uint32_t)nack[6] << 24U);
+    TEST_ASSERT_EQUAL_HEX32(((1UL << WT20_GROUP_HISTORY) - 1U) & ~1UL, missing);
+
+    TEST_ASSERT(wt20_group_tx_on_nack(&tx, nack, sizeof(nack)));
+    TEST_ASSERT_EQUAL_UINT16(lengths[last - (WT20_GROUP_HISTORY - 1U)], wt20_group_tx_next_repair(&tx, 0U, repair));
+
+    /* joined without repair, gaps are left alone */
+    wt20_group_rx_set_member(&rx, 9U, true, false);
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_group_rx_build_nack(&rx, talker, 9U, 1000U, nack));
+}
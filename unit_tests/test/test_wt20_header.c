@@ -0,0 +1,151 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "crc16.h"
+#include "wt20_header.h"
+
+static const uint8_t mac_a[WT20_DEDUP_MAC_BYTES] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x60};
+static const uint8_t mac_b[WT20_DEDUP_MAC_BYTES] = {0x10, 0x20, 0x30, 0x40, 0x50, 0x61};
+
+static uint8_t frame[WT20_FRAME_BYTES];
+static WT20_DEDUP_T dedup;
+
+void setUp(void)
+{
+    wt20_dedup_init(&dedup);
+}
+
+void tearDown(void) { }
+
+void test_crc16_matches_ccitt_false_check_value(void)
+{
+    const uint8_t check[] = "123456789";
+
+    TEST_ASSERT_EQUAL_HEX16(0x29B1U, crc16_update(CRC16_INIT, check, 9U));
+
+    /* same result in pieces */
+    TEST_ASSERT_EQUAL_HEX16(0x29B1U, crc16_update(crc16_update(CRC16_INIT, check, 4U), &check[4], 5U));
+}
+
+void test_wt20_header_round_trips(void)
+{
+    WT20_HDR_T sent = {.flags = 0x05U, .type = 0x42U, .seq = 0xBEEFU, .timestamp_ms = 0x1234U};
+    WT20_HDR_T received;
+    uint16_t length;
+
+    memset(&frame[WT20_HDR_BYTES], 0xA5, WT20_PAYLOAD_BYTES);
+    length = wt20_header_build(&sent, frame, WT20_PAYLOAD_BYTES);
+
+    TEST_ASSERT_EQUAL_UINT16(WT20_FRAME_BYTES, length);
+    TEST_ASSERT_EQUAL_HEX8((WT20_HDR_VERSION << 4U) | 0x05U, frame[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x42U, frame[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xEFU, frame[2]);
+    TEST_ASSERT_EQUAL_HEX8(0xBEU, frame[3]);
+
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_OK, wt20_header_parse(frame, length, &received));
+    TEST_ASSERT_EQUAL_UINT8(WT20_HDR_VERSION, received.version);
+    TEST_ASSERT_EQUAL_UINT8(0x05U, received.flags);
+    TEST_ASSERT_EQUAL_UINT8(0x42U, received.type);
+    TEST_ASSERT_EQUAL_UINT16(0xBEEFU, received.seq);
+    TEST_ASSERT_EQUAL_UINT16(0x1234U, received.timestamp_ms);
+
+    /* header alone is a valid frame */
+    TEST_ASSERT_EQUAL_UINT16(WT20_HDR_BYTES, wt20_header_build(&sent, frame, 0U));
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_OK, wt20_header_parse(frame, WT20_HDR_BYTES, &received));
+}
+
+void test_wt20_header_rejects_damaged_frames(void)
+{
+    WT20_HDR_T sent = {.type = 1U, .seq = 7U};
+    WT20_HDR_T received;
+    uint16_t length;
+    uint32_t i;
+
+    memset(&frame[WT20_HDR_BYTES], 0x3C, 100U);
+    length = wt20_header_build(&sent, frame, 100U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_TOO_SHORT, wt20_header_parse(frame, WT20_HDR_BYTES - 1U, &received));
+
+    /* crc covers every byte but its own, header and payload alike */
+    for (i = 0U; i < length; i++)
+    {
+        if ((i == (WT20_HDR_BYTES - 2U)) || (i == (WT20_HDR_BYTES - 1U)))
+        {
+            continue;
+        }
+
+        frame[i] ^= 0x01U;
+        TEST_ASSERT_EQUAL_INT(WT20_HDR_BAD_CRC, wt20_header_parse(frame, length, &received));
+        frame[i] ^= 0x01U;
+    }
+
+    /* a truncated frame doesn't match either */
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_BAD_CRC, wt20_header_parse(frame, length - 1U, &received));
+
+    frame[0] = (uint8_t)((WT20_HDR_VERSION + 1U) << 4U);
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_BAD_VERSION, wt20_header_parse(frame, length, &received));
+}
+
+void test_wt20_dedup_drops_repeats_in_window(void)
+{
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 100U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_a, 100U));
+
+    /* late and out of order frames still get through once */
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 103U));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 101U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_a, 101U));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 102U));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 103U - WT20_DEDUP_WINDOW + 1U));
+
+    /* senders are tracked apart */
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_b, 103U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_b, 103U));
+
+    TEST_ASSERT_EQUAL_UINT32(3U, dedup.duplicates);
+}
+
+void test_wt20_dedup_follows_wrap_and_restart(void)
+{
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 0xFFFEU));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 0xFFFFU));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 0x0000U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_a, 0xFFFFU));
+
+    /* a jump forward past the window forgets what came before */
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 1000U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_a, 1000U));
+
+    /* sender restarted from 0, so its count starts over */
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 0U));
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac_a, 1U));
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac_a, 0U));
+}
+
+void test_wt20_dedup_replaces_quietest_sender(void)
+{
+    uint8_t mac[WT20_DEDUP_MAC_BYTES];
+    uint32_t i;
+
+    memcpy(mac, mac_a, sizeof(mac));
+
+    for (i = 0U; i < WT20_DEDUP_PEERS; i++)
+    {
+        mac[0] = (uint8_t)i;
+        TEST_ASSERT(wt20_dedup_accept(&dedup, mac, 50U));
+    }
+
+    /* hear from the first sender again, so the second is now the quietest */
+    mac[0] = 0U;
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac, 50U));
+
+    mac[0] = 0xF0U;
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac, 50U));
+
+    /* second sender was forgotten, first wasn't */
+    mac[0] = 1U;
+    TEST_ASSERT(wt20_dedup_accept(&dedup, mac, 50U));
+    mac[0] = 0U;
+    TEST_ASSERT_FALSE(wt20_dedup_accept(&dedup, mac, 50U));
+}
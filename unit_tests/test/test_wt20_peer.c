@@ -0,0 +1,163 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_peer.h"
+#include "wt20_header.h"
+#include "crc16.h"
+
+static WT20_PEER_TABLE_T table;
+
+static void mac_of(uint32_t n, uint8_t* mac)
+{
+    mac[0] = 0x40U;
+    mac[1] = 0x4CU;
+    mac[2] = 0xCAU;
+    mac[3] = (uint8_t)(n >> 16U);
+    mac[4] = (uint8_t)(n >> 8U);
+    mac[5] = (uint8_t)n;
+}
+
+/* longest run of occupied index slots, what a lookup of a missing mac walks */
+static uint32_t longest_run(void)
+{
+    uint32_t longest = 0U;
+    uint32_t run = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < (2U * WT20_PEER_HASH_SLOTS); i++)
+    {
+        run = (table.index[i % WT20_PEER_HASH_SLOTS] != WT20_PEER_ID_NONE) ? (run + 1U) : 0U;
+        longest = (run > longest) ? run : longest;
+    }
+
+    return longest;
+}
+
+void setUp(void)
+{
+    wt20_peer_table_init(&table);
+}
+
+void tearDown(void) { }
+
+void test_wt20_peer_add_find_and_get(void)
+{
+    uint8_t mac_a[WT20_PEER_MAC_BYTES];
+    uint8_t mac_b[WT20_PEER_MAC_BYTES];
+    WT20_PEER_T* peer;
+
+    mac_of(0xDF80U, mac_a);
+    mac_of(0x67ECU, mac_b);
+
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_peer_find(&table, mac_a));
+    TEST_ASSERT_EQUAL_UINT8(1U, wt20_peer_add(&table, mac_a));
+    TEST_ASSERT_EQUAL_UINT8(2U, wt20_peer_add(&table, mac_b));
+    TEST_ASSERT_EQUAL_UINT8(1U, wt20_peer_add(&table, mac_a));
+    TEST_ASSERT_EQUAL_UINT32(2U, table.count);
+
+    TEST_ASSERT_EQUAL_UINT8(1U, wt20_peer_find(&table, mac_a));
+    TEST_ASSERT_EQUAL_UINT8(2U, wt20_peer_find(&table, mac_b));
+
+    peer = wt20_peer_get(&table, 2U);
+    TEST_ASSERT_NOT_NULL(peer);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(mac_b, peer->mac, WT20_PEER_MAC_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(0U, peer->stats.frames_rx);
+
+    TEST_ASSERT_NULL(wt20_peer_get(&table, WT20_PEER_ID_NONE));
+    TEST_ASSERT_NULL(wt20_peer_get(&table, 3U));
+    TEST_ASSERT_NULL(wt20_peer_get(&table, WT20_PEER_MAX + 1U));
+}
+
+void test_wt20_peer_table_fills_up(void)
+{
+    uint8_t mac[WT20_PEER_MAC_BYTES];
+    uint32_t i;
+
+    for (i = 0U; i < WT20_PEER_MAX; i++)
+    {
+        mac_of(i, mac);
+        TEST_ASSERT_EQUAL_UINT8(i + 1U, wt20_peer_add(&table, mac));
+    }
+
+    mac_of(WT20_PEER_MAX, mac);
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_peer_add(&table, mac));
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_peer_find(&table, mac));
+
+    /* consecutive macs, the usual case for a batch of boards, don't pile up in the index */
+    TEST_ASSERT(longest_run() <= 4U);
+
+    for (i = 0U; i < WT20_PEER_MAX; i++)
+    {
+        mac_of(i, mac);
+        TEST_ASSERT_EQUAL_UINT8(i + 1U, wt20_peer_find(&table, mac));
+    }
+}
+
+void test_wt20_peer_remove_frees_lowest_id_and_keeps_others_findable(void)
+{
+    uint8_t mac[WT20_PEER_MAC_BYTES];
+    WT20_PEER_T* peer;
+    uint32_t i;
+
+    for (i = 0U; i < WT20_PEER_MAX; i++)
+    {
+        mac_of(i * 977U, mac);
+        (void)wt20_peer_add(&table, mac);
+    }
+
+    peer = wt20_peer_get(&table, 4U);
+    peer->stats.frames_rx = 10U;
+
+    TEST_ASSERT(wt20_peer_remove(&table, 4U));
+    TEST_ASSERT_FALSE(wt20_peer_remove(&table, 4U));
+    TEST_ASSERT_NULL(wt20_peer_get(&table, 4U));
+    TEST_ASSERT_EQUAL_UINT32(WT20_PEER_MAX - 1U, table.count);
+
+    mac_of(3U * 977U, mac);
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_peer_find(&table, mac));
+
+    for (i = 0U; i < WT20_PEER_MAX; i++)
+    {
+        mac_of(i * 977U, mac);
+        TEST_ASSERT_EQUAL_UINT8((i == 3U) ? WT20_PEER_ID_NONE : (i + 1U), wt20_peer_find(&table, mac));
+    }
+
+    /* the freed id is reused, with fresh state */
+    mac_of(0xABCDEFU, mac);
+    TEST_ASSERT_EQUAL_UINT8(4U, wt20_peer_add(&table, mac));
+    TEST_ASSERT_EQUAL_UINT32(0U, wt20_peer_get(&table, 4U)->stats.frames_rx);
+}
+
+void test_wt20_peer_remove_in_colliding_runs(void)
+{
+    uint8_t mac[WT20_PEER_MAC_BYTES];
+    uint32_t round;
+    uint32_t i;
+    uint32_t n;
+
+    /* churn through many macs, removing from the middle of runs, and check every lookup */
+    for (round = 0U; round < 200U; round++)
+    {
+        for (i = 0U; i < WT20_PEER_MAX; i++)
+        {
+            mac_of((round * 31U) + (i * 7U), mac);
+            (void)wt20_peer_add(&table, mac);
+        }
+
+        for (i = 0U; i < WT20_PEER_MAX; i += 3U)
+        {
+            n = (round * 31U) + (i * 7U);
+            mac_of(n, mac);
+            (void)wt20_peer_remove(&table, wt20_peer_find(&table, mac));
+        }
+
+        for (i = 1U; i <= WT20_PEER_MAX; i++)
+        {
+            if (wt20_peer_get(&table, (WT20_PEER_ID_T)i) != NULL)
+            {
+                TEST_ASSERT_EQUAL_UINT8(i, wt20_peer_find(&table, wt20_peer_get(&table, (WT20_PEER_ID_T)i)->mac));
+            }
+        }
+    }
+}
@@ -3,7 +3,23 @@
 #include <string.h>
 
 #include "wt20_protocol.h"
+#include "wt20_frag.h"
+#include "wt20_bulk.h"
+#include "wt20_fec.h"
+#include "gf256.h"
+#include "wt20_header.h"
+#include "crc16.h"
+#include "mem_pool.h"
+#include "metrics.h"
+#include "wt20_peer.h"
+#include "wt20_group.h"
+#include "wt20_relay.h"
+#include "wt20_chan.h"
+#include "wt20_vrate.h"
+#include "adpcm.h"
+#include "espnow_link_chan.h"
 #include "mock_espnow_link.h"
+#include "mock_timing.h"
 
 static uint8_t peer_mac1[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4A, 0x5B};
 static uint8_t mock_mac[6U] = {0x56, 0x78, 0x12, 0xFE, 0x4B, 0x50};
@@ -16,8 +32,28 @@ static uint8_t payload_sent[ESPNOW_DATA_BYTES - 1U];
 
 static ESPNOW_LINK_MSG_T mock_msg;
 static bool read_callback_called = false;
+static WT20_MSG_T pool_test_msg;
+static uint16_t mock_seq;
 
-void setUp(void) { } 
+/* command of a frame, from its header */
+#define FRAME_COMMAND(frame) ((frame).data[1])
+
+/* puts a frame from peer_mac1 in mock_msg, with the next sequence number */
+static void set_mock_msg(WT20_COMMAND_T command, const void* payload, uint16_t length)
+{
+    WT20_HDR_T hdr = {.type = (uint8_t)command, .seq = mock_seq++};
+
+    memcpy(mock_msg.info.src_mac, peer_mac1, 6U);
+    memcpy(&mock_msg.data[WT20_HDR_BYTES], payload, length);
+    mock_msg.info.data_len = wt20_header_build(&hdr, mock_msg.data, length);
+}
+
+void setUp(void)
+{
+    /* wt20_init() reads the device mac and the clock to set up the relay */
+    espnow_link_get_device_mac_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    timing_get_us_IgnoreAndReturn(0U);
+}
 
 void tearDown(void)
 {
@@ -37,7 +73,7 @@ ESPNOW_LINK_ERR_T espnow_link_write_callback(const uint8_t* peer_mac,
 
     if (data_length > 0U)
     {
-        command_sent = data[0]; /* command in first byte of data */
+        command_sent = data[1]; /* command in header's type byte */
         ret = ESPNOW_LINK_ERR_NONE;
     }
     else if (data_length > 1U)
@@ -55,6 +91,35 @@ ESPNOW_LINK_ERR_T espnow_link_read_callback(const ESPNOW_LINK_MSG_T* msg_buffer,
 
     /* copy mock msg into buffer */
     memcpy(msg_buffer, &mock_msg, sizeof(mock_msg));
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+/* returns mock msg for the first mock_msgs_pending calls, then reports empty */
+static uint32_t mock_msgs_pending;
+
+ESPNOW_LINK_ERR_T espnow_link_read_burst_callback(const ESPNOW_LINK_MSG_T* msg_buffer, int cmock_num_calls)
+{
+    if (mock_msgs_pending == 0U)
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    mock_msgs_pending--;
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, NULL, 0U);
+    memcpy(msg_buffer, &mock_msg, sizeof(mock_msg));
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+static uint32_t handler_calls;
+static void* handler_context;
+
+static void count_messages_handler(const WT20_MSG_T* msg, void* context)
+{
+    handler_calls++;
+    handler_context = context;
+    TEST_ASSERT_EQUAL_INT(WT20_COMMAND_TOGGLE_LED, msg->command);
 }
 
 ESPNOW_LINK_ERR_T espnow_link_get_device_mac_callback(const uint8_t* buffer, int cmock_num_calls)
@@ -73,14 +138,15 @@ void test_wt20_write_toggle_led_command(void)
 
     /* we should expect espnow_link_write to be called */
     espnow_link_write_Stub(espnow_link_write_callback);
+    timing_get_ms_IgnoreAndReturn(0U);
 
     err = wt20_write(peer_mac1, WT20_COMMAND_TOGGLE_LED, NULL, 0U);
 
-    /* per protocol definition, wt20 should have written 1 byte to peer containing command */
+    /* per protocol definition, wt20 should have written just a header to peer containing command */
     TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, err);
     TEST_ASSERT_EQUAL_INT(0U, memcmp(mac_src, peer_mac1, 6U));
     TEST_ASSERT_EQUAL_INT(WT20_COMMAND_TOGGLE_LED, command_sent);
-    TEST_ASSERT_EQUAL_INT(1U, data_length_sent);
+    TEST_ASSERT_EQUAL_INT(WT20_HDR_BYTES, data_length_sent);
 
     espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
     wt20_deinit();
@@ -144,9 +210,7 @@ void test_wt20_protocol_function_led_toggle_function(void)
     WT20_MSG_T ret_msg;
 
     /* set up message to be sent */
-    mock_msg.recv_info.des_addr = mock_mac;
-    mock_msg.recv_info.src_addr = peer_mac1;
-    mock_msg.data[0] = WT20_COMMAND_TOGGLE_LED;
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, NULL, 0U);
 
     /* init first */
     espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
@@ -175,11 +239,10 @@ void test_wt20_protocol_function_write_str(void)
 
     const char* str = "Example Text";
 
+    memset(&ret_msg, 0xA5, sizeof(ret_msg));
+
     /* set up message to be sent */
-    mock_msg.recv_info.des_addr = mock_mac;
-    mock_msg.recv_info.src_addr = peer_mac1;
-    mock_msg.data[0] = WT20_COMMAND_SEND_PAYLOAD;
-    memcpy(&(mock_msg.data[1]), str, strlen(str));
+    set_mock_msg(WT20_COMMAND_SEND_PAYLOAD, str, strlen(str));
 
     /* init first */
     espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
@@ -196,6 +259,10 @@ void test_wt20_protocol_function_write_str(void)
     TEST_ASSERT_EQUAL_INT(0U, memcmp(ret_msg.src_mac, peer_mac1, 6U));
     TEST_ASSERT_EQUAL_INT(ret_msg.command, WT20_COMMAND_SEND_PAYLOAD);
     TEST_ASSERT_EQUAL_INT(0U, memcmp(ret_msg.payload, str,  strlen(str)));
+    TEST_ASSERT_EQUAL_INT(strlen(str), ret_msg.length);
+
+    /* only the string went on air, the rest of the payload is zeroed on the receiving side */
+    TEST_ASSERT_EACH_EQUAL_UINT8(0U, &ret_msg.payload[strlen(str)], WT20_PAYLOAD_BYTES - strlen(str));
 
     /* deinit for next test */
     espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
@@ -218,3 +285,745 @@ void test_wt20_add_contact(void)
     TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_add_contact(peer_mac1));
 }
 
+
+void test_wt20_receive_waits_for_message(void)
+{
+    WT20_ERR_T err;
+    WT20_MSG_T ret_msg;
+
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, NULL, 0U);
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* nothing pending, so wt20_receive should sleep on the link instead of returning */
+    espnow_link_messages_available_ExpectAndReturn(false);
+    espnow_link_wait_for_messages_ExpectAndReturn(100U, true);
+    espnow_link_read_Stub(espnow_link_read_callback);
+
+    err = wt20_receive(&ret_msg, 100U);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, err);
+    TEST_ASSERT_EQUAL_INT(WT20_COMMAND_TOGGLE_LED, ret_msg.command);
+    TEST_ASSERT_EQUAL_MEMORY(peer_mac1, ret_msg.src_mac, 6U);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_receive_timeout(void)
+{
+    WT20_MSG_T ret_msg;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    espnow_link_messages_available_ExpectAndReturn(false);
+    espnow_link_wait_for_messages_ExpectAndReturn(5U, false);
+
+    TEST_ASSERT_EQUAL_INT(WT20_NO_DATA_AVAILABLE, wt20_receive(&ret_msg, 5U));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_receive_not_initialized(void)
+{
+    TEST_ASSERT_EQUAL_INT(WT20_NOT_INITIALIZED, wt20_receive(NULL, 0U));
+    TEST_ASSERT_EQUAL_INT(WT20_NOT_INITIALIZED, wt20_receive_all(count_messages_handler, NULL, 0U, NULL));
+}
+
+void test_wt20_receive_all_drains_burst(void)
+{
+    int context;
+    uint32_t processed = 0U;
+
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, NULL, 0U);
+    mock_msgs_pending = 5U;
+    handler_calls = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* one wakeup should hand every pending message to the handler */
+    espnow_link_messages_available_ExpectAndReturn(false);
+    espnow_link_wait_for_messages_ExpectAndReturn(WT20_WAIT_FOREVER, true);
+    espnow_link_read_Stub(espnow_link_read_burst_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_receive_all(count_messages_handler, &context, WT20_WAIT_FOREVER, &processed));
+    TEST_ASSERT_EQUAL_INT(5U, processed);
+    TEST_ASSERT_EQUAL_INT(5U, handler_calls);
+    TEST_ASSERT_EQUAL_PTR(&context, handler_context);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* frame buffers come from the "wt20_frame" pool and all go back once a call returns */
+static MEM_POOL_T* find_pool(const char* name)
+{
+    MEM_POOL_T* pool;
+
+    for (pool = mem_pool_first(); pool != NULL; pool = mem_pool_next(pool))
+    {
+        if (strcmp(pool->name, name) == 0)
+        {
+            return pool;
+        }
+    }
+
+    return NULL;
+}
+
+void test_wt20_frame_buffers_come_from_pool(void)
+{
+    void* taken[WT20_FRAME_POOL_BLOCKS];
+    MEM_POOL_STATS_T stats;
+    MEM_POOL_T* pool;
+    uint32_t processed = 0U;
+    uint32_t i;
+
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, NULL, 0U);
+    mock_msgs_pending = 3U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+    pool = find_pool("wt20_frame");
+    TEST_ASSERT_NOT_NULL(pool);
+
+    espnow_link_messages_available_ExpectAndReturn(true);
+    espnow_link_read_Stub(espnow_link_read_burst_callback);
+    espnow_link_write_Stub(espnow_link_write_callback);
+    timing_get_ms_IgnoreAndReturn(0U);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_receive_all(count_messages_handler, NULL, 0U, &processed));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_write(peer_mac1, WT20_COMMAND_SEND_PAYLOAD, (const uint8_t*)"hi", 3U));
+
+    mem_pool_get_stats(pool, &stats);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.in_use);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.high_water);
+
+    /* with every block taken nothing is sent or read, and the shortfall is counted */
+    for (i = 0U; i < WT20_FRAME_POOL_BLOCKS; i++)
+    {
+        taken[i] = mem_pool_alloc(pool);
+    }
+
+    espnow_link_write_called = false;
+    TEST_ASSERT_EQUAL_INT(WT20_NO_BUFFER, wt20_write(peer_mac1, WT20_COMMAND_TOGGLE_LED, NULL, 0U));
+    TEST_ASSERT_FALSE(espnow_link_write_called);
+
+    espnow_link_messages_available_ExpectAndReturn(true);
+    TEST_ASSERT_EQUAL_INT(WT20_NO_BUFFER, wt20_receive(&pool_test_msg, 0U));
+
+    mem_pool_get_stats(pool, &stats);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.alloc_failures);
+
+    for (i = 0U; i < WT20_FRAME_POOL_BLOCKS; i++)
+    {
+        mem_pool_free(pool, taken[i]);
+    }
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_receive_all_timeout(void)
+{
+    uint32_t processed = 1U;
+
+    handler_calls = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    espnow_link_messages_available_ExpectAndReturn(false);
+    espnow_link_wait_for_messages_ExpectAndReturn(10U, false);
+
+    TEST_ASSERT_EQUAL_INT(WT20_NO_DATA_AVAILABLE, wt20_receive_all(count_messages_handler, NULL, 10U, &processed));
+    TEST_ASSERT_EQUAL_INT(0U, processed);
+    TEST_ASSERT_EQUAL_INT(0U, handler_calls);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* frames captured from espnow_link_write_async, fed back in through espnow_link_read */
+#define MAX_CAPTURED_FRAMES (80U)
+static ESPNOW_LINK_MSG_T captured_frames[MAX_CAPTURED_FRAMES];
+static uint32_t captured_count;
+static uint32_t replay_index;
+static uint8_t big_message[4000U];
+
+/* the capture completes each frame at once, failing the one numbered fail_frame, and reports
+   the pipeline full for the next busy_writes writes */
+static uint32_t fail_frame;
+static uint32_t busy_writes;
+
+ESPNOW_LINK_ERR_T espnow_link_write_async_capture_callback(const uint8_t* peer_mac,
+                                                           const uint8_t* data,
+                                                           uint16_t data_length,
+                                                           ESPNOW_LINK_TX_DONE_CB_T callback,
+                                                           void* context,
+                                                           ESPNOW_LINK_TX_HANDLE_T* handle,
+                                                           int cmock_num_calls)
+{
+    TEST_ASSERT(captured_count < MAX_CAPTURED_FRAMES);
+    TEST_ASSERT_EQUAL_MEMORY(peer_mac1, peer_mac, 6U);
+
+    if (busy_writes > 0U)
+    {
+        busy_writes--;
+        *handle = ESPNOW_LINK_TX_INVALID_HANDLE;
+        return ESPNOW_LINK_ERR_BUSY;
+    }
+
+    memcpy(captured_frames[captured_count].info.src_mac, mock_mac, 6U);
+    captured_frames[captured_count].info.data_len = data_length;
+    memcpy(captured_frames[captured_count].data, data, data_length);
+    captured_count++;
+
+    *handle = captured_count;
+
+    if (callback != NULL)
+    {
+        callback(*handle, captured_count != fail_frame, context);
+    }
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+ESPNOW_LINK_ERR_T espnow_link_read_replay_callback(const ESPNOW_LINK_MSG_T* msg_buffer, int cmock_num_calls)
+{
+    if (replay_index >= captured_count)
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    memcpy(msg_buffer, &captured_frames[replay_index++], sizeof(ESPNOW_LINK_MSG_T));
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+static uint32_t reassembled_length;
+static bool reassembled_match;
+
+static void message_callback(const uint8_t* src_mac, const uint8_t* message, uint32_t length, void* context)
+{
+    reassembled_length = length;
+    reassembled_match = (memcmp(message, big_message, length) == 0) && (memcmp(src_mac, mock_mac, 6U) == 0);
+}
+
+void test_wt20_send_message_fragments_and_reassembles(void)
+{
+    WT20_MSG_T ret_msg;
+    uint32_t i;
+
+    for (i = 0U; i < sizeof(big_message); i++)
+    {
+        big_message[i] = (uint8_t)(i ^ (i >> 8U));
+    }
+    captured_count = 0U;
+    replay_index = 0U;
+    reassembled_length = 0U;
+    reassembled_match = false;
+    fail_frame = 0U;
+    busy_writes = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* every fragment is handed to the link without waiting for its own ack */
+    espnow_link_write_async_Stub(espnow_link_write_async_capture_callback);
+    espnow_link_wait_tx_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    timing_get_ms_IgnoreAndReturn(0U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_send_message(peer_mac1, big_message, sizeof(big_message)));
+    TEST_ASSERT_EQUAL_INT(wt20_frag_count(sizeof(big_message)), captured_count);
+    for (i = 0U; i < captured_count; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_COMMAND_FRAGMENT, FRAME_COMMAND(captured_frames[i]));
+    }
+
+    /* feed frames back in, fragments should be consumed and reassembled */
+    wt20_set_message_callback(message_callback, NULL);
+    espnow_link_messages_available_ExpectAndReturn(true);
+    espnow_link_read_Stub(espnow_link_read_replay_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_NO_DATA_AVAILABLE, wt20_protocol_function(&ret_msg));
+    TEST_ASSERT_EQUAL_INT(sizeof(big_message), reassembled_length);
+    TEST_ASSERT(reassembled_match);
+
+    wt20_set_message_callback(NULL, NULL);
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_send_message_failed_fragment(void)
+{
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* one fragment not acked, the rest still go out */
+    captured_count = 0U;
+    fail_frame = 2U;
+    busy_writes = 0U;
+    espnow_link_write_async_Stub(espnow_link_write_async_capture_callback);
+    espnow_link_wait_tx_IgnoreAndReturn(ESPNOW_LINK_ERR);
+    timing_get_ms_IgnoreAndReturn(0U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_SEND_FAILURE, wt20_send_message(peer_mac1, big_message, 1000U));
+    TEST_ASSERT_EQUAL_INT(wt20_frag_count(1000U), captured_count);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+static uint32_t mock_now_ms;
+
+static uint32_t timing_get_ms_clock_callback(int cmock_num_calls)
+{
+    return mock_now_ms;
+}
+
+/* the link's pipeline stays full the whole wait, time moves on with each wait */
+static ESPNOW_LINK_ERR_T espnow_link_wait_tx_slot_timeout_callback(uint32_t timeout_ms, int cmock_num_calls)
+{
+    mock_now_ms += timeout_ms;
+
+    return ESPNOW_LINK_ERR_TIMEOUT;
+}
+
+void test_wt20_send_message_waits_out_a_full_pipeline(void)
+{
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* other writers fill the pipeline for a moment, the message still goes out whole */
+    captured_count = 0U;
+    fail_frame = 0U;
+    busy_writes = 3U;
+    espnow_link_write_async_Stub(espnow_link_write_async_capture_callback);
+    espnow_link_wait_tx_slot_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    espnow_link_wait_tx_IgnoreAndReturn(ESPNOW_LINK_ERR);
+    timing_get_ms_IgnoreAndReturn(0U);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_send_message(peer_mac1, big_message, 1000U));
+    TEST_ASSERT_EQUAL_INT(wt20_frag_count(1000U), captured_count);
+
+    /* full for good, it gives up, and doesn't send the rest */
+    captured_count = 0U;
+    busy_writes = 1000U;
+    mock_now_ms = 0U;
+    timing_get_ms_Stub(timing_get_ms_clock_callback);
+    espnow_link_wait_tx_slot_Stub(espnow_link_wait_tx_slot_timeout_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_SEND_FAILURE, wt20_send_message(peer_mac1, big_message, 1000U));
+    TEST_ASSERT_EQUAL_INT(0U, captured_count);
+    TEST_ASSERT(mock_now_ms >= (2U * ESPNOW_LINK_PS_INTERVAL_MS));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_send_message_too_long(void)
+{
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    TEST_ASSERT_EQUAL_INT(WT20_MESSAGE_TOO_LONG, wt20_send_message(peer_mac1, big_message, WT20_FRAG_MAX_MESSAGE_BYTES + 1U));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* loopback for reliable transfers. This node plays both sender (mock_mac) and receiver (peer_mac1),
+   so each frame shows up as coming from the other one. One frame can be dropped to force a retransmit */
+static uint32_t drop_frame_number;
+static uint32_t frames_written;
+static uint32_t data_frames_delivered;
+static bool transfer_done;
+static bool transfer_success;
+
+ESPNOW_LINK_ERR_T espnow_link_write_async_loopback_callback(const uint8_t* peer_mac,
+                                                            const uint8_t* data,
+                                                            uint16_t data_length,
+                                                            ESPNOW_LINK_TX_DONE_CB_T callback,
+                                                            void* context,
+                                                            ESPNOW_LINK_TX_HANDLE_T* handle,
+                                                            int cmock_num_calls)
+{
+    frames_written++;
+    *handle = frames_written;
+
+    if (frames_written == drop_frame_number)
+    {
+        return ESPNOW_LINK_ERR_NONE;
+    }
+
+    TEST_ASSERT(captured_count < MAX_CAPTURED_FRAMES);
+    memcpy(captured_frames[captured_count].info.src_mac, (memcmp(peer_mac, peer_mac1, 6U) == 0) ? mock_mac : peer_mac1, 6U);
+    captured_frames[captured_count].info.data_len = data_length;
+    memcpy(captured_frames[captured_count].data, data, data_length);
+    captured_count++;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+bool espnow_link_messages_available_replay_callback(int cmock_num_calls)
+{
+    return replay_index < captured_count;
+}
+
+static void transfer_done_callback(bool success, void* context)
+{
+    transfer_done = true;
+    transfer_success = success;
+}
+
+void test_wt20_send_message_reliable_resends_only_missing(void)
+{
+    uint16_t count = wt20_frag_count(sizeof(big_message));
+    uint32_t i;
+
+    for (i = 0U; i < sizeof(big_message); i++)
+    {
+        big_message[i] = (uint8_t)(i * 3U);
+    }
+    captured_count = 0U;
+    replay_index = 0U;
+    frames_written = 0U;
+    drop_frame_number = 3U;
+    reassembled_length = 0U;
+    transfer_done = false;
+    handler_calls = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+    wt20_set_message_callback(message_callback, NULL);
+
+    timing_get_ms_IgnoreAndReturn(0U);
+    espnow_link_wake_reader_Ignore();
+    espnow_link_tx_pending_IgnoreAndReturn(0U);
+    espnow_link_wait_for_messages_IgnoreAndReturn(false);
+    espnow_link_write_async_Stub(espnow_link_write_async_loopback_callback);
+    espnow_link_messages_available_Stub(espnow_link_messages_available_replay_callback);
+    espnow_link_read_Stub(espnow_link_read_replay_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE,
+                          wt20_send_message_reliable(peer_mac1, big_message, sizeof(big_message), transfer_done_callback, NULL));
+    TEST_ASSERT_EQUAL_INT(WT20_TRANSFER_IN_PROGRESS,
+                          wt20_send_message_reliable(peer_mac1, big_message, sizeof(big_message), transfer_done_callback, NULL));
+
+    for (i = 0U; (i < 10U) && !transfer_done; i++)
+    {
+        wt20_receive_all(count_messages_handler, NULL, 0U, NULL);
+    }
+
+    TEST_ASSERT(transfer_done);
+    TEST_ASSERT(transfer_success);
+    TEST_ASSERT_EQUAL_INT(sizeof(big_message), reassembled_length);
+    TEST_ASSERT(reassembled_match);
+
+    /* the dropped fragment is the only one sent twice */
+    data_frames_delivered = 0U;
+    for (i = 0U; i < captured_count; i++)
+    {
+        if (FRAME_COMMAND(captured_frames[i]) != WT20_COMMAND_BULK_ACK)
+        {
+            data_frames_delivered++;
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(count, data_frames_delivered);
+    TEST_ASSERT_EQUAL_INT(count + 1U, frames_written - (captured_count - data_frames_delivered));
+    TEST_ASSERT_EQUAL_INT(0U, handler_calls);
+
+    wt20_set_message_callback(NULL, NULL);
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* live frames sent through espnow_link_write, captured so they can be read back */
+static uint32_t stream_frames_seen;
+static uint32_t stream_frames_recovered;
+static uint32_t stream_last_seq;
+
+ESPNOW_LINK_ERR_T espnow_link_write_capture_callback(const uint8_t* peer_mac,
+                                                     const uint8_t* data,
+                                                     uint16_t data_length,
+                                                     int cmock_num_calls)
+{
+    TEST_ASSERT(captured_count < MAX_CAPTURED_FRAMES);
+
+    memcpy(captured_frames[captured_count].info.src_mac, mock_mac, 6U);
+    captured_frames[captured_count].info.data_len = data_length;
+    memcpy(captured_frames[captured_count].data, data, data_length);
+    captured_count++;
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+static void stream_callback(uint32_t seq, const uint8_t* frame, uint16_t length, bool recovered, void* context)
+{
+    stream_frames_seen++;
+    stream_frames_recovered += recovered ? 1U : 0U;
+    stream_last_seq = seq;
+
+    TEST_ASSERT_EQUAL_INT(40U, length);
+    TEST_ASSERT_EACH_EQUAL_UINT8((uint8_t)seq, frame, length);
+}
+
+void test_wt20_write_stream_rebuilds_lost_frame(void)
+{
+    WT20_FEC_CONFIG_T config = {.k = 4U, .m = 1U, .frame_bytes = 40U};
+    WT20_MSG_T ret_msg;
+    uint8_t frame[40U];
+    uint32_t i;
+
+    captured_count = 0U;
+    replay_index = 0U;
+    stream_frames_seen = 0U;
+    stream_frames_recovered = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_set_stream_fec(&config));
+    wt20_set_stream_callback(stream_callback, NULL);
+
+    espnow_link_write_Stub(espnow_link_write_capture_callback);
+    timing_get_ms_IgnoreAndReturn(0U);
+
+    for (i = 0U; i < 4U; i++)
+    {
+        memset(frame, (int)i, sizeof(frame));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_write_stream(peer_mac1, frame, sizeof(frame)));
+    }
+
+    /* four frames and their parity */
+    TEST_ASSERT_EQUAL_INT(5U, captured_count);
+    TEST_ASSERT_EQUAL_INT(WT20_COMMAND_STREAM, FRAME_COMMAND(captured_frames[4]));
+
+    /* second frame lost in the air */
+    memmove(&captured_frames[1], &captured_frames[2], 3U * sizeof(captured_frames[0]));
+    captured_count--;
+
+    espnow_link_messages_available_ExpectAndReturn(true);
+    espnow_link_read_Stub(espnow_link_read_replay_callback);
+    TEST_ASSERT_EQUAL_INT(WT20_NO_DATA_AVAILABLE, wt20_protocol_function(&ret_msg));
+
+    TEST_ASSERT_EQUAL_INT(4U, stream_frames_seen);
+    TEST_ASSERT_EQUAL_INT(1U, stream_frames_recovered);
+    TEST_ASSERT_EQUAL_INT(1U, stream_last_seq);
+
+    wt20_set_stream_callback(NULL, NULL);
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* counts live frames written, and fails them while writes_fail is set */
+static bool writes_fail;
+static uint32_t writes_seen;
+
+ESPNOW_LINK_ERR_T espnow_link_write_failing_callback(const uint8_t* peer_mac,
+                                                     const uint8_t* data,
+                                                     uint16_t data_length,
+                                                     int cmock_num_calls)
+{
+    writes_seen++;
+
+    return writes_fail ? ESPNOW_LINK_ERR : ESPNOW_LINK_ERR_NONE;
+}
+
+void test_wt20_write_stream_failures_drive_voice_mode_down(void)
+{
+    WT20_FEC_CONFIG_T config = {.k = 4U, .m = 1U, .frame_bytes = 40U};
+    WT20_VRATE_STATS_T stats;
+    ADPCM_MODE_T mode = ADPCM_MODES;
+    uint8_t frame[40U] = {0};
+    uint32_t i;
+
+    writes_fail = false;
+    writes_seen = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_set_stream_fec(&config));
+
+    espnow_link_write_Stub(espnow_link_write_failing_callback);
+    timing_get_ms_IgnoreAndReturn(0U);
+
+    for (i = 0U; i < 3U; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_next_voice_mode(0U, &mode));
+        TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_write_stream(peer_mac1, frame, sizeof(frame)));
+    }
+
+    /* the frame completing the group isn't acked, its parity still goes out */
+    writes_fail = true;
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_next_voice_mode(0U, &mode));
+    TEST_ASSERT_EQUAL_INT(ADPCM_MODE_16K, mode);
+    TEST_ASSERT_EQUAL_INT(WT20_SEND_FAILURE, wt20_write_stream(peer_mac1, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_UINT32(5U, writes_seen);
+
+    /* one failure is shrugged off, a second close behind it drops a mode */
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_next_voice_mode(0U, &mode));
+    TEST_ASSERT_EQUAL_INT(ADPCM_MODE_16K, mode);
+    TEST_ASSERT_EQUAL_INT(WT20_SEND_FAILURE, wt20_write_stream(peer_mac1, frame, sizeof(frame)));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_next_voice_mode(0U, &mode));
+    TEST_ASSERT_EQUAL_INT(ADPCM_MODE_8K, mode);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_get_voice_rate_stats(&stats, NULL));
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.downs);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.reports);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+/* replays mock_msg twice, then a copy with a flipped payload bit, then runs dry */
+ESPNOW_LINK_ERR_T espnow_link_read_damaged_callback(const ESPNOW_LINK_MSG_T* msg_buffer, int cmock_num_calls)
+{
+    ESPNOW_LINK_MSG_T* msg = (ESPNOW_LINK_MSG_T*)msg_buffer;
+
+    if (cmock_num_calls > 2)
+    {
+        return ESPNOW_LINK_ERR;
+    }
+
+    memcpy(msg, &mock_msg, sizeof(mock_msg));
+
+    if (cmock_num_calls == 2)
+    {
+        msg->data[WT20_HDR_BYTES] ^= 0x10U;
+    }
+
+    return ESPNOW_LINK_ERR_NONE;
+}
+
+void test_wt20_receive_drops_duplicate_and_damaged_frames(void)
+{
+    WT20_RX_STATS_T stats;
+    uint32_t processed = 0U;
+
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, "x", 1U);
+    handler_calls = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    espnow_link_messages_available_ExpectAndReturn(true);
+    espnow_link_read_Stub(espnow_link_read_damaged_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_receive_all(count_messages_handler, NULL, 0U, &processed));
+    TEST_ASSERT_EQUAL_INT(1U, processed);
+    TEST_ASSERT_EQUAL_INT(1U, handler_calls);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_get_rx_stats(&stats));
+    TEST_ASSERT_EQUAL_UINT32(3U, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.crc_errors);
+    TEST_ASSERT_EQUAL_UINT32(0U, stats.malformed);
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+static WT20_PEER_ID_T handler_peer_id;
+
+static void peer_id_handler(const WT20_MSG_T* msg, void* context)
+{
+    handler_calls++;
+    handler_peer_id = msg->peer_id;
+}
+
+void test_wt20_added_peer_keeps_own_state(void)
+{
+    WT20_RX_STATS_T rx_stats;
+    WT20_PEER_ID_T id = WT20_PEER_ID_NONE;
+    WT20_PEER_T peer;
+    uint32_t processed = 0U;
+
+    set_mock_msg(WT20_COMMAND_TOGGLE_LED, "x", 1U);
+    mock_msg.info.rssi = -61;
+    handler_calls = 0U;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* adding again doesn't register with esp now twice */
+    espnow_link_register_peer_ExpectAndReturn(peer_mac1, ESPNOW_LINK_ERR_NONE);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_add_peer(peer_mac1, &id));
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_add_contact(peer_mac1));
+    TEST_ASSERT_EQUAL_UINT8(1U, id);
+    TEST_ASSERT_EQUAL_UINT8(id, wt20_find_peer(peer_mac1));
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_find_peer(mock_mac));
+
+    timing_get_ms_IgnoreAndReturn(5000U);
+    espnow_link_messages_available_ExpectAndReturn(true);
+    espnow_link_read_Stub(espnow_link_read_damaged_callback);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_receive_all(peer_id_handler, NULL, 0U, &processed));
+    TEST_ASSERT_EQUAL_INT(1U, handler_calls);
+    TEST_ASSERT_EQUAL_UINT8(id, handler_peer_id);
+
+    espnow_link_write_Stub(espnow_link_write_callback);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_write_peer(id, WT20_COMMAND_TOGGLE_LED, NULL, 0U));
+    TEST_ASSERT_EQUAL_MEMORY(peer_mac1, mac_src, 6U);
+
+    /* the damaged copy fails its crc before the peer is looked up, so isn't counted */
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_get_peer(id, &peer));
+    TEST_ASSERT_EQUAL_UINT32(2U, peer.stats.frames_rx);
+    TEST_ASSERT_EQUAL_UINT32(1U, peer.stats.duplicates);
+    TEST_ASSERT_EQUAL_UINT32(1U, peer.stats.frames_tx);
+    TEST_ASSERT_EQUAL_UINT32(0U, peer.stats.tx_failures);
+    TEST_ASSERT_EQUAL_UINT32(5000U, peer.stats.last_heard_ms);
+    TEST_ASSERT_EQUAL_INT8(-61, peer.stats.last_rssi);
+
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_get_rx_stats(&rx_stats));
+    TEST_ASSERT_EQUAL_UINT32(1U, rx_stats.duplicates);
+
+    /* esp now's slot goes with it */
+    espnow_link_unregister_peer_ExpectAndReturn(peer_mac1, ESPNOW_LINK_ERR_NONE);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_remove_peer(id));
+    TEST_ASSERT_EQUAL_INT(WT20_UNKNOWN_PEER, wt20_get_peer(id, &peer));
+    TEST_ASSERT_EQUAL_INT(WT20_UNKNOWN_PEER, wt20_write_peer(id, WT20_COMMAND_TOGGLE_LED, NULL, 0U));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_add_peer_esp_now_refuses(void)
+{
+    WT20_PEER_ID_T id = WT20_PEER_ID_NONE;
+
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    /* esp now's list is full, the peer isn't kept */
+    espnow_link_register_peer_ExpectAndReturn(peer_mac1, ESPNOW_LINK_ERR);
+    TEST_ASSERT_EQUAL_INT(WT20_PEER_TABLE_FULL, wt20_add_peer(peer_mac1, &id));
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, id);
+    TEST_ASSERT_EQUAL_UINT8(WT20_PEER_ID_NONE, wt20_find_peer(peer_mac1));
+
+    /* once there is room it goes in, at the id the failed add would have had */
+    espnow_link_register_peer_ExpectAndReturn(peer_mac1, ESPNOW_LINK_ERR_NONE);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_add_peer(peer_mac1, &id));
+    TEST_ASSERT_EQUAL_UINT8(1U, id);
+
+    espnow_link_unregister_peer_ExpectAndReturn(peer_mac1, ESPNOW_LINK_ERR_NONE);
+    TEST_ASSERT_EQUAL_INT(WT20_ERR_NONE, wt20_remove_peer(id));
+    TEST_ASSERT_EQUAL_INT(WT20_UNKNOWN_PEER, wt20_remove_peer(id));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
+
+void test_wt20_write_rejects_payload_past_one_frame(void)
+{
+    espnow_link_init_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_init();
+
+    TEST_ASSERT_EQUAL_INT(WT20_MESSAGE_TOO_LONG,
+                          wt20_write(peer_mac1, WT20_COMMAND_SEND_PAYLOAD, big_message, WT20_PAYLOAD_BYTES + 1U));
+
+    espnow_link_close_IgnoreAndReturn(ESPNOW_LINK_ERR_NONE);
+    wt20_deinit();
+}
@@ -0,0 +1,158 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_relay.h"
+
+static const uint8_t origin[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x03U};
+static const uint8_t dest[6U] = {0x40U, 0x4CU, 0xCAU, 0x01U, 0x02U, 0x09U};
+
+static WT20_RELAY_T relay;
+
+/* payload of a relayed frame from origin carrying 20 bytes of seq */
+static uint16_t build(uint16_t seq, uint8_t hops, uint8_t* payload)
+{
+    uint8_t data[20U];
+    WT20_RELAY_FRAME_T frame = {.seq = seq, .hops = hops, .command = 7U, .data = data, .length = sizeof(data)};
+
+    memset(data, (int)seq, sizeof(data));
+    memcpy(frame.origin, origin, sizeof(origin));
+    memcpy(frame.dest, dest, sizeof(dest));
+
+    return wt20_relay_build(&frame, payload);
+}
+
+void setUp(void)
+{
+    wt20_relay_init(&relay, 0x12345678U);
+}
+
+void tearDown(void) { }
+
+void test_wt20_relay_header_round_trips(void)
+{
+    uint8_t payload[WT20_PAYLOAD_BYTES];
+    WT20_RELAY_FRAME_T frame;
+    uint16_t length = build(0xA55AU, 3U, payload);
+
+    TEST_ASSERT_EQUAL_UINT16(WT20_RELAY_HDR_BYTES + 20U, length);
+
+    /* seq low byte first, like every other field on the wire */
+    TEST_ASSERT_EQUAL_HEX8(0x5AU, payload[12]);
+    TEST_ASSERT_EQUAL_HEX8(0xA5U, payload[13]);
+
+    TEST_ASSERT(wt20_relay_parse(payload, length, &frame));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(origin, frame.origin, 6U));
+    TEST_ASSERT_EQUAL_INT(0, memcmp(dest, frame.dest, 6U));
+    TEST_ASSERT_EQUAL_HEX16(0xA55AU, frame.seq);
+    TEST_ASSERT_EQUAL_UINT8(3U, frame.hops);
+    TEST_ASSERT_EQUAL_UINT8(7U, frame.command);
+    TEST_ASSERT_EQUAL_UINT16(20U, frame.length);
+    TEST_ASSERT_EQUAL_HEX8(0x5AU, frame.data[19]);
+
+    TEST_ASSERT_FALSE(wt20_relay_parse(payload, WT20_RELAY_HDR_BYTES - 1U, &frame));
+    (void)build(1U, 0U, payload);
+    TEST_ASSERT_FALSE(wt20_relay_parse(payload, length, &frame));
+
+    frame.length = WT20_RELAY_MAX_PAYLOAD_BYTES + 1U;
+    TEST_ASSERT_EQUAL_UINT16(0U, wt20_relay_build(&frame, payload));
+}
+
+void test_wt20_relay_cache_drops_copies_and_forgets_old_frames(void)
+{
+    uint8_t other[6U];
+    uint32_t seq;
+
+    TEST_ASSERT_FALSE(wt20_relay_seen(&relay, origin, 100U));
+    TEST_ASSERT(wt20_relay_seen(&relay, origin, 100U));
+    TEST_ASSERT_FALSE(wt20_relay_seen(&relay, dest, 100U));
+
+    /* the frames just before this one are all still known, from one origin or several */
+    for (seq = 0U; seq < 1000U; seq++)
+    {
+        memcpy(other, origin, sizeof(other));
+        other[5] = (uint8_t)(seq % 3U);
+        TEST_ASSERT_FALSE(wt20_relay_seen(&relay, other, (uint16_t)(1000U + seq)));
+
+        if (seq >= 8U)
+        {
+            other[5] = (uint8_t)((seq - 8U) % 3U);
+            TEST_ASSERT(wt20_relay_seen(&relay, other, (uint16_t)(1000U + seq - 8U)));
+        }
+    }
+
+    /* a fixed size cache, so long gone frames are forgotten */
+    TEST_ASSERT_FALSE(wt20_relay_seen(&relay, origin, 100U));
+}
+
+void test_wt20_relay_forwards_after_backoff_with_one_hop_less(void)
+{
+    uint8_t payload[WT20_PAYLOAD_BYTES];
+    uint8_t forward[WT20_PAYLOAD_BYTES];
+    WT20_RELAY_FRAME_T frame;
+    uint32_t due_us = 0U;
+    uint16_t length = build(5U, 2U, payload);
+
+    TEST_ASSERT_FALSE(wt20_relay_pending(&relay, &due_us));
+    TEST_ASSERT(wt20_relay_queue(&relay, payload, length, 1000U));
+    TEST_ASSERT(wt20_relay_pending(&relay, &due_us));
+    TEST_ASSERT((due_us >= 1000U) && (due_us <= (1000U + WT20_RELAY_JITTER_US)));
+
+    if (due_us > 1000U)
+    {
+        TEST_ASSERT_EQUAL_UINT16(0U, wt20_relay_next(&relay, due_us - 1U, forward));
+    }
+
+    TEST_ASSERT_EQUAL_UINT16(length, wt20_relay_next(&relay, due_us, forward));
+    TEST_ASSERT_FALSE(wt20_relay_pending(&relay, NULL));
+    TEST_ASSERT(wt20_relay_parse(forward, length, &frame));
+    TEST_ASSERT_EQUAL_UINT8(1U, frame.hops);
+    TEST_ASSERT_EQUAL_UINT16(5U, frame.seq);
+
+    /* that copy was on its last hop */
+    TEST_ASSERT_FALSE(wt20_relay_queue(&relay, forward, length, 2000U));
+}
+
+void test_wt20_relay_backoffs_spread_and_queue_is_bounded(void)
+{
+    uint8_t payload[WT20_PAYLOAD_BYTES];
+    uint8_t forward[WT20_PAYLOAD_BYTES];
+    uint32_t first_us = 0U;
+    uint32_t due_us;
+    uint32_t min_us = UINT32_MAX;
+    uint32_t max_us = 0U;
+    uint32_t i;
+    uint16_t length = build(9U, 3U, payload);
+
+    for (i = 0U; i < 200U; i++)
+    {
+        TEST_ASSERT(wt20_relay_queue(&relay, payload, length, 0U));
+        TEST_ASSERT(wt20_relay_pending(&relay, &due_us));
+        TEST_ASSERT(due_us <= WT20_RELAY_JITTER_US);
+        min_us = (due_us < min_us) ? due_us : min_us;
+        max_us = (due_us > max_us) ? due_us : max_us;
+        TEST_ASSERT_EQUAL_UINT16(length, wt20_relay_next(&relay, WT20_RELAY_JITTER_US, forward));
+    }
+
+    /* relays hearing the same frame pick spread out times */
+    TEST_ASSERT(min_us < (WT20_RELAY_JITTER_US / 4U));
+    TEST_ASSERT(max_us > ((3U * WT20_RELAY_JITTER_US) / 4U));
+
+    for (i = 0U; i < WT20_RELAY_QUEUE; i++)
+    {
+        TEST_ASSERT(wt20_relay_queue(&relay, payload, length, 0U));
+    }
+
+    TEST_ASSERT_FALSE(wt20_relay_queue(&relay, payload, length, 0U));
+
+    /* the first one due is reported, and comes off first */
+    TEST_ASSERT(wt20_relay_pending(&relay, &first_us));
+
+    for (i = 0U; i < WT20_RELAY_QUEUE; i++)
+    {
+        TEST_ASSERT(wt20_relay_pending(&relay, &due_us));
+        TEST_ASSERT(due_us >= first_us);
+        TEST_ASSERT_EQUAL_UINT16(length, wt20_relay_next(&relay, due_us, forward));
+        first_us = due_us;
+    }
+}
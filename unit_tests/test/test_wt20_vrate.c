@@ -0,0 +1,172 @@
+#include "unity.h"
+
+#include <string.h>
+
+#include "wt20_vrate.h"
+#include "adpcm.h"
+
+static WT20_VRATE_T ctl;
+
+/* count frames with nothing wrong, returns the mode of the last */
+static ADPCM_MODE_T run_clean(uint32_t count, bool may_raise)
+{
+    ADPCM_MODE_T mode = ADPCM_MODES;
+    uint32_t i;
+
+    for (i = 0U; i < count; i++)
+    {
+        mode = wt20_vrate_next(&ctl, 0U, may_raise);
+        wt20_vrate_on_send(&ctl, true);
+    }
+
+    return mode;
+}
+
+void setUp(void)
+{
+    wt20_vrate_init(&ctl);
+}
+
+void tearDown(void) { }
+
+void test_wt20_vrate_steps_down_on_trouble(void)
+{
+    WT20_VRATE_STATS_T stats;
+    uint32_t i;
+
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(100U, true));
+
+    /* the queue backs up, one mode down, and no further until the drop had time to show */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, false));
+
+    for (i = 1U; i < WT20_VRATE_HOLD_FRAMES; i++)
+    {
+        TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, false));
+    }
+
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K_2BIT, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, false));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K_2BIT, run_clean(WT20_VRATE_RAISE_FRAMES - 1U, true));
+
+    /* a single failed send is shrugged off, a couple close together are not */
+    wt20_vrate_init(&ctl);
+    wt20_vrate_on_send(&ctl, false);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, wt20_vrate_next(&ctl, 0U, true));
+    wt20_vrate_on_send(&ctl, false);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, 0U, true));
+
+    /* a report over the threshold drops a mode, one under it doesn't */
+    wt20_vrate_init(&ctl);
+    wt20_vrate_on_report(&ctl, WT20_VRATE_DOWN_LOSS_PERMILLE);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, wt20_vrate_next(&ctl, 0U, true));
+    wt20_vrate_on_report(&ctl, WT20_VRATE_DOWN_LOSS_PERMILLE + 1U);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, 0U, true));
+
+    /* and acts on it once */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(2U * WT20_VRATE_HOLD_FRAMES, false));
+
+    /* a badly backed up queue goes straight to the lowest */
+    wt20_vrate_init(&ctl);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K_2BIT, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_SEVERE_FRAMES, true));
+
+    wt20_vrate_get_stats(&ctl, &stats);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K_2BIT, stats.mode);
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.downs);
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.frames[ADPCM_MODE_8K_2BIT]);
+}
+
+void test_wt20_vrate_steps_up_after_clean_talk(void)
+{
+    WT20_VRATE_STATS_T stats;
+
+    wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_SEVERE_FRAMES, true);
+
+    /* only where a new fec group starts */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K_2BIT, run_clean(2U * WT20_VRATE_RAISE_FRAMES, false));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(1U, true));
+
+    /* one mode at a time */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(WT20_VRATE_RAISE_FRAMES - 1U, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(1U, true));
+
+    /* a report close to the threshold holds the mode where it is */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(WT20_VRATE_RAISE_FRAMES, true));
+    wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, true);
+    run_clean(WT20_VRATE_RAISE_FRAMES - 2U, true);
+    wt20_vrate_on_report(&ctl, WT20_VRATE_DOWN_LOSS_PERMILLE);
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(WT20_VRATE_RAISE_FRAMES, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(1U, true));
+
+    wt20_vrate_get_stats(&ctl, &stats);
+    TEST_ASSERT_EQUAL_UINT32(3U, stats.ups);
+    TEST_ASSERT_EQUAL_UINT32(2U, stats.downs);
+    TEST_ASSERT_EQUAL_UINT32(1U, stats.reports);
+    TEST_ASSERT_EQUAL_UINT16(WT20_VRATE_DOWN_LOSS_PERMILLE, stats.loss_permille);
+}
+
+void test_wt20_vrate_backs_off_when_a_mode_up_does_not_last(void)
+{
+    uint32_t wait;
+    uint32_t round;
+
+    wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, true);
+
+    /* the link can't take 16 kHz. Each try up waits twice as long as the last, up to the most */
+    for (round = 0U; round < 5U; round++)
+    {
+        wait = WT20_VRATE_RAISE_FRAMES << round;
+        wait = (wait > (WT20_VRATE_RAISE_FRAMES * WT20_VRATE_MAX_BACKOFF)) ? (WT20_VRATE_RAISE_FRAMES * WT20_VRATE_MAX_BACKOFF) : wait;
+
+        run_clean(WT20_VRATE_HOLD_FRAMES, false);
+        TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(wait - WT20_VRATE_HOLD_FRAMES - 1U, true));
+        TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(1U, true));
+        TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, true));
+    }
+
+    /* once a mode up lasts, the wait comes back down */
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(wait - 1U, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(1U, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(WT20_VRATE_RAISE_FRAMES, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, wt20_vrate_next(&ctl, WT20_VRATE_QUEUE_FRAMES, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_8K, run_clean(((WT20_VRATE_RAISE_FRAMES * WT20_VRATE_MAX_BACKOFF) / 2U) - 1U, true));
+    TEST_ASSERT_EQUAL(ADPCM_MODE_16K, run_clean(1U, true));
+}
+
+void test_wt20_vrate_listener_reports_loss_before_fec(void)
+{
+    WT20_VRATE_RX_T rx;
+    uint8_t payload[WT20_VRATE_REPORT_BYTES];
+    uint16_t loss_permille = 0U;
+    uint32_t i;
+
+    wt20_vrate_rx_init(&rx);
+
+    /* all but 3 through clean, 2 rebuilt and 1 lost for good, all count */
+    for (i = 0U; i < (WT20_VRATE_REPORT_FRAMES - 3U); i++)
+    {
+        TEST_ASSERT_FALSE(wt20_vrate_rx_on_frame(&rx, false));
+    }
+
+    TEST_ASSERT_FALSE(wt20_vrate_rx_on_frame(&rx, true));
+    wt20_vrate_rx_on_lost(&rx, 1U);
+    TEST_ASSERT(wt20_vrate_rx_on_frame(&rx, true));
+
+    TEST_ASSERT_EQUAL_UINT16(WT20_VRATE_REPORT_BYTES, wt20_vrate_rx_build_report(&rx, payload));
+    TEST_ASSERT(wt20_vrate_parse_report(payload, sizeof(payload), &loss_permille));
+    TEST_ASSERT_EQUAL_UINT16(3U * 1000U / WT20_VRATE_REPORT_FRAMES, loss_permille);
+    TEST_ASSERT_EQUAL_UINT32(WT20_VRATE_REPORT_FRAMES - 1U, rx.stats.delivered);
+    TEST_ASSERT_EQUAL_UINT32(2U, rx.stats.recovered);
+    TEST_ASSERT_EQUAL_UINT32(1U, rx.stats.lost);
+
+    /* counting starts again */
+    TEST_ASSERT_FALSE(wt20_vrate_rx_on_frame(&rx, false));
+
+    /* empty, short, or out of range reports are ignored */
+    TEST_ASSERT_FALSE(wt20_vrate_parse_report(payload, WT20_VRATE_REPORT_BYTES - 1U, &loss_permille));
+    wt20_vrate_rx_init(&rx);
+    wt20_vrate_rx_build_report(&rx, payload);
+    TEST_ASSERT_FALSE(wt20_vrate_parse_report(payload, sizeof(payload), &loss_permille));
+    payload[0] = 0xE9U;
+    payload[1] = 0x03U;
+    payload[2] = 1U;
+    TEST_ASSERT_FALSE(wt20_vrate_parse_report(payload, sizeof(payload), &loss_permille));
+}